@@ -6,6 +6,7 @@
 
 #include "sc_fm_engine_private.h"
 #include "sc_stream_file.h"
+#include "sc_link_helpers.h"
 
 #include "../sc_memory.h"
 
@@ -22,22 +23,26 @@ GMutex fs_mutex;
 
 sc_uint8* sc_fs_engine_make_checksum_path(const sc_check_sum *check_sum)
 {
+    // binary checksums are encoded in hex, so path contains printable chars only
+    sc_char check_sum_str[SC_CHECKSUM_STRING_SIZE];
+    sc_uint str_len = 0;
+
+    g_assert(check_sum != 0);
+    g_assert(check_sum->len != 0);
+
+    str_len = sc_link_checksum_to_string(check_sum, check_sum_str);
+    g_assert(str_len % 4 == 0);
+
     // calculate output string length and create it
-    sc_uint div = (check_sum->len % 8 == 0) ? 8 : 4;
-    sc_uint len = check_sum->len + check_sum->len / div + 1;
+    sc_uint div = (str_len % 8 == 0) ? 8 : 4;
+    sc_uint len = str_len + str_len / div + 1;
     sc_uint8 *result = malloc(sizeof(sc_uint8) * len);
     sc_uint idx = 0;
     sc_uint j = 0;
 
-    g_assert(check_sum->len == 32);
-
-    g_assert(check_sum != 0);
-    g_assert(check_sum->len != 0);
-    g_assert(check_sum->len % 4 == 0);
-
-    for (idx = 0; idx < check_sum->len; idx++)
+    for (idx = 0; idx < str_len; idx++)
     {
-        result[j++] = check_sum->data[idx];
+        result[j++] = check_sum_str[idx];
         if ((idx + 1 ) % div == 0)
             result[j++] = '/';
     }
@@ -191,11 +196,11 @@ sc_result sc_fs_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr,
             goto clean;
     }
 
-    // remove addr from content
+    // remove addr from content, that is number of addrs followed by them
     if (content != 0)
     {
-        g_assert(content_len % sizeof(sc_addr) == 0);
-        sc_addr *iter = (sc_addr*)content;
+        g_assert(content_len >= sizeof(sc_uint32) && (content_len - sizeof(sc_uint32)) % sizeof(sc_addr) == 0);
+        sc_addr *iter = (sc_addr*)(content + sizeof(sc_uint32));
         sc_addr *iter_end = (sc_addr*)(content + content_len);
         sc_bool found = SC_FALSE;
 
@@ -203,21 +208,22 @@ sc_result sc_fs_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr,
         {
             if (SC_ADDR_IS_EQUAL(*iter, addr))
             {
-                if (content_len > sizeof(sc_addr))
+                found = SC_TRUE;
+                if (content_len > sizeof(sc_uint32) + sizeof(sc_addr))
                 {
-                    found = SC_TRUE;
+                    gsize const prefix_len = (gchar*)iter - content;
+
                     content2 = g_new0(gchar, content_len - sizeof(sc_addr));
-                    if ((gchar*)iter != content)
-                        memcpy(content2, content, (gchar*)iter - content);
+                    memcpy(content2, content, prefix_len);
 
                     iter_next = iter;
                     ++iter_next;
-
-                    if (iter_next != iter_end)
-                        memcpy(content2, iter + 1, (gchar*)iter_end - (gchar*)iter_next);
+                    memcpy(content2 + prefix_len, iter_next, (gchar*)iter_end - (gchar*)iter_next);
+                    (*(sc_uint32*)content2)--;
 
                     g_free(content);
                     content = content2;
+                    content_len -= sizeof(sc_addr);
                 } else
                 {
                     g_free(content);
@@ -229,15 +235,16 @@ sc_result sc_fs_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr,
             ++iter;
         }
 
-        content = g_new0(gchar, content_len + sizeof(addr));
-        memcpy(content, content2, content_len);
-        memcpy(content + content_len, &addr, sizeof(addr));
-        content_len += sizeof(addr);
-
-        // old content doesn't need
-        g_free(content2);
+        if (found == SC_FALSE)
+        {
+            res = SC_RESULT_ERROR_NOT_FOUND;
+            goto clean;
+        }
     } else
+    {
         res = SC_RESULT_ERROR_NOT_FOUND;
+        goto clean;
+    }
 
     // write content to file
     res = SC_RESULT_OK;
@@ -0,0 +1,909 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_fm_packed.h"
+#include "sc_stream_packed.h"
+#include "sc_fm_engine_private.h"
+
+#include "../sc_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifndef WIN32
+# include <unistd.h>
+#else
+# include <io.h>
+#endif
+
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
+
+#define SC_FM_PACKED_REF_APPEND 1
+#define SC_FM_PACKED_REF_REMOVE 2
+
+//! Header of index file
+typedef struct _sc_fm_packed_index_header
+{
+    sc_uint32 magic;            // SC_FM_PACKED_INDEX_MAGIC
+    sc_uint32 format;           // SC_FM_PACKED_INDEX_FORMAT
+    sc_uint32 addr_size;        // size of sc_addr, so index isn't loaded by incompatible build
+    sc_uint32 blobs_count;
+    sc_uint32 files_count;
+    sc_uint32 reserved;
+    sc_uint64 file_size;        // size of the last data file, that is covered by index
+} sc_fm_packed_index_header;
+
+//! Blob description in index file. It's followed by sc-addrs of sc-links
+typedef struct _sc_fm_packed_index_blob
+{
+    sc_char checksum[SC_MAX_CHECKSUM_LEN];
+    sc_uint32 file;
+    sc_uint32 length;
+    sc_uint64 offset;
+    sc_uint32 addrs_count;
+    sc_uint32 reserved;
+} sc_fm_packed_index_blob;
+
+//! Record of references log
+typedef struct _sc_fm_packed_ref_record
+{
+    sc_uint32 op;               // SC_FM_PACKED_REF_APPEND or SC_FM_PACKED_REF_REMOVE
+    sc_addr addr;
+    sc_char checksum[SC_MAX_CHECKSUM_LEN];
+} sc_fm_packed_ref_record;
+
+gchar packed_path[MAX_PATH_LENGTH + 1];
+const gchar *packed_dir = "packed";
+
+GHashTable *blobs = null_ptr;       // checksum -> sc_fm_packed_blob
+GRWLock index_lock;                 // protects blobs table and references log
+
+int files[SC_FM_PACKED_FILES_MAX];  // descriptors of data files
+sc_uint32 files_count = 0;
+sc_uint64 file_size = 0;            // size of the last data file
+GMutex append_mutex;                // serializes appends into data file
+
+int refs_fd = -1;
+
+#ifdef WIN32
+GMutex read_mutex;                  // there is no pread, so reads change file position
+#endif
+
+#define INDEX_READ_LOCK()       g_rw_lock_reader_lock(&index_lock)
+#define INDEX_READ_UNLOCK()     g_rw_lock_reader_unlock(&index_lock)
+#define INDEX_WRITE_LOCK()      g_rw_lock_writer_lock(&index_lock)
+#define INDEX_WRITE_UNLOCK()    g_rw_lock_writer_unlock(&index_lock)
+
+
+guint _sc_fm_packed_checksum_hash(gconstpointer key)
+{
+    // checksum is a hash already, so its words are just mixed (binary checksum starts with marker and length)
+    guint result = 0, word = 0;
+    sc_uint32 i;
+    for (i = 0; i + sizeof(word) <= SC_MAX_CHECKSUM_LEN; i += sizeof(word))
+    {
+        memcpy(&word, (sc_char const*)key + i, sizeof(word));
+        result = result * 31 + word;
+    }
+    return result;
+}
+
+gboolean _sc_fm_packed_checksum_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, SC_MAX_CHECKSUM_LEN) == 0 ? TRUE : FALSE;
+}
+
+void _sc_fm_packed_blob_free(gpointer data)
+{
+    sc_fm_packed_blob *blob = (sc_fm_packed_blob*)data;
+    g_free(blob->addrs);
+    g_free(blob);
+}
+
+void _sc_fm_packed_make_key(const sc_check_sum *check_sum, sc_char *key)
+{
+    memset(key, 0, SC_MAX_CHECKSUM_LEN);
+    memcpy(key, check_sum->data, MIN(check_sum->len, SC_MAX_CHECKSUM_LEN));
+}
+
+//! Returns blob with specified checksum. If it doesn't exist and \p create is SC_TRUE, then it would be created
+sc_fm_packed_blob* _sc_fm_packed_blob_get(sc_char const *key, sc_bool create)
+{
+    sc_fm_packed_blob *blob = (sc_fm_packed_blob*)g_hash_table_lookup(blobs, key);
+    if (blob == null_ptr && create == SC_TRUE)
+    {
+        blob = g_new0(sc_fm_packed_blob, 1);
+        memcpy(blob->checksum, key, SC_MAX_CHECKSUM_LEN);
+        blob->file = SC_FM_PACKED_NO_FILE;
+        g_hash_table_insert(blobs, blob->checksum, blob);
+    }
+
+    return blob;
+}
+
+int _sc_fm_packed_addr_compare(const void *a, const void *b)
+{
+    sc_addr_hash const ha = SC_ADDR_LOCAL_TO_INT(*(sc_addr const*)a);
+    sc_addr_hash const hb = SC_ADDR_LOCAL_TO_INT(*(sc_addr const*)b);
+    return (ha < hb) ? -1 : ((ha > hb) ? 1 : 0);
+}
+
+/*! Finds \p addr in sorted references of blob. Returns SC_TRUE, if it's found. Position of found sc-addr
+ * or position to insert it is stored into \p pos
+ */
+sc_bool _sc_fm_packed_blob_find_addr(sc_fm_packed_blob const *blob, sc_addr addr, sc_uint32 *pos)
+{
+    sc_uint32 lo = 0, hi = blob->addrs_count;
+    while (lo < hi)
+    {
+        sc_uint32 const mid = lo + (hi - lo) / 2;
+        int const cmp = _sc_fm_packed_addr_compare(&blob->addrs[mid], &addr);
+        if (cmp == 0)
+        {
+            *pos = mid;
+            return SC_TRUE;
+        }
+
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *pos = lo;
+    return SC_FALSE;
+}
+
+sc_bool _sc_fm_packed_blob_append_addr(sc_fm_packed_blob *blob, sc_addr addr)
+{
+    sc_uint32 pos = 0;
+    if (_sc_fm_packed_blob_find_addr(blob, addr, &pos) == SC_TRUE)
+        return SC_FALSE;
+
+    if (blob->addrs_count == blob->addrs_capacity)
+    {
+        blob->addrs_capacity = (blob->addrs_capacity == 0) ? 1 : blob->addrs_capacity * 2;
+        blob->addrs = g_renew(sc_addr, blob->addrs, blob->addrs_capacity);
+    }
+
+    // references are kept sorted, so duplicates are found by binary search
+    memmove(&blob->addrs[pos + 1], &blob->addrs[pos], sizeof(sc_addr) * (blob->addrs_count - pos));
+    blob->addrs[pos] = addr;
+    ++blob->addrs_count;
+
+    return SC_TRUE;
+}
+
+sc_bool _sc_fm_packed_blob_remove_addr(sc_fm_packed_blob *blob, sc_addr addr)
+{
+    sc_uint32 pos = 0;
+    if (_sc_fm_packed_blob_find_addr(blob, addr, &pos) == SC_FALSE)
+        return SC_FALSE;
+
+    --blob->addrs_count;
+    memmove(&blob->addrs[pos], &blob->addrs[pos + 1], sizeof(sc_addr) * (blob->addrs_count - pos));
+
+    return SC_TRUE;
+}
+
+//! Removes blob from index, if nothing refers to it and it has no stored data
+void _sc_fm_packed_blob_check_unused(sc_fm_packed_blob *blob)
+{
+    if (blob->addrs_count == 0 && blob->file == SC_FM_PACKED_NO_FILE)
+        g_hash_table_remove(blobs, blob->checksum);
+}
+
+void _sc_fm_packed_make_file_path(sc_uint32 num, gchar *path)
+{
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/data_%u.bin", packed_path, num);
+}
+
+sc_bool _sc_fm_packed_write_all(int fd, void const *data, gsize size)
+{
+    gchar const *ptr = (gchar const*)data;
+    while (size > 0)
+    {
+        gssize written = write(fd, ptr, size);
+        if (written <= 0)
+            return SC_FALSE;
+        ptr += written;
+        size -= written;
+    }
+
+    return SC_TRUE;
+}
+
+sc_bool _sc_fm_packed_read_all(int fd, void *data, gsize size)
+{
+    gchar *ptr = (gchar*)data;
+    while (size > 0)
+    {
+        gssize bytes = read(fd, ptr, size);
+        if (bytes <= 0)
+            return SC_FALSE;
+        ptr += bytes;
+        size -= bytes;
+    }
+
+    return SC_TRUE;
+}
+
+void _sc_fm_packed_sync(int fd)
+{
+#ifndef WIN32
+    fsync(fd);
+#else
+    _commit(fd);
+#endif
+}
+
+sc_bool _sc_fm_packed_file_open(sc_uint32 num)
+{
+    gchar path[MAX_PATH_LENGTH];
+
+    if (num >= SC_FM_PACKED_FILES_MAX)
+    {
+        g_critical("Maximum number of packed file memory data files reached");
+        return SC_FALSE;
+    }
+
+    _sc_fm_packed_make_file_path(num, path);
+    files[num] = g_open(path, O_RDWR | O_CREAT | O_BINARY, 0644);
+    if (files[num] < 0)
+    {
+        g_critical("Can't open packed file memory data file: %s", path);
+        return SC_FALSE;
+    }
+
+    files_count = num + 1;
+    return SC_TRUE;
+}
+
+void _sc_fm_packed_files_close()
+{
+    sc_uint32 i;
+    for (i = 0; i < files_count; ++i)
+        close(files[i]);
+    files_count = 0;
+    file_size = 0;
+
+    if (refs_fd >= 0)
+        close(refs_fd);
+    refs_fd = -1;
+}
+
+sc_bool _sc_fm_packed_refs_open()
+{
+    gchar path[MAX_PATH_LENGTH];
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/refs.log", packed_path);
+
+    refs_fd = g_open(path, O_RDWR | O_CREAT | O_APPEND | O_BINARY, 0644);
+    if (refs_fd < 0)
+    {
+        g_critical("Can't open packed file memory references log: %s", path);
+        return SC_FALSE;
+    }
+
+    return SC_TRUE;
+}
+
+//! Appends reference change into log. Index have to be locked for write
+void _sc_fm_packed_refs_log(sc_uint32 op, sc_addr addr, sc_char const *key)
+{
+    sc_fm_packed_ref_record record;
+
+    memset(&record, 0, sizeof(record));
+    record.op = op;
+    record.addr = addr;
+    memcpy(record.checksum, key, SC_MAX_CHECKSUM_LEN);
+
+    if (_sc_fm_packed_write_all(refs_fd, &record, sizeof(record)) == SC_FALSE)
+        g_critical("Can't write packed file memory references log");
+}
+
+// --- data files ---
+sc_bool sc_fm_packed_read(sc_uint32 file, sc_uint64 offset, sc_char *data, sc_uint32 length)
+{
+    if (file >= files_count)
+        return SC_FALSE;
+
+#ifndef WIN32
+    while (length > 0)
+    {
+        gssize bytes = pread(files[file], data, length, (off_t)offset);
+        if (bytes <= 0)
+            return SC_FALSE;
+        data += bytes;
+        offset += bytes;
+        length -= bytes;
+    }
+    return SC_TRUE;
+#else
+    sc_bool res = SC_FALSE;
+    g_mutex_lock(&read_mutex);
+    if (_lseeki64(files[file], offset, SEEK_SET) == (__int64)offset)
+        res = _sc_fm_packed_read_all(files[file], data, length);
+    g_mutex_unlock(&read_mutex);
+    return res;
+#endif
+}
+
+sc_result sc_fm_packed_append(const sc_check_sum *check_sum, sc_char const *data, sc_uint32 length)
+{
+    sc_fm_packed_record_header header;
+    sc_fm_packed_blob *blob = null_ptr;
+    sc_result res = SC_RESULT_ERROR_IO;
+    sc_uint64 offset = 0;
+    sc_uint32 num = 0;
+
+    header.magic = SC_FM_PACKED_RECORD_MAGIC;
+    header.length = length;
+    _sc_fm_packed_make_key(check_sum, header.checksum);
+
+    // content with the same checksum stored already
+    INDEX_READ_LOCK();
+    blob = (sc_fm_packed_blob*)g_hash_table_lookup(blobs, header.checksum);
+    if (blob != null_ptr && blob->file != SC_FM_PACKED_NO_FILE)
+        res = SC_RESULT_OK;
+    INDEX_READ_UNLOCK();
+
+    if (res == SC_RESULT_OK)
+        return res;
+
+    g_mutex_lock(&append_mutex);
+
+    // start new data file
+    if (file_size > 0 && file_size + sizeof(header) + length > SC_FM_PACKED_FILE_MAX_SIZE)
+    {
+        _sc_fm_packed_sync(files[files_count - 1]);
+        if (_sc_fm_packed_file_open(files_count) == SC_FALSE)
+            goto clean;
+        file_size = 0;
+    }
+
+    num = files_count - 1;
+    offset = file_size + sizeof(header);
+
+#ifndef WIN32
+    if (pwrite(files[num], &header, sizeof(header), (off_t)file_size) != sizeof(header))
+        goto clean;
+    if (length > 0 && pwrite(files[num], data, length, (off_t)offset) != (gssize)length)
+        goto clean;
+#else
+    if (_lseeki64(files[num], file_size, SEEK_SET) != (__int64)file_size)
+        goto clean;
+    if (_sc_fm_packed_write_all(files[num], &header, sizeof(header)) == SC_FALSE)
+        goto clean;
+    if (_sc_fm_packed_write_all(files[num], data, length) == SC_FALSE)
+        goto clean;
+#endif
+
+    file_size = offset + length;
+    res = SC_RESULT_OK;
+
+    // make content visible for reading. If the same content was appended by other thread, then
+    // the first record is used, and this one is just a garbage in data file
+    INDEX_WRITE_LOCK();
+    blob = _sc_fm_packed_blob_get(header.checksum, SC_TRUE);
+    if (blob->file == SC_FM_PACKED_NO_FILE)
+    {
+        blob->file = num;
+        blob->offset = offset;
+        blob->length = length;
+    }
+    INDEX_WRITE_UNLOCK();
+
+    clean:
+    {
+        g_mutex_unlock(&append_mutex);
+    }
+
+    return res;
+}
+
+/*! Scans records in tail of data files, that were appended after the last save, and appends them into index.
+ * Broken record at the end of file (it wasn't written completely) is truncated
+ */
+sc_bool _sc_fm_packed_scan(sc_uint32 num, sc_uint64 offset)
+{
+    sc_fm_packed_record_header header;
+    sc_fm_packed_blob *blob = null_ptr;
+
+    for (; num < files_count; ++num)
+    {
+        sc_uint64 size = (sc_uint64)lseek(files[num], 0, SEEK_END);
+
+        while (offset + sizeof(header) <= size)
+        {
+            if (sc_fm_packed_read(num, offset, (sc_char*)&header, sizeof(header)) == SC_FALSE)
+                return SC_FALSE;
+            if (header.magic != SC_FM_PACKED_RECORD_MAGIC || offset + sizeof(header) + header.length > size)
+                break;
+
+            blob = _sc_fm_packed_blob_get(header.checksum, SC_TRUE);
+            if (blob->file == SC_FM_PACKED_NO_FILE)
+            {
+                blob->file = num;
+                blob->offset = offset + sizeof(header);
+                blob->length = header.length;
+            }
+
+            offset += sizeof(header) + header.length;
+        }
+
+        if (offset < size)
+        {
+            g_warning("Truncate broken tail of packed file memory data file %u at %" G_GUINT64_FORMAT, num, offset);
+#ifndef WIN32
+            if (ftruncate(files[num], (off_t)offset) != 0)
+                return SC_FALSE;
+#else
+            if (_chsize_s(files[num], offset) != 0)
+                return SC_FALSE;
+#endif
+        }
+
+        file_size = offset;
+        offset = 0;
+    }
+
+    return SC_TRUE;
+}
+
+//! Loads index file. Returns SC_FALSE, if index file is broken
+sc_bool _sc_fm_packed_index_load(sc_uint32 *last_file, sc_uint64 *last_size)
+{
+    gchar path[MAX_PATH_LENGTH];
+    sc_fm_packed_index_header header;
+    sc_fm_packed_index_blob info;
+    sc_fm_packed_blob *blob = null_ptr;
+    sc_bool res = SC_FALSE;
+    sc_uint32 i;
+    int fd = -1;
+
+    *last_file = 0;
+    *last_size = 0;
+
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/index.bin", packed_path);
+    if (g_file_test(path, G_FILE_TEST_EXISTS) == FALSE)
+        return SC_TRUE;
+
+    fd = g_open(path, O_RDONLY | O_BINARY, 0);
+    if (fd < 0)
+        return SC_FALSE;
+
+    if (_sc_fm_packed_read_all(fd, &header, sizeof(header)) == SC_FALSE)
+        goto clean;
+
+    if (header.magic != SC_FM_PACKED_INDEX_MAGIC || header.format != SC_FM_PACKED_INDEX_FORMAT
+            || header.addr_size != sizeof(sc_addr) || header.files_count == 0)
+    {
+        g_critical("Packed file memory index has unsupported format: %s", path);
+        goto clean;
+    }
+
+    for (i = 0; i < header.blobs_count; ++i)
+    {
+        if (_sc_fm_packed_read_all(fd, &info, sizeof(info)) == SC_FALSE)
+            goto clean;
+
+        blob = _sc_fm_packed_blob_get(info.checksum, SC_TRUE);
+        blob->file = info.file;
+        blob->offset = info.offset;
+        blob->length = info.length;
+        blob->addrs_count = blob->addrs_capacity = info.addrs_count;
+        blob->addrs = g_new0(sc_addr, info.addrs_count);
+
+        if (_sc_fm_packed_read_all(fd, blob->addrs, sizeof(sc_addr) * info.addrs_count) == SC_FALSE)
+            goto clean;
+        qsort(blob->addrs, blob->addrs_count, sizeof(sc_addr), _sc_fm_packed_addr_compare);
+    }
+
+    *last_file = header.files_count - 1;
+    *last_size = header.file_size;
+    res = SC_TRUE;
+
+    clean:
+    {
+        close(fd);
+    }
+
+    return res;
+}
+
+//! Replays references log over loaded index. Replay is idempotent, so log can contain changes, that were saved
+sc_bool _sc_fm_packed_refs_replay()
+{
+    sc_fm_packed_ref_record record;
+    sc_fm_packed_blob *blob = null_ptr;
+
+    lseek(refs_fd, 0, SEEK_SET);
+    while (_sc_fm_packed_read_all(refs_fd, &record, sizeof(record)) == SC_TRUE)
+    {
+        if (record.op == SC_FM_PACKED_REF_APPEND)
+        {
+            blob = _sc_fm_packed_blob_get(record.checksum, SC_TRUE);
+            _sc_fm_packed_blob_append_addr(blob, record.addr);
+        }
+        else if (record.op == SC_FM_PACKED_REF_REMOVE)
+        {
+            blob = _sc_fm_packed_blob_get(record.checksum, SC_FALSE);
+            if (blob != null_ptr)
+            {
+                _sc_fm_packed_blob_remove_addr(blob, record.addr);
+                _sc_fm_packed_blob_check_unused(blob);
+            }
+        }
+        else
+            break;
+    }
+
+    return SC_TRUE;
+}
+
+sc_bool _sc_fm_packed_open()
+{
+    sc_uint32 last_file = 0, i;
+    sc_uint64 last_size = 0;
+    gchar path[MAX_PATH_LENGTH];
+
+    if (!g_file_test(packed_path, G_FILE_TEST_IS_DIR))
+    {
+        if (g_mkdir_with_parents(packed_path, -1) < 0)
+        {
+            g_critical("Can't create '%s' directory.", packed_path);
+            return SC_FALSE;
+        }
+    }
+
+    if (_sc_fm_packed_index_load(&last_file, &last_size) == SC_FALSE)
+        return SC_FALSE;
+
+    // open all existing data files
+    for (i = 0; ; ++i)
+    {
+        _sc_fm_packed_make_file_path(i, path);
+        if (i > 0 && g_file_test(path, G_FILE_TEST_EXISTS) == FALSE)
+            break;
+        if (_sc_fm_packed_file_open(i) == SC_FALSE)
+            return SC_FALSE;
+    }
+
+    if (last_file >= files_count)
+    {
+        g_critical("Packed file memory data file %u doesn't exist", last_file);
+        return SC_FALSE;
+    }
+
+    if (_sc_fm_packed_scan(last_file, last_size) == SC_FALSE)
+        return SC_FALSE;
+
+    if (_sc_fm_packed_refs_open() == SC_FALSE)
+        return SC_FALSE;
+
+    return _sc_fm_packed_refs_replay();
+}
+
+// --- implementation of interface ---
+sc_result sc_fm_packed_create_stream(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_uint8 flags, sc_stream **stream)
+{
+    sc_char key[SC_MAX_CHECKSUM_LEN];
+    sc_fm_packed_blob *blob = null_ptr;
+    sc_result res = SC_RESULT_ERROR_NOT_FOUND;
+
+    if (flags & SC_STREAM_FLAG_WRITE)
+    {
+        *stream = sc_stream_packed_write_new(check_sum);
+        return SC_RESULT_OK;
+    }
+
+    _sc_fm_packed_make_key(check_sum, key);
+
+    INDEX_READ_LOCK();
+    blob = (sc_fm_packed_blob*)g_hash_table_lookup(blobs, key);
+    if (blob != null_ptr && blob->file != SC_FM_PACKED_NO_FILE)
+    {
+        *stream = sc_stream_packed_read_new(blob->file, blob->offset, blob->length);
+        res = SC_RESULT_OK;
+    }
+    INDEX_READ_UNLOCK();
+
+    return res;
+}
+
+sc_result sc_fm_packed_addr_ref_append(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    sc_char key[SC_MAX_CHECKSUM_LEN];
+    _sc_fm_packed_make_key(check_sum, key);
+
+    INDEX_WRITE_LOCK();
+    if (_sc_fm_packed_blob_append_addr(_sc_fm_packed_blob_get(key, SC_TRUE), addr) == SC_TRUE)
+        _sc_fm_packed_refs_log(SC_FM_PACKED_REF_APPEND, addr, key);
+    INDEX_WRITE_UNLOCK();
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_fm_packed_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    sc_char key[SC_MAX_CHECKSUM_LEN];
+    sc_fm_packed_blob *blob = null_ptr;
+    _sc_fm_packed_make_key(check_sum, key);
+
+    INDEX_WRITE_LOCK();
+    blob = _sc_fm_packed_blob_get(key, SC_FALSE);
+    if (blob != null_ptr && _sc_fm_packed_blob_remove_addr(blob, addr) == SC_TRUE)
+    {
+        _sc_fm_packed_refs_log(SC_FM_PACKED_REF_REMOVE, addr, key);
+        _sc_fm_packed_blob_check_unused(blob);
+    }
+    INDEX_WRITE_UNLOCK();
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_fm_packed_find(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_addr **result, sc_uint32 *result_count)
+{
+    sc_char key[SC_MAX_CHECKSUM_LEN];
+    sc_fm_packed_blob *blob = null_ptr;
+    sc_result res = SC_RESULT_ERROR_NOT_FOUND;
+
+    // must be a null pointer
+    g_assert(*result == 0);
+
+    *result_count = 0;
+    _sc_fm_packed_make_key(check_sum, key);
+
+    INDEX_READ_LOCK();
+    blob = (sc_fm_packed_blob*)g_hash_table_lookup(blobs, key);
+    if (blob != null_ptr && blob->addrs_count > 0)
+    {
+        *result_count = blob->addrs_count;
+        *result = g_new0(sc_addr, blob->addrs_count);
+        memcpy(*result, blob->addrs, sizeof(sc_addr) * blob->addrs_count);
+        res = SC_RESULT_OK;
+    }
+    INDEX_READ_UNLOCK();
+
+    return res;
+}
+
+sc_result sc_fm_packed_clear(const sc_fm_engine *engine)
+{
+    gchar path[MAX_PATH_LENGTH];
+    GDir *dir = null_ptr;
+    const gchar *name = null_ptr;
+    sc_result res = SC_RESULT_OK;
+
+    g_mutex_lock(&append_mutex);
+    INDEX_WRITE_LOCK();
+
+    _sc_fm_packed_files_close();
+    g_hash_table_remove_all(blobs);
+
+    dir = g_dir_open(packed_path, 0, 0);
+    if (dir != null_ptr)
+    {
+        while ((name = g_dir_read_name(dir)) != null_ptr)
+        {
+            g_snprintf(path, MAX_PATH_LENGTH, "%s/%s", packed_path, name);
+            if (g_file_test(path, G_FILE_TEST_IS_REGULAR) && g_remove(path) != 0)
+            {
+                g_critical("Can't remove file: %s", path);
+                res = SC_RESULT_ERROR_IO;
+            }
+        }
+        g_dir_close(dir);
+    }
+
+    if (_sc_fm_packed_file_open(0) == SC_FALSE || _sc_fm_packed_refs_open() == SC_FALSE)
+        res = SC_RESULT_ERROR_IO;
+
+    INDEX_WRITE_UNLOCK();
+    g_mutex_unlock(&append_mutex);
+
+    return res;
+}
+
+//! Writes index into temporary file and replaces index file with it. Index have to be locked for write
+sc_result _sc_fm_packed_index_save()
+{
+    gchar path[MAX_PATH_LENGTH];
+    gchar tmp_path[MAX_PATH_LENGTH];
+    sc_fm_packed_index_header header;
+    sc_fm_packed_index_blob info;
+    GHashTableIter iter;
+    gpointer key, value;
+    sc_result res = SC_RESULT_ERROR_IO;
+    int fd = -1;
+
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/index.bin", packed_path);
+    g_snprintf(tmp_path, MAX_PATH_LENGTH, "%s/index.bin.tmp", packed_path);
+
+    fd = g_open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (fd < 0)
+    {
+        g_critical("Can't open packed file memory index: %s", tmp_path);
+        return SC_RESULT_ERROR_IO;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = SC_FM_PACKED_INDEX_MAGIC;
+    header.format = SC_FM_PACKED_INDEX_FORMAT;
+    header.addr_size = sizeof(sc_addr);
+    header.blobs_count = g_hash_table_size(blobs);
+    header.files_count = files_count;
+    header.file_size = file_size;
+
+    if (_sc_fm_packed_write_all(fd, &header, sizeof(header)) == SC_FALSE)
+        goto clean;
+
+    g_hash_table_iter_init(&iter, blobs);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        sc_fm_packed_blob *blob = (sc_fm_packed_blob*)value;
+
+        memset(&info, 0, sizeof(info));
+        memcpy(info.checksum, blob->checksum, SC_MAX_CHECKSUM_LEN);
+        info.file = blob->file;
+        info.length = blob->length;
+        info.offset = blob->offset;
+        info.addrs_count = blob->addrs_count;
+
+        if (_sc_fm_packed_write_all(fd, &info, sizeof(info)) == SC_FALSE)
+            goto clean;
+        if (_sc_fm_packed_write_all(fd, blob->addrs, sizeof(sc_addr) * blob->addrs_count) == SC_FALSE)
+            goto clean;
+    }
+
+    _sc_fm_packed_sync(fd);
+    res = SC_RESULT_OK;
+
+    clean:
+    {
+        close(fd);
+    }
+
+    if (res == SC_RESULT_OK)
+    {
+        g_remove(path);
+        if (g_rename(tmp_path, path) != 0)
+        {
+            g_critical("Can't rename %s -> %s", tmp_path, path);
+            res = SC_RESULT_ERROR_IO;
+        }
+    }
+
+    return res;
+}
+
+sc_result sc_fm_packed_save(const sc_fm_engine *engine)
+{
+    sc_result res = SC_RESULT_OK;
+
+    // appends are stopped, so index covers all data, that was written before it
+    g_mutex_lock(&append_mutex);
+    INDEX_WRITE_LOCK();
+
+    _sc_fm_packed_sync(files[files_count - 1]);
+    res = _sc_fm_packed_index_save();
+
+    // references log is covered by index now
+    if (res == SC_RESULT_OK)
+    {
+#ifndef WIN32
+        if (ftruncate(refs_fd, 0) != 0)
+            res = SC_RESULT_ERROR_IO;
+#else
+        if (_chsize_s(refs_fd, 0) != 0)
+            res = SC_RESULT_ERROR_IO;
+#endif
+    }
+
+    INDEX_WRITE_UNLOCK();
+    g_mutex_unlock(&append_mutex);
+
+    return res;
+}
+
+sc_result sc_fm_packed_destroy_data(const sc_fm_engine *engine)
+{
+    INDEX_WRITE_LOCK();
+    _sc_fm_packed_files_close();
+    g_hash_table_destroy(blobs);
+    blobs = null_ptr;
+    INDEX_WRITE_UNLOCK();
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_fm_packed_clean_state(const sc_fm_engine *engine)
+{
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    GHashTableIter iter;
+    gpointer key, value;
+    sc_uint32 i, copied;
+
+    INDEX_WRITE_LOCK();
+    g_hash_table_iter_init(&iter, blobs);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        sc_fm_packed_blob *blob = (sc_fm_packed_blob*)value;
+
+        copied = 0;
+        for (i = 0; i < blob->addrs_count; ++i)
+        {
+            if (sc_memory_is_element(ctx, blob->addrs[i]) == SC_TRUE)
+                blob->addrs[copied++] = blob->addrs[i];
+        }
+        blob->addrs_count = copied;
+
+        if (blob->addrs_count == 0 && blob->file == SC_FM_PACKED_NO_FILE)
+            g_hash_table_iter_remove(&iter);
+    }
+    INDEX_WRITE_UNLOCK();
+
+    sc_memory_context_free(ctx);
+
+    return sc_fm_packed_save(engine);
+}
+
+
+// --- extension interface ---
+_SC_EXT_EXTERN sc_fm_engine * initialize(const sc_char* repo_path)
+{
+    g_snprintf(packed_path, MAX_PATH_LENGTH, "%s/%s", repo_path, packed_dir);
+
+    g_rw_lock_init(&index_lock);
+    g_mutex_init(&append_mutex);
+#ifdef WIN32
+    g_mutex_init(&read_mutex);
+#endif
+
+    blobs = g_hash_table_new_full(_sc_fm_packed_checksum_hash, _sc_fm_packed_checksum_equal, null_ptr, _sc_fm_packed_blob_free);
+    files_count = 0;
+    file_size = 0;
+
+    if (_sc_fm_packed_open() == SC_FALSE)
+    {
+        _sc_fm_packed_files_close();
+        g_hash_table_destroy(blobs);
+        blobs = null_ptr;
+        return null_ptr;
+    }
+
+    g_message("\tPacked file memory: %u contents in %u data files", g_hash_table_size(blobs), files_count);
+
+    sc_fm_engine *engine = g_new0(sc_fm_engine, 1);
+
+    engine->storage_info = 0;
+    engine->funcStreamCreate = &sc_fm_packed_create_stream;
+    engine->funcAddrRefAppend = &sc_fm_packed_addr_ref_append;
+    engine->funcAddrRefRemove = &sc_fm_packed_addr_ref_remove;
+    engine->funcFind = &sc_fm_packed_find;
+    engine->funcClear = &sc_fm_packed_clear;
+    engine->funcSave = &sc_fm_packed_save;
+    engine->funcDestroyData = &sc_fm_packed_destroy_data;
+    engine->funcCleanState = &sc_fm_packed_clean_state;
+
+    return engine;
+}
+
+_SC_EXT_EXTERN sc_result shutdown()
+{
+    g_rw_lock_clear(&index_lock);
+    g_mutex_clear(&append_mutex);
+#ifdef WIN32
+    g_mutex_clear(&read_mutex);
+#endif
+    return SC_RESULT_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_fm_packed_h_
+#define _sc_fm_packed_h_
+
+#include "sc_types.h"
+#include "sc_defines.h"
+
+#include <glib.h>
+
+/* Packed file memory stores contents of sc-links in append-only data files <repo>/packed/data_<number>.bin.
+ * Each content is stored once as a record: header with checksum and length, that is followed by data.
+ * In-memory index maps checksum of content to its place in data files and to sc-addrs of sc-links with
+ * this content. Index is written into <repo>/packed/index.bin on save, and changes of references since
+ * the last save are appended into <repo>/packed/refs.log. Records, that were appended after the last save,
+ * are found by scan of data files tail on start.
+ */
+
+#define SC_FM_PACKED_RECORD_MAGIC   0x52504653  // "SFPR"
+#define SC_FM_PACKED_INDEX_MAGIC    0x49504653  // "SFPI"
+#define SC_FM_PACKED_INDEX_FORMAT   1
+#define SC_FM_PACKED_FILE_MAX_SIZE  (1 << 30)   // size of data file, after that new one is started
+#define SC_FM_PACKED_FILES_MAX      4096        // maximum number of data files
+#define SC_FM_PACKED_NO_FILE        G_MAXUINT32 // file number of checksum, that has references, but no stored data
+
+//! Header of content record in data file
+typedef struct _sc_fm_packed_record_header
+{
+    sc_uint32 magic;                            // SC_FM_PACKED_RECORD_MAGIC
+    sc_uint32 length;                           // length of content data
+    sc_char checksum[SC_MAX_CHECKSUM_LEN];
+} sc_fm_packed_record_header;
+
+//! Content with specified checksum and sc-links, that refer to it
+typedef struct _sc_fm_packed_blob
+{
+    sc_char checksum[SC_MAX_CHECKSUM_LEN];
+    sc_uint32 file;             // number of data file, SC_FM_PACKED_NO_FILE - data isn't stored
+    sc_uint32 length;           // length of content data
+    sc_uint64 offset;           // offset of content data in file
+    sc_addr *addrs;             // sorted sc-addrs of sc-links with this content
+    sc_uint32 addrs_count;
+    sc_uint32 addrs_capacity;
+} sc_fm_packed_blob;
+
+/*! Reads content data from data file. It doesn't lock index, so it can be called by many threads at once
+ * @param file Number of data file
+ * @param offset Offset of data in file
+ * @param data Pointer to buffer for data
+ * @param length Number of bytes to read
+ */
+sc_bool sc_fm_packed_read(sc_uint32 file, sc_uint64 offset, sc_char *data, sc_uint32 length);
+
+/*! Appends content with specified checksum into data file. If there is such content already, then
+ * data isn't written again
+ */
+sc_result sc_fm_packed_append(const sc_check_sum *check_sum, sc_char const *data, sc_uint32 length);
+
+#endif
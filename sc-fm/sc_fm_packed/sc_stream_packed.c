@@ -0,0 +1,166 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_stream_packed.h"
+#include "sc_stream_private.h"
+#include "sc_fm_packed.h"
+
+#include <glib.h>
+#include <memory.h>
+
+struct _sc_packed_handler
+{
+    sc_uint32 file;             // number of data file to read
+    sc_uint64 offset;           // offset of content data in file
+    sc_uint32 pos;              // current seek position
+    sc_uint32 size;             // size of content data in bytes
+    GByteArray *buffer;         // written data, that is appended into data file on stream free
+    sc_check_sum check_sum;     // checksum of written data
+};
+
+typedef struct _sc_packed_handler sc_packed_handler;
+
+
+sc_result sc_stream_packed_read(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_read)
+{
+    sc_packed_handler *handler = (sc_packed_handler*)stream->handler;
+    g_assert(handler != 0);
+
+    if (handler->buffer != null_ptr)
+        return SC_RESULT_ERROR;
+
+    *bytes_read = MIN(length, handler->size - handler->pos);
+    if (*bytes_read > 0 && sc_fm_packed_read(handler->file, handler->offset + handler->pos, data, *bytes_read) == SC_FALSE)
+    {
+        *bytes_read = 0;
+        return SC_RESULT_ERROR_IO;
+    }
+    handler->pos += *bytes_read;
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_stream_packed_write(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_written)
+{
+    sc_packed_handler *handler = (sc_packed_handler*)stream->handler;
+    g_assert(handler != 0);
+
+    if (handler->buffer == null_ptr)
+        return SC_RESULT_ERROR;
+
+    g_byte_array_append(handler->buffer, (guint8*)data, length);
+    handler->size = handler->pos = handler->buffer->len;
+    *bytes_written = length;
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_stream_packed_seek(const sc_stream *stream, sc_stream_seek_origin origin, sc_uint32 offset)
+{
+    sc_packed_handler *handler = (sc_packed_handler*)stream->handler;
+    g_assert(handler != 0);
+
+    switch (origin)
+    {
+    case SC_STREAM_SEEK_END:
+        if (offset > handler->size)
+            return SC_RESULT_ERROR_INVALID_PARAMS;
+        handler->pos = handler->size - offset;
+        break;
+
+    case SC_STREAM_SEEK_CUR:
+        if (offset > (handler->size - handler->pos))
+            return SC_RESULT_ERROR_INVALID_PARAMS;
+        handler->pos += offset;
+        break;
+
+    case SC_STREAM_SEEK_SET:
+        if (offset > handler->size)
+            return SC_RESULT_ERROR_INVALID_PARAMS;
+        handler->pos = offset;
+        break;
+    };
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_stream_packed_tell(const sc_stream *stream, sc_uint32 *position)
+{
+    sc_packed_handler *handler = (sc_packed_handler*)stream->handler;
+    g_assert(handler != 0);
+
+    *position = handler->pos;
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_stream_packed_free_handler(const sc_stream *stream)
+{
+    sc_packed_handler *handler = (sc_packed_handler*)stream->handler;
+    sc_result res = SC_RESULT_OK;
+    g_assert(handler != 0);
+
+    if (handler->buffer != null_ptr)
+    {
+        res = sc_fm_packed_append(&handler->check_sum, (sc_char const*)handler->buffer->data, handler->buffer->len);
+        if (res != SC_RESULT_OK)
+            g_critical("Can't append content into packed file memory");
+        g_byte_array_free(handler->buffer, TRUE);
+    }
+
+    g_free(handler);
+
+    return res;
+}
+
+sc_bool sc_stream_packed_eof(const sc_stream *stream)
+{
+    sc_packed_handler *handler = (sc_packed_handler*)stream->handler;
+    g_assert(handler != 0);
+
+    if (handler->pos == handler->size)
+        return SC_TRUE;
+
+    return SC_FALSE;
+}
+
+sc_stream* _sc_stream_packed_new(sc_packed_handler *handler, sc_uint8 flags)
+{
+    sc_stream *stream = g_new0(sc_stream, 1);
+
+    stream->flags = flags | SC_STREAM_FLAG_SEEK | SC_STREAM_FLAG_TELL;
+    stream->handler = (void*)handler;
+
+    stream->read_func = &sc_stream_packed_read;
+    stream->write_func = &sc_stream_packed_write;
+    stream->seek_func = &sc_stream_packed_seek;
+    stream->tell_func = &sc_stream_packed_tell;
+    stream->free_func = &sc_stream_packed_free_handler;
+    stream->eof_func = &sc_stream_packed_eof;
+
+    return stream;
+}
+
+sc_stream* sc_stream_packed_read_new(sc_uint32 file, sc_uint64 offset, sc_uint32 size)
+{
+    sc_packed_handler *handler = g_new0(sc_packed_handler, 1);
+
+    handler->file = file;
+    handler->offset = offset;
+    handler->size = size;
+
+    return _sc_stream_packed_new(handler, SC_STREAM_FLAG_READ);
+}
+
+sc_stream* sc_stream_packed_write_new(const sc_check_sum *check_sum)
+{
+    sc_packed_handler *handler = g_new0(sc_packed_handler, 1);
+
+    handler->buffer = g_byte_array_new();
+    handler->check_sum = *check_sum;
+
+    return _sc_stream_packed_new(handler, SC_STREAM_FLAG_WRITE);
+}
@@ -0,0 +1,27 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_stream_packed_h_
+#define _sc_stream_packed_h_
+
+#include "sc_stream.h"
+
+/*! Create stream to read content data from packed data file
+ * @param file Number of data file
+ * @param offset Offset of content data in file
+ * @param size Length of content data
+ * @remarks The returned stream pointer should be freed with sc_stream_free function, when done using it.
+ */
+sc_stream* sc_stream_packed_read_new(sc_uint32 file, sc_uint64 offset, sc_uint32 size);
+
+/*! Create stream to write content data with specified checksum. Data is buffered and appended into data
+ * file, when stream is freed, so one content record is written at once.
+ * @param check_sum Pointer to checksum of content
+ * @remarks The returned stream pointer should be freed with sc_stream_free function, when done using it.
+ */
+sc_stream* sc_stream_packed_write_new(const sc_check_sum *check_sum);
+
+#endif // _sc_stream_packed_h_
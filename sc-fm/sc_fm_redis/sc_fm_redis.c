@@ -8,6 +8,7 @@
 #include "sc_fm_engine_private.h"
 #include "sc_stream_redis.h"
 #include "sc_fm_redis_config.h"
+#include "sc_link_helpers.h"
 #include "../sc_memory.h"
 
 #include <glib.h>
@@ -130,9 +131,9 @@ sc_result sc_redis_engine_create_stream(const sc_fm_engine *engine, const sc_che
     g_assert(data);
 
     char key[128];
-    char *check_sum_str = g_strndup(check_sum->data, check_sum->len);
+    char check_sum_str[SC_CHECKSUM_STRING_SIZE];
+    sc_link_checksum_to_string(check_sum, check_sum_str);
     g_snprintf(key, 128, "link:%s:data", check_sum_str);
-    g_free(check_sum_str);
 
     *stream = 0;
     *stream = sc_stream_redis_new(data->context, key, flags, &redis_mutex);
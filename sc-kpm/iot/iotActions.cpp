@@ -151,7 +151,7 @@ namespace iot
 
 		ScTemplateSearchResult searchResult;
 
-		if (mMemoryCtx->helperSearchTemplate(periodTempl, searchResult))
+		if (mMemoryCtx->helperSearchTemplate(periodTempl, searchResult, 1))
 		{
 			check_expr(searchResult.getSize() > 0);
 			ScTemplateSearchResultItem const item = searchResult[0];
@@ -194,7 +194,7 @@ namespace iot
 
 		ScTemplateSearchResult searchResult;
 
-		if (mMemoryCtx->helperSearchTemplate(timeTempl, searchResult))
+		if (mMemoryCtx->helperSearchTemplate(timeTempl, searchResult, 1))
 		{
 			check_expr(searchResult.getSize() > 0);
 			ScTemplateSearchResultItem const item = searchResult[0];
@@ -246,8 +246,7 @@ namespace iot
 					ScType(sc_type_arc_pos_const_perm),
 					task.action);
 
-				ScTemplateSearchResult searchResult;
-				if (!mMemoryCtx->helperSearchTemplate(initTempl, searchResult))
+				if (!mMemoryCtx->helperSearchTemplateExists(initTempl))
 				{
 					ScTemplateGenResult genResult;
 					mMemoryCtx->helperGenTemplate(initTempl, genResult);
@@ -58,25 +58,19 @@ namespace iot
 				);
 
 			// Devices
-			ScTemplateSearchResult searchResult;
-			if (mMemoryCtx.helperSearchTemplate(templDevice, searchResult))
-			{
-				size_t const resultNum = searchResult.getSize();
-				for (size_t i = 0; i < resultNum; ++i)
+			mMemoryCtx.helperSearchTemplateForEach(templDevice, [this, &result](ScTemplateSearchResultItem const & res) {
+				/// TODO: implement support of different types (int, float, ...)
+				ScAddr const & link = res["link"];
+				ScStream stream;
+				if (mMemoryCtx.getLinkContent(link, stream) && (stream.size() == sizeof(float)))
 				{
-					ScTemplateSearchResultItem const res = searchResult[i];
-
-					/// TODO: implement support of different types (int, float, ...)
-					ScAddr const & link = res["link"];
-					ScStream stream;
-					if (mMemoryCtx.getLinkContent(link, stream) && (stream.size() == sizeof(float)))
-					{
-						float value = 0.f;
-						if (stream.readType(value))
-							result += value;
-					}
+					float value = 0.f;
+					if (stream.readType(value))
+						result += value;
 				}
-			}
+
+				return ScTemplateSearchRequest::Continue;
+			});
 
 			// update value for a current group
 
@@ -97,7 +91,8 @@ namespace iot
 					);
 
 			ScAddr linkAddr;
-			if (mMemoryCtx.helperSearchTemplate(templPowerUsage, searchResult))
+			ScTemplateSearchResult searchResult;
+			if (mMemoryCtx.helperSearchTemplate(templPowerUsage, searchResult, 1))
 			{
 				linkAddr = searchResult[0]["link"];
 			}
@@ -12,7 +12,7 @@
 #include <glib.h>
 #include <sc_memory_headers.h>
 
-#define MAKE_SC_ADDR_HASH(elem) GINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(elem))
+#define MAKE_SC_ADDR_HASH(elem) GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(elem))
 
 sc_result agent_set_cantorization(const sc_event *event, sc_addr arg)
 {
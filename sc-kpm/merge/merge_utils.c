@@ -73,7 +73,7 @@ sc_result merge_sc_elements(sc_addr first, sc_addr second)
 sc_addr resolve_sc_addr_from_pointer(gpointer data)
 {
     sc_addr elem;
-    elem.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_INT(data));
-    elem.seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_INT(data));
+    elem.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_SIZE(data));
+    elem.seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_SIZE(data));
     return elem;
 }
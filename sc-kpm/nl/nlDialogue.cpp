@@ -65,7 +65,7 @@ namespace nl
                      Keynodes::msNrelResult);
 
                 ScTemplateSearchResult searchResult;
-                if (!mMemoryCtx.helperSearchTemplate(resultTemplate, searchResult))
+                if (!mMemoryCtx.helperSearchTemplate(resultTemplate, searchResult, 1))
                     return SC_RESULT_ERROR_INVALID_STATE;
 
                 ScAddr resultAddr;
@@ -85,7 +85,7 @@ namespace nl
                      Keynodes::msRrelLastItem);
 
                 ScAddr lastItemAddr;
-                if (mMemoryCtx.helperSearchTemplate(lastItemTemplate, searchResult))
+                if (mMemoryCtx.helperSearchTemplate(lastItemTemplate, searchResult, 1))
                 {
                     ScTemplateSearchResultItem item = searchResult[0];
                     lastItemAddr = item["_last_item"];
@@ -287,8 +287,8 @@ void erase_var_set_values(sc_memory_context *context, scp_operand *set)
 sc_addr resolve_sc_addr_from_pointer(gpointer data)
 {
     sc_addr elem;
-    elem.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_INT(data));
-    elem.seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_INT(data));
+    elem.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_SIZE(data));
+    elem.seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_SIZE(data));
     return elem;
 }
 
@@ -38,11 +38,11 @@ struct sc_addr_comparator
 };
 
 typedef std::map<sc_addr, sc_addr, sc_addr_comparator> sc_type_result;
-typedef std::map<int, sc_addr> sc_type_hash;
+typedef std::map<sc_addr_hash, sc_addr> sc_type_hash;
 typedef std::vector<sc_type_result *> sc_type_result_vector;
 typedef std::vector<sc_addr> sc_addr_vector;
 typedef std::pair<sc_addr, sc_addr> sc_addr_pair;
-typedef std::pair<int, sc_addr> sc_hash_pair;
+typedef std::pair<sc_addr_hash, sc_addr> sc_hash_pair;
 
 void print_hash(sc_type_hash table);
 void print_result(sc_memory_context *context, sc_type_result table);
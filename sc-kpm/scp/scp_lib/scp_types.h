@@ -30,9 +30,9 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #define MAKE_COMMON_ARC_ASSIGN(operand) { operand.addr.seg = 0; operand.addr.offset = 0; operand.element_type = scp_type_arc_common | scp_type_const; operand.param_type = SCP_ASSIGN; operand.erase = SCP_FALSE; operand.set = SCP_FALSE; operand.operand_type=SCP_CONST;}
 #define MAKE_DEFAULT_NODE_ASSIGN(operand) { operand.addr.seg = 0; operand.addr.offset = 0; operand.element_type = scp_type_const | scp_type_node; operand.param_type = SCP_ASSIGN; operand.erase = SCP_FALSE; operand.set = SCP_FALSE; operand.operand_type=SCP_CONST;}
 
-#define MAKE_SC_ADDR_HASH(elem) GINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(elem))
-#define MAKE_HASH(elem) GINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT((elem).addr))
-#define MAKE_PHASH(elem) GINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT((elem)->addr))
+#define MAKE_SC_ADDR_HASH(elem) GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(elem))
+#define MAKE_HASH(elem) GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT((elem).addr))
+#define MAKE_PHASH(elem) GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT((elem)->addr))
 
 // parameter type
 enum _scp_param_type
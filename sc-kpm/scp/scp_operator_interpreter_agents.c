@@ -2447,7 +2447,7 @@ sc_result scp_event_procedure_processor(const sc_event *event, sc_addr arg)
         return SC_RESULT_OK;
     }
     quest.param_type = SCP_ASSIGN;
-    agent_scp_program.addr = resolve_sc_addr_from_int((scp_uint32)sc_event_get_data(event));
+    agent_scp_program.addr = resolve_sc_addr_from_pointer(sc_event_get_data(event));
     agent_scp_program.param_type = SCP_FIXED;
 
     MAKE_DEFAULT_NODE_ASSIGN(quest);
@@ -2473,7 +2473,7 @@ sc_result sys_wait_processor(const sc_event *event, sc_addr arg)
     scp_operand operator_node, arc;
     MAKE_DEFAULT_ARC_ASSIGN(arc);
     MAKE_DEFAULT_OPERAND_FIXED(operator_node);
-    operator_node.addr = resolve_sc_addr_from_int((scp_uint32)sc_event_get_data(event));
+    operator_node.addr = resolve_sc_addr_from_pointer(sc_event_get_data(event));
     if (SCP_RESULT_TRUE == searchElStr3(s_default_ctx, &active_scp_operator, &arc, &operator_node))
     {
         g_hash_table_remove(scp_wait_event_table, MAKE_HASH(operator_node));
@@ -2495,7 +2495,7 @@ scp_result create_sys_wait_event(sc_memory_context *context, scp_operand *operan
         return print_error("Event processing", "Can't resolve event type");
     }
 
-    event = sc_event_new(context, operands[1].addr, type, (sc_pointer)SC_ADDR_LOCAL_TO_INT(operator_node->addr), (fEventCallback)sys_wait_processor, NULL);
+    event = sc_event_new(context, operands[1].addr, type, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(operator_node->addr)), (fEventCallback)sys_wait_processor, NULL);
     g_hash_table_insert(scp_wait_event_table, MAKE_PHASH(operator_node), (gpointer)event);
     return SC_RESULT_OK;
 }
@@ -3717,7 +3717,7 @@ sc_result sc_agent_activator(sc_event *in_event, sc_addr arg)
     {
         if (SCP_TRUE != resolve_sc_agent_event_type(s_default_ctx, &event_type, &type))
             return SC_RESULT_OK;
-        event = sc_event_new(s_default_ctx, event_elem.addr, type, (sc_pointer)SC_ADDR_LOCAL_TO_INT(agent_program.addr), (fEventCallback)scp_event_procedure_processor, NULL);
+        event = sc_event_new(s_default_ctx, event_elem.addr, type, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(agent_program.addr)), (fEventCallback)scp_event_procedure_processor, NULL);
         g_hash_table_insert(scp_event_table, MAKE_HASH(agent_program), (gpointer)event);
 
         printf("REGISTERING SCP AGENT PROGRAM: ");
@@ -3784,7 +3784,7 @@ scp_result init_all_scp_agents(sc_memory_context *context)
         {
             if (SCP_TRUE != resolve_sc_agent_event_type(context, &event_type, &type))
                 continue;
-            event = sc_event_new(s_default_ctx, event_elem.addr, type, SC_ADDR_LOCAL_TO_INT(agent_program.addr), (fEventCallback)scp_event_procedure_processor, NULL);
+            event = sc_event_new(s_default_ctx, event_elem.addr, type, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(agent_program.addr)), (fEventCallback)scp_event_procedure_processor, NULL);
             g_hash_table_insert(scp_event_table, MAKE_HASH(agent_program), (gpointer)event);
 
             printf("REGISTERING SCP AGENT PROGRAM: ");
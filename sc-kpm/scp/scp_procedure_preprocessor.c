@@ -38,8 +38,8 @@ void append_to_hash(GHashTable *table, scp_operand *elem)
 void append_to_set(gpointer key, gpointer value, gpointer set)
 {
     sc_addr elem;
-    elem.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_INT(key));
-    elem.seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_INT(key));
+    elem.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_SIZE(key));
+    elem.seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_SIZE(key));
     sc_memory_arc_new(s_default_ctx, sc_type_arc_pos_const_perm, ((scp_operand *)set)->addr, elem);
 }
 
@@ -0,0 +1,162 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Benchmark of answer construction. Each element is appended into answer like appendIntoAnswer
+ * in sc-kpm does: sc-arc is created, if sc_helper_check_arc doesn't find it. Workloads:
+ *  - answer: N new elements are appended into one answer, then all of them are appended again;
+ *  - shared: the same element (like keynode) is appended into N answers, so it has N input arcs.
+ * Each workload is run with iterators (f_a_f walks input arcs of element) and with index of sc-arcs
+ * ([memory] arc_index). Workload is stopped, when it works longer than time budget.
+ *
+ * Usage: sc-memory-answer-bench [time budget in seconds] [elements count ...]
+ */
+
+extern "C"
+{
+#include "sc_memory_headers.h"
+#include "sc_helper.h"
+
+#include <glib.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+struct Result
+{
+    sc_uint32 done;     // number of appended elements
+    double seconds;
+};
+
+double secondsFrom(tClock::time_point const & start)
+{
+    return std::chrono::duration<double>(tClock::now() - start).count();
+}
+
+void appendIntoAnswer(sc_memory_context * ctx, sc_addr answer, sc_addr el)
+{
+    if (sc_helper_check_arc(ctx, answer, el, sc_type_arc_pos_const_perm) == SC_TRUE)
+        return;
+
+    sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, answer, el);
+}
+
+Result benchAnswer(sc_memory_context * ctx, sc_uint32 count, double budget)
+{
+    Result result = { 0, 0.0 };
+    std::vector<sc_addr> elements(count);
+    for (sc_uint32 i = 0; i < count; ++i)
+        elements[i] = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+
+    sc_addr const answer = sc_memory_node_new(ctx, sc_type_node | sc_type_const | sc_type_node_struct);
+
+    tClock::time_point const start = tClock::now();
+    for (sc_uint32 pass = 0; pass < 2; ++pass)
+    {
+        for (sc_uint32 i = 0; i < count; ++i, ++result.done)
+        {
+            appendIntoAnswer(ctx, answer, elements[i]);
+            if ((i & 1023) == 0 && secondsFrom(start) > budget)
+                break;
+        }
+    }
+    result.seconds = secondsFrom(start);
+
+    return result;
+}
+
+Result benchShared(sc_memory_context * ctx, sc_uint32 count, double budget)
+{
+    Result result = { 0, 0.0 };
+    std::vector<sc_addr> answers(count);
+    for (sc_uint32 i = 0; i < count; ++i)
+        answers[i] = sc_memory_node_new(ctx, sc_type_node | sc_type_const | sc_type_node_struct);
+
+    sc_addr const keynode = sc_memory_node_new(ctx, sc_type_node | sc_type_const | sc_type_node_class);
+
+    tClock::time_point const start = tClock::now();
+    for (sc_uint32 i = 0; i < count; ++i, ++result.done)
+    {
+        appendIntoAnswer(ctx, answers[i], keynode);
+        if ((i & 1023) == 0 && secondsFrom(start) > budget)
+            break;
+    }
+    result.seconds = secondsFrom(start);
+
+    return result;
+}
+
+void printResult(char const * mode, char const * workload, sc_uint32 count, sc_uint32 total, Result const & result)
+{
+    printf("%-8s %-8s %8u %12.1f %12.2f %s\n", mode, workload, count, result.seconds * 1000.0,
+           result.seconds * 1000000.0 / (result.done ? result.done : 1),
+           (result.done < total) ? "(stopped by time budget)" : "");
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    double const budget = (argc > 1) ? atof(argv[1]) : 60.0;
+    std::vector<sc_uint32> counts;
+    for (int i = 2; i < argc; ++i)
+        counts.push_back((sc_uint32)atoi(argv[i]));
+    if (counts.empty())
+    {
+        counts.push_back(10000);
+        counts.push_back(100000);
+    }
+
+    std::string const repo = std::string(g_get_tmp_dir()) + "/sc-memory-answer-bench";
+    std::string const config = repo + ".ini";
+
+    printf("%-8s %-8s %8s %12s %12s\n", "mode", "workload", "count", "total ms", "us/append");
+    for (sc_uint32 indexed = 0; indexed < 2; ++indexed)
+    {
+        FILE * file = fopen(config.c_str(), "w");
+        if (file == 0)
+        {
+            printf("Can't write config: %s\n", config.c_str());
+            return EXIT_FAILURE;
+        }
+        fprintf(file, "[memory]\narc_index = %s\n", indexed ? "true" : "false");
+        fclose(file);
+
+        char const * mode = indexed ? "index" : "iterate";
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            sc_memory_params params;
+            sc_memory_params_clear(&params);
+            params.clear = SC_TRUE;
+            params.repo_path = repo.c_str();
+            params.config_file = config.c_str();
+
+            if (sc_memory_initialize(&params) == 0)
+            {
+                printf("Can't initialize sc-memory in %s\n", repo.c_str());
+                return EXIT_FAILURE;
+            }
+
+            sc_memory_context * ctx = sc_memory_context_new(sc_access_lvl_make_max);
+            printResult(mode, "answer", counts[i], counts[i] * 2, benchAnswer(ctx, counts[i], budget));
+            printResult(mode, "shared", counts[i], counts[i], benchShared(ctx, counts[i], budget));
+
+            sc_memory_context_free(ctx);
+            sc_memory_shutdown(SC_FALSE);
+        }
+    }
+
+    remove(config.c_str());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Benchmark of iterators on element with high degree. Class node has D members (output and input
+ * sc-arcs) and a few relation sc-arcs. Workloads:
+ *  - typed: iterate output relation sc-arcs of class (f_a_a with sc_type_arc_common);
+ *  - f_a_f: check, that random member is connected with class (f_a_f with class as end);
+ *  - all: iterate all output member sc-arcs of class (most of sc-arcs match, so list is walked).
+ * Each workload is run with list walk ([memory] adjacency_threshold = 0) and with adjacency, that is
+ * built by the first iteration. Workload is stopped, when it works longer than time budget.
+ *
+ * Usage: sc-memory-degree-bench [time budget in seconds] [degree ...]
+ */
+
+extern "C"
+{
+#include "sc_memory_headers.h"
+#include "sc-store/sc_adjacency.h"
+
+#include <glib.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+sc_uint32 const RELATIONS_COUNT = 8;
+
+double secondsFrom(tClock::time_point const & start)
+{
+    return std::chrono::duration<double>(tClock::now() - start).count();
+}
+
+sc_uint32 iterate(sc_iterator3 * it)
+{
+    sc_uint32 count = 0;
+    while (sc_iterator3_next(it) == SC_TRUE)
+        ++count;
+    sc_iterator3_free(it);
+    return count;
+}
+
+void printResult(char const * mode, char const * workload, sc_uint32 degree, sc_uint32 done, sc_uint32 total, double seconds)
+{
+    printf("%-10s %-6s %9u %8u %14.2f %s\n", mode, workload, degree, done,
+           seconds * 1000000.0 / (done ? done : 1),
+           (done < total) ? "(stopped by time budget)" : "");
+}
+
+void bench(sc_memory_context * ctx, char const * mode, sc_uint32 degree, double budget)
+{
+    sc_addr const cls = sc_memory_node_new(ctx, sc_type_node | sc_type_const | sc_type_node_class);
+    std::vector<sc_addr> members(degree);
+    for (sc_uint32 i = 0; i < degree; ++i)
+    {
+        members[i] = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+        sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, cls, members[i]);
+        sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, members[i], cls);
+    }
+    for (sc_uint32 i = 0; i < RELATIONS_COUNT; ++i)
+        sc_memory_arc_new(ctx, sc_type_arc_common | sc_type_const, cls, members[i]);
+
+    // the first iterations walk lists, adjacency is built meanwhile
+    tClock::time_point start = tClock::now();
+    iterate(sc_iterator3_f_a_a_new(ctx, cls, sc_type_arc_common, sc_type_node));
+    iterate(sc_iterator3_a_a_f_new(ctx, sc_type_node, sc_type_arc_pos_const_perm, cls));
+    printf("%-10s %-6s %9u %8u %14.2f %s\n", mode, "first", degree, 2, secondsFrom(start) * 1000000.0 / 2,
+           sc_adjacency_count(cls, SC_ADJACENCY_OUT) > 0 ? "(adjacency is built)" : "");
+
+    sc_uint32 const typed_total = 1000;
+    sc_uint32 done = 0;
+    start = tClock::now();
+    for (; done < typed_total && (done % 16 != 0 || secondsFrom(start) < budget); ++done)
+    {
+        if (iterate(sc_iterator3_f_a_a_new(ctx, cls, sc_type_arc_common, sc_type_node)) != RELATIONS_COUNT)
+            printf("Invalid number of relations\n");
+    }
+    printResult(mode, "typed", degree, done, typed_total, secondsFrom(start));
+
+    sc_uint32 const check_total = 10000;
+    srand(42);
+    start = tClock::now();
+    for (done = 0; done < check_total && (done % 16 != 0 || secondsFrom(start) < budget); ++done)
+    {
+        sc_iterator3 * it = sc_iterator3_f_a_f_new(ctx, members[rand() % degree], sc_type_arc_pos_const_perm, cls);
+        if (sc_iterator3_next(it) == SC_FALSE)
+            printf("Member isn't found\n");
+        sc_iterator3_free(it);
+    }
+    printResult(mode, "f_a_f", degree, done, check_total, secondsFrom(start));
+
+    sc_uint32 const all_total = 10;
+    start = tClock::now();
+    for (done = 0; done < all_total && secondsFrom(start) < budget; ++done)
+    {
+        if (iterate(sc_iterator3_f_a_a_new(ctx, cls, sc_type_arc_pos_const_perm, sc_type_node)) != degree)
+            printf("Invalid number of members\n");
+    }
+    printResult(mode, "all", degree, done, all_total, secondsFrom(start));
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    double const budget = (argc > 1) ? atof(argv[1]) : 30.0;
+    std::vector<sc_uint32> degrees;
+    for (int i = 2; i < argc; ++i)
+        degrees.push_back((sc_uint32)atoi(argv[i]));
+    if (degrees.empty())
+    {
+        degrees.push_back(1000);
+        degrees.push_back(10000);
+        degrees.push_back(100000);
+        degrees.push_back(1000000);
+    }
+
+    std::string const repo = std::string(g_get_tmp_dir()) + "/sc-memory-degree-bench";
+    std::string const config = repo + ".ini";
+
+    printf("%-10s %-6s %9s %8s %14s\n", "mode", "work", "degree", "ops", "us/op");
+    for (sc_uint32 adjacency = 0; adjacency < 2; ++adjacency)
+    {
+        FILE * file = fopen(config.c_str(), "w");
+        if (file == 0)
+        {
+            printf("Can't write config: %s\n", config.c_str());
+            return EXIT_FAILURE;
+        }
+        fprintf(file, "[memory]\nadjacency_threshold = %u\n", adjacency ? 1024 : 0);
+        fclose(file);
+
+        for (size_t i = 0; i < degrees.size(); ++i)
+        {
+            sc_memory_params params;
+            sc_memory_params_clear(&params);
+            params.clear = SC_TRUE;
+            params.repo_path = repo.c_str();
+            params.config_file = config.c_str();
+
+            if (sc_memory_initialize(&params) == 0)
+            {
+                printf("Can't initialize sc-memory in %s\n", repo.c_str());
+                return EXIT_FAILURE;
+            }
+
+            sc_memory_context * ctx = sc_memory_context_new(sc_access_lvl_make_max);
+            bench(ctx, adjacency ? "adjacency" : "list", degrees[i], budget);
+            sc_memory_context_free(ctx);
+            sc_memory_shutdown(SC_FALSE);
+        }
+    }
+
+    remove(config.c_str());
+    return EXIT_SUCCESS;
+}
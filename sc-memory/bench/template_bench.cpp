@@ -0,0 +1,194 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Benchmark of template search plans on knowledge base with hub class. Class concept_entity has D members,
+ * each of them has identifier (sc-link in relation nrel_idtf). A few members are in small class
+ * concept_small and have relation nrel_rare. Templates:
+ *  - intersection: members of both classes (concept_entity _-> _x;; concept_small _-> _x;;);
+ *  - relation: members of hub class with rare relation (concept_entity _-> _x;; _x => nrel_rare: _y;;);
+ *  - idtf: identifier of element (x => nrel_idtf: _link;;);
+ *  - members: identifiers of all members of hub class (concept_entity _-> _x;; _x => nrel_idtf: _link;;),
+ *    it has D results, so it shows cost of one result.
+ * Each template is searched with static and cost based plans, number of results should be equal.
+ * Workload is stopped, when it works longer than time budget.
+ *
+ * Usage: sc-memory-template-bench [time budget in seconds] [degree ...]
+ */
+
+#include "../wrap/sc_memory.hpp"
+#include "../wrap/sc_template.hpp"
+
+extern "C"
+{
+#include <glib.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+size_t const SMALL_COUNT = 16;
+size_t const SEARCH_COUNT = 1000;
+
+double secondsFrom(tClock::time_point const & start)
+{
+	return std::chrono::duration<double>(tClock::now() - start).count();
+}
+
+struct KnowledgeBase
+{
+	ScAddr mEntity;
+	ScAddr mSmall;
+	ScAddr mRare;
+	ScAddr mIdtf;
+	tAddrVector mMembers;
+};
+
+void generate(ScMemoryContext & ctx, size_t degree, KnowledgeBase & kb)
+{
+	kb.mEntity = ctx.createNode(sc_type_node_class | sc_type_const);
+	kb.mSmall = ctx.createNode(sc_type_node_class | sc_type_const);
+	kb.mRare = ctx.createNode(sc_type_node_norole | sc_type_const);
+	kb.mIdtf = ctx.createNode(sc_type_node_norole | sc_type_const);
+
+	for (size_t i = 0; i < degree; ++i)
+	{
+		ScAddr const member = ctx.createNode(sc_type_node | sc_type_const);
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mEntity, member);
+
+		ScAddr const link = ctx.createLink();
+		ctx.setElementSubtype(link, sc_type_const);
+		ScAddr const idtfEdge = ctx.createEdge(sc_type_arc_common | sc_type_const, member, link);
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mIdtf, idtfEdge);
+
+		kb.mMembers.push_back(member);
+	}
+
+	for (size_t i = 0; i < SMALL_COUNT; ++i)
+	{
+		ScAddr const member = kb.mMembers[(i * degree) / SMALL_COUNT];
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mSmall, member);
+
+		ScAddr const value = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const rareEdge = ctx.createEdge(sc_type_arc_common | sc_type_const, member, value);
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mRare, rareEdge);
+	}
+}
+
+void bench(ScMemoryContext & ctx, char const * name, ScTemplate & templ, size_t degree, double budget)
+{
+	ScTemplateSearchPlan const plans[] = { ScTemplateSearchPlan::Static, ScTemplateSearchPlan::CostBased };
+	char const * const planNames[] = { "static", "cost" };
+
+	for (size_t p = 0; p < 2; ++p)
+	{
+		templ.setSearchPlan(plans[p]);
+
+		size_t done = 0;
+		size_t found = 0;
+		tClock::time_point const start = tClock::now();
+		for (; done < SEARCH_COUNT && secondsFrom(start) < budget; ++done)
+		{
+			ScTemplateSearchResult result;
+			ctx.helperSearchTemplate(templ, result);
+			found = result.getSize();
+		}
+
+		double const seconds = secondsFrom(start);
+		printf("%-12s %-6s %9zu %8zu %8zu %14.2f %10.1f %s\n", name, planNames[p], degree, done, found,
+			   seconds * 1000000.0 / (done ? done : 1),
+			   seconds * 1000000000.0 / ((done && found) ? done * found : 1),
+			   (done < SEARCH_COUNT) ? "(stopped by time budget)" : "");
+	}
+}
+
+void benchDegree(size_t degree, double budget)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_max);
+	KnowledgeBase kb;
+	generate(ctx, degree, kb);
+
+	{
+		ScTemplate templ;
+		templ
+			(kb.mEntity, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+			(kb.mSmall, ScType::EDGE_ACCESS_VAR_POS_PERM, "_x");
+		bench(ctx, "intersection", templ, degree, budget);
+	}
+
+	{
+		ScTemplate templ;
+		templ
+			(kb.mEntity, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+			("_x", ScType::EDGE_DCOMMON_VAR >> "_edge", ScType::NODE_VAR >> "_y")
+			(kb.mRare, ScType::EDGE_ACCESS_VAR_POS_PERM, "_edge");
+		bench(ctx, "relation", templ, degree, budget);
+	}
+
+	{
+		ScTemplate templ;
+		templ
+			(kb.mMembers[degree / 2], ScType::EDGE_DCOMMON_VAR >> "_edge", ScType(sc_type_link | sc_type_var) >> "_link")
+			(kb.mIdtf, ScType::EDGE_ACCESS_VAR_POS_PERM, "_edge");
+		bench(ctx, "idtf", templ, degree, budget);
+	}
+
+	{
+		ScTemplate templ;
+		templ
+			(kb.mEntity, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+			("_x", ScType::EDGE_DCOMMON_VAR >> "_edge", ScType(sc_type_link | sc_type_var) >> "_link")
+			(kb.mIdtf, ScType::EDGE_ACCESS_VAR_POS_PERM, "_edge");
+		bench(ctx, "members", templ, degree, budget);
+	}
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	double const budget = (argc > 1) ? atof(argv[1]) : 10.0;
+	std::vector<size_t> degrees;
+	for (int i = 2; i < argc; ++i)
+		degrees.push_back((size_t)atoi(argv[i]));
+	if (degrees.empty())
+	{
+		degrees.push_back(1000);
+		degrees.push_back(10000);
+		degrees.push_back(100000);
+	}
+
+	std::string const repo = std::string(g_get_tmp_dir()) + "/sc-memory-template-bench";
+
+	printf("%-12s %-6s %9s %8s %8s %14s %10s\n", "template", "plan", "degree", "searches", "results", "us/search", "ns/result");
+	for (size_t i = 0; i < degrees.size(); ++i)
+	{
+		sc_memory_params params;
+		sc_memory_params_clear(&params);
+		params.clear = SC_TRUE;
+		params.repo_path = repo.c_str();
+
+		ScMemory::logMute();
+		if (!ScMemory::initialize(params))
+		{
+			printf("Can't initialize sc-memory in %s\n", repo.c_str());
+			return EXIT_FAILURE;
+		}
+
+		benchDegree(degrees[i], budget);
+		ScMemory::shutdown(false);
+		ScMemory::logUnmute();
+	}
+
+	return EXIT_SUCCESS;
+}
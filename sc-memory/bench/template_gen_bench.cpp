@@ -0,0 +1,173 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Benchmark of template generation. Template describes one instance of class with value:
+ *   concept_entity _-> _x;;
+ *   _x => nrel_value: _v;; concept_value _-> _v;;
+ * It is generated N times by ScTemplate (all elements of template are created by one batch) and the same
+ * construction is created N times element by element (createNode/createEdge), as template generation
+ * worked before batches. Result is a number of generated triples per second.
+ * Each workload runs in memory only and with write-ahead log synchronized on each commit, where batch
+ * writes one record instead of one record per element. Workload is stopped, when it works longer than
+ * time budget.
+ *
+ * Usage: sc-memory-template-gen-bench [time budget in seconds] [generations ...]
+ */
+
+#include "../wrap/sc_memory.hpp"
+#include "../wrap/sc_template.hpp"
+
+extern "C"
+{
+#include <glib.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+size_t const TRIPLES_COUNT = 4;
+
+double secondsFrom(tClock::time_point const & start)
+{
+	return std::chrono::duration<double>(tClock::now() - start).count();
+}
+
+struct KnowledgeBase
+{
+	ScAddr mEntity;
+	ScAddr mValueClass;
+	ScAddr mNrelValue;
+};
+
+// Returns number of generated triples
+size_t genElements(ScMemoryContext & ctx, KnowledgeBase const & kb, size_t generations, double budget)
+{
+	size_t triples = 0;
+	tClock::time_point const start = tClock::now();
+	for (size_t i = 0; i < generations && secondsFrom(start) < budget; ++i)
+	{
+		ScAddr const instance = ctx.createNode(sc_type_node | sc_type_const);
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mEntity, instance);
+
+		ScAddr const value = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const valueEdge = ctx.createEdge(sc_type_arc_common | sc_type_const, instance, value);
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mNrelValue, valueEdge);
+		ctx.createEdge(sc_type_arc_pos_const_perm, kb.mValueClass, value);
+
+		triples += TRIPLES_COUNT;
+	}
+
+	return triples;
+}
+
+size_t genTemplate(ScMemoryContext & ctx, KnowledgeBase const & kb, size_t generations, double budget)
+{
+	ScTemplate templ;
+	templ
+		(kb.mEntity, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+		("_x", ScType::EDGE_DCOMMON_VAR >> "_value_edge", ScType::NODE_VAR >> "_v")
+		(kb.mNrelValue, ScType::EDGE_ACCESS_VAR_POS_PERM, "_value_edge")
+		(kb.mValueClass, ScType::EDGE_ACCESS_VAR_POS_PERM, "_v");
+
+	size_t triples = 0;
+	tClock::time_point const start = tClock::now();
+	for (size_t i = 0; i < generations && secondsFrom(start) < budget; ++i)
+	{
+		ScTemplateGenResult result;
+		if (ctx.helperGenTemplate(templ, result))
+			triples += TRIPLES_COUNT;
+	}
+
+	return triples;
+}
+
+void benchGenerations(char const * mode, size_t generations, double budget)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_max);
+
+	KnowledgeBase kb;
+	kb.mEntity = ctx.createNode(sc_type_node_class | sc_type_const);
+	kb.mValueClass = ctx.createNode(sc_type_node_class | sc_type_const);
+	kb.mNrelValue = ctx.createNode(sc_type_node_norole | sc_type_const);
+
+	char const * const names[] = { "elements", "template" };
+	for (size_t m = 0; m < 2; ++m)
+	{
+		tClock::time_point const start = tClock::now();
+		size_t const triples = (m == 0) ? genElements(ctx, kb, generations, budget)
+										: genTemplate(ctx, kb, generations, budget);
+		double const seconds = secondsFrom(start);
+
+		printf("%-6s %-10s %11zu %9zu %10.1f %14.0f %s\n", mode, names[m], generations, triples, seconds * 1000.0,
+			   triples / (seconds > 0.0 ? seconds : 1.0),
+			   (triples < generations * TRIPLES_COUNT) ? "(stopped by time budget)" : "");
+	}
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	double const budget = (argc > 1) ? atof(argv[1]) : 10.0;
+	std::vector<size_t> generations;
+	for (int i = 2; i < argc; ++i)
+		generations.push_back((size_t)atoi(argv[i]));
+	if (generations.empty())
+	{
+		generations.push_back(10000);
+		generations.push_back(100000);
+	}
+
+	std::string const repo = std::string(g_get_tmp_dir()) + "/sc-memory-template-gen-bench";
+	std::string const walConfig = repo + "-wal.ini";
+
+	FILE * config = fopen(walConfig.c_str(), "w");
+	if (config == nullptr)
+	{
+		printf("Can't write configuration %s\n", walConfig.c_str());
+		return EXIT_FAILURE;
+	}
+	fprintf(config, "[memory]\nwal = true\nwal_sync = commit\n");
+	fclose(config);
+
+	char const * const modes[] = { "memory", "wal" };
+
+	printf("%-6s %-10s %11s %9s %10s %14s\n", "mode", "method", "generations", "triples", "ms", "triples/s");
+	for (size_t i = 0; i < generations.size(); ++i)
+	{
+		for (size_t m = 0; m < 2; ++m)
+		{
+			sc_memory_params params;
+			sc_memory_params_clear(&params);
+			params.clear = SC_TRUE;
+			params.repo_path = repo.c_str();
+			params.config_file = (m == 1) ? walConfig.c_str() : nullptr;
+
+			ScMemory::logMute();
+			if (!ScMemory::initialize(params))
+			{
+				printf("Can't initialize sc-memory in %s\n", repo.c_str());
+				return EXIT_FAILURE;
+			}
+
+			benchGenerations(modes[m], generations[i], budget);
+			ScMemory::shutdown(false);
+			ScMemory::logUnmute();
+		}
+	}
+
+	remove(walConfig.c_str());
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Benchmark of parallel template search. Class concept_entity has N instances, each of them is checked
+ * by five more triples of template:
+ *   concept_entity _-> _x;;
+ *   _x => nrel_value: _v;; concept_value _-> _v;;
+ *   _x => nrel_idtf: _link;;
+ * Just a half of values are in concept_value, so half of instances are results.
+ * Template is searched sequentially and in parallel with 1, 2, 4 ... workers up to number of processors
+ * (and with 2x of it), speedup is calculated against sequential search.
+ *
+ * Usage: sc-memory-template-parallel-bench [searches] [instances ...]
+ */
+
+#include "../wrap/sc_memory.hpp"
+#include "../wrap/sc_template.hpp"
+
+extern "C"
+{
+#include <glib.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+double secondsFrom(tClock::time_point const & start)
+{
+	return std::chrono::duration<double>(tClock::now() - start).count();
+}
+
+void generate(ScMemoryContext & ctx, size_t instances, ScTemplate & templ)
+{
+	ScAddr const entity = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const valueClass = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const nrelValue = ctx.createNode(sc_type_node_norole | sc_type_const);
+	ScAddr const nrelIdtf = ctx.createNode(sc_type_node_norole | sc_type_const);
+
+	for (size_t i = 0; i < instances; ++i)
+	{
+		ScAddr const instance = ctx.createNode(sc_type_node | sc_type_const);
+		ctx.createEdge(sc_type_arc_pos_const_perm, entity, instance);
+
+		ScAddr const value = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const valueEdge = ctx.createEdge(sc_type_arc_common | sc_type_const, instance, value);
+		ctx.createEdge(sc_type_arc_pos_const_perm, nrelValue, valueEdge);
+		if (i % 2 == 0)
+			ctx.createEdge(sc_type_arc_pos_const_perm, valueClass, value);
+
+		ScAddr const link = ctx.createLink();
+		ctx.setElementSubtype(link, sc_type_const);
+		ScAddr const idtfEdge = ctx.createEdge(sc_type_arc_common | sc_type_const, instance, link);
+		ctx.createEdge(sc_type_arc_pos_const_perm, nrelIdtf, idtfEdge);
+	}
+
+	templ
+		(entity, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+		("_x", ScType::EDGE_DCOMMON_VAR >> "_value_edge", ScType::NODE_VAR >> "_v")
+		(nrelValue, ScType::EDGE_ACCESS_VAR_POS_PERM, "_value_edge")
+		(valueClass, ScType::EDGE_ACCESS_VAR_POS_PERM, "_v")
+		("_x", ScType::EDGE_DCOMMON_VAR >> "_idtf_edge", ScType(sc_type_link | sc_type_var) >> "_link")
+		(nrelIdtf, ScType::EDGE_ACCESS_VAR_POS_PERM, "_idtf_edge");
+}
+
+// Returns seconds per search. Workers count 0 means sequential search
+double bench(ScMemoryContext & ctx, ScTemplate const & templ, size_t workers, size_t searches, size_t & found)
+{
+	tClock::time_point const start = tClock::now();
+	for (size_t i = 0; i < searches; ++i)
+	{
+		ScTemplateSearchResult result;
+		if (workers == 0)
+			ctx.helperSearchTemplate(templ, result);
+		else
+			ctx.helperSearchTemplateParallel(templ, result, ScTemplateParallelParams(workers));
+		found = result.getSize();
+	}
+
+	return secondsFrom(start) / searches;
+}
+
+void benchInstances(size_t instances, size_t searches, size_t processors)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_max);
+	ScTemplate templ;
+	generate(ctx, instances, templ);
+
+	size_t found = 0;
+	double const sequential = bench(ctx, templ, 0, searches, found);
+	printf("%9zu %-10s %8zu %12.2f %8.2f\n", instances, "sequential", found, sequential * 1000.0, 1.0);
+
+	std::vector<size_t> workers;
+	for (size_t w = 1; w < processors * 2; w *= 2)
+		workers.push_back(w);
+	if (workers.back() != processors)
+		workers.push_back(processors);
+	workers.push_back(processors * 2);
+
+	for (size_t const w : workers)
+	{
+		size_t parallelFound = 0;
+		double const parallel = bench(ctx, templ, w, searches, parallelFound);
+		printf("%9zu %-10zu %8zu %12.2f %8.2f %s\n", instances, w, parallelFound, parallel * 1000.0, sequential / parallel,
+			   (parallelFound != found) ? "(results differ)" : "");
+	}
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	size_t const searches = (argc > 1) ? (size_t)atoi(argv[1]) : 10;
+	std::vector<size_t> instances;
+	for (int i = 2; i < argc; ++i)
+		instances.push_back((size_t)atoi(argv[i]));
+	if (instances.empty())
+	{
+		instances.push_back(10000);
+		instances.push_back(100000);
+	}
+
+	size_t const processors = g_get_num_processors();
+	std::string const repo = std::string(g_get_tmp_dir()) + "/sc-memory-template-parallel-bench";
+
+	printf("processors: %zu, searches: %zu\n", processors, searches);
+	printf("%9s %-10s %8s %12s %8s\n", "instances", "workers", "results", "ms/search", "speedup");
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		sc_memory_params params;
+		sc_memory_params_clear(&params);
+		params.clear = SC_TRUE;
+		params.repo_path = repo.c_str();
+
+		ScMemory::logMute();
+		if (!ScMemory::initialize(params))
+		{
+			printf("Can't initialize sc-memory in %s\n", repo.c_str());
+			return EXIT_FAILURE;
+		}
+
+		benchInstances(instances[i], searches, processors);
+		ScMemory::shutdown(false);
+		ScMemory::logUnmute();
+	}
+
+	return EXIT_SUCCESS;
+}
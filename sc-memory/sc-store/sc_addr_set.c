@@ -0,0 +1,148 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_addr_set.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <glib.h>
+
+#define SC_ADDR_SET_MIN_CAPACITY 64
+
+sc_uint32 _sc_addr_set_hash(sc_addr_hash value)
+{
+#ifdef SC_WIDE_ADDR
+    value ^= value >> 32;
+#endif
+    // fold high bits, because just low bits of hash are used
+    sc_uint32 const h = (sc_uint32)value * 2654435761u;
+    return h ^ (h >> 16);
+}
+
+//! Inserts index of item into table. Table must have empty slots
+void _sc_addr_set_table_put(sc_addr_set *set, sc_uint32 index)
+{
+    sc_uint32 const mask = set->capacity - 1;
+    sc_uint32 slot = _sc_addr_set_hash(set->items[index]) & mask;
+
+    while (set->table[slot] != 0)
+        slot = (slot + 1) & mask;
+
+    set->table[slot] = index + 1;
+}
+
+void _sc_addr_set_rehash(sc_addr_set *set, sc_uint32 capacity)
+{
+    sc_uint32 i;
+
+    g_free(set->table);
+    set->table = g_new0(sc_uint32, capacity);
+    set->items = g_renew(sc_addr_hash, set->items, capacity / 2);
+    set->capacity = capacity;
+
+    for (i = 0; i < set->count; ++i)
+        _sc_addr_set_table_put(set, i);
+}
+
+int _sc_addr_set_compare(void const *a, void const *b)
+{
+    sc_addr_hash const va = *(sc_addr_hash const*)a;
+    sc_addr_hash const vb = *(sc_addr_hash const*)b;
+    return (va < vb) ? -1 : (va > vb);
+}
+
+void sc_addr_set_init(sc_addr_set *set)
+{
+    g_assert(set != null_ptr);
+
+    set->items = null_ptr;
+    set->count = 0;
+    set->table = null_ptr;
+    set->capacity = 0;
+}
+
+void sc_addr_set_destroy(sc_addr_set *set)
+{
+    g_assert(set != null_ptr);
+
+    g_free(set->items);
+    g_free(set->table);
+    sc_addr_set_init(set);
+}
+
+void sc_addr_set_clear(sc_addr_set *set)
+{
+    sc_uint32 i;
+    sc_uint32 const mask = set->capacity - 1;
+
+    g_assert(set != null_ptr);
+
+    // small sets are cleared by their items, so clear doesn't depend on capacity
+    if (set->count < set->capacity / 8)
+    {
+        for (i = 0; i < set->count; ++i)
+        {
+            sc_uint32 slot = _sc_addr_set_hash(set->items[i]) & mask;
+            while (set->table[slot] != i + 1)
+                slot = (slot + 1) & mask;
+            set->table[slot] = 0;
+        }
+    }
+    else if (set->table != null_ptr)
+        memset(set->table, 0, sizeof(sc_uint32) * set->capacity);
+
+    set->count = 0;
+}
+
+sc_bool sc_addr_set_contains(sc_addr_set const *set, sc_addr_hash value)
+{
+    sc_uint32 mask, slot;
+
+    if (set->count == 0)
+        return SC_FALSE;
+
+    mask = set->capacity - 1;
+    slot = _sc_addr_set_hash(value) & mask;
+    while (set->table[slot] != 0)
+    {
+        if (set->items[set->table[slot] - 1] == value)
+            return SC_TRUE;
+        slot = (slot + 1) & mask;
+    }
+
+    return SC_FALSE;
+}
+
+sc_bool sc_addr_set_add(sc_addr_set *set, sc_addr_hash value)
+{
+    if (sc_addr_set_contains(set, value) == SC_TRUE)
+        return SC_FALSE;
+
+    // keep load factor not greater than 0.5
+    if ((set->count + 1) * 2 > set->capacity)
+        _sc_addr_set_rehash(set, set->capacity == 0 ? SC_ADDR_SET_MIN_CAPACITY : set->capacity * 2);
+
+    set->items[set->count] = value;
+    _sc_addr_set_table_put(set, set->count);
+    ++set->count;
+
+    return SC_TRUE;
+}
+
+void sc_addr_set_sort(sc_addr_set *set)
+{
+    sc_uint32 i;
+
+    if (set->count < 2)
+        return;
+
+    qsort(set->items, set->count, sizeof(sc_addr_hash), _sc_addr_set_compare);
+
+    // indices of items changed, so rebuild table
+    memset(set->table, 0, sizeof(sc_uint32) * set->capacity);
+    for (i = 0; i < set->count; ++i)
+        _sc_addr_set_table_put(set, i);
+}
@@ -0,0 +1,38 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_addr_set_h_
+#define _sc_addr_set_h_
+
+#include "sc_types.h"
+
+/*! Set of sc_addr_hash values (packed sc-addrs, segment sections and etc.), that keeps insertion order.
+ * It is designed to be reused as a scratch storage: clear doesn't free memory, so after warm up
+ * it works without any allocations.
+ */
+typedef struct _sc_addr_set
+{
+    sc_addr_hash *items;        // values in insertion order
+    sc_uint32 count;            // number of values in set
+    sc_uint32 *table;           // open addressing table of (item index + 1), 0 - empty slot
+    sc_uint32 capacity;         // size of table, power of 2
+} sc_addr_set;
+
+//! Initialize empty set
+void sc_addr_set_init(sc_addr_set *set);
+//! Frees memory, used by set
+void sc_addr_set_destroy(sc_addr_set *set);
+//! Removes all values from set. Allocated memory is kept for reuse
+void sc_addr_set_clear(sc_addr_set *set);
+
+//! Returns SC_TRUE, if \p value exists in set
+sc_bool sc_addr_set_contains(sc_addr_set const *set, sc_addr_hash value);
+//! Appends \p value into set. Returns SC_TRUE, if value was added; SC_FALSE, if it already exists in set
+sc_bool sc_addr_set_add(sc_addr_set *set, sc_addr_hash value);
+//! Sorts items of set in ascending order
+void sc_addr_set_sort(sc_addr_set *set);
+
+#endif
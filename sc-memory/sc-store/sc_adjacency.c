@@ -0,0 +1,430 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_adjacency.h"
+#include "sc_iterator.h"
+
+#include <memory.h>
+#include <stdlib.h>
+#include <glib.h>
+
+#define SC_ADJACENCY_SHARDS_BITS        6
+#define SC_ADJACENCY_SHARDS             (1 << SC_ADJACENCY_SHARDS_BITS)
+#define SC_ADJACENCY_MIN_CAPACITY       16
+
+//! Entry of partition. Empty sc-addr isn't used by sc-elements, so entry with empty arc is free
+typedef struct
+{
+    sc_addr_hash other;
+    sc_addr_hash arc;
+    sc_uint32 seq;          // order of sc-arc in list
+} sc_adjacency_entry;
+
+/*! Sc-arcs of one type: open addressing table by other element with linear probing. Several sc-arcs
+ * can have the same other element, they are placed one after another in probe sequence
+ */
+typedef struct
+{
+    sc_type type;
+    sc_adjacency_entry *entries;
+    sc_uint32 capacity;     // power of 2
+    sc_uint32 count;
+} sc_adjacency_partition;
+
+typedef struct
+{
+    sc_adjacency_partition *partitions;
+    sc_uint32 partitions_count;
+    sc_uint32 count;        // number of sc-arcs in all partitions
+    sc_uint32 seq;          // order of next appended sc-arc
+} sc_adjacency_list;
+
+typedef struct
+{
+    sc_adjacency_list lists[2];
+} sc_adjacency;
+
+typedef struct
+{
+    GRWLock lock;
+    GHashTable *table;      // [addr] = sc_adjacency
+} sc_adjacency_shard;
+
+sc_adjacency_shard *adjacency_shards = null_ptr;
+
+sc_uint32 _sc_adjacency_hash(sc_addr_hash value)
+{
+    sc_uint64 h = (sc_uint64)value * 0x9E3779B185EBCA87ULL;
+    return (sc_uint32)(h ^ (h >> 32));
+}
+
+sc_adjacency_shard* _sc_adjacency_shard(sc_addr el)
+{
+    return &adjacency_shards[_sc_adjacency_hash(SC_ADDR_LOCAL_TO_INT(el)) >> (32 - SC_ADJACENCY_SHARDS_BITS)];
+}
+
+void _sc_adjacency_free(gpointer data)
+{
+    sc_adjacency *adj = (sc_adjacency*)data;
+    sc_uint32 i, j;
+
+    for (i = 0; i < 2; ++i)
+    {
+        for (j = 0; j < adj->lists[i].partitions_count; ++j)
+            g_free(adj->lists[i].partitions[j].entries);
+        g_free(adj->lists[i].partitions);
+    }
+
+    g_free(adj);
+}
+
+//! Returns list of sc-arcs in adjacency of \p el. Shard of \p el must be locked
+sc_adjacency_list* _sc_adjacency_list(sc_adjacency_shard *shard, sc_addr el, sc_adjacency_direction dir)
+{
+    sc_adjacency *adj = (sc_adjacency*)g_hash_table_lookup(shard->table, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el)));
+    return (adj != null_ptr) ? &adj->lists[dir] : null_ptr;
+}
+
+void _sc_adjacency_partition_put(sc_adjacency_partition *part, sc_adjacency_entry const *entry)
+{
+    sc_uint32 const mask = part->capacity - 1;
+    sc_uint32 slot = _sc_adjacency_hash(entry->other) & mask;
+
+    while (part->entries[slot].arc != 0)
+        slot = (slot + 1) & mask;
+
+    part->entries[slot] = *entry;
+}
+
+void _sc_adjacency_partition_append(sc_adjacency_partition *part, sc_adjacency_entry const *entry)
+{
+    // keep load factor less than 0.75
+    if ((part->count + 1) * 4 > part->capacity * 3)
+    {
+        sc_adjacency_entry *old = part->entries;
+        sc_uint32 const old_capacity = part->capacity;
+        sc_uint32 i;
+
+        part->capacity = old_capacity * 2;
+        part->entries = g_new0(sc_adjacency_entry, part->capacity);
+        for (i = 0; i < old_capacity; ++i)
+        {
+            if (old[i].arc != 0)
+                _sc_adjacency_partition_put(part, &old[i]);
+        }
+        g_free(old);
+    }
+
+    _sc_adjacency_partition_put(part, entry);
+    ++part->count;
+}
+
+//! Removes sc-arc from partition. If it's found, then its entry is copied into \p removed
+sc_bool _sc_adjacency_partition_remove(sc_adjacency_partition *part, sc_addr_hash arc, sc_addr_hash other, sc_adjacency_entry *removed)
+{
+    sc_uint32 const mask = part->capacity - 1;
+    sc_uint32 slot = _sc_adjacency_hash(other) & mask;
+    sc_uint32 next;
+
+    while (part->entries[slot].arc != 0 && part->entries[slot].arc != arc)
+        slot = (slot + 1) & mask;
+
+    if (part->entries[slot].arc == 0)
+        return SC_FALSE;
+
+    *removed = part->entries[slot];
+
+    // shift next entries back, so probe sequences have no holes
+    next = slot;
+    while (SC_TRUE)
+    {
+        sc_uint32 home;
+        next = (next + 1) & mask;
+        if (part->entries[next].arc == 0)
+            break;
+
+        home = _sc_adjacency_hash(part->entries[next].other) & mask;
+        // entry can be moved into free slot, if its home isn't between free slot and entry
+        if ((slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next))
+        {
+            part->entries[slot] = part->entries[next];
+            slot = next;
+        }
+    }
+
+    memset(&part->entries[slot], 0, sizeof(sc_adjacency_entry));
+    --part->count;
+
+    return SC_TRUE;
+}
+
+//! Returns partition of sc-arcs with \p type. If it doesn't exist, then it's created
+sc_adjacency_partition* _sc_adjacency_list_partition(sc_adjacency_list *list, sc_type type)
+{
+    sc_adjacency_partition *part;
+    sc_uint32 i;
+
+    for (i = 0; i < list->partitions_count; ++i)
+    {
+        if (list->partitions[i].type == type)
+            return &list->partitions[i];
+    }
+
+    list->partitions = g_renew(sc_adjacency_partition, list->partitions, list->partitions_count + 1);
+    part = &list->partitions[list->partitions_count++];
+    part->type = type;
+    part->capacity = SC_ADJACENCY_MIN_CAPACITY;
+    part->count = 0;
+    part->entries = g_new0(sc_adjacency_entry, part->capacity);
+
+    return part;
+}
+
+sc_bool _sc_adjacency_list_remove(sc_adjacency_list *list, sc_addr_hash arc, sc_addr_hash other, sc_adjacency_entry *removed)
+{
+    sc_uint32 i;
+
+    // type of sc-arc could be changed, so all partitions are checked
+    for (i = 0; i < list->partitions_count; ++i)
+    {
+        if (_sc_adjacency_partition_remove(&list->partitions[i], arc, other, removed) == SC_TRUE)
+        {
+            --list->count;
+            return SC_TRUE;
+        }
+    }
+
+    return SC_FALSE;
+}
+
+int _sc_adjacency_entry_compare(void const *a, void const *b)
+{
+    sc_uint32 const seq_a = ((sc_adjacency_entry const*)a)->seq;
+    sc_uint32 const seq_b = ((sc_adjacency_entry const*)b)->seq;
+
+    // the latest sc-arcs are the first in lists
+    return (seq_a < seq_b) ? 1 : ((seq_a > seq_b) ? -1 : 0);
+}
+
+// -----------------------------------------------------------------------------
+
+void sc_adjacency_initialize()
+{
+    sc_uint32 i;
+
+    g_assert(adjacency_shards == null_ptr);
+    adjacency_shards = g_new0(sc_adjacency_shard, SC_ADJACENCY_SHARDS);
+
+    for (i = 0; i < SC_ADJACENCY_SHARDS; ++i)
+    {
+        g_rw_lock_init(&adjacency_shards[i].lock);
+        adjacency_shards[i].table = g_hash_table_new_full(g_direct_hash, g_direct_equal, null_ptr, _sc_adjacency_free);
+    }
+}
+
+void sc_adjacency_shutdown()
+{
+    sc_uint32 i;
+
+    if (adjacency_shards == null_ptr)
+        return;
+
+    for (i = 0; i < SC_ADJACENCY_SHARDS; ++i)
+    {
+        g_hash_table_destroy(adjacency_shards[i].table);
+        g_rw_lock_clear(&adjacency_shards[i].lock);
+    }
+
+    g_free(adjacency_shards);
+    adjacency_shards = null_ptr;
+}
+
+void sc_adjacency_create(sc_addr el)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+
+    g_rw_lock_writer_lock(&shard->lock);
+    g_hash_table_insert(shard->table, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el)), g_new0(sc_adjacency, 1));
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+void sc_adjacency_drop(sc_addr el)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+
+    g_rw_lock_writer_lock(&shard->lock);
+    g_hash_table_remove(shard->table, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el)));
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+void sc_adjacency_append(sc_addr el, sc_adjacency_direction dir, sc_addr arc, sc_type arc_type, sc_addr other)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+    sc_adjacency_list *list;
+
+    g_rw_lock_writer_lock(&shard->lock);
+
+    list = _sc_adjacency_list(shard, el, dir);
+    if (list != null_ptr)
+    {
+        sc_adjacency_entry entry;
+        entry.other = SC_ADDR_LOCAL_TO_INT(other);
+        entry.arc = SC_ADDR_LOCAL_TO_INT(arc);
+        entry.seq = list->seq++;
+
+        _sc_adjacency_partition_append(_sc_adjacency_list_partition(list, sc_flags_remove(arc_type)), &entry);
+        ++list->count;
+    }
+
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+void sc_adjacency_remove(sc_addr el, sc_adjacency_direction dir, sc_addr arc, sc_addr other)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+    sc_adjacency_list *list;
+    sc_adjacency_entry removed;
+
+    g_rw_lock_writer_lock(&shard->lock);
+
+    list = _sc_adjacency_list(shard, el, dir);
+    if (list != null_ptr)
+        _sc_adjacency_list_remove(list, SC_ADDR_LOCAL_TO_INT(arc), SC_ADDR_LOCAL_TO_INT(other), &removed);
+
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+void sc_adjacency_change_type(sc_addr el, sc_adjacency_direction dir, sc_addr arc, sc_addr other, sc_type arc_type)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+    sc_adjacency_list *list;
+    sc_adjacency_entry entry;
+
+    g_rw_lock_writer_lock(&shard->lock);
+
+    list = _sc_adjacency_list(shard, el, dir);
+    if (list != null_ptr && _sc_adjacency_list_remove(list, SC_ADDR_LOCAL_TO_INT(arc), SC_ADDR_LOCAL_TO_INT(other), &entry) == SC_TRUE)
+    {
+        // sc-arc keeps its place in order
+        _sc_adjacency_partition_append(_sc_adjacency_list_partition(list, sc_flags_remove(arc_type)), &entry);
+        ++list->count;
+    }
+
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+void sc_adjacency_reverse(sc_addr el)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+    sc_adjacency *adj;
+    sc_uint32 i, j, k;
+
+    g_rw_lock_writer_lock(&shard->lock);
+
+    adj = (sc_adjacency*)g_hash_table_lookup(shard->table, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el)));
+    for (i = 0; adj != null_ptr && i < 2; ++i)
+    {
+        sc_adjacency_list *list = &adj->lists[i];
+        for (j = 0; j < list->partitions_count; ++j)
+        {
+            sc_adjacency_partition *part = &list->partitions[j];
+            for (k = 0; k < part->capacity; ++k)
+            {
+                if (part->entries[k].arc != 0)
+                    part->entries[k].seq = list->seq - 1 - part->entries[k].seq;
+            }
+        }
+    }
+
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+sc_bool sc_adjacency_collect(sc_addr el, sc_adjacency_direction dir, sc_type arc_type, sc_addr other, sc_addr **arcs, sc_uint32 *count)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+    sc_adjacency_list *list;
+    sc_adjacency_entry *found = null_ptr;
+    sc_uint32 i, j, matched = 0, found_count = 0;
+    sc_addr_hash const other_hash = SC_ADDR_LOCAL_TO_INT(other);
+
+    g_rw_lock_reader_lock(&shard->lock);
+
+    list = _sc_adjacency_list(shard, el, dir);
+    if (list == null_ptr)
+    {
+        g_rw_lock_reader_unlock(&shard->lock);
+        return SC_FALSE;
+    }
+
+    for (i = 0; i < list->partitions_count; ++i)
+    {
+        if (sc_iterator_compare_type(list->partitions[i].type, arc_type) == SC_TRUE)
+            matched += list->partitions[i].count;
+    }
+
+    // collected sc-arcs are sorted, so list walk is cheaper, if most of sc-arcs match
+    if (SC_ADDR_IS_EMPTY(other) && matched * 2 > list->count)
+    {
+        g_rw_lock_reader_unlock(&shard->lock);
+        return SC_FALSE;
+    }
+
+    found = g_new(sc_adjacency_entry, matched + 1);
+    for (i = 0; i < list->partitions_count; ++i)
+    {
+        sc_adjacency_partition const *part = &list->partitions[i];
+        if (sc_iterator_compare_type(part->type, arc_type) == SC_FALSE)
+            continue;
+
+        if (SC_ADDR_IS_EMPTY(other))
+        {
+            for (j = 0; j < part->capacity; ++j)
+            {
+                if (part->entries[j].arc != 0)
+                    found[found_count++] = part->entries[j];
+            }
+        }
+        else
+        {
+            sc_uint32 const mask = part->capacity - 1;
+            for (j = _sc_adjacency_hash(other_hash) & mask; part->entries[j].arc != 0; j = (j + 1) & mask)
+            {
+                if (part->entries[j].other == other_hash)
+                    found[found_count++] = part->entries[j];
+            }
+        }
+    }
+
+    g_rw_lock_reader_unlock(&shard->lock);
+
+    qsort(found, found_count, sizeof(sc_adjacency_entry), _sc_adjacency_entry_compare);
+
+    *arcs = g_new(sc_addr, found_count + 1);
+    for (i = 0; i < found_count; ++i)
+    {
+        (*arcs)[i].seg = SC_ADDR_LOCAL_SEG_FROM_INT(found[i].arc);
+        (*arcs)[i].offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(found[i].arc);
+    }
+    *count = found_count;
+    g_free(found);
+
+    return SC_TRUE;
+}
+
+sc_uint32 sc_adjacency_count(sc_addr el, sc_adjacency_direction dir)
+{
+    sc_adjacency_shard *shard = _sc_adjacency_shard(el);
+    sc_adjacency_list *list;
+    sc_uint32 count = 0;
+
+    g_rw_lock_reader_lock(&shard->lock);
+    list = _sc_adjacency_list(shard, el, dir);
+    if (list != null_ptr)
+        count = list->count;
+    g_rw_lock_reader_unlock(&shard->lock);
+
+    return count;
+}
@@ -0,0 +1,65 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_adjacency_h_
+#define _sc_adjacency_h_
+
+#include "sc_types.h"
+
+/*! Secondary adjacency of sc-elements with high degree. Iterators walk lists of output and input sc-arcs,
+ * so on class nodes with millions of members each filter by arc type or other element touches all sc-arcs.
+ * When iterator walks more than [memory] adjacency_threshold sc-arcs of element, adjacency is built for it
+ * (see sc_storage_adjacency_build): sc-arcs are partitioned by type and hashed by other element in each
+ * partition. Then iterators take just matched sc-arcs from it.
+ *
+ * Adjacency isn't stored, it's built again after restart. It's changed under lock of its sc-element,
+ * so sc-element meta has flag, that it has adjacency (see sc_element_meta).
+ */
+
+typedef enum
+{
+    SC_ADJACENCY_OUT = 0,   // output sc-arcs
+    SC_ADJACENCY_IN = 1     // input sc-arcs
+} sc_adjacency_direction;
+
+//! Initializes table of adjacencies
+void sc_adjacency_initialize();
+//! Frees all adjacencies
+void sc_adjacency_shutdown();
+
+//! Creates empty adjacency of sc-element \p el. Previous adjacency of it is removed
+void sc_adjacency_create(sc_addr el);
+//! Removes adjacency of sc-element \p el, if it exists
+void sc_adjacency_drop(sc_addr el);
+
+/*! Appends sc-arc into adjacency of \p el. Appended sc-arcs are returned by sc_adjacency_collect before
+ * previous ones, like they are placed in lists of sc-arcs.
+ * @param other Other element of sc-arc: end for output sc-arc and begin for input one
+ */
+void sc_adjacency_append(sc_addr el, sc_adjacency_direction dir, sc_addr arc, sc_type arc_type, sc_addr other);
+//! Removes sc-arc from adjacency of \p el
+void sc_adjacency_remove(sc_addr el, sc_adjacency_direction dir, sc_addr arc, sc_addr other);
+//! Moves sc-arc into partition of \p arc_type, when type of sc-arc is changed
+void sc_adjacency_change_type(sc_addr el, sc_adjacency_direction dir, sc_addr arc, sc_addr other, sc_type arc_type);
+
+/*! Reverses order of sc-arcs in adjacency. Adjacency is built by walk from the first (latest) sc-arc in lists,
+ * so order of appended sc-arcs should be reversed after it
+ */
+void sc_adjacency_reverse(sc_addr el);
+
+/*! Collects sc-arcs from adjacency of \p el, that have type matched to \p arc_type (see sc_iterator_compare_type)
+ * and \p other element, if it isn't empty. Sc-arcs are collected in order of lists of sc-arcs
+ * @param arcs Pointer to buffer of collected sc-arcs. It should be freed with g_free
+ * @param count Pointer to number of collected sc-arcs
+ * @return Returns SC_FALSE, if \p el has no adjacency or most of its sc-arcs in direction match filter, so it's
+ * cheaper to walk list of sc-arcs
+ */
+sc_bool sc_adjacency_collect(sc_addr el, sc_adjacency_direction dir, sc_type arc_type, sc_addr other, sc_addr **arcs, sc_uint32 *count);
+
+//! Returns number of sc-arcs in adjacency of \p el in direction \p dir
+sc_uint32 sc_adjacency_count(sc_addr el, sc_adjacency_direction dir);
+
+#endif
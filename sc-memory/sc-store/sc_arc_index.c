@@ -0,0 +1,240 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_arc_index.h"
+
+#include <memory.h>
+#include <glib.h>
+
+#define SC_ARC_INDEX_SHARDS_BITS    6
+#define SC_ARC_INDEX_SHARDS         (1 << SC_ARC_INDEX_SHARDS_BITS)
+#define SC_ARC_INDEX_MIN_CAPACITY   64
+
+//! Entry of index. Empty sc-addr isn't used by sc-elements, so entry with empty arc is free
+typedef struct
+{
+    sc_addr_hash begin;
+    sc_addr_hash end;
+    sc_addr_hash arc;
+} sc_arc_index_entry;
+
+/*! Shard of index: open addressing table with linear probing. Several entries can have the same
+ * pair (begin, end), they are placed one after another in probe sequence
+ */
+typedef struct
+{
+    GRWLock lock;
+    sc_arc_index_entry *entries;
+    sc_uint32 capacity;     // power of 2
+    sc_uint32 count;
+} sc_arc_index_shard;
+
+sc_arc_index_shard *arc_index_shards = null_ptr;
+
+sc_uint64 _sc_arc_index_hash(sc_addr_hash begin, sc_addr_hash end)
+{
+    sc_uint64 h = (sc_uint64)begin * 0x9E3779B185EBCA87ULL;
+    h ^= (sc_uint64)end * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    h *= 0x165667B19E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+//! High bits of hash select shard, low bits select slot in shard
+sc_arc_index_shard* _sc_arc_index_shard(sc_uint64 hash)
+{
+    return &arc_index_shards[hash >> (64 - SC_ARC_INDEX_SHARDS_BITS)];
+}
+
+void _sc_arc_index_put(sc_arc_index_shard *shard, sc_arc_index_entry const *entry)
+{
+    sc_uint32 const mask = shard->capacity - 1;
+    sc_uint32 slot = (sc_uint32)_sc_arc_index_hash(entry->begin, entry->end) & mask;
+
+    while (shard->entries[slot].arc != 0)
+        slot = (slot + 1) & mask;
+
+    shard->entries[slot] = *entry;
+}
+
+void _sc_arc_index_rehash(sc_arc_index_shard *shard, sc_uint32 capacity)
+{
+    sc_arc_index_entry *old = shard->entries;
+    sc_uint32 const old_capacity = shard->capacity;
+    sc_uint32 i;
+
+    shard->entries = g_new0(sc_arc_index_entry, capacity);
+    shard->capacity = capacity;
+
+    for (i = 0; i < old_capacity; ++i)
+    {
+        if (old[i].arc != 0)
+            _sc_arc_index_put(shard, &old[i]);
+    }
+
+    g_free(old);
+}
+
+void sc_arc_index_initialize()
+{
+    sc_uint32 i;
+
+    g_assert(arc_index_shards == null_ptr);
+    arc_index_shards = g_new0(sc_arc_index_shard, SC_ARC_INDEX_SHARDS);
+
+    for (i = 0; i < SC_ARC_INDEX_SHARDS; ++i)
+    {
+        g_rw_lock_init(&arc_index_shards[i].lock);
+        arc_index_shards[i].entries = g_new0(sc_arc_index_entry, SC_ARC_INDEX_MIN_CAPACITY);
+        arc_index_shards[i].capacity = SC_ARC_INDEX_MIN_CAPACITY;
+    }
+}
+
+void sc_arc_index_shutdown()
+{
+    sc_uint32 i;
+
+    if (arc_index_shards == null_ptr)
+        return;
+
+    for (i = 0; i < SC_ARC_INDEX_SHARDS; ++i)
+    {
+        g_free(arc_index_shards[i].entries);
+        g_rw_lock_clear(&arc_index_shards[i].lock);
+    }
+
+    g_free(arc_index_shards);
+    arc_index_shards = null_ptr;
+}
+
+sc_bool sc_arc_index_is_enabled()
+{
+    return (arc_index_shards != null_ptr) ? SC_TRUE : SC_FALSE;
+}
+
+void sc_arc_index_append(sc_addr arc, sc_addr begin, sc_addr end)
+{
+    sc_arc_index_entry entry;
+    sc_arc_index_shard *shard;
+
+    g_assert(arc_index_shards != null_ptr);
+    g_assert(SC_ADDR_IS_NOT_EMPTY(arc));
+
+    entry.begin = SC_ADDR_LOCAL_TO_INT(begin);
+    entry.end = SC_ADDR_LOCAL_TO_INT(end);
+    entry.arc = SC_ADDR_LOCAL_TO_INT(arc);
+    shard = _sc_arc_index_shard(_sc_arc_index_hash(entry.begin, entry.end));
+
+    g_rw_lock_writer_lock(&shard->lock);
+
+    // keep load factor less than 0.75
+    if ((shard->count + 1) * 4 > shard->capacity * 3)
+        _sc_arc_index_rehash(shard, shard->capacity * 2);
+
+    _sc_arc_index_put(shard, &entry);
+    ++shard->count;
+
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+void sc_arc_index_remove(sc_addr arc, sc_addr begin, sc_addr end)
+{
+    sc_addr_hash const b = SC_ADDR_LOCAL_TO_INT(begin);
+    sc_addr_hash const e = SC_ADDR_LOCAL_TO_INT(end);
+    sc_addr_hash const a = SC_ADDR_LOCAL_TO_INT(arc);
+    sc_uint64 const hash = _sc_arc_index_hash(b, e);
+    sc_arc_index_shard *shard = _sc_arc_index_shard(hash);
+    sc_uint32 mask, slot, next;
+
+    g_assert(arc_index_shards != null_ptr);
+
+    g_rw_lock_writer_lock(&shard->lock);
+
+    mask = shard->capacity - 1;
+    slot = (sc_uint32)hash & mask;
+    while (shard->entries[slot].arc != 0 && shard->entries[slot].arc != a)
+        slot = (slot + 1) & mask;
+
+    if (shard->entries[slot].arc == 0)
+    {
+        g_rw_lock_writer_unlock(&shard->lock);
+        return;
+    }
+
+    // shift next entries back, so probe sequences have no holes
+    next = slot;
+    while (SC_TRUE)
+    {
+        sc_uint32 home;
+        next = (next + 1) & mask;
+        if (shard->entries[next].arc == 0)
+            break;
+
+        home = (sc_uint32)_sc_arc_index_hash(shard->entries[next].begin, shard->entries[next].end) & mask;
+        // entry can be moved into free slot, if its home isn't between free slot and entry
+        if ((slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next))
+        {
+            shard->entries[slot] = shard->entries[next];
+            slot = next;
+        }
+    }
+
+    memset(&shard->entries[slot], 0, sizeof(sc_arc_index_entry));
+    --shard->count;
+
+    g_rw_lock_writer_unlock(&shard->lock);
+}
+
+sc_uint32 sc_arc_index_find(sc_addr begin, sc_addr end, sc_addr *arcs, sc_uint32 max_count)
+{
+    sc_addr_hash const b = SC_ADDR_LOCAL_TO_INT(begin);
+    sc_addr_hash const e = SC_ADDR_LOCAL_TO_INT(end);
+    sc_uint64 const hash = _sc_arc_index_hash(b, e);
+    sc_arc_index_shard *shard = _sc_arc_index_shard(hash);
+    sc_uint32 mask, slot, found = 0;
+
+    g_assert(arc_index_shards != null_ptr);
+
+    g_rw_lock_reader_lock(&shard->lock);
+
+    mask = shard->capacity - 1;
+    slot = (sc_uint32)hash & mask;
+    while (shard->entries[slot].arc != 0)
+    {
+        sc_arc_index_entry const *entry = &shard->entries[slot];
+        if (entry->begin == b && entry->end == e)
+        {
+            if (found < max_count)
+            {
+                arcs[found].seg = SC_ADDR_LOCAL_SEG_FROM_INT(entry->arc);
+                arcs[found].offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(entry->arc);
+            }
+            ++found;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    g_rw_lock_reader_unlock(&shard->lock);
+
+    return found;
+}
+
+sc_uint32 sc_arc_index_count()
+{
+    sc_uint32 i, count = 0;
+
+    if (arc_index_shards == null_ptr)
+        return 0;
+
+    for (i = 0; i < SC_ARC_INDEX_SHARDS; ++i)
+    {
+        g_rw_lock_reader_lock(&arc_index_shards[i].lock);
+        count += arc_index_shards[i].count;
+        g_rw_lock_reader_unlock(&arc_index_shards[i].lock);
+    }
+
+    return count;
+}
@@ -0,0 +1,44 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_arc_index_h_
+#define _sc_arc_index_h_
+
+#include "sc_types.h"
+
+/*! Index of sc-arcs by pair of begin and end elements. It allows to find sc-arcs between two elements
+ * (f_a_f check) by constant time, while iterator walks all input arcs of end element.
+ *
+ * Index is optional (see [memory] arc_index in config), because it uses memory for each sc-arc. Sc-arcs of
+ * loaded segments are appended on first usage of segments (see sc_storage_segment_loaded), so index isn't
+ * used for search until all segments are appended. Index is divided into shards with own locks, so
+ * changes of different pairs don't wait each other.
+ */
+
+//! Creates empty index
+void sc_arc_index_initialize();
+//! Frees index
+void sc_arc_index_shutdown();
+//! Returns SC_TRUE, if index is initialized
+sc_bool sc_arc_index_is_enabled();
+
+//! Appends sc-arc into index
+void sc_arc_index_append(sc_addr arc, sc_addr begin, sc_addr end);
+//! Removes sc-arc from index
+void sc_arc_index_remove(sc_addr arc, sc_addr begin, sc_addr end);
+
+/*! Finds sc-arcs between \p begin and \p end elements
+ * @param arcs Pointer to buffer for found sc-arcs
+ * @param max_count Size of \p arcs buffer
+ * @return Returns number of found sc-arcs. If it's greater than \p max_count, then just \p max_count
+ * sc-arcs are stored into buffer
+ */
+sc_uint32 sc_arc_index_find(sc_addr begin, sc_addr end, sc_addr *arcs, sc_uint32 max_count);
+
+//! Returns number of sc-arcs in index
+sc_uint32 sc_arc_index_count();
+
+#endif
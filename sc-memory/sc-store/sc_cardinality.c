@@ -0,0 +1,102 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_cardinality.h"
+
+#include <glib.h>
+
+//! Number of sc-types without flags (see sc_flags_remove)
+#define SC_CARDINALITY_TYPES_COUNT  (sc_flag_request_deletion)
+
+/*! Counter of sc-elements by exact type. Types, that were counted at least once, are kept in list,
+ * so sum by type filter walks a few used types instead of all of them
+ */
+typedef struct
+{
+    gint count;
+    gint used;  // non zero, if type is in list of used types
+} sc_cardinality_counter;
+
+sc_cardinality_counter *cardinality_counters = null_ptr;
+sc_type *cardinality_types = null_ptr;
+gint cardinality_types_count = 0;
+GMutex cardinality_types_mutex;
+
+void sc_cardinality_initialize()
+{
+    g_assert(cardinality_counters == null_ptr);
+
+    cardinality_counters = g_new0(sc_cardinality_counter, SC_CARDINALITY_TYPES_COUNT);
+    cardinality_types = g_new0(sc_type, SC_CARDINALITY_TYPES_COUNT);
+    g_atomic_int_set(&cardinality_types_count, 0);
+}
+
+void sc_cardinality_shutdown()
+{
+    g_free(cardinality_counters);
+    cardinality_counters = null_ptr;
+    g_free(cardinality_types);
+    cardinality_types = null_ptr;
+    g_atomic_int_set(&cardinality_types_count, 0);
+}
+
+void sc_cardinality_append(sc_type type)
+{
+    sc_cardinality_counter *counter = &cardinality_counters[sc_flags_remove(type)];
+
+    if (g_atomic_int_get(&counter->used) == 0)
+    {
+        g_mutex_lock(&cardinality_types_mutex);
+        if (counter->used == 0)
+        {
+            // type is published before counter is marked, so readers see it just once
+            cardinality_types[cardinality_types_count] = sc_flags_remove(type);
+            g_atomic_int_inc(&cardinality_types_count);
+            g_atomic_int_set(&counter->used, 1);
+        }
+        g_mutex_unlock(&cardinality_types_mutex);
+    }
+
+    g_atomic_int_inc(&counter->count);
+}
+
+void sc_cardinality_remove(sc_type type)
+{
+    g_atomic_int_add(&cardinality_counters[sc_flags_remove(type)].count, -1);
+}
+
+void sc_cardinality_change(sc_type old_type, sc_type new_type)
+{
+    if (sc_flags_remove(old_type) == sc_flags_remove(new_type))
+        return;
+
+    sc_cardinality_append(new_type);
+    sc_cardinality_remove(old_type);
+}
+
+sc_uint64 sc_cardinality_get(sc_type type)
+{
+    sc_uint64 result = 0;
+    gint const count = g_atomic_int_get(&cardinality_types_count);
+    gint i;
+
+    if (cardinality_counters == null_ptr)
+        return 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        sc_type const t = cardinality_types[i];
+        if ((t & type) == type)
+        {
+            // removal can be counted before concurrent creation, so counter can be negative for a moment
+            gint const value = g_atomic_int_get(&cardinality_counters[t].count);
+            if (value > 0)
+                result += (sc_uint64)value;
+        }
+    }
+
+    return result;
+}
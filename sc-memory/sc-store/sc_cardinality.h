@@ -0,0 +1,37 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_cardinality_h_
+#define _sc_cardinality_h_
+
+#include "sc_types.h"
+
+/*! Cardinalities of sc-element types: number of existing sc-elements by each type. They are used by
+ * planners of search (see ScTemplateSearch) to estimate selectivity of type filters, so they are
+ * maintained approximately: counters are changed by atomic operations without lock of sc-elements.
+ *
+ * Cardinalities aren't stored, loaded segments are counted on their first usage (see sc_storage_segment_loaded).
+ * Mapped segments, that weren't used yet, are counted by background check of segments.
+ */
+
+//! Resets all cardinalities to zero
+void sc_cardinality_initialize();
+//! Frees cardinalities
+void sc_cardinality_shutdown();
+
+//! Counts new sc-element with \p type
+void sc_cardinality_append(sc_type type);
+//! Uncounts removed sc-element with \p type
+void sc_cardinality_remove(sc_type type);
+//! Moves sc-element from cardinality of \p old_type into cardinality of \p new_type
+void sc_cardinality_change(sc_type old_type, sc_type new_type);
+
+/*! Returns number of sc-elements, that have type matched to \p type (see sc_iterator_compare_type).
+ * Zero \p type matches all sc-elements
+ */
+sc_uint64 sc_cardinality_get(sc_type type);
+
+#endif
@@ -13,10 +13,29 @@ const char str_group_fm[] = "filememory";
 
 const char str_key_max_loaded_segments[] = "max_loaded_segments";
 const char str_key_fm_engine[] = "engine";
+const char str_key_fm_checksum[] = "checksum";
+const char str_key_fm_verify_checksum[] = "verify_checksum";
+const char str_key_wal[] = "wal";
+const char str_key_wal_sync[] = "wal_sync";
+const char str_key_wal_sync_interval[] = "wal_sync_interval";
+const char str_key_arc_index[] = "arc_index";
+const char str_key_adjacency_threshold[] = "adjacency_threshold";
 
 
 // Maximum number of segments, that can be loaded into memory at one moment
-sc_uint config_max_loaded_segments = G_MAXUINT16;
+sc_uint config_max_loaded_segments = SC_SEGMENT_MAX;
+
+// --- write-ahead log ---
+sc_bool config_wal = SC_FALSE;
+const char wal_default_sync[] = "interval";
+const char *config_wal_sync = wal_default_sync;
+sc_uint32 config_wal_sync_interval = 100;
+
+// index of sc-arcs by begin and end
+sc_bool config_arc_index = SC_FALSE;
+
+// secondary adjacency of elements with high degree
+sc_uint32 config_adjacency_threshold = 1024;
 
 
 
@@ -28,6 +47,9 @@ GHashTable *values_table = 0;
 // --- file memory ---
 const char fm_default_engine[] = "filesystem";
 const char *config_fm_engine = fm_default_engine;
+const char fm_default_checksum[] = "fast128";
+const char *config_fm_checksum = fm_default_checksum;
+sc_bool config_fm_verify_checksum = SC_TRUE;
 
 void value_table_destroy_key_value(gpointer data)
 {
@@ -44,19 +66,46 @@ void sc_config_initialize(const sc_char *file_path)
 {
     GKeyFile *key_file = 0;
     key_file = g_key_file_new();
+
+    // setup default values, so options of previously loaded file aren't used
+    config_max_loaded_segments = SC_SEGMENT_MAX;
+    config_wal = SC_FALSE;
+    config_wal_sync = wal_default_sync;
+    config_wal_sync_interval = 100;
+    config_arc_index = SC_FALSE;
+    config_adjacency_threshold = 1024;
+    config_fm_engine = fm_default_engine;
+    config_fm_checksum = fm_default_checksum;
+    config_fm_verify_checksum = SC_TRUE;
+
     if ((file_path != null_ptr) && (g_key_file_load_from_file(key_file, file_path, G_KEY_FILE_NONE, 0) == TRUE))
     {
         // parse settings
         if (g_key_file_has_key(key_file, str_group_memory, str_key_max_loaded_segments, 0) == TRUE)
             config_max_loaded_segments = g_key_file_get_integer(key_file, str_group_memory, str_key_max_loaded_segments, 0);
+        if (config_max_loaded_segments > SC_SEGMENT_MAX)
+            config_max_loaded_segments = SC_SEGMENT_MAX;
+
+        // write-ahead log
+        if (g_key_file_has_key(key_file, str_group_memory, str_key_wal, 0) == TRUE)
+            config_wal = g_key_file_get_boolean(key_file, str_group_memory, str_key_wal, 0) ? SC_TRUE : SC_FALSE;
+        if (g_key_file_has_key(key_file, str_group_memory, str_key_wal_sync, 0) == TRUE)
+            config_wal_sync = g_key_file_get_string(key_file, str_group_memory, str_key_wal_sync, 0);
+        if (g_key_file_has_key(key_file, str_group_memory, str_key_wal_sync_interval, 0) == TRUE)
+            config_wal_sync_interval = g_key_file_get_integer(key_file, str_group_memory, str_key_wal_sync_interval, 0);
+
+        if (g_key_file_has_key(key_file, str_group_memory, str_key_arc_index, 0) == TRUE)
+            config_arc_index = g_key_file_get_boolean(key_file, str_group_memory, str_key_arc_index, 0) ? SC_TRUE : SC_FALSE;
+        if (g_key_file_has_key(key_file, str_group_memory, str_key_adjacency_threshold, 0) == TRUE)
+            config_adjacency_threshold = g_key_file_get_integer(key_file, str_group_memory, str_key_adjacency_threshold, 0);
 
         // file memory
         if (g_key_file_has_key(key_file, str_group_fm, str_key_fm_engine, 0) == TRUE)
             config_fm_engine = g_key_file_get_string(key_file, str_group_fm, str_key_fm_engine, 0);
-    }else
-    {
-        // setup default values
-        config_max_loaded_segments = G_MAXUINT16;
+        if (g_key_file_has_key(key_file, str_group_fm, str_key_fm_checksum, 0) == TRUE)
+            config_fm_checksum = g_key_file_get_string(key_file, str_group_fm, str_key_fm_checksum, 0);
+        if (g_key_file_has_key(key_file, str_group_fm, str_key_fm_verify_checksum, 0) == TRUE)
+            config_fm_verify_checksum = g_key_file_get_boolean(key_file, str_group_fm, str_key_fm_verify_checksum, 0) ? SC_TRUE : SC_FALSE;
     }
 
     // load all values into hash table
@@ -140,3 +189,38 @@ const sc_char* sc_config_fm_engine()
 {
     return config_fm_engine;
 }
+
+const sc_char* sc_config_fm_checksum()
+{
+    return config_fm_checksum;
+}
+
+sc_bool sc_config_fm_verify_checksum()
+{
+    return config_fm_verify_checksum;
+}
+
+sc_bool sc_config_wal()
+{
+    return config_wal;
+}
+
+const sc_char* sc_config_wal_sync()
+{
+    return config_wal_sync;
+}
+
+sc_uint32 sc_config_wal_sync_interval()
+{
+    return config_wal_sync_interval;
+}
+
+sc_bool sc_config_arc_index()
+{
+    return config_arc_index;
+}
+
+sc_uint32 sc_config_adjacency_threshold()
+{
+    return config_adjacency_threshold;
+}
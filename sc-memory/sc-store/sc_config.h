@@ -25,6 +25,27 @@ sc_int32 sc_config_get_max_loaded_segments();
 //! Returns file memory engine
 const sc_char* sc_config_fm_engine();
 
+//! Returns checksum algorithm of sc-links content for new repositories: fast128 or sha256
+const sc_char* sc_config_fm_checksum();
+
+//! Returns SC_TRUE (default), if contents with equal fast checksums should be compared with stored ones to detect collisions
+sc_bool sc_config_fm_verify_checksum();
+
+//! Returns SC_TRUE, if changes of sc-memory should be written into write-ahead log
+sc_bool sc_config_wal();
+
+//! Returns sync policy of write-ahead log: none, interval or commit
+const sc_char* sc_config_wal_sync();
+
+//! Returns period (in milliseconds) of write-ahead log writes
+sc_uint32 sc_config_wal_sync_interval();
+
+//! Returns SC_TRUE, if sc-arcs should be indexed by begin and end elements (see sc_arc_index.h)
+sc_bool sc_config_arc_index();
+
+//! Returns number of walked sc-arcs of element, after that iterator builds adjacency for it (see sc_adjacency.h). 0 - never build
+sc_uint32 sc_config_adjacency_threshold();
+
 
 // --- api for extensions ---
 /*!
@@ -25,7 +25,6 @@
 #define MAX_PATH_LENGTH 1024
 
 #define SC_CONCURRENCY_LEVEL   32   // max number of independent threads that can work in parallel with memory
-#define SC_SEGMENT_CACHE_SIZE  32   // size of segments cache
 
 #if defined (SC_MEMORY_SELF_BUILD)
     #if defined (SC_PLATFORM_WIN)
@@ -17,12 +17,11 @@ void sc_element_set_type(sc_element *element, sc_type type)
     element->flags.type = sc_flags_remove(type);
 }
 
-sc_bool sc_element_is_checksum_empty(sc_element *element)
+sc_bool sc_element_is_checksum_empty(sc_content const *content)
 {
-    g_assert(element->flags.type & sc_type_link);
     sc_uint32 i = 0;
     for (; i < SC_CHECKSUM_LEN; ++i)
-        if (element->content.data[i] != 0)
+        if (content->data[i] != 0)
             return SC_FALSE;
 
     return SC_TRUE;
@@ -38,6 +37,11 @@ sc_bool sc_element_is_valid(sc_element *element)
     return (element->flags.type == 0 || element->flags.type & sc_flag_request_deletion) ? SC_FALSE : SC_TRUE;
 }
 
+sc_bool sc_element_is_reserved(sc_element const *element)
+{
+    return (element->flags.type == sc_flag_reserved) ? SC_TRUE : SC_FALSE;
+}
+
 sc_uint16 sc_element_get_refs(sc_element_meta *element)
 {
     return element->ref_count;
@@ -25,6 +25,7 @@ struct _sc_arc_info
 
 /*! Structure to store content information
  * Data field store checksum for data, that stores in specified sc-link.
+ * Contents are stored apart from sc-elements (see sc_segment_get_content), so just sc-links use memory for them.
  */
 struct _sc_content
 {
@@ -47,6 +48,8 @@ struct _sc_content
  * Each list of arcs contains pointer to array of arcs pointers.
  * Size of each array is fixed and equivalent to ARC_SEG_SIZE value.
  *
+ * Structure contains just data, that is used to walk through arcs, so it doesn't contain content of sc-link.
+ *
  * All arcs have next_arc and prev_arc addr's. Each element store addr of begin and end arcs.
  * Arcs values: next_out_arc and next_in_arc store next arcs in output and input arcs list.
  * So if you need to iterate all output arcs for specified element, then you need to use such code:
@@ -82,10 +85,15 @@ struct _sc_element_meta
         sc_element_locks locks; // bits access
         sc_uint8 locks_data; // one byte
     };
+    sc_uint8 adjacency; // 1, if sc-element has secondary adjacency (see sc_adjacency.h). Changed under lock of sc-element
     union
     {
         sc_uint32 ref_count;
     };
+    sc_uint32 events_mask; // bit per sc-event type, that has subscribed sc-events. Use atomic access
+    sc_uint32 out_degree; // number of output sc-arcs. Changed under lock of sc-element, read without lock as estimate
+    sc_uint32 in_degree; // number of input sc-arcs. Changed under lock of sc-element, read without lock as estimate
+    sc_uint32 degree_counted; // 1, if degrees are counted by lists of sc-arcs (see sc_storage_get_element_degree). Use atomic access
 };
 
 struct _sc_element
@@ -94,20 +102,18 @@ struct _sc_element
 
     sc_addr first_out_arc;
     sc_addr first_in_arc;
-    union
-    {
-        sc_content content;
-        sc_arc_info arc;
-    };
+    sc_arc_info arc;
 };
 
 /// All functions must be called for locked sc-elements
 void sc_element_set_type(sc_element *element, sc_type type);
 
-sc_bool sc_element_is_checksum_empty(sc_element *element);
+sc_bool sc_element_is_checksum_empty(sc_content const *content);
 
 sc_bool sc_element_is_request_deletion(sc_element *element);
 sc_bool sc_element_is_valid(sc_element *element);
+//! Returns SC_TRUE, if slot of \p element is reserved for new sc-element (see sc_storage_elements_new)
+sc_bool sc_element_is_reserved(sc_element const *element);
 
 sc_uint16 sc_element_get_refs(sc_element_meta *element);
 sc_bool sc_element_ref(sc_element_meta *element);
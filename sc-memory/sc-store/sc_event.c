@@ -11,45 +11,66 @@
 #include "sc_event/sc_event_queue.h"
 #include "../sc_memory_private.h"
 
-GMutex events_table_mutex;
-#define EVENTS_TABLE_LOCK g_mutex_lock(&events_table_mutex);
-#define EVENTS_TABLE_UNLOCK g_mutex_unlock(&events_table_mutex);
+/*! Subscriptions are split into shards by listened sc-element, so subscribe/unsubscribe for
+ * different sc-elements don't block each other and emitters just take a shared lock. Each listened
+ * sc-element has a bit per subscribed sc-event type in its meta (see sc_storage_get_element_events_mask),
+ * so emitting of event, that has no subscribers, doesn't touch the index at all. Bits are changed by atomic
+ * or/and under shard lock after the index is updated and are read atomically, so cleared bit means, that
+ * there was no subscription, when it was read.
+ */
+typedef struct _sc_events_shard
+{
+    GRWLock lock;
+    GHashTable *table;      // map of packed sc-addr to sc_element_events
+} sc_events_shard;
 
+//! Subscriptions of one sc-element grouped by sc-event type
+typedef struct _sc_element_events
+{
+    GSList *events[SC_EVENT_TYPES_COUNT];
+} sc_element_events;
 
-// Pointer to hash table that contains events
-GHashTable *events_table = 0;
+sc_events_shard events_shards[SC_CONCURRENCY_LEVEL];
 sc_event_queue *event_queue = 0;
+fElementDeletedHook element_deleted_hook = 0;
+fLinkContentChangedHook link_content_changed_hook = 0;
+fArcCreatedHook arc_created_hook = 0;
+//! Guards running delete callbacks of detached events, so sc_event_destroy can wait for them
+GMutex events_delete_mutex;
+GCond events_delete_cond;
 
-guint events_table_hash_func(gconstpointer pointer)
-{
-    const sc_addr *addr = (const sc_addr*)pointer;
-    return SC_ADDR_LOCAL_TO_INT(*addr);
-}
+#define EVENTS_SHARD(el) (&events_shards[(SC_ADDR_LOCAL_TO_INT(el) * 2654435761u) % SC_CONCURRENCY_LEVEL])
 
-gboolean events_table_equal_func(gconstpointer a, gconstpointer b)
+sc_bool _sc_event_type_is_valid(sc_event_type type)
 {
-    const sc_addr *addr1 = (const sc_addr*)a;
-    const sc_addr *addr2 = (const sc_addr*)b;
-    return SC_ADDR_IS_EQUAL(*addr1, *addr2);
+    return (type >= 0 && type < SC_EVENT_TYPES_COUNT) ? SC_TRUE : SC_FALSE;
 }
 
 //! Inserts specified event into events table
 sc_result insert_event_into_table(sc_event *event)
 {
-    GSList *element_events_list = 0;
+    sc_events_shard *shard = EVENTS_SHARD(event->element);
+    gpointer key = GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(event->element));
+    sc_element_events *el_events = 0;
 
-    EVENTS_TABLE_LOCK
+    g_rw_lock_writer_lock(&shard->lock);
 
     // first of all, if table doesn't exist, then create it
-    if (events_table == null_ptr)
-        events_table = g_hash_table_new(events_table_hash_func, events_table_equal_func);
+    if (shard->table == null_ptr)
+        shard->table = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     // if there are no events for specified sc-element, then create new events list
-    element_events_list = (GSList*)g_hash_table_lookup(events_table, (gconstpointer)&event->element);
-    element_events_list = g_slist_append(element_events_list, (gpointer)event);
-    g_hash_table_insert(events_table, (gpointer)&event->element, (gpointer)element_events_list);
+    el_events = (sc_element_events*)g_hash_table_lookup(shard->table, key);
+    if (el_events == null_ptr)
+    {
+        el_events = g_new0(sc_element_events, 1);
+        g_hash_table_insert(shard->table, key, (gpointer)el_events);
+    }
+
+    el_events->events[event->type] = g_slist_append(el_events->events[event->type], (gpointer)event);
+    sc_storage_add_element_events_mask(event->element, SC_EVENT_TYPE_BIT(event->type));
 
-    EVENTS_TABLE_UNLOCK
+    g_rw_lock_writer_unlock(&shard->lock);
 
     return SC_RESULT_OK;
 }
@@ -57,41 +78,54 @@ sc_result insert_event_into_table(sc_event *event)
 //! Remove specified sc-event from events table
 sc_result remove_event_from_table(sc_event *event)
 {
-    GSList *element_events_list = 0;
-    g_assert(events_table != null_ptr);
+    sc_events_shard *shard = EVENTS_SHARD(event->element);
+    gpointer key = GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(event->element));
+    sc_element_events *el_events = 0;
+    sc_result result = SC_RESULT_OK;
+    sc_uint32 i;
+
+    g_rw_lock_writer_lock(&shard->lock);
 
-    EVENTS_TABLE_LOCK
+    // event was already removed from table, when listened sc-element deleted
+    if (event->detached == SC_TRUE)
+        goto unlock;
 
-    element_events_list = (GSList*)g_hash_table_lookup(events_table, (gconstpointer)&event->element);
-    if (element_events_list == null_ptr)
+    el_events = shard->table ? (sc_element_events*)g_hash_table_lookup(shard->table, key) : null_ptr;
+    if (el_events == null_ptr || g_slist_find(el_events->events[event->type], (gconstpointer)event) == null_ptr)
     {
-        EVENTS_TABLE_UNLOCK
-        return SC_RESULT_ERROR_INVALID_PARAMS;
+        result = SC_RESULT_ERROR_INVALID_PARAMS;
+        goto unlock;
     }
 
     // remove event from list of events for specified sc-element
-    element_events_list = g_slist_remove(element_events_list, (gconstpointer)event);
-    if (element_events_list == null_ptr)
-        g_hash_table_remove(events_table, (gconstpointer)&event->element);
-    else
-        g_hash_table_insert(events_table, (gpointer)&event->element, (gpointer)element_events_list);
-
-    // if there are no more events in table, then delete it
-    if (g_hash_table_size(events_table) == 0)
+    el_events->events[event->type] = g_slist_remove(el_events->events[event->type], (gconstpointer)event);
+    if (el_events->events[event->type] == null_ptr)
+        sc_storage_remove_element_events_mask(event->element, SC_EVENT_TYPE_BIT(event->type));
+
+    for (i = 0; i < SC_EVENT_TYPES_COUNT; ++i)
     {
-        g_hash_table_destroy(events_table);
-        events_table = null_ptr;
+        if (el_events->events[i] != null_ptr)
+            goto unlock;
     }
 
-    EVENTS_TABLE_UNLOCK
+    // there are no more events for sc-element
+    g_hash_table_remove(shard->table, key);
+    g_free(el_events);
 
-    return SC_RESULT_OK;
+    unlock:
+    {
+        g_rw_lock_writer_unlock(&shard->lock);
+    }
+
+    return result;
 }
 
 sc_event* sc_event_new(sc_memory_context const * ctx, sc_addr el, sc_event_type type, sc_pointer data, fEventCallback callback, fDeleteCallback delete_callback)
 {
     sc_access_levels levels;
     sc_event *event = null_ptr;
+    if (_sc_event_type_is_valid(type) == SC_FALSE)
+        return 0;
     if (sc_storage_get_access_levels(ctx, el, &levels) != SC_RESULT_OK || !sc_access_lvl_check_read(ctx->access_levels, levels))
         return 0;
 
@@ -122,38 +156,123 @@ sc_result sc_event_destroy(sc_event *event)
 
     sc_event_queue_remove(event_queue, event);
 
+    // listened sc-element deleted, so delete callback can run concurrently
+    g_mutex_lock(&events_delete_mutex);
+    if (event->detached == SC_TRUE)
+    {
+        // event is already destroyed by another call
+        if (event->destroyed == SC_TRUE)
+        {
+            g_mutex_unlock(&events_delete_mutex);
+            return SC_RESULT_ERROR;
+        }
+        event->destroyed = SC_TRUE;
+
+        // event can be destroyed from it own delete callback, so it will be freed after callback returns
+        if (event->delete_thread == g_thread_self())
+        {
+            event->destroy_deferred = SC_TRUE;
+            g_mutex_unlock(&events_delete_mutex);
+            return SC_RESULT_OK;
+        }
+
+        while (event->delete_thread != null_ptr)
+            g_cond_wait(&events_delete_cond, &events_delete_mutex);
+    }
+    g_mutex_unlock(&events_delete_mutex);
+
     g_free(event);
 
     return SC_RESULT_OK;
 }
 
+void sc_event_set_element_deleted_hook(fElementDeletedHook hook)
+{
+    element_deleted_hook = hook;
+}
+
+void sc_event_set_link_content_changed_hook(fLinkContentChangedHook hook)
+{
+    link_content_changed_hook = hook;
+}
+
+void sc_event_notify_link_content_changed(sc_addr link, const sc_stream *stream)
+{
+    if (link_content_changed_hook != null_ptr)
+        link_content_changed_hook(link, stream);
+}
+
+void sc_event_set_arc_created_hook(fArcCreatedHook hook)
+{
+    arc_created_hook = hook;
+}
+
+void sc_event_notify_arc_created(sc_addr arc, sc_addr beg, sc_addr end)
+{
+    if (arc_created_hook != null_ptr)
+        arc_created_hook(arc, beg, end);
+}
+
 sc_result sc_event_notify_element_deleted(sc_addr element)
 {
+    sc_events_shard *shard = EVENTS_SHARD(element);
+    gpointer key = GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(element));
+    sc_element_events *el_events = 0;
     GSList *element_events_list = 0;
+    GSList *it = 0;
     sc_event *event = 0;
+    sc_uint32 i;
 
     sc_event_queue_remove_element(event_queue, element);
 
-    EVENTS_TABLE_LOCK
-    // do nothing, if there are no registered events
-    if (events_table == null_ptr)
-        goto result;
+    if (element_deleted_hook != null_ptr)
+        element_deleted_hook(element);
 
-    // lookup for all registered to specified sc-elemen events
-    element_events_list = (GSList*)g_hash_table_lookup(events_table, (gconstpointer)&element);
+    if (sc_storage_get_element_events_mask(element) == 0)
+        return SC_RESULT_OK;
+
+    // take all subscriptions of sc-element, so delete callbacks can destroy events without index lock
+    g_rw_lock_writer_lock(&shard->lock);
+    el_events = shard->table ? (sc_element_events*)g_hash_table_lookup(shard->table, key) : null_ptr;
+    if (el_events != null_ptr)
+    {
+        g_hash_table_remove(shard->table, key);
+        for (i = 0; i < SC_EVENT_TYPES_COUNT; ++i)
+            element_events_list = g_slist_concat(element_events_list, el_events->events[i]);
+        g_free(el_events);
+    }
+
+    g_mutex_lock(&events_delete_mutex);
+    for (it = element_events_list; it != null_ptr; it = it->next)
+    {
+        event = (sc_event*)it->data;
+        event->detached = SC_TRUE;
+        event->delete_thread = g_thread_self();
+    }
+    g_mutex_unlock(&events_delete_mutex);
+
+    sc_storage_remove_element_events_mask(element, ~(sc_uint32)0);
+    g_rw_lock_writer_unlock(&shard->lock);
 
     // destroy events
     while (element_events_list != null_ptr)
     {
+        sc_bool deferred = SC_FALSE;
         event = (sc_event*)element_events_list->data;
         if (event->delete_callback != null_ptr)
             event->delete_callback(event);
-        element_events_list = g_slist_delete_link(element_events_list, element_events_list);
-    }
 
-    result:
-    {
-        EVENTS_TABLE_UNLOCK;
+        // wake up sc_event_destroy calls, that wait for delete callback
+        g_mutex_lock(&events_delete_mutex);
+        event->delete_thread = null_ptr;
+        deferred = event->destroy_deferred;
+        g_cond_broadcast(&events_delete_cond);
+        g_mutex_unlock(&events_delete_mutex);
+
+        if (deferred == SC_TRUE)
+            g_free(event);
+
+        element_events_list = g_slist_delete_link(element_events_list, element_events_list);
     }
 
     return SC_RESULT_OK;
@@ -161,22 +280,32 @@ sc_result sc_event_notify_element_deleted(sc_addr element)
 
 sc_result sc_event_emit(sc_addr el, sc_access_levels el_access, sc_event_type type, sc_addr arg)
 {
+    sc_events_shard *shard = 0;
+    sc_element_events *el_events = 0;
     GSList *element_events_list = 0;
     sc_event *event = 0;
 
-    EVENTS_TABLE_LOCK;
+    // there are no subscriptions of this type, so do nothing without locking
+    if (_sc_event_type_is_valid(type) == SC_FALSE || (sc_storage_get_element_events_mask(el) & SC_EVENT_TYPE_BIT(type)) == 0)
+        return SC_RESULT_OK;
 
-    // if table is empty, then do nothing
-    if (events_table == null_ptr)
+    shard = EVENTS_SHARD(el);
+    g_rw_lock_reader_lock(&shard->lock);
+
+    if (shard->table == null_ptr)
         goto result;
 
     // lookup for all registered to specified sc-elemen events
-    element_events_list = (GSList*)g_hash_table_lookup(events_table, (gconstpointer)&el);
+    el_events = (sc_element_events*)g_hash_table_lookup(shard->table, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el)));
+    if (el_events == null_ptr)
+        goto result;
+
+    element_events_list = el_events->events[type];
     while (element_events_list != null_ptr)
     {
         event = (sc_event*)element_events_list->data;
 
-        if (event->type == type && sc_access_lvl_check_read(event->ctx->access_levels, el_access))
+        if (sc_access_lvl_check_read(event->ctx->access_levels, el_access))
         {
             g_assert(event->callback != null_ptr);
             sc_event_queue_append(event_queue, event, arg);
@@ -187,7 +316,7 @@ sc_result sc_event_emit(sc_addr el, sc_access_levels el_access, sc_event_type ty
 
     result:
     {
-        EVENTS_TABLE_UNLOCK;
+        g_rw_lock_reader_unlock(&shard->lock);
     }
 
     return SC_RESULT_OK;
@@ -212,9 +341,28 @@ sc_addr sc_event_get_element(const sc_event *event)
 }
 
 // --------
+void _sc_element_events_free(gpointer key, gpointer value, gpointer user_data)
+{
+    sc_element_events *el_events = (sc_element_events*)value;
+    sc_uint32 i;
+
+    // events itself are owned by subscribers
+    for (i = 0; i < SC_EVENT_TYPES_COUNT; ++i)
+        g_slist_free(el_events->events[i]);
+    g_free(el_events);
+}
+
 sc_bool sc_events_initialize()
 {
-    //g_mutex_init(&events_table_mutex);
+    sc_uint32 i;
+    for (i = 0; i < SC_CONCURRENCY_LEVEL; ++i)
+    {
+        g_rw_lock_init(&events_shards[i].lock);
+        events_shards[i].table = null_ptr;
+    }
+    g_mutex_init(&events_delete_mutex);
+    g_cond_init(&events_delete_cond);
+
     event_queue = sc_event_queue_new();
 
     return SC_TRUE;
@@ -222,9 +370,22 @@ sc_bool sc_events_initialize()
 
 void sc_events_shutdown()
 {
+    sc_uint32 i;
     sc_event_queue_destroy_wait(event_queue);
-    //g_mutex_clear(&events_table_mutex);
     event_queue = 0;
+
+    for (i = 0; i < SC_CONCURRENCY_LEVEL; ++i)
+    {
+        if (events_shards[i].table != null_ptr)
+        {
+            g_hash_table_foreach(events_shards[i].table, _sc_element_events_free, null_ptr);
+            g_hash_table_destroy(events_shards[i].table);
+            events_shards[i].table = null_ptr;
+        }
+        g_rw_lock_clear(&events_shards[i].lock);
+    }
+    g_mutex_clear(&events_delete_mutex);
+    g_cond_clear(&events_delete_cond);
 }
 
 void sc_events_stop_processing()
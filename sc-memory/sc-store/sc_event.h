@@ -34,6 +34,8 @@ _SC_EXTERN sc_event* sc_event_new(sc_memory_context const * ctx, sc_addr el, sc_
 /*! Destroys specified sc-event
  * @param event Poitner to sc-event, that need to be destroyed
  * @return If event destoyed correctly, then return SC_OK; otherwise return SC_ERROR code.
+ * @remarks If listened sc-element is deleting, then waits until delete callback of event returns.
+ * Event can be destroyed from its own delete callback.
  */
 _SC_EXTERN sc_result sc_event_destroy(sc_event *event);
 
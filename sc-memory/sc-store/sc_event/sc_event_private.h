@@ -8,7 +8,13 @@
 #define _sc_event_private_h_
 
 #include "sc_types.h"
+#include "sc_stream.h"
+#include <glib.h>
 
+//! Number of sc-event types, that can be subscribed
+#define SC_EVENT_TYPES_COUNT    (SC_EVENT_CONTENT_CHANGED + 1)
+//! Bit of sc-event type in sc-element events mask
+#define SC_EVENT_TYPE_BIT(t)    (1 << (t))
 
 /*! Structure that contains information about event
  */
@@ -28,6 +34,14 @@ struct _sc_event
     fDeleteCallback delete_callback;
     //! Reference count (just references from queue)
     sc_uint32 ref_count;
+    //! Flag, that event removed from subscriptions, because listened sc-element deleted
+    sc_bool detached;
+    //! Thread, that runs delete callback of detached event. Access under delete mutex
+    GThread *delete_thread;
+    //! Flag, that sc_event_destroy was called for detached event. Access under delete mutex
+    sc_bool destroyed;
+    //! Flag, that event destroyed from its own delete callback, so it's freed after callback returns
+    sc_bool destroy_deferred;
 };
 
 
@@ -40,6 +54,44 @@ void sc_events_shutdown();
 //! Waits while all emited events will be processed, then returns. After calling that function all new emited events will be ignored
 void sc_events_stop_processing();
 
+//! Function, that is called for each deleted sc-element (see sc_event_set_element_deleted_hook)
+typedef void (*fElementDeletedHook)(sc_addr element);
+
+/*! Sets function, that is called by sc_event_notify_element_deleted. It's used by indices, that
+ * are built over sc-memory and must forget deleted sc-elements.
+ * @param hook Pointer to hook function. Pass null_ptr to remove hook
+ * @remarks Hook is called while storage locks of deleted sc-element are held, so it must not
+ * access sc-memory
+ */
+void sc_event_set_element_deleted_hook(fElementDeletedHook hook);
+
+//! Function, that is called for each change of sc-link content (see sc_event_set_link_content_changed_hook)
+typedef void (*fLinkContentChangedHook)(sc_addr link, const sc_stream *stream);
+
+/*! Sets function, that is called by sc_event_notify_link_content_changed. It has the same restrictions
+ * as deletion hook, and it's used by indices over contents of sc-links.
+ * @param hook Pointer to hook function. Pass null_ptr to remove hook
+ * @remarks New content is passed in stream, so hook reads it from the beginning
+ */
+void sc_event_set_link_content_changed_hook(fLinkContentChangedHook hook);
+
+//! Notificate about change of sc-link content to data of \p stream. It's called while sc-link is locked
+void sc_event_notify_link_content_changed(sc_addr link, const sc_stream *stream);
+
+//! Function, that is called for each created sc-arc (see sc_event_set_arc_created_hook)
+typedef void (*fArcCreatedHook)(sc_addr arc, sc_addr beg, sc_addr end);
+
+/*! Sets function, that is called by sc_event_notify_arc_created. It's used by indices, that
+ * are built over constructions of sc-memory and must know new ones.
+ * @param hook Pointer to hook function. Pass null_ptr to remove hook
+ * @remarks Hook is called after storage locks of created sc-arc are released, so it can access
+ * sc-memory. It's called for each sc-arc, so it should skip unrelated ones without locking
+ */
+void sc_event_set_arc_created_hook(fArcCreatedHook hook);
+
+//! Notificate about creation of sc-arc \p arc from \p beg to \p end. It's called without storage locks
+void sc_event_notify_arc_created(sc_addr arc, sc_addr beg, sc_addr end);
+
 /*! Notificate about sc-element deletion.
  * @param element sc-addr of deleted sc-element
  * @remarks This function call deletion callback function for event.
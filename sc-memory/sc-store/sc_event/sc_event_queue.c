@@ -10,75 +10,90 @@
 #include "sc_storage.h"
 #include "../sc_memory_private.h"
 
-struct _sc_event_pool_worker_data
-{
-    sc_event * evt;
-    sc_addr arg;
-};
-
+//! Process all items of strand. Runs in thread pool worker
 void sc_event_pool_worker(gpointer data, gpointer user_data)
 {
-}
+    sc_event_queue_strand *strand = (sc_event_queue_strand*)data;
+    sc_event_queue *queue = (sc_event_queue*)user_data;
 
-gpointer sc_event_queue_thread_loop(gpointer data)
-{
-    sc_event_queue *queue = (sc_event_queue*)data;
+    g_mutex_lock(&queue->mutex);
+    strand->thread = g_thread_self();
 
-    g_rec_mutex_lock(&queue->mutex);
-    queue->running = SC_TRUE;
-    g_rec_mutex_unlock(&queue->mutex);
+    while (g_queue_is_empty(&strand->items) == FALSE)
+    {
+        sc_event_queue_item *item = (sc_event_queue_item*)g_queue_pop_head(&strand->items);
+        sc_event *event = item->event;
+        sc_addr arg = item->arg;
+        g_free(item);
 
-    sc_bool running = SC_TRUE;
-    sc_event *event = 0;
-    sc_addr arg;
+        // if pointer to event is null, then event removed, we need to skip it
+        if (event == null_ptr)
+            continue;
 
-    while (running == SC_TRUE || g_queue_get_length(queue->queue) > 0)
+        strand->event_process = event;
+        g_mutex_unlock(&queue->mutex);
+
+        g_assert(event->callback != null_ptr);
+        event->callback(event, arg);
+
+        g_mutex_lock(&queue->mutex);
+        strand->event_process = null_ptr;
+        g_cond_broadcast(&queue->proc_cond);
+    }
+
+    // there are no more items for this element, so next emitted item will start new strand
+    g_hash_table_remove(queue->strands, GSIZE_TO_POINTER(strand->element));
+    g_mutex_unlock(&queue->mutex);
+
+    g_free(strand);
+}
+
+//! Moves \p item into strand of listened sc-element. Queue mutex must be locked
+void _sc_event_queue_dispatch(sc_event_queue *queue, sc_event_queue_item *item)
+{
+    if (item->event == null_ptr)
     {
-        g_rec_mutex_lock(&queue->mutex);
-        running = queue->running;
-        sc_event_queue_item *item = null_ptr;
-        if (queue->queue != null_ptr)
-            item = (sc_event_queue_item*)g_queue_pop_head(queue->queue);
-        g_rec_mutex_unlock(&queue->mutex);
+        g_free(item);
+        return;
+    }
 
-        event = 0;
+    sc_addr_hash element = SC_ADDR_LOCAL_TO_INT(item->event->element);
+    sc_event_queue_strand *strand = (sc_event_queue_strand*)g_hash_table_lookup(queue->strands, GSIZE_TO_POINTER(element));
+    if (strand != null_ptr)
+    {
+        // strand is already processing, so worker will take item after previous ones
+        g_queue_push_tail(&strand->items, (gpointer)item);
+        return;
+    }
 
-        // find first not null event in queue
-        while (item != 0)
-        {
-            // if pointer to event is null, then event removed, we need to skip it
-            if (item->event)
-            {
-                event = item->event;
-                arg = item->arg;
-
-                sc_access_levels arg_access;
-                if (sc_storage_get_access_levels(s_memory_default_ctx, arg, &arg_access) != SC_RESULT_OK)
-                    arg_access = sc_access_lvl_make_max;
-
-                g_free(item);
-                break;
-            }
-            else
-            {
-                g_free(item);
-                g_rec_mutex_lock(&queue->mutex);
-                item = (sc_event_queue_item*)g_queue_pop_head(queue->queue);
-                g_rec_mutex_unlock(&queue->mutex);
-            }
-        }
+    strand = g_new0(sc_event_queue_strand, 1);
+    strand->element = element;
+    g_queue_init(&strand->items);
+    g_queue_push_tail(&strand->items, (gpointer)item);
 
-        g_rec_mutex_lock(&queue->proc_mutex);
-        queue->event_process = event;
+    g_hash_table_insert(queue->strands, GSIZE_TO_POINTER(element), (gpointer)strand);
+    g_thread_pool_push(queue->thread_pool, (gpointer)strand, 0);
+}
 
-        if (queue->event_process)
-            queue->event_process->callback(queue->event_process, arg);
+gpointer sc_event_queue_thread_loop(gpointer data)
+{
+    sc_event_queue *queue = (sc_event_queue*)data;
 
-        queue->event_process = 0;
-        g_rec_mutex_unlock(&queue->proc_mutex);
+    g_mutex_lock(&queue->mutex);
+    while (queue->running == SC_TRUE || g_queue_is_empty(queue->queue) == FALSE)
+    {
+        if (g_queue_is_empty(queue->queue) == TRUE)
+        {
+            g_cond_wait(&queue->cond, &queue->mutex);
+            continue;
+        }
 
-        g_usleep(1000); // sleep for an one millisecond
+        // drain all appended items at once
+        sc_event_queue_item *item = 0;
+        while ((item = (sc_event_queue_item*)g_queue_pop_head(queue->queue)) != null_ptr)
+            _sc_event_queue_dispatch(queue, item);
     }
+    g_mutex_unlock(&queue->mutex);
 
     return 0;
 }
@@ -86,12 +101,14 @@ gpointer sc_event_queue_thread_loop(gpointer data)
 sc_event_queue* sc_event_queue_new()
 {
     sc_event_queue *queue = g_new0(sc_event_queue, 1);
-    queue->running = SC_FALSE;
-    g_rec_mutex_init(&queue->mutex);
-    g_rec_mutex_init(&queue->proc_mutex);
-    queue->thread = g_thread_new("sc_event_queue thread", sc_event_queue_thread_loop, (gpointer)queue);
+    g_mutex_init(&queue->mutex);
+    g_cond_init(&queue->cond);
+    g_cond_init(&queue->proc_cond);
     queue->queue = g_queue_new();
-    queue->thread_pool = g_thread_pool_new(sc_event_pool_worker, (gpointer)0, 2 * SC_CONCURRENCY_LEVEL, FALSE, 0);
+    queue->strands = g_hash_table_new(g_direct_hash, g_direct_equal);
+    queue->thread_pool = g_thread_pool_new(sc_event_pool_worker, (gpointer)queue, 2 * SC_CONCURRENCY_LEVEL, FALSE, 0);
+    queue->running = SC_TRUE;
+    queue->thread = g_thread_new("sc_event_queue thread", sc_event_queue_thread_loop, (gpointer)queue);
 
     return queue;
 }
@@ -101,46 +118,55 @@ void sc_event_queue_destroy_wait(sc_event_queue *queue)
 {
     g_assert(queue != 0);
 
-    sc_bool is_running = SC_FALSE;
+    g_mutex_lock(&queue->mutex);
+    queue->running = SC_FALSE;
+    GThread *thread = queue->thread;
+    queue->thread = 0;
+    g_cond_signal(&queue->cond);
+    g_mutex_unlock(&queue->mutex);
 
-    g_rec_mutex_lock(&queue->mutex);
-    is_running = queue->running;
-    g_rec_mutex_unlock(&queue->mutex);
+    // dispatcher exits when all appended items are moved into strands
+    if (thread)
+        g_thread_join(thread);
 
-    if (is_running)
+    // wait until workers process all strands
+    if (queue->thread_pool)
     {
-        g_rec_mutex_lock(&queue->mutex);
-        queue->running = SC_FALSE;
-        GThread *thread = queue->thread;
-        queue->thread = 0;
-        g_rec_mutex_unlock(&queue->mutex);
-
-        g_thread_join(thread);
+        g_thread_pool_free(queue->thread_pool, FALSE, TRUE);
+        queue->thread_pool = 0;
     }
 
+    g_mutex_lock(&queue->mutex);
     if (queue->queue)
     {
         g_queue_free(queue->queue);
         queue->queue = 0;
     }
-    if (queue->thread_pool)
+    if (queue->strands)
     {
-        g_thread_pool_free(queue->thread_pool, TRUE, TRUE);
-        queue->thread_pool = 0;
+        g_assert(g_hash_table_size(queue->strands) == 0);
+        g_hash_table_destroy(queue->strands);
+        queue->strands = 0;
     }
+    g_mutex_unlock(&queue->mutex);
 }
 
 void sc_event_queue_append(sc_event_queue *queue, sc_event *event, sc_addr arg)
 {
     g_assert(queue != 0);
-    g_rec_mutex_lock(&queue->mutex);
+    g_mutex_lock(&queue->mutex);
 
-    sc_event_queue_item *item = g_new0(sc_event_queue_item, 1);
-    item->arg = arg;
-    item->event = event;
-    g_queue_push_tail(queue->queue, (gpointer)item);
+    // ignore events emitted after processing stopped
+    if (queue->running == SC_TRUE)
+    {
+        sc_event_queue_item *item = g_new0(sc_event_queue_item, 1);
+        item->arg = arg;
+        item->event = event;
+        g_queue_push_tail(queue->queue, (gpointer)item);
+        g_cond_signal(&queue->cond);
+    }
 
-    g_rec_mutex_unlock(&queue->mutex);
+    g_mutex_unlock(&queue->mutex);
 }
 
 void _sc_event_queue_item_remove(gpointer _item, gpointer _event)
@@ -156,7 +182,7 @@ void _sc_event_queue_item_remove_by_addr(gpointer _item, gpointer _addr)
 {
     sc_event_queue_item *item = (sc_event_queue_item*)_item;
 
-    if ((SC_ADDR_LOCAL_TO_INT(item->arg) == GPOINTER_TO_UINT(_addr)))
+    if (item->event != null_ptr && (SC_ADDR_LOCAL_TO_INT(item->arg) == GPOINTER_TO_SIZE(_addr)))
     {
         sc_event_type t = sc_event_get_type(item->event);
         if (t != SC_EVENT_REMOVE_ELEMENT && t != SC_EVENT_REMOVE_INPUT_ARC && t != SC_EVENT_REMOVE_OUTPUT_ARC)
@@ -164,31 +190,65 @@ void _sc_event_queue_item_remove_by_addr(gpointer _item, gpointer _addr)
     }
 }
 
+//! Returns SC_TRUE, if \p event is processing by any worker except current thread. Queue mutex must be locked
+sc_bool _sc_event_queue_is_processing(sc_event_queue *queue, sc_event *event)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init(&iter, queue->strands);
+    while (g_hash_table_iter_next(&iter, &key, &value) == TRUE)
+    {
+        sc_event_queue_strand *strand = (sc_event_queue_strand*)value;
+        if (strand->event_process == event && strand->thread != g_thread_self())
+            return SC_TRUE;
+    }
+
+    return SC_FALSE;
+}
+
 void sc_event_queue_remove(sc_event_queue *queue, sc_event *event)
 {
     g_assert(queue != 0);
-    g_rec_mutex_lock(&queue->mutex);
-
-    g_rec_mutex_lock(&queue->proc_mutex);
-    if (queue->event_process == event)
-        queue->event_process = 0;
-    g_rec_mutex_unlock(&queue->proc_mutex);
+    g_mutex_lock(&queue->mutex);
 
     if (queue->queue)
-    {
         g_queue_foreach(queue->queue, _sc_event_queue_item_remove, (gpointer)event);
-    }
 
-    g_rec_mutex_unlock(&queue->mutex);
+    if (queue->strands)
+    {
+        GHashTableIter iter;
+        gpointer key, value;
+
+        g_hash_table_iter_init(&iter, queue->strands);
+        while (g_hash_table_iter_next(&iter, &key, &value) == TRUE)
+            g_queue_foreach(&((sc_event_queue_strand*)value)->items, _sc_event_queue_item_remove, (gpointer)event);
 
+        // event can be destroyed from it own callback, so wait just for other threads
+        while (_sc_event_queue_is_processing(queue, event) == SC_TRUE)
+            g_cond_wait(&queue->proc_cond, &queue->mutex);
+    }
+
+    g_mutex_unlock(&queue->mutex);
 }
 
 void sc_event_queue_remove_element(sc_event_queue *queue, sc_addr addr)
 {
     g_assert(queue != 0);
-    g_rec_mutex_lock(&queue->mutex);
+    g_mutex_lock(&queue->mutex);
+
+    if (queue->queue)
+        g_queue_foreach(queue->queue, _sc_event_queue_item_remove_by_addr, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr)));
 
-    g_queue_foreach(queue->queue, _sc_event_queue_item_remove_by_addr, (gpointer)SC_ADDR_LOCAL_TO_INT(addr));
+    if (queue->strands)
+    {
+        GHashTableIter iter;
+        gpointer key, value;
+
+        g_hash_table_iter_init(&iter, queue->strands);
+        while (g_hash_table_iter_next(&iter, &key, &value) == TRUE)
+            g_queue_foreach(&((sc_event_queue_strand*)value)->items, _sc_event_queue_item_remove_by_addr, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr)));
+    }
 
-    g_rec_mutex_unlock(&queue->mutex);
+    g_mutex_unlock(&queue->mutex);
 }
@@ -10,14 +10,20 @@
 #include "sc_types.h"
 #include <glib.h>
 
+/*! Events are dispatched in two stages. Emitters append items into \b queue and signal \b cond.
+ * Dispatcher thread drains the whole queue at once and distributes items into strands (one strand
+ * per listened sc-element). Each strand with pending items is processed by one worker of \b thread_pool,
+ * so callbacks for different sc-elements run in parallel, while callbacks for one sc-element keep emit order.
+ */
 struct _sc_event_queue
 {
-    GQueue *queue;
-    GThread *thread;
-    GRecMutex mutex;
-    sc_bool running;    // flag that determine if queue is running
-    sc_event *event_process;    // currently processing event
-    GRecMutex proc_mutex;   // mutex to lock event for process
+    GQueue *queue;              // items, that wait for dispatching
+    GThread *thread;            // dispatcher thread
+    GMutex mutex;               // mutex to lock queue, strands and processing state
+    GCond cond;                 // signals dispatcher, that there are new items or queue stopped
+    GCond proc_cond;            // signals, that some strand finished processing of an item
+    sc_bool running;            // flag that determine if queue is running
+    GHashTable *strands;        // map of listened sc-element to sc_event_queue_strand, that is in processing
     GThreadPool *thread_pool;	// thread pool that used for a workers
 };
 
@@ -28,8 +34,18 @@ struct _sc_event_queue_item
     sc_addr arg;
 };
 
+//! Items of one listened sc-element, that processed sequentially by one worker
+struct _sc_event_queue_strand
+{
+    sc_addr_hash element;       // packed sc-addr of listened sc-element
+    GQueue items;               // items, that wait for processing
+    sc_event *event_process;    // currently processing event
+    GThread *thread;            // worker thread, that process strand
+};
+
 typedef struct _sc_event_queue sc_event_queue;
 typedef struct _sc_event_queue_item sc_event_queue_item;
+typedef struct _sc_event_queue_strand sc_event_queue_strand;
 
 //! Create new sc-event queue
 sc_event_queue* sc_event_queue_new();
@@ -41,7 +57,7 @@ void sc_event_queue_destroy_wait(sc_event_queue *queue);
 void sc_event_queue_append(sc_event_queue *queue, sc_event *event, sc_addr arg);
 
 /*! Removes event from queue. This function removes all events from queue that
- * equal to \p event
+ * equal to \p event. If \p event is processing by other thread, then function waits until it finished.
  */
 void sc_event_queue_remove(sc_event_queue *queue, sc_event *event);
 
@@ -6,9 +6,11 @@
 
 #include "sc_fs_storage.h"
 #include "sc_segment.h"
+#include "sc_storage.h"
 #include "sc_stream_file.h"
 #include "sc_config.h"
 #include "sc_fm_engine.h"
+#include "sc_link_helpers.h"
 
 #include "../sc_memory_version.h"
 
@@ -18,16 +20,27 @@
 #include <gmodule.h>
 #include <glib/gstdio.h>
 
+#ifndef WIN32
+# include <unistd.h>
+#endif
+
 #define BuffSize 256 * 1024
 
 gchar *repo_path = 0;
 gchar segments_path[MAX_PATH_LENGTH]; // Path to file, where stored segments in correct state
+gchar journal_path[MAX_PATH_LENGTH];  // Path to journal of segments, that are written in place
 sc_fm_engine *fm_engine = 0;
 #define SC_DIR_PERMISSIONS -1
 
 const gchar *seg_meta = "_meta";
+const gchar *checksum_file_name = "content_checksum";
 const gchar *addr_key_group = "addrs";
 
+GMappedFile *segments_map = null_ptr;   // mapped segments file, segments use it memory for elements
+GThread *check_thread = null_ptr;       // thread, that checks checksums of mapped segments
+sc_int32 check_thread_stop = 0;
+sc_uint32 check_segments_num = 0;       // number of mapped segments, that are checked by thread
+
 GModule *fm_engine_module = 0;
 gchar fm_engine_module_path[MAX_PATH_LENGTH + 1];
 typedef sc_fm_engine* (*fFmEngineInitFunc)();
@@ -60,27 +73,6 @@ sc_uint8 _checksum_get_size()
     return (sc_uint8)g_checksum_type_get_length(_checksum_type());
 }
 
-gchar * _checksum_seg(sc_segment const * seg)
-{
-    gchar * result = null_ptr;
-    gsize length = 0;
-    GChecksum * checksum = g_checksum_new(_checksum_type());
-    g_assert(seg);
-
-    if (checksum)
-    {
-        g_checksum_reset(checksum);
-        g_checksum_update(checksum, (guchar*)(&seg->elements[0]), SC_SEG_ELEMENTS_SIZE_BYTE);
-
-        length = _checksum_get_size();
-        result = g_new0(gchar, length);
-        g_checksum_get_digest(checksum, result, &length);
-        g_assert( length == _checksum_get_size() );
-    }
-
-    return result;
-}
-
 void _remove_dir(gchar const * path)
 {
     char tmp_path[MAX_PATH_LENGTH];
@@ -116,12 +108,118 @@ void _remove_dir(gchar const * path)
     g_rmdir(path);
 }
 
+/*! Checks checksum of mapped segment. It's called on first usage of segment, so mapped memory isn't
+ * changed yet, and valid segment is counted in statistics of sc-memory at the same time. Damaged segment
+ * data is copied into quarantine file near segments file to recover it manually
+ */
+sc_bool _sc_fs_storage_check_segment(sc_segment *seg)
+{
+    gchar const *data = g_mapped_file_get_contents(segments_map);
+    sc_fs_storage_map_header const *header = (sc_fs_storage_map_header const*)data;
+    sc_fs_storage_segment_info const *info = (sc_fs_storage_segment_info const*)(header + 1) + seg->num;
+    gchar const *seg_data = data + header->data_offset + header->segment_size * seg->num;
+    GChecksum *checksum = g_checksum_new(_checksum_type());
+    sc_uint8 digest[SC_STORAGE_SEG_CHECKSUM_SIZE];
+    gsize bytes = SC_STORAGE_SEG_CHECKSUM_SIZE;
+    sc_bool result;
+
+    g_checksum_update(checksum, (guchar const*)seg_data, SC_SEG_DATA_SIZE_BYTE);
+    g_checksum_get_digest(checksum, digest, &bytes);
+    g_checksum_free(checksum);
+
+    result = (bytes == SC_STORAGE_SEG_CHECKSUM_SIZE && memcmp(digest, info->checksum, SC_STORAGE_SEG_CHECKSUM_SIZE) == 0) ? SC_TRUE : SC_FALSE;
+    if (result == SC_FALSE)
+    {
+        gchar *path = g_strdup_printf("%s.damaged_%u", segments_path, seg->num);
+
+        g_warning("Invalid checksum of segment %u, it's refused and saved into %s", seg->num, path);
+        if (g_file_set_contents(path, seg_data, SC_SEG_DATA_SIZE_BYTE, null_ptr) == FALSE)
+            g_warning("Can't save damaged segment into %s", path);
+        g_free(path);
+    }
+    else
+        sc_storage_segment_loaded(seg->num, (sc_element const*)seg_data);
+
+    return result;
+}
+
+//! Checks mapped segments, that weren't used yet, so damaged ones are found without waiting for their usage
+gpointer _sc_fs_storage_check_thread_loop(gpointer data)
+{
+    sc_segment_table *segments = (sc_segment_table*)data;
+    sc_uint32 i;
+
+    for (i = 0; i < check_segments_num && g_atomic_int_get(&check_thread_stop) == 0; ++i)
+        sc_segment_check_external(sc_segment_table_get(segments, i));
+
+    g_message("Segments checked: %u", i);
+
+    return 0;
+}
+
+void _sc_fs_storage_check_stop()
+{
+    if (check_thread == null_ptr)
+        return;
+
+    g_atomic_int_set(&check_thread_stop, 1);
+    g_thread_join(check_thread);
+    check_thread = null_ptr;
+}
+
 // ----------------------------------------------
 
+/*! Chooses checksum algorithm of sc-links content. Algorithm of repository is stored in file, because
+ * stored contents are found by checksums. Repositories without this file, that have segments, are created
+ * by previous versions, so legacy checksum is used for them. New repositories use algorithm from config.
+ * @return Returns SC_FALSE, if algorithm name is unknown. Stored contents can't be found by another
+ * algorithm, so sc-memory isn't started and stored name isn't changed
+ */
+sc_bool _sc_fs_storage_init_checksum(sc_bool clear)
+{
+    gchar path[MAX_PATH_LENGTH];
+    gchar *name = null_ptr;
+    sc_checksum_algorithm algorithm = SC_CHECKSUM_FAST128;
+
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/%s", repo_path, checksum_file_name);
+
+    if (clear == SC_FALSE && g_file_get_contents(path, &name, null_ptr, null_ptr) == TRUE)
+    {
+        sc_bool known;
+        g_strstrip(name);
+        known = sc_link_checksum_algorithm_from_name(name, &algorithm);
+        if (known == SC_FALSE)
+            g_warning("Unknown checksum algorithm '%s' in: %s", name, path);
+        g_free(name);
+
+        if (known == SC_FALSE)
+            return SC_FALSE;
+    }
+    else
+    {
+        if (clear == SC_FALSE && g_file_test(segments_path, G_FILE_TEST_IS_REGULAR))
+            algorithm = SC_CHECKSUM_SHA256;
+        else if (sc_link_checksum_algorithm_from_name(sc_config_fm_checksum(), &algorithm) == SC_FALSE)
+        {
+            g_warning("Unknown checksum algorithm '%s' in config", sc_config_fm_checksum());
+            return SC_FALSE;
+        }
+
+        if (g_file_set_contents(path, sc_link_checksum_algorithm_name(algorithm), -1, null_ptr) == FALSE)
+            g_warning("Can't write checksum algorithm into: %s", path);
+    }
+
+    sc_link_checksum_set_algorithm(algorithm);
+    g_message("\tContent checksum: %s", sc_link_checksum_algorithm_name(algorithm));
+
+    return SC_TRUE;
+}
+
 sc_bool sc_fs_storage_initialize(const gchar *path, sc_bool clear)
 {
     g_message("Initialize sc-storage from path: %s", path);
     g_snprintf(segments_path, MAX_PATH_LENGTH, "%s/segments.scdb", path);
+    g_snprintf(journal_path, MAX_PATH_LENGTH, "%s/segments.scdb.journal", path);
     repo_path = g_strdup(path);
 
     g_message("\tFile memory engine: %s", sc_config_fm_engine());
@@ -169,6 +267,8 @@ sc_bool sc_fs_storage_initialize(const gchar *path, sc_bool clear)
         g_message("Clear memory");
         if (g_file_test(segments_path, G_FILE_TEST_IS_REGULAR) && g_remove(segments_path) != 0)
             g_error("Can't delete segments file: %s", segments_path);
+        if (g_file_test(journal_path, G_FILE_TEST_IS_REGULAR) && g_remove(journal_path) != 0)
+            g_error("Can't delete segments journal: %s", journal_path);
 
         g_message("Clear file memory");
         if (sc_fm_clear(fm_engine) != SC_RESULT_OK)
@@ -178,17 +278,32 @@ sc_bool sc_fs_storage_initialize(const gchar *path, sc_bool clear)
         }
     }
 
+    if (_sc_fs_storage_init_checksum(clear) == SC_FALSE)
+    {
+        sc_fs_storage_shutdown(null_ptr, SC_FALSE);
+        return SC_FALSE;
+    }
+
     return SC_TRUE;
 }
 
-sc_bool sc_fs_storage_shutdown(sc_segment **segments, sc_bool save_segments)
+sc_bool sc_fs_storage_shutdown(sc_segment_table *segments, sc_bool save_segments)
 {    
     g_message("Shutdown sc-storage");
 
+    _sc_fs_storage_check_stop();
+
     if (save_segments == SC_TRUE)
     {
         g_message("Write segments");
-        sc_fs_storage_write_to_path(segments);
+        sc_fs_storage_write_to_path(segments, null_ptr);
+    }
+
+    // segments still refer to mapped memory, but they are not used after shutdown
+    if (segments_map != null_ptr)
+    {
+        g_mapped_file_unref(segments_map);
+        segments_map = null_ptr;
     }
 
     sc_bool res = SC_FALSE;
@@ -218,128 +333,223 @@ sc_bool sc_fs_storage_shutdown(sc_segment **segments, sc_bool save_segments)
     return res;
 }
 
-sc_bool sc_fs_storage_read_from_path(sc_segment **segments, sc_uint32 *segments_num)
+//! Layout of sc-element in legacy segments file, where content of sc-link is stored in sc-element
+typedef struct _sc_fs_storage_legacy_element
 {
-    if (g_file_test(repo_path, G_FILE_TEST_IS_DIR) == FALSE)
+    sc_element_flags flags;
+    sc_addr first_out_arc;
+    sc_addr first_in_arc;
+    union
     {
-        g_error("%s isn't a directory.", repo_path);
+        sc_content content;
+        sc_arc_info arc;
+    };
+} sc_fs_storage_legacy_element;
+
+#define SC_FS_STORAGE_LEGACY_SEG_SIZE_BYTE (sizeof(sc_fs_storage_legacy_element) * SC_SEGMENT_ELEMENTS_COUNT)
+
+//! Loads segments from file in legacy format (sequential segments without page alignment)
+sc_bool _sc_fs_storage_read_legacy(sc_segment_table *segments, sc_uint32 *segments_num)
+{
+    GIOChannel * in_file = g_io_channel_new_file(segments_path, "r", null_ptr);
+    sc_fs_storage_segments_header header;
+    gsize bytes_num = 0;
+    sc_uint32 i = 0, header_size = 0;
+    GChecksum * checksum = null_ptr;
+    sc_segment * seg = null_ptr;
+    sc_fs_storage_legacy_element * buffer = null_ptr;
+    sc_element * elements = null_ptr;
+    sc_content * contents = null_ptr;
+    sc_uint32 j;
+    sc_bool is_valid = SC_TRUE;
+    sc_uint8 calculated_checksum[SC_STORAGE_SEG_CHECKSUM_SIZE];
+
+    g_assert(_checksum_get_size() == SC_STORAGE_SEG_CHECKSUM_SIZE);
+    if (!in_file)
+    {
+        g_critical("Can't open segments from: %s", segments_path);
         return SC_FALSE;
     }
 
-    if (g_file_test(segments_path, G_FILE_TEST_IS_REGULAR) == FALSE)
+    if (g_io_channel_set_encoding(in_file, null_ptr, null_ptr) != G_IO_STATUS_NORMAL)
     {
-        g_message("There are no segments in %s", segments_path);
+        g_critical("Can't setup encoding: %s", segments_path);
         return SC_FALSE;
     }
 
-    // open segments
+    if ((g_io_channel_read_chars(in_file, (gchar*)&header_size, sizeof(header_size), &bytes_num, null_ptr) != G_IO_STATUS_NORMAL) || (bytes_num != sizeof(header_size)))
     {
-        GIOChannel * in_file = g_io_channel_new_file(segments_path, "r", null_ptr);
-        sc_fs_storage_segments_header header;
-        gsize bytes_num = 0;
-        sc_uint32 i = 0, header_size = 0;
-        GChecksum * checksum = null_ptr;
-        sc_segment * seg = null_ptr;
-        sc_bool is_valid = SC_TRUE;
-        sc_uint8 calculated_checksum[SC_STORAGE_SEG_CHECKSUM_SIZE];
-
-        g_assert(_checksum_get_size() == SC_STORAGE_SEG_CHECKSUM_SIZE);
-        if (!in_file)
-        {
-            g_critical("Can't open segments from: %s", segments_path);
-            return SC_FALSE;
-        }
-
-        if (g_io_channel_set_encoding(in_file, null_ptr, null_ptr) != G_IO_STATUS_NORMAL)
-        {
-            g_critical("Can't setup encoding: %s", segments_path);
-            return SC_FALSE;
-        }
+        g_critical("Can't read header size");
+        return SC_FALSE;
+    }
 
-        if ((g_io_channel_read_chars(in_file, (gchar*)&header_size, sizeof(header_size), &bytes_num, null_ptr) != G_IO_STATUS_NORMAL) || (bytes_num != sizeof(header_size)))
-        {
-            g_critical("Can't read header size");
-            return SC_FALSE;
-        }
+    if (header_size != sizeof(header))
+    {
+        g_critical("Invalid header size %d != %d", header_size, (int)sizeof(header));
+        return SC_FALSE;
+    }
 
-        if (header_size != sizeof(header))
-        {
-            g_critical("Invalid header size %d != %d", header_size, (int)sizeof(header));
-            return SC_FALSE;
-        }
+    if ((g_io_channel_read_chars(in_file, (gchar*)&header, sizeof(header), &bytes_num, null_ptr) != G_IO_STATUS_NORMAL) || (bytes_num != sizeof(header)))
+    {
+        g_critical("Can't read header of segments: %s", segments_path);
+        return SC_FALSE;
+    }
 
-        if ((g_io_channel_read_chars(in_file, (gchar*)&header, sizeof(header), &bytes_num, null_ptr) != G_IO_STATUS_NORMAL) || (bytes_num != sizeof(header)))
-        {
-            g_critical("Can't read header of segments: %s", segments_path);
-            return SC_FALSE;
-        }
+    *segments_num = header.segments_num;
 
-        *segments_num = header.segments_num;
+    /// TODO: Check version
 
-        /// TODO: Check version
+    checksum = g_checksum_new(_checksum_type());
+    g_assert(checksum);
 
-        checksum = g_checksum_new(_checksum_type());
-        g_assert(checksum);
+    g_checksum_reset(checksum);
+    buffer = g_new0(sc_fs_storage_legacy_element, SC_SEGMENT_ELEMENTS_COUNT);
+    elements = g_new0(sc_element, SC_SEGMENT_ELEMENTS_COUNT);
+    contents = g_new0(sc_content, SC_SEGMENT_ELEMENTS_COUNT);
 
-        g_checksum_reset(checksum);
+    // chek data
+    for (i = 0; i < *segments_num; ++i)
+    {
+        seg = sc_segment_new(i);
+        sc_segment_table_set(segments, i, seg);
 
-        // chek data
-        for (i = 0; i < *segments_num; ++i)
+        g_io_channel_read_chars(in_file, (gchar*)buffer, SC_FS_STORAGE_LEGACY_SEG_SIZE_BYTE, &bytes_num, null_ptr);
+        if (bytes_num != SC_FS_STORAGE_LEGACY_SEG_SIZE_BYTE)
         {
-            seg = sc_segment_new(i);
-            segments[i] = seg;
-
-            g_io_channel_read_chars(in_file, (gchar*)seg->elements, SC_SEG_ELEMENTS_SIZE_BYTE, &bytes_num, null_ptr);
-            sc_segment_loaded(seg);
-            if (bytes_num != SC_SEG_ELEMENTS_SIZE_BYTE)
-            {
-                g_error("Error while read data for segment: %d", i);
-                is_valid = SC_FALSE;
-                break;
-            }
-            g_checksum_update(checksum, (guchar*)seg->elements, SC_SEG_ELEMENTS_SIZE_BYTE);
+            g_error("Error while read data for segment: %d", i);
+            is_valid = SC_FALSE;
+            break;
         }
+        g_checksum_update(checksum, (guchar*)buffer, SC_FS_STORAGE_LEGACY_SEG_SIZE_BYTE);
 
-        if (is_valid == SC_TRUE)
+        // contents of sc-links are moved apart from elements
+        memset(contents, 0, SC_SEG_CONTENTS_SIZE_BYTE);
+        for (j = 0; j < SC_SEGMENT_ELEMENTS_COUNT; ++j)
         {
-            // compare checksum
-            g_checksum_get_digest(checksum, calculated_checksum, &bytes_num);
-            if (bytes_num != SC_STORAGE_SEG_CHECKSUM_SIZE)
-                is_valid = SC_FALSE;
+            elements[j].flags = buffer[j].flags;
+            elements[j].first_out_arc = buffer[j].first_out_arc;
+            elements[j].first_in_arc = buffer[j].first_in_arc;
+            if (buffer[j].flags.type & sc_type_link)
+            {
+                memset(&elements[j].arc, 0, sizeof(sc_arc_info));
+                contents[j] = buffer[j].content;
+            }
             else
-                is_valid = (memcmp(calculated_checksum, header.checksum, SC_STORAGE_SEG_CHECKSUM_SIZE) == 0) ? SC_TRUE : SC_FALSE;
+                elements[j].arc = buffer[j].arc;
         }
 
-        if (is_valid == SC_FALSE)
+        // empty pages of segment are not allocated
+        sc_segment_set_elements(seg, elements, contents);
+        sc_segment_loaded(seg);
+        sc_storage_segment_loaded(i, elements);
+    }
+    g_free(buffer);
+    g_free(elements);
+    g_free(contents);
+
+    if (is_valid == SC_TRUE)
+    {
+        // compare checksum
+        g_checksum_get_digest(checksum, calculated_checksum, &bytes_num);
+        if (bytes_num != SC_STORAGE_SEG_CHECKSUM_SIZE)
+            is_valid = SC_FALSE;
+        else
+            is_valid = (memcmp(calculated_checksum, header.checksum, SC_STORAGE_SEG_CHECKSUM_SIZE) == 0) ? SC_TRUE : SC_FALSE;
+    }
+
+    if (is_valid == SC_FALSE)
+    {
+        for (i = 0; i < *segments_num; ++i)
         {
-            *segments_num = 0;
-            for (i = 0; i < SC_SEGMENT_MAX; ++i)
+            seg = sc_segment_table_get(segments, i);
+            if (seg)
             {
-                if (segments[i])
-                {
-                    sc_segment_free(segments[i]);
-                    segments[i] = null_ptr;
-                }
+                sc_segment_free(seg);
+                sc_segment_table_set(segments, i, null_ptr);
             }
         }
+        *segments_num = 0;
+    }
 
-        g_checksum_free(checksum);
-        g_io_channel_shutdown(in_file, FALSE, null_ptr);
+    g_checksum_free(checksum);
+    g_io_channel_shutdown(in_file, FALSE, null_ptr);
 
-        if (is_valid == SC_FALSE)
-            return SC_FALSE;
+    return is_valid;
+}
+
+//! Maps segments file into memory. Returns SC_FALSE, if file has other format
+sc_bool _sc_fs_storage_read_map(sc_segment_table *segments, sc_uint32 *segments_num, sc_bool *is_map)
+{
+    GError *error = null_ptr;
+    gchar const *data = null_ptr;
+    gsize size = 0;
+    sc_fs_storage_map_header const *header = null_ptr;
+    sc_fs_storage_segment_info const *infos = null_ptr;
+    sc_uint32 i, j;
+
+    *is_map = SC_FALSE;
+
+    // mapped memory is private, so changes of segments don't affect the file
+    segments_map = g_mapped_file_new(segments_path, TRUE, &error);
+    if (segments_map == null_ptr)
+    {
+        g_critical("Can't map segments file %s: %s", segments_path, error ? error->message : "");
+        if (error)
+            g_error_free(error);
+        return SC_FALSE;
     }
 
-    g_message("Segments loaded: %u", *segments_num);
+    data = g_mapped_file_get_contents(segments_map);
+    size = g_mapped_file_get_length(segments_map);
+    header = (sc_fs_storage_map_header const*)data;
 
-    g_assert(fm_engine != null_ptr);
-    g_message("Check file memory state");
-    sc_bool r = sc_fm_clean_state(fm_engine) == SC_RESULT_OK;
+    if (size < sizeof(sc_fs_storage_map_header) || header->magic != SC_STORAGE_MAP_MAGIC)
+    {
+        g_mapped_file_unref(segments_map);
+        segments_map = null_ptr;
+        return SC_FALSE;
+    }
 
-    if (r == SC_FALSE)
-        g_error("File memory wasn't check properly");
+    *is_map = SC_TRUE;
 
-    return r;
+    /// TODO: Check version
+    if (header->format != SC_STORAGE_MAP_FORMAT ||
+        header->segments_num > SC_SEGMENT_MAX ||
+        header->segment_size < SC_SEG_DATA_SIZE_BYTE ||
+        header->data_offset < sizeof(sc_fs_storage_map_header) + sizeof(sc_fs_storage_segment_info) * header->segments_num ||
+        size < header->data_offset + header->segment_size * header->segments_num)
+    {
+        g_critical("Invalid header of segments file: %s", segments_path);
+        g_mapped_file_unref(segments_map);
+        segments_map = null_ptr;
+        return SC_FALSE;
+    }
+
+    infos = (sc_fs_storage_segment_info const*)(header + 1);
+    for (i = 0; i < header->segments_num; ++i)
+    {
+        gchar const *seg_data = data + header->data_offset + header->segment_size * i;
+        sc_segment *seg = sc_segment_new_external(i, (sc_element*)seg_data, (sc_content*)(seg_data + SC_SEG_ELEMENTS_SIZE_BYTE));
+        sc_segment_set_external_check(seg, _sc_fs_storage_check_segment);
+
+        // setup sections from saved info, so elements are not touched until they are used
+        seg->elements_count = infos[i].elements_count;
+        for (j = 0; j < SC_CONCURRENCY_LEVEL; ++j)
+        {
+            seg->sections[j].empty_count = infos[i].empty_count[j];
+            seg->sections[j].empty_offset = infos[i].empty_offset[j];
+        }
+
+        sc_segment_table_set(segments, i, seg);
+    }
+    *segments_num = header->segments_num;
+
+    // checksums are checked on first usage of segments or in background, so pages are loaded lazily
+    check_segments_num = header->segments_num;
+    g_atomic_int_set(&check_thread_stop, 0);
+    check_thread = g_thread_new("sc-storage check", _sc_fs_storage_check_thread_loop, segments);
+
+    return SC_TRUE;
 }
 
 static GIOChannel * _open_tmp_file(gchar ** tmp_file_name)
@@ -353,112 +563,502 @@ static GIOChannel * _open_tmp_file(gchar ** tmp_file_name)
     return result;
 }
 
-sc_bool sc_fs_storage_write_to_path(sc_segment **segments)
+//! Writes \p size zero bytes into channel
+sc_bool _write_padding(GIOChannel *output, gsize size)
 {
-    sc_uint32 idx = 0, header_size = 0;
-    const sc_segment *segment = 0;
-    sc_fs_storage_segments_header header;
-    GChecksum * checksum = null_ptr;
-    GIOChannel * output = null_ptr;
-    gchar * tmp_filename = null_ptr;
-    gsize bytes;
-    sc_bool result = SC_TRUE;
+    static gchar const zeros[SC_STORAGE_MAP_PAGE_SIZE] = { 0 };
+    gsize bytes = 0;
 
-    if (!g_file_test(repo_path, G_FILE_TEST_IS_DIR))
+    while (size > 0)
     {
-        g_error("%s isn't a directory.", repo_path);
+        gsize const n = MIN(size, SC_STORAGE_MAP_PAGE_SIZE);
+        if (g_io_channel_write_chars(output, zeros, n, &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != n)
+            return SC_FALSE;
+        size -= n;
+    }
+
+    return SC_TRUE;
+}
+
+//! Flushes written data of channel to disk
+sc_bool _sync_channel(GIOChannel *output)
+{
+    if (g_io_channel_flush(output, null_ptr) != G_IO_STATUS_NORMAL)
+        return SC_FALSE;
+
+#ifndef WIN32
+    if (fsync(g_io_channel_unix_get_fd(output)) != 0)
+        return SC_FALSE;
+#endif
+
+    return SC_TRUE;
+}
+
+//! Writes \p size bytes from \p data at \p offset of file
+sc_bool _write_at(GIOChannel *output, sc_uint64 offset, gconstpointer data, gsize size)
+{
+    gsize bytes = 0;
+
+    return (g_io_channel_seek_position(output, (gint64)offset, G_SEEK_SET, null_ptr) == G_IO_STATUS_NORMAL &&
+            g_io_channel_write_chars(output, (gchar const*)data, size, &bytes, null_ptr) == G_IO_STATUS_NORMAL &&
+            bytes == size) ? SC_TRUE : SC_FALSE;
+}
+
+//! Returns number of segment infos, that reserved in file for \p segments_num segments
+sc_uint32 _sc_fs_storage_infos_capacity(sc_uint32 segments_num)
+{
+    sc_uint32 capacity = SC_STORAGE_MAP_INFOS_MIN;
+    while (capacity < segments_num)
+        capacity *= 2;
+    return capacity;
+}
+
+/*! Copies elements of segment into \p buffer and collects its info, if segment changed since last save
+ * or \p force is SC_TRUE. Segment is locked just for copying, so other segments can be changed meanwhile.
+ * Slots, that are reserved by unfinished bulk creation, are stored as empty ones: writing of them marks
+ * segment as changed again. Returns SC_TRUE, if segment was copied.
+ */
+sc_bool _sc_fs_storage_segment_snapshot(sc_segment *seg, sc_memory_context const *ctx, sc_bool force, gchar *buffer, sc_fs_storage_segment_info *info)
+{
+    sc_uint32 j;
+    sc_bool copy;
+    GChecksum *checksum;
+    gsize length = SC_STORAGE_SEG_CHECKSUM_SIZE;
+
+    if (force == SC_FALSE && g_atomic_int_get(&seg->dirty) == 0)
         return SC_FALSE;
+
+    if (ctx != null_ptr)
+        sc_segment_lock(seg, ctx);
+
+    copy = (sc_segment_reset_dirty(seg) == SC_TRUE || force == SC_TRUE) ? SC_TRUE : SC_FALSE;
+    if (copy == SC_TRUE)
+    {
+        sc_segment_copy_elements(seg, (sc_element*)buffer, (sc_content*)(buffer + SC_SEG_ELEMENTS_SIZE_BYTE));
+
+        info->elements_count = g_atomic_int_get(&seg->elements_count);
+        for (j = 0; j < SC_CONCURRENCY_LEVEL; ++j)
+        {
+            info->empty_count[j] = g_atomic_int_get(&seg->sections[j].empty_count);
+            info->empty_offset[j] = g_atomic_int_get(&seg->sections[j].empty_offset);
+        }
+
+        for (j = 0; j < SC_SEGMENT_ELEMENTS_COUNT; ++j)
+        {
+            sc_element *el = (sc_element*)buffer + j;
+            if (sc_element_is_reserved(el) == SC_FALSE)
+                continue;
+
+            memset(el, 0, sizeof(sc_element));
+            info->elements_count--;
+            info->empty_count[j % SC_CONCURRENCY_LEVEL]++;
+        }
     }
 
-    // create temporary file
+    if (ctx != null_ptr)
+        sc_segment_unlock(seg, ctx);
 
-    output = _open_tmp_file(&tmp_filename);
+    if (copy == SC_TRUE)
+    {
+        checksum = g_checksum_new(_checksum_type());
+        g_checksum_update(checksum, (guchar*)buffer, SC_SEG_DATA_SIZE_BYTE);
+        g_checksum_get_digest(checksum, info->checksum, &length);
+        g_assert(length == SC_STORAGE_SEG_CHECKSUM_SIZE);
+        g_checksum_free(checksum);
+    }
 
-    memset(&header, 0, sizeof(sc_fs_storage_segments_header));
-    header.segments_num = 0;
-    header.timestamp = g_get_real_time();
+    return copy;
+}
+
+//! Reads header of segments file, that can be updated in place, for \p segments_num segments
+sc_bool _sc_fs_storage_read_map_header(GIOChannel *file, sc_uint32 segments_num, sc_fs_storage_map_header *header)
+{
+    gsize bytes = 0;
+
+    return (g_io_channel_read_chars(file, (gchar*)header, sizeof(*header), &bytes, null_ptr) == G_IO_STATUS_NORMAL &&
+            bytes == sizeof(*header) &&
+            header->magic == SC_STORAGE_MAP_MAGIC &&
+            header->format == SC_STORAGE_MAP_FORMAT &&
+            header->segment_size == SC_STORAGE_MAP_ALIGN(SC_SEG_DATA_SIZE_BYTE) &&
+            header->segments_num <= segments_num &&
+            header->data_offset >= sizeof(*header) + sizeof(sc_fs_storage_segment_info) * segments_num) ? SC_TRUE : SC_FALSE;
+}
+
+/*! Writes segments from complete journal into segments file in place. Journal can be applied many times,
+ * so it's applied again after crash in the middle of write.
+ */
+sc_bool _sc_fs_storage_journal_apply(GIOChannel *output, gchar *buffer)
+{
+    sc_fs_storage_journal_header journal_header;
+    sc_fs_storage_map_header header;
+    sc_fs_storage_segment_info info;
+    GIOChannel *journal = null_ptr;
+    sc_uint32 i, idx = 0;
+    gsize bytes = 0;
+    sc_bool result = SC_FALSE;
+
+    journal = g_io_channel_new_file(journal_path, "r", null_ptr);
+    if (journal == null_ptr)
+        return SC_FALSE;
+    g_io_channel_set_encoding(journal, null_ptr, null_ptr);
+
+    if (g_io_channel_read_chars(journal, (gchar*)&journal_header, sizeof(journal_header), &bytes, null_ptr) != G_IO_STATUS_NORMAL ||
+        bytes != sizeof(journal_header) || journal_header.magic != SC_STORAGE_JOURNAL_MAGIC ||
+        g_io_channel_seek_position(output, 0, G_SEEK_SET, null_ptr) != G_IO_STATUS_NORMAL ||
+        _sc_fs_storage_read_map_header(output, journal_header.segments_num, &header) == SC_FALSE)
+        goto clean;
+
+    for (i = 0; i < journal_header.count; ++i)
+    {
+        if (g_io_channel_read_chars(journal, (gchar*)&idx, sizeof(idx), &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != sizeof(idx) ||
+            g_io_channel_read_chars(journal, (gchar*)&info, sizeof(info), &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != sizeof(info) ||
+            g_io_channel_read_chars(journal, buffer, SC_SEG_DATA_SIZE_BYTE, &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != SC_SEG_DATA_SIZE_BYTE ||
+            idx >= journal_header.segments_num)
+        {
+            g_critical("Can't read segment %u from %s", i, journal_path);
+            goto clean;
+        }
+
+        if (_write_at(output, header.data_offset + header.segment_size * idx, buffer, SC_SEG_DATA_SIZE_BYTE) == SC_FALSE ||
+            _write_padding(output, header.segment_size - SC_SEG_DATA_SIZE_BYTE) == SC_FALSE ||
+            _write_at(output, sizeof(header) + sizeof(sc_fs_storage_segment_info) * idx, &info, sizeof(info)) == SC_FALSE)
+        {
+            g_critical("Can't write segment %u into %s", idx, segments_path);
+            goto clean;
+        }
+    }
+
+    // header is written at the end, so new segments become visible after their data
     header.version = sc_version_to_int(&SC_VERSION);
+    header.segments_num = journal_header.segments_num;
+    header.timestamp = g_get_real_time();
+    if (_write_at(output, 0, &header, sizeof(header)) == SC_FALSE ||
+        _sync_channel(output) == SC_FALSE)
+    {
+        g_critical("Can't write header into %s", segments_path);
+        goto clean;
+    }
+
+    result = SC_TRUE;
+
+    clean:
+    {
+        g_io_channel_shutdown(journal, FALSE, null_ptr);
+    }
 
+    return result;
+}
+
+//! Finishes save, that was interrupted by crash. Returns SC_FALSE, if segments file can't be recovered
+sc_bool _sc_fs_storage_journal_recover()
+{
+    sc_fs_storage_journal_header journal_header;
+    GIOChannel *output = null_ptr;
+    gchar *buffer = null_ptr;
+    gsize bytes = 0;
+    sc_bool result = SC_TRUE;
+
+    if (g_file_test(journal_path, G_FILE_TEST_IS_REGULAR) == FALSE)
+        return SC_TRUE;
+
+    // journal without header wasn't complete, so segments file wasn't changed
+    output = g_io_channel_new_file(journal_path, "r", null_ptr);
+    if (output != null_ptr)
+    {
+        g_io_channel_set_encoding(output, null_ptr, null_ptr);
+        if (g_io_channel_read_chars(output, (gchar*)&journal_header, sizeof(journal_header), &bytes, null_ptr) != G_IO_STATUS_NORMAL)
+            bytes = 0;
+        g_io_channel_shutdown(output, FALSE, null_ptr);
+        output = null_ptr;
+    }
+
+    if (bytes == sizeof(journal_header) && journal_header.magic == SC_STORAGE_JOURNAL_MAGIC)
+    {
+        g_message("Apply segments journal: %s", journal_path);
+
+        buffer = g_new(gchar, SC_SEG_DATA_SIZE_BYTE);
+        output = g_io_channel_new_file(segments_path, "r+", null_ptr);
+        if (output != null_ptr)
+            g_io_channel_set_encoding(output, null_ptr, null_ptr);
+
+        result = (output != null_ptr && _sc_fs_storage_journal_apply(output, buffer) == SC_TRUE) ? SC_TRUE : SC_FALSE;
+        if (output != null_ptr)
+            g_io_channel_shutdown(output, TRUE, null_ptr);
+        g_free(buffer);
+
+        if (result == SC_FALSE)
+        {
+            g_critical("Can't apply segments journal: %s", journal_path);
+            return SC_FALSE;
+        }
+    }
+
+    if (g_remove(journal_path) != 0)
+        g_warning("Can't remove segments journal: %s", journal_path);
+
+    return result;
+}
+
+/*! Writes changed segments into existing segments file in place. Segments are written into journal at
+ * first, so segments file can be recovered after crash. Returns SC_FALSE, if file can't be updated in
+ * place (it doesn't exist, has other format or hasn't space for new segments info), so it need to be rewritten.
+ */
+sc_bool _sc_fs_storage_write_changed(sc_segment_table *segments, sc_uint32 segments_num, sc_memory_context const *ctx, gchar *buffer)
+{
+    sc_fs_storage_map_header header;
+    sc_fs_storage_journal_header journal_header;
+    sc_fs_storage_segment_info info;
+    GIOChannel *output = null_ptr;
+    GIOChannel *journal = null_ptr;
+    sc_uint32 idx;
+    gsize bytes = 0;
+    sc_bool result = SC_FALSE;
+
+    if (g_file_test(segments_path, G_FILE_TEST_IS_REGULAR) == FALSE)
+        return SC_FALSE;
+
+    output = g_io_channel_new_file(segments_path, "r+", null_ptr);
+    if (output == null_ptr)
+        return SC_FALSE;
     g_io_channel_set_encoding(output, null_ptr, null_ptr);
 
-    checksum = g_checksum_new(_checksum_type());
-    g_checksum_reset(checksum);
+    if (_sc_fs_storage_read_map_header(output, segments_num, &header) == SC_FALSE)
+        goto clean;
 
-    for (idx = 0; idx < SC_ADDR_SEG_MAX; idx++)
+    journal = g_io_channel_new_file(journal_path, "w", null_ptr);
+    if (journal == null_ptr)
     {
-        segment = segments[idx];
-        if (segment == null_ptr)
-            break; // stop save, because we allocate segment in order
+        g_critical("Can't create segments journal: %s", journal_path);
+        goto clean;
+    }
+    g_io_channel_set_encoding(journal, null_ptr, null_ptr);
 
-        g_checksum_update(checksum, (guchar*)segment->elements, SC_SEG_ELEMENTS_SIZE_BYTE);
+    // header is written after records, so incomplete journal isn't applied
+    memset(&journal_header, 0, sizeof(journal_header));
+    journal_header.segments_num = segments_num;
+    if (_write_padding(journal, sizeof(journal_header)) == SC_FALSE)
+        goto journal_error;
+
+    for (idx = 0; idx < segments_num; ++idx)
+    {
+        // new segments are always changed
+        if (_sc_fs_storage_segment_snapshot(sc_segment_table_get(segments, idx), ctx, SC_FALSE, buffer, &info) == SC_FALSE)
+            continue;
+
+        if (g_io_channel_write_chars(journal, (gchar const*)&idx, sizeof(idx), &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != sizeof(idx) ||
+            g_io_channel_write_chars(journal, (gchar const*)&info, sizeof(info), &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != sizeof(info) ||
+            g_io_channel_write_chars(journal, buffer, SC_SEG_DATA_SIZE_BYTE, &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != SC_SEG_DATA_SIZE_BYTE)
+            goto journal_error;
+        ++journal_header.count;
     }
 
-    header.segments_num = idx;
-    bytes = SC_STORAGE_SEG_CHECKSUM_SIZE;
-    g_checksum_get_digest(checksum, header.checksum, &bytes);
+    journal_header.magic = SC_STORAGE_JOURNAL_MAGIC;
+    if (_sync_channel(journal) == SC_FALSE ||
+        _write_at(journal, 0, &journal_header, sizeof(journal_header)) == SC_FALSE ||
+        _sync_channel(journal) == SC_FALSE)
+        goto journal_error;
+
+    g_io_channel_shutdown(journal, TRUE, null_ptr);
+    journal = null_ptr;
 
-    header_size = sizeof(header);
-    if (g_io_channel_write_chars(output, (gchar*)&header_size, sizeof(header_size), &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != sizeof(header_size))
+    if (_sc_fs_storage_journal_apply(output, buffer) == SC_FALSE)
     {
-        g_error("Can't write header size: %s", tmp_filename);
-        result = SC_FALSE;
+        // journal stays, so segments file is recovered on next load
+        g_critical("Can't write segments from journal into %s", segments_path);
         goto clean;
     }
 
-    if (g_io_channel_write_chars(output, (gchar*)&header, header_size, &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != header_size)
+    if (g_remove(journal_path) != 0)
+        g_warning("Can't remove segments journal: %s", journal_path);
+
+    g_message("Segments written: %u of %u", journal_header.count, segments_num);
+    result = SC_TRUE;
+    goto clean;
+
+    journal_error:
     {
-        g_error("Can't write header: %s", tmp_filename);
-        result = SC_FALSE;
+        g_critical("Can't write segments journal: %s", journal_path);
+        g_io_channel_shutdown(journal, FALSE, null_ptr);
+        journal = null_ptr;
+        g_remove(journal_path);
+    }
+
+    clean:
+    {
+        g_io_channel_shutdown(output, TRUE, null_ptr);
+    }
+
+    return result;
+}
+
+//! Writes all segments into new segments file
+sc_bool _sc_fs_storage_write_all(sc_segment_table *segments, sc_uint32 segments_num, sc_memory_context const *ctx, gchar *buffer)
+{
+    sc_uint32 idx = 0;
+    sc_fs_storage_map_header header;
+    sc_fs_storage_segment_info *infos = null_ptr;
+    GIOChannel * output = null_ptr;
+    gchar * tmp_filename = null_ptr;
+    gsize infos_size;
+    sc_bool result = SC_FALSE;
+
+    // create temporary file
+    output = _open_tmp_file(&tmp_filename);
+    if (output == null_ptr)
+    {
+        g_critical("Can't create temporary file: %s", tmp_filename);
+        g_free(tmp_filename);
+        return SC_FALSE;
+    }
+    g_io_channel_set_encoding(output, null_ptr, null_ptr);
+
+    memset(&header, 0, sizeof(sc_fs_storage_map_header));
+    header.magic = SC_STORAGE_MAP_MAGIC;
+    header.format = SC_STORAGE_MAP_FORMAT;
+    header.version = sc_version_to_int(&SC_VERSION);
+    header.segments_num = segments_num;
+    header.timestamp = g_get_real_time();
+    header.segment_size = SC_STORAGE_MAP_ALIGN(SC_SEG_DATA_SIZE_BYTE);
+
+    // reserve space for info of new segments, so file can be updated in place
+    infos_size = sizeof(sc_fs_storage_segment_info) * segments_num;
+    header.data_offset = SC_STORAGE_MAP_ALIGN(sizeof(header) + sizeof(sc_fs_storage_segment_info) * _sc_fs_storage_infos_capacity(segments_num));
+    infos = g_new0(sc_fs_storage_segment_info, segments_num > 0 ? segments_num : 1);
+
+    // infos are written after segments, when checksums are known
+    if (_write_padding(output, header.data_offset) == SC_FALSE)
+    {
+        g_critical("Can't write header: %s", tmp_filename);
         goto clean;
     }
 
-    for (idx = 0; idx < header.segments_num; ++idx)
+    for (idx = 0; idx < segments_num; ++idx)
     {
-        segment = segments[idx];
-        g_assert(segment != null_ptr);
+        _sc_fs_storage_segment_snapshot(sc_segment_table_get(segments, idx), ctx, SC_TRUE, buffer, &infos[idx]);
 
-        if (g_io_channel_write_chars(output, (gchar*)segment->elements, SC_SEG_ELEMENTS_SIZE_BYTE, &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != SC_SEG_ELEMENTS_SIZE_BYTE)
+        if (_write_at(output, header.data_offset + header.segment_size * idx, buffer, SC_SEG_DATA_SIZE_BYTE) == SC_FALSE ||
+            _write_padding(output, header.segment_size - SC_SEG_DATA_SIZE_BYTE) == SC_FALSE)
         {
-            g_error("Can't write segment %d into %s", idx, tmp_filename);
-            result = SC_FALSE;
+            g_critical("Can't write segment %u into %s", idx, tmp_filename);
             goto clean;
         }
     }
 
-    if (result == SC_TRUE)
+    if (_write_at(output, 0, &header, sizeof(header)) == SC_FALSE ||
+        (infos_size > 0 && _write_at(output, sizeof(header), infos, infos_size) == SC_FALSE) ||
+        _sync_channel(output) == SC_FALSE)
     {
-        // rename main file
-        if (g_file_test(tmp_filename, G_FILE_TEST_IS_REGULAR))
-        {
-            g_io_channel_shutdown(output, TRUE, NULL);
-            output = null_ptr;
+        g_critical("Can't write segments info: %s", tmp_filename);
+        goto clean;
+    }
 
-            if (g_rename(tmp_filename, segments_path) != 0)
-            {
-                g_error("Can't rename %s -> %s", tmp_filename, segments_path);
-                result = SC_FALSE;
-            }
-        }
+    // rename main file
+    g_io_channel_shutdown(output, TRUE, null_ptr);
+    output = null_ptr;
 
-        // save file memory
-        g_message("Save file memory state");
-        if (sc_fm_save(fm_engine) != SC_RESULT_OK)
-            g_critical("Error while saves file memory");
+    if (g_rename(tmp_filename, segments_path) != 0)
+    {
+        g_critical("Can't rename %s -> %s", tmp_filename, segments_path);
+        goto clean;
     }
 
+    // journal of failed in place write can't be applied to new file
+    if (g_file_test(journal_path, G_FILE_TEST_IS_REGULAR) && g_remove(journal_path) != 0)
+        g_critical("Can't remove segments journal: %s", journal_path);
+
+    g_message("Segments written: %u", segments_num);
+    result = SC_TRUE;
+
     clean:
     {
-        if (tmp_filename)
-            g_free(tmp_filename);
-        if (checksum)
-            g_checksum_free(checksum);
         if (output)
-            g_io_channel_shutdown(output, TRUE, null_ptr);
+        {
+            g_io_channel_shutdown(output, FALSE, null_ptr);
+            g_remove(tmp_filename);
+        }
+        g_free(tmp_filename);
+        g_free(infos);
     }
 
     return result;
 }
 
+sc_bool sc_fs_storage_read_from_path(sc_segment_table *segments, sc_uint32 *segments_num)
+{
+    sc_bool is_map = SC_FALSE;
+
+    if (g_file_test(repo_path, G_FILE_TEST_IS_DIR) == FALSE)
+    {
+        g_error("%s isn't a directory.", repo_path);
+        return SC_FALSE;
+    }
+
+    if (g_file_test(segments_path, G_FILE_TEST_IS_REGULAR) == FALSE)
+    {
+        g_message("There are no segments in %s", segments_path);
+        return SC_FALSE;
+    }
+
+    if (_sc_fs_storage_journal_recover() == SC_FALSE)
+        return SC_FALSE;
+
+    if (_sc_fs_storage_read_map(segments, segments_num, &is_map) == SC_FALSE)
+    {
+        if (is_map == SC_TRUE)
+            return SC_FALSE;
+
+        g_message("Load segments in legacy format");
+        if (_sc_fs_storage_read_legacy(segments, segments_num) == SC_FALSE)
+            return SC_FALSE;
+    }
+
+    g_message("Segments loaded: %u", *segments_num);
+
+    g_assert(fm_engine != null_ptr);
+    g_message("Check file memory state");
+    sc_bool r = sc_fm_clean_state(fm_engine) == SC_RESULT_OK;
+
+    if (r == SC_FALSE)
+        g_error("File memory wasn't check properly");
+
+    return r;
+}
+
+sc_bool sc_fs_storage_write_to_path(sc_segment_table *segments, sc_memory_context const *ctx)
+{
+    sc_uint32 idx = 0, segments_num = 0;
+    gchar *buffer = null_ptr;
+    sc_bool result = SC_TRUE;
+
+    if (!g_file_test(repo_path, G_FILE_TEST_IS_DIR))
+    {
+        g_error("%s isn't a directory.", repo_path);
+        return SC_FALSE;
+    }
+
+    // segments are allocated in order
+    while (segments_num < SC_ADDR_SEG_MAX && sc_segment_table_get(segments, segments_num) != null_ptr)
+        ++segments_num;
+
+    buffer = g_new(gchar, SC_SEG_DATA_SIZE_BYTE);
+    if (_sc_fs_storage_write_changed(segments, segments_num, ctx, buffer) == SC_FALSE &&
+        _sc_fs_storage_write_all(segments, segments_num, ctx, buffer) == SC_FALSE)
+    {
+        // state of file is unknown, so write all segments next time
+        for (idx = 0; idx < segments_num; ++idx)
+            sc_segment_set_dirty(sc_segment_table_get(segments, idx));
+        result = SC_FALSE;
+    }
+    g_free(buffer);
+
+    // save file memory
+    g_message("Save file memory state");
+    if (sc_fm_save(fm_engine) != SC_RESULT_OK)
+        g_critical("Error while saves file memory");
+
+    return result;
+}
+
 
 sc_result sc_fs_storage_write_content(sc_addr addr, const sc_check_sum *check_sum, const sc_stream *stream)
 {
@@ -22,6 +22,52 @@ typedef struct _sc_fs_storage_segments_header
 
 } sc_fs_storage_segments_header;
 
+/*! Segments file, that can be mapped into memory. It contains header, table of segments info and
+ * segments data. Each segment data block is page aligned and has fixed size, so segments use mapped
+ * memory directly and pages are loaded on first access. Segment data block contains array of elements,
+ * that is followed by array of sc-links contents (see SC_SEG_DATA_SIZE_BYTE).
+ */
+#define SC_STORAGE_MAP_MAGIC        0x42444353  // "SCDB"
+#define SC_STORAGE_MAP_FORMAT       3
+#define SC_STORAGE_MAP_PAGE_SIZE    4096
+#define SC_STORAGE_MAP_INFOS_MIN    64          // minimal number of segment infos reserved in file
+#define SC_STORAGE_MAP_ALIGN(x)     ((((x) + SC_STORAGE_MAP_PAGE_SIZE - 1) / SC_STORAGE_MAP_PAGE_SIZE) * SC_STORAGE_MAP_PAGE_SIZE)
+
+typedef struct _sc_fs_storage_map_header
+{
+    sc_uint32 magic;            // SC_STORAGE_MAP_MAGIC
+    sc_uint32 format;           // SC_STORAGE_MAP_FORMAT
+    sc_uint32 version;          // version of sc-memory, that saved file
+    sc_uint32 segments_num;
+    sc_uint64 timestamp;
+    sc_uint64 segment_size;     // size of segment data block in file
+    sc_uint64 data_offset;      // offset of the first segment data block in file
+} sc_fs_storage_map_header;
+
+//! Info of one segment in segments file. It allows to use segment without scanning of its elements
+typedef struct _sc_fs_storage_segment_info
+{
+    sc_uint8  checksum[SC_STORAGE_SEG_CHECKSUM_SIZE];   // checksum of segment data
+    sc_uint32 elements_count;
+    sc_uint32 empty_count[SC_CONCURRENCY_LEVEL];        // number of empty elements in each section
+    sc_uint32 empty_offset[SC_CONCURRENCY_LEVEL];       // offset of any empty element in each section
+} sc_fs_storage_segment_info;
+
+/*! Journal of segments, that are written into segments file in place. Changed segments are written into
+ * journal first, and journal header is written after them. So crash while segments file is updated is
+ * recovered by journal on next load, and journal without header is just removed (segments file wasn't
+ * changed yet). Journal contains header and records: segment index, segment info and segment data.
+ */
+#define SC_STORAGE_JOURNAL_MAGIC    0x4a444353  // "SCDJ"
+
+typedef struct _sc_fs_storage_journal_header
+{
+    sc_uint32 magic;            // SC_STORAGE_JOURNAL_MAGIC, it's written after records
+    sc_uint32 segments_num;     // number of segments in file after journal is applied
+    sc_uint32 count;            // number of records
+    sc_uint32 reserved;
+} sc_fs_storage_journal_header;
+
 /*! Initialize file system storage in specified path
  * @param path Path to store on file system.
  * @param clear Flag to initialize empty storage
@@ -30,21 +76,26 @@ sc_bool sc_fs_storage_initialize(const char *path, sc_bool clear);
 
 /*! Shutdown file system storage
  */
-sc_bool sc_fs_storage_shutdown(sc_segment **segments, sc_bool save_segments);
+sc_bool sc_fs_storage_shutdown(sc_segment_table *segments, sc_bool save_segments);
 
-/*! Load segments from file system storage
+/*! Load segments from file system storage. Segments file is mapped into memory and checksums of segments
+ * are checked, so damaged file isn't loaded. Journal of interrupted save is applied before load.
  *
- * @param segments Pointer to segments array.
+ * @param segments Pointer to segments table.
  * @param segments_num Pointer to container for number of segments
  * It will be contain pointers to loaded segments.
  */
-sc_bool sc_fs_storage_read_from_path(sc_segment **segments, sc_uint32 *segments_num);
+sc_bool sc_fs_storage_read_from_path(sc_segment_table *segments, sc_uint32 *segments_num);
 
-/*! Save segments to file system
+/*! Save segments to file system. Just segments, that changed since last save, are written into
+ * segments file in place through journal. Whole file is rewritten into temporary file, that replaces
+ * segments file, when it doesn't exist or has no space for new segments.
  *
- * @param segments Pointer to array that contains segment pointers to save.
+ * @param segments Pointer to table that contains segments to save.
+ * @param ctx Context to lock segments one by one while they are copied. If it's null, then segments
+ * are not locked (there are no other users of memory)
  */
-sc_bool sc_fs_storage_write_to_path(sc_segment **segments);
+sc_bool sc_fs_storage_write_to_path(sc_segment_table *segments, sc_memory_context const *ctx);
 
 // -------------------------------------------------
 /*! Write specified stream as content
@@ -7,6 +7,8 @@
 #include "sc_iterator.h"
 #include "sc_element.h"
 #include "sc_storage.h"
+#include "sc_adjacency.h"
+#include "sc_config.h"
 #include "../sc_memory_private.h"
 
 #include <glib.h>
@@ -138,11 +140,12 @@ void _sc_iterator_unref_element_addr(const sc_memory_context *ctx, sc_addr addr)
     STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr))
 }
 
-sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+//! Checks parameters of iterator with \p type and refs its fixed elements
+sc_bool _sc_iterator3_ref_params(const sc_memory_context *ctx, sc_iterator3_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
 {
     // check types
     if (type >= sc_iterator3_count)
-        return (sc_iterator3*)0;
+        return SC_FALSE;
     
     // check params with template
     switch (type)
@@ -153,7 +156,7 @@ sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type t
             _sc_iterator_ref_element(ctx, p1.addr) != SC_TRUE
            )
         {
-            return (sc_iterator3*)0;
+            return SC_FALSE;
         }
         break;
     
@@ -162,7 +165,7 @@ sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type t
             _sc_iterator_ref_element(ctx, p3.addr) != SC_TRUE
            )
         {
-            return (sc_iterator3*)0;
+            return SC_FALSE;
         }
         break;
 
@@ -172,7 +175,7 @@ sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type t
             _sc_iterator_ref_element(ctx, p3.addr) != SC_TRUE
            )
         {
-            return (sc_iterator3*)0;
+            return SC_FALSE;
         }
         break;
 
@@ -181,12 +184,17 @@ sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type t
             _sc_iterator_ref_element(ctx, p2.addr) != SC_TRUE
             )
         {
-            return (sc_iterator3*)0;
+            return SC_FALSE;
         }
         break;
     };
 
-    sc_iterator3 *it = g_new0(sc_iterator3, 1);
+    return SC_TRUE;
+}
+
+void _sc_iterator3_setup(sc_iterator3 *it, const sc_memory_context *ctx, sc_iterator3_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    memset(it, 0, sizeof(sc_iterator3));
 
     it->params[0] = p1;
     it->params[1] = p2;
@@ -195,11 +203,48 @@ sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type t
     it->type = type;
     it->ctx = ctx;
     it->finished = SC_FALSE;
+}
+
+sc_iterator3* sc_iterator3_new(const sc_memory_context *ctx, sc_iterator3_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    if (_sc_iterator3_ref_params(ctx, type, p1, p2, p3) == SC_FALSE)
+        return (sc_iterator3*)0;
+
+    sc_iterator3 *it = g_new0(sc_iterator3, 1);
+    _sc_iterator3_setup(it, ctx, type, p1, p2, p3);
 
     return it;
 }
 
-void sc_iterator3_free(sc_iterator3 *it)
+//! Returns SC_TRUE, if fixed element of parameter can be read with \p ctx
+sc_bool _sc_iterator3_check_access(const sc_memory_context *ctx, sc_iterator_param p)
+{
+    sc_access_levels levels;
+
+    if (p.is_type)
+        return SC_TRUE;
+
+    return (sc_storage_get_access_levels(ctx, p.addr, &levels) == SC_RESULT_OK &&
+            sc_access_lvl_check_read(ctx->access_levels, levels)) ? SC_TRUE : SC_FALSE;
+}
+
+sc_bool sc_iterator3_init(sc_iterator3 *it, const sc_memory_context *ctx, sc_iterator3_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    g_assert(it != null_ptr);
+
+    if (_sc_iterator3_check_access(ctx, p1) == SC_FALSE ||
+        _sc_iterator3_check_access(ctx, p2) == SC_FALSE ||
+        _sc_iterator3_check_access(ctx, p3) == SC_FALSE ||
+        _sc_iterator3_ref_params(ctx, type, p1, p2, p3) == SC_FALSE)
+    {
+        return SC_FALSE;
+    }
+
+    _sc_iterator3_setup(it, ctx, type, p1, p2, p3);
+    return SC_TRUE;
+}
+
+void sc_iterator3_destroy(sc_iterator3 *it)
 {
     if (it == null_ptr)
         return;
@@ -229,9 +274,25 @@ void sc_iterator3_free(sc_iterator3 *it)
         break;
     }
 
+    g_free(it->arcs);
+    it->arcs = null_ptr;
+}
+
+void sc_iterator3_free(sc_iterator3 *it)
+{
+    if (it == null_ptr)
+        return;
+
+    sc_iterator3_destroy(it);
     g_free(it);
 }
 
+void sc_iterator3_set_context(sc_iterator3 *it, const sc_memory_context *ctx)
+{
+    g_assert(it != null_ptr);
+    it->ctx = ctx;
+}
+
 sc_bool sc_iterator_param_compare(sc_element *el, sc_addr addr, sc_iterator_param param)
 {
     g_assert(el != 0);
@@ -245,9 +306,317 @@ sc_bool sc_iterator_param_compare(sc_element *el, sc_addr addr, sc_iterator_para
 }
 
 
+/*! Locks sc-arc, that is walked by iterator. It's locked by attempts to prevent deadlock with deletion.
+ * Owner of section could be preempted by reader, so reader yields between attempts
+ */
+sc_element* _sc_iterator3_lock_arc(sc_iterator3 *it, sc_addr arc_addr)
+{
+    sc_element *el = 0;
+
+    STORAGE_CHECK_CALL(sc_storage_element_lock_try(it->ctx, arc_addr, s_max_iterator_lock_attempts, &el));
+    while (el == null_ptr)
+    {
+        g_thread_yield();
+        STORAGE_CHECK_CALL(sc_storage_element_lock_try(it->ctx, arc_addr, s_max_iterator_lock_attempts, &el));
+    }
+
+    return el;
+}
+
+//! Counts walked sc-arcs in list of \p el and builds adjacency for it, when there are many of them
+void _sc_iterator3_count_walked(sc_iterator3 *it, sc_addr el)
+{
+    if (++it->walked == sc_config_adjacency_threshold())
+        sc_storage_adjacency_build(it->ctx, el);
+}
+
+//! Returns SC_TRUE, if sc-element \p el has adjacency (see sc_adjacency.h)
+sc_bool _sc_iterator3_has_adjacency(sc_iterator3 *it, sc_addr el)
+{
+    sc_element *element = 0;
+    sc_bool result;
+
+    STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, el, &element));
+    g_assert(element != null_ptr);
+    result = sc_storage_get_element_meta(it->ctx, el)->adjacency ? SC_TRUE : SC_FALSE;
+    STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, el));
+
+    return result;
+}
+
+/*! Collects sc-arcs of fixed element from its adjacency. It's done just when iterator starts, so sc-arcs,
+ * that are created later, aren't iterated like in list walk.
+ * @return Returns SC_TRUE, if iterator should take collected sc-arcs instead of list walk
+ */
+sc_bool _sc_iterator3_collect(sc_iterator3 *it)
+{
+    sc_addr empty;
+    SC_ADDR_MAKE_EMPTY(empty);
+
+    switch (it->type)
+    {
+    case sc_iterator3_f_a_a:
+        return _sc_iterator3_has_adjacency(it, it->params[0].addr) &&
+               sc_adjacency_collect(it->params[0].addr, SC_ADJACENCY_OUT, it->params[1].type, empty, &it->arcs, &it->arcs_count);
+
+    case sc_iterator3_a_a_f:
+        return _sc_iterator3_has_adjacency(it, it->params[2].addr) &&
+               sc_adjacency_collect(it->params[2].addr, SC_ADJACENCY_IN, it->params[1].type, empty, &it->arcs, &it->arcs_count);
+
+    case sc_iterator3_f_a_f:
+        if (_sc_iterator3_has_adjacency(it, it->params[2].addr) == SC_TRUE &&
+            sc_adjacency_collect(it->params[2].addr, SC_ADJACENCY_IN, it->params[1].type, it->params[0].addr, &it->arcs, &it->arcs_count) == SC_TRUE)
+        {
+            return SC_TRUE;
+        }
+        return _sc_iterator3_has_adjacency(it, it->params[0].addr) &&
+               sc_adjacency_collect(it->params[0].addr, SC_ADJACENCY_OUT, it->params[1].type, it->params[2].addr, &it->arcs, &it->arcs_count);
+
+    default:
+        break;
+    };
+
+    return SC_FALSE;
+}
+
+//! Moves iterator to the next matched sc-arc from collected ones
+sc_bool _sc_iterator3_adjacency_next(sc_iterator3 *it)
+{
+    if (SC_ADDR_IS_NOT_EMPTY(it->results[1]))
+    {
+        _sc_iterator_unref_element_addr(it->ctx, it->results[1]);
+        SC_ADDR_MAKE_EMPTY(it->results[1]);
+    }
+
+    while (it->arcs_pos < it->arcs_count)
+    {
+        sc_addr const arc_addr = it->arcs[it->arcs_pos++];
+        sc_element *el = 0;
+        sc_bool found = SC_FALSE;
+        sc_addr arc_begin, arc_end;
+        sc_access_levels other_access = sc_access_lvl_make_max;
+        sc_type other_type = 0;
+
+        el = _sc_iterator3_lock_arc(it, arc_addr);
+
+        // sc-arc could be deleted and its place reused after it was collected
+        if ((el->flags.type & sc_type_arc_mask) &&
+            sc_element_is_request_deletion(el) == SC_FALSE &&
+            sc_iterator_compare_type(el->flags.type, it->params[1].type) &&
+            sc_access_lvl_check_read(it->ctx->access_levels, el->flags.access_levels))
+        {
+            arc_begin = el->arc.begin;
+            arc_end = el->arc.end;
+            found = (it->type == sc_iterator3_a_a_f || SC_ADDR_IS_EQUAL(arc_begin, it->params[0].addr)) &&
+                    (it->type == sc_iterator3_f_a_a || SC_ADDR_IS_EQUAL(arc_end, it->params[2].addr));
+        }
+
+        if (found == SC_FALSE || sc_element_ref(sc_storage_get_element_meta(it->ctx, arc_addr)) == SC_FALSE)
+        {
+            STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
+            continue;
+        }
+
+        // other element is read after unlock, so deletion, that holds it, isn't waited with locked sc-arc
+        STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
+
+        switch (it->type)
+        {
+        case sc_iterator3_f_a_a:
+            sc_storage_get_access_levels(it->ctx, arc_end, &other_access);
+            sc_storage_get_element_type(it->ctx, arc_end, &other_type);
+            found = sc_iterator_compare_type(other_type, it->params[2].type) &&
+                    sc_access_lvl_check_read(it->ctx->access_levels, other_access);
+            break;
+
+        case sc_iterator3_a_a_f:
+            sc_storage_get_access_levels(it->ctx, arc_begin, &other_access);
+            sc_storage_get_element_type(it->ctx, arc_begin, &other_type);
+            found = sc_iterator_compare_type(other_type, it->params[0].type) &&
+                    sc_access_lvl_check_read(it->ctx->access_levels, other_access);
+            break;
+
+        default:
+            break;
+        };
+
+        if (found == SC_TRUE)
+        {
+            it->results[0] = arc_begin;
+            it->results[1] = arc_addr;
+            it->results[2] = arc_end;
+            return SC_TRUE;
+        }
+
+        _sc_iterator_unref_element_addr(it->ctx, arc_addr);
+    }
+
+    it->finished = SC_TRUE;
+
+    return SC_FALSE;
+}
+
+//! Returns SC_FALSE, if sc-element \p addr doesn't match \p type or can't be read. It's checked without lock
+sc_bool _sc_iterator3_may_match_element(sc_iterator3 *it, sc_addr addr, sc_type type)
+{
+    sc_element el;
+    sc_uint32 version;
+
+    // on conflict with writer sc-element is checked under lock
+    if (sc_storage_element_try_read(addr, &el, &version) == SC_FALSE)
+        return SC_TRUE;
+
+    return sc_iterator_compare_type(el.flags.type, type) &&
+           sc_access_lvl_check_read(it->ctx->access_levels, el.flags.access_levels);
+}
+
+//! Returns SC_TRUE, if \p arc is sc-arc from list of \p el in direction \p dir
+sc_bool _sc_iterator3_arc_in_list(sc_element *arc, sc_addr el, sc_adjacency_direction dir)
+{
+    return (arc->flags.type & sc_type_arc_mask) &&
+           SC_ADDR_IS_EQUAL(dir == SC_ADJACENCY_OUT ? arc->arc.begin : arc->arc.end, el);
+}
+
+//! Returns SC_TRUE, if sc-arc \p arc has the same place in lists of sc-arcs, as \p expected
+sc_bool _sc_iterator3_arc_unchanged(sc_element *arc, sc_element *expected)
+{
+    return SC_ADDR_IS_EQUAL(arc->arc.begin, expected->arc.begin) &&
+           SC_ADDR_IS_EQUAL(arc->arc.end, expected->arc.end) &&
+           SC_ADDR_IS_EQUAL(arc->arc.next_out_arc, expected->arc.next_out_arc) &&
+           SC_ADDR_IS_EQUAL(arc->arc.next_in_arc, expected->arc.next_in_arc);
+}
+
+/*! Reads next sc-arc of \p prev_addr in list of \p el under lock. It's used, when sc-arc can't be validated after
+ * it's read without lock, so walk doesn't continue from erased or reused sc-arc
+ * @return Returns empty address, if \p prev_addr isn't in list of \p el anymore
+ */
+sc_addr _sc_iterator3_next_locked(sc_iterator3 *it, sc_addr prev_addr, sc_addr el, sc_adjacency_direction dir)
+{
+    sc_element *prev = 0;
+    sc_addr arc_addr;
+    SC_ADDR_MAKE_EMPTY(arc_addr);
+
+    STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, prev_addr, &prev));
+    if (prev == null_ptr)
+        return arc_addr;
+
+    if (SC_ADDR_IS_EQUAL(prev_addr, el))
+        arc_addr = (dir == SC_ADJACENCY_OUT) ? prev->first_out_arc : prev->first_in_arc;
+    else if (_sc_iterator3_arc_in_list(prev, el, dir))
+        arc_addr = (dir == SC_ADJACENCY_OUT) ? prev->arc.next_out_arc : prev->arc.next_in_arc;
+    STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, prev_addr));
+
+    return arc_addr;
+}
+
+/*! Walks sc-arcs after \p start_addr without locks, see _sc_iterator3_skip. Each sc-arc is validated by previous
+ * element after it's read: sc-arc can't be removed from list without change of previous one.
+ * @return Returns SC_FALSE, if some walked element was changed meanwhile, so walk should be repeated
+ */
+sc_bool _sc_iterator3_skip_from(sc_iterator3 *it, sc_addr start_addr, sc_addr el, sc_adjacency_direction dir, sc_addr *arc_addr, sc_element *arc)
+{
+    sc_element prev;
+    sc_addr prev_addr = start_addr;
+    sc_uint32 prev_version = 0;
+
+    if (sc_storage_element_try_read(start_addr, &prev, &prev_version) == SC_FALSE)
+        return SC_FALSE;
+
+    if (SC_ADDR_IS_EQUAL(start_addr, el))
+        *arc_addr = (dir == SC_ADJACENCY_OUT) ? prev.first_out_arc : prev.first_in_arc;
+    else if (_sc_iterator3_arc_in_list(&prev, el, dir) && sc_element_is_request_deletion(&prev) == SC_FALSE)
+        *arc_addr = (dir == SC_ADJACENCY_OUT) ? prev.arc.next_out_arc : prev.arc.next_in_arc;
+    else
+        return SC_TRUE; // deleted sc-arc isn't changed with its next sc-arc, so it's walked under lock
+
+    while (SC_ADDR_IS_NOT_EMPTY(*arc_addr))
+    {
+        sc_uint32 version;
+        sc_bool may_match = SC_FALSE;
+
+        if (sc_storage_element_try_read(*arc_addr, arc, &version) == SC_FALSE ||
+            sc_storage_element_validate(prev_addr, prev_version) == SC_FALSE)
+        {
+            return SC_FALSE;
+        }
+
+        if (sc_element_is_request_deletion(arc) == SC_FALSE &&
+            sc_iterator_compare_type(arc->flags.type, it->params[1].type) &&
+            sc_access_lvl_check_read(it->ctx->access_levels, arc->flags.access_levels))
+        {
+            switch (it->type)
+            {
+            case sc_iterator3_f_a_a:
+                may_match = _sc_iterator3_may_match_element(it, arc->arc.end, it->params[2].type);
+                break;
+
+            case sc_iterator3_a_a_f:
+                may_match = _sc_iterator3_may_match_element(it, arc->arc.begin, it->params[0].type);
+                break;
+
+            case sc_iterator3_f_a_f:
+                may_match = SC_ADDR_IS_EQUAL(arc->arc.begin, it->params[0].addr);
+                break;
+
+            default:
+                may_match = SC_TRUE;
+                break;
+            };
+        }
+
+        if (may_match == SC_TRUE)
+            return SC_TRUE;
+
+        _sc_iterator3_count_walked(it, el);
+        prev_addr = *arc_addr;
+        prev_version = version;
+        *arc_addr = (dir == SC_ADJACENCY_OUT) ? arc->arc.next_out_arc : arc->arc.next_in_arc;
+    }
+
+    return SC_TRUE;
+}
+
+/*! Skips sc-arcs in list of \p el, that don't match iterator, without locks (see sc_storage_element_try_read).
+ * So readers don't write into sections of skipped sc-arcs and don't wait for writers. When skipped sc-arcs
+ * are changed meanwhile, walk is repeated from \p prev_addr, which isn't erased while iterator holds it.
+ * @param prev_addr Previous element of \p arc_addr: \p el or the last sc-arc, that was checked under lock
+ * @param arc_addr Next sc-arc of \p prev_addr, that was read under lock. It's returned, when walk fails
+ * @param dir Direction of list: output sc-arcs for f_a_a and input ones for a_a_f and f_a_f iterators
+ * @param arc Pointer to copy of returned sc-arc. Its type is 0, if it isn't read
+ * @return Returns sc-arc, that could match iterator, so it should be checked under lock. Returns empty address
+ * at the end of list
+ */
+sc_addr _sc_iterator3_skip(sc_iterator3 *it, sc_addr prev_addr, sc_addr arc_addr, sc_addr el, sc_adjacency_direction dir, sc_element *arc)
+{
+    sc_uint32 attempt;
+
+    // all sc-arcs match iterator without filters, so there is nothing to skip
+    if (it->params[1].type == 0 &&
+        ((it->type == sc_iterator3_f_a_a && it->params[2].type == 0) ||
+         (it->type == sc_iterator3_a_a_f && it->params[0].type == 0)))
+    {
+        arc->flags.type = 0;
+        return arc_addr;
+    }
+
+    for (attempt = 0; attempt < s_max_iterator_lock_attempts; ++attempt)
+    {
+        sc_addr result = arc_addr;
+
+        arc->flags.type = 0;
+        if (_sc_iterator3_skip_from(it, prev_addr, el, dir, &result, arc) == SC_TRUE)
+            return result;
+    }
+
+    arc->flags.type = 0;
+    return arc_addr;
+}
+
 sc_bool _sc_iterator3_f_a_a_next(sc_iterator3 *it)
 {
     sc_addr arc_addr;
+    sc_addr prev_addr = it->params[0].addr;
+    sc_uint32 retries = 0;
     SC_ADDR_MAKE_EMPTY(arc_addr);
 
     it->results[0] = it->params[0].addr;
@@ -255,17 +624,19 @@ sc_bool _sc_iterator3_f_a_a_next(sc_iterator3 *it)
     // try to find first output arc
     if (SC_ADDR_IS_EMPTY(it->results[1]))
     {
-        sc_element *el = 0;
-        STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, it->params[0].addr, &el));
-        g_assert(el != null_ptr);
-        arc_addr = el->first_out_arc;
-        STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, it->params[0].addr));
+        sc_element el;
+        STORAGE_CHECK_CALL(sc_storage_element_read(it->ctx, it->params[0].addr, &el));
+        arc_addr = el.first_out_arc;
+
+        if (_sc_iterator3_collect(it) == SC_TRUE)
+            return _sc_iterator3_adjacency_next(it);
     }else
     {
         sc_element *el = 0;
         STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, it->results[1], &el));
         g_assert(el != null_ptr);
         arc_addr = el->arc.next_out_arc;
+        prev_addr = it->results[1];
         _sc_iterator_unref_element(it->ctx, el, it->results[1]);
         STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, it->results[1]));
     }
@@ -274,9 +645,28 @@ sc_bool _sc_iterator3_f_a_a_next(sc_iterator3 *it)
     while (SC_ADDR_IS_NOT_EMPTY(arc_addr))
     {
         sc_element *el = 0;
+        sc_element expected;
+
+        arc_addr = _sc_iterator3_skip(it, prev_addr, arc_addr, it->params[0].addr, SC_ADJACENCY_OUT, &expected);
+        if (SC_ADDR_IS_EMPTY(arc_addr))
+            break;
+        _sc_iterator3_count_walked(it, it->params[0].addr);
+
         // lock required elements to prevent deadlock with deletion
-        while (el == null_ptr)
-            STORAGE_CHECK_CALL(sc_storage_element_lock_try(it->ctx, arc_addr, s_max_iterator_lock_attempts, &el));
+        el = _sc_iterator3_lock_arc(it, arc_addr);
+
+        // sc-arc could be deleted and its place reused after it was read without lock, then list is read again
+        if ((expected.flags.type != 0 ? _sc_iterator3_arc_unchanged(el, &expected) : _sc_iterator3_arc_in_list(el, it->params[0].addr, SC_ADJACENCY_OUT)) == SC_FALSE)
+        {
+            STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
+            if (retries++ >= s_max_iterator_lock_attempts)
+            {
+                // list changes too often to be read without lock, so next sc-arc is read under lock of previous one
+                arc_addr = _sc_iterator3_next_locked(it, prev_addr, it->params[0].addr, SC_ADJACENCY_OUT);
+                retries = 0;
+            }
+            continue;
+        }
 
         if (!sc_element_ref(sc_storage_get_element_meta(it->ctx, arc_addr)))
         {
@@ -292,11 +682,13 @@ sc_bool _sc_iterator3_f_a_a_next(sc_iterator3 *it)
             sc_type arc_type = el->flags.type;
             sc_access_levels arc_access = el->flags.access_levels;
             sc_access_levels end_access;
-            if (sc_storage_get_access_levels(it->ctx, arc_end, &end_access) != SC_RESULT_OK)
-                end_access = sc_access_lvl_make_max;
 
+            // end is read after unlock, so deletion, that holds it, isn't waited with locked sc-arc
             STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
 
+            if (sc_storage_get_access_levels(it->ctx, arc_end, &end_access) != SC_RESULT_OK)
+                end_access = sc_access_lvl_make_max;
+
             sc_type el_type;
             sc_storage_get_element_type(it->ctx, arc_end, &el_type);
 
@@ -319,6 +711,7 @@ sc_bool _sc_iterator3_f_a_a_next(sc_iterator3 *it)
         }
 
         // go to next arc
+        prev_addr = arc_addr;
         arc_addr = next_out_arc;
     }
 
@@ -330,6 +723,8 @@ sc_bool _sc_iterator3_f_a_a_next(sc_iterator3 *it)
 sc_bool _sc_iterator3_f_a_f_next(sc_iterator3 *it)
 {
     sc_addr arc_addr;
+    sc_addr prev_addr = it->params[2].addr;
+    sc_uint32 retries = 0;
 
     SC_ADDR_MAKE_EMPTY(arc_addr);
 
@@ -339,17 +734,19 @@ sc_bool _sc_iterator3_f_a_f_next(sc_iterator3 *it)
     // try to find first input arc
     if (SC_ADDR_IS_EMPTY(it->results[1]))
     {
-        sc_element *el = 0;
-        STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, it->params[2].addr, &el));
-        g_assert(el != null_ptr);
-        arc_addr = el->first_in_arc;
-        STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, it->params[2].addr));
+        sc_element el;
+        STORAGE_CHECK_CALL(sc_storage_element_read(it->ctx, it->params[2].addr, &el));
+        arc_addr = el.first_in_arc;
+
+        if (_sc_iterator3_collect(it) == SC_TRUE)
+            return _sc_iterator3_adjacency_next(it);
     }else
     {
         sc_element *el = 0;
         STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, it->results[1], &el));
         g_assert(el != null_ptr);
         arc_addr = el->arc.next_in_arc;
+        prev_addr = it->results[1];
         _sc_iterator_unref_element(it->ctx, el, it->results[1]);
         STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, it->results[1]));
     }
@@ -358,8 +755,27 @@ sc_bool _sc_iterator3_f_a_f_next(sc_iterator3 *it)
     while (SC_ADDR_IS_NOT_EMPTY(arc_addr))
     {
         sc_element *el = 0;
-        while (el == null_ptr)
-            STORAGE_CHECK_CALL(sc_storage_element_lock_try(it->ctx, arc_addr, s_max_iterator_lock_attempts, &el));
+        sc_element expected;
+
+        arc_addr = _sc_iterator3_skip(it, prev_addr, arc_addr, it->params[2].addr, SC_ADJACENCY_IN, &expected);
+        if (SC_ADDR_IS_EMPTY(arc_addr))
+            break;
+        _sc_iterator3_count_walked(it, it->params[2].addr);
+
+        el = _sc_iterator3_lock_arc(it, arc_addr);
+
+        // sc-arc could be deleted and its place reused after it was read without lock, then list is read again
+        if ((expected.flags.type != 0 ? _sc_iterator3_arc_unchanged(el, &expected) : _sc_iterator3_arc_in_list(el, it->params[2].addr, SC_ADJACENCY_IN)) == SC_FALSE)
+        {
+            STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
+            if (retries++ >= s_max_iterator_lock_attempts)
+            {
+                // list changes too often to be read without lock, so next sc-arc is read under lock of previous one
+                arc_addr = _sc_iterator3_next_locked(it, prev_addr, it->params[2].addr, SC_ADJACENCY_IN);
+                retries = 0;
+            }
+            continue;
+        }
 
         if (!sc_element_ref(sc_storage_get_element_meta(it->ctx, arc_addr)))
         {
@@ -393,6 +809,7 @@ sc_bool _sc_iterator3_f_a_f_next(sc_iterator3 *it)
         }
 
         // go to next arc
+        prev_addr = arc_addr;
         arc_addr = next_in_arc;
     }
 
@@ -404,24 +821,28 @@ sc_bool _sc_iterator3_f_a_f_next(sc_iterator3 *it)
 sc_bool _sc_iterator3_a_a_f_next(sc_iterator3 *it)
 {
     sc_addr arc_addr;
-    SC_ADDR_MAKE_EMPTY(arc_addr)
+    sc_addr prev_addr = it->params[2].addr;
+    sc_uint32 retries = 0;
+    SC_ADDR_MAKE_EMPTY(arc_addr);
 
     it->results[2] = it->params[2].addr;
 
     // try to find first input arc
     if (SC_ADDR_IS_EMPTY(it->results[1]))
     {
-        sc_element *el = 0;
-        STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, it->params[2].addr, &el));
-        g_assert(el != null_ptr);
-        arc_addr = el->first_in_arc;
-        STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, it->params[2].addr));
+        sc_element el;
+        STORAGE_CHECK_CALL(sc_storage_element_read(it->ctx, it->params[2].addr, &el));
+        arc_addr = el.first_in_arc;
+
+        if (_sc_iterator3_collect(it) == SC_TRUE)
+            return _sc_iterator3_adjacency_next(it);
     }else
     {
         sc_element *el = 0;
         STORAGE_CHECK_CALL(sc_storage_element_lock(it->ctx, it->results[1], &el));
         g_assert(el != null_ptr);
         arc_addr = el->arc.next_in_arc;
+        prev_addr = it->results[1];
         _sc_iterator_unref_element(it->ctx, el, it->results[1]);
         STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, it->results[1]));
     }
@@ -430,8 +851,27 @@ sc_bool _sc_iterator3_a_a_f_next(sc_iterator3 *it)
     while (SC_ADDR_IS_NOT_EMPTY(arc_addr))
     {
         sc_element *el = 0;
-        while (el == null_ptr)
-            STORAGE_CHECK_CALL(sc_storage_element_lock_try(it->ctx, arc_addr, s_max_iterator_lock_attempts, &el));
+        sc_element expected;
+
+        arc_addr = _sc_iterator3_skip(it, prev_addr, arc_addr, it->params[2].addr, SC_ADJACENCY_IN, &expected);
+        if (SC_ADDR_IS_EMPTY(arc_addr))
+            break;
+        _sc_iterator3_count_walked(it, it->params[2].addr);
+
+        el = _sc_iterator3_lock_arc(it, arc_addr);
+
+        // sc-arc could be deleted and its place reused after it was read without lock, then list is read again
+        if ((expected.flags.type != 0 ? _sc_iterator3_arc_unchanged(el, &expected) : _sc_iterator3_arc_in_list(el, it->params[2].addr, SC_ADJACENCY_IN)) == SC_FALSE)
+        {
+            STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
+            if (retries++ >= s_max_iterator_lock_attempts)
+            {
+                // list changes too often to be read without lock, so next sc-arc is read under lock of previous one
+                arc_addr = _sc_iterator3_next_locked(it, prev_addr, it->params[2].addr, SC_ADJACENCY_IN);
+                retries = 0;
+            }
+            continue;
+        }
 
         if (!sc_element_ref(sc_storage_get_element_meta(it->ctx, arc_addr)))
         {
@@ -447,11 +887,13 @@ sc_bool _sc_iterator3_a_a_f_next(sc_iterator3 *it)
             sc_addr arc_begin = el->arc.begin;
             sc_access_levels arc_access = el->flags.access_levels;
             sc_access_levels begin_access;
-            if (sc_storage_get_access_levels(it->ctx, arc_begin, &begin_access) != SC_RESULT_OK)
-                begin_access = sc_access_lvl_make_max;
 
+            // begin is read after unlock, so deletion, that holds it, isn't waited with locked sc-arc
             STORAGE_CHECK_CALL(sc_storage_element_unlock(it->ctx, arc_addr));
 
+            if (sc_storage_get_access_levels(it->ctx, arc_begin, &begin_access) != SC_RESULT_OK)
+                begin_access = sc_access_lvl_make_max;
+
             sc_type el_type = 0;
             sc_storage_get_element_type(it->ctx, arc_begin, &el_type);
 
@@ -474,6 +916,7 @@ sc_bool _sc_iterator3_a_a_f_next(sc_iterator3 *it)
         }
 
         // go to next arc
+        prev_addr = arc_addr;
         arc_addr = next_in_arc;
     }
 
@@ -502,6 +945,9 @@ sc_bool sc_iterator3_next(sc_iterator3 *it)
     if ((it == null_ptr) || (it->finished == SC_TRUE))
         return SC_FALSE;
 
+    if (it->arcs != null_ptr)
+        return _sc_iterator3_adjacency_next(it);
+
     switch (it->type)
     {
 
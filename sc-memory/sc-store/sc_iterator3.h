@@ -44,6 +44,10 @@ struct _sc_iterator3
     sc_addr results[3];             // results array (same size as params)
     const sc_memory_context *ctx;   // pointer to used memory context
     sc_bool finished;
+    sc_addr *arcs;                  // sc-arcs collected from adjacency of fixed element (see sc_adjacency.h), or null
+    sc_uint32 arcs_count;           // number of collected sc-arcs
+    sc_uint32 arcs_pos;             // index of next collected sc-arc
+    sc_uint32 walked;               // number of walked sc-arcs in list of fixed element
 };
 
 /*! Create iterator to find output arcs for specified element
@@ -88,6 +92,18 @@ _SC_EXTERN sc_iterator3 * sc_iterator3_a_f_a_new(sc_memory_context const * ctx,
  */
 _SC_EXTERN void sc_iterator3_free(sc_iterator3 * it);
 
+/*! Initialize iterator in memory, that is owned by caller, so pool of iterators can be reused without allocations.
+ * Like typed constructors, it checks, that fixed elements can be read with \p ctx
+ * @param it Pointer to memory for iterator
+ * @return Returns SC_TRUE, if iterator initialized. Initialized iterator should be destroyed with sc_iterator3_destroy
+ */
+_SC_EXTERN sc_bool sc_iterator3_init(sc_iterator3 * it, sc_memory_context const * ctx, sc_iterator3_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3);
+
+/*! Destroy iterator, that was initialized with sc_iterator3_init. Memory of iterator isn't freed
+ * @param it Pointer to sc-iterator that need to be destroyed
+ */
+_SC_EXTERN void sc_iterator3_destroy(sc_iterator3 * it);
+
 /*! Go to next iterator result
  * @param it Pointer to iterator that we need to go next result
  * @return Return SC_TRUE, if iterator moved to new results; otherwise return SC_FALSE.
@@ -102,6 +118,14 @@ _SC_EXTERN sc_bool sc_iterator3_next(sc_iterator3 * it);
  */
 _SC_EXTERN sc_addr sc_iterator3_value(sc_iterator3 * it, sc_uint vid);
 
+/*! Change memory context, that is used by iterator. It's used to continue iteration,
+ * that was started by another thread with its own context. Context can be changed between
+ * iterator steps only
+ * @param it Pointer to iterator
+ * @param ctx Pointer to new memory context
+ */
+_SC_EXTERN void sc_iterator3_set_context(sc_iterator3 * it, const sc_memory_context * ctx);
+
 /*! Check if specified element type passed into
  * iterator selection.
  * @param el_type Compared element type
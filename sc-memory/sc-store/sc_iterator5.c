@@ -216,6 +216,17 @@ void sc_iterator5_free(sc_iterator5 *it)
     g_free(it);
 }
 
+void sc_iterator5_set_context(sc_iterator5 *it, const sc_memory_context *ctx)
+{
+    g_assert(it != null_ptr);
+
+    it->ctx = ctx;
+    if (it->it_main != null_ptr)
+        sc_iterator3_set_context(it->it_main, ctx);
+    if (it->it_attr != null_ptr)
+        sc_iterator3_set_context(it->it_attr, ctx);
+}
+
 sc_bool _sc_iterator5_a_a_f_a_f_next(sc_iterator5 *it)
 {
 
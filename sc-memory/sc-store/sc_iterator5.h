@@ -123,4 +123,11 @@ _SC_EXTERN sc_addr sc_iterator5_value(sc_iterator5 *it, sc_uint vid);
  */
 _SC_EXTERN void sc_iterator5_free(sc_iterator5 *it);
 
+/*! Change memory context, that is used by iterator and its internal iterators.
+ * Context can be changed between iterator steps only
+ * @param it Pointer to iterator
+ * @param ctx Pointer to new memory context
+ */
+_SC_EXTERN void sc_iterator5_set_context(sc_iterator5 *it, const sc_memory_context *ctx);
+
 #endif // SC_ITERATOR5_H
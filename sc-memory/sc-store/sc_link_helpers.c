@@ -7,58 +7,460 @@
 #include "sc_link_helpers.h"
 #include "sc_element.h"
 #include "sc_stream_memory.h"
+#include "sc_stream_private.h"
 
 #include <stdlib.h>
 #include <memory.h>
 #include <glib.h>
 
-#define SC_DEFAULT_CHECKSUM G_CHECKSUM_SHA256
+//! Size of buffer to read streams, that don't store data in memory
+#define SC_CHECKSUM_BUFFER_SIZE     (64 * 1024)
+
+sc_checksum_algorithm checksum_algorithm = SC_CHECKSUM_FAST128;
+
+// --- fast 128-bit hash ---
+/* Input is processed by 32 byte stripes in 4 independent 64-bit lanes (like in xxHash64), so lanes are
+ * computed in parallel by processor. Two 64-bit halves of result are mixed from lanes and tail differently.
+ */
+#define FAST128_PRIME1  0x9E3779B185EBCA87ULL
+#define FAST128_PRIME2  0xC2B2AE3D27D4EB4FULL
+#define FAST128_PRIME3  0x165667B19E3779F9ULL
+#define FAST128_PRIME4  0x85EBCA77C2B2AE63ULL
+#define FAST128_PRIME5  0x27D4EB2F165667C5ULL
+#define FAST128_STRIPE  32
+
+#define FAST128_ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+typedef struct
+{
+    sc_uint64 lanes[4];
+    sc_uint64 length;
+    sc_uint8 tail[FAST128_STRIPE];
+    sc_uint32 tail_size;
+} sc_fast128_state;
+
+sc_uint64 _fast128_read64(const sc_uint8 *p)
+{
+    // little-endian, so checksums are the same on all platforms
+    return (sc_uint64)p[0] | ((sc_uint64)p[1] << 8) | ((sc_uint64)p[2] << 16) | ((sc_uint64)p[3] << 24) |
+           ((sc_uint64)p[4] << 32) | ((sc_uint64)p[5] << 40) | ((sc_uint64)p[6] << 48) | ((sc_uint64)p[7] << 56);
+}
+
+sc_uint64 _fast128_read32(const sc_uint8 *p)
+{
+    return (sc_uint64)p[0] | ((sc_uint64)p[1] << 8) | ((sc_uint64)p[2] << 16) | ((sc_uint64)p[3] << 24);
+}
+
+sc_uint64 _fast128_round(sc_uint64 acc, sc_uint64 input)
+{
+    acc += input * FAST128_PRIME2;
+    acc = FAST128_ROTL(acc, 31);
+    return acc * FAST128_PRIME1;
+}
+
+sc_uint64 _fast128_merge(sc_uint64 acc, sc_uint64 lane)
+{
+    acc ^= _fast128_round(0, lane);
+    return acc * FAST128_PRIME1 + FAST128_PRIME4;
+}
+
+void _fast128_stripe(sc_fast128_state *state, const sc_uint8 *p)
+{
+    state->lanes[0] = _fast128_round(state->lanes[0], _fast128_read64(p));
+    state->lanes[1] = _fast128_round(state->lanes[1], _fast128_read64(p + 8));
+    state->lanes[2] = _fast128_round(state->lanes[2], _fast128_read64(p + 16));
+    state->lanes[3] = _fast128_round(state->lanes[3], _fast128_read64(p + 24));
+}
+
+void _fast128_init(sc_fast128_state *state)
+{
+    memset(state, 0, sizeof(sc_fast128_state));
+    state->lanes[0] = FAST128_PRIME1 + FAST128_PRIME2;
+    state->lanes[1] = FAST128_PRIME2;
+    state->lanes[2] = 0;
+    state->lanes[3] = (sc_uint64)0 - FAST128_PRIME1;
+}
+
+void _fast128_update(sc_fast128_state *state, const sc_uint8 *data, sc_uint32 size)
+{
+    const sc_uint8 *end = data + size;
+
+    state->length += size;
+
+    if (state->tail_size + size < FAST128_STRIPE)
+    {
+        memcpy(state->tail + state->tail_size, data, size);
+        state->tail_size += size;
+        return;
+    }
+
+    if (state->tail_size > 0)
+    {
+        sc_uint32 const fill = FAST128_STRIPE - state->tail_size;
+        memcpy(state->tail + state->tail_size, data, fill);
+        _fast128_stripe(state, state->tail);
+        data += fill;
+        state->tail_size = 0;
+    }
+
+    while (data + FAST128_STRIPE <= end)
+    {
+        _fast128_stripe(state, data);
+        data += FAST128_STRIPE;
+    }
+
+    state->tail_size = (sc_uint32)(end - data);
+    memcpy(state->tail, data, state->tail_size);
+}
+
+sc_uint64 _fast128_avalanche(sc_uint64 h, sc_uint32 s1, sc_uint64 m1, sc_uint32 s2, sc_uint64 m2, sc_uint32 s3)
+{
+    h ^= h >> s1;
+    h *= m1;
+    h ^= h >> s2;
+    h *= m2;
+    h ^= h >> s3;
+    return h;
+}
+
+void _fast128_final(sc_fast128_state const *state, sc_uint64 *low, sc_uint64 *high)
+{
+    sc_uint64 const *v = state->lanes;
+    const sc_uint8 *p = state->tail;
+    const sc_uint8 *end = state->tail + state->tail_size;
+    sc_uint64 lo, hi;
+
+    if (state->length >= FAST128_STRIPE)
+    {
+        lo = FAST128_ROTL(v[0], 1) + FAST128_ROTL(v[1], 7) + FAST128_ROTL(v[2], 12) + FAST128_ROTL(v[3], 18);
+        lo = _fast128_merge(lo, v[0]);
+        lo = _fast128_merge(lo, v[1]);
+        lo = _fast128_merge(lo, v[2]);
+        lo = _fast128_merge(lo, v[3]);
+
+        hi = FAST128_ROTL(v[3], 3) + FAST128_ROTL(v[2], 11) + FAST128_ROTL(v[1], 19) + FAST128_ROTL(v[0], 27);
+        hi = _fast128_merge(hi, v[3]);
+        hi = _fast128_merge(hi, v[2]);
+        hi = _fast128_merge(hi, v[1]);
+        hi = _fast128_merge(hi, v[0]);
+    }
+    else
+    {
+        lo = FAST128_PRIME5;
+        hi = FAST128_PRIME4;
+    }
+
+    lo += state->length;
+    hi ^= state->length * FAST128_PRIME3;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        sc_uint64 const k = _fast128_read64(p);
+        lo ^= _fast128_round(0, k);
+        lo = FAST128_ROTL(lo, 27) * FAST128_PRIME1 + FAST128_PRIME4;
+        hi ^= FAST128_ROTL(k * FAST128_PRIME4, 29) * FAST128_PRIME2;
+        hi = FAST128_ROTL(hi, 31) * FAST128_PRIME2 + FAST128_PRIME3;
+    }
+
+    if (p + 4 <= end)
+    {
+        sc_uint64 const k = _fast128_read32(p);
+        lo ^= k * FAST128_PRIME1;
+        lo = FAST128_ROTL(lo, 23) * FAST128_PRIME2 + FAST128_PRIME3;
+        hi ^= k * FAST128_PRIME3;
+        hi = FAST128_ROTL(hi, 21) * FAST128_PRIME1 + FAST128_PRIME5;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+    {
+        lo ^= (*p) * FAST128_PRIME5;
+        lo = FAST128_ROTL(lo, 11) * FAST128_PRIME1;
+        hi ^= (*p) * FAST128_PRIME1;
+        hi = FAST128_ROTL(hi, 13) * FAST128_PRIME5;
+    }
+
+    *low = _fast128_avalanche(lo, 33, FAST128_PRIME2, 29, FAST128_PRIME3, 32);
+    *high = _fast128_avalanche(hi + lo, 37, FAST128_PRIME3, 32, FAST128_PRIME1, 29);
+}
+
+// --- checksum algorithms ---
+/* Each algorithm is a set of functions, so new algorithms can be added without changes in
+ * stream reading code
+ */
+typedef gpointer (*fChecksumNew)();
+typedef void (*fChecksumUpdate)(gpointer state, const sc_uint8 *data, sc_uint32 size);
+typedef void (*fChecksumFinish)(gpointer state, sc_check_sum *check_sum);
+
+typedef struct
+{
+    const sc_char *name;
+    fChecksumNew new_func;
+    fChecksumUpdate update_func;
+    fChecksumFinish finish_func;  // stores result and frees state
+} sc_checksum_engine;
+
+gpointer _sha256_new()
+{
+    return g_checksum_new(G_CHECKSUM_SHA256);
+}
+
+void _sha256_update(gpointer state, const sc_uint8 *data, sc_uint32 size)
+{
+    g_checksum_update((GChecksum*)state, (guchar const*)data, size);
+}
+
+void _sha256_finish(gpointer state, sc_check_sum *check_sum)
+{
+    GChecksum *checksum = (GChecksum*)state;
+
+    // legacy checksum stores first chars of hex string
+    check_sum->len = SC_CHECKSUM_LEN;
+    memcpy(&(check_sum->data[0]), g_checksum_get_string(checksum), check_sum->len);
+
+    g_checksum_free(checksum);
+}
+
+gpointer _fast128_new()
+{
+    sc_fast128_state *state = g_new(sc_fast128_state, 1);
+    _fast128_init(state);
+    return state;
+}
+
+void _fast128_update_func(gpointer state, const sc_uint8 *data, sc_uint32 size)
+{
+    _fast128_update((sc_fast128_state*)state, data, size);
+}
+
+void _fast128_finish(gpointer data, sc_check_sum *check_sum)
+{
+    sc_fast128_state *state = (sc_fast128_state*)data;
+    sc_uint64 lo, hi;
+    sc_uint32 i;
+
+    _fast128_final(state, &lo, &hi);
+
+    memset(check_sum->data, 0, SC_MAX_CHECKSUM_LEN);
+    check_sum->data[0] = SC_CHECKSUM_FAST128_MARK;
+    for (i = 0; i < 7; ++i)
+        check_sum->data[1 + i] = (sc_char)((state->length >> (8 * i)) & 0xff);
+    for (i = 0; i < 8; ++i)
+    {
+        check_sum->data[8 + i] = (sc_char)((lo >> (8 * i)) & 0xff);
+        check_sum->data[16 + i] = (sc_char)((hi >> (8 * i)) & 0xff);
+    }
+    check_sum->len = SC_CHECKSUM_BINARY_LEN;
+
+    g_free(state);
+}
+
+sc_checksum_engine const checksum_engines[] =
+{
+    { "sha256", _sha256_new, _sha256_update, _sha256_finish },
+    { "fast128", _fast128_new, _fast128_update_func, _fast128_finish }
+};
+
+#define SC_CHECKSUM_ENGINES_NUM (sizeof(checksum_engines) / sizeof(checksum_engines[0]))
+
+
+void sc_link_checksum_set_algorithm(sc_checksum_algorithm algorithm)
+{
+    g_assert((sc_uint32)algorithm < SC_CHECKSUM_ENGINES_NUM);
+    checksum_algorithm = algorithm;
+}
+
+sc_checksum_algorithm sc_link_checksum_get_algorithm()
+{
+    return checksum_algorithm;
+}
+
+const sc_char* sc_link_checksum_algorithm_name(sc_checksum_algorithm algorithm)
+{
+    g_assert((sc_uint32)algorithm < SC_CHECKSUM_ENGINES_NUM);
+    return checksum_engines[algorithm].name;
+}
+
+sc_bool sc_link_checksum_algorithm_from_name(const sc_char *name, sc_checksum_algorithm *algorithm)
+{
+    sc_uint32 i;
+    for (i = 0; i < SC_CHECKSUM_ENGINES_NUM; ++i)
+    {
+        if (g_strcmp0(checksum_engines[i].name, name) == 0)
+        {
+            *algorithm = (sc_checksum_algorithm)i;
+            return SC_TRUE;
+        }
+    }
+
+    return SC_FALSE;
+}
 
 sc_bool sc_link_calculate_checksum(const sc_stream *stream, sc_check_sum *check_sum)
 {
-    sc_char buffer[1024];
+    return sc_link_calculate_checksum_by(stream, checksum_algorithm, check_sum);
+}
+
+sc_bool sc_link_calculate_checksum_by(const sc_stream *stream, sc_checksum_algorithm algorithm, sc_check_sum *check_sum)
+{
+    sc_checksum_engine const *engine = null_ptr;
+    const sc_char *data = null_ptr;
+    sc_char *buffer = null_ptr;
     sc_uint32 data_read;
-    const gchar *result = 0;
-    GChecksum *checksum = g_checksum_new(SC_DEFAULT_CHECKSUM);
+    gpointer state = null_ptr;
 
     g_assert(stream != 0);
     g_assert(check_sum != 0);
-    g_checksum_reset(checksum);
+    g_assert((sc_uint32)algorithm < SC_CHECKSUM_ENGINES_NUM);
 
-    sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
+    engine = &checksum_engines[algorithm];
+    state = engine->new_func();
 
-    while (sc_stream_eof(stream) == SC_FALSE)
+    // data, that is stored in memory, is processed without copying
+    if (stream->data_func != null_ptr && stream->data_func(stream, &data, &data_read) == SC_RESULT_OK)
     {
-        if (sc_stream_read_data(stream, buffer, 1024, &data_read) == SC_RESULT_ERROR)
+        engine->update_func(state, (const sc_uint8*)data, data_read);
+    }
+    else
+    {
+        buffer = g_malloc(SC_CHECKSUM_BUFFER_SIZE);
+        sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
+
+        while (sc_stream_eof(stream) == SC_FALSE)
         {
-            g_checksum_free(checksum);
-            return SC_FALSE;
+            if (sc_stream_read_data(stream, buffer, SC_CHECKSUM_BUFFER_SIZE, &data_read) == SC_RESULT_ERROR)
+            {
+                engine->finish_func(state, check_sum);
+                g_free(buffer);
+                return SC_FALSE;
+            }
+
+            engine->update_func(state, (const sc_uint8*)buffer, data_read);
         }
 
-        g_checksum_update(checksum, (guchar*)buffer, data_read);
+        g_free(buffer);
     }
 
     // store results
-    check_sum->len = (sc_uint8)g_checksum_type_get_length(SC_DEFAULT_CHECKSUM);
-    g_assert(check_sum->len == SC_CHECKSUM_LEN);
-
-    result = g_checksum_get_string(checksum);
-    memcpy(&(check_sum->data[0]), result, check_sum->len);
-
-    g_checksum_free(checksum);
+    engine->finish_func(state, check_sum);
+    g_assert(check_sum->len <= SC_CHECKSUM_LEN);
 
     sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
 
     return SC_TRUE;
 }
 
-sc_bool sc_link_self_container_calculate_checksum(sc_element *el, sc_check_sum *sum)
+sc_bool sc_link_self_container_calculate_checksum(sc_content const *content, sc_check_sum *sum)
 {
-    sc_stream *stream = sc_stream_memory_new(&el->content.data[1], el->content.data[0], SC_STREAM_FLAG_READ, SC_FALSE);
+    sc_stream *stream = sc_stream_memory_new(&content->data[1], content->data[0], SC_STREAM_FLAG_READ, SC_FALSE);
     sc_bool r = sc_link_calculate_checksum(stream, sum);
     sc_stream_free(stream);
     return r;
 }
 
+void sc_link_checksum_from_content(sc_content const *content, sc_check_sum *sum)
+{
+    G_STATIC_ASSERT(SC_CHECKSUM_LEN <= SC_MAX_CHECKSUM_LEN);
+
+    memcpy(&sum->data[0], content->data, SC_CHECKSUM_LEN);
+    sum->len = (content->data[0] == SC_CHECKSUM_FAST128_MARK) ? SC_CHECKSUM_BINARY_LEN : SC_CHECKSUM_LEN;
+}
 
+sc_bool sc_link_checksum_is_binary(const sc_check_sum *sum)
+{
+    return (sum->len > 0 && sum->data[0] == SC_CHECKSUM_FAST128_MARK) ? SC_TRUE : SC_FALSE;
+}
 
+sc_uint32 sc_link_checksum_to_string(const sc_check_sum *sum, sc_char *str)
+{
+    static const sc_char hex[] = "0123456789abcdef";
+    sc_uint32 i, len = 0;
+
+    g_assert(sum->len <= SC_MAX_CHECKSUM_LEN);
+
+    if (sc_link_checksum_is_binary(sum) == SC_TRUE)
+    {
+        for (i = 0; i < sum->len; ++i)
+        {
+            sc_uint8 const b = (sc_uint8)sum->data[i];
+            str[len++] = hex[b >> 4];
+            str[len++] = hex[b & 0x0f];
+        }
+    }
+    else
+    {
+        memcpy(str, sum->data, sum->len);
+        len = sum->len;
+    }
+
+    str[len] = 0;
+    return len;
+}
+
+//! Reads \p size bytes from stream, if stream isn't ended before
+sc_bool _sc_link_stream_read_full(const sc_stream *stream, sc_char *buffer, sc_uint32 size, sc_uint32 *bytes_read)
+{
+    sc_uint32 read = 0;
+    *bytes_read = 0;
+
+    while (*bytes_read < size && sc_stream_eof(stream) == SC_FALSE)
+    {
+        if (sc_stream_read_data(stream, buffer + *bytes_read, size - *bytes_read, &read) == SC_RESULT_ERROR)
+            return SC_FALSE;
+        if (read == 0)
+            break;
+        *bytes_read += read;
+    }
+
+    return SC_TRUE;
+}
+
+sc_bool sc_link_streams_equal(const sc_stream *stream1, const sc_stream *stream2)
+{
+    sc_uint32 len1 = 0, len2 = 0;
+    sc_char *buffer1 = null_ptr, *buffer2 = null_ptr;
+    sc_bool result = SC_FALSE;
+
+    if (sc_stream_get_length(stream1, &len1) == SC_RESULT_OK &&
+        sc_stream_get_length(stream2, &len2) == SC_RESULT_OK &&
+        len1 != len2)
+    {
+        return SC_FALSE;
+    }
+
+    if (sc_stream_seek(stream1, SC_STREAM_SEEK_SET, 0) != SC_RESULT_OK ||
+        sc_stream_seek(stream2, SC_STREAM_SEEK_SET, 0) != SC_RESULT_OK)
+    {
+        return SC_FALSE;
+    }
+
+    buffer1 = g_malloc(SC_CHECKSUM_BUFFER_SIZE);
+    buffer2 = g_malloc(SC_CHECKSUM_BUFFER_SIZE);
+
+    while (SC_TRUE)
+    {
+        if (_sc_link_stream_read_full(stream1, buffer1, SC_CHECKSUM_BUFFER_SIZE, &len1) == SC_FALSE ||
+            _sc_link_stream_read_full(stream2, buffer2, SC_CHECKSUM_BUFFER_SIZE, &len2) == SC_FALSE)
+        {
+            goto clean;
+        }
+
+        if (len1 != len2 || memcmp(buffer1, buffer2, len1) != 0)
+            goto clean;
+
+        if (len1 < SC_CHECKSUM_BUFFER_SIZE)
+            break;
+    }
+
+    result = SC_TRUE;
+
+clean:
+    {
+        g_free(buffer1);
+        g_free(buffer2);
+        sc_stream_seek(stream1, SC_STREAM_SEEK_SET, 0);
+        sc_stream_seek(stream2, SC_STREAM_SEEK_SET, 0);
+    }
+
+    return result;
+}
@@ -10,21 +10,78 @@
 #include "sc_types.h"
 #include "sc_stream.h"
 
+/*! Checksum algorithms of sc-links content. Algorithm is chosen for repository once, when it's created,
+ * because contents are found by checksum (see sc_fs_storage_initialize).
+ */
+typedef enum
+{
+    //! Legacy checksum: 32 hex chars of SHA-256 digest
+    SC_CHECKSUM_SHA256 = 0,
+    //! Binary digest of fast non-cryptographic 128-bit hash and content length
+    SC_CHECKSUM_FAST128 = 1
+} sc_checksum_algorithm;
+
+/*! Binary checksum layout: marker byte, 7 bytes of content length (little-endian) and 16 bytes of hash.
+ * Marker isn't a hex char, so binary checksums are distinguished from legacy ones stored in the same place.
+ */
+#define SC_CHECKSUM_FAST128_MARK    0x01
+#define SC_CHECKSUM_BINARY_LEN      24
+
+//! Size of buffer for checksum string (see sc_link_checksum_to_string)
+#define SC_CHECKSUM_STRING_SIZE     (SC_MAX_CHECKSUM_LEN * 2 + 1)
+
+//! Sets algorithm, that is used by sc_link_calculate_checksum
+void sc_link_checksum_set_algorithm(sc_checksum_algorithm algorithm);
+
+//! Returns algorithm, that is used by sc_link_calculate_checksum
+sc_checksum_algorithm sc_link_checksum_get_algorithm();
+
+//! Returns name of checksum algorithm
+const sc_char* sc_link_checksum_algorithm_name(sc_checksum_algorithm algorithm);
+
+/*! Finds checksum algorithm by name
+ * @return If algorithm with \p name exists, then returns SC_TRUE and sets \p algorithm; otherwise returns SC_FALSE
+ */
+sc_bool sc_link_checksum_algorithm_from_name(const sc_char *name, sc_checksum_algorithm *algorithm);
 
-/*! Caclulates checksum for data in stream
+/*! Caclulates checksum for data in stream by current algorithm
  * @param stream Pointer to data stream for checksum calculation
  * @param check_sum Pointer to stucture, that contains calculated checksum
  * @return If checksum calculated, then return SC_TRUE; otherwise return SC_FALSE
  */
 sc_bool sc_link_calculate_checksum(const sc_stream *stream, sc_check_sum *check_sum);
 
+/*! Caclulates checksum for data in stream by specified algorithm
+ * @see sc_link_calculate_checksum
+ */
+sc_bool sc_link_calculate_checksum_by(const sc_stream *stream, sc_checksum_algorithm algorithm, sc_check_sum *check_sum);
+
 
 /*! Calculates checksum for sc-link, when it is self container for it's data
- * @param el Pointer to sc-link
+ * @param content Pointer to content of sc-link
  * @param sum Pointer to checksum structure to contain result
  * @return If checksum calculated, then return SC_TRUE; otherwise return SC_FALSE
  */
-sc_bool sc_link_self_container_calculate_checksum(sc_element *el, sc_check_sum *sum);
+sc_bool sc_link_self_container_calculate_checksum(sc_content const *content, sc_check_sum *sum);
+
+/*! Gets checksum, that is stored in content of sc-link (it isn't self container). Checksum format
+ * (legacy or binary) is detected by its first byte
+ */
+void sc_link_checksum_from_content(sc_content const *content, sc_check_sum *sum);
+
+//! Returns SC_TRUE, if \p sum is a binary checksum
+_SC_EXTERN sc_bool sc_link_checksum_is_binary(const sc_check_sum *sum);
+
+/*! Makes printable string from checksum: binary checksums are encoded in hex, legacy ones are copied as is
+ * @param str Pointer to buffer of SC_CHECKSUM_STRING_SIZE bytes
+ * @return Returns length of string
+ */
+_SC_EXTERN sc_uint32 sc_link_checksum_to_string(const sc_check_sum *sum, sc_char *str);
+
+/*! Compares data of two streams. Both streams are read from the begin
+ * @return Returns SC_TRUE, if streams contain the same data; otherwise returns SC_FALSE
+ */
+sc_bool sc_link_streams_equal(const sc_stream *stream1, const sc_stream *stream2);
 
 
 #endif
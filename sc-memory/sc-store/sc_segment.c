@@ -14,6 +14,74 @@
 #define MAX_LOCK_SLEEP      10 // microseconds
 #define LOCK_SLEEP() //{ g_usleep(g_random_int() % MAX_LOCK_SLEEP); }
 
+// page of element with specified offset and position of element in page
+#define SC_SEGMENT_PAGE(offset)         (((offset) % SC_CONCURRENCY_LEVEL) * SC_SEGMENT_SECTION_PAGES + ((offset) / SC_CONCURRENCY_LEVEL) / SC_SEGMENT_PAGE_SIZE)
+#define SC_SEGMENT_PAGE_POS(offset)     (((offset) / SC_CONCURRENCY_LEVEL) % SC_SEGMENT_PAGE_SIZE)
+// offset of element in specified position of page
+#define SC_SEGMENT_PAGE_OFFSET(page, pos) ((((page) % SC_SEGMENT_SECTION_PAGES) * SC_SEGMENT_PAGE_SIZE + (pos)) * SC_CONCURRENCY_LEVEL + (page) / SC_SEGMENT_SECTION_PAGES)
+
+//! Allocates page of elements. If other thread allocated it meanwhile, then returns its page
+sc_element* _sc_segment_page_alloc(sc_segment *seg, sc_uint32 page)
+{
+    sc_element *elements = g_new0(sc_element, SC_SEGMENT_PAGE_SIZE);
+
+    if (g_atomic_pointer_compare_and_exchange(&seg->pages[page], null_ptr, elements) == FALSE)
+    {
+        g_free(elements);
+        return g_atomic_pointer_get(&seg->pages[page]);
+    }
+
+    g_atomic_int_inc(&seg->pages_count);
+    return elements;
+}
+
+//! Allocates page of elements meta info. If other thread allocated it meanwhile, then returns its page
+sc_element_meta* _sc_segment_meta_page_alloc(sc_segment *seg, sc_uint32 page)
+{
+    sc_element_meta *meta = g_new0(sc_element_meta, SC_SEGMENT_PAGE_SIZE);
+
+    if (g_atomic_pointer_compare_and_exchange(&seg->meta_pages[page], null_ptr, meta) == FALSE)
+    {
+        g_free(meta);
+        return g_atomic_pointer_get(&seg->meta_pages[page]);
+    }
+
+    return meta;
+}
+
+//! Allocates page of contents. If other thread allocated it meanwhile, then returns its page
+sc_content* _sc_segment_content_page_alloc(sc_segment *seg, sc_uint32 page)
+{
+    sc_content *contents = g_new0(sc_content, SC_SEGMENT_PAGE_SIZE);
+
+    if (g_atomic_pointer_compare_and_exchange(&seg->content_pages[page], null_ptr, contents) == FALSE)
+    {
+        g_free(contents);
+        return g_atomic_pointer_get(&seg->content_pages[page]);
+    }
+
+    return contents;
+}
+
+// states of external memory check
+#define SC_SEGMENT_EXTERNAL_CHECKED     0
+#define SC_SEGMENT_EXTERNAL_UNCHECKED   1
+#define SC_SEGMENT_EXTERNAL_CHECKING    2
+
+// external memory of segment is checked before the first access to it
+#define SC_SEGMENT_EXTERNAL_ACCESS(seg) { if (g_atomic_int_get(&(seg)->external_state) != SC_SEGMENT_EXTERNAL_CHECKED) sc_segment_check_external(seg); }
+
+//! Returns type of sc-element without page allocation. Elements of not allocated pages are empty
+sc_type _sc_segment_element_type(sc_segment *seg, sc_uint32 offset)
+{
+    SC_SEGMENT_EXTERNAL_ACCESS(seg);
+    if (seg->elements_external != null_ptr)
+        return seg->elements_external[offset].flags.type;
+
+    sc_element const *page = g_atomic_pointer_get(&seg->pages[SC_SEGMENT_PAGE(offset)]);
+    return page == null_ptr ? 0 : page[SC_SEGMENT_PAGE_POS(offset)].flags.type;
+}
+
 sc_segment* sc_segment_new(sc_addr_seg num)
 {
     sc_segment *segment = g_new0(sc_segment, 1);
@@ -25,7 +93,7 @@ sc_segment* sc_segment_new(sc_addr_seg num)
     {
         sc_segment_section *section = &(segment->sections[i]);
         section->empty_offset = i;
-        section->empty_count = ((c + i) <= SC_SEGMENT_ELEMENTS_COUNT) ? count + 1 : count;
+        section->empty_count = ((c + i) < SC_SEGMENT_ELEMENTS_COUNT) ? count + 1 : count;
     }
 
     if (num == 0)
@@ -34,11 +102,58 @@ sc_segment* sc_segment_new(sc_addr_seg num)
         segment->sections[0].empty_count--;
     }
 
+    segment->num = num;
+    segment->dirty = 1;
+
+    return segment;
+}
+
+sc_segment* sc_segment_new_external(sc_addr_seg num, sc_element *elements, sc_content *contents)
+{
+    g_assert(elements != null_ptr && contents != null_ptr);
+    sc_segment *segment = g_new0(sc_segment, 1);
+
+    segment->elements_external = elements;
+    segment->contents_external = contents;
     segment->num = num;
 
     return segment;
 }
 
+void sc_segment_set_external_check(sc_segment *seg, sc_segment_check_func func)
+{
+    g_assert(seg->elements_external != null_ptr && func != null_ptr);
+    seg->external_check = func;
+    g_atomic_int_set(&seg->external_state, SC_SEGMENT_EXTERNAL_UNCHECKED);
+}
+
+void sc_segment_check_external(sc_segment *seg)
+{
+    while (g_atomic_int_get(&seg->external_state) != SC_SEGMENT_EXTERNAL_CHECKED)
+    {
+        if (g_atomic_int_compare_and_exchange(&seg->external_state, SC_SEGMENT_EXTERNAL_UNCHECKED, SC_SEGMENT_EXTERNAL_CHECKING) == FALSE)
+        {
+            g_thread_yield();
+            continue;
+        }
+
+        // damaged memory is refused, so segment uses empty pages instead of it
+        if (seg->external_check(seg) == SC_FALSE)
+        {
+            seg->elements_external = null_ptr;
+            seg->contents_external = null_ptr;
+            g_atomic_int_set(&seg->elements_count, 0);
+        }
+
+        g_atomic_int_set(&seg->external_state, SC_SEGMENT_EXTERNAL_CHECKED);
+    }
+}
+
+sc_bool sc_segment_is_external_checked(sc_segment *seg)
+{
+    return (g_atomic_int_get(&seg->external_state) == SC_SEGMENT_EXTERNAL_CHECKED) ? SC_TRUE : SC_FALSE;
+}
+
 void sc_segment_loaded(sc_segment * seg)
 {
     sc_uint32 i;
@@ -50,12 +165,14 @@ void sc_segment_loaded(sc_segment * seg)
         sc_uint32 idx = i;
 
         section->empty_count = 0;
+        section->empty_offset = i;
         while (idx < SC_SEGMENT_ELEMENTS_COUNT)
         {
-            if (seg->elements[idx].flags.type == 0)
+            if (_sc_segment_element_type(seg, idx) == 0 && (idx != 0 || seg->num != 0))
             {
-                ++section->empty_count;
-                section->empty_offset = idx;
+                // the first empty element, so sc-elements are allocated from the first pages
+                if (section->empty_count++ == 0)
+                    section->empty_offset = idx;
             }
             else
                 ++seg->elements_count;
@@ -66,8 +183,15 @@ void sc_segment_loaded(sc_segment * seg)
 
 void sc_segment_free(sc_segment *segment)
 {
+    sc_uint32 i;
     g_assert( segment != 0);
 
+    for (i = 0; i < SC_SEGMENT_PAGES_COUNT; ++i)
+    {
+        g_free(segment->pages[i]);
+        g_free(segment->meta_pages[i]);
+        g_free(segment->content_pages[i]);
+    }
     g_free(segment);
 }
 
@@ -78,13 +202,147 @@ void sc_segment_erase_element(sc_segment *seg, sc_uint16 offset)
 
     g_assert( seg != (sc_segment*)0 );
     g_assert( offset < SC_SEGMENT_ELEMENTS_COUNT );
-    memset(&seg->elements[offset], 0, sizeof(sc_element));
+    memset(sc_segment_get_element(seg, offset), 0, sizeof(sc_element));
+    sc_segment_clear_content(seg, offset);
 
     sc_segment_section *section = &(seg->sections[offset % SC_CONCURRENCY_LEVEL]);
     g_atomic_int_inc(&section->empty_count);
     g_atomic_int_set(&section->empty_offset, offset);
 
     g_assert(offset != 0 || seg->num != 0);
+
+    sc_segment_set_dirty(seg);
+}
+
+sc_element* sc_segment_get_element(sc_segment *seg, sc_addr_offset offset)
+{
+    sc_uint32 const page = SC_SEGMENT_PAGE(offset);
+    sc_element *elements;
+
+    g_assert(offset < SC_SEGMENT_ELEMENTS_COUNT);
+    SC_SEGMENT_EXTERNAL_ACCESS(seg);
+    if (seg->elements_external != null_ptr)
+        return &seg->elements_external[offset];
+
+    elements = g_atomic_pointer_get(&seg->pages[page]);
+    if (elements == null_ptr)
+        elements = _sc_segment_page_alloc(seg, page);
+
+    return &elements[SC_SEGMENT_PAGE_POS(offset)];
+}
+
+sc_content* sc_segment_get_content(sc_segment *seg, sc_addr_offset offset)
+{
+    sc_uint32 const page = SC_SEGMENT_PAGE(offset);
+    sc_content *contents;
+
+    g_assert(offset < SC_SEGMENT_ELEMENTS_COUNT);
+    SC_SEGMENT_EXTERNAL_ACCESS(seg);
+    if (seg->contents_external != null_ptr)
+        return &seg->contents_external[offset];
+
+    contents = g_atomic_pointer_get(&seg->content_pages[page]);
+    if (contents == null_ptr)
+        contents = _sc_segment_content_page_alloc(seg, page);
+
+    return &contents[SC_SEGMENT_PAGE_POS(offset)];
+}
+
+void sc_segment_clear_content(sc_segment *seg, sc_addr_offset offset)
+{
+    sc_content *contents;
+
+    SC_SEGMENT_EXTERNAL_ACCESS(seg);
+    if (seg->contents_external != null_ptr)
+    {
+        memset(&seg->contents_external[offset], 0, sizeof(sc_content));
+        return;
+    }
+
+    contents = g_atomic_pointer_get(&seg->content_pages[SC_SEGMENT_PAGE(offset)]);
+    if (contents != null_ptr)
+        memset(&contents[SC_SEGMENT_PAGE_POS(offset)], 0, sizeof(sc_content));
+}
+
+void sc_segment_copy_elements(sc_segment *seg, sc_element *buffer, sc_content *contents)
+{
+    sc_uint32 i, j, offset;
+
+    SC_SEGMENT_EXTERNAL_ACCESS(seg);
+    if (seg->elements_external != null_ptr)
+    {
+        memcpy(buffer, seg->elements_external, SC_SEG_ELEMENTS_SIZE_BYTE);
+        memcpy(contents, seg->contents_external, SC_SEG_CONTENTS_SIZE_BYTE);
+        return;
+    }
+
+    memset(buffer, 0, SC_SEG_ELEMENTS_SIZE_BYTE);
+    memset(contents, 0, SC_SEG_CONTENTS_SIZE_BYTE);
+    for (i = 0; i < SC_SEGMENT_PAGES_COUNT; ++i)
+    {
+        sc_element const *page = g_atomic_pointer_get(&seg->pages[i]);
+        sc_content const *content_page = g_atomic_pointer_get(&seg->content_pages[i]);
+
+        for (j = 0; j < SC_SEGMENT_PAGE_SIZE && (offset = SC_SEGMENT_PAGE_OFFSET(i, j)) < SC_SEGMENT_ELEMENTS_COUNT; ++j)
+        {
+            if (page != null_ptr)
+                buffer[offset] = page[j];
+            if (content_page != null_ptr)
+                contents[offset] = content_page[j];
+        }
+    }
+}
+
+void sc_segment_set_elements(sc_segment *seg, sc_element const *buffer, sc_content const *contents)
+{
+    sc_uint32 i, j, offset;
+
+    g_assert(seg->elements_external == null_ptr);
+    for (i = 0; i < SC_SEGMENT_PAGES_COUNT; ++i)
+    {
+        sc_element *page = seg->pages[i];
+        sc_content *content_page = seg->content_pages[i];
+
+        // pages without sc-elements aren't allocated, and pages of contents are allocated just for sc-links
+        for (j = 0; j < SC_SEGMENT_PAGE_SIZE && (offset = SC_SEGMENT_PAGE_OFFSET(i, j)) < SC_SEGMENT_ELEMENTS_COUNT; ++j)
+        {
+            if (page == null_ptr && buffer[offset].flags.type != 0)
+                page = _sc_segment_page_alloc(seg, i);
+            if (content_page == null_ptr && (buffer[offset].flags.type & sc_type_link))
+                content_page = _sc_segment_content_page_alloc(seg, i);
+        }
+
+        for (j = 0; j < SC_SEGMENT_PAGE_SIZE && (offset = SC_SEGMENT_PAGE_OFFSET(i, j)) < SC_SEGMENT_ELEMENTS_COUNT; ++j)
+        {
+            if (page != null_ptr)
+                page[j] = buffer[offset];
+            if (content_page != null_ptr)
+                content_page[j] = contents[offset];
+        }
+    }
+}
+
+sc_uint32 sc_segment_get_pages_count(sc_segment *seg)
+{
+    g_assert(seg != null_ptr);
+
+    return g_atomic_int_get(&seg->pages_count);
+}
+
+void sc_segment_set_dirty(sc_segment *seg)
+{
+    g_assert(seg != null_ptr);
+
+    // skip write, when flag already set, to keep cache line shared between readers
+    if (g_atomic_int_get(&seg->dirty) == 0)
+        g_atomic_int_set(&seg->dirty, 1);
+}
+
+sc_bool sc_segment_reset_dirty(sc_segment *seg)
+{
+    g_assert(seg != null_ptr);
+
+    return g_atomic_int_compare_and_exchange(&seg->dirty, 1, 0) ? SC_TRUE : SC_FALSE;
 }
 
 sc_uint32 sc_segment_get_elements_count(sc_segment *seg)
@@ -113,7 +371,7 @@ void sc_segment_collect_elements_stat(const sc_memory_context *ctx, sc_segment *
         sc_int32 j = i;
         while (j < SC_SEGMENT_ELEMENTS_COUNT)
         {
-            sc_type type = seg->elements[j].flags.type;
+            sc_type type = _sc_segment_element_type(seg, j);
             if (type & sc_type_node)
                 stat->node_count++;
             else
@@ -146,10 +404,133 @@ sc_element_meta* sc_segment_get_meta(const sc_memory_context *ctx, sc_segment *
     g_assert(seg->sections[offset % SC_CONCURRENCY_LEVEL].ctx_lock == ctx);
     g_assert(offset < SC_SEGMENT_ELEMENTS_COUNT);
 
-    return &seg->meta[offset];
+    sc_uint32 const page = SC_SEGMENT_PAGE(offset);
+    sc_element_meta *meta = g_atomic_pointer_get(&seg->meta_pages[page]);
+    if (meta == null_ptr)
+        meta = _sc_segment_meta_page_alloc(seg, page);
+
+    return &meta[SC_SEGMENT_PAGE_POS(offset)];
+}
+
+sc_uint32 sc_segment_get_events_mask(sc_segment *seg, sc_addr_offset offset)
+{
+    g_assert(seg != null_ptr && offset < SC_SEGMENT_ELEMENTS_COUNT);
+
+    sc_element_meta *meta = g_atomic_pointer_get(&seg->meta_pages[SC_SEGMENT_PAGE(offset)]);
+    if (meta == null_ptr)
+        return 0;
+
+    return (sc_uint32)g_atomic_int_get((gint*)&meta[SC_SEGMENT_PAGE_POS(offset)].events_mask);
+}
+
+sc_bool sc_segment_get_degree(sc_segment *seg, sc_addr_offset offset, sc_uint32 *out_degree, sc_uint32 *in_degree)
+{
+    g_assert(seg != null_ptr && offset < SC_SEGMENT_ELEMENTS_COUNT);
+
+    sc_element_meta *meta = g_atomic_pointer_get(&seg->meta_pages[SC_SEGMENT_PAGE(offset)]);
+    if (meta == null_ptr || g_atomic_int_get((gint*)&meta[SC_SEGMENT_PAGE_POS(offset)].degree_counted) == 0)
+        return SC_FALSE;
+
+    *out_degree = (sc_uint32)g_atomic_int_get((gint*)&meta[SC_SEGMENT_PAGE_POS(offset)].out_degree);
+    *in_degree = (sc_uint32)g_atomic_int_get((gint*)&meta[SC_SEGMENT_PAGE_POS(offset)].in_degree);
+
+    return SC_TRUE;
+}
+
+void sc_segment_add_events_mask(sc_segment *seg, sc_addr_offset offset, sc_uint32 bits)
+{
+    g_assert(seg != null_ptr && offset < SC_SEGMENT_ELEMENTS_COUNT);
+
+    sc_uint32 const page = SC_SEGMENT_PAGE(offset);
+    sc_element_meta *meta = g_atomic_pointer_get(&seg->meta_pages[page]);
+    if (meta == null_ptr)
+        meta = _sc_segment_meta_page_alloc(seg, page);
+
+    g_atomic_int_or((guint*)&meta[SC_SEGMENT_PAGE_POS(offset)].events_mask, (guint)bits);
+}
+
+void sc_segment_remove_events_mask(sc_segment *seg, sc_addr_offset offset, sc_uint32 bits)
+{
+    g_assert(seg != null_ptr && offset < SC_SEGMENT_ELEMENTS_COUNT);
+
+    sc_element_meta *meta = g_atomic_pointer_get(&seg->meta_pages[SC_SEGMENT_PAGE(offset)]);
+    // there are no subscriptions on elements of page
+    if (meta == null_ptr)
+        return;
+
+    g_atomic_int_and((guint*)&meta[SC_SEGMENT_PAGE_POS(offset)].events_mask, ~(guint)bits);
 }
 
 // ---------------------------
+/*! Takes empty element from locked section. Returns SC_FALSE, if there are no empty elements in section.
+ * Section hint (empty_offset) moves to the next empty element.
+ */
+sc_bool _sc_segment_section_take_empty(sc_segment *seg, sc_uint32 sec_id, sc_addr_offset *offset)
+{
+    sc_segment_section *section = &seg->sections[sec_id];
+    sc_int32 const first = (sec_id == 0 && seg->num == 0) ? SC_CONCURRENCY_LEVEL : (sc_int32)sec_id;
+    sc_int32 idx = (sc_int32)g_atomic_int_get(&section->empty_offset);
+    sc_int32 j;
+
+    if (g_atomic_int_get(&section->empty_count) <= 0)
+        return SC_FALSE;
+
+    g_assert(idx >= 0 && idx < SC_SEGMENT_ELEMENTS_COUNT);
+
+    // hint can be out of date, so find any empty element in section
+    if (idx < first || _sc_segment_element_type(seg, idx) != 0)
+    {
+        idx = -1;
+        for (j = first; j < SC_SEGMENT_ELEMENTS_COUNT; j += SC_CONCURRENCY_LEVEL)
+        {
+            if (_sc_segment_element_type(seg, j) == 0)
+            {
+                idx = j;
+                break;
+            }
+        }
+
+        if (idx < 0)
+        {
+            g_atomic_int_set(&section->empty_count, 0);
+            return SC_FALSE;
+        }
+    }
+
+    g_atomic_int_inc(&seg->elements_count);
+    if (g_atomic_int_dec_and_test(&section->empty_count) == FALSE)
+    {
+        // need to find new empty element
+        for (j = idx + SC_CONCURRENCY_LEVEL; j < SC_SEGMENT_ELEMENTS_COUNT; j += SC_CONCURRENCY_LEVEL)
+        {
+            if (_sc_segment_element_type(seg, j) == 0)
+                goto found;
+        }
+        for (j = idx - SC_CONCURRENCY_LEVEL; j >= first; j -= SC_CONCURRENCY_LEVEL)
+        {
+            if (_sc_segment_element_type(seg, j) == 0)
+                goto found;
+        }
+        // counter was out of date
+        g_atomic_int_set(&section->empty_count, 0);
+        goto result;
+
+        found:
+        {
+            g_atomic_int_set(&section->empty_offset, j);
+        }
+    }
+
+    result:
+    {
+        g_assert(seg->num + idx > 0);   // not empty addr
+        *offset = idx;
+        sc_segment_set_dirty(seg);
+    }
+
+    return SC_TRUE;
+}
+
 sc_element* sc_segment_lock_empty_element(const sc_memory_context *ctx, sc_segment *seg, sc_addr_offset *offset)
 {
     sc_uint16 max_attempts = 1;
@@ -164,60 +545,13 @@ sc_element* sc_segment_lock_empty_element(const sc_memory_context *ctx, sc_segme
             if (g_atomic_int_get(&section->empty_count) == 0)
                 continue;
 
-            sc_bool locked = sc_segment_section_lock_try(ctx, section, 1);
-
-            if (locked == SC_TRUE)
+            if (sc_segment_section_lock_try(ctx, section, max_attempts) == SC_TRUE)
             {
-                sc_int32 idx = (sc_int32)section->empty_offset;
-
-                if (section->empty_count > 0)
-                {
-                    g_atomic_int_inc(&seg->elements_count);
-                    g_atomic_int_add(&section->empty_count, -1);
-
-                    // trying to find empty element in section
-                    g_assert(idx >= 0 && idx < SC_SEGMENT_ELEMENTS_COUNT);
-                    g_assert(seg->num + idx > 0);   // not empty addr
-
-                    // need to find new empty element
-                    sc_int32 j = idx + SC_CONCURRENCY_LEVEL;
-                    while (j < SC_SEGMENT_ELEMENTS_COUNT)
-                    {
-                        if (seg->elements[j].flags.type == 0)
-                        {
-                            g_atomic_int_set(&section->empty_offset, j);
-                            g_assert(seg->num + j > 0);
-                            goto result;
-                        }
-                        j += SC_CONCURRENCY_LEVEL;
-                    }
-                    j = idx - SC_CONCURRENCY_LEVEL;
-                    sc_int left = (i == 0 && seg->num == 0) ? SC_CONCURRENCY_LEVEL : idx;
-                    while (j >= left)
-                    {
-                        if (seg->elements[j].flags.type == 0)
-                        {
-                            g_atomic_int_set(&section->empty_offset, j);
-                            g_assert(seg->num + j > 0);
-                            goto result;
-                        }
-
-                        j -= SC_CONCURRENCY_LEVEL;
-                    }
-
-                }
+                if (_sc_segment_section_take_empty(seg, sec_id, offset) == SC_TRUE)
+                    return sc_segment_get_element(seg, *offset);
 
                 sc_segment_section_unlock(ctx, section);
-                continue;
-
-                result:
-                {
-                    g_assert(g_atomic_int_get(&section->empty_count) >= 0);
-                    *offset = idx;
-                    return &seg->elements[*offset];
-                }
             }
-
         }
 
         if (max_attempts < SC_CONCURRENCY_LEVEL)
@@ -229,12 +563,51 @@ sc_element* sc_segment_lock_empty_element(const sc_memory_context *ctx, sc_segme
     return null_ptr;
 }
 
+sc_element* sc_segment_section_lock_empty_element(const sc_memory_context *ctx, sc_segment *seg, sc_uint32 sec_id, sc_addr_offset *offset)
+{
+    g_assert(sec_id < SC_CONCURRENCY_LEVEL);
+    sc_segment_section *section = &seg->sections[sec_id];
+
+    if (g_atomic_int_get(&section->empty_count) <= 0)
+        return null_ptr;
+
+    sc_segment_section_lock(ctx, section);
+    if (_sc_segment_section_take_empty(seg, sec_id, offset) == SC_TRUE)
+        return sc_segment_get_element(seg, *offset);
+
+    sc_segment_section_unlock(ctx, section);
+    return null_ptr;
+}
+
+sc_uint32 sc_segment_section_lock_empty_elements(const sc_memory_context *ctx, sc_segment *seg, sc_uint32 sec_id, sc_addr_offset *offsets, sc_uint32 count)
+{
+    g_assert(sec_id < SC_CONCURRENCY_LEVEL);
+    sc_segment_section *section = &seg->sections[sec_id];
+    sc_uint32 taken = 0;
+
+    if (g_atomic_int_get(&section->empty_count) <= 0)
+        return 0;
+
+    sc_segment_section_lock(ctx, section);
+    while (taken < count && _sc_segment_section_take_empty(seg, sec_id, &offsets[taken]) == SC_TRUE)
+    {
+        // taken element isn't empty anymore, so search of the next one doesn't find it again
+        sc_segment_get_element(seg, offsets[taken])->flags.type = sc_flag_reserved;
+        ++taken;
+    }
+
+    if (taken == 0)
+        sc_segment_section_unlock(ctx, section);
+
+    return taken;
+}
+
 sc_element* sc_segment_lock_element(const sc_memory_context *ctx, sc_segment *seg, sc_addr_offset offset)
 {
     g_assert(offset < SC_SEGMENT_ELEMENTS_COUNT && seg != null_ptr);
     sc_segment_section *section = &seg->sections[offset % SC_CONCURRENCY_LEVEL];
     sc_segment_section_lock(ctx, section);
-    return &seg->elements[offset];
+    return sc_segment_get_element(seg, offset);
 }
 
 sc_element* sc_segment_lock_element_try(const sc_memory_context *ctx, sc_segment *seg, sc_addr_offset offset, sc_uint16 max_attempts)
@@ -243,7 +616,7 @@ sc_element* sc_segment_lock_element_try(const sc_memory_context *ctx, sc_segment
     sc_segment_section *section = &seg->sections[offset % SC_CONCURRENCY_LEVEL];
 
     if (sc_segment_section_lock_try(ctx, section, max_attempts) == SC_TRUE)
-        return &seg->elements[offset];
+        return sc_segment_get_element(seg, offset);
 
     return (sc_element*)0;
 }
@@ -268,9 +641,14 @@ void sc_segment_section_lock(const sc_memory_context *ctx, sc_segment_section *s
     if (g_atomic_pointer_get(&section->ctx_lock) != 0 && g_atomic_pointer_get(&section->ctx_lock) != ctx)
     {
         g_atomic_int_set(&section->internal_lock, 0);
+        // section can be held for a long time (deletion locks many of them), so give owner a chance to finish
+        g_thread_yield();
         goto lock;
     }
 
+    // section becomes locked, so optimistic reads of its elements fail until it's unlocked
+    if (g_atomic_int_get(&section->lock_count) == 0)
+        g_atomic_int_inc(&section->version);
     g_atomic_pointer_set(&section->ctx_lock, ctx);
     g_atomic_int_inc(&section->lock_count);
 
@@ -300,6 +678,9 @@ sc_bool sc_segment_section_lock_try(const sc_memory_context *ctx, sc_segment_sec
         goto lock;
     }
 
+    // section becomes locked, so optimistic reads of its elements fail until it's unlocked
+    if (g_atomic_int_get(&section->lock_count) == 0)
+        g_atomic_int_inc(&section->version);
     g_atomic_pointer_set(&section->ctx_lock, ctx);
     g_atomic_int_inc(&section->lock_count);
 
@@ -320,11 +701,49 @@ void sc_segment_section_unlock(const sc_memory_context *ctx, sc_segment_section
     g_assert(g_atomic_pointer_get(&section->ctx_lock) == ctx);
 
     if (g_atomic_int_dec_and_test(&section->lock_count) == TRUE)
+    {
+        g_atomic_int_inc(&section->version);
         g_atomic_pointer_set(&section->ctx_lock, 0);
+    }
 
     g_atomic_int_set(&section->internal_lock, 0);
 }
 
+sc_bool sc_segment_read_element(sc_segment *seg, sc_addr_offset offset, sc_element *el, sc_uint32 *version)
+{
+    sc_segment_section *section;
+    sc_element const *page;
+
+    g_assert(offset < SC_SEGMENT_ELEMENTS_COUNT && seg != null_ptr);
+    section = &seg->sections[offset % SC_CONCURRENCY_LEVEL];
+
+    // atomic get is a full barrier, so element is copied between two reads of version
+    *version = (sc_uint32)g_atomic_int_get(&section->version);
+    if (*version & 1)
+        return SC_FALSE;
+
+    SC_SEGMENT_EXTERNAL_ACCESS(seg);
+    if (seg->elements_external != null_ptr)
+        *el = seg->elements_external[offset];
+    else
+    {
+        // page isn't allocated by readers, elements of not allocated pages are empty
+        page = g_atomic_pointer_get(&seg->pages[SC_SEGMENT_PAGE(offset)]);
+        if (page != null_ptr)
+            *el = page[SC_SEGMENT_PAGE_POS(offset)];
+        else
+            memset(el, 0, sizeof(sc_element));
+    }
+
+    return ((sc_uint32)g_atomic_int_get(&section->version) == *version) ? SC_TRUE : SC_FALSE;
+}
+
+sc_bool sc_segment_validate_element(sc_segment *seg, sc_addr_offset offset, sc_uint32 version)
+{
+    g_assert(offset < SC_SEGMENT_ELEMENTS_COUNT && seg != null_ptr);
+    return ((sc_uint32)g_atomic_int_get(&seg->sections[offset % SC_CONCURRENCY_LEVEL].version) == version) ? SC_TRUE : SC_FALSE;
+}
+
 void sc_segment_lock(sc_segment * seg, sc_memory_context const * ctx)
 {
     sc_uint32 i;
@@ -339,3 +758,43 @@ void sc_segment_unlock(sc_segment * seg, sc_memory_context const * ctx)
         sc_segment_section_unlock(ctx, &seg->sections[i]);
 }
 
+// ---------------------------
+sc_segment_table* sc_segment_table_new()
+{
+    return g_new0(sc_segment_table, 1);
+}
+
+void sc_segment_table_free(sc_segment_table *table)
+{
+    sc_uint32 i;
+    g_assert(table != null_ptr);
+
+    for (i = 0; i < SC_SEGMENT_TABLE_BLOCKS_COUNT; ++i)
+        g_free(table->blocks[i]);
+    g_free(table);
+}
+
+sc_segment* sc_segment_table_get(sc_segment_table const *table, sc_addr_seg num)
+{
+    sc_segment **block = g_atomic_pointer_get(&table->blocks[num / SC_SEGMENT_TABLE_BLOCK_SIZE]);
+
+    return block == null_ptr ? null_ptr : g_atomic_pointer_get(&block[num % SC_SEGMENT_TABLE_BLOCK_SIZE]);
+}
+
+void sc_segment_table_set(sc_segment_table *table, sc_addr_seg num, sc_segment *seg)
+{
+    sc_uint32 const idx = num / SC_SEGMENT_TABLE_BLOCK_SIZE;
+    sc_segment **block = g_atomic_pointer_get(&table->blocks[idx]);
+
+    if (block == null_ptr)
+    {
+        block = g_new0(sc_segment*, SC_SEGMENT_TABLE_BLOCK_SIZE);
+        if (g_atomic_pointer_compare_and_exchange(&table->blocks[idx], null_ptr, block) == FALSE)
+        {
+            g_free(block);
+            block = g_atomic_pointer_get(&table->blocks[idx]);
+        }
+    }
+
+    g_atomic_pointer_set(&block[num % SC_SEGMENT_TABLE_BLOCK_SIZE], seg);
+}
@@ -14,6 +14,22 @@
 #include <glib.h>
 
 #define SC_SEG_ELEMENTS_SIZE_BYTE (sizeof(sc_element) * SC_SEGMENT_ELEMENTS_COUNT)
+#define SC_SEG_CONTENTS_SIZE_BYTE (sizeof(sc_content) * SC_SEGMENT_ELEMENTS_COUNT)
+//! Size of segment data: array of elements, that is followed by array of sc-links contents
+#define SC_SEG_DATA_SIZE_BYTE     (SC_SEG_ELEMENTS_SIZE_BYTE + SC_SEG_CONTENTS_SIZE_BYTE)
+
+/* Segment memory is allocated by pages on first usage, so segment with a few sc-elements doesn't take memory
+ * for the whole segment. Page contains elements of one section, because context allocates sc-elements
+ * in its own section, so sequentially allocated sc-elements are stored in the same pages
+ */
+#define SC_SEGMENT_PAGE_SIZE            256
+#define SC_SEGMENT_SECTION_ELEMENTS     ((SC_SEGMENT_ELEMENTS_COUNT + SC_CONCURRENCY_LEVEL - 1) / SC_CONCURRENCY_LEVEL)
+#define SC_SEGMENT_SECTION_PAGES        ((SC_SEGMENT_SECTION_ELEMENTS + SC_SEGMENT_PAGE_SIZE - 1) / SC_SEGMENT_PAGE_SIZE)
+#define SC_SEGMENT_PAGES_COUNT          (SC_SEGMENT_SECTION_PAGES * SC_CONCURRENCY_LEVEL)
+
+//! Number of segments in one block of segments table
+#define SC_SEGMENT_TABLE_BLOCK_SIZE     1024
+#define SC_SEGMENT_TABLE_BLOCKS_COUNT   ((SC_SEGMENT_MAX + SC_SEGMENT_TABLE_BLOCK_SIZE) / SC_SEGMENT_TABLE_BLOCK_SIZE)
 
 //! Structure to store segment locks
 typedef struct _sc_segment_section
@@ -23,17 +39,33 @@ typedef struct _sc_segment_section
     sc_int empty_offset;                    // use 32-bit value for atomic operations
     sc_int internal_lock;                   //
     sc_int lock_count;                      // count of recursive locks
+    sc_int version;                         // odd, while section is locked; changed on each lock and unlock (see sc_segment_read_element)
+    const sc_memory_context *slab_ctx;      // pointer to context, that reserved section to allocate sc-elements
 } sc_segment_section;
 
+/*! Function, that checks external memory of segment (see sc_segment_set_external_check)
+ * @returns Returns SC_FALSE, if memory is damaged
+ */
+typedef sc_bool (*sc_segment_check_func)(sc_segment *seg);
+
 /*! Structure for segment storing
  */
 struct _sc_segment
 {
-    sc_element_meta meta[SC_SEGMENT_ELEMENTS_COUNT];
-    sc_element elements[SC_SEGMENT_ELEMENTS_COUNT];
+    sc_element *pages[SC_SEGMENT_PAGES_COUNT];          // pages of elements, null - page isn't allocated (all its elements are empty)
+    sc_element_meta *meta_pages[SC_SEGMENT_PAGES_COUNT];    // pages of elements meta info, null - page isn't allocated
+    sc_content *content_pages[SC_SEGMENT_PAGES_COUNT];      // pages of sc-links contents, null - page has no sc-links with content
+    sc_element *elements_external;  // array of all elements, that isn't owned by segment (for example mapped from file). Pages aren't used with it
+    sc_content *contents_external;  // array of all contents, that isn't owned by segment. It's used with elements_external
+    sc_segment_check_func external_check;   // function to check external memory on first usage
+    sc_int32 external_state;    // state of external memory check: 0 - checked, 1 - not checked, 2 - is checking
+    sc_uint32 pages_count;      // number of allocated pages of elements
     sc_addr_seg num;            // number of this segment in memory
     sc_segment_section sections[SC_CONCURRENCY_LEVEL];
     sc_uint elements_count;   // number of sc-element in the segment
+    sc_uint32 free_next;        // number + 1 of next segment in list of segments with empty slots (0 - end of list)
+    sc_int32 in_free_list;      // non zero, if segment is in list of segments with empty slots
+    sc_int32 dirty;             // non zero, if elements were changed since segment was saved
 };
 
 /*! Create new segment with specified size.
@@ -41,6 +73,25 @@ struct _sc_segment
  */
 sc_segment* sc_segment_new(sc_addr_seg num);
 
+/*! Create segment, that uses external memory for elements. Memory isn't freed with segment.
+ * @param num Number of created intance in sc-memory
+ * @param elements Pointer to array of SC_SEGMENT_ELEMENTS_COUNT elements (for example mapped from file)
+ * @param contents Pointer to array of SC_SEGMENT_ELEMENTS_COUNT contents of sc-links
+ * @note Sections statistics should be setup after creation (see sc_segment_loaded)
+ */
+sc_segment* sc_segment_new_external(sc_addr_seg num, sc_element *elements, sc_content *contents);
+
+/*! Sets function, that checks external memory of segment before its first usage. So segment memory isn't read
+ * until segment is used or checked by sc_segment_check_external. If memory is damaged, then segment refuses it
+ * and its sc-elements are empty
+ */
+void sc_segment_set_external_check(sc_segment *seg, sc_segment_check_func func);
+
+//! Checks external memory of segment, if it wasn't checked yet. Waits, while other thread checks it
+void sc_segment_check_external(sc_segment *seg);
+//! Returns SC_TRUE, if external memory of segment is checked or segment doesn't use it
+sc_bool sc_segment_is_external_checked(sc_segment *seg);
+
 //! Need to be called after segment data loaded. This function update all meta info that need to coorect work (sections empty offsets, and others)
 void sc_segment_loaded(sc_segment * seg);
 
@@ -49,6 +100,33 @@ void sc_segment_free(sc_segment *segment);
 //! Remove element from specified segment. @note sc-element need to be locked
 void sc_segment_erase_element(sc_segment *seg, sc_uint16 offset);
 
+/*! Returns pointer to sc-element with specified offset. Page of sc-element is allocated, if it wasn't.
+ * @note sc-element need to be locked to read or change it
+ */
+sc_element* sc_segment_get_element(sc_segment *seg, sc_addr_offset offset);
+
+/*! Returns pointer to content of sc-link with specified offset. Page of contents is allocated, if it wasn't.
+ * @note sc-link need to be locked to read or change it
+ */
+sc_content* sc_segment_get_content(sc_segment *seg, sc_addr_offset offset);
+//! Clears content of sc-element with specified offset. Page of contents isn't allocated, if it wasn't
+void sc_segment_clear_content(sc_segment *seg, sc_addr_offset offset);
+
+/*! Copies all elements of segment into \p buffer (SC_SEGMENT_ELEMENTS_COUNT elements) and their contents into \p contents
+ * (SC_SEGMENT_ELEMENTS_COUNT contents). Elements and contents of not allocated pages are zeroed
+ */
+void sc_segment_copy_elements(sc_segment *seg, sc_element *buffer, sc_content *contents);
+//! Copies elements and contents from buffers into segment. Pages, that have no sc-elements (sc-links), are not allocated
+void sc_segment_set_elements(sc_segment *seg, sc_element const *buffer, sc_content const *contents);
+
+//! Returns number of allocated pages of elements
+sc_uint32 sc_segment_get_pages_count(sc_segment *seg);
+
+//! Marks segment as changed, so it would be written on next save
+void sc_segment_set_dirty(sc_segment *seg);
+//! Resets changed flag of segment and returns its previous value. @note Segment need to be locked
+sc_bool sc_segment_reset_dirty(sc_segment *seg);
+
 //! Returns number of stored sc-elements in segment
 sc_uint32 sc_segment_get_elements_count(sc_segment *seg);
 
@@ -71,6 +149,17 @@ void sc_segment_collect_elements_stat(const sc_memory_context *ctx, sc_segment *
 //! Returns pointer to sc-element metainfo
 sc_element_meta* sc_segment_get_meta(const sc_memory_context *ctx, sc_segment * seg, sc_addr_offset offset);
 
+//! Returns mask of sc-event types, that have subscriptions on sc-element. It doesn't require sc-element lock
+sc_uint32 sc_segment_get_events_mask(sc_segment *seg, sc_addr_offset offset);
+//! Atomically sets \p bits in mask of sc-event types of sc-element. It doesn't require sc-element lock
+void sc_segment_add_events_mask(sc_segment *seg, sc_addr_offset offset, sc_uint32 bits);
+//! Atomically clears \p bits in mask of sc-event types of sc-element. It doesn't require sc-element lock
+void sc_segment_remove_events_mask(sc_segment *seg, sc_addr_offset offset, sc_uint32 bits);
+/*! Returns number of output and input sc-arcs of sc-element. It doesn't require sc-element lock, so result is an estimate
+ * @returns Returns SC_FALSE, if degrees of sc-element aren't counted yet
+ */
+sc_bool sc_segment_get_degree(sc_segment *seg, sc_addr_offset offset, sc_uint32 *out_degree, sc_uint32 *in_degree);
+
 // ---------------------- locks --------------------------
 /*! Function to lock any empty element
  * @param seg Pointer to segment where to lock empty element
@@ -80,6 +169,21 @@ sc_element_meta* sc_segment_get_meta(const sc_memory_context *ctx, sc_segment *
  */
 sc_element* sc_segment_lock_empty_element(const sc_memory_context *ctx, sc_segment *seg, sc_addr_offset *offset);
 
+/*! Function to lock empty element in specified section of segment. It waits until section would be unlocked
+ * @param seg Pointer to segment where to lock empty element
+ * @param sec_id Index of section in segment
+ * @param offset Pointer to container for locked element offset
+ * @returns Returns pointer to locked empty element. If section has no empty elements, then returns 0
+ */
+sc_element* sc_segment_section_lock_empty_element(const sc_memory_context *ctx, sc_segment *seg, sc_uint32 sec_id, sc_addr_offset *offset);
+
+/*! Takes up to \p count empty elements in specified section of segment under one lock of section.
+ * Taken elements get sc_flag_reserved type
+ * @param offsets Array of \p count offsets to store offsets of taken elements
+ * @returns Returns number of taken elements. If it isn't 0, then section stays locked (once)
+ */
+sc_uint32 sc_segment_section_lock_empty_elements(const sc_memory_context *ctx, sc_segment *seg, sc_uint32 sec_id, sc_addr_offset *offsets, sc_uint32 count);
+
 /*! Function to lock specified element in segment
  * @param seg Pointer to segment to lock element
  * @param offset Offset of element to lock
@@ -96,6 +200,18 @@ sc_element* sc_segment_lock_element_try(const sc_memory_context *ctx, sc_segment
  */
 void sc_segment_unlock_element(const sc_memory_context *ctx, sc_segment *seg, sc_addr_offset offset);
 
+/*! Copies sc-element without lock. Version of its section is checked before and after copy, so
+ * copy is consistent, if section wasn't locked meanwhile. Readers don't write into section, so they don't
+ * interfere with each other.
+ * @param el Pointer to buffer for copy of sc-element
+ * @param version Pointer to version of section, that can be checked again by sc_segment_validate_element
+ * @returns Returns SC_TRUE, if consistent copy is made; otherwise returns SC_FALSE
+ */
+sc_bool sc_segment_read_element(sc_segment *seg, sc_addr_offset offset, sc_element *el, sc_uint32 *version);
+
+//! Returns SC_TRUE, if section of sc-element wasn't locked since \p version was read
+sc_bool sc_segment_validate_element(sc_segment *seg, sc_addr_offset offset, sc_uint32 version);
+
 //! Locks segment section. This funciton doesn't returns control, while part wouldn't be locked.
 void sc_segment_section_lock(const sc_memory_context *ctx, sc_segment_section *section);
 /*! Try to lock segment section. If section already locked, then this function returns false; otherwise it locks section and returns true
@@ -110,5 +226,24 @@ void sc_segment_section_unlock(const sc_memory_context *ctx, sc_segment_section
 void sc_segment_lock(sc_segment * seg, sc_memory_context const * ctx);
 void sc_segment_unlock(sc_segment * seg, sc_memory_context const * ctx);
 
+// ---------------------- table --------------------------
+/*! Table of segments. It is allocated by blocks of SC_SEGMENT_TABLE_BLOCK_SIZE segments, that are never moved,
+ * so segments can be read from table without locks, while new ones are appended
+ */
+struct _sc_segment_table
+{
+    sc_segment **blocks[SC_SEGMENT_TABLE_BLOCKS_COUNT];
+};
+
+//! Create empty table of segments
+sc_segment_table* sc_segment_table_new();
+//! Destroys table of segments. Segments aren't freed
+void sc_segment_table_free(sc_segment_table *table);
+
+//! Returns segment with specified number. If there are no such segment, then returns null
+sc_segment* sc_segment_table_get(sc_segment_table const *table, sc_addr_seg num);
+//! Stores segment with specified number into table
+void sc_segment_table_set(sc_segment_table *table, sc_addr_seg num, sc_segment *seg);
+
 
 #endif
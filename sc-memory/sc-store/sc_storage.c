@@ -15,6 +15,11 @@
 #include "sc_config.h"
 #include "sc_iterator.h"
 #include "sc_stream_memory.h"
+#include "sc_addr_set.h"
+#include "sc_wal.h"
+#include "sc_arc_index.h"
+#include "sc_adjacency.h"
+#include "sc_cardinality.h"
 
 #include "sc_event/sc_event_private.h"
 #include "../sc_memory_private.h"
@@ -22,137 +27,433 @@
 #include <memory.h>
 #include <glib.h>
 
-// segments array
-sc_segment **segments = 0;
+// segments table
+sc_segment_table *segments = 0;
 // number of segments
 sc_uint32 segments_num = 0;
 
 const sc_uint16 s_max_storage_lock_attempts = 100;
-const sc_uint16 s_max_storage_cache_attempts = 10;
+const sc_uint16 s_max_storage_read_attempts = 16;
 
-sc_bool is_initialized = SC_FALSE;
+// maximum number of empty elements, that are taken under one lock of section
+#define SC_STORAGE_RESERVE_CHUNK    64
 
-sc_memory_context *segments_cache_lock_ctx = 0;
-sc_int32 segments_cache_count = 0;
-sc_segment* segments_cache[SC_SEGMENT_CACHE_SIZE]; // cache of segments that have empty elements
+sc_bool is_initialized = SC_FALSE;
+// non zero, if all loaded segments are counted by sc_storage_segment_loaded
+sc_int32 segments_counted = 0;
 
-GMutex s_mutex_free;
 GMutex s_mutex_save;
+GMutex s_mutex_segment_new;
 
-#define CONCURRENCY_TO_CACHE_IDX(x) ((x) % SC_SEGMENT_CACHE_SIZE)
+/*! Segments with empty slots are kept in lock-free list (stack). Head contains number + 1 of the top segment
+ * in low bits and modification tag in high bits, so concurrent pop and push of the same segment (ABA)
+ * can't corrupt the list. Segments are never freed while storage works, so they can be read after pop.
+ */
+#ifdef SC_WIDE_ADDR
+#   define SC_FREE_SEGMENTS_NUM_BITS   25
+#else
+#   define SC_FREE_SEGMENTS_NUM_BITS   20
+#endif
+#define SC_FREE_SEGMENTS_NUM_MASK   ((1 << SC_FREE_SEGMENTS_NUM_BITS) - 1)
+
+gsize free_segments_head = 0;
+// number of storage initializations, to skip slabs of contexts, that were created with previous storage
+sc_uint32 storage_generation = 0;
+
+/*! Each context reserves one segment section and allocates sc-elements in it. Other contexts don't allocate
+ * from reserved section, so section lock is contended just by readers of sc-elements.
+ */
+struct _sc_storage_slab
+{
+    sc_uint32 segment;      // number + 1 of segment with reserved section (0 - there are no reserved section)
+    sc_uint32 section;      // index of reserved section
+    sc_uint32 generation;   // storage generation, when section was reserved
+    sc_int32 in_use;        // non zero, if slab is used by some thread (context can be shared between threads)
+};
+
+//! Returns SC_TRUE, if segment has section with empty slots, that isn't reserved by any context
+sc_bool _sc_segment_has_free_section(sc_segment *seg)
+{
+    sc_uint32 i;
+    for (i = 0; i < SC_CONCURRENCY_LEVEL; ++i)
+    {
+        if (g_atomic_int_get(&seg->sections[i].empty_count) > 0 && g_atomic_pointer_get(&seg->sections[i].slab_ctx) == null_ptr)
+            return SC_TRUE;
+    }
 
-void _sc_segment_cache_lock(const sc_memory_context * ctx)
+    return SC_FALSE;
+}
+
+sc_segment* _sc_free_segments_top()
 {
-    while (g_atomic_pointer_compare_and_exchange(&segments_cache_lock_ctx, 0, ctx) == FALSE) {}
+    gsize const head = (gsize)g_atomic_pointer_get(&free_segments_head);
+    sc_uint32 const num = head & SC_FREE_SEGMENTS_NUM_MASK;
+
+    return num == 0 ? null_ptr : sc_segment_table_get(segments, num - 1);
 }
 
-void _sc_segment_cache_unlock(const sc_memory_context *ctx)
+//! Appends segment into list of segments with empty slots. Does nothing, if it is already in the list
+void _sc_free_segments_push(sc_segment *seg)
 {
-    g_assert(g_atomic_pointer_get(&segments_cache_lock_ctx) == ctx);
-    g_atomic_pointer_set(&segments_cache_lock_ctx, 0);
+    gsize head, new_head;
+
+    if (g_atomic_int_compare_and_exchange(&seg->in_free_list, 0, 1) == FALSE)
+        return;
+
+    do
+    {
+        head = (gsize)g_atomic_pointer_get(&free_segments_head);
+        g_atomic_int_set(&seg->free_next, head & SC_FREE_SEGMENTS_NUM_MASK);
+        new_head = (((head >> SC_FREE_SEGMENTS_NUM_BITS) + 1) << SC_FREE_SEGMENTS_NUM_BITS) | (seg->num + 1);
+    } while (g_atomic_pointer_compare_and_exchange(&free_segments_head, (gpointer)head, (gpointer)new_head) == FALSE);
+}
+
+//! Removes segment from list, if it is on top of the list
+void _sc_free_segments_pop(sc_segment *seg)
+{
+    gsize const head = (gsize)g_atomic_pointer_get(&free_segments_head);
+    gsize new_head;
+
+    if ((head & SC_FREE_SEGMENTS_NUM_MASK) != seg->num + 1)
+        return;
+
+    new_head = (((head >> SC_FREE_SEGMENTS_NUM_BITS) + 1) << SC_FREE_SEGMENTS_NUM_BITS) | g_atomic_int_get(&seg->free_next);
+    if (g_atomic_pointer_compare_and_exchange(&free_segments_head, (gpointer)head, (gpointer)new_head) == FALSE)
+        return;
+
+    g_atomic_int_set(&seg->in_free_list, 0);
+
+    // element could be freed or section released between check and removal from list
+    if (_sc_segment_has_free_section(seg) == SC_TRUE)
+        _sc_free_segments_push(seg);
 }
 
-void _sc_segment_cache_append(const sc_memory_context * ctx, sc_segment * seg)
+//! Creates new segment and appends it into list of segments with empty slots
+sc_segment* _sc_storage_segment_new()
 {
-    sc_int32 i, idx = CONCURRENCY_TO_CACHE_IDX(ctx->id);
-    for (i = 0; i < SC_SEGMENT_CACHE_SIZE; ++i)
+    sc_segment *seg = null_ptr;
+
+    g_mutex_lock(&s_mutex_segment_new);
+
+    // other thread could create segment, while this one waits for mutex
+    seg = _sc_free_segments_top();
+    if (seg == null_ptr && g_atomic_int_get(&segments_num) < sc_config_get_max_loaded_segments())
     {
-        if (g_atomic_pointer_compare_and_exchange(&segments_cache[(idx + i) % SC_SEGMENT_CACHE_SIZE], 0, seg) == TRUE)
-        {
-            g_atomic_int_inc(&segments_cache_count);
-            break;
-        }
+        sc_uint32 const seg_num = g_atomic_int_get(&segments_num);
+        seg = sc_segment_new(seg_num);
+        sc_segment_table_set(segments, seg_num, seg);
+        g_atomic_int_inc(&segments_num);
+        _sc_free_segments_push(seg);
     }
+
+    g_mutex_unlock(&s_mutex_segment_new);
+
+    return seg;
 }
 
-void _sc_segment_cache_remove(const sc_memory_context *ctx, sc_segment *seg)
+//! Reserves section with empty slots for \p slab. Returns SC_FALSE, if there are no more free space
+sc_bool _sc_storage_slab_reserve(const sc_memory_context *ctx, sc_storage_slab *slab)
 {
-    sc_int32 i, idx = CONCURRENCY_TO_CACHE_IDX(ctx->id);
-    for (i = 0; i < SC_SEGMENT_CACHE_SIZE; ++i)
+    while (SC_TRUE)
     {
-        if (g_atomic_pointer_compare_and_exchange(&segments_cache[(idx + i) % SC_SEGMENT_CACHE_SIZE], seg, 0) == TRUE)
+        sc_uint32 i;
+        sc_segment *seg = _sc_free_segments_top();
+        if (seg == null_ptr)
         {
-            g_atomic_int_add(&segments_cache_count, -1);
-            break;
+            seg = _sc_storage_segment_new();
+            if (seg == null_ptr)
+                return SC_FALSE;
+        }
+
+        for (i = 0; i < SC_CONCURRENCY_LEVEL; ++i)
+        {
+            sc_uint32 const sec_id = (ctx->id + i) % SC_CONCURRENCY_LEVEL;
+            sc_segment_section *section = &seg->sections[sec_id];
+
+            if (g_atomic_int_get(&section->empty_count) > 0 &&
+                g_atomic_pointer_compare_and_exchange(&section->slab_ctx, null_ptr, ctx) == TRUE)
+            {
+                slab->segment = seg->num + 1;
+                slab->section = sec_id;
+                slab->generation = storage_generation;
+                return SC_TRUE;
+            }
         }
+
+        // all sections with empty slots are reserved by other contexts
+        _sc_free_segments_pop(seg);
     }
+
+    return SC_FALSE;
 }
 
-void _sc_segment_cache_clear()
+//! Returns reserved section back to segment
+void _sc_storage_slab_release(sc_storage_slab *slab)
 {
-    sc_int32 i;
-    for (i = 0; i < SC_SEGMENT_CACHE_SIZE; ++i)
-        g_atomic_pointer_set(&segments_cache[i], 0);
+    sc_segment *seg = null_ptr;
+
+    if (slab->segment == 0)
+        return;
+
+    if (segments != null_ptr && slab->generation == storage_generation)
+    {
+        seg = sc_segment_table_get(segments, slab->segment - 1);
+        g_atomic_pointer_set(&seg->sections[slab->section].slab_ctx, null_ptr);
+
+        // other contexts can use empty slots of section now
+        if (g_atomic_int_get(&seg->sections[slab->section].empty_count) > 0)
+            _sc_free_segments_push(seg);
+    }
+
+    slab->segment = 0;
 }
 
-void _sc_segment_cache_update(const sc_memory_context *ctx)
+sc_storage_slab* sc_storage_slab_new()
 {
-    // trying to push segments to cache
-    sc_int32 i;
-    for (i = 0; i < g_atomic_int_get(&segments_num); ++i)
+    return g_new0(sc_storage_slab, 1);
+}
+
+void sc_storage_slab_free(sc_storage_slab *slab)
+{
+    if (slab == null_ptr)
+        return;
+
+    _sc_storage_slab_release(slab);
+    g_free(slab);
+}
+
+/*! Locks up to \p count empty elements in section reserved by context. Returns number of locked elements,
+ * their section is locked once
+ */
+sc_uint32 _sc_storage_slab_lock_empty_elements(const sc_memory_context *ctx, sc_storage_slab *slab, sc_addr *addrs, sc_uint32 count)
+{
+    sc_addr_offset offsets[SC_STORAGE_RESERVE_CHUNK];
+    sc_uint32 i, taken;
+
+    count = MIN(count, SC_STORAGE_RESERVE_CHUNK);
+    while (SC_TRUE)
     {
-        sc_segment *s = g_atomic_pointer_get(&(segments[i]));
-        // need to check pointer, because segments_num increments earlier, then segments appends into array
-        if (s != null_ptr)
+        if (slab->segment != 0 && slab->generation == storage_generation)
         {
-            if (sc_segment_has_empty_slot(s))
-                _sc_segment_cache_append(ctx, s);
+            sc_segment *seg = sc_segment_table_get(segments, slab->segment - 1);
+            taken = sc_segment_section_lock_empty_elements(ctx, seg, slab->section, offsets, count);
+            if (taken > 0)
+            {
+                for (i = 0; i < taken; ++i)
+                {
+                    addrs[i].seg = seg->num;
+                    addrs[i].offset = offsets[i];
+                }
+                return taken;
+            }
+
+            // section is full, so reserve other one
+            _sc_storage_slab_release(slab);
         }
 
-        if (g_atomic_int_get(&segments_cache_count) == SC_SEGMENT_CACHE_SIZE)
-            break;
+        slab->segment = 0;
+        if (_sc_storage_slab_reserve(ctx, slab) == SC_FALSE)
+            return 0;
     }
+
+    return 0;
 }
 
-sc_segment* _sc_segment_cache_get(const sc_memory_context *ctx)
+//! Locks empty element in section reserved by context
+sc_element* _sc_storage_slab_lock_empty_element(const sc_memory_context *ctx, sc_storage_slab *slab, sc_addr *addr)
 {
-    _sc_segment_cache_lock(ctx);
+    if (_sc_storage_slab_lock_empty_elements(ctx, slab, addr, 1) == 0)
+        return null_ptr;
 
-    g_mutex_lock(&s_mutex_save);
+    return sc_segment_get_element(sc_segment_table_get(segments, addr->seg), addr->offset);
+}
 
-    sc_segment *seg = 0;
-    if (g_atomic_int_get(&segments_cache_count) > 0)
+//! Locks empty element in any segment. It is used, when slab of context is used by other thread
+sc_element* _sc_storage_shared_lock_empty_element(const sc_memory_context *ctx, sc_addr *addr)
+{
+    while (SC_TRUE)
     {
-        sc_int32 i, idx = CONCURRENCY_TO_CACHE_IDX(ctx->id);
-        for (i = 0; i < SC_SEGMENT_CACHE_SIZE; ++i)
+        sc_segment *seg = _sc_free_segments_top();
+        if (seg == null_ptr)
         {
-            seg = g_atomic_pointer_get(&segments_cache[(idx + i) % SC_SEGMENT_CACHE_SIZE]);
-            if (seg != null_ptr)
-                goto result;
+            seg = _sc_storage_segment_new();
+            if (seg == null_ptr)
+                return null_ptr;
         }
+
+        sc_element *el = sc_segment_lock_empty_element(ctx, seg, &addr->offset);
+        if (el != null_ptr)
+        {
+            addr->seg = seg->num;
+            return el;
+        }
+
+        _sc_free_segments_pop(seg);
     }
 
-    // try to update cache
-    _sc_segment_cache_update(ctx);
+    return null_ptr;
+}
+
+//! Returns pointer to sc-element. Section of sc-element must be locked
+sc_element* _sc_storage_get_locked_element(sc_addr_hash addr_int)
+{
+    sc_segment *seg = sc_segment_table_get(segments, SC_ADDR_LOCAL_SEG_FROM_INT(addr_int));
+    g_assert(seg != null_ptr);
+    return sc_segment_get_element(seg, SC_ADDR_LOCAL_OFFSET_FROM_INT(addr_int));
+}
 
-    // if element still not added, then create new segment and append element into it
-    sc_int32 seg_num = g_atomic_int_add(&segments_num, 1);
-    seg = sc_segment_new(seg_num);
-    segments[seg_num] = seg;
-    _sc_segment_cache_append(ctx, seg);
+//! Returns pointer to content of locked sc-link
+sc_content* _sc_storage_get_locked_content(sc_addr addr)
+{
+    sc_segment *seg = sc_segment_table_get(segments, addr.seg);
+    g_assert(seg != null_ptr);
+    return sc_segment_get_content(seg, addr.offset);
+}
 
-    result:
+//! Marks segment of changed sc-element, so it would be written on next save
+void _sc_storage_set_dirty(sc_addr addr)
+{
+    sc_segment *seg = sc_segment_table_get(segments, addr.seg);
+    g_assert(seg != null_ptr);
+    sc_segment_set_dirty(seg);
+}
+
+/*! Appends images of changed sc-elements into write-ahead log. Sc-elements must be locked.
+ * @param addrs Array of packed sc-addrs of changed sc-elements
+ * @returns Returns sequence number of log record, that should be passed to sc_wal_wait after unlock.
+ * If log is disabled, then returns 0
+ */
+sc_uint64 _sc_storage_wal_append(sc_addr_hash const *addrs, sc_uint32 count)
+{
+    sc_uint32 i;
+    sc_addr addr;
+
+    if (sc_wal_is_enabled() == SC_FALSE)
+        return 0;
+
+    sc_wal_record_begin();
+    for (i = 0; i < count; ++i)
     {
-        _sc_segment_cache_unlock(ctx);
-        g_mutex_unlock(&s_mutex_save);
+        addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(addrs[i]);
+        addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(addrs[i]);
+        sc_element const *el = _sc_storage_get_locked_element(addrs[i]);
+        sc_wal_record_add(addr, el, (el->flags.type & sc_type_link) ? _sc_storage_get_locked_content(addr) : null_ptr);
     }
 
-    return seg;
+    return sc_wal_record_end();
 }
 
+//! Appends image of one changed sc-element into write-ahead log. @see _sc_storage_wal_append
+sc_uint64 _sc_storage_wal_append_element(sc_addr addr)
+{
+    sc_addr_hash const addr_int = SC_ADDR_LOCAL_TO_INT(addr);
+    return _sc_storage_wal_append(&addr_int, 1);
+}
+
+//! Counts sc-element \p el in cardinalities of types and appends it into index of sc-arcs, if it's sc-arc
+void _sc_storage_stat_append(sc_addr addr, sc_element const *el)
+{
+    if (el->flags.type == 0 || (el->flags.type & sc_flag_request_deletion))
+        return;
+
+    sc_cardinality_append(el->flags.type);
+    if ((el->flags.type & sc_type_arc_mask) && sc_arc_index_is_enabled() == SC_TRUE)
+        sc_arc_index_append(addr, el->arc.begin, el->arc.end);
+}
+
+//! Uncounts sc-element \p el, that was counted by _sc_storage_stat_append
+void _sc_storage_stat_remove(sc_addr addr, sc_element const *el)
+{
+    if (el->flags.type == 0 || (el->flags.type & sc_flag_request_deletion))
+        return;
+
+    sc_cardinality_remove(el->flags.type);
+    if ((el->flags.type & sc_type_arc_mask) && sc_arc_index_is_enabled() == SC_TRUE)
+        sc_arc_index_remove(addr, el->arc.begin, el->arc.end);
+}
+
+//! Applies sc-element image on write-ahead log replay. Changed segments are collected into \p data
+void _sc_storage_wal_apply(sc_addr addr, sc_element const *element, sc_content const *content, sc_pointer data)
+{
+    sc_addr_set *changed_segments = (sc_addr_set*)data;
+    sc_segment *seg;
+
+    if (addr.seg >= SC_ADDR_SEG_MAX)
+        return;
+
+    // segments are allocated in order
+    while (segments_num <= addr.seg)
+    {
+        sc_segment_table_set(segments, segments_num, sc_segment_new(segments_num));
+        ++segments_num;
+    }
+
+    // statistics of loaded sc-element are replaced by applied one
+    seg = sc_segment_table_get(segments, addr.seg);
+    _sc_storage_stat_remove(addr, sc_segment_get_element(seg, addr.offset));
+    *sc_segment_get_element(seg, addr.offset) = *element;
+    _sc_storage_stat_append(addr, element);
+    if (element->flags.type & sc_type_link)
+        *sc_segment_get_content(seg, addr.offset) = *content;
+    else
+        sc_segment_clear_content(seg, addr.offset);
+    sc_addr_set_add(changed_segments, addr.seg);
+}
+
+void sc_storage_segment_loaded(sc_addr_seg num, sc_element const *elements)
+{
+    sc_addr addr;
+    sc_uint32 i;
+
+    addr.seg = num;
+    for (i = 0; i < SC_SEGMENT_ELEMENTS_COUNT; ++i)
+    {
+        addr.offset = (sc_addr_offset)i;
+        _sc_storage_stat_append(addr, &elements[i]);
+    }
+}
+
+//! Returns SC_TRUE, if all loaded segments are counted by sc_storage_segment_loaded, so index of sc-arcs is complete
+sc_bool _sc_storage_segments_counted()
+{
+    sc_uint32 i;
+
+    if (g_atomic_int_get(&segments_counted) != 0)
+        return SC_TRUE;
+
+    for (i = 0; i < segments_num; ++i)
+    {
+        sc_segment *seg = sc_segment_table_get(segments, i);
+        if (seg != null_ptr && sc_segment_is_external_checked(seg) == SC_FALSE)
+            return SC_FALSE;
+    }
+
+    g_atomic_int_set(&segments_counted, 1);
+    return SC_TRUE;
+}
 
 // -----------------------------------------------------------------------------
 
 sc_bool sc_storage_initialize(const char *path, sc_bool clear)
 {
-    g_assert( segments == (sc_segment**)0 );
+    g_assert( segments == null_ptr );
     g_assert( !is_initialized );
 
-    segments = g_new0(sc_segment*, SC_ADDR_SEG_MAX);
+    segments = sc_segment_table_new();
 
     sc_bool res = sc_fs_storage_initialize(path, clear);
     if (res == SC_FALSE)
+    {
+        sc_segment_table_free(segments);
+        segments = null_ptr;
         return SC_FALSE;
+    }
+
+    // statistics and index of sc-arcs are filled by segments on their first usage (see sc_storage_segment_loaded)
+    g_atomic_int_set(&segments_counted, 0);
+    sc_cardinality_initialize();
+    if (sc_config_arc_index() == SC_TRUE)
+        sc_arc_index_initialize();
 
     if (clear == SC_FALSE)
     {
@@ -160,9 +461,41 @@ sc_bool sc_storage_initialize(const char *path, sc_bool clear)
             return SC_FALSE;
     }
 
+    // apply changes, that were made after last save
+    sc_addr_set changed_segments;
+    sc_addr_set_init(&changed_segments);
+    if (sc_wal_initialize(path, clear, _sc_storage_wal_apply, &changed_segments) == SC_FALSE)
+    {
+        sc_addr_set_destroy(&changed_segments);
+        return SC_FALSE;
+    }
+
+    sc_uint32 i;
+    for (i = 0; i < changed_segments.count; ++i)
+    {
+        sc_segment *seg = sc_segment_table_get(segments, (sc_addr_seg)changed_segments.items[i]);
+        sc_segment_loaded(seg);
+        sc_segment_set_dirty(seg);
+    }
+
+    sc_adjacency_initialize();
+
     is_initialized = SC_TRUE;
+    ++storage_generation;
+
+    // collect loaded segments with empty slots
+    g_atomic_pointer_set(&free_segments_head, 0);
+    for (i = segments_num; i > 0; --i)
+    {
+        sc_segment *seg = sc_segment_table_get(segments, i - 1);
+        if (seg != null_ptr && sc_segment_has_empty_slot(seg) == SC_TRUE)
+            _sc_free_segments_push(seg);
+    }
 
-    memset(&(segments_cache[0]), 0, sizeof(sc_segment*) * SC_SEGMENT_CACHE_SIZE);
+    // save replayed changes, so log files (even ones without complete records) are removed
+    if (changed_segments.count > 0 || sc_wal_is_replayed() == SC_TRUE)
+        sc_storage_save(null_ptr);
+    sc_addr_set_destroy(&changed_segments);
 
     return SC_TRUE;
 }
@@ -170,23 +503,34 @@ sc_bool sc_storage_initialize(const char *path, sc_bool clear)
 void sc_storage_shutdown(sc_bool save_state)
 {
     sc_uint idx = 0;
-    g_assert( segments != (sc_segment**)0 );
+    g_assert( segments != null_ptr );
 
 
-    sc_fs_storage_shutdown(segments, save_state);
+    if (save_state == SC_TRUE)
+    {
+        g_message("Write segments");
+        sc_storage_save(null_ptr);
+    }
+
+    sc_fs_storage_shutdown(segments, SC_FALSE);
+    sc_wal_shutdown();
+    sc_arc_index_shutdown();
+    sc_adjacency_shutdown();
+    sc_cardinality_shutdown();
 
-    for (idx = 0; idx < SC_ADDR_SEG_MAX; idx++)
+    for (idx = 0; idx < segments_num; idx++)
     {
-        if (segments[idx] == null_ptr) continue; // skip segments, that are not loaded
-        sc_segment_free(segments[idx]);
+        sc_segment *seg = sc_segment_table_get(segments, idx);
+        if (seg == null_ptr) continue; // skip segments, that are not loaded
+        sc_segment_free(seg);
     }
 
-    g_free(segments);
-    segments = (sc_segment**)0;
+    sc_segment_table_free(segments);
+    segments = null_ptr;
     segments_num = 0;
 
     is_initialized = SC_FALSE;
-    _sc_segment_cache_clear();
+    g_atomic_pointer_set(&free_segments_head, 0);
 }
 
 sc_bool sc_storage_is_initialized()
@@ -196,51 +540,73 @@ sc_bool sc_storage_is_initialized()
 
 sc_bool sc_storage_is_element(const sc_memory_context *ctx, sc_addr addr)
 {
-    sc_element *el = 0;
-    sc_bool res = SC_TRUE;
-    
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+    sc_element el;
+
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
         return SC_FALSE;
-        
-    if (el->flags.type == 0 || (el->flags.type & sc_flag_request_deletion))
-        res = SC_FALSE;
 
-    sc_storage_element_unlock(ctx, addr);
+    return sc_element_is_valid(&el);
+}
 
-    return res;
+/*! Locks up to \p count empty elements in slab of context under one lock of section. If slab is used by other
+ * thread, then locks one empty element in any segment. Locked elements get sc_flag_reserved type.
+ * Returns number of locked elements
+ */
+sc_uint32 _sc_storage_lock_empty_elements(const sc_memory_context *ctx, sc_addr *addrs, sc_uint32 count)
+{
+    sc_storage_slab *slab = ctx->slab;
+    sc_element *el = null_ptr;
+    sc_uint32 taken = 0;
+
+    if (slab != null_ptr && g_atomic_int_compare_and_exchange(&slab->in_use, 0, 1) == TRUE)
+    {
+        taken = _sc_storage_slab_lock_empty_elements(ctx, slab, addrs, count);
+        g_atomic_int_set(&slab->in_use, 0);
+    }
+    else if ((el = _sc_storage_shared_lock_empty_element(ctx, &addrs[0])) != null_ptr)
+    {
+        el->flags.type = sc_flag_reserved;
+        taken = 1;
+    }
+
+    return taken;
+}
+
+//! Locks empty element in slab of context, or in any segment, if slab is used by other thread
+sc_element* _sc_storage_lock_empty_element(const sc_memory_context *ctx, sc_addr *addr)
+{
+    sc_storage_slab *slab = ctx->slab;
+    sc_element *el = null_ptr;
+
+    if (slab != null_ptr && g_atomic_int_compare_and_exchange(&slab->in_use, 0, 1) == TRUE)
+    {
+        el = _sc_storage_slab_lock_empty_element(ctx, slab, addr);
+        g_atomic_int_set(&slab->in_use, 0);
+    }
+    else
+        el = _sc_storage_shared_lock_empty_element(ctx, addr);
+
+    return el;
 }
 
 sc_element* sc_storage_append_el_into_segments(const sc_memory_context *ctx, sc_element *element, sc_addr *addr)
 {
-    sc_segment * seg = (sc_segment*)0x1;
+    sc_element *el = null_ptr;
 
     g_assert( addr != 0 );
     SC_ADDR_MAKE_EMPTY(*addr);
 
-    if (g_atomic_int_get(&segments_num) >= sc_config_get_max_loaded_segments())
-        return null_ptr;
-
-    /// @todo store segment with empty slots
-    // try to find segment with empty slots
-    while (seg != 0)
+    el = _sc_storage_lock_empty_element(ctx, addr);
+    if (el == null_ptr)
     {
-        sc_segment *seg = _sc_segment_cache_get(ctx);
-
-        if (seg == null_ptr)
-            break;
-
-        sc_element *el = sc_segment_lock_empty_element(ctx, seg, &addr->offset);
-        if (el != null_ptr)
-        {
-            addr->seg = seg->num;
-            *el = *element;
-            el->flags.access_levels = sc_access_lvl_min(ctx->access_levels, el->flags.access_levels);
-            return el;
-        }else
-            _sc_segment_cache_remove(ctx, seg);
+        SC_ADDR_MAKE_EMPTY(*addr);
+        return null_ptr;
     }
 
-    return null_ptr;
+    *el = *element;
+    el->flags.access_levels = sc_access_lvl_min(ctx->access_levels, el->flags.access_levels);
+    sc_cardinality_append(el->flags.type);
+    return el;
 }
 
 sc_addr sc_storage_element_new_access(const sc_memory_context *ctx, sc_type type, sc_access_levels access_levels)
@@ -248,225 +614,278 @@ sc_addr sc_storage_element_new_access(const sc_memory_context *ctx, sc_type type
     sc_element el;
     sc_addr addr;
     sc_element *res = 0;
+    sc_uint64 lsn = 0;
 
     memset(&el, 0, sizeof(el));
     el.flags.type = type;
     el.flags.access_levels = access_levels;
 
     res = sc_storage_append_el_into_segments(ctx, &el, &addr);
-    sc_storage_element_unlock(ctx, addr);
     g_assert(res != 0);
+    lsn = _sc_storage_wal_append_element(addr);
+    sc_storage_element_unlock(ctx, addr);
+    sc_wal_wait(lsn);
     return addr;
 }
 
-sc_result sc_storage_element_free(const sc_memory_context *ctx, sc_addr addr)
+// ----------------------------- deletion --------------------------------------
+/*! Deletion locks all segment sections, that contains removed sc-elements and their neighbours.
+ * Sections are locked in ascending order (segment, section), so concurrent deletions (and save,
+ * that locks whole segments in the same order) can't deadlock. Set of required sections isn't known
+ * before the closure of removed sc-elements is collected, so collection runs under locked sections.
+ * If it finds sc-element in a section, that isn't locked, then all sections are unlocked and
+ * collection repeats with extended set of sections.
+ */
+struct _sc_storage_free_scratch
 {
-    GHashTable *remove_table = 0, *lock_table = 0;
-    GSList *remove_list = 0;
-    sc_result result = SC_RESULT_OK;
+    sc_addr_set elements;       // packed sc-addrs of removed sc-elements in order of discovering
+    sc_addr_set sections;       // sections, that are locked by deletion
+    sc_addr_set missing;        // sections, that are required, but not locked yet
+    sc_addr_set changed;        // packed sc-addrs of changed sc-elements (for write-ahead log)
+    sc_int32 in_use;            // non zero, if scratch is used by deletion (context can be shared between threads)
+};
 
-    g_mutex_lock(&s_mutex_free);
+#define SC_STORAGE_SECTION_KEY(addr) ((sc_uint32)(addr).seg * SC_CONCURRENCY_LEVEL + (addr).offset % SC_CONCURRENCY_LEVEL)
 
-    // first of all we need to collect and lock all elements
-    sc_element *el;
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+sc_storage_free_scratch* sc_storage_free_scratch_new()
+{
+    sc_storage_free_scratch *scratch = g_new0(sc_storage_free_scratch, 1);
+    sc_addr_set_init(&scratch->elements);
+    sc_addr_set_init(&scratch->sections);
+    sc_addr_set_init(&scratch->missing);
+    sc_addr_set_init(&scratch->changed);
+    return scratch;
+}
+
+void sc_storage_free_scratch_free(sc_storage_free_scratch *scratch)
+{
+    if (scratch == null_ptr)
+        return;
+
+    g_assert(g_atomic_int_get(&scratch->in_use) == 0);
+    sc_addr_set_destroy(&scratch->elements);
+    sc_addr_set_destroy(&scratch->sections);
+    sc_addr_set_destroy(&scratch->missing);
+    sc_addr_set_destroy(&scratch->changed);
+    g_free(scratch);
+}
+
+//! Returns scratch of context, or temporary one, if context scratch is used by other thread
+sc_storage_free_scratch* _sc_storage_free_scratch_acquire(const sc_memory_context *ctx)
+{
+    sc_storage_free_scratch *scratch = ctx->free_scratch;
+    if (scratch != null_ptr && g_atomic_int_compare_and_exchange(&scratch->in_use, 0, 1) == TRUE)
+        return scratch;
+
+    return sc_storage_free_scratch_new();
+}
+
+void _sc_storage_free_scratch_release(const sc_memory_context *ctx, sc_storage_free_scratch *scratch)
+{
+    if (scratch == ctx->free_scratch)
+        g_atomic_int_set(&scratch->in_use, 0);
+    else
+        sc_storage_free_scratch_free(scratch);
+}
+
+//! Locks first \p count sections from \p sections in their order
+void _sc_storage_sections_lock(const sc_memory_context *ctx, sc_addr_set const *sections, sc_uint32 count)
+{
+    sc_uint32 i;
+    for (i = 0; i < count; ++i)
     {
-        g_mutex_unlock(&s_mutex_free);
-        return SC_RESULT_ERROR;
+        sc_segment *seg = sc_segment_table_get(segments, sections->items[i] / SC_CONCURRENCY_LEVEL);
+        sc_segment_section_lock(ctx, &seg->sections[sections->items[i] % SC_CONCURRENCY_LEVEL]);
     }
+}
 
-    g_assert(el != 0);
-    if (el->flags.type == 0 || el->flags.type & sc_flag_request_deletion)
+void _sc_storage_sections_unlock(const sc_memory_context *ctx, sc_addr_set const *sections, sc_uint32 count)
+{
+    sc_uint32 i;
+    for (i = 0; i < count; ++i)
+    {
+        sc_segment *seg = sc_segment_table_get(segments, sections->items[i] / SC_CONCURRENCY_LEVEL);
+        sc_segment_section_unlock(ctx, &seg->sections[sections->items[i] % SC_CONCURRENCY_LEVEL]);
+    }
+}
+
+/*! Checks if section of \p addr is locked by deletion. If it isn't, then it would be
+ * appended to missing sections and function returns SC_FALSE
+ */
+sc_bool _sc_storage_free_require(sc_storage_free_scratch *scratch, sc_addr addr)
+{
+    sc_uint32 const key = SC_STORAGE_SECTION_KEY(addr);
+    if (sc_addr_set_contains(&scratch->sections, key) == SC_TRUE)
+        return SC_TRUE;
+
+    sc_addr_set_add(&scratch->missing, key);
+    return SC_FALSE;
+}
+
+//! Appends arcs from output (\p out == SC_TRUE) or input list, that starts with \p arc_addr, into removed elements
+void _sc_storage_free_predict_list(const sc_memory_context *ctx, sc_addr arc_addr, sc_bool out, sc_storage_free_scratch *scratch)
+{
+    while (SC_ADDR_IS_NOT_EMPTY(arc_addr))
     {
-        g_mutex_unlock(&s_mutex_free);
+        sc_element *el = 0;
+        sc_addr const addr = arc_addr;
+
+        // stop on already known arc, list could be changed concurrently
+        if (sc_addr_set_add(&scratch->elements, SC_ADDR_LOCAL_TO_INT(addr)) == SC_FALSE)
+            break;
+
+        if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+            break;
+        arc_addr = (out == SC_TRUE) ? el->arc.next_out_arc : el->arc.next_in_arc;
         sc_storage_element_unlock(ctx, addr);
-        return SC_RESULT_ERROR;
     }
+}
 
-    remove_table = g_hash_table_new(g_direct_hash, g_direct_equal);
-    lock_table = g_hash_table_new(g_direct_hash, g_direct_equal);
-    g_hash_table_insert(remove_table, GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr)), el);
-    g_hash_table_insert(lock_table, GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr)), el);
+/*! Predicts sections, that would be required for deletion of sc-element with \p addr. It walks
+ * connectors locking one sc-element at a time, so in most cases collection succeeds with the first set
+ * of locked sections.
+ */
+void _sc_storage_free_predict(const sc_memory_context *ctx, sc_addr addr, sc_storage_free_scratch *scratch)
+{
+    sc_addr_set *elements = &scratch->elements;
+    sc_uint32 i;
 
-    remove_list = g_slist_append(remove_list, GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr)));
-    while (remove_list != 0)
+    sc_addr_set_clear(elements);
+    sc_addr_set_add(elements, SC_ADDR_LOCAL_TO_INT(addr));
+    for (i = 0; i < elements->count; ++i)
     {
-        // get sc-addr for removing
-        sc_uint32 addr_int = GPOINTER_TO_UINT(remove_list->data);
-        sc_addr _addr;
-        _addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(addr_int);
-        _addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(addr_int);
+        sc_addr _addr, first_out_arc, first_in_arc;
+        sc_element *el = 0;
+        _addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(elements->items[i]);
+        _addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(elements->items[i]);
 
-        gpointer p_addr = GUINT_TO_POINTER(addr_int);
+        sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(_addr));
 
-        // go to next sc-addr in list
-        remove_list = g_slist_delete_link(remove_list, remove_list);
+        if (sc_storage_element_lock(ctx, _addr, &el) != SC_RESULT_OK)
+            continue;
 
-        if (!sc_access_lvl_check_write(ctx->access_levels, el->flags.access_levels))
+        if (el->flags.type & sc_type_arc_mask)
         {
-            result = SC_RESULT_ERROR_NO_WRITE_RIGHTS;
-            goto unlock;
+            sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(el->arc.begin));
+            sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(el->arc.end));
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.prev_out_arc))
+                sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(el->arc.prev_out_arc));
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_out_arc))
+                sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(el->arc.next_out_arc));
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.prev_in_arc))
+                sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(el->arc.prev_in_arc));
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_in_arc))
+                sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(el->arc.next_in_arc));
         }
 
-        el = g_hash_table_lookup(lock_table, p_addr);
-        if (el == null_ptr)
-        {
-            STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, _addr, &el));
+        first_out_arc = el->first_out_arc;
+        first_in_arc = el->first_in_arc;
+        sc_storage_element_unlock(ctx, _addr);
 
-            g_assert(el->flags.type != 0);
-            g_hash_table_insert(remove_table, p_addr, el);
-            g_hash_table_insert(lock_table, p_addr, el);
-        }
+        _sc_storage_free_predict_list(ctx, first_out_arc, SC_TRUE, scratch);
+        _sc_storage_free_predict_list(ctx, first_in_arc, SC_FALSE, scratch);
+    }
+}
 
-        if (el->flags.type & sc_type_arc_mask)
-        {
-            // lock begin and end elements of arc
-            sc_element *el2 = 0;
-            p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.begin));
-            if ((el2 = g_hash_table_lookup(lock_table, p_addr)) == null_ptr)
-            {
-                STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.begin, &el2));
-                g_hash_table_insert(lock_table, p_addr, el2);
-            }
+//! Collects sc-element with \p addr and all connectors incident to it. All found sections must be locked
+sc_result _sc_storage_free_collect(const sc_memory_context *ctx, sc_addr addr, sc_storage_free_scratch *scratch)
+{
+    sc_addr_set *elements = &scratch->elements;
+    sc_element *el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(addr));
+    sc_uint32 i;
 
-            p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.end));
-            if ((el2 = g_hash_table_lookup(lock_table, p_addr)) == null_ptr)
-            {
-                el2 = 0;
-                STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.end, &el2));
-                g_hash_table_insert(lock_table, p_addr, el2);
-            }
+    sc_addr_set_clear(elements);
 
-            // lock next/prev arcs in out/in lists
-            if (SC_ADDR_IS_NOT_EMPTY(el->arc.prev_out_arc))
-            {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.prev_out_arc));
-                if (g_hash_table_lookup(lock_table, p_addr) == null_ptr)
-                {
-                    el2 = 0;
-                    STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.prev_out_arc, &el2));
-                    g_assert(el2 != 0);
-                    g_hash_table_insert(lock_table, p_addr, el2);
-                }
-            }
+    if (el->flags.type == 0 || el->flags.type & sc_flag_request_deletion)
+        return SC_RESULT_ERROR;
 
-            if (SC_ADDR_IS_NOT_EMPTY(el->arc.prev_in_arc))
-            {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.prev_in_arc));
-                if (g_hash_table_lookup(lock_table, p_addr) == null_ptr)
-                {
-                    el2 = 0;
-                    STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.prev_in_arc, &el2));
-                    g_assert(el2 != 0);
-                    g_hash_table_insert(lock_table, p_addr, el2);
-                }
-            }
+    sc_addr_set_add(elements, SC_ADDR_LOCAL_TO_INT(addr));
+    for (i = 0; i < elements->count; ++i)
+    {
+        sc_addr _addr;
+        el = _sc_storage_get_locked_element(elements->items[i]);
 
-            if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_out_arc))
-            {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.next_out_arc));
-                if (g_hash_table_lookup(lock_table, p_addr) == null_ptr)
-                {
-                    el2 = 0;
-                    STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.next_out_arc, &el2));
-                    g_assert(el2 != 0);
-                    g_hash_table_insert(lock_table, p_addr, el2);
-                }
-            }
+        if (!sc_access_lvl_check_write(ctx->access_levels, el->flags.access_levels))
+            return SC_RESULT_ERROR_NO_WRITE_RIGHTS;
 
+        // begin, end and neighbours in output/input lists of arc would be changed
+        if (el->flags.type & sc_type_arc_mask)
+        {
+            _sc_storage_free_require(scratch, el->arc.begin);
+            _sc_storage_free_require(scratch, el->arc.end);
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.prev_out_arc))
+                _sc_storage_free_require(scratch, el->arc.prev_out_arc);
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_out_arc))
+                _sc_storage_free_require(scratch, el->arc.next_out_arc);
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.prev_in_arc))
+                _sc_storage_free_require(scratch, el->arc.prev_in_arc);
             if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_in_arc))
-            {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.next_in_arc));
-                if (g_hash_table_lookup(lock_table, p_addr) == null_ptr)
-                {
-                    el2 = 0;
-                    STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.next_in_arc, &el2));
-                    g_assert(el2 != 0);
-                    g_hash_table_insert(lock_table, p_addr, el2);
-                }
-            }
+                _sc_storage_free_require(scratch, el->arc.next_in_arc);
         }
 
-        // Iterate all connectors for deleted element and append them into remove_list
+        // iterate all connectors of removed element and append them into remove list
         _addr = el->first_out_arc;
-        while (SC_ADDR_IS_NOT_EMPTY(_addr))
-        {
-            gpointer p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(_addr));
-            sc_element *el2 = g_hash_table_lookup(remove_table, p_addr);
-
-            if (el2 == null_ptr)
-            {
-                el2 = g_hash_table_lookup(lock_table, p_addr);
-                if (el2 == null_ptr)
-                {
-                    sc_storage_element_lock(ctx, _addr, &el2);
-                    g_hash_table_insert(lock_table, p_addr, el2);
-                }
-
-                g_assert(el2 != null_ptr);
-                g_hash_table_insert(remove_table, p_addr, el2);
-
-                remove_list = g_slist_append(remove_list, p_addr);
-            }
-
-            _addr = el2->arc.next_out_arc;
+        while (SC_ADDR_IS_NOT_EMPTY(_addr) && _sc_storage_free_require(scratch, _addr) == SC_TRUE)
+        {
+            sc_addr_set_add(elements, SC_ADDR_LOCAL_TO_INT(_addr));
+            _addr = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(_addr))->arc.next_out_arc;
         }
 
         _addr = el->first_in_arc;
-        while (SC_ADDR_IS_NOT_EMPTY(_addr))
+        while (SC_ADDR_IS_NOT_EMPTY(_addr) && _sc_storage_free_require(scratch, _addr) == SC_TRUE)
         {
-            gpointer p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(_addr));
-            sc_element *el2 = g_hash_table_lookup(remove_table, p_addr);
-
-            if (el2 == null_ptr)
-            {
-                el2 = g_hash_table_lookup(lock_table, p_addr);
-                if (el2 == null_ptr)
-                {
-                    sc_storage_element_lock(ctx, _addr, &el2);
-                    g_hash_table_insert(lock_table, p_addr, el2);
-                }
-
-                g_assert(el2 != null_ptr);
-                g_hash_table_insert(remove_table, p_addr, el2);
+            sc_addr_set_add(elements, SC_ADDR_LOCAL_TO_INT(_addr));
+            _addr = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(_addr))->arc.next_in_arc;
+        }
+    }
 
-                remove_list = g_slist_append(remove_list, p_addr);
-            }
+    return SC_RESULT_OK;
+}
 
-            _addr = el2->arc.next_in_arc;
-        }
+//! Marks sc-element as changed by deletion (or by bulk creation)
+void _sc_storage_free_changed(sc_storage_free_scratch *scratch, sc_addr addr)
+{
+    _sc_storage_set_dirty(addr);
+    if (sc_wal_is_enabled() == SC_TRUE)
+        sc_addr_set_add(&scratch->changed, SC_ADDR_LOCAL_TO_INT(addr));
+}
 
-        // clean temp addr
-        SC_ADDR_MAKE_EMPTY(_addr);
-    }
+//! Erases all collected sc-elements. All required sections must be locked
+sc_result _sc_storage_free_erase(const sc_memory_context *ctx, sc_storage_free_scratch *scratch)
+{
+    sc_uint32 i;
 
-    // now we need to erase all elements
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, remove_table);
-    gpointer key, value;
-    while (g_hash_table_iter_next(&iter, &key, &value) == TRUE)
+    sc_addr_set_clear(&scratch->changed);
+    for (i = 0; i < scratch->elements.count; ++i)
     {
-        el = value;
-        sc_uint32 uint_addr = GPOINTER_TO_UINT(key);
-        gpointer p_addr;
-        addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(uint_addr);
-        addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(uint_addr);
+        sc_addr addr;
+        sc_element *el = _sc_storage_get_locked_element(scratch->elements.items[i]);
+        addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(scratch->elements.items[i]);
+        addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(scratch->elements.items[i]);
         sc_access_levels el_access = el->flags.access_levels;
 
         if (el->flags.type & sc_flag_request_deletion)
             continue;
 
+        sc_cardinality_remove(el->flags.type);
+
+        sc_element_meta *meta = sc_storage_get_element_meta(ctx, addr);
+        if (meta->adjacency)
+        {
+            sc_adjacency_drop(addr);
+            meta->adjacency = 0;
+        }
+
         if (el->flags.type & sc_type_link)
         {
             sc_check_sum sum;
 
+            sc_content const *content = _sc_storage_get_locked_content(addr);
+
             if (el->flags.type & sc_flag_link_self_container)
-                sc_link_self_container_calculate_checksum(el, &sum);
+                sc_link_self_container_calculate_checksum(content, &sum);
             else
-            {
-                memcpy(&sum.data[0], el->content.data, SC_CHECKSUM_LEN);
-                sum.len = SC_CHECKSUM_LEN;
-            }
+                sc_link_checksum_from_content(content, &sum);
 
             STORAGE_CHECK_CALL(sc_fs_storage_remove_content_addr(addr, &sum));
         }
@@ -478,80 +897,75 @@ sc_result sc_storage_element_free(const sc_memory_context *ctx, sc_addr addr)
 
             if (SC_ADDR_IS_NOT_EMPTY(prev_arc))
             {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(prev_arc));
-                sc_element *prev_el_arc = g_hash_table_lookup(lock_table, p_addr);
-                g_assert(prev_el_arc != null_ptr);
-                prev_el_arc->arc.next_out_arc = next_arc;
-
+                _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(prev_arc))->arc.next_out_arc = next_arc;
+                _sc_storage_free_changed(scratch, prev_arc);
             }
 
             if (SC_ADDR_IS_NOT_EMPTY(next_arc))
             {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(next_arc));
-                sc_element *next_el_arc = g_hash_table_lookup(lock_table, p_addr);
-                g_assert(next_el_arc != null_ptr);
-                next_el_arc->arc.prev_out_arc = prev_arc;
+                _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(next_arc))->arc.prev_out_arc = prev_arc;
+                _sc_storage_free_changed(scratch, next_arc);
             }
 
-            sc_element *b_el = g_hash_table_lookup(lock_table, GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.begin)));
-            sc_bool need_unlock = SC_FALSE;
-            if (b_el == null_ptr)
-            {
-                STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.begin, &b_el));
-                need_unlock = SC_TRUE;
-            }
+            sc_element *b_el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(el->arc.begin));
             if (SC_ADDR_IS_EQUAL(addr, b_el->first_out_arc))
+            {
                 b_el->first_out_arc = next_arc;
+                _sc_storage_free_changed(scratch, el->arc.begin);
+            }
 
             sc_event_emit(el->arc.begin, b_el->flags.access_levels, SC_EVENT_REMOVE_OUTPUT_ARC, addr);
 
-            if (need_unlock)
-                sc_storage_element_unlock(ctx, el->arc.begin);
-
             // input arcs
             prev_arc = el->arc.prev_in_arc;
             next_arc = el->arc.next_in_arc;
 
             if (SC_ADDR_IS_NOT_EMPTY(prev_arc))
             {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(prev_arc));
-                sc_element *prev_el_arc = g_hash_table_lookup(lock_table, p_addr);
-                g_assert(prev_el_arc != null_ptr);
-                prev_el_arc->arc.next_in_arc = next_arc;
+                _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(prev_arc))->arc.next_in_arc = next_arc;
+                _sc_storage_free_changed(scratch, prev_arc);
             }
 
             if (SC_ADDR_IS_NOT_EMPTY(next_arc))
             {
-                p_addr = GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(next_arc));
-                sc_element *next_el_arc = g_hash_table_lookup(lock_table, p_addr);
-                g_assert(next_el_arc != null_ptr);
-                next_el_arc->arc.prev_in_arc = prev_arc;
+                _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(next_arc))->arc.prev_in_arc = prev_arc;
+                _sc_storage_free_changed(scratch, next_arc);
             }
 
-            need_unlock = SC_FALSE;
-            sc_element *e_el = g_hash_table_lookup(lock_table, GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(el->arc.end)));
-            if (e_el == null_ptr)
-            {
-                STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, el->arc.end, &e_el));
-                need_unlock = SC_TRUE;
-            }
+            sc_element *e_el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(el->arc.end));
             if (SC_ADDR_IS_EQUAL(addr, e_el->first_in_arc))
+            {
                 e_el->first_in_arc = next_arc;
+                _sc_storage_free_changed(scratch, el->arc.end);
+            }
 
             sc_event_emit(el->arc.end, e_el->flags.access_levels, SC_EVENT_REMOVE_INPUT_ARC, addr);
 
-            if (need_unlock)
-                sc_storage_element_unlock(ctx, el->arc.end);
+            if (sc_arc_index_is_enabled() == SC_TRUE)
+                sc_arc_index_remove(addr, el->arc.begin, el->arc.end);
+
+            sc_element_meta *b_meta = sc_storage_get_element_meta(ctx, el->arc.begin);
+            sc_element_meta *e_meta = sc_storage_get_element_meta(ctx, el->arc.end);
+            if (b_meta->degree_counted)
+                b_meta->out_degree--;
+            if (e_meta->degree_counted)
+                e_meta->in_degree--;
+            if (b_meta->adjacency)
+                sc_adjacency_remove(el->arc.begin, SC_ADJACENCY_OUT, addr, el->arc.end);
+            if (e_meta->adjacency)
+                sc_adjacency_remove(el->arc.end, SC_ADJACENCY_IN, addr, el->arc.begin);
         }
 
         if (sc_element_get_refs(sc_storage_get_element_meta(ctx, addr)) == 0)
         {
             sc_storage_erase_element_from_segment(addr);
-            _sc_segment_cache_append(ctx, g_atomic_pointer_get(&segments[addr.seg]));
+            _sc_free_segments_push(sc_segment_table_get(segments, addr.seg));
+            _sc_storage_free_changed(scratch, addr);
         }
         else
         {
             el->flags.type |= sc_flag_request_deletion;
+            _sc_storage_free_changed(scratch, addr);
         }
 
         sc_event_emit(addr, el_access, SC_EVENT_REMOVE_ELEMENT, addr);
@@ -560,24 +974,51 @@ sc_result sc_storage_element_free(const sc_memory_context *ctx, sc_addr addr)
         sc_event_notify_element_deleted(addr);
     }
 
-    unlock:
+    return SC_RESULT_OK;
+}
+
+sc_result sc_storage_element_free(const sc_memory_context *ctx, sc_addr addr)
+{
+    sc_storage_free_scratch *scratch = 0;
+    sc_result result = SC_RESULT_OK;
+    sc_uint32 i, locked = 0;
+    sc_uint64 lsn = 0;
+
+    if (addr.seg >= SC_ADDR_SEG_MAX || sc_segment_table_get(segments, addr.seg) == null_ptr)
+        return SC_RESULT_ERROR;
+
+    scratch = _sc_storage_free_scratch_acquire(ctx);
+    sc_addr_set_clear(&scratch->sections);
+    sc_addr_set_clear(&scratch->missing);
+    _sc_storage_free_predict(ctx, addr, scratch);
 
-    // now unlock elements
-    g_hash_table_iter_init(&iter, lock_table);
-    while (g_hash_table_iter_next(&iter, &key, &value) == TRUE)
+    while (SC_TRUE)
     {
-        sc_uint32 uint_addr = GPOINTER_TO_UINT(key);
-        addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(uint_addr);
-        addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(uint_addr);
+        sc_addr_set_sort(&scratch->sections);
+        locked = scratch->sections.count;
+        _sc_storage_sections_lock(ctx, &scratch->sections, locked);
 
-        sc_storage_element_unlock(ctx, addr);
+        result = _sc_storage_free_collect(ctx, addr, scratch);
+        if (result != SC_RESULT_OK || scratch->missing.count == 0)
+            break;
+
+        // some of required sc-elements are in sections, that aren't locked, so repeat with them
+        _sc_storage_sections_unlock(ctx, &scratch->sections, locked);
+        for (i = 0; i < scratch->missing.count; ++i)
+            sc_addr_set_add(&scratch->sections, scratch->missing.items[i]);
+        sc_addr_set_clear(&scratch->missing);
+    }
+
+    if (result == SC_RESULT_OK)
+    {
+        result = _sc_storage_free_erase(ctx, scratch);
+        lsn = _sc_storage_wal_append(scratch->changed.items, scratch->changed.count);
     }
 
-    g_mutex_unlock(&s_mutex_free);
+    _sc_storage_sections_unlock(ctx, &scratch->sections, locked);
+    _sc_storage_free_scratch_release(ctx, scratch);
 
-    g_slist_free(remove_list);
-    g_hash_table_destroy(remove_table);
-    g_hash_table_destroy(lock_table);
+    sc_wal_wait(lsn);
 
     return result;
 }
@@ -604,7 +1045,11 @@ sc_addr sc_storage_node_new_ext(const sc_memory_context *ctx, sc_type type, sc_a
         SC_ADDR_MAKE_EMPTY(addr);
     }
     else
+    {
+        sc_uint64 const lsn = _sc_storage_wal_append_element(addr);
         STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
+        sc_wal_wait(lsn);
+    }
     return addr;
 }
 
@@ -628,7 +1073,11 @@ sc_addr sc_storage_link_new_ext(const sc_memory_context *ctx, sc_access_levels a
         SC_ADDR_MAKE_EMPTY(addr);
     }
     else
+    {
+        sc_uint64 const lsn = _sc_storage_wal_append_element(addr);
         STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
+        sc_wal_wait(lsn);
+    }
     return addr;
 }
 
@@ -641,6 +1090,7 @@ sc_addr sc_storage_arc_new_ext(const sc_memory_context *ctx, sc_type type, sc_ad
 {
     sc_addr addr;
     sc_element el;
+    sc_uint64 lsn = 0;
 
     memset(&el, 0, sizeof(el));
     g_assert( !(sc_type_node & type) );
@@ -700,91 +1150,588 @@ sc_addr sc_storage_arc_new_ext(const sc_memory_context *ctx, sc_type type, sc_ad
                 goto unlock;
         }
 
-        // get new element
-        tmp_el = sc_storage_append_el_into_segments(ctx, &el, &addr);
+        // get new element
+        tmp_el = sc_storage_append_el_into_segments(ctx, &el, &addr);
+
+        g_assert(tmp_el != 0);
+        g_assert(SC_ADDR_IS_NOT_EQUAL(addr, first_in_arc));
+
+        // emit events
+        sc_event_emit(beg, beg_access, SC_EVENT_ADD_OUTPUT_ARC, addr);
+        sc_event_emit(end, end_access, SC_EVENT_ADD_INPUT_ARC, addr);
+
+        // check values
+        g_assert(beg_el != null_ptr && end_el != null_ptr);
+        g_assert(beg_el->flags.type != 0 && end_el->flags.type != 0);
+
+        // set next output arc for our created arc
+        tmp_el->arc.next_out_arc = first_out_arc;
+        tmp_el->arc.next_in_arc = first_in_arc;
+
+        g_assert(SC_ADDR_IS_NOT_EQUAL(addr, first_out_arc) && SC_ADDR_IS_NOT_EQUAL(addr, first_in_arc));
+        if (f_out_arc)
+        {
+            f_out_arc->arc.prev_out_arc = addr;
+            _sc_storage_set_dirty(first_out_arc);
+        }
+
+        if (f_in_arc)
+        {
+            f_in_arc->arc.prev_in_arc = addr;
+            _sc_storage_set_dirty(first_in_arc);
+        }
+
+        // set our arc as first output/input at begin/end elements
+        beg_el->first_out_arc = addr;
+        end_el->first_in_arc = addr;
+        _sc_storage_set_dirty(beg);
+        _sc_storage_set_dirty(end);
+
+        if (sc_arc_index_is_enabled() == SC_TRUE)
+            sc_arc_index_append(addr, beg, end);
+
+        sc_element_meta *beg_meta = sc_storage_get_element_meta(ctx, beg);
+        sc_element_meta *end_meta = sc_storage_get_element_meta(ctx, end);
+        if (beg_meta->degree_counted)
+            beg_meta->out_degree++;
+        if (end_meta->degree_counted)
+            end_meta->in_degree++;
+        if (beg_meta->adjacency)
+            sc_adjacency_append(beg, SC_ADJACENCY_OUT, addr, tmp_el->flags.type, end);
+        if (end_meta->adjacency)
+            sc_adjacency_append(end, SC_ADJACENCY_IN, addr, tmp_el->flags.type, beg);
+
+        if (sc_wal_is_enabled() == SC_TRUE)
+        {
+            sc_addr_hash changed[5];
+            sc_uint32 changed_count = 0;
+
+            changed[changed_count++] = SC_ADDR_LOCAL_TO_INT(addr);
+            changed[changed_count++] = SC_ADDR_LOCAL_TO_INT(beg);
+            if (SC_ADDR_IS_NOT_EQUAL(beg, end))
+                changed[changed_count++] = SC_ADDR_LOCAL_TO_INT(end);
+            if (f_out_arc)
+                changed[changed_count++] = SC_ADDR_LOCAL_TO_INT(first_out_arc);
+            if (f_in_arc && SC_ADDR_IS_NOT_EQUAL(first_in_arc, first_out_arc))
+                changed[changed_count++] = SC_ADDR_LOCAL_TO_INT(first_in_arc);
+
+            lsn = _sc_storage_wal_append(changed, changed_count);
+        }
+
+        unlock:
+        {
+            if (beg_el)
+            {
+                if (f_out_arc)
+                    sc_storage_element_unlock(ctx, first_out_arc);
+                sc_storage_element_unlock(ctx, beg);
+            }
+            if (end_el)
+            {
+                if (f_in_arc)
+                    sc_storage_element_unlock(ctx, first_in_arc);
+                sc_storage_element_unlock(ctx, end);
+            }
+
+            if (tmp_el)
+                sc_storage_element_unlock(ctx, addr);
+            if (r != SC_RESULT_OK)
+                return addr;
+        }
+
+    }
+
+    sc_wal_wait(lsn);
+
+    sc_event_notify_arc_created(addr, beg, end);
+
+    return addr;
+}
+
+// ----------------------------- bulk creation ---------------------------------
+/*! Bulk creation reserves slots for all new sc-elements first. Reserved slot has type sc_flag_reserved,
+ * so readers see it as invalid, allocations don't take it and save stores it as empty. Then sections of new sc-elements, of existing
+ * begin/end sc-elements and of their first output/input sc-arcs are locked once in ascending order (like in
+ * deletion), all sc-elements are written and linked under these locks and events are emitted after unlock.
+ * So batch is created atomically: other contexts see all of its sc-elements or none of them.
+ */
+
+//! Returns begin (\p begin == SC_TRUE) or end of sc-arc described by \p spec. Batch elements are taken from \p addrs
+sc_addr _sc_storage_spec_arc_end(sc_element_spec const *spec, sc_bool begin, sc_addr const *addrs)
+{
+    sc_uint32 const index = (begin == SC_TRUE) ? spec->begin_index : spec->end_index;
+    if (index != SC_ELEMENT_SPEC_NO_INDEX)
+        return addrs[index];
+
+    return (begin == SC_TRUE) ? spec->begin : spec->end;
+}
+
+//! Returns SC_TRUE, if begin (\p begin == SC_TRUE) or end of sc-arc described by \p spec is existing sc-element
+sc_bool _sc_storage_spec_arc_end_exists(sc_element_spec const *spec, sc_bool begin)
+{
+    return ((begin == SC_TRUE ? spec->begin_index : spec->end_index) == SC_ELEMENT_SPEC_NO_INDEX) ? SC_TRUE : SC_FALSE;
+}
+
+//! Checks types of sc-elements and references to begin/end of sc-arcs in \p specs
+sc_result _sc_storage_specs_check(sc_element_spec const *specs, sc_uint32 count)
+{
+    sc_uint32 i, j;
+
+    for (i = 0; i < count; ++i)
+    {
+        sc_element_spec const *spec = &specs[i];
+        if (!(spec->type & sc_type_arc_mask))
+            continue;
+
+        if (spec->type & (sc_type_node | sc_type_link))
+            return SC_RESULT_ERROR_INVALID_TYPE;
+
+        for (j = 0; j < 2; ++j)
+        {
+            sc_bool const begin = (j == 0) ? SC_TRUE : SC_FALSE;
+            sc_uint32 const index = (begin == SC_TRUE) ? spec->begin_index : spec->end_index;
+            sc_addr const addr = (begin == SC_TRUE) ? spec->begin : spec->end;
+
+            // sc-arc can refer just to previous elements of batch
+            if (index != SC_ELEMENT_SPEC_NO_INDEX && index >= i)
+                return SC_RESULT_ERROR_INVALID_PARAMS;
+
+            if (index == SC_ELEMENT_SPEC_NO_INDEX &&
+                (addr.seg >= SC_ADDR_SEG_MAX || sc_segment_table_get(segments, addr.seg) == null_ptr))
+                return SC_RESULT_ERROR_INVALID_PARAMS;
+        }
+    }
+
+    return SC_RESULT_OK;
+}
+
+/*! Returns reserved slots back to segments. Sections of slots can be already locked by context.
+ * Slots, that aren't reserved anymore, are left as is
+ */
+void _sc_storage_elements_release(const sc_memory_context *ctx, sc_addr const *addrs, sc_uint32 count)
+{
+    sc_uint32 i;
+    for (i = 0; i < count; ++i)
+    {
+        sc_element *el = null_ptr;
+        if (sc_storage_element_lock(ctx, addrs[i], &el) != SC_RESULT_OK)
+            continue;
+
+        g_assert(el != null_ptr);
+        if (sc_element_is_reserved(el) == SC_TRUE)
+        {
+            sc_storage_erase_element_from_segment(addrs[i]);
+            _sc_free_segments_push(sc_segment_table_get(segments, addrs[i].seg));
+        }
+        else
+            g_warning("Slot %u:%u isn't reserved, so it isn't released", addrs[i].seg, addrs[i].offset);
+        STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addrs[i]));
+    }
+}
+
+//! Reserves slots for \p count new sc-elements. Returns SC_FALSE, if there are no more free space
+sc_bool _sc_storage_elements_reserve(const sc_memory_context *ctx, sc_addr *addrs, sc_uint32 count)
+{
+    sc_uint32 i = 0;
+    while (i < count)
+    {
+        // slots are taken by chunks from section of context slab, each chunk locks section once
+        sc_uint32 const taken = _sc_storage_lock_empty_elements(ctx, &addrs[i], count - i);
+        if (taken == 0)
+        {
+            _sc_storage_elements_release(ctx, addrs, i);
+            return SC_FALSE;
+        }
+
+        STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addrs[i]));
+        i += taken;
+    }
+
+    return SC_TRUE;
+}
+
+/*! Predicts sections, that would be required for bulk creation: sections of new sc-elements, of existing
+ * begin/end sc-elements and of their first output/input sc-arcs
+ */
+void _sc_storage_elements_predict(const sc_memory_context *ctx, sc_element_spec const *specs, sc_uint32 count,
+                                  sc_addr const *addrs, sc_storage_free_scratch *scratch)
+{
+    sc_uint32 i, j;
+
+    for (i = 0; i < count; ++i)
+    {
+        sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(addrs[i]));
+        if (!(specs[i].type & sc_type_arc_mask))
+            continue;
+
+        for (j = 0; j < 2; ++j)
+        {
+            sc_bool const begin = (j == 0) ? SC_TRUE : SC_FALSE;
+            sc_addr const addr = _sc_storage_spec_arc_end(&specs[i], begin, addrs);
+            sc_addr first_arc;
+            sc_element el;
+
+            if (_sc_storage_spec_arc_end_exists(&specs[i], begin) == SC_FALSE)
+                continue;
+
+            sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(addr));
+            if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
+                continue;
+
+            first_arc = (begin == SC_TRUE) ? el.first_out_arc : el.first_in_arc;
+            if (SC_ADDR_IS_NOT_EMPTY(first_arc))
+                sc_addr_set_add(&scratch->sections, SC_STORAGE_SECTION_KEY(first_arc));
+        }
+    }
+}
+
+/*! Checks, that existing begin/end sc-elements are valid and that sections of their first output/input sc-arcs
+ * are locked. Missing sections are appended into scratch. All predicted sections must be locked
+ */
+sc_result _sc_storage_elements_collect(sc_element_spec const *specs, sc_uint32 count, sc_addr const *addrs,
+                                       sc_storage_free_scratch *scratch)
+{
+    sc_uint32 i, j;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!(specs[i].type & sc_type_arc_mask))
+            continue;
+
+        for (j = 0; j < 2; ++j)
+        {
+            sc_bool const begin = (j == 0) ? SC_TRUE : SC_FALSE;
+            sc_addr const addr = _sc_storage_spec_arc_end(&specs[i], begin, addrs);
+            sc_addr first_arc;
+            sc_element *el;
+
+            if (_sc_storage_spec_arc_end_exists(&specs[i], begin) == SC_FALSE)
+                continue;
+
+            el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(addr));
+            if (sc_element_is_valid(el) == SC_FALSE)
+                return SC_RESULT_ERROR_INVALID_STATE;
+
+            first_arc = (begin == SC_TRUE) ? el->first_out_arc : el->first_in_arc;
+            if (SC_ADDR_IS_NOT_EMPTY(first_arc))
+                _sc_storage_free_require(scratch, first_arc);
+        }
+    }
+
+    return SC_RESULT_OK;
+}
+
+/*! Writes all sc-elements into reserved slots and links sc-arcs into output/input lists. Access levels of
+ * begin and end of i-th sc-arc are stored into \p ends_access[2 * i] and \p ends_access[2 * i + 1] to emit events
+ * after unlock. All required sections must be locked
+ */
+void _sc_storage_elements_write(const sc_memory_context *ctx, sc_element_spec const *specs, sc_uint32 count,
+                                sc_addr const *addrs, sc_access_levels *ends_access, sc_storage_free_scratch *scratch)
+{
+    sc_uint32 i;
+
+    sc_addr_set_clear(&scratch->changed);
+    for (i = 0; i < count; ++i)
+    {
+        sc_element_spec const *spec = &specs[i];
+        sc_addr const addr = addrs[i];
+        sc_element *el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(addr));
+
+        memset(el, 0, sizeof(sc_element));
+        el->flags.access_levels = ctx->access_levels;
+
+        if (spec->type & sc_type_arc_mask)
+        {
+            sc_addr const beg = _sc_storage_spec_arc_end(spec, SC_TRUE, addrs);
+            sc_addr const end = _sc_storage_spec_arc_end(spec, SC_FALSE, addrs);
+            sc_element *beg_el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(beg));
+            sc_element *end_el = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(end));
+
+            el->flags.type = sc_flags_remove(spec->type);
+            el->arc.begin = beg;
+            el->arc.end = end;
+
+            // new sc-arc becomes the first one in output list of begin and in input list of end
+            el->arc.next_out_arc = beg_el->first_out_arc;
+            el->arc.next_in_arc = end_el->first_in_arc;
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_out_arc))
+            {
+                _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(el->arc.next_out_arc))->arc.prev_out_arc = addr;
+                _sc_storage_free_changed(scratch, el->arc.next_out_arc);
+            }
+            if (SC_ADDR_IS_NOT_EMPTY(el->arc.next_in_arc))
+            {
+                _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(el->arc.next_in_arc))->arc.prev_in_arc = addr;
+                _sc_storage_free_changed(scratch, el->arc.next_in_arc);
+            }
+
+            beg_el->first_out_arc = addr;
+            end_el->first_in_arc = addr;
+            _sc_storage_free_changed(scratch, beg);
+            _sc_storage_free_changed(scratch, end);
+
+            ends_access[2 * i] = beg_el->flags.access_levels;
+            ends_access[2 * i + 1] = end_el->flags.access_levels;
+
+            if (sc_arc_index_is_enabled() == SC_TRUE)
+                sc_arc_index_append(addr, beg, end);
+
+            sc_element_meta *beg_meta = sc_storage_get_element_meta(ctx, beg);
+            sc_element_meta *end_meta = sc_storage_get_element_meta(ctx, end);
+            if (beg_meta->degree_counted)
+                beg_meta->out_degree++;
+            if (end_meta->degree_counted)
+                end_meta->in_degree++;
+            if (beg_meta->adjacency)
+                sc_adjacency_append(beg, SC_ADJACENCY_OUT, addr, el->flags.type, end);
+            if (end_meta->adjacency)
+                sc_adjacency_append(end, SC_ADJACENCY_IN, addr, el->flags.type, beg);
+        }
+        else if (spec->type & sc_type_link)
+            el->flags.type = sc_flags_remove(spec->type);
+        else
+            el->flags.type = sc_flags_remove(sc_type_node | spec->type);
+
+        sc_cardinality_append(el->flags.type);
+        _sc_storage_free_changed(scratch, addr);
+    }
+}
+
+sc_result sc_storage_elements_new(const sc_memory_context *ctx, sc_element_spec const *specs, sc_uint32 count, sc_addr *result)
+{
+    sc_storage_free_scratch *scratch = 0;
+    sc_access_levels *ends_access = 0;
+    sc_result res = SC_RESULT_OK;
+    sc_uint32 i, locked = 0;
+    sc_uint64 lsn = 0;
+
+    if (count == 0)
+        return SC_RESULT_OK;
+
+    if (specs == null_ptr || result == null_ptr)
+        return SC_RESULT_ERROR_INVALID_PARAMS;
+
+    res = _sc_storage_specs_check(specs, count);
+    if (res != SC_RESULT_OK)
+        return res;
+
+    if (_sc_storage_elements_reserve(ctx, result, count) == SC_FALSE)
+    {
+        for (i = 0; i < count; ++i)
+            SC_ADDR_MAKE_EMPTY(result[i]);
+        return SC_RESULT_ERROR;
+    }
+
+    scratch = _sc_storage_free_scratch_acquire(ctx);
+    sc_addr_set_clear(&scratch->sections);
+    sc_addr_set_clear(&scratch->missing);
+    _sc_storage_elements_predict(ctx, specs, count, result, scratch);
+
+    while (SC_TRUE)
+    {
+        sc_addr_set_sort(&scratch->sections);
+        locked = scratch->sections.count;
+        _sc_storage_sections_lock(ctx, &scratch->sections, locked);
+
+        res = _sc_storage_elements_collect(specs, count, result, scratch);
+        if (res != SC_RESULT_OK || scratch->missing.count == 0)
+            break;
+
+        // first sc-arcs of some begin/end sc-elements were changed concurrently, so repeat with their sections
+        _sc_storage_sections_unlock(ctx, &scratch->sections, locked);
+        for (i = 0; i < scratch->missing.count; ++i)
+            sc_addr_set_add(&scratch->sections, scratch->missing.items[i]);
+        sc_addr_set_clear(&scratch->missing);
+    }
+
+    if (res == SC_RESULT_OK)
+    {
+        ends_access = g_new(sc_access_levels, 2 * count);
+        _sc_storage_elements_write(ctx, specs, count, result, ends_access, scratch);
+        lsn = _sc_storage_wal_append(scratch->changed.items, scratch->changed.count);
+    }
+    else
+        _sc_storage_elements_release(ctx, result, count);
+
+    _sc_storage_sections_unlock(ctx, &scratch->sections, locked);
+    _sc_storage_free_scratch_release(ctx, scratch);
+
+    sc_wal_wait(lsn);
+
+    if (res != SC_RESULT_OK)
+    {
+        for (i = 0; i < count; ++i)
+            SC_ADDR_MAKE_EMPTY(result[i]);
+        return res;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!(specs[i].type & sc_type_arc_mask))
+            continue;
+
+        sc_event_emit(_sc_storage_spec_arc_end(&specs[i], SC_TRUE, result), ends_access[2 * i], SC_EVENT_ADD_OUTPUT_ARC, result[i]);
+        sc_event_emit(_sc_storage_spec_arc_end(&specs[i], SC_FALSE, result), ends_access[2 * i + 1], SC_EVENT_ADD_INPUT_ARC, result[i]);
+        sc_event_notify_arc_created(result[i], _sc_storage_spec_arc_end(&specs[i], SC_TRUE, result), _sc_storage_spec_arc_end(&specs[i], SC_FALSE, result));
+    }
+    g_free(ends_access);
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_storage_find_arc(const sc_memory_context *ctx, sc_addr beg, sc_addr end, sc_type arc_type, sc_addr *result)
+{
+    sc_access_levels levels;
+    sc_addr buffer[16];
+    sc_addr *arcs = buffer;
+    sc_uint32 i, count;
+    sc_result res = SC_RESULT_ERROR_NOT_FOUND;
+
+    if (sc_storage_get_access_levels(ctx, beg, &levels) != SC_RESULT_OK || !sc_access_lvl_check_read(ctx->access_levels, levels) ||
+        sc_storage_get_access_levels(ctx, end, &levels) != SC_RESULT_OK || !sc_access_lvl_check_read(ctx->access_levels, levels))
+    {
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
+    }
+
+    // index doesn't contain sc-arcs of segments, that weren't used yet
+    if (sc_arc_index_is_enabled() == SC_FALSE || _sc_storage_segments_counted() == SC_FALSE)
+    {
+        sc_iterator3 *it = sc_iterator3_f_a_f_new(ctx, beg, arc_type, end);
+        if (it == null_ptr)
+            return SC_RESULT_ERROR;
+
+        if (sc_iterator3_next(it) == SC_TRUE)
+        {
+            *result = sc_iterator3_value(it, 1);
+            res = SC_RESULT_OK;
+        }
+
+        sc_iterator3_free(it);
+        return res;
+    }
 
-        g_assert(tmp_el != 0);
-        g_assert(SC_ADDR_IS_NOT_EQUAL(addr, first_in_arc));
+    count = sc_arc_index_find(beg, end, arcs, G_N_ELEMENTS(buffer));
+    if (count > G_N_ELEMENTS(buffer))
+    {
+        // sc-arcs, that are created after the first search, can be skipped
+        sc_uint32 const capacity = count;
+        arcs = g_new(sc_addr, capacity);
+        count = MIN(sc_arc_index_find(beg, end, arcs, capacity), capacity);
+    }
 
-        // emit events
-        sc_event_emit(beg, beg_access, SC_EVENT_ADD_OUTPUT_ARC, addr);
-        sc_event_emit(end, end_access, SC_EVENT_ADD_INPUT_ARC, addr);
+    for (i = 0; i < count && res != SC_RESULT_OK; ++i)
+    {
+        sc_element *el = null_ptr;
+        if (sc_storage_element_lock(ctx, arcs[i], &el) != SC_RESULT_OK || el == null_ptr)
+            continue;
 
-        // check values
-        g_assert(beg_el != null_ptr && end_el != null_ptr);
-        g_assert(beg_el->flags.type != 0 && end_el->flags.type != 0);
+        // sc-arc can be deleted after search in index, so its element is checked
+        if ((el->flags.type & sc_type_arc_mask) &&
+            sc_element_is_request_deletion(el) == SC_FALSE &&
+            SC_ADDR_IS_EQUAL(el->arc.begin, beg) &&
+            SC_ADDR_IS_EQUAL(el->arc.end, end) &&
+            sc_iterator_compare_type(el->flags.type, arc_type) &&
+            sc_access_lvl_check_read(ctx->access_levels, el->flags.access_levels))
+        {
+            *result = arcs[i];
+            res = SC_RESULT_OK;
+        }
 
-        // set next output arc for our created arc
-        tmp_el->arc.next_out_arc = first_out_arc;
-        tmp_el->arc.next_in_arc = first_in_arc;
+        STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, arcs[i]));
+    }
 
-        g_assert(SC_ADDR_IS_NOT_EQUAL(addr, first_out_arc) && SC_ADDR_IS_NOT_EQUAL(addr, first_in_arc));
-        if (f_out_arc)
-            f_out_arc->arc.prev_out_arc = addr;
+    if (arcs != buffer)
+        g_free(arcs);
 
-        if (f_in_arc)
-            f_in_arc->arc.prev_in_arc = addr;
+    return res;
+}
 
-        // set our arc as first output/input at begin/end elements
-        beg_el->first_out_arc = addr;
-        end_el->first_in_arc = addr;
+//! Appends sc-arcs from list, that starts with \p arc_addr, into adjacency of \p addr. Element must be locked
+sc_result _sc_storage_adjacency_build_list(const sc_memory_context *ctx, sc_addr addr, sc_addr arc_addr, sc_adjacency_direction dir)
+{
+    while (SC_ADDR_IS_NOT_EMPTY(arc_addr))
+    {
+        sc_element *arc_el = null_ptr;
+        sc_addr const arc = arc_addr;
 
-        unlock:
-        {
-            if (beg_el)
-            {
-                if (f_out_arc)
-                    sc_storage_element_unlock(ctx, first_out_arc);
-                sc_storage_element_unlock(ctx, beg);
-            }
-            if (end_el)
-            {
-                if (f_in_arc)
-                    sc_storage_element_unlock(ctx, first_in_arc);
-                sc_storage_element_unlock(ctx, end);
-            }
+        // sc-arc is locked, so its type isn't changed until it's appended
+        if (sc_storage_element_lock_try(ctx, arc, s_max_storage_lock_attempts, &arc_el) != SC_RESULT_OK || arc_el == null_ptr)
+            return SC_RESULT_ERROR;
 
-            if (tmp_el)
-                sc_storage_element_unlock(ctx, addr);
-            if (r != SC_RESULT_OK)
-                return addr;
+        if (dir == SC_ADJACENCY_OUT)
+        {
+            sc_adjacency_append(addr, dir, arc, arc_el->flags.type, arc_el->arc.end);
+            arc_addr = arc_el->arc.next_out_arc;
+        }
+        else
+        {
+            sc_adjacency_append(addr, dir, arc, arc_el->flags.type, arc_el->arc.begin);
+            arc_addr = arc_el->arc.next_in_arc;
         }
 
+        STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, arc));
     }
 
-    return addr;
+    return SC_RESULT_OK;
 }
 
-sc_result sc_storage_get_element_type(const sc_memory_context *ctx, sc_addr addr, sc_type *result)
+sc_result sc_storage_adjacency_build(const sc_memory_context *ctx, sc_addr addr)
 {
     sc_element *el = null_ptr;
+    sc_element_meta *meta = null_ptr;
     sc_result r = SC_RESULT_OK;
 
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK || el == null_ptr)
         return SC_RESULT_ERROR;
-        
-    if (sc_element_is_valid(el) == SC_FALSE)
-    {
-        r = SC_RESULT_ERROR_INVALID_STATE;
+
+    meta = sc_storage_get_element_meta(ctx, addr);
+    if (meta->adjacency || sc_element_is_valid(el) == SC_FALSE)
         goto unlock;
-    }
 
-    if (sc_access_lvl_check_read(ctx->access_levels, el->flags.access_levels))
-        *result = sc_flags_remove(el->flags.type);
+    // output and input lists of element are changed under its lock
+    sc_adjacency_create(addr);
+    r = _sc_storage_adjacency_build_list(ctx, addr, el->first_out_arc, SC_ADJACENCY_OUT);
+    if (r == SC_RESULT_OK)
+        r = _sc_storage_adjacency_build_list(ctx, addr, el->first_in_arc, SC_ADJACENCY_IN);
+
+    if (r == SC_RESULT_OK)
+    {
+        sc_adjacency_reverse(addr);
+        meta->adjacency = 1;
+    }
     else
-        r = SC_RESULT_ERROR_NO_READ_RIGHTS;
+        sc_adjacency_drop(addr);
 
     unlock:
     {
-        sc_storage_element_unlock(ctx, addr);
+        STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
     }
+
     return r;
 }
 
+sc_result sc_storage_get_element_type(const sc_memory_context *ctx, sc_addr addr, sc_type *result)
+{
+    sc_element el;
+
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
+        return SC_RESULT_ERROR;
+
+    if (sc_element_is_valid(&el) == SC_FALSE)
+        return SC_RESULT_ERROR_INVALID_STATE;
+
+    if (!sc_access_lvl_check_read(ctx->access_levels, el.flags.access_levels))
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
+
+    *result = sc_flags_remove(el.flags.type);
+    return SC_RESULT_OK;
+}
+
 sc_result sc_storage_change_element_subtype(const sc_memory_context *ctx, sc_addr addr, sc_type type)
 {
     sc_element *el = null_ptr;
     sc_result r = SC_RESULT_OK;
+    sc_uint64 lsn = 0;
 
     if (type & sc_type_element_mask)
         return SC_RESULT_ERROR_INVALID_PARAMS;
@@ -799,118 +1746,130 @@ sc_result sc_storage_change_element_subtype(const sc_memory_context *ctx, sc_add
     }
 
     if (sc_access_lvl_check_write(ctx->access_levels, el->flags.access_levels))
+    {
+        sc_type const old_type = el->flags.type;
         el->flags.type = (el->flags.type & sc_type_element_mask) | (type & ~sc_type_element_mask);
+        sc_cardinality_change(old_type, el->flags.type);
+        _sc_storage_set_dirty(addr);
+
+        // adjacencies of begin and end are changed under lock of sc-arc, so they aren't built meanwhile
+        if (el->flags.type & sc_type_arc_mask)
+        {
+            sc_adjacency_change_type(el->arc.begin, SC_ADJACENCY_OUT, addr, el->arc.end, el->flags.type);
+            sc_adjacency_change_type(el->arc.end, SC_ADJACENCY_IN, addr, el->arc.begin, el->flags.type);
+        }
+        lsn = _sc_storage_wal_append_element(addr);
+    }
     else
         r = SC_RESULT_ERROR_NO_WRITE_RIGHTS;
 
     unlock:
     {
         sc_storage_element_unlock(ctx, addr);
+        sc_wal_wait(lsn);
     }
     return r;
 }
 
 sc_result sc_storage_get_arc_begin(const sc_memory_context *ctx, sc_addr addr, sc_addr *result)
 {
-    sc_element *el = null_ptr;
-    sc_result res = SC_RESULT_ERROR_INVALID_TYPE;
+    sc_element el;
 
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
         return SC_RESULT_ERROR;
-        
-    if (sc_element_is_valid(el) == SC_FALSE)
-    {
-        res = SC_RESULT_ERROR_INVALID_STATE;
-        goto unlock;
-    }
 
-    if (sc_access_lvl_check_read(ctx->access_levels, el->flags.access_levels))
-    {
-        if (el->flags.type & sc_type_arc_mask)
-        {
-            *result = el->arc.begin;
-            res = SC_RESULT_OK;
-        }
-    } else
-        res = SC_RESULT_ERROR_NO_READ_RIGHTS;
+    if (sc_element_is_valid(&el) == SC_FALSE)
+        return SC_RESULT_ERROR_INVALID_STATE;
 
-    unlock:
-    {
-        sc_storage_element_unlock(ctx, addr);
-    }
-    return res;
+    if (!sc_access_lvl_check_read(ctx->access_levels, el.flags.access_levels))
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
+
+    if (!(el.flags.type & sc_type_arc_mask))
+        return SC_RESULT_ERROR_INVALID_TYPE;
+
+    *result = el.arc.begin;
+    return SC_RESULT_OK;
 }
 
 sc_result sc_storage_get_arc_end(const sc_memory_context *ctx, sc_addr addr, sc_addr *result)
 {
-    sc_element *el = null_ptr;
-    sc_result res = SC_RESULT_ERROR_INVALID_TYPE;
+    sc_element el;
 
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
         return SC_RESULT_ERROR;
 
-    if (sc_element_is_valid(el) == SC_FALSE)
-    {
-        res = SC_RESULT_ERROR_INVALID_STATE;
-        goto unlock;
-    }
+    if (sc_element_is_valid(&el) == SC_FALSE)
+        return SC_RESULT_ERROR_INVALID_STATE;
 
-    if (sc_access_lvl_check_read(ctx->access_levels, el->flags.access_levels))
-    {
-        if (el->flags.type & sc_type_arc_mask)
-        {
-            *result = el->arc.end;
-            res = SC_RESULT_OK;
-        }
-    } else
-        res = SC_RESULT_ERROR_NO_READ_RIGHTS;
+    if (!sc_access_lvl_check_read(ctx->access_levels, el.flags.access_levels))
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
 
-    unlock:
-    {
-        sc_storage_element_unlock(ctx, addr);
-    }
-    return res;
+    if (!(el.flags.type & sc_type_arc_mask))
+        return SC_RESULT_ERROR_INVALID_TYPE;
+
+    *result = el.arc.end;
+    return SC_RESULT_OK;
 }
 
 sc_result sc_storage_get_arc_info(sc_memory_context const * ctx, sc_addr addr, sc_addr * result_begin_addr, sc_addr * result_end_addr)
 {
-    sc_element *el = null_ptr;
-    sc_result res = SC_RESULT_ERROR_INVALID_TYPE;
+    sc_element el;
 
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
         return SC_RESULT_ERROR;
 
-    if (sc_element_is_valid(el) == SC_FALSE)
-    {
-        res = SC_RESULT_ERROR_INVALID_STATE;
-        goto unlock;
-    }
+    if (sc_element_is_valid(&el) == SC_FALSE)
+        return SC_RESULT_ERROR_INVALID_STATE;
+
+    if (!sc_access_lvl_check_read(ctx->access_levels, el.flags.access_levels))
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
+
+    if (!(el.flags.type & sc_type_arc_mask))
+        return SC_RESULT_ERROR_INVALID_TYPE;
+
+    *result_begin_addr = el.arc.begin;
+    *result_end_addr = el.arc.end;
+    return SC_RESULT_OK;
+}
+
+/*! Checks if content with the same binary checksum, that is stored already, differs from data in \p stream.
+ * Fast checksum isn't cryptographic and clients can choose contents, so it's verified by stored content
+ * (it reads stored content on each match), unless it's disabled in config. Contents, that collide with stored ones, are stored by legacy
+ * checksum. Self container contents have no stored data, so they aren't checked
+ */
+sc_bool _sc_storage_checksum_collides(const sc_check_sum *check_sum, const sc_stream *stream)
+{
+    sc_stream *stored = null_ptr;
+    sc_uint32 len = 0;
+    sc_bool result = SC_FALSE;
+
+    if (sc_config_fm_verify_checksum() == SC_FALSE || sc_link_checksum_is_binary(check_sum) == SC_FALSE)
+        return SC_FALSE;
 
-    if (sc_access_lvl_check_read(ctx->access_levels, el->flags.access_levels))
+    if (sc_stream_get_length(stream, &len) != SC_RESULT_OK || len < SC_CHECKSUM_LEN)
+        return SC_FALSE;
+
+    if (sc_fs_storage_get_checksum_content(check_sum, &stored) == SC_RESULT_OK && stored != null_ptr)
     {
-        if (el->flags.type & sc_type_arc_mask)
+        if (sc_link_streams_equal(stored, stream) == SC_FALSE)
         {
-            *result_begin_addr = el->arc.begin;
-            *result_end_addr = el->arc.end;
-            res = SC_RESULT_OK;
+            g_warning("Checksum collision of sc-link contents, legacy checksum is used");
+            result = SC_TRUE;
         }
+        sc_stream_free(stored);
     }
-    else
-        res = SC_RESULT_ERROR_NO_READ_RIGHTS;
 
-unlock:
-    {
-        sc_storage_element_unlock(ctx, addr);
-    }
-    return res;
+    return result;
 }
 
 sc_result sc_storage_set_link_content(const sc_memory_context *ctx, sc_addr addr, const sc_stream *stream)
 {
     sc_element *el;
+    sc_content *content;
     sc_check_sum check_sum;
     sc_result result = SC_RESULT_ERROR;
     sc_access_levels access_lvl;
+    sc_uint64 lsn = 0;
 
     if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
         return SC_RESULT_ERROR;
@@ -936,20 +1895,19 @@ sc_result sc_storage_set_link_content(const sc_memory_context *ctx, sc_addr addr
         goto unlock;
     }
 
-    if (sc_element_is_checksum_empty(el) == SC_FALSE)
+    content = _sc_storage_get_locked_content(addr);
+    if (sc_element_is_checksum_empty(content) == SC_FALSE)
     {
         sc_check_sum sum;
         if (el->flags.type & sc_flag_link_self_container)
-            sc_link_self_container_calculate_checksum(el, &sum);
+            sc_link_self_container_calculate_checksum(content, &sum);
         else
-        {
-            sum.len = SC_CHECKSUM_LEN;
-            memcpy(&sum.data[0], el->content.data, SC_CHECKSUM_LEN);
-        }
+            sc_link_checksum_from_content(content, &sum);
 
         STORAGE_CHECK_CALL(sc_fs_storage_remove_content_addr(addr, &sum));
     }
 
+    _sc_storage_set_dirty(addr);
     if (sc_link_calculate_checksum(stream, &check_sum) == SC_TRUE)
     {
         sc_uint32 len = 0;
@@ -958,8 +1916,12 @@ sc_result sc_storage_set_link_content(const sc_memory_context *ctx, sc_addr addr
         {
             el->flags.type &= ~sc_flag_link_self_container;
 
+            if (_sc_storage_checksum_collides(&check_sum, stream) == SC_TRUE)
+                sc_link_calculate_checksum_by(stream, SC_CHECKSUM_SHA256, &check_sum);
+
             result = sc_fs_storage_write_content(addr, &check_sum, stream);
-            memcpy(el->content.data, check_sum.data, check_sum.len);
+            memset(content->data, 0, SC_CHECKSUM_LEN);
+            memcpy(content->data, check_sum.data, check_sum.len);
         } else
         {
             G_STATIC_ASSERT(SC_CHECKSUM_LEN < 256);
@@ -970,22 +1932,23 @@ sc_result sc_storage_set_link_content(const sc_memory_context *ctx, sc_addr addr
             STORAGE_CHECK_CALL(sc_stream_read_data(stream, &buff[0], len, &read));
             g_assert(read == len);
 
-            el->content.data[0] = (sc_uint8)len;
-            memcpy(&el->content.data[1], &buff[0], len);
+            content->data[0] = (sc_uint8)len;
+            memcpy(&content->data[1], &buff[0], len);
             result = SC_RESULT_OK;
 
-            sc_check_sum sum;
-            STORAGE_CHECK_CALL(sc_link_calculate_checksum(stream, &sum));
-            sc_fs_storage_add_content_addr(addr, &sum);
+            sc_fs_storage_add_content_addr(addr, &check_sum);
         }
     }
     g_assert(result == SC_RESULT_OK);
+    lsn = _sc_storage_wal_append_element(addr);
 
+    sc_event_notify_link_content_changed(addr, stream);
     sc_event_emit(addr, access_lvl, SC_EVENT_CONTENT_CHANGED, addr);
 
     unlock:
     {
         STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
+        sc_wal_wait(lsn);
     }
 
     return result;
@@ -994,6 +1957,7 @@ sc_result sc_storage_set_link_content(const sc_memory_context *ctx, sc_addr addr
 sc_result sc_storage_get_link_content(const sc_memory_context *ctx, sc_addr addr, sc_stream **stream)
 {
     sc_element *el = null_ptr;
+    sc_content const *content = null_ptr;
     sc_result res = SC_RESULT_ERROR;
 
     if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
@@ -1017,15 +1981,16 @@ sc_result sc_storage_get_link_content(const sc_memory_context *ctx, sc_addr addr
         goto unlock;
     }
 
+    content = _sc_storage_get_locked_content(addr);
     if (el->flags.type & sc_flag_link_self_container)
     {
-        sc_uint8 len = el->content.data[0];
+        sc_uint8 len = content->data[0];
 
         if (len != 0)
         {
             g_assert(len < SC_CHECKSUM_LEN);
             gchar *buff = g_new0(gchar, len);
-            memcpy(buff, &el->content.data[1], len);
+            memcpy(buff, &content->data[1], len);
             *stream = sc_stream_memory_new(buff, len, SC_STREAM_FLAG_READ, SC_TRUE);
 
             res = SC_RESULT_OK;
@@ -1038,8 +2003,7 @@ sc_result sc_storage_get_link_content(const sc_memory_context *ctx, sc_addr addr
     {
         // prepare checksum
         sc_check_sum checksum;
-        checksum.len = SC_CHECKSUM_LEN;
-        memcpy(checksum.data, el->content.data, checksum.len);
+        sc_link_checksum_from_content(content, &checksum);
 
         res = sc_fs_storage_get_checksum_content(&checksum, stream);
     }
@@ -1066,6 +2030,9 @@ sc_result sc_storage_find_links_with_content(const sc_memory_context *ctx, const
         sc_addr * tmp_res = 0;
         sc_uint32 tmp_res_count = 0;
 
+        if (_sc_storage_checksum_collides(&check_sum, stream) == SC_TRUE)
+            sc_link_calculate_checksum_by(stream, SC_CHECKSUM_SHA256, &check_sum);
+
         r = sc_fs_storage_find_links_with_content(&check_sum, &tmp_res, &tmp_res_count);
         if (r == SC_RESULT_OK && tmp_res_count > 0)
         {
@@ -1109,6 +2076,7 @@ sc_result sc_storage_set_access_levels(const sc_memory_context *ctx, sc_addr add
 {
     sc_element *el = 0;
     sc_result r = SC_RESULT_OK;
+    sc_uint64 lsn = 0;
 
     if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
         return SC_RESULT_ERROR;
@@ -1116,6 +2084,8 @@ sc_result sc_storage_set_access_levels(const sc_memory_context *ctx, sc_addr add
     if (sc_access_lvl_check_write(ctx->access_levels, el->flags.access_levels))
     {
         el->flags.access_levels = sc_access_lvl_min(ctx->access_levels, access_levels);
+        _sc_storage_set_dirty(addr);
+        lsn = _sc_storage_wal_append_element(addr);
         if (new_value)
             *new_value = el->flags.access_levels;
     }
@@ -1123,27 +2093,23 @@ sc_result sc_storage_set_access_levels(const sc_memory_context *ctx, sc_addr add
         r = SC_RESULT_ERROR_NO_WRITE_RIGHTS;
 
     STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
+    sc_wal_wait(lsn);
 
     return r;
 }
 
 sc_result sc_storage_get_access_levels(const sc_memory_context *ctx, sc_addr addr, sc_access_levels * result)
 {
-    sc_element *el = null_ptr;
-    sc_result r = SC_RESULT_OK;
+    sc_element el;
 
-    if (sc_storage_element_lock(ctx, addr, &el) != SC_RESULT_OK)
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
         return SC_RESULT_ERROR;
 
-    if (sc_access_lvl_check_read(ctx->access_levels, el->flags.access_levels))
-    {
-        *result = el->flags.access_levels;
-    }
-    else
-        r = SC_RESULT_ERROR_NO_READ_RIGHTS;
+    if (!sc_access_lvl_check_read(ctx->access_levels, el.flags.access_levels))
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
 
-    STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
-    return r;
+    *result = el.flags.access_levels;
+    return SC_RESULT_OK;
 }
 
 
@@ -1159,7 +2125,7 @@ sc_result sc_storage_get_elements_stat(const sc_memory_context *ctx, sc_stat *st
     sc_int32 i;
     for (i = 0; i < g_atomic_int_get(&segments_num); ++i)
     {
-        sc_segment *seg = segments[i];
+        sc_segment *seg = sc_segment_table_get(segments, i);
         sc_segment_collect_elements_stat(ctx, seg, stat);
     }
 
@@ -1173,15 +2139,76 @@ unsigned int sc_storage_get_segments_count()
 
 sc_result sc_storage_erase_element_from_segment(sc_addr addr)
 {
-    sc_segment_erase_element(g_atomic_pointer_get(&segments[addr.seg]), addr.offset);
+    sc_segment_erase_element(sc_segment_table_get(segments, addr.seg), addr.offset);
+    return SC_RESULT_OK;
+}
+
+/*! Counts degrees of sc-element by its lists of sc-arcs, when they are requested first time. Then they are changed
+ * with lists, so loaded sc-elements aren't scanned until their degrees are used
+ */
+void _sc_storage_degree_count(const sc_memory_context *ctx, sc_addr addr, sc_uint32 *out_degree, sc_uint32 *in_degree)
+{
+    sc_element *el = null_ptr;
+    sc_element_meta *meta;
+    sc_addr arc;
+
+    STORAGE_CHECK_CALL(sc_storage_element_lock(ctx, addr, &el));
+    meta = sc_storage_get_element_meta(ctx, addr);
+    if (g_atomic_int_get((gint*)&meta->degree_counted) == 0)
+    {
+        sc_uint32 out = 0, in = 0;
+
+        // lists of sc-arcs are changed under lock of element, so sc-arcs in them aren't locked
+        for (arc = el->first_out_arc; SC_ADDR_IS_NOT_EMPTY(arc); arc = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(arc))->arc.next_out_arc)
+            ++out;
+        for (arc = el->first_in_arc; SC_ADDR_IS_NOT_EMPTY(arc); arc = _sc_storage_get_locked_element(SC_ADDR_LOCAL_TO_INT(arc))->arc.next_in_arc)
+            ++in;
+
+        g_atomic_int_set((gint*)&meta->out_degree, (gint)out);
+        g_atomic_int_set((gint*)&meta->in_degree, (gint)in);
+        g_atomic_int_set((gint*)&meta->degree_counted, 1);
+    }
+
+    *out_degree = meta->out_degree;
+    *in_degree = meta->in_degree;
+    STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
+}
+
+sc_result sc_storage_get_element_degree(const sc_memory_context *ctx, sc_addr addr, sc_uint32 *out_degree, sc_uint32 *in_degree)
+{
+    sc_element el;
+
+    if (sc_storage_element_read(ctx, addr, &el) != SC_RESULT_OK)
+        return SC_RESULT_ERROR;
+
+    if (sc_element_is_valid(&el) == SC_FALSE)
+        return SC_RESULT_ERROR_INVALID_STATE;
+
+    if (!sc_access_lvl_check_read(ctx->access_levels, el.flags.access_levels))
+        return SC_RESULT_ERROR_NO_READ_RIGHTS;
+
+    // degrees are changed under lock, but they are read as estimate, so lock isn't waited
+    sc_uint32 out = 0, in = 0;
+    if (sc_segment_get_degree(sc_segment_table_get(segments, addr.seg), addr.offset, &out, &in) == SC_FALSE)
+        _sc_storage_degree_count(ctx, addr, &out, &in);
+    if (out_degree != null_ptr)
+        *out_degree = out;
+    if (in_degree != null_ptr)
+        *in_degree = in;
+
     return SC_RESULT_OK;
 }
 
+sc_uint64 sc_storage_get_type_cardinality(sc_type type)
+{
+    return sc_cardinality_get(type);
+}
+
 // ------------------------------
 sc_element_meta* sc_storage_get_element_meta(const sc_memory_context *ctx, sc_addr addr)
 {
     g_assert(addr.seg < SC_ADDR_SEG_MAX);
-    sc_segment *segment = g_atomic_pointer_get(&segments[addr.seg]);
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
     g_assert(segment != null_ptr);
     return sc_segment_get_meta(ctx, segment, addr.offset);
 }
@@ -1194,7 +2221,7 @@ sc_result sc_storage_element_lock(const sc_memory_context *ctx, sc_addr addr, sc
         return SC_RESULT_ERROR;
     }
 
-    sc_segment *segment = g_atomic_pointer_get(&segments[addr.seg]);
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
     if (segment == 0)
     {
         *el = 0;
@@ -1213,7 +2240,7 @@ sc_result sc_storage_element_lock_try(const sc_memory_context *ctx, sc_addr addr
         return SC_RESULT_ERROR;
     }
 
-    sc_segment *segment = g_atomic_pointer_get(&segments[addr.seg]);
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
     if (segment == 0)
     {
         *el = 0;
@@ -1231,7 +2258,7 @@ sc_result sc_storage_element_unlock(const sc_memory_context *ctx, sc_addr addr)
     if (addr.seg >= SC_ADDR_SEG_MAX)
         return SC_RESULT_ERROR;
 
-    segment = g_atomic_pointer_get(&segments[addr.seg]);
+    segment = sc_segment_table_get(segments, addr.seg);
     if (segment == 0)
         return SC_RESULT_ERROR;
 
@@ -1239,38 +2266,102 @@ sc_result sc_storage_element_unlock(const sc_memory_context *ctx, sc_addr addr)
     return SC_RESULT_OK;
 }
 
-sc_result sc_storage_save(sc_memory_context const * ctx)
+sc_bool sc_storage_element_try_read(sc_addr addr, sc_element *el, sc_uint32 *version)
 {
-    sc_segment * seg;
-    sc_uint32 i;
+    sc_segment *segment;
 
-    // synchronize with free
-    g_mutex_lock(&s_mutex_free);
-    g_mutex_lock(&s_mutex_save);
+    if (addr.seg >= SC_ADDR_SEG_MAX || addr.offset >= SC_SEGMENT_ELEMENTS_COUNT)
+        return SC_FALSE;
 
-    for (i = 0; i < SC_SEGMENT_MAX; ++i)
-    {
-        seg = segments[i];
-        if (seg == null_ptr)
-            continue;
+    segment = sc_segment_table_get(segments, addr.seg);
+    if (segment == null_ptr)
+        return SC_FALSE;
 
-        sc_segment_lock(seg, ctx);
-    }
+    return sc_segment_read_element(segment, addr.offset, el, version);
+}
 
-    sc_fs_storage_write_to_path(segments);
+sc_bool sc_storage_element_validate(sc_addr addr, sc_uint32 version)
+{
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
+    g_assert(segment != null_ptr);
 
-    g_mutex_unlock(&s_mutex_free);
+    return sc_segment_validate_element(segment, addr.offset, version);
+}
 
-    for (i = 0; i < SC_SEGMENT_MAX; ++i)
-    {
-        seg = segments[i];
-        if (seg == null_ptr)
-            continue;
+sc_result sc_storage_element_read(const sc_memory_context *ctx, sc_addr addr, sc_element *el)
+{
+    sc_element *locked = null_ptr;
+    sc_uint32 version, attempt;
+
+    if (addr.seg >= SC_ADDR_SEG_MAX || sc_segment_table_get(segments, addr.seg) == null_ptr)
+        return SC_RESULT_ERROR;
 
-        sc_segment_unlock(seg, ctx);
+    for (attempt = 0; attempt < s_max_storage_read_attempts; ++attempt)
+    {
+        if (sc_storage_element_try_read(addr, el, &version) == SC_TRUE)
+            return SC_RESULT_OK;
     }
 
-    g_mutex_unlock(&s_mutex_save);
+    // section is locked for a long time or changed often, so reader waits for it
+    if (sc_storage_element_lock(ctx, addr, &locked) != SC_RESULT_OK)
+        return SC_RESULT_ERROR;
+    *el = *locked;
+    STORAGE_CHECK_CALL(sc_storage_element_unlock(ctx, addr));
 
     return SC_RESULT_OK;
 }
+
+sc_uint32 sc_storage_get_element_events_mask(sc_addr addr)
+{
+    if (segments == null_ptr || addr.seg >= SC_ADDR_SEG_MAX)
+        return 0;
+
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
+    if (segment == null_ptr)
+        return 0;
+
+    return sc_segment_get_events_mask(segment, addr.offset);
+}
+
+void sc_storage_add_element_events_mask(sc_addr addr, sc_uint32 bits)
+{
+    if (segments == null_ptr || addr.seg >= SC_ADDR_SEG_MAX)
+        return;
+
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
+    if (segment == null_ptr)
+        return;
+
+    sc_segment_add_events_mask(segment, addr.offset, bits);
+}
+
+void sc_storage_remove_element_events_mask(sc_addr addr, sc_uint32 bits)
+{
+    if (segments == null_ptr || addr.seg >= SC_ADDR_SEG_MAX)
+        return;
+
+    sc_segment *segment = sc_segment_table_get(segments, addr.seg);
+    if (segment == null_ptr)
+        return;
+
+    sc_segment_remove_events_mask(segment, addr.offset, bits);
+}
+
+sc_result sc_storage_save(sc_memory_context const * ctx)
+{
+    sc_bool result;
+    sc_uint32 log_num;
+
+    // segments are locked one by one while they are copied, so just one save can run at the time
+    g_mutex_lock(&s_mutex_save);
+
+    // changes, that can be missed by save, are logged into new file, so previous files aren't required after save
+    log_num = sc_wal_checkpoint_begin();
+    result = sc_fs_storage_write_to_path(segments, ctx);
+    if (result == SC_TRUE)
+        sc_wal_checkpoint_end(log_num);
+
+    g_mutex_unlock(&s_mutex_save);
+
+    return result == SC_TRUE ? SC_RESULT_OK : SC_RESULT_ERROR;
+}
@@ -17,7 +17,7 @@
 # define STORAGE_CHECK_CALL(x) { x; }
 #endif
 
-/*! Initialize sc storage in specified path
+/*! Initialize sc storage in specified path. Changes from write-ahead log are applied to loaded segments.
  * @param path Path to repository
  * @param clear Flag to clear initialize empty storage
  */
@@ -56,6 +56,22 @@ sc_addr sc_storage_element_new_access(const sc_memory_context *ctx, sc_type type
  */
 sc_result sc_storage_element_free(const sc_memory_context *ctx, sc_addr addr);
 
+//! Segment section, that reserved by context to allocate new sc-elements without contention with other contexts
+typedef struct _sc_storage_slab sc_storage_slab;
+
+//! Create new empty slab. Section would be reserved on first sc-element allocation
+sc_storage_slab* sc_storage_slab_new();
+//! Releases reserved section and destroys slab
+void sc_storage_slab_free(sc_storage_slab *slab);
+
+//! Scratch memory, that used by sc_storage_element_free and sc_storage_elements_new. Each context owns one, so they don't allocate memory
+typedef struct _sc_storage_free_scratch sc_storage_free_scratch;
+
+//! Create new scratch for sc-element deletion
+sc_storage_free_scratch* sc_storage_free_scratch_new();
+//! Destroys scratch for sc-element deletion
+void sc_storage_free_scratch_free(sc_storage_free_scratch *scratch);
+
 /*! Create new sc-node
  * @param type Type of new sc-node
  * @return Return sc-addr of created sc-node or empty sc-addr if sc-node wasn't created
@@ -85,6 +101,14 @@ sc_addr sc_storage_arc_new(sc_memory_context const * ctx, sc_type type, sc_addr
 //! Create new sc-arc with specified access levels
 sc_addr sc_storage_arc_new_ext(sc_memory_context const * ctx, sc_type type, sc_addr beg, sc_addr end, sc_access_levels access_levels);
 
+/*! Creates \p count sc-elements described by \p specs at once. Slots for them are reserved together, required segment
+ * sections are locked once and sc-arcs are linked under these locks, events are emitted after unlock.
+ * @param result Array of \p count sc-addrs, that receives sc-addrs of created sc-elements in order of \p specs
+ * @return If all sc-elements created, then returns SC_RESULT_OK. Otherwise none of them is created and \p result
+ * is filled with empty sc-addrs
+ */
+sc_result sc_storage_elements_new(sc_memory_context const * ctx, sc_element_spec const * specs, sc_uint32 count, sc_addr * result);
+
 /*! Get type of sc-element with specified sc-addr
  * @param addr sc-addr of element to get type
  * @param result Pointer to result container
@@ -121,6 +145,19 @@ sc_result sc_storage_get_arc_end(sc_memory_context const * ctx, sc_addr addr, sc
  */
 sc_result sc_storage_get_arc_info(sc_memory_context const * ctx, sc_addr addr, sc_addr * result_begin_addr, sc_addr * result_end_addr);
 
+/*! Finds sc-arc with specified type between \p beg and \p end elements. It uses index of sc-arcs,
+ * if it's enabled (see sc_arc_index.h); otherwise input sc-arcs of \p end element are iterated.
+ * @param result Pointer to container for found sc-arc
+ * @return If sc-arc found, then returns SC_RESULT_OK; if it doesn't exist, then returns SC_RESULT_ERROR_NOT_FOUND
+ */
+sc_result sc_storage_find_arc(sc_memory_context const * ctx, sc_addr beg, sc_addr end, sc_type arc_type, sc_addr * result);
+
+/*! Builds secondary adjacency of sc-element with \p addr (see sc_adjacency.h), if it doesn't exist. Element is
+ * locked while its lists of sc-arcs are walked, so they aren't changed meanwhile.
+ * @return If adjacency is built, then returns SC_RESULT_OK; if some sc-arc can't be locked, then returns SC_RESULT_ERROR
+ */
+sc_result sc_storage_adjacency_build(sc_memory_context const * ctx, sc_addr addr);
+
 /*! Setup content data for specified sc-link
  * @param addr sc-addr of sc-link to setup content
  * @param stream Pointer to stream
@@ -183,6 +220,23 @@ sc_result sc_storage_get_elements_stat(sc_memory_context const * ctx, sc_stat *s
 
 sc_result sc_storage_erase_element_from_segment(sc_addr addr);
 
+/*! Returns number of output and input sc-arcs of sc-element. Degrees are read without lock,
+ * so they can be changed concurrently, and should be used as estimate (see ScTemplateSearch)
+ * @param out_degree Pointer to container for number of output sc-arcs. It can be NULL
+ * @param in_degree Pointer to container for number of input sc-arcs. It can be NULL
+ * @return If degrees returned, then returns SC_RESULT_OK; otherwise returns error code
+ */
+sc_result sc_storage_get_element_degree(sc_memory_context const * ctx, sc_addr addr, sc_uint32 * out_degree, sc_uint32 * in_degree);
+
+//! Returns estimated number of sc-elements, that have type matched to \p type (see sc_cardinality.h)
+sc_uint64 sc_storage_get_type_cardinality(sc_type type);
+
+/*! Counts sc-elements of segment, that is loaded from file, in statistics and index of sc-arcs. It's called on
+ * first usage of segment, before its sc-elements are changed, so segments aren't scanned on initialization
+ * @param elements Array of SC_SEGMENT_ELEMENTS_COUNT sc-elements of segment
+ */
+void sc_storage_segment_loaded(sc_addr_seg num, sc_element const *elements);
+
 
 // ----- Locks -----
 //! Returns pointer to sc-element metainfo
@@ -194,6 +248,29 @@ sc_result sc_storage_element_lock_try(sc_memory_context const * ctx, sc_addr add
 //! Unlocks specified sc-element
 sc_result sc_storage_element_unlock(sc_memory_context const * ctx, sc_addr addr);
 
+// ----- Optimistic reads -----
+/*! Copies sc-element without lock (see sc_segment_read_element)
+ * @param version Pointer to version, that can be checked by sc_storage_element_validate
+ * @return Returns SC_FALSE, if \p addr isn't valid or sc-element is changed meanwhile
+ */
+sc_bool sc_storage_element_try_read(sc_addr addr, sc_element *el, sc_uint32 *version);
+//! Returns SC_TRUE, if sc-element, that was read by sc_storage_element_try_read, isn't changed since that
+sc_bool sc_storage_element_validate(sc_addr addr, sc_uint32 version);
+/*! Copies sc-element. It's read without lock and read is repeated on conflict with writer, so readers
+ * don't write into shared memory. After several conflicts sc-element is copied under lock
+ */
+sc_result sc_storage_element_read(sc_memory_context const * ctx, sc_addr addr, sc_element *el);
+
+//! Returns mask of sc-event types, that have subscriptions on sc-element. It doesn't require sc-element lock
+sc_uint32 sc_storage_get_element_events_mask(sc_addr addr);
+//! Atomically sets \p bits in mask of sc-event types of sc-element. It doesn't require sc-element lock
+void sc_storage_add_element_events_mask(sc_addr addr, sc_uint32 bits);
+//! Atomically clears \p bits in mask of sc-event types of sc-element. It doesn't require sc-element lock
+void sc_storage_remove_element_events_mask(sc_addr addr, sc_uint32 bits);
+
+/*! Saves changed segments and removes write-ahead log files, that are covered by saved state
+ * @param ctx Context to lock segments while they are copied. If it's null, then segments are not locked
+ */
 sc_result sc_storage_save(sc_memory_context const * ctx);
 
 #endif
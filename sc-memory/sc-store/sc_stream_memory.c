@@ -113,6 +113,17 @@ sc_bool sc_stream_memory_eof(const sc_stream *stream)
     return SC_FALSE;
 }
 
+sc_result sc_stream_memory_data(const sc_stream *stream, const sc_char **data, sc_uint32 *length)
+{
+    sc_memory_buffer *buffer = (sc_memory_buffer*)stream->handler;
+    g_assert(buffer != 0);
+
+    *data = buffer->data;
+    *length = buffer->size;
+
+    return SC_RESULT_OK;
+}
+
 
 sc_stream* sc_stream_memory_new(const sc_char *buffer, sc_uint buffer_size, sc_uint8 flags, sc_bool data_owner)
 {
@@ -144,6 +155,7 @@ sc_stream* sc_stream_memory_new(const sc_char *buffer, sc_uint buffer_size, sc_u
     stream->seek_func = &sc_stream_memory_seek;
     stream->tell_func = &sc_stream_memory_tell;
     stream->write_func = 0; // doesn't support writing
+    stream->data_func = &sc_stream_memory_data;
 
     return stream;
 }
@@ -35,6 +35,11 @@ typedef sc_bool (*fStreamEof)(const sc_stream *stream);
  */
 typedef sc_result (*fStreamFreeHandler)(const sc_stream *stream);
 
+/*! Pointer to stream data function. This function returns pointer to whole stream data and its \i length,
+ * if stream data is stored in memory continuously. Streams, that don't store data in memory, don't set it.
+ */
+typedef sc_result (*fStreamData)(const sc_stream *stream, const sc_char **data, sc_uint32 *length);
+
 /*! Structure to store stream information
  */
 struct _sc_stream
@@ -55,6 +60,8 @@ struct _sc_stream
     fStreamFreeHandler free_func;
     //! Pointer to function to check if stream indicates to the end position
     fStreamEof eof_func;
+    //! Pointer to function to get whole stream data without copying (optional)
+    fStreamData data_func;
 };
 
 
@@ -58,14 +58,27 @@ typedef sc_int sc_bool;
 #define SC_MAXINT32     ((sc_int32)  0x7fffffff)
 #define SC_MAXUINT32	((sc_uint32) 0xffffffff)
 
-#define SC_ADDR_SEG_MAX     SC_MAXUINT16
+/* Wide addresses (SC_WIDE_ADDR build option) use 32-bit segment numbers, so number of sc-elements isn't limited
+ * by 2^32. Size of sc-addr is changed, so segments files and network protocol of such build are incompatible with default one
+ */
+#ifdef SC_WIDE_ADDR
+#   define SC_ADDR_SEG_MAX  0x00ffffff
+#else
+#   define SC_ADDR_SEG_MAX  SC_MAXUINT16
+#endif
 #define SC_ADDR_OFFSET_MAX  SC_MAXUINT16
 
 #define SC_SEGMENT_ELEMENTS_COUNT        SC_MAXUINT16   // number of elements in segment
-#define SC_SEGMENT_MAX                   SC_MAXUINT16   // max number of segments
+#define SC_SEGMENT_MAX                   SC_ADDR_SEG_MAX   // max number of segments
 
 // Types for segment and offset
+#ifdef SC_WIDE_ADDR
+typedef sc_uint32 sc_addr_seg;
+typedef sc_uint64 sc_addr_hash;     // packed local part of sc-addr
+#else
 typedef sc_uint16 sc_addr_seg;
+typedef sc_uint32 sc_addr_hash;     // packed local part of sc-addr
+#endif
 typedef sc_uint16 sc_addr_offset;
 
 //! Structure to store sc-element address
@@ -87,9 +100,9 @@ struct _sc_addr
 /*! Next defines help to pack local part of sc-addr (segment and offset) into int value
  * and get them back from int
  */
-#define SC_ADDR_LOCAL_TO_INT(addr) (sc_uint32)(((addr).seg << 16) | ((addr).offset & 0xffff))
+#define SC_ADDR_LOCAL_TO_INT(addr) (sc_addr_hash)((((sc_addr_hash)(addr).seg) << 16) | ((addr).offset & 0xffff))
 #define SC_ADDR_LOCAL_OFFSET_FROM_INT(v) (sc_uint16)((v) & 0x0000ffff)
-#define SC_ADDR_LOCAL_SEG_FROM_INT(v) SC_ADDR_LOCAL_OFFSET_FROM_INT(v >> 16)
+#define SC_ADDR_LOCAL_SEG_FROM_INT(v) (sc_addr_seg)(((sc_addr_hash)(v)) >> 16)
 
 typedef sc_uint16 sc_type;
 
@@ -137,6 +150,8 @@ typedef sc_uint16 sc_type;
 #define sc_flag_request_deletion    (0x4000)
 #define sc_flag_link_self_container (0x8000)
 #define sc_flags_remove(x)          ((x) & ~(sc_flag_request_deletion | sc_flag_link_self_container))
+//! Type of slot, that is reserved for new sc-element: it's invalid and has no element type, unlike deleted sc-element
+#define sc_flag_reserved            (sc_flag_request_deletion)
 
 // locks
 #define sc_lock_out_in      0x1
@@ -222,8 +237,10 @@ typedef struct _sc_element_flags sc_element_flags;
 typedef struct _sc_element_refs sc_element_refs;
 typedef struct _sc_memory_context sc_memory_context;
 typedef struct _sc_element_meta sc_element_meta;
+typedef struct _sc_element_spec sc_element_spec;
 typedef struct _sc_element sc_element;
 typedef struct _sc_segment sc_segment;
+typedef struct _sc_segment_table sc_segment_table;
 typedef struct _sc_addr sc_addr;
 typedef struct _sc_elements_stat sc_elements_stat;
 typedef struct _sc_iterator_param sc_iterator_param;
@@ -234,5 +251,20 @@ typedef enum _sc_result sc_result;
 typedef enum _sc_event_type sc_event_type;
 typedef struct _sc_stat sc_stat;
 
+//! Value of sc_element_spec index, that means reference to existing sc-element by sc-addr
+#define SC_ELEMENT_SPEC_NO_INDEX ((sc_uint32)-1)
+
+/*! Description of new sc-element for bulk creation (see sc_memory_elements_new). Begin and end of sc-arc are
+ * existing sc-elements (begin, end) or previous elements of the same batch (begin_index, end_index)
+ */
+struct _sc_element_spec
+{
+    sc_type type;               // type of sc-element; type of sc-arc must contain one of sc_type_arc_mask bits
+    sc_addr begin;              // begin of sc-arc, if begin_index is SC_ELEMENT_SPEC_NO_INDEX
+    sc_addr end;                // end of sc-arc, if end_index is SC_ELEMENT_SPEC_NO_INDEX
+    sc_uint32 begin_index;      // index of begin of sc-arc in batch
+    sc_uint32 end_index;        // index of end of sc-arc in batch
+};
+
 
 #endif
@@ -0,0 +1,533 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sc_wal.h"
+#include "sc_config.h"
+#include "sc_addr_set.h"
+
+#include <stdio.h>
+#include <memory.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifndef WIN32
+# include <unistd.h>
+#endif
+
+#define SC_WAL_FILE_MAGIC       0x4c574353  // "SCWL"
+#define SC_WAL_FILE_FORMAT      2
+#define SC_WAL_RECORD_MAGIC     0x52574353  // "SCWR"
+#define SC_WAL_FLUSH_SIZE       (1 << 20)   // size of buffered records, that are written without waiting for interval
+
+typedef struct _sc_wal_file_header
+{
+    sc_uint32 magic;            // SC_WAL_FILE_MAGIC
+    sc_uint32 format;           // SC_WAL_FILE_FORMAT
+    sc_uint32 element_size;     // size of sc_element, so log isn't replayed by incompatible build
+    sc_uint32 number;           // number of log file
+} sc_wal_file_header;
+
+typedef struct _sc_wal_record_header
+{
+    sc_uint32 magic;            // SC_WAL_RECORD_MAGIC
+    sc_uint32 count;            // number of sc-element images in record
+    sc_uint64 lsn;              // sequence number of record
+    sc_uint32 checksum;         // checksum of sc-element images
+    sc_uint32 reserved;
+} sc_wal_record_header;
+
+typedef struct _sc_wal_entry
+{
+    sc_addr addr;
+    sc_element element;
+    sc_content content;         // content of sc-link, it's empty for other sc-elements
+} sc_wal_entry;
+
+gchar *wal_path = null_ptr;
+sc_bool wal_enabled = SC_FALSE;
+sc_wal_sync wal_sync = SC_WAL_SYNC_INTERVAL;
+sc_uint32 wal_sync_interval = 100;
+
+GMutex wal_mutex;                           // protects buffer and sequence numbers
+GMutex wal_write_mutex;                     // protects log file
+GCond wal_cond_flush;                       // signaled, when buffered records need to be written
+GCond wal_cond_synced;                      // signaled, when buffered records were written
+GByteArray *wal_buffer = null_ptr;          // records, that wait for write
+GByteArray *wal_buffer_write = null_ptr;    // records, that are written now
+gsize wal_record_offset = 0;                // offset of current record in buffer
+sc_uint64 wal_lsn_next = 1;                 // sequence number of next record
+sc_uint64 wal_lsn_synced = 1;               // records with lower sequence numbers are written
+GIOChannel *wal_file = null_ptr;
+sc_uint32 wal_file_num = 0;                 // number of current log file
+GThread *wal_thread = null_ptr;
+sc_bool wal_stop = SC_FALSE;
+sc_bool wal_replayed = SC_FALSE;            // existing log files were found on initialization
+
+// ----------------------------------------------
+//! FNV-1a hash, it's enough to find incomplete records after crash
+sc_uint32 _sc_wal_checksum(guint8 const *data, gsize size)
+{
+    sc_uint32 hash = 2166136261u;
+    gsize i;
+
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void _sc_wal_file_path(sc_uint32 num, gchar *path)
+{
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/wal_%.10u.log", wal_path, num);
+}
+
+//! Collects numbers of existing log files in ascending order
+void _sc_wal_list_files(sc_addr_set *numbers)
+{
+    GDir *dir = g_dir_open(wal_path, 0, null_ptr);
+    gchar const *name = null_ptr;
+    sc_uint32 num = 0;
+
+    if (dir == null_ptr)
+        return;
+
+    while ((name = g_dir_read_name(dir)) != null_ptr)
+    {
+        if (g_str_has_suffix(name, ".log") && sscanf(name, "wal_%u.log", &num) == 1)
+            sc_addr_set_add(numbers, num);
+    }
+
+    g_dir_close(dir);
+    sc_addr_set_sort(numbers);
+}
+
+//! Flushes written data to disk, if it's required by sync policy
+void _sc_wal_sync_file(GIOChannel *file)
+{
+    g_io_channel_flush(file, null_ptr);
+
+#ifndef WIN32
+    if (wal_sync != SC_WAL_SYNC_NONE)
+        fsync(g_io_channel_unix_get_fd(file));
+#endif
+}
+
+sc_bool _sc_wal_file_open(sc_uint32 num)
+{
+    gchar path[MAX_PATH_LENGTH];
+    sc_wal_file_header header;
+    gsize bytes = 0;
+
+    _sc_wal_file_path(num, path);
+    wal_file = g_io_channel_new_file(path, "w", null_ptr);
+    if (wal_file == null_ptr)
+        return SC_FALSE;
+
+    g_io_channel_set_encoding(wal_file, null_ptr, null_ptr);
+
+    header.magic = SC_WAL_FILE_MAGIC;
+    header.format = SC_WAL_FILE_FORMAT;
+    header.element_size = sizeof(sc_element);
+    header.number = num;
+    if (g_io_channel_write_chars(wal_file, (gchar*)&header, sizeof(header), &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != sizeof(header))
+    {
+        g_io_channel_shutdown(wal_file, FALSE, null_ptr);
+        wal_file = null_ptr;
+        return SC_FALSE;
+    }
+
+    _sc_wal_sync_file(wal_file);
+
+    return SC_TRUE;
+}
+
+void _sc_wal_file_close()
+{
+    if (wal_file == null_ptr)
+        return;
+
+    _sc_wal_sync_file(wal_file);
+    g_io_channel_shutdown(wal_file, TRUE, null_ptr);
+    wal_file = null_ptr;
+}
+
+//! Writes buffered records into log file. Write mutex must be locked
+void _sc_wal_flush()
+{
+    GByteArray *buffer = null_ptr;
+    sc_uint64 lsn;
+    gsize bytes = 0;
+
+    // records are appended into other buffer, while this one is written
+    g_mutex_lock(&wal_mutex);
+    buffer = wal_buffer;
+    wal_buffer = wal_buffer_write;
+    wal_buffer_write = buffer;
+    lsn = wal_lsn_next;
+    g_mutex_unlock(&wal_mutex);
+
+    if (buffer->len > 0 && wal_file != null_ptr)
+    {
+        if (g_io_channel_write_chars(wal_file, (gchar*)buffer->data, buffer->len, &bytes, null_ptr) != G_IO_STATUS_NORMAL || bytes != buffer->len)
+            g_critical("Can't write records into log file %u", wal_file_num);
+
+        _sc_wal_sync_file(wal_file);
+    }
+    g_byte_array_set_size(buffer, 0);
+
+    g_mutex_lock(&wal_mutex);
+    wal_lsn_synced = lsn;
+    g_cond_broadcast(&wal_cond_synced);
+    g_mutex_unlock(&wal_mutex);
+}
+
+gpointer _sc_wal_thread_loop(gpointer data)
+{
+    g_mutex_lock(&wal_mutex);
+    while (wal_stop == SC_FALSE)
+    {
+        gint64 const end_time = g_get_monotonic_time() + wal_sync_interval * G_TIME_SPAN_MILLISECOND;
+
+        // commit policy writes records as soon as possible, so records appended meanwhile are written in one group
+        while (wal_stop == SC_FALSE && wal_buffer->len < SC_WAL_FLUSH_SIZE &&
+               (wal_sync != SC_WAL_SYNC_COMMIT || wal_buffer->len == 0))
+        {
+            if (g_cond_wait_until(&wal_cond_flush, &wal_mutex, end_time) == FALSE)
+                break;
+        }
+        g_mutex_unlock(&wal_mutex);
+
+        g_mutex_lock(&wal_write_mutex);
+        _sc_wal_flush();
+        g_mutex_unlock(&wal_write_mutex);
+
+        g_mutex_lock(&wal_mutex);
+    }
+    g_mutex_unlock(&wal_mutex);
+
+    return 0;
+}
+
+//! Cuts incomplete record from the end of log file, so it isn't found by next replays
+void _sc_wal_truncate_file(gchar const *path, gsize size)
+{
+#ifndef WIN32
+    if (truncate(path, (off_t)size) != 0)
+        g_warning("Can't truncate log file %s to %llu bytes", path, (unsigned long long)size);
+#else
+    (void)path;
+    (void)size;
+#endif
+}
+
+/*! Replays records of log file. Incomplete or damaged record (it's written just before crash) and
+ * records after it are cut from file, because they could be partially written. Returns SC_FALSE,
+ * if file can't be read or has unsupported format.
+ */
+sc_bool _sc_wal_replay_file(sc_uint32 num, fWalApplyFunc apply, sc_pointer data, sc_uint64 *records_count)
+{
+    gchar path[MAX_PATH_LENGTH];
+    GIOChannel *in_file = null_ptr;
+    sc_wal_file_header file_header;
+    sc_wal_record_header header;
+    sc_wal_entry *entries = null_ptr;
+    sc_uint32 capacity = 0, i;
+    gsize bytes = 0;
+    gsize valid_size = 0;       // size of file header and complete records
+    sc_bool torn = SC_TRUE;
+    sc_bool result = SC_FALSE;
+
+    _sc_wal_file_path(num, path);
+    in_file = g_io_channel_new_file(path, "r", null_ptr);
+    if (in_file == null_ptr)
+    {
+        g_warning("Can't open log file: %s", path);
+        return SC_FALSE;
+    }
+    g_io_channel_set_encoding(in_file, null_ptr, null_ptr);
+
+    if (g_io_channel_read_chars(in_file, (gchar*)&file_header, sizeof(file_header), &bytes, null_ptr) != G_IO_STATUS_NORMAL ||
+        bytes != sizeof(file_header))
+    {
+        // file could be created just before crash, so it's just removed by next checkpoint
+        result = SC_TRUE;
+        goto clean;
+    }
+
+    if (file_header.magic != SC_WAL_FILE_MAGIC || file_header.format != SC_WAL_FILE_FORMAT ||
+        file_header.element_size != sizeof(sc_element))
+    {
+        g_warning("Log file %s has unsupported format", path);
+        goto clean;
+    }
+
+    result = SC_TRUE;
+    valid_size = sizeof(file_header);
+    while (SC_TRUE)
+    {
+        GIOStatus const status = g_io_channel_read_chars(in_file, (gchar*)&header, sizeof(header), &bytes, null_ptr);
+        if (status == G_IO_STATUS_EOF && bytes == 0)
+        {
+            torn = SC_FALSE;
+            break;
+        }
+
+        if (status != G_IO_STATUS_NORMAL || bytes != sizeof(header) || header.magic != SC_WAL_RECORD_MAGIC)
+            break;
+
+        if (header.count > capacity)
+        {
+            capacity = header.count;
+            entries = g_renew(sc_wal_entry, entries, capacity);
+        }
+
+        if (header.count > 0 &&
+            (g_io_channel_read_chars(in_file, (gchar*)entries, sizeof(sc_wal_entry) * header.count, &bytes, null_ptr) != G_IO_STATUS_NORMAL ||
+             bytes != sizeof(sc_wal_entry) * header.count))
+            break;
+
+        if (_sc_wal_checksum((guint8 const*)entries, sizeof(sc_wal_entry) * header.count) != header.checksum)
+            break;
+
+        for (i = 0; i < header.count; ++i)
+            apply(entries[i].addr, &entries[i].element, &entries[i].content, data);
+
+        ++(*records_count);
+        valid_size += sizeof(header) + sizeof(sc_wal_entry) * header.count;
+    }
+
+    clean:
+    {
+        g_free(entries);
+        g_io_channel_shutdown(in_file, FALSE, null_ptr);
+    }
+
+    if (result == SC_TRUE && torn == SC_TRUE && valid_size > 0)
+    {
+        g_warning("Log file %s has incomplete record after %llu records, it's cut", path, (unsigned long long)*records_count);
+        _sc_wal_truncate_file(path, valid_size);
+    }
+
+    return result;
+}
+
+sc_wal_sync _sc_wal_parse_sync(const sc_char *value)
+{
+    if (value != null_ptr && g_str_equal(value, "none"))
+        return SC_WAL_SYNC_NONE;
+    if (value != null_ptr && g_str_equal(value, "commit"))
+        return SC_WAL_SYNC_COMMIT;
+
+    return SC_WAL_SYNC_INTERVAL;
+}
+
+// ----------------------------------------------
+
+sc_bool sc_wal_initialize(const sc_char *path, sc_bool clear, fWalApplyFunc apply, sc_pointer data)
+{
+    gchar file_path[MAX_PATH_LENGTH];
+    sc_addr_set files;
+    sc_uint64 records_count = 0;
+    sc_uint32 i;
+
+    g_assert(wal_path == null_ptr);
+
+    wal_path = g_strdup(path);
+    wal_enabled = sc_config_wal();
+    wal_sync = _sc_wal_parse_sync(sc_config_wal_sync());
+    wal_sync_interval = MAX(1, sc_config_wal_sync_interval());
+    wal_lsn_next = wal_lsn_synced = 1;
+    wal_stop = SC_FALSE;
+    wal_replayed = SC_FALSE;
+
+    sc_addr_set_init(&files);
+    _sc_wal_list_files(&files);
+
+    if (clear == SC_TRUE)
+    {
+        for (i = 0; i < files.count; ++i)
+        {
+            _sc_wal_file_path(files.items[i], file_path);
+            if (g_remove(file_path) != 0)
+                g_critical("Can't remove log file: %s", file_path);
+        }
+    }
+    else if (files.count > 0)
+    {
+        gint64 const start_time = g_get_monotonic_time();
+
+        /* incomplete record can end just the file, that was written at crash. Next files were written
+         * after restart (without that record), so they are replayed too
+         */
+        for (i = 0; i < files.count; ++i)
+        {
+            if (_sc_wal_replay_file(files.items[i], apply, data, &records_count) == SC_FALSE)
+                break;
+        }
+        wal_replayed = SC_TRUE;
+
+        g_message("Log replayed: %llu records from %u files in %lf seconds", (unsigned long long)records_count,
+                  files.count, (g_get_monotonic_time() - start_time) / (double)G_TIME_SPAN_SECOND);
+    }
+
+    wal_file_num = (clear == SC_FALSE && files.count > 0) ? files.items[files.count - 1] + 1 : 1;
+    sc_addr_set_destroy(&files);
+
+    if (wal_enabled == SC_FALSE)
+        return SC_TRUE;
+
+    if (_sc_wal_file_open(wal_file_num) == SC_FALSE)
+    {
+        g_critical("Can't create log file %u in %s", wal_file_num, wal_path);
+        return SC_FALSE;
+    }
+
+    wal_buffer = g_byte_array_new();
+    wal_buffer_write = g_byte_array_new();
+    wal_thread = g_thread_new("sc-wal", _sc_wal_thread_loop, null_ptr);
+
+    g_message("Write-ahead log: file %u, sync: %s, interval: %u ms", wal_file_num, sc_config_wal_sync(), wal_sync_interval);
+
+    return SC_TRUE;
+}
+
+void sc_wal_shutdown()
+{
+    if (wal_thread != null_ptr)
+    {
+        g_mutex_lock(&wal_mutex);
+        wal_stop = SC_TRUE;
+        g_cond_signal(&wal_cond_flush);
+        g_mutex_unlock(&wal_mutex);
+
+        g_thread_join(wal_thread);
+        wal_thread = null_ptr;
+
+        g_mutex_lock(&wal_write_mutex);
+        _sc_wal_flush();
+        _sc_wal_file_close();
+        g_mutex_unlock(&wal_write_mutex);
+
+        g_byte_array_free(wal_buffer, TRUE);
+        g_byte_array_free(wal_buffer_write, TRUE);
+        wal_buffer = wal_buffer_write = null_ptr;
+    }
+
+    wal_enabled = SC_FALSE;
+    g_free(wal_path);
+    wal_path = null_ptr;
+}
+
+sc_bool sc_wal_is_enabled()
+{
+    return wal_enabled;
+}
+
+sc_bool sc_wal_is_replayed()
+{
+    return wal_replayed;
+}
+
+void sc_wal_record_begin()
+{
+    sc_wal_record_header header;
+
+    g_mutex_lock(&wal_mutex);
+
+    // header is filled, when record is finished
+    memset(&header, 0, sizeof(header));
+    wal_record_offset = wal_buffer->len;
+    g_byte_array_append(wal_buffer, (guint8 const*)&header, sizeof(header));
+}
+
+void sc_wal_record_add(sc_addr addr, sc_element const *element, sc_content const *content)
+{
+    sc_wal_entry entry;
+
+    entry.addr = addr;
+    entry.element = *element;
+    if (content != null_ptr)
+        entry.content = *content;
+    else
+        memset(&entry.content, 0, sizeof(entry.content));
+    g_byte_array_append(wal_buffer, (guint8 const*)&entry, sizeof(entry));
+}
+
+sc_uint64 sc_wal_record_end()
+{
+    sc_wal_record_header header;
+    gsize const size = wal_buffer->len - wal_record_offset - sizeof(sc_wal_record_header);
+    sc_uint64 const lsn = wal_lsn_next++;
+
+    header.magic = SC_WAL_RECORD_MAGIC;
+    header.count = (sc_uint32)(size / sizeof(sc_wal_entry));
+    header.lsn = lsn;
+    header.checksum = _sc_wal_checksum(wal_buffer->data + wal_record_offset + sizeof(sc_wal_record_header), size);
+    header.reserved = 0;
+    memcpy(wal_buffer->data + wal_record_offset, &header, sizeof(header));
+
+    if (wal_sync == SC_WAL_SYNC_COMMIT || wal_buffer->len >= SC_WAL_FLUSH_SIZE)
+        g_cond_signal(&wal_cond_flush);
+
+    g_mutex_unlock(&wal_mutex);
+
+    return lsn;
+}
+
+void sc_wal_wait(sc_uint64 lsn)
+{
+    if (lsn == 0 || wal_sync != SC_WAL_SYNC_COMMIT)
+        return;
+
+    g_mutex_lock(&wal_mutex);
+    while (wal_lsn_synced <= lsn && wal_stop == SC_FALSE)
+        g_cond_wait(&wal_cond_synced, &wal_mutex);
+    g_mutex_unlock(&wal_mutex);
+}
+
+sc_uint32 sc_wal_checkpoint_begin()
+{
+    sc_uint32 num;
+
+    if (wal_enabled == SC_FALSE)
+        return wal_file_num;
+
+    // records appended before checkpoint are kept in previous file, until checkpoint finished
+    g_mutex_lock(&wal_write_mutex);
+    _sc_wal_flush();
+    _sc_wal_file_close();
+
+    ++wal_file_num;
+    if (_sc_wal_file_open(wal_file_num) == SC_FALSE)
+        g_critical("Can't create log file %u in %s", wal_file_num, wal_path);
+
+    num = wal_file_num;
+    g_mutex_unlock(&wal_write_mutex);
+
+    return num;
+}
+
+void sc_wal_checkpoint_end(sc_uint32 log_num)
+{
+    gchar file_path[MAX_PATH_LENGTH];
+    sc_addr_set files;
+    sc_uint32 i;
+
+    sc_addr_set_init(&files);
+    _sc_wal_list_files(&files);
+
+    for (i = 0; i < files.count && files.items[i] < log_num; ++i)
+    {
+        _sc_wal_file_path(files.items[i], file_path);
+        if (g_remove(file_path) != 0)
+            g_warning("Can't remove log file: %s", file_path);
+    }
+
+    sc_addr_set_destroy(&files);
+}
@@ -0,0 +1,73 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sc_wal_h_
+#define _sc_wal_h_
+
+#include "sc_types.h"
+#include "sc_element.h"
+
+/*! Write-ahead log of sc-memory changes. Each record contains images of sc-elements, that were changed
+ * by one operation (sc-element creation, deletion, type or content change). Records are appended while
+ * changed sc-elements are locked, so records of the same sc-element are ordered in log like changes.
+ * Replay of images in log order is idempotent, so log can be replayed over segments, that were saved while
+ * it was written (segments are saved without global lock).
+ *
+ * Log is written into files <repo>/wal_<number>.log. Checkpoint (segments save) starts new file, and files
+ * before it are removed, when checkpoint finished.
+ */
+
+typedef enum
+{
+    SC_WAL_SYNC_NONE = 0,       // records are written periodically, but not flushed to disk
+    SC_WAL_SYNC_INTERVAL,       // records are written and flushed to disk periodically
+    SC_WAL_SYNC_COMMIT          // each change waits until its record is flushed to disk (records are flushed in groups)
+} sc_wal_sync;
+
+//! Function, that applies image of sc-element and its content on log replay
+typedef void (*fWalApplyFunc)(sc_addr addr, sc_element const *element, sc_content const *content, sc_pointer data);
+
+/*! Initialize write-ahead log in specified repository path. Existing log files are replayed
+ * with \p apply function. New log file is created, if log is enabled in configuration.
+ * @param path Path to repository
+ * @param clear Flag to remove existing log files without replay
+ * @param apply Function, that applies sc-element images from existing log
+ * @param data Pointer to user data for \p apply function
+ * @return Returns SC_FALSE, if log can't be replayed or created
+ */
+sc_bool sc_wal_initialize(const sc_char *path, sc_bool clear, fWalApplyFunc apply, sc_pointer data);
+
+//! Writes all appended records and closes log
+void sc_wal_shutdown();
+
+//! Returns SC_TRUE, if changes are written into log
+sc_bool sc_wal_is_enabled();
+
+//! Returns SC_TRUE, if existing log files were replayed on initialization, so they need checkpoint
+sc_bool sc_wal_is_replayed();
+
+/*! Starts new record. Records are appended into common buffer, so record_add and record_end
+ * need to be called from the same thread right after this function.
+ */
+void sc_wal_record_begin();
+//! Appends image of sc-element into current record. Content is passed for sc-links, otherwise it's null
+void sc_wal_record_add(sc_addr addr, sc_element const *element, sc_content const *content);
+//! Finishes current record and returns its sequence number
+sc_uint64 sc_wal_record_end();
+
+/*! Waits until record with specified sequence number is flushed to disk, if it's required by sync policy.
+ * It shouldn't be called while sc-elements are locked, so other changes can be flushed in the same group.
+ */
+void sc_wal_wait(sc_uint64 lsn);
+
+/*! Starts new log file for changes, that can be missed by checkpoint.
+ * @returns Returns number of new log file. It should be passed to sc_wal_checkpoint_end
+ */
+sc_uint32 sc_wal_checkpoint_begin();
+//! Removes log files, that were written before log file with number \p log_num
+void sc_wal_checkpoint_end(sc_uint32 log_num);
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "sc_helper.h"
 #include "sc_memory_headers.h"
+#include "sc-store/sc_event/sc_event_private.h"
 
 #include <glib.h>
 #include "string.h"
@@ -16,6 +17,275 @@ sc_bool sc_helper_is_initialized = SC_FALSE;
 sc_char **keynodes_str = 0;
 sc_addr *sc_keynodes = 0;
 
+/*! System identifier of sc-element. Lookup by identifier doesn't touch file memory, so each
+ * identifier is stored together with sc-elements of its construction:
+ * element => nrel_system_identifier: link
+ * Identifier data is allocated together with structure. Index is kept complete by hooks of sc-memory:
+ * construction is added, when its attribute sc-arc is created, and it's removed or changed, when any of
+ * its sc-elements is deleted or content of its sc-link is changed.
+ */
+typedef struct _sc_idtf_entry
+{
+    const sc_char *data;
+    sc_uint32 len;
+    sc_bool indexed;    // SC_TRUE, if entry can be found by identifier (it isn't empty and isn't used by another entry)
+    sc_addr element;
+    sc_addr link;       // sc-link with identifier
+    sc_addr arc;        // common sc-arc from element to sc-link
+    sc_addr attr_arc;   // sc-arc from nrel_system_identifier to common sc-arc
+} sc_idtf_entry;
+
+GRWLock idtf_index_lock;
+GHashTable *idtf_index = 0;         // set of indexed sc_idtf_entry by identifier
+GHashTable *idtf_index_addrs = 0;   // map of packed sc-addr of entry sc-elements (except element) to sc_idtf_entry
+sc_memory_context *idtf_index_ctx = 0;  // context to read constructions, access levels are checked on lookup
+
+guint _idtf_entry_hash(gconstpointer v)
+{
+    const sc_idtf_entry *entry = (const sc_idtf_entry*)v;
+    guint hash = 5381;
+    sc_uint32 i;
+
+    for (i = 0; i < entry->len; ++i)
+        hash = (hash << 5) + hash + (guchar)entry->data[i];
+
+    return hash;
+}
+
+gboolean _idtf_entry_equal(gconstpointer a, gconstpointer b)
+{
+    const sc_idtf_entry *e1 = (const sc_idtf_entry*)a;
+    const sc_idtf_entry *e2 = (const sc_idtf_entry*)b;
+
+    return (e1->len == e2->len) && (memcmp(e1->data, e2->data, e1->len) == 0);
+}
+
+sc_idtf_entry* _idtf_entry_new(const sc_char *data, sc_uint32 len, sc_addr element, sc_addr link, sc_addr arc, sc_addr attr_arc)
+{
+    sc_idtf_entry *entry = (sc_idtf_entry*)g_malloc(sizeof(sc_idtf_entry) + len);
+
+    if (len > 0)
+        memcpy(entry + 1, data, len);
+    entry->data = (const sc_char*)(entry + 1);
+    entry->len = len;
+    entry->indexed = SC_FALSE;
+    entry->element = element;
+    entry->link = link;
+    entry->arc = arc;
+    entry->attr_arc = attr_arc;
+
+    return entry;
+}
+
+//! Adds entry into index. Index must be locked for writing
+void _idtf_index_insert_entry(sc_idtf_entry *entry)
+{
+    if (entry->len > 0 && g_hash_table_contains(idtf_index, entry) == FALSE)
+    {
+        g_hash_table_add(idtf_index, entry);
+        entry->indexed = SC_TRUE;
+    }
+    else if (entry->len > 0)
+        g_warning("There are more then one sc-elements with system identifier %.*s", (int)entry->len, entry->data);
+
+    g_hash_table_insert(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(entry->link)), entry);
+    g_hash_table_insert(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(entry->arc)), entry);
+    g_hash_table_insert(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(entry->attr_arc)), entry);
+}
+
+//! Removes entry from index and frees it. Index must be locked for writing
+void _idtf_index_remove_entry(sc_idtf_entry *entry)
+{
+    g_hash_table_remove(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(entry->link)));
+    g_hash_table_remove(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(entry->arc)));
+    g_hash_table_remove(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(entry->attr_arc)));
+    if (entry->indexed == SC_TRUE)
+        g_hash_table_remove(idtf_index, entry);
+    g_free(entry);
+}
+
+/*! Adds system identifier construction into index. Construction with empty or already used identifier is
+ * added too, so it's indexed when content of its sc-link is changed.
+ * @returns Returns SC_FALSE, if construction can't be found by identifier
+ */
+sc_bool _idtf_index_add(const sc_char *data, sc_uint32 len, sc_addr element, sc_addr link, sc_addr arc, sc_addr attr_arc)
+{
+    sc_idtf_entry *entry = _idtf_entry_new(data, len, element, link, arc, attr_arc);
+    sc_bool result = SC_FALSE;
+
+    g_rw_lock_writer_lock(&idtf_index_lock);
+    // sc-link can be used just by one construction
+    if (g_hash_table_contains(idtf_index_addrs, GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(link))) == FALSE)
+    {
+        _idtf_index_insert_entry(entry);
+        result = entry->indexed;
+        entry = null_ptr;
+    }
+    g_rw_lock_writer_unlock(&idtf_index_lock);
+
+    g_free(entry);
+
+    return result;
+}
+
+/*! Finds sc-element by system identifier in index.
+ * @param link Pointer to sc-link of identifier construction. Can be null_ptr
+ * @returns Returns SC_TRUE, if identifier was found
+ */
+sc_bool _idtf_index_find(const sc_char *data, sc_uint32 len, sc_addr *element, sc_addr *link)
+{
+    sc_idtf_entry key;
+    sc_idtf_entry *entry = 0;
+
+    key.data = data;
+    key.len = len;
+
+    g_rw_lock_reader_lock(&idtf_index_lock);
+    entry = (sc_idtf_entry*)g_hash_table_lookup(idtf_index, &key);
+    if (entry != null_ptr)
+    {
+        *element = entry->element;
+        if (link != null_ptr)
+            *link = entry->link;
+    }
+    g_rw_lock_reader_unlock(&idtf_index_lock);
+
+    return entry != null_ptr ? SC_TRUE : SC_FALSE;
+}
+
+/*! Removes system identifier from index, when any sc-element of its construction is deleted. Deleted
+ * element also deletes its common sc-arc, so it's enough to watch sc-link and sc-arcs
+ */
+void _idtf_index_on_element_deleted(sc_addr addr)
+{
+    gpointer key = GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr));
+    sc_idtf_entry *entry = 0;
+
+    // most of deleted sc-elements aren't indexed, so they take shared lock only
+    g_rw_lock_reader_lock(&idtf_index_lock);
+    entry = (sc_idtf_entry*)g_hash_table_lookup(idtf_index_addrs, key);
+    g_rw_lock_reader_unlock(&idtf_index_lock);
+
+    if (entry == null_ptr)
+        return;
+
+    g_rw_lock_writer_lock(&idtf_index_lock);
+    entry = (sc_idtf_entry*)g_hash_table_lookup(idtf_index_addrs, key);
+    if (entry != null_ptr)
+        _idtf_index_remove_entry(entry);
+    g_rw_lock_writer_unlock(&idtf_index_lock);
+}
+
+/*! Changes system identifier in index with content of its sc-link. It's called while sc-link is locked,
+ * so changes of the same sc-link are applied in order
+ */
+void _idtf_index_on_link_content_changed(sc_addr link, const sc_stream *stream)
+{
+    gpointer key = GSIZE_TO_POINTER(SC_ADDR_LOCAL_TO_INT(link));
+    sc_idtf_entry *entry = 0, *changed = 0;
+    sc_char *data = 0;
+    sc_uint32 len = 0, read = 0;
+
+    g_rw_lock_reader_lock(&idtf_index_lock);
+    entry = (sc_idtf_entry*)g_hash_table_lookup(idtf_index_addrs, key);
+    g_rw_lock_reader_unlock(&idtf_index_lock);
+
+    if (entry == null_ptr)
+        return;
+
+    if (sc_stream_get_length(stream, &len) != SC_RESULT_OK || sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0) != SC_RESULT_OK)
+        len = 0;
+
+    data = g_new0(sc_char, len + 1);
+    if (sc_stream_read_data(stream, data, len, &read) != SC_RESULT_OK || read != len)
+        len = 0;
+
+    g_rw_lock_writer_lock(&idtf_index_lock);
+    entry = (sc_idtf_entry*)g_hash_table_lookup(idtf_index_addrs, key);
+    if (entry != null_ptr && SC_ADDR_IS_EQUAL(entry->link, link))
+    {
+        changed = _idtf_entry_new(data, len, entry->element, entry->link, entry->arc, entry->attr_arc);
+        _idtf_index_remove_entry(entry);
+        _idtf_index_insert_entry(changed);
+    }
+    g_rw_lock_writer_unlock(&idtf_index_lock);
+
+    g_free(data);
+}
+
+/*! Reads system identifier construction with attribute sc-arc \p attr_arc and common sc-arc \p arc into index.
+ * @returns Returns SC_TRUE, if construction can be found by identifier
+ */
+sc_bool _idtf_index_read(sc_addr attr_arc, sc_addr arc)
+{
+    sc_addr element, link;
+    sc_stream *stream = 0;
+    sc_char *data = 0;
+    sc_uint32 len = 0, read = 0;
+    sc_type type = 0;
+    sc_bool result = SC_FALSE;
+
+    if (sc_memory_get_element_type(idtf_index_ctx, attr_arc, &type) != SC_RESULT_OK ||
+        (type & sc_type_arc_pos_const_perm) != sc_type_arc_pos_const_perm ||
+        sc_memory_get_element_type(idtf_index_ctx, arc, &type) != SC_RESULT_OK ||
+        (type & (sc_type_arc_common | sc_type_const)) != (sc_type_arc_common | sc_type_const) ||
+        sc_memory_get_arc_info(idtf_index_ctx, arc, &element, &link) != SC_RESULT_OK ||
+        sc_memory_get_element_type(idtf_index_ctx, link, &type) != SC_RESULT_OK ||
+        (type & sc_type_link) == 0)
+    {
+        return SC_FALSE;
+    }
+
+    // sc-link without content is added with empty identifier
+    if (sc_memory_get_link_content(idtf_index_ctx, link, &stream) == SC_RESULT_OK)
+    {
+        if (sc_stream_get_length(stream, &len) != SC_RESULT_OK)
+            len = 0;
+        data = g_new0(sc_char, len + 1);
+        if (sc_stream_read_data(stream, data, len, &read) != SC_RESULT_OK || read != len)
+            len = 0;
+        sc_stream_free(stream);
+    }
+
+    result = _idtf_index_add(data, len, element, link, arc, attr_arc);
+    g_free(data);
+
+    return result;
+}
+
+//! Adds system identifier construction into index, when its attribute sc-arc is created
+void _idtf_index_on_arc_created(sc_addr arc, sc_addr beg, sc_addr end)
+{
+    if (SC_ADDR_IS_NOT_EQUAL(beg, sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER]))
+        return;
+
+    _idtf_index_read(arc, end);
+}
+
+//! Reads identifiers of all sc-elements into index
+void _idtf_index_build()
+{
+    sc_iterator3 *it = 0;
+    sc_uint32 count = 0;
+
+    it = sc_iterator3_f_a_a_new(idtf_index_ctx,
+                                sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER],
+                                sc_type_arc_pos_const_perm,
+                                sc_type_arc_common | sc_type_const);
+    if (it == null_ptr)
+        return;
+
+    while (sc_iterator3_next(it) == SC_TRUE)
+    {
+        if (_idtf_index_read(sc_iterator3_value(it, 1), sc_iterator3_value(it, 2)) == SC_TRUE)
+            ++count;
+    }
+
+    sc_iterator3_free(it);
+
+    g_message("\tSystem identifiers: %u", count);
+}
+
 sc_result resolve_nrel_system_identifier(sc_memory_context const * ctx)
 {
     sc_addr *results = 0;
@@ -128,6 +398,14 @@ sc_result sc_helper_init(sc_memory_context const * ctx)
         sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER] = addr;
     }
 
+    idtf_index = g_hash_table_new(_idtf_entry_hash, _idtf_entry_equal);
+    idtf_index_addrs = g_hash_table_new(g_direct_hash, g_direct_equal);
+    idtf_index_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    _idtf_index_build();
+    sc_event_set_element_deleted_hook(_idtf_index_on_element_deleted);
+    sc_event_set_link_content_changed_hook(_idtf_index_on_link_content_changed);
+    sc_event_set_arc_created_hook(_idtf_index_on_arc_created);
+
     sc_helper_is_initialized = SC_TRUE;
 
     return SC_RESULT_OK;
@@ -135,103 +413,64 @@ sc_result sc_helper_init(sc_memory_context const * ctx)
 
 void sc_helper_shutdown()
 {
+    GHashTableIter iter;
+    gpointer key;
+
     g_message("Shutdown sc-helper");
 
+    sc_event_set_element_deleted_hook(null_ptr);
+    sc_event_set_link_content_changed_hook(null_ptr);
+    sc_event_set_arc_created_hook(null_ptr);
+
+    g_rw_lock_writer_lock(&idtf_index_lock);
+    g_hash_table_iter_init(&iter, idtf_index);
+    while (g_hash_table_iter_next(&iter, &key, null_ptr))
+        g_free(key);
+    g_hash_table_destroy(idtf_index);
+    g_hash_table_destroy(idtf_index_addrs);
+    idtf_index = 0;
+    idtf_index_addrs = 0;
+    g_rw_lock_writer_unlock(&idtf_index_lock);
+    sc_memory_context_free(idtf_index_ctx);
+    idtf_index_ctx = 0;
+
+    sc_helper_is_initialized = SC_FALSE;
     g_free(sc_keynodes);
     _destroy_keynodes_str();
 }
 
 sc_result sc_helper_find_element_by_system_identifier(sc_memory_context const * ctx, const sc_char* data, sc_uint32 len, sc_addr *result_addr)
 {
-    sc_addr *results = 0;
-    sc_uint32 results_count = 0;
-    sc_stream *stream = 0;
-    sc_uint32 i = 0;
-    sc_iterator5 *it = 0;
-    sc_bool found = SC_FALSE;
+    sc_addr addr;
 
     g_assert(sc_helper_is_initialized == SC_TRUE);
     g_assert(sc_keynodes != 0);
 
-    // try to find sc-links with that contains system identifier value
-    stream = sc_stream_memory_new(data, sizeof(sc_char) * len, SC_STREAM_FLAG_READ, SC_FALSE);
-    if (sc_memory_find_links_with_content(ctx, stream, &results, &results_count) == SC_RESULT_OK)
-    {
-        for (i = 0; i < results_count; i++)
-        {
-            it = sc_iterator5_a_a_f_a_f_new(ctx,
-                                            0,
-                                            sc_type_arc_common | sc_type_const,
-                                            results[i],
-                                            sc_type_arc_pos_const_perm,
-                                            sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER]);
-            if (sc_iterator5_next(it))
-            {
-                if (found == SC_FALSE)
-                {
-                    found = SC_TRUE;
-                    *result_addr = sc_iterator5_value(it, 0);
-                }else
-                {
-                    // don't foget to free allocated memory before return error
-                    sc_iterator5_free(it);
-                    sc_stream_free(stream);
-                    g_free(results);
-                    return SC_RESULT_ERROR_INVALID_STATE;
-                }
-            }
-
-            sc_iterator5_free(it);
-        }
-
-        g_free(results);
-    }
+    // all identifiers are found without file memory
+    if (_idtf_index_find(data, len, &addr, null_ptr) == SC_FALSE)
+        return SC_RESULT_ERROR;
 
-    sc_stream_free(stream);
+    if (sc_memory_is_element(ctx, addr) == SC_FALSE)
+        return SC_RESULT_ERROR;
 
-    return found == SC_TRUE ? SC_RESULT_OK : SC_RESULT_ERROR;
+    *result_addr = addr;
+    return SC_RESULT_OK;
 }
 
 sc_result sc_helper_set_system_identifier(sc_memory_context const * ctx, sc_addr addr, const sc_char* data, sc_uint32 len)
 {
-    sc_iterator5 *it5 = 0;
-    sc_addr *results = 0;
-    sc_uint32 results_count = 0;
     sc_stream *stream = 0;
-    sc_uint32 i = 0;
-    sc_addr idtf_addr, arc_addr;
+    sc_addr idtf_addr, arc_addr, attr_arc_addr, found_addr, found_link;
 
     SC_ADDR_MAKE_EMPTY(idtf_addr)
     g_assert(sc_keynodes != 0);
 
     // check if specified system identifier already used
-    stream = sc_stream_memory_new(data, sizeof(sc_char) * len, SC_STREAM_FLAG_READ, SC_FALSE);
-    if (sc_memory_find_links_with_content(ctx, stream, &results, &results_count) == SC_RESULT_OK)
-    {
-        for (i = 0; i < results_count; i++)
-        {
-            it5 = sc_iterator5_a_a_f_a_f_new(ctx,
-                                             0,
-                                             sc_type_arc_common | sc_type_const,
-                                             results[i],
-                                             sc_type_arc_pos_const_perm,
-                                             sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER]);
-            if (sc_iterator5_next(it5))
-            {
-                // don't foget to free allocated memory before return error
-                sc_iterator5_free(it5);
-                sc_stream_free(stream);
-                g_free(results);
-                return SC_RESULT_ERROR_INVALID_PARAMS;
-            }
-
-            sc_iterator5_free(it5);
-        }
-
-        g_free(results);
-    }
+    if (_idtf_index_find(data, len, &found_addr, null_ptr) == SC_TRUE)
+        return SC_RESULT_ERROR_INVALID_PARAMS;
 
     // if there are no elements with specified system identitifier, then we can use it
+    stream = sc_stream_memory_new(data, sizeof(sc_char) * len, SC_STREAM_FLAG_READ, SC_FALSE);
     idtf_addr = sc_memory_link_new(ctx);
     if (sc_memory_set_link_content(ctx, idtf_addr, stream) != SC_RESULT_OK)
     {
@@ -247,10 +486,17 @@ sc_result sc_helper_set_system_identifier(sc_memory_context const * ctx, sc_addr
     if (SC_ADDR_IS_EMPTY(arc_addr))
         return SC_RESULT_ERROR;
 
-    arc_addr = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER], arc_addr);
-    if (SC_ADDR_IS_EMPTY(arc_addr))
+    attr_arc_addr = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER], arc_addr);
+    if (SC_ADDR_IS_EMPTY(attr_arc_addr))
         return SC_RESULT_ERROR;
 
+    // construction is indexed on creation of attribute sc-arc, but the same identifier could be set by another thread at the same time
+    if (_idtf_index_find(data, len, &found_addr, &found_link) == SC_FALSE || SC_ADDR_IS_NOT_EQUAL(found_link, idtf_addr))
+    {
+        sc_memory_element_free(ctx, idtf_addr);
+        return SC_RESULT_ERROR_INVALID_PARAMS;
+    }
+
     return SC_RESULT_OK;
 }
 
@@ -308,18 +554,8 @@ sc_bool sc_helper_resolve_system_identifier(sc_memory_context const * ctx, const
 
 sc_bool sc_helper_check_arc(sc_memory_context const * ctx, sc_addr beg_el, sc_addr end_el, sc_type arc_type)
 {
-    sc_iterator3 *it = 0;
-    sc_bool res = SC_FALSE;
-
-    it = sc_iterator3_f_a_f_new(ctx, beg_el, arc_type, end_el);
-    if (it == null_ptr)
-        return SC_FALSE;
-
-    if (sc_iterator3_next(it) == SC_TRUE)
-        res = SC_TRUE;
-
-    sc_iterator3_free(it);
-    return res;
+    sc_addr arc;
+    return (sc_memory_find_arc(ctx, beg_el, end_el, arc_type, &arc) == SC_RESULT_OK) ? SC_TRUE : SC_FALSE;
 }
 
 
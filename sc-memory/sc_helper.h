@@ -24,9 +24,10 @@ typedef enum _sc_keynode sc_keynode;
  * @param len Length of data buffer
  * @param result_addr Pointer to result container
  * @return If sc-element with spefcified system identifier found, then return SC_RESULT_OK and result_addr
- * contains sc-addr of this one; otherwise return SC_RESULT_ERROR. If there are more then one sc-elements with
- * specified system identifier, then return SC_RESULT_ERROR_INVALID_STATE, but result_addr will contains sc-addr
- * of firstly found sc-element.
+ * contains sc-addr of this one; otherwise return SC_RESULT_ERROR.
+ * @remarks System identifiers are kept in memory index, that is built on initialization and updated by
+ * creation of identifier constructions (with or without sc-helper), by deletion of sc-elements and by
+ * changes of identifiers contents. So lookup doesn't touch file memory.
  */
 _SC_EXTERN sc_result sc_helper_find_element_by_system_identifier(sc_memory_context const * ctx, const sc_char* data, sc_uint32 len, sc_addr *result_addr);
 
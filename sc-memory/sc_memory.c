@@ -122,6 +122,8 @@ sc_memory_context* sc_memory_context_new(sc_uint8 levels)
     sc_uint32 index = 0;
 
     ctx->access_levels = levels;
+    ctx->slab = sc_storage_slab_new();
+    ctx->free_scratch = sc_storage_free_scratch_new();
 
     // setup concurency id
     g_mutex_lock(&s_concurrency_mutex);
@@ -145,6 +147,8 @@ sc_memory_context* sc_memory_context_new(sc_uint8 levels)
 
     error:
     {
+        sc_storage_slab_free(ctx->slab);
+        sc_storage_free_scratch_free(ctx->free_scratch);
         g_free(ctx);
         ctx = 0;
     }
@@ -168,6 +172,8 @@ void sc_memory_context_free(sc_memory_context *ctx)
 
     g_mutex_unlock(&s_concurrency_mutex);
 
+    sc_storage_slab_free(ctx->slab);
+    sc_storage_free_scratch_free(ctx->free_scratch);
     g_free(ctx);
 }
 
@@ -201,6 +207,11 @@ sc_addr sc_memory_arc_new(sc_memory_context const * ctx, sc_type type, sc_addr b
     return sc_storage_arc_new(ctx, type, beg, end);
 }
 
+sc_result sc_memory_elements_new(sc_memory_context const * ctx, sc_element_spec const * specs, sc_uint32 count, sc_addr * result)
+{
+    return sc_storage_elements_new(ctx, specs, count, result);
+}
+
 sc_result sc_memory_get_element_type(sc_memory_context const * ctx, sc_addr addr, sc_type *result)
 {
     return sc_storage_get_element_type(ctx, addr, result);
@@ -227,6 +238,11 @@ sc_result sc_memory_get_arc_info(sc_memory_context const * ctx, sc_addr addr,
     return sc_storage_get_arc_info(ctx, addr, result_start_addr, result_end_addr);
 }
 
+sc_result sc_memory_find_arc(sc_memory_context const * ctx, sc_addr beg, sc_addr end, sc_type arc_type, sc_addr * result)
+{
+    return sc_storage_find_arc(ctx, beg, end, arc_type, result);
+}
+
 sc_result sc_memory_set_link_content(sc_memory_context const * ctx, sc_addr addr, const sc_stream *stream)
 {
     return sc_storage_set_link_content(ctx, addr, stream);
@@ -262,6 +278,16 @@ sc_result sc_memory_stat(sc_memory_context const * ctx, sc_stat *stat)
     return sc_storage_get_elements_stat(ctx, stat);
 }
 
+sc_result sc_memory_get_element_degree(sc_memory_context const * ctx, sc_addr addr, sc_uint32 * out_degree, sc_uint32 * in_degree)
+{
+    return sc_storage_get_element_degree(ctx, addr, out_degree, in_degree);
+}
+
+sc_uint64 sc_memory_get_type_cardinality(sc_memory_context const * ctx, sc_type type)
+{
+    return sc_storage_get_type_cardinality(type);
+}
+
 sc_result sc_memory_save(sc_memory_context const * ctx)
 {
     return sc_storage_save(ctx);
@@ -83,6 +83,18 @@ _SC_EXTERN sc_addr sc_memory_link_new(sc_memory_context const * ctx);
  */
 _SC_EXTERN sc_addr sc_memory_arc_new(sc_memory_context const * ctx, sc_type type, sc_addr beg, sc_addr end);
 
+/*! Creates batch of sc-elements at once. Sc-arcs of batch can connect existing sc-elements and previous
+ * elements of the same batch (see sc_element_spec). It locks storage once for the whole batch, so it's much
+ * faster than creation of the same elements one by one; batch is created atomically.
+ * @param specs Descriptions of new sc-elements
+ * @param count Number of sc-elements in batch
+ * @param result Array of \p count sc-addrs to store sc-addrs of created sc-elements
+ * @return If batch created, then returns SC_RESULT_OK; otherwise nothing is created.
+ * SC_RESULT_ERROR_INVALID_PARAMS is returned, if sc-arc refers to unknown sc-addr or to the next element of batch,
+ * SC_RESULT_ERROR_INVALID_STATE - if begin or end sc-element doesn't exist
+ */
+_SC_EXTERN sc_result sc_memory_elements_new(sc_memory_context const * ctx, sc_element_spec const * specs, sc_uint32 count, sc_addr * result);
+
 /*! Get type of sc-element with specified sc-addr
  * @param addr sc-addr of element to get type
  * @param result Pointer to result container
@@ -125,6 +137,13 @@ _SC_EXTERN sc_result sc_memory_get_arc_end(sc_memory_context const * ctx, sc_add
 _SC_EXTERN sc_result sc_memory_get_arc_info(sc_memory_context const * ctx, sc_addr addr,	
                                             sc_addr * result_start_addr, sc_addr * result_end_addr);
 
+/*! Finds sc-arc with specified type between \p beg and \p end elements. If index of sc-arcs is
+ * enabled in config ([memory] arc_index), then it works by constant time.
+ * @return If sc-arc found, then returns SC_RESULT_OK and sets \p result; if it doesn't exist,
+ * then returns SC_RESULT_ERROR_NOT_FOUND
+ */
+_SC_EXTERN sc_result sc_memory_find_arc(sc_memory_context const * ctx, sc_addr beg, sc_addr end, sc_type arc_type, sc_addr * result);
+
 /*! Setup content data for specified sc-link
  * @param addr sc-addr of sc-link to setup content
  * @param stream Pointer to stream
@@ -189,6 +208,20 @@ _SC_EXTERN sc_result sc_memory_get_element_access_levels(sc_memory_context const
  */
 _SC_EXTERN sc_result sc_memory_stat(sc_memory_context const * ctx, sc_stat *stat);
 
+/*! Get number of output and input sc-arcs of sc-element. Degrees are estimates, because they are read without lock
+ * @param addr sc-addr of sc-element to get degrees
+ * @param out_degree Pointer to container for number of output sc-arcs. It can be NULL
+ * @param in_degree Pointer to container for number of input sc-arcs. It can be NULL
+ * @return If degrees returned, then returns SC_RESULT_OK; otherwise returns error code
+ */
+_SC_EXTERN sc_result sc_memory_get_element_degree(sc_memory_context const * ctx, sc_addr addr, sc_uint32 * out_degree, sc_uint32 * in_degree);
+
+/*! Get estimated number of sc-elements with specified type
+ * @param type Type filter. Sc-element is counted, if its type contains all bits of \p type
+ * @return Returns number of sc-elements, that have matched type
+ */
+_SC_EXTERN sc_uint64 sc_memory_get_type_cardinality(sc_memory_context const * ctx, sc_type type);
+
 /*! Save sc-memory state.
  * Calls from application, when request to save memory state
  */
@@ -14,6 +14,8 @@ struct _sc_memory_context
 {
     sc_uint16 id;
     sc_access_levels access_levels;
+    struct _sc_storage_slab *slab;                  // reserved segment section for sc-elements allocation
+    struct _sc_storage_free_scratch *free_scratch;  // scratch memory for sc-elements deletion and bulk creation
 };
 
 extern sc_memory_context * s_memory_default_ctx;
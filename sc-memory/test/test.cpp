@@ -9,11 +9,17 @@ extern "C"
 {
 #include "sc_memory_headers.h"
 #include "sc-store/sc_store.h"
+#include "sc-store/sc_segment.h"
+#include "sc-store/sc_link_helpers.h"
+#include "sc-store/sc_arc_index.h"
+#include "sc-store/sc_adjacency.h"
+#include "sc-store/sc_fs_storage.h"
 #include "sc_helper.h"
 }
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <set>
 #include <limits>
 #include <glib.h>
 #include <cstdint>
@@ -684,7 +690,1452 @@ void test_save()
 
 }
 
+void test_sys_idtf_index()
+{
+    initialize_memory();
+
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_min);
+    std::string const idtf = "test_sys_idtf_index";
+
+    sc_addr addr = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_addr found;
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) != SC_RESULT_OK);
+    g_assert(sc_helper_set_system_identifier(ctx, addr, idtf.c_str(), (sc_uint32)idtf.size()) == SC_RESULT_OK);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(found, addr));
+
+    // identifier can't be used twice, and its prefix is another identifier
+    sc_addr addr2 = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    g_assert(sc_helper_set_system_identifier(ctx, addr2, idtf.c_str(), (sc_uint32)idtf.size()) == SC_RESULT_ERROR_INVALID_PARAMS);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size() - 1, &found) != SC_RESULT_OK);
+
+    // identifier is released, when sc-element is deleted
+    g_assert(sc_memory_element_free(ctx, addr) == SC_RESULT_OK);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) != SC_RESULT_OK);
+    g_assert(sc_helper_set_system_identifier(ctx, addr2, idtf.c_str(), (sc_uint32)idtf.size()) == SC_RESULT_OK);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(found, addr2));
+
+    // and when relation between sc-element and its identifier is deleted
+    sc_addr link;
+    g_assert(sc_helper_get_system_identifier_link(ctx, addr2, &link) == SC_RESULT_OK);
+    sc_iterator3 *it = sc_iterator3_f_a_f_new(ctx, addr2, sc_type_arc_common | sc_type_const, link);
+    g_assert(sc_iterator3_next(it) == SC_TRUE);
+    g_assert(sc_memory_element_free(ctx, sc_iterator3_value(it, 1)) == SC_RESULT_OK);
+    sc_iterator3_free(it);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) != SC_RESULT_OK);
+    g_assert(sc_memory_is_element(ctx, addr2) == SC_TRUE);
+
+    // identifier construction, that is created without sc-helper, is found too
+    sc_addr nrel_idtf;
+    g_assert(sc_helper_get_keynode(ctx, SC_KEYNODE_NREL_SYSTEM_IDENTIFIER, &nrel_idtf) == SC_RESULT_OK);
+    sc_stream *stream = sc_stream_memory_new(idtf.c_str(), (sc_uint)idtf.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+    g_assert(sc_memory_set_link_content(ctx, link, stream) == SC_RESULT_OK);
+    sc_stream_free(stream);
+    sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_common | sc_type_const, addr2, link);
+    sc_addr const attr_arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, nrel_idtf, arc);
+    g_assert(SC_ADDR_IS_NOT_EMPTY(attr_arc));
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(found, addr2));
+    g_assert(sc_helper_set_system_identifier(ctx, addr, idtf.c_str(), (sc_uint32)idtf.size()) == SC_RESULT_ERROR_INVALID_PARAMS);
+
+    // identifier is changed with content of its sc-link
+    std::string const new_idtf = idtf + "_changed";
+    stream = sc_stream_memory_new(new_idtf.c_str(), (sc_uint)new_idtf.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+    g_assert(sc_memory_set_link_content(ctx, link, stream) == SC_RESULT_OK);
+    sc_stream_free(stream);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, idtf.c_str(), (sc_uint32)idtf.size(), &found) != SC_RESULT_OK);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, new_idtf.c_str(), (sc_uint32)new_idtf.size(), &found) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(found, addr2));
+
+    // content of sc-link can be set after construction is created
+    std::string const late_idtf = idtf + "_late";
+    sc_addr const late_link = sc_memory_link_new(ctx);
+    sc_addr const late_arc = sc_memory_arc_new(ctx, sc_type_arc_common | sc_type_const, addr2, late_link);
+    g_assert(SC_ADDR_IS_NOT_EMPTY(sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, nrel_idtf, late_arc)));
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, late_idtf.c_str(), (sc_uint32)late_idtf.size(), &found) != SC_RESULT_OK);
+    stream = sc_stream_memory_new(late_idtf.c_str(), (sc_uint)late_idtf.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+    g_assert(sc_memory_set_link_content(ctx, late_link, stream) == SC_RESULT_OK);
+    sc_stream_free(stream);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, late_idtf.c_str(), (sc_uint32)late_idtf.size(), &found) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(found, addr2));
+
+    // construction, that is created by batch, is found too
+    std::string const batch_idtf = idtf + "_batch";
+    sc_addr const batch_link = sc_memory_link_new(ctx);
+    stream = sc_stream_memory_new(batch_idtf.c_str(), (sc_uint)batch_idtf.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+    g_assert(sc_memory_set_link_content(ctx, batch_link, stream) == SC_RESULT_OK);
+    sc_stream_free(stream);
+
+    sc_element_spec specs[3];
+    memset(specs, 0, sizeof(specs));
+    for (sc_uint32 i = 0; i < G_N_ELEMENTS(specs); ++i)
+        specs[i].begin_index = specs[i].end_index = SC_ELEMENT_SPEC_NO_INDEX;
+    specs[0].type = sc_type_node | sc_type_const;
+    specs[1].type = sc_type_arc_common | sc_type_const;
+    specs[1].begin_index = 0;
+    specs[1].end = batch_link;
+    specs[2].type = sc_type_arc_pos_const_perm;
+    specs[2].begin = nrel_idtf;
+    specs[2].end_index = 1;
+
+    sc_addr batch[3];
+    g_assert(sc_memory_elements_new(ctx, specs, G_N_ELEMENTS(specs), batch) == SC_RESULT_OK);
+    g_assert(sc_helper_find_element_by_system_identifier(ctx, batch_idtf.c_str(), (sc_uint32)batch_idtf.size(), &found) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(found, batch[0]));
+
+    sc_memory_context_free(ctx);
+    shutdown_memory();
+}
+
+void test_save_mapped()
+{
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory.ini";
+    p.ext_path = 0;
+    std::vector<sc_addr> addrs;
+
+    static sc_uint32 const ADDRS_COUNT = 3000;
+    addrs.reserve(ADDRS_COUNT * 2);
+
+    // contents of sc-links are stored apart from elements, so check both short (stored in memory) and long ones
+    char const *datas[] = { "short", "content, that is longer than checksum of sc-link" };
+    sc_addr links[2];
+
+    sc_memory_initialize(&p);
+    s_default_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    for (uint32_t i = 0; i < ADDRS_COUNT; ++i)
+        addrs.push_back(sc_memory_node_new(s_default_ctx, sc_type_node | sc_type_const));
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        sc_stream *stream = sc_stream_memory_new(datas[i], (sc_uint)strlen(datas[i]), SC_STREAM_FLAG_READ, SC_FALSE);
+        links[i] = sc_memory_link_new(s_default_ctx);
+        g_assert(sc_memory_set_link_content(s_default_ctx, links[i], stream) == SC_RESULT_OK);
+        sc_stream_free(stream);
+    }
+    sc_memory_context_free(s_default_ctx);
+    sc_memory_shutdown(SC_TRUE);
+
+    // modify sc-elements in mapped segments and save them again
+    p.clear = SC_FALSE;
+    sc_memory_initialize(&p);
+    s_default_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    for (uint32_t i = 0; i < ADDRS_COUNT; i += 2)
+        g_assert(sc_memory_element_free(s_default_ctx, addrs[i]) == SC_RESULT_OK);
+    for (uint32_t i = 0; i < ADDRS_COUNT; ++i)
+        addrs.push_back(sc_memory_node_new(s_default_ctx, sc_type_node | sc_type_var));
+    sc_memory_context_free(s_default_ctx);
+    sc_memory_shutdown(SC_TRUE);
+
+    sc_memory_initialize(&p);
+    s_default_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    print_storage_statistics();
+    for (uint32_t i = 0; i < addrs.size(); ++i)
+    {
+        if (i < ADDRS_COUNT && (i % 2) == 0)
+            continue;
+
+        sc_type type = 0;
+        g_assert(sc_memory_get_element_type(s_default_ctx, addrs[i], &type) == SC_RESULT_OK);
+        g_assert(type == (sc_type_node | (i < ADDRS_COUNT ? sc_type_const : sc_type_var)));
+    }
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        sc_stream *stream = sc_stream_memory_new(datas[i], (sc_uint)strlen(datas[i]), SC_STREAM_FLAG_READ, SC_FALSE);
+        sc_stream *rstream = 0;
+        g_assert(sc_memory_get_link_content(s_default_ctx, links[i], &rstream) == SC_RESULT_OK);
+        g_assert(test_stream_equal(stream, rstream) == SC_TRUE);
+        sc_stream_free(rstream);
+        sc_stream_free(stream);
+    }
+    sc_memory_context_free(s_default_ctx);
+    sc_memory_shutdown(SC_FALSE);
+
+    // damaged segment is refused on first usage, and its data is saved apart
+    sc_fs_storage_map_header header;
+    sc_element el;
+    FILE *file = fopen("repo/segments.scdb", "r+b");
+    g_assert(file != 0);
+    g_assert(fread(&header, sizeof(header), 1, file) == 1);
+    g_assert(fseek(file, (long)(header.data_offset + sizeof(sc_element) * addrs[1].offset), SEEK_SET) == 0);
+    g_assert(fread(&el, sizeof(el), 1, file) == 1);
+    el.flags.type = sc_type_node | sc_type_var;
+    g_assert(fseek(file, (long)(header.data_offset + sizeof(sc_element) * addrs[1].offset), SEEK_SET) == 0);
+    g_assert(fwrite(&el, sizeof(el), 1, file) == 1);
+    fclose(file);
+    remove("repo/segments.scdb.damaged_0");
+
+    sc_memory_initialize(&p);
+    s_default_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    sc_type type = 0;
+    g_assert(sc_memory_get_element_type(s_default_ctx, addrs[1], &type) != SC_RESULT_OK);
+    g_assert(g_file_test("repo/segments.scdb.damaged_0", G_FILE_TEST_IS_REGULAR) == TRUE);
+    g_assert(SC_ADDR_IS_NOT_EMPTY(sc_memory_node_new(s_default_ctx, sc_type_node | sc_type_const)));
+    sc_memory_context_free(s_default_ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
+void test_save_journal()
+{
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory.ini";
+    p.ext_path = 0;
+    std::vector<sc_addr> addrs;
+
+    static sc_uint32 const ADDRS_COUNT = 1000;
+
+    sc_memory_initialize(&p);
+    s_default_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    for (uint32_t i = 0; i < ADDRS_COUNT; ++i)
+        addrs.push_back(sc_memory_node_new(s_default_ctx, sc_type_node | sc_type_const));
+    sc_memory_context_free(s_default_ctx);
+    sc_memory_shutdown(SC_TRUE);
+
+    // journal contains saved copy of the first segment
+    sc_fs_storage_map_header header;
+    sc_fs_storage_segment_info info;
+    std::vector<char> data(SC_SEG_DATA_SIZE_BYTE);
+
+    FILE *file = fopen("repo/segments.scdb", "r+b");
+    g_assert(file != 0);
+    g_assert(fread(&header, sizeof(header), 1, file) == 1);
+    g_assert(fread(&info, sizeof(info), 1, file) == 1);
+    g_assert(fseek(file, (long)header.data_offset, SEEK_SET) == 0);
+    g_assert(fread(data.data(), data.size(), 1, file) == 1);
+
+    sc_fs_storage_journal_header journal_header;
+    journal_header.magic = SC_STORAGE_JOURNAL_MAGIC;
+    journal_header.segments_num = header.segments_num;
+    journal_header.count = 1;
+    journal_header.reserved = 0;
+    sc_uint32 const idx = 0;
+
+    FILE *journal = fopen("repo/segments.scdb.journal", "wb");
+    g_assert(journal != 0);
+    fwrite(&journal_header, sizeof(journal_header), 1, journal);
+    fwrite(&idx, sizeof(idx), 1, journal);
+    fwrite(&info, sizeof(info), 1, journal);
+    fwrite(data.data(), data.size(), 1, journal);
+    fclose(journal);
+
+    // crash in the middle of in place write damaged the first segment
+    std::vector<char> const zeros(SC_STORAGE_MAP_PAGE_SIZE, 0);
+    g_assert(fseek(file, (long)header.data_offset, SEEK_SET) == 0);
+    g_assert(fwrite(zeros.data(), zeros.size(), 1, file) == 1);
+    fclose(file);
+
+    // complete journal is applied, and incomplete one is removed without changes
+    p.clear = SC_FALSE;
+    for (int complete = 1; complete >= 0; --complete)
+    {
+        if (complete == 0)
+        {
+            journal_header.magic = 0;
+            journal = fopen("repo/segments.scdb.journal", "wb");
+            g_assert(journal != 0);
+            fwrite(&journal_header, sizeof(journal_header), 1, journal);
+            fwrite(&idx, sizeof(idx), 1, journal);
+            fwrite(zeros.data(), zeros.size(), 1, journal);
+            fclose(journal);
+        }
+
+        sc_memory_initialize(&p);
+        s_default_ctx = sc_memory_context_new(sc_access_lvl_make_max);
+        g_assert(g_file_test("repo/segments.scdb.journal", G_FILE_TEST_EXISTS) == FALSE);
+        for (uint32_t i = 0; i < addrs.size(); ++i)
+        {
+            sc_type type = 0;
+            g_assert(sc_memory_get_element_type(s_default_ctx, addrs[i], &type) == SC_RESULT_OK);
+            g_assert(type == (sc_type_node | sc_type_const));
+        }
+        sc_memory_context_free(s_default_ctx);
+        sc_memory_shutdown(SC_FALSE);
+    }
+}
+
+void test_wal_replay()
+{
+    // write-ahead log is enabled in configuration
+    FILE *config = fopen("sc-memory-wal.ini", "w");
+    g_assert(config != 0);
+    fprintf(config, "[memory]\nwal = true\nwal_sync = commit\n");
+    fclose(config);
+
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory-wal.ini";
+    p.ext_path = 0;
+
+    static sc_uint32 const NODES_COUNT = 1000;
+    std::vector<sc_addr> nodes, arcs;
+    char const *data = "content, that is stored in file memory";
+
+    s_default_ctx = sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    g_assert(sc_memory_save(ctx) == SC_RESULT_OK);
+
+    // changes after save are restored from log
+    for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+        nodes.push_back(sc_memory_node_new(ctx, sc_type_node | sc_type_const));
+    for (sc_uint32 i = 1; i < NODES_COUNT; ++i)
+        arcs.push_back(sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, nodes[0], nodes[i]));
+    for (sc_uint32 i = 1; i < NODES_COUNT; i += 2)
+        g_assert(sc_memory_change_element_subtype(ctx, nodes[i], sc_type_node_struct | sc_type_var) == SC_RESULT_OK);
+
+    sc_addr const link = sc_memory_link_new(ctx);
+    sc_stream *stream = sc_stream_memory_new(data, (sc_uint)strlen(data), SC_STREAM_FLAG_READ, SC_FALSE);
+    g_assert(sc_memory_set_link_content(ctx, link, stream) == SC_RESULT_OK);
+
+    // freed cells can be reused by new sc-elements, so they are deleted last
+    for (sc_uint32 i = 2; i < NODES_COUNT; i += 3)
+        g_assert(sc_memory_element_free(ctx, nodes[i]) == SC_RESULT_OK);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+
+    p.clear = SC_FALSE;
+    s_default_ctx = sc_memory_initialize(&p);
+    ctx = sc_memory_context_new(sc_access_lvl_make_max);
+
+    for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+    {
+        bool const deleted = (i >= 2 && (i - 2) % 3 == 0);
+        g_assert(sc_memory_is_element(ctx, nodes[i]) == (deleted ? SC_FALSE : SC_TRUE));
+        if (i > 0)
+            g_assert(sc_memory_is_element(ctx, arcs[i - 1]) == (deleted ? SC_FALSE : SC_TRUE));
+        if (deleted)
+            continue;
+
+        sc_type type = 0;
+        g_assert(sc_memory_get_element_type(ctx, nodes[i], &type) == SC_RESULT_OK);
+        g_assert(type == ((i % 2) ? (sc_type_node | sc_type_node_struct | sc_type_var) : (sc_type_node | sc_type_const)));
+    }
+
+    // output arcs list is restored
+    sc_uint32 arcs_count = 0;
+    sc_iterator3 *it = sc_iterator3_f_a_a_new(ctx, nodes[0], sc_type_arc_pos_const_perm, 0);
+    while (sc_iterator3_next(it) == SC_TRUE)
+        ++arcs_count;
+    sc_iterator3_free(it);
+    g_assert(arcs_count == NODES_COUNT - 1 - NODES_COUNT / 3);
+
+    sc_stream *rstream = 0;
+    g_assert(sc_memory_get_link_content(ctx, link, &rstream) == SC_RESULT_OK);
+    g_assert(test_stream_equal(stream, rstream) == SC_TRUE);
+    sc_stream_free(rstream);
+    sc_stream_free(stream);
+
+    // new sc-elements don't overwrite restored ones
+    for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+    {
+        sc_addr const addr = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+        for (sc_uint32 j = 0; j < NODES_COUNT; ++j)
+            g_assert(SC_ADDR_IS_NOT_EQUAL(addr, nodes[j]) || (j >= 2 && (j - 2) % 3 == 0));
+    }
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+    remove("sc-memory-wal.ini");
+}
+
+// Returns number of the last log file in repository
+sc_uint32 test_wal_last_file()
+{
+    sc_uint32 last = 0, num = 0;
+    GDir *dir = g_dir_open("repo", 0, 0);
+    g_assert(dir != 0);
+
+    gchar const *name = 0;
+    while ((name = g_dir_read_name(dir)) != 0)
+    {
+        if (sscanf(name, "wal_%u.log", &num) == 1 && num > last)
+            last = num;
+    }
+    g_dir_close(dir);
+
+    return last;
+}
+
+void test_wal_torn_record()
+{
+    FILE *config = fopen("sc-memory-wal.ini", "w");
+    g_assert(config != 0);
+    fprintf(config, "[memory]\nwal = true\nwal_sync = commit\n");
+    fclose(config);
+
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory-wal.ini";
+    p.ext_path = 0;
+
+    s_default_ctx = sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    g_assert(sc_memory_save(ctx) == SC_RESULT_OK);
+    sc_addr const node = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+
+    /* log file before the last one ends with torn record (crash was in the middle of write, and memory
+     * was restarted), so it's replayed and cut, but doesn't prevent replay of the next file
+     */
+    sc_uint32 const last = test_wal_last_file();
+    g_assert(last > 1);
+
+    char last_path[256], torn_path[256];
+    g_snprintf(last_path, sizeof(last_path), "repo/wal_%.10u.log", last);
+    g_snprintf(torn_path, sizeof(torn_path), "repo/wal_%.10u.log", last - 1);
+
+    char header[16];
+    FILE *in = fopen(last_path, "rb");
+    g_assert(in != 0);
+    g_assert(fread(header, 1, sizeof(header), in) == sizeof(header));
+    fclose(in);
+
+    char const torn[] = "SCWR torn";
+    FILE *out = fopen(torn_path, "wb");
+    g_assert(out != 0);
+    fwrite(header, 1, sizeof(header), out);
+    fwrite(torn, 1, sizeof(torn), out);
+    fclose(out);
+
+    p.clear = SC_FALSE;
+    for (int restart = 0; restart < 2; ++restart)
+    {
+        s_default_ctx = sc_memory_initialize(&p);
+        ctx = sc_memory_context_new(sc_access_lvl_make_max);
+        g_assert(sc_memory_is_element(ctx, node) == SC_TRUE);
+        sc_memory_context_free(ctx);
+        sc_memory_shutdown(SC_FALSE);
+
+        // replayed files are removed by checkpoint on initialization
+        g_assert(g_file_test(torn_path, G_FILE_TEST_EXISTS) == FALSE);
+    }
+
+    remove("sc-memory-wal.ini");
+}
+
+void test_fm_packed()
+{
+    // packed file memory engine is selected in configuration. Write-ahead log restores sc-links, that weren't saved
+    FILE *config = fopen("sc-memory-packed.ini", "w");
+    g_assert(config != 0);
+    fprintf(config, "[memory]\nwal = true\nwal_sync = commit\n[filememory]\nengine = packed\n");
+    fclose(config);
+
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory-packed.ini";
+    p.ext_path = 0;
+
+    static sc_uint32 const LINKS_COUNT = 10;
+    char const *datas[] = { "content, that is shared by many sc-links",
+                            "content, that is removed after save",
+                            "content, that is appended after save" };
+    sc_stream *streams[3];
+    std::vector<sc_addr> links;
+    sc_addr *result = 0;
+    sc_uint32 count = 0;
+
+    for (sc_uint32 i = 0; i < 3; ++i)
+        streams[i] = sc_stream_memory_new(datas[i], (sc_uint)strlen(datas[i]), SC_STREAM_FLAG_READ, SC_FALSE);
+
+    s_default_ctx = sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+
+    // data file contains system identifiers already
+    gchar *data = 0;
+    gsize data_len = 0, data_len_before = 0;
+    g_assert(g_file_get_contents("repo/packed/data_0.bin", &data, &data_len_before, 0) == TRUE);
+    g_free(data);
+
+    for (sc_uint32 i = 0; i < LINKS_COUNT; ++i)
+    {
+        links.push_back(sc_memory_link_new(ctx));
+        g_assert(sc_memory_set_link_content(ctx, links.back(), streams[0]) == SC_RESULT_OK);
+    }
+    sc_addr const removed_link = sc_memory_link_new(ctx);
+    g_assert(sc_memory_set_link_content(ctx, removed_link, streams[1]) == SC_RESULT_OK);
+
+    // the same content is stored once, not for each sc-link
+    g_assert(g_file_get_contents("repo/packed/data_0.bin", &data, &data_len, 0) == TRUE);
+    g_assert(data_len - data_len_before < (LINKS_COUNT / 2) * strlen(datas[0]));
+    g_free(data);
+
+    g_assert(sc_memory_find_links_with_content(ctx, streams[0], &result, &count) == SC_RESULT_OK);
+    g_assert(count == LINKS_COUNT);
+    g_free(result);
+    result = 0;
+
+    for (sc_uint32 i = 0; i < LINKS_COUNT; ++i)
+    {
+        sc_stream *rstream = 0;
+        g_assert(sc_memory_get_link_content(ctx, links[i], &rstream) == SC_RESULT_OK);
+        g_assert(sc_stream_seek(streams[0], SC_STREAM_SEEK_SET, 0) == SC_RESULT_OK);
+        g_assert(test_stream_equal(streams[0], rstream) == SC_TRUE);
+        sc_stream_free(rstream);
+    }
+
+    g_assert(sc_memory_save(ctx) == SC_RESULT_OK);
+
+    // changes after save are restored from references log
+    for (sc_uint32 i = 0; i < LINKS_COUNT; i += 2)
+        g_assert(sc_memory_element_free(ctx, links[i]) == SC_RESULT_OK);
+    g_assert(sc_memory_element_free(ctx, removed_link) == SC_RESULT_OK);
+
+    sc_addr const new_link = sc_memory_link_new(ctx);
+    g_assert(sc_memory_set_link_content(ctx, new_link, streams[2]) == SC_RESULT_OK);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+
+    p.clear = SC_FALSE;
+    for (sc_uint32 pass = 0; pass < 2; ++pass)
+    {
+        s_default_ctx = sc_memory_initialize(&p);
+        ctx = sc_memory_context_new(sc_access_lvl_make_max);
+
+        g_assert(sc_memory_find_links_with_content(ctx, streams[0], &result, &count) == SC_RESULT_OK);
+        g_assert(count == LINKS_COUNT / 2);
+        for (sc_uint32 i = 0; i < count; ++i)
+            g_assert(sc_memory_is_element(ctx, result[i]) == SC_TRUE);
+        g_free(result);
+        result = 0;
+
+        g_assert(sc_memory_find_links_with_content(ctx, streams[1], &result, &count) == SC_RESULT_ERROR_NOT_FOUND);
+        g_assert(count == 0);
+
+        g_assert(sc_memory_find_links_with_content(ctx, streams[2], &result, &count) == SC_RESULT_OK);
+        g_assert(count == 1);
+        g_assert(SC_ADDR_IS_EQUAL(result[0], new_link));
+        g_free(result);
+        result = 0;
+
+        sc_stream *rstream = 0;
+        g_assert(sc_memory_get_link_content(ctx, new_link, &rstream) == SC_RESULT_OK);
+        g_assert(sc_stream_seek(streams[2], SC_STREAM_SEEK_SET, 0) == SC_RESULT_OK);
+        g_assert(test_stream_equal(streams[2], rstream) == SC_TRUE);
+        sc_stream_free(rstream);
+
+        // the second pass loads saved index
+        sc_memory_context_free(ctx);
+        sc_memory_shutdown(SC_TRUE);
+    }
+
+    for (sc_uint32 i = 0; i < 3; ++i)
+        sc_stream_free(streams[i]);
+    remove("sc-memory-packed.ini");
+}
+
+void test_link_checksum()
+{
+    // data is longer than read buffer, so file stream is read by several blocks
+    std::string data(200 * 1024 + 7, 0);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (char)(i * 31 + i / 97);
+
+    FILE *file = fopen("checksum.bin", "wb");
+    g_assert(file != 0);
+    g_assert(fwrite(data.c_str(), 1, data.size(), file) == data.size());
+    fclose(file);
+
+    sc_stream *mstream = sc_stream_memory_new(data.c_str(), (sc_uint)data.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+    sc_stream *fstream = sc_stream_file_new("checksum.bin", SC_STREAM_FLAG_READ);
+    g_assert(fstream != 0);
+
+    sc_check_sum sum1, sum2;
+    sc_char str[SC_CHECKSUM_STRING_SIZE];
+
+    g_assert(sc_link_calculate_checksum_by(mstream, SC_CHECKSUM_FAST128, &sum1) == SC_TRUE);
+    g_assert(sc_link_calculate_checksum_by(fstream, SC_CHECKSUM_FAST128, &sum2) == SC_TRUE);
+    g_assert(sum1.len == SC_CHECKSUM_BINARY_LEN);
+    g_assert(sc_link_checksum_is_binary(&sum1) == SC_TRUE);
+    g_assert(sum1.len == sum2.len && memcmp(sum1.data, sum2.data, sum1.len) == 0);
+    g_assert(sc_link_checksum_to_string(&sum1, str) == SC_CHECKSUM_BINARY_LEN * 2);
+    g_assert(strspn(str, "0123456789abcdef") == SC_CHECKSUM_BINARY_LEN * 2);
+
+    // content length is a part of binary checksum
+    sc_uint64 length = 0;
+    for (sc_uint32 i = 0; i < 7; ++i)
+        length |= (sc_uint64)(sc_uint8)sum1.data[1 + i] << (8 * i);
+    g_assert(length == data.size());
+
+    // legacy checksum is a hex string
+    g_assert(sc_link_calculate_checksum_by(mstream, SC_CHECKSUM_SHA256, &sum1) == SC_TRUE);
+    g_assert(sc_link_calculate_checksum_by(fstream, SC_CHECKSUM_SHA256, &sum2) == SC_TRUE);
+    g_assert(sum1.len == SC_CHECKSUM_LEN);
+    g_assert(sc_link_checksum_is_binary(&sum1) == SC_FALSE);
+    g_assert(memcmp(sum1.data, sum2.data, sum1.len) == 0);
+    g_assert(sc_link_checksum_to_string(&sum1, str) == SC_CHECKSUM_LEN);
+    g_assert(strspn(str, "0123456789abcdef") == SC_CHECKSUM_LEN);
+
+    g_assert(sc_link_streams_equal(mstream, fstream) == SC_TRUE);
+    sc_stream_free(mstream);
+    sc_stream_free(fstream);
+    remove("checksum.bin");
+
+    // each prefix and each changed byte give another checksum
+    std::set<std::string> sums;
+    for (sc_uint32 len = 0; len < 100; ++len)
+    {
+        sc_stream *stream = sc_stream_memory_new(data.c_str(), len, SC_STREAM_FLAG_READ, SC_FALSE);
+        g_assert(sc_link_calculate_checksum_by(stream, SC_CHECKSUM_FAST128, &sum1) == SC_TRUE);
+        g_assert(sums.insert(std::string(sum1.data, sum1.len)).second);
+        sc_stream_free(stream);
+    }
+    for (sc_uint32 i = 0; i < 100; ++i)
+    {
+        std::string changed = data.substr(0, 100);
+        changed[i] ^= 1;
+        sc_stream *stream = sc_stream_memory_new(changed.c_str(), (sc_uint)changed.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+        g_assert(sc_link_calculate_checksum_by(stream, SC_CHECKSUM_FAST128, &sum1) == SC_TRUE);
+        g_assert(sums.insert(std::string(sum1.data, sum1.len)).second);
+        sc_stream_free(stream);
+    }
+
+    // new repository uses fast checksum
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory.ini";
+    p.ext_path = 0;
+
+    std::string const small = "small content";
+    sc_stream *streams[2];
+    streams[0] = sc_stream_memory_new(data.c_str(), (sc_uint)data.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+    streams[1] = sc_stream_memory_new(small.c_str(), (sc_uint)small.size(), SC_STREAM_FLAG_READ, SC_FALSE);
+
+    sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    g_assert(sc_link_checksum_get_algorithm() == SC_CHECKSUM_FAST128);
+
+    sc_addr links[3];
+    for (sc_uint32 i = 0; i < 3; ++i)
+    {
+        links[i] = sc_memory_link_new(ctx);
+        g_assert(sc_memory_set_link_content(ctx, links[i], streams[i / 2]) == SC_RESULT_OK);
+    }
+
+    sc_addr *result = 0;
+    sc_uint32 count = 0;
+    for (sc_uint32 i = 0; i < 2; ++i)
+    {
+        g_assert(sc_memory_find_links_with_content(ctx, streams[i], &result, &count) == SC_RESULT_OK);
+        g_assert(count == (i == 0 ? 2 : 1));
+        g_free(result);
+        result = 0;
+    }
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_TRUE);
+
+    // repository without checksum file is created by previous version, so it uses legacy checksum
+    g_assert(remove("repo/content_checksum") == 0);
+    p.clear = SC_FALSE;
+    for (sc_uint32 pass = 0; pass < 2; ++pass)
+    {
+        sc_memory_initialize(&p);
+        ctx = sc_memory_context_new(sc_access_lvl_make_max);
+        g_assert(sc_link_checksum_get_algorithm() == SC_CHECKSUM_SHA256);
+
+        // contents with binary checksums are still available
+        sc_stream *rstream = 0;
+        g_assert(sc_memory_get_link_content(ctx, links[0], &rstream) == SC_RESULT_OK);
+        g_assert(sc_stream_seek(streams[0], SC_STREAM_SEEK_SET, 0) == SC_RESULT_OK);
+        g_assert(test_stream_equal(streams[0], rstream) == SC_TRUE);
+        sc_stream_free(rstream);
+
+        if (pass == 0)
+            g_assert(sc_memory_set_link_content(ctx, links[1], streams[1]) == SC_RESULT_OK);
+
+        g_assert(sc_memory_find_links_with_content(ctx, streams[1], &result, &count) == SC_RESULT_OK);
+        g_assert(count == 1);
+        g_assert(SC_ADDR_IS_EQUAL(result[0], links[1]));
+        g_free(result);
+        result = 0;
+
+        sc_memory_context_free(ctx);
+        sc_memory_shutdown(SC_TRUE);
+    }
+
+    // sc-memory isn't started with unknown algorithm of repository, and stored name isn't changed
+    g_assert(g_file_set_contents("repo/content_checksum", "unknown", -1, 0) == TRUE);
+    g_assert(sc_memory_initialize(&p) == 0);
+    gchar *name = 0;
+    g_assert(g_file_get_contents("repo/content_checksum", &name, 0, 0) == TRUE);
+    g_assert(g_strcmp0(name, "unknown") == 0);
+    g_free(name);
+
+    g_assert(g_file_set_contents("repo/content_checksum", sc_link_checksum_algorithm_name(SC_CHECKSUM_SHA256), -1, 0) == TRUE);
+    sc_memory_initialize(&p);
+    g_assert(sc_link_checksum_get_algorithm() == SC_CHECKSUM_SHA256);
+    sc_memory_shutdown(SC_FALSE);
+
+    for (sc_uint32 i = 0; i < 2; ++i)
+        sc_stream_free(streams[i]);
+}
+
+void test_arc_index()
+{
+    // index of sc-arcs is enabled in configuration
+    FILE *config = fopen("sc-memory-arc-index.ini", "w");
+    g_assert(config != 0);
+    fprintf(config, "[memory]\narc_index = true\n");
+    fclose(config);
+
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory-arc-index.ini";
+    p.ext_path = 0;
+
+    static sc_uint32 const NODES_COUNT = 50;
+    static sc_uint32 const ARCS_COUNT = 3000;
+    sc_type const types[] = { sc_type_arc_pos_const_perm, sc_type_arc_common | sc_type_const, sc_type_arc_access | sc_type_var };
+
+    s_default_ctx = sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    g_assert(sc_arc_index_is_enabled() == SC_TRUE);
+    sc_uint32 const initial_count = sc_arc_index_count();
+
+    std::vector<sc_addr> nodes, arcs;
+    for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+        nodes.push_back(sc_memory_node_new(ctx, sc_type_node | sc_type_const));
+
+    // many sc-arcs between the same elements
+    for (sc_uint32 i = 0; i < 40; ++i)
+        arcs.push_back(sc_memory_arc_new(ctx, types[i % 3], nodes[0], nodes[1]));
+    arcs.push_back(sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, nodes[2], nodes[2]));
+    arcs.push_back(sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, nodes[3], arcs[0]));
+
+    // random changes, results of index are compared with iterators. Sc-arc, that is an end of another one, isn't deleted
+    sc_uint32 const fixed = (sc_uint32)arcs.size();
+    srand(42);
+    for (sc_uint32 i = 0; i < ARCS_COUNT; ++i)
+    {
+        if (i % 3 == 2 && arcs.size() > fixed)
+        {
+            sc_uint32 const idx = fixed + rand() % (arcs.size() - fixed);
+            g_assert(sc_memory_element_free(ctx, arcs[idx]) == SC_RESULT_OK);
+            arcs[idx] = arcs.back();
+            arcs.pop_back();
+        }
+        else
+            arcs.push_back(sc_memory_arc_new(ctx, types[rand() % 3], nodes[rand() % NODES_COUNT], nodes[rand() % NODES_COUNT]));
+    }
+
+    for (sc_uint32 pass = 0; pass < 2; ++pass)
+    {
+        g_assert(sc_arc_index_count() == initial_count + arcs.size());
+
+        for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+        {
+            for (sc_uint32 j = 0; j < NODES_COUNT; ++j)
+            {
+                for (sc_uint32 t = 0; t < 4; ++t)
+                {
+                    sc_type const type = (t < 3) ? types[t] : sc_type_arc_access;
+                    sc_iterator3 *it = sc_iterator3_f_a_f_new(ctx, nodes[i], type, nodes[j]);
+                    sc_bool const exists = sc_iterator3_next(it);
+                    sc_iterator3_free(it);
+
+                    sc_addr arc;
+                    sc_result const r = sc_memory_find_arc(ctx, nodes[i], nodes[j], type, &arc);
+                    g_assert(r == (exists ? SC_RESULT_OK : SC_RESULT_ERROR_NOT_FOUND));
+                    g_assert(sc_helper_check_arc(ctx, nodes[i], nodes[j], type) == exists);
+                    if (exists)
+                    {
+                        sc_addr b, e;
+                        sc_type arc_type;
+                        g_assert(sc_memory_get_arc_info(ctx, arc, &b, &e) == SC_RESULT_OK);
+                        g_assert(SC_ADDR_IS_EQUAL(b, nodes[i]) && SC_ADDR_IS_EQUAL(e, nodes[j]));
+                        g_assert(sc_memory_get_element_type(ctx, arc, &arc_type) == SC_RESULT_OK);
+                        g_assert(sc_iterator_compare_type(arc_type, type));
+                    }
+                }
+            }
+        }
+
+        // sc-arcs of deleted element are removed from index
+        if (pass == 0)
+        {
+            sc_addr const node = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+            sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, node, nodes[0]);
+            g_assert(sc_helper_check_arc(ctx, node, nodes[0], sc_type_arc_pos_const_perm) == SC_TRUE);
+            g_assert(sc_memory_element_free(ctx, node) == SC_RESULT_OK);
+            g_assert(sc_memory_is_element(ctx, arc) == SC_FALSE);
+
+            // index is built on initialization
+            sc_memory_context_free(ctx);
+            sc_memory_shutdown(SC_TRUE);
+
+            p.clear = SC_FALSE;
+            s_default_ctx = sc_memory_initialize(&p);
+            ctx = sc_memory_context_new(sc_access_lvl_make_max);
+        }
+    }
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_TRUE);
+    g_assert(sc_arc_index_is_enabled() == SC_FALSE);
+    remove("sc-memory-arc-index.ini");
+}
+
+struct AdjacencyArc
+{
+    sc_addr arc;
+    sc_addr begin;
+    sc_addr end;
+    sc_type type;
+};
+
+std::vector<sc_addr> adjacency_iterate(sc_iterator3 *it)
+{
+    std::vector<sc_addr> result;
+    while (sc_iterator3_next(it) == SC_TRUE)
+        result.push_back(sc_iterator3_value(it, 1));
+    sc_iterator3_free(it);
+    return result;
+}
+
+//! Returns sc-arcs in order of lists: the latest is the first
+std::vector<sc_addr> adjacency_expected(std::vector<AdjacencyArc> const & arcs, sc_addr const * begin, sc_addr const * end, sc_type arc_type)
+{
+    std::vector<sc_addr> result;
+    for (size_t i = arcs.size(); i > 0; --i)
+    {
+        AdjacencyArc const & a = arcs[i - 1];
+        if ((begin == 0 || SC_ADDR_IS_EQUAL(a.begin, *begin)) &&
+            (end == 0 || SC_ADDR_IS_EQUAL(a.end, *end)) &&
+            sc_iterator_compare_type(a.type, arc_type))
+        {
+            result.push_back(a.arc);
+        }
+    }
+    return result;
+}
+
+bool adjacency_equal(std::vector<sc_addr> const & v1, std::vector<sc_addr> const & v2)
+{
+    if (v1.size() != v2.size())
+        return false;
+    for (size_t i = 0; i < v1.size(); ++i)
+    {
+        if (SC_ADDR_IS_NOT_EQUAL(v1[i], v2[i]))
+            return false;
+    }
+    return true;
+}
+
+void adjacency_check(sc_memory_context *ctx, sc_addr hub, std::vector<sc_addr> const & others, std::vector<AdjacencyArc> const & arcs)
+{
+    sc_type const types[] = { 0, sc_type_arc_access, sc_type_arc_pos_const_perm, sc_type_arc_common | sc_type_const, sc_type_arc_access | sc_type_var };
+    for (size_t t = 0; t < G_N_ELEMENTS(types); ++t)
+    {
+        // other elements are nodes
+        g_assert(adjacency_equal(adjacency_iterate(sc_iterator3_f_a_a_new(ctx, hub, types[t], sc_type_node)), adjacency_expected(arcs, &hub, 0, types[t])));
+        g_assert(adjacency_equal(adjacency_iterate(sc_iterator3_a_a_f_new(ctx, sc_type_node, types[t], hub)), adjacency_expected(arcs, 0, &hub, types[t])));
+        g_assert(adjacency_iterate(sc_iterator3_f_a_a_new(ctx, hub, types[t], sc_type_link)).empty());
+
+        for (size_t i = 0; i < others.size(); ++i)
+        {
+            g_assert(adjacency_equal(adjacency_iterate(sc_iterator3_f_a_f_new(ctx, hub, types[t], others[i])), adjacency_expected(arcs, &hub, &others[i], types[t])));
+            g_assert(adjacency_equal(adjacency_iterate(sc_iterator3_f_a_f_new(ctx, others[i], types[t], hub)), adjacency_expected(arcs, &others[i], &hub, types[t])));
+        }
+    }
+}
+
+sc_uint32 adjacency_count(std::vector<AdjacencyArc> const & arcs, sc_addr hub, bool out)
+{
+    sc_uint32 count = 0;
+    for (size_t i = 0; i < arcs.size(); ++i)
+    {
+        if (SC_ADDR_IS_EQUAL(out ? arcs[i].begin : arcs[i].end, hub))
+            ++count;
+    }
+    return count;
+}
+
+void test_adjacency()
+{
+    // adjacency is built for elements with more than 16 sc-arcs
+    FILE *config = fopen("sc-memory-adjacency.ini", "w");
+    g_assert(config != 0);
+    fprintf(config, "[memory]\nadjacency_threshold = 16\n");
+    fclose(config);
+
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory-adjacency.ini";
+    p.ext_path = 0;
+
+    static sc_uint32 const OTHERS_COUNT = 20;
+    sc_type const types[] = { sc_type_arc_pos_const_perm, sc_type_arc_common | sc_type_const, sc_type_arc_access | sc_type_var };
+
+    s_default_ctx = sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+
+    sc_addr const hub = sc_memory_node_new(ctx, sc_type_node | sc_type_node_class);
+    std::vector<sc_addr> others;
+    for (sc_uint32 i = 0; i < OTHERS_COUNT; ++i)
+        others.push_back(sc_memory_node_new(ctx, sc_type_node | ((i % 2) ? sc_type_const : sc_type_var)));
+
+    std::vector<AdjacencyArc> arcs;
+    srand(7);
+    for (sc_uint32 i = 0; i < 300; ++i)
+    {
+        AdjacencyArc a;
+        a.type = types[rand() % 3];
+        a.begin = (i % 3 == 2) ? others[rand() % OTHERS_COUNT] : hub;
+        a.end = (i % 3 == 2) ? hub : others[rand() % OTHERS_COUNT];
+        if (i == 100)
+            a.begin = a.end = hub;
+        a.arc = sc_memory_arc_new(ctx, a.type, a.begin, a.end);
+        g_assert(SC_ADDR_IS_NOT_EMPTY(a.arc));
+        arcs.push_back(a);
+    }
+
+    // the first iteration walks lists and builds adjacency
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_OUT) == 0);
+    adjacency_check(ctx, hub, others, arcs);
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_OUT) == adjacency_count(arcs, hub, true));
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_IN) == adjacency_count(arcs, hub, false));
+    adjacency_check(ctx, hub, others, arcs);
+
+    // changes are applied to adjacency
+    for (sc_uint32 i = 0; i < 200; ++i)
+    {
+        sc_uint32 const idx = rand() % arcs.size();
+        switch (i % 3)
+        {
+        case 0:
+            g_assert(sc_memory_element_free(ctx, arcs[idx].arc) == SC_RESULT_OK);
+            arcs.erase(arcs.begin() + idx);
+            break;
+
+        case 1:
+        {
+            AdjacencyArc a;
+            a.type = types[rand() % 3];
+            a.begin = (rand() % 2) ? others[rand() % OTHERS_COUNT] : hub;
+            a.end = SC_ADDR_IS_EQUAL(a.begin, hub) ? others[rand() % OTHERS_COUNT] : hub;
+            a.arc = sc_memory_arc_new(ctx, a.type, a.begin, a.end);
+            arcs.push_back(a);
+            break;
+        }
+
+        default:
+            if (arcs[idx].type & sc_type_arc_access)
+            {
+                sc_type const subtype = (arcs[idx].type & sc_type_const) ? (sc_type_var | sc_type_arc_pos | sc_type_arc_temp) : (sc_type_const | sc_type_arc_pos | sc_type_arc_perm);
+                g_assert(sc_memory_change_element_subtype(ctx, arcs[idx].arc, subtype) == SC_RESULT_OK);
+                arcs[idx].type = sc_type_arc_access | subtype;
+            }
+            break;
+        }
+    }
+
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_OUT) == adjacency_count(arcs, hub, true));
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_IN) == adjacency_count(arcs, hub, false));
+    adjacency_check(ctx, hub, others, arcs);
+
+    // sc-arcs of deleted element are removed from adjacency
+    sc_addr const removed = others.back();
+    g_assert(sc_memory_element_free(ctx, removed) == SC_RESULT_OK);
+    others.pop_back();
+    for (size_t i = arcs.size(); i > 0; --i)
+    {
+        if (SC_ADDR_IS_EQUAL(arcs[i - 1].begin, removed) || SC_ADDR_IS_EQUAL(arcs[i - 1].end, removed))
+            arcs.erase(arcs.begin() + (i - 1));
+    }
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_OUT) == adjacency_count(arcs, hub, true));
+    adjacency_check(ctx, hub, others, arcs);
+
+    // adjacency of deleted element is removed, so new element in its place doesn't use it
+    g_assert(sc_memory_element_free(ctx, hub) == SC_RESULT_OK);
+    g_assert(sc_adjacency_count(hub, SC_ADJACENCY_OUT) == 0);
+    arcs.clear();
+    sc_addr const node = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, node, others[0]);
+    AdjacencyArc a = { arc, node, others[0], sc_type_arc_pos_const_perm };
+    arcs.push_back(a);
+    adjacency_check(ctx, node, others, arcs);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+    remove("sc-memory-adjacency.ini");
+}
+
+void test_segment_pages()
+{
+    sc_segment *seg = sc_segment_new(1);
+    g_assert(sc_segment_get_pages_count(seg) == 0);
+
+    // just page of used element is allocated
+    sc_element *el = sc_segment_get_element(seg, SC_SEGMENT_ELEMENTS_COUNT - 1);
+    el->flags.type = sc_type_node;
+    g_assert(sc_segment_get_pages_count(seg) == 1);
+    g_assert(sc_segment_get_element(seg, SC_SEGMENT_ELEMENTS_COUNT - 1) == el);
+
+    // sequential elements of one section are stored in the same page
+    g_assert(sc_segment_get_element(seg, 5) + 1 == sc_segment_get_element(seg, 5 + SC_CONCURRENCY_LEVEL));
+    g_assert(sc_segment_get_pages_count(seg) == 2);
+    sc_segment_get_element(seg, 6);
+    g_assert(sc_segment_get_pages_count(seg) == 3);
+
+    // empty events mask doesn't require meta info
+    g_assert(sc_segment_get_events_mask(seg, 0) == 0);
+    sc_segment_remove_events_mask(seg, 0, 1);
+    g_assert(seg->meta_pages[0] == 0);
+    sc_segment_add_events_mask(seg, 1, 1);
+    sc_segment_add_events_mask(seg, 1, 4);
+    g_assert(sc_segment_get_events_mask(seg, 1) == 5);
+    sc_segment_remove_events_mask(seg, 1, 1);
+    g_assert(sc_segment_get_events_mask(seg, 1) == 4);
+
+    // contents are stored just for sc-links
+    sc_segment_get_element(seg, 7)->flags.type = sc_type_link;
+    sc_segment_get_content(seg, 7)->data[0] = 1;
+    g_assert(seg->content_pages[0] == 0);
+
+    std::vector<sc_element> buffer(SC_SEGMENT_ELEMENTS_COUNT);
+    std::vector<sc_content> contents(SC_SEGMENT_ELEMENTS_COUNT);
+    sc_segment_copy_elements(seg, buffer.data(), contents.data());
+    g_assert(buffer.back().flags.type == sc_type_node);
+    g_assert(buffer.front().flags.type == 0);
+    g_assert(contents[7].data[0] == 1);
+
+    // empty pages are not allocated on load
+    sc_segment *loaded = sc_segment_new(1);
+    sc_segment_set_elements(loaded, buffer.data(), contents.data());
+    sc_segment_loaded(loaded);
+    g_assert(sc_segment_get_pages_count(loaded) == 2);
+    g_assert(sc_segment_get_elements_count(loaded) == 2);
+    g_assert(sc_segment_get_element(loaded, SC_SEGMENT_ELEMENTS_COUNT - 1)->flags.type == sc_type_node);
+    g_assert(sc_segment_get_content(loaded, 7)->data[0] == 1);
+    g_assert(loaded->content_pages[0] == 0);
+
+    // elements, that are taken under one lock, are different, even if hint of section moves back
+    sc_segment *fragmented = sc_segment_new(1);
+    for (sc_uint32 i = 0; i < SC_SEGMENT_ELEMENTS_COUNT; i += SC_CONCURRENCY_LEVEL)
+        sc_segment_get_element(fragmented, i)->flags.type = (i > 0 && i <= 3 * SC_CONCURRENCY_LEVEL) ? 0 : sc_type_node;
+    sc_segment_loaded(fragmented);
+    fragmented->sections[0].empty_offset = 3 * SC_CONCURRENCY_LEVEL;
+
+    int owner = 0;
+    sc_memory_context const *owner_ctx = reinterpret_cast<sc_memory_context const*>(&owner);
+    sc_addr_offset offsets[3];
+    g_assert(sc_segment_section_lock_empty_elements(owner_ctx, fragmented, 0, offsets, 3) == 3);
+    g_assert(std::set<sc_addr_offset>(offsets, offsets + 3).size() == 3);
+    for (sc_uint32 i = 0; i < 3; ++i)
+        g_assert(sc_segment_get_element(fragmented, offsets[i])->flags.type == sc_flag_reserved);
+    sc_segment_section_unlock(owner_ctx, &fragmented->sections[0]);
+    sc_segment_free(fragmented);
+
+    // segments table allocates blocks on demand
+    sc_segment_table *table = sc_segment_table_new();
+    g_assert(sc_segment_table_get(table, SC_SEGMENT_MAX - 1) == 0);
+    sc_segment_table_set(table, SC_SEGMENT_MAX - 1, seg);
+    sc_segment_table_set(table, 1, loaded);
+    g_assert(sc_segment_table_get(table, SC_SEGMENT_MAX - 1) == seg);
+    g_assert(sc_segment_table_get(table, 1) == loaded);
+    g_assert(sc_segment_table_get(table, 2) == 0);
+    sc_segment_table_free(table);
+
+    sc_segment_free(loaded);
+    sc_segment_free(seg);
+}
+
+void test_iterator_context()
+{
+    static const sc_uint32 arcs_count = 10;
+
+    initialize_memory();
+
+    sc_memory_context *ctx1 = sc_memory_context_new(sc_access_lvl_make_min);
+    sc_memory_context *ctx2 = sc_memory_context_new(sc_access_lvl_make_min);
+
+    sc_addr node = sc_memory_node_new(ctx1, sc_type_node | sc_type_const);
+    sc_addr attr = sc_memory_node_new(ctx1, sc_type_node | sc_type_const);
+    for (sc_uint32 i = 0; i < arcs_count; ++i)
+    {
+        sc_addr target = sc_memory_node_new(ctx1, sc_type_node | sc_type_const);
+        sc_addr arc = sc_memory_arc_new(ctx1, sc_type_arc_pos_const_perm, node, target);
+        sc_memory_arc_new(ctx1, sc_type_arc_pos_const_perm, attr, arc);
+    }
+
+    // iteration started by one context is continued by another one
+    sc_iterator3 *it3 = sc_iterator3_f_a_a_new(ctx1, node, sc_type_arc_pos_const_perm, 0);
+    sc_iterator5 *it5 = sc_iterator5_f_a_a_a_f_new(ctx1, node, sc_type_arc_pos_const_perm, 0, sc_type_arc_pos_const_perm, attr);
+    g_assert(it3 != null_ptr && it5 != null_ptr);
+
+    sc_uint32 count3 = 0, count5 = 0;
+    while (count3 < arcs_count / 2 && sc_iterator3_next(it3) == SC_TRUE)
+        ++count3;
+    while (count5 < arcs_count / 2 && sc_iterator5_next(it5) == SC_TRUE)
+        ++count5;
+
+    sc_iterator3_set_context(it3, ctx2);
+    sc_iterator5_set_context(it5, ctx2);
+    sc_memory_context_free(ctx1);
+
+    while (sc_iterator3_next(it3) == SC_TRUE)
+        ++count3;
+    while (sc_iterator5_next(it5) == SC_TRUE)
+        ++count5;
+
+    g_assert(count3 == arcs_count);
+    g_assert(count5 == arcs_count);
+
+    sc_iterator3_free(it3);
+    sc_iterator5_free(it5);
+    sc_memory_context_free(ctx2);
+
+    shutdown_memory();
+}
+
+void test_iterator_init()
+{
+    static const sc_uint32 arcs_count = 10;
+
+    initialize_memory();
+
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_min);
+    sc_memory_context *ctx_max = sc_memory_context_new(sc_access_lvl_make_max);
+
+    sc_addr node = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    for (sc_uint32 i = 0; i < arcs_count; ++i)
+    {
+        sc_addr target = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+        sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, node, target);
+        sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, target, node);
+    }
+
+    sc_iterator_param p1, p2, p3;
+    p1.is_type = SC_FALSE;
+    p1.addr = node;
+    p2.is_type = SC_TRUE;
+    p2.type = sc_type_arc_pos_const_perm;
+    p3.is_type = SC_TRUE;
+    p3.type = 0;
+
+    // the same memory is used by iterators one after another
+    sc_iterator3 it;
+    for (sc_uint32 pass = 0; pass < 3; ++pass)
+    {
+        g_assert(sc_iterator3_init(&it, ctx, sc_iterator3_f_a_a, p1, p2, p3) == SC_TRUE);
+        sc_uint32 count = 0;
+        while (sc_iterator3_next(&it) == SC_TRUE)
+        {
+            g_assert(SC_ADDR_IS_EQUAL(sc_iterator3_value(&it, 0), node));
+            ++count;
+        }
+        g_assert(count == arcs_count);
+        sc_iterator3_destroy(&it);
+
+        g_assert(sc_iterator3_init(&it, ctx, sc_iterator3_a_a_f, p3, p2, p1) == SC_TRUE);
+        count = 0;
+        while (sc_iterator3_next(&it) == SC_TRUE)
+            ++count;
+        g_assert(count == arcs_count);
+        sc_iterator3_destroy(&it);
+    }
+
+    // fixed element, that can't be read in context
+    sc_addr hidden = sc_memory_node_new(ctx_max, sc_type_node | sc_type_const);
+    p1.addr = hidden;
+    g_assert(sc_iterator3_init(&it, ctx, sc_iterator3_f_a_a, p1, p2, p3) == SC_FALSE);
+    g_assert(sc_iterator3_init(&it, ctx_max, sc_iterator3_f_a_a, p1, p2, p3) == SC_TRUE);
+    g_assert(sc_iterator3_next(&it) == SC_FALSE);
+    sc_iterator3_destroy(&it);
+
+    // element isn't locked by destroyed iterators, so it can be deleted
+    g_assert(sc_memory_element_free(ctx, node) == SC_RESULT_OK);
+    g_assert(sc_memory_is_element(ctx, node) == SC_FALSE);
+
+    sc_memory_context_free(ctx_max);
+    sc_memory_context_free(ctx);
+
+    shutdown_memory();
+}
+
+void test_optimistic_read()
+{
+    initialize_memory();
+
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_min);
+    sc_addr node = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_addr target = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_addr arc = sc_memory_arc_new(ctx, sc_type_arc_pos_var_perm, node, target);
+
+    sc_element el;
+    sc_uint32 version = 0;
+    g_assert(sc_storage_element_try_read(arc, &el, &version) == SC_TRUE);
+    g_assert((version & 1) == 0);
+    g_assert(el.flags.type == sc_type_arc_pos_var_perm);
+    g_assert(SC_ADDR_IS_EQUAL(el.arc.begin, node) && SC_ADDR_IS_EQUAL(el.arc.end, target));
+
+    // readers don't change version of section
+    sc_type type = 0;
+    sc_addr begin, end;
+    g_assert(sc_memory_get_element_type(ctx, arc, &type) == SC_RESULT_OK && type == sc_type_arc_pos_var_perm);
+    g_assert(sc_memory_get_arc_info(ctx, arc, &begin, &end) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(begin, node) && SC_ADDR_IS_EQUAL(end, target));
+    g_assert(sc_memory_is_element(ctx, arc) == SC_TRUE);
+    g_assert(sc_storage_element_validate(arc, version) == SC_TRUE);
+
+    // sc-arc, that doesn't match iterator, is skipped without lock
+    sc_iterator3 *it = sc_iterator3_f_a_a_new(ctx, node, sc_type_arc_pos_const_perm, 0);
+    g_assert(sc_iterator3_next(it) == SC_FALSE);
+    sc_iterator3_free(it);
+
+    // writer does
+    g_assert(sc_storage_element_try_read(arc, &el, &version) == SC_TRUE);
+    g_assert(sc_memory_change_element_subtype(ctx, arc, sc_type_const | sc_type_arc_pos | sc_type_arc_perm) == SC_RESULT_OK);
+    g_assert(sc_storage_element_validate(arc, version) == SC_FALSE);
+    g_assert(sc_storage_element_try_read(arc, &el, &version) == SC_TRUE);
+    g_assert(el.flags.type == sc_type_arc_pos_const_perm);
+
+    it = sc_iterator3_f_a_a_new(ctx, node, sc_type_arc_pos_const_perm, 0);
+    g_assert(sc_iterator3_next(it) == SC_TRUE);
+    g_assert(SC_ADDR_IS_EQUAL(sc_iterator3_value(it, 1), arc));
+    g_assert(sc_iterator3_next(it) == SC_FALSE);
+    sc_iterator3_free(it);
+
+    // not loaded segment can't be read
+    sc_addr invalid;
+    invalid.seg = SC_ADDR_SEG_MAX - 1;
+    invalid.offset = 0;
+    g_assert(sc_storage_element_try_read(invalid, &el, &version) == SC_FALSE);
+    g_assert(sc_memory_is_element(ctx, invalid) == SC_FALSE);
+
+    sc_memory_context_free(ctx);
+
+    shutdown_memory();
+}
+
+void statistics_check_degree(sc_memory_context *ctx, sc_addr addr, sc_uint32 out_degree, sc_uint32 in_degree)
+{
+    sc_uint32 out = 0, in = 0;
+    g_assert(sc_memory_get_element_degree(ctx, addr, &out, &in) == SC_RESULT_OK);
+    g_assert(out == out_degree && in == in_degree);
+}
+
+void test_statistics()
+{
+    sc_memory_params p;
+    p.clear = SC_TRUE;
+    p.repo_path = "repo";
+    p.config_file = "sc-memory.ini";
+    p.ext_path = 0;
+
+    static sc_uint32 const MEMBERS_COUNT = 20;
+    sc_type const node_type = sc_type_node | sc_type_const | sc_type_node_material;
+    sc_type const arc_type = sc_type_arc_access | sc_type_const | sc_type_arc_neg | sc_type_arc_temp;
+    sc_type const other_arc_type = sc_type_arc_access | sc_type_const | sc_type_arc_fuz | sc_type_arc_temp;
+
+    sc_memory_initialize(&p);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    sc_uint64 const all_count = sc_memory_get_type_cardinality(ctx, 0);
+    sc_uint64 const nodes_count = sc_memory_get_type_cardinality(ctx, sc_type_node);
+    g_assert(sc_memory_get_type_cardinality(ctx, node_type) == 0);
+    g_assert(sc_memory_get_type_cardinality(ctx, arc_type) == 0);
+
+    sc_addr hub = sc_memory_node_new(ctx, node_type);
+    std::vector<sc_addr> members, arcs;
+    for (sc_uint32 i = 0; i < MEMBERS_COUNT; ++i)
+    {
+        members.push_back(sc_memory_node_new(ctx, node_type));
+        arcs.push_back(sc_memory_arc_new(ctx, arc_type, hub, members.back()));
+    }
+    sc_addr loop = sc_memory_arc_new(ctx, arc_type, hub, hub);
+
+    statistics_check_degree(ctx, hub, MEMBERS_COUNT + 1, 1);
+    statistics_check_degree(ctx, members[0], 0, 1);
+    statistics_check_degree(ctx, loop, 0, 0);
+    g_assert(sc_memory_get_type_cardinality(ctx, node_type) == MEMBERS_COUNT + 1);
+    g_assert(sc_memory_get_type_cardinality(ctx, arc_type) == MEMBERS_COUNT + 1);
+    g_assert(sc_memory_get_type_cardinality(ctx, sc_type_node) == nodes_count + MEMBERS_COUNT + 1);
+    g_assert(sc_memory_get_type_cardinality(ctx, 0) == all_count + 2 * MEMBERS_COUNT + 2);
+
+    // subtype is moved into cardinality of the new type
+    g_assert(sc_memory_change_element_subtype(ctx, arcs[0], other_arc_type & ~sc_type_element_mask) == SC_RESULT_OK);
+    g_assert(sc_memory_get_type_cardinality(ctx, arc_type) == MEMBERS_COUNT);
+    g_assert(sc_memory_get_type_cardinality(ctx, other_arc_type) == 1);
+
+    // removed sc-arcs aren't counted in degrees
+    g_assert(sc_memory_element_free(ctx, members[1]) == SC_RESULT_OK);
+    g_assert(sc_memory_element_free(ctx, loop) == SC_RESULT_OK);
+    statistics_check_degree(ctx, hub, MEMBERS_COUNT - 1, 0);
+    g_assert(sc_memory_get_type_cardinality(ctx, node_type) == MEMBERS_COUNT);
+    g_assert(sc_memory_get_type_cardinality(ctx, arc_type) == MEMBERS_COUNT - 2);
+
+    sc_uint32 out = 0, in = 0;
+    g_assert(sc_memory_get_element_degree(ctx, members[1], &out, &in) != SC_RESULT_OK);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_TRUE);
+
+    // statistics are counted again on initialization
+    p.clear = SC_FALSE;
+    sc_memory_initialize(&p);
+    ctx = sc_memory_context_new(sc_access_lvl_make_max);
+
+    statistics_check_degree(ctx, hub, MEMBERS_COUNT - 1, 0);
+    statistics_check_degree(ctx, members[2], 0, 1);
+    g_assert(sc_memory_get_type_cardinality(ctx, node_type) == MEMBERS_COUNT);
+    g_assert(sc_memory_get_type_cardinality(ctx, arc_type) == MEMBERS_COUNT - 2);
+    g_assert(sc_memory_get_type_cardinality(ctx, other_arc_type) == 1);
+
+    // removal of element removes its sc-arcs from degrees of neighbours
+    g_assert(sc_memory_element_free(ctx, hub) == SC_RESULT_OK);
+    statistics_check_degree(ctx, members[2], 0, 0);
+    g_assert(sc_memory_get_type_cardinality(ctx, node_type) == MEMBERS_COUNT - 1);
+    g_assert(sc_memory_get_type_cardinality(ctx, sc_type_arc_access | sc_type_const | sc_type_arc_temp) == 0);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
 // ---------------------------
+void elements_new_check_stat(sc_memory_context *ctx, sc_stat const *before, sc_uint32 nodes, sc_uint32 arcs, sc_uint32 links)
+{
+    sc_stat stat;
+    g_assert(sc_memory_stat(ctx, &stat) == SC_RESULT_OK);
+    g_assert(stat.node_count == before->node_count + nodes);
+    g_assert(stat.arc_count == before->arc_count + arcs);
+    g_assert(stat.link_count == before->link_count + links);
+}
+
+void test_elements_new()
+{
+    initialize_memory();
+
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make_min);
+
+    sc_addr concept = sc_memory_node_new(ctx, sc_type_node_class | sc_type_const);
+    sc_addr other = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, concept, other);
+
+    sc_stat before;
+    g_assert(sc_memory_stat(ctx, &before) == SC_RESULT_OK);
+
+    // node, link, arcs from existing element, between batch elements, to arc of batch and to existing element
+    sc_element_spec specs[6];
+    memset(specs, 0, sizeof(specs));
+    for (sc_uint32 i = 0; i < G_N_ELEMENTS(specs); ++i)
+        specs[i].begin_index = specs[i].end_index = SC_ELEMENT_SPEC_NO_INDEX;
+
+    specs[0].type = sc_type_node | sc_type_const;
+    specs[1].type = sc_type_link;
+    specs[2].type = sc_type_arc_pos_const_perm;
+    specs[2].begin = concept;
+    specs[2].end_index = 0;
+    specs[3].type = sc_type_arc_common | sc_type_const;
+    specs[3].begin_index = 0;
+    specs[3].end_index = 1;
+    specs[4].type = sc_type_arc_pos_const_perm;
+    specs[4].begin = concept;
+    specs[4].end_index = 3;
+    specs[5].type = sc_type_arc_pos_const_perm;
+    specs[5].begin_index = 0;
+    specs[5].end = other;
+
+    sc_addr result[6];
+    g_assert(sc_memory_elements_new(ctx, specs, G_N_ELEMENTS(specs), result) == SC_RESULT_OK);
+    elements_new_check_stat(ctx, &before, 1, 4, 1);
+
+    sc_type type = 0;
+    g_assert(sc_memory_get_element_type(ctx, result[0], &type) == SC_RESULT_OK && type == (sc_type_node | sc_type_const));
+    g_assert(sc_memory_get_element_type(ctx, result[1], &type) == SC_RESULT_OK && type == sc_type_link);
+    g_assert(sc_memory_get_element_type(ctx, result[3], &type) == SC_RESULT_OK && type == (sc_type_arc_common | sc_type_const));
+
+    sc_addr beg, end;
+    g_assert(sc_memory_get_arc_info(ctx, result[3], &beg, &end) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(beg, result[0]) && SC_ADDR_IS_EQUAL(end, result[1]));
+    g_assert(sc_memory_get_arc_info(ctx, result[4], &beg, &end) == SC_RESULT_OK);
+    g_assert(SC_ADDR_IS_EQUAL(beg, concept) && SC_ADDR_IS_EQUAL(end, result[3]));
+
+    // sc-arcs are linked into lists of existing elements
+    statistics_check_degree(ctx, concept, 3, 0);
+    statistics_check_degree(ctx, other, 0, 2);
+    statistics_check_degree(ctx, result[0], 2, 1);
+    statistics_check_degree(ctx, result[3], 0, 1);
+
+    sc_uint32 count = 0;
+    sc_iterator3 *it = sc_iterator3_f_a_a_new(ctx, concept, sc_type_arc_pos_const_perm, 0);
+    while (sc_iterator3_next(it) == SC_TRUE)
+        ++count;
+    sc_iterator3_free(it);
+    g_assert(count == 3);
+
+    count = 0;
+    it = sc_iterator3_a_a_f_new(ctx, 0, sc_type_arc_pos_const_perm, other);
+    while (sc_iterator3_next(it) == SC_TRUE)
+        ++count;
+    sc_iterator3_free(it);
+    g_assert(count == 2);
+
+    // invalid batches don't create anything
+    g_assert(sc_memory_stat(ctx, &before) == SC_RESULT_OK);
+
+    specs[2].end_index = 2;
+    g_assert(sc_memory_elements_new(ctx, specs, G_N_ELEMENTS(specs), result) == SC_RESULT_ERROR_INVALID_PARAMS);
+    specs[2].end_index = 0;
+
+    specs[2].type = sc_type_arc_pos_const_perm | sc_type_node;
+    g_assert(sc_memory_elements_new(ctx, specs, G_N_ELEMENTS(specs), result) == SC_RESULT_ERROR_INVALID_TYPE);
+    specs[2].type = sc_type_arc_pos_const_perm;
+
+    sc_addr removed = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    g_assert(sc_memory_element_free(ctx, removed) == SC_RESULT_OK);
+    specs[5].end = removed;
+    g_assert(sc_memory_elements_new(ctx, specs, G_N_ELEMENTS(specs), result) == SC_RESULT_ERROR_INVALID_STATE);
+    for (sc_uint32 i = 0; i < G_N_ELEMENTS(result); ++i)
+        g_assert(SC_ADDR_IS_EMPTY(result[i]));
+    elements_new_check_stat(ctx, &before, 0, 0, 0);
+    statistics_check_degree(ctx, concept, 3, 0);
+
+    // created elements are deleted as usual ones
+    specs[5].end = other;
+    g_assert(sc_memory_elements_new(ctx, specs, G_N_ELEMENTS(specs), result) == SC_RESULT_OK);
+    g_assert(sc_memory_element_free(ctx, result[0]) == SC_RESULT_OK);
+    g_assert(sc_memory_is_element(ctx, result[4]) == SC_FALSE);
+    g_assert(sc_memory_is_element(ctx, result[1]) == SC_TRUE);
+    statistics_check_degree(ctx, concept, 3, 0);
+    statistics_check_degree(ctx, other, 0, 2);
+
+    // slot, that is reserved by unfinished batch, is saved as empty one
+    sc_addr const reserved = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+    sc_element *el = 0;
+    g_assert(sc_storage_element_lock(ctx, reserved, &el) == SC_RESULT_OK);
+    el->flags.type = sc_flag_reserved;
+    g_assert(sc_storage_element_unlock(ctx, reserved) == SC_RESULT_OK);
+    g_assert(sc_memory_save(ctx) == SC_RESULT_OK);
+
+    sc_memory_context_free(ctx);
+    shutdown_memory();
+
+    sc_memory_params p = params;
+    p.clear = SC_FALSE;
+    s_default_ctx = sc_memory_initialize(&p);
+    ctx = sc_memory_context_new(sc_access_lvl_make_max);
+    g_assert(sc_storage_element_lock(ctx, reserved, &el) == SC_RESULT_OK);
+    g_assert(el->flags.type == 0);
+    g_assert(sc_storage_element_unlock(ctx, reserved) == SC_RESULT_OK);
+    g_assert(sc_memory_is_element(ctx, other) == SC_TRUE);
+
+    sc_memory_context_free(ctx);
+    shutdown_memory();
+}
+
 int main(int argc, char *argv[])
 {
     sc_memory_params_clear(&params);
@@ -700,6 +2151,21 @@ int main(int argc, char *argv[])
     /// TODO: add test for verion utils
 
     g_test_add_func("/common/save", test_save);
+    g_test_add_func("/common/sys_idtf_index", test_sys_idtf_index);
+    g_test_add_func("/common/save_mapped", test_save_mapped);
+    g_test_add_func("/common/save_journal", test_save_journal);
+    g_test_add_func("/common/wal_replay", test_wal_replay);
+    g_test_add_func("/common/wal_torn_record", test_wal_torn_record);
+    g_test_add_func("/common/fm_packed", test_fm_packed);
+    g_test_add_func("/common/link_checksum", test_link_checksum);
+    g_test_add_func("/common/arc_index", test_arc_index);
+    g_test_add_func("/common/adjacency", test_adjacency);
+    g_test_add_func("/common/segment_pages", test_segment_pages);
+    g_test_add_func("/common/iterator_context", test_iterator_context);
+    g_test_add_func("/common/iterator_init", test_iterator_init);
+    g_test_add_func("/common/optimistic_read", test_optimistic_read);
+    g_test_add_func("/common/statistics", test_statistics);
+    g_test_add_func("/common/elements_new", test_elements_new);
     g_test_add_func("/common/context", test_context);
     g_test_add_func("/common/access", test_access_levels);
     g_test_add_func("/common/deletion", test_deletion);
@@ -12,8 +12,18 @@ extern "C"
 }
 #include <vector>
 #include <limits>
+#include <algorithm>
 #include <glib.h>
 
+#ifdef __linux__
+#   include <malloc.h>
+#   include <unistd.h>
+#   include <string.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#endif
+
 sc_memory_context * s_default_ctx = 0;
 sc_memory_params params;
 
@@ -236,6 +246,754 @@ void test_save()
     sc_memory_shutdown(SC_FALSE);
 }
 
+// ---------------------------
+namespace
+{
+    struct EventsBenchElement
+    {
+        std::vector<gint64> emitTimes;
+        gint processed;
+        gint64 latencySum;
+        gint64 latencyMax;
+    };
+}
+
+sc_result events_bench_callback(const sc_event *event, sc_addr arg)
+{
+    EventsBenchElement *data = (EventsBenchElement*)sc_event_get_data(event);
+
+    // events of one element are processed in emit order, so processed count is an index of emit time
+    gint64 const latency = g_get_monotonic_time() - data->emitTimes[g_atomic_int_get(&data->processed)];
+    data->latencySum += latency;
+    data->latencyMax = std::max(data->latencyMax, latency);
+
+    g_atomic_int_inc(&data->processed);
+    return SC_RESULT_OK;
+}
+
+void test_events_dispatch()
+{
+    sc_int32 const element_count = 16;
+    sc_int32 const emit_count = 1 << 14;
+
+    s_default_ctx = sc_memory_initialize(&params);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+
+    g_message("Elements: %d, Events per element: %d", element_count, emit_count);
+
+    std::vector<EventsBenchElement> elements(element_count);
+    std::vector<sc_addr> nodes(element_count);
+    std::vector<sc_event*> events(element_count);
+    for (sc_int32 i = 0; i < element_count; ++i)
+    {
+        elements[i].emitTimes.resize(emit_count);
+        elements[i].processed = 0;
+        elements[i].latencySum = 0;
+        elements[i].latencyMax = 0;
+
+        nodes[i] = sc_memory_node_new(ctx, 0);
+        events[i] = sc_event_new(ctx, nodes[i], SC_EVENT_ADD_OUTPUT_ARC, &elements[i], events_bench_callback, 0);
+        g_assert(events[i] != 0);
+    }
+
+    sc_addr target = sc_memory_node_new(ctx, 0);
+
+    g_test_timer_start();
+    for (sc_int32 j = 0; j < emit_count; ++j)
+    {
+        for (sc_int32 i = 0; i < element_count; ++i)
+        {
+            elements[i].emitTimes[j] = g_get_monotonic_time();
+            sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, nodes[i], target);
+            g_assert(SC_ADDR_IS_NOT_EMPTY(arc));
+        }
+    }
+    double const emit_time = g_test_timer_elapsed();
+
+    // wait until all events will be processed
+    sc_int32 processed = 0;
+    while (processed < element_count * emit_count)
+    {
+        processed = 0;
+        for (sc_int32 i = 0; i < element_count; ++i)
+            processed += g_atomic_int_get(&elements[i].processed);
+        g_usleep(100);
+    }
+    double const total_time = g_test_timer_elapsed();
+
+    gint64 latency_sum = 0, latency_max = 0;
+    for (sc_int32 i = 0; i < element_count; ++i)
+    {
+        latency_sum += elements[i].latencySum;
+        latency_max = std::max(latency_max, elements[i].latencyMax);
+        sc_event_destroy(events[i]);
+    }
+
+    printf("Emit time: %lf, Total time: %lf\n", emit_time, total_time);
+    printf("Events/s: %lf\n", processed / total_time);
+    printf("Latency (us): avg %lf, max %lld\n", (double)latency_sum / processed, (long long)latency_max);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+// ---------------------------
+// creation throughput for different number of threads, each thread creates the same number of elements
+void test_creation_scaling()
+{
+    sc_int32 const count_per_thread = 1 << 15;
+
+    for (sc_int32 thread_count = 1; thread_count <= 64; thread_count *= 2)
+    {
+        s_default_ctx = sc_memory_initialize(&params);
+
+        tGThreadVector threads;
+        threads.reserve(thread_count);
+
+        g_test_timer_start();
+        for (sc_int32 i = 0; i < thread_count; ++i)
+        {
+            GThread * thread = g_thread_try_new(0, create_node_thread, GINT_TO_POINTER(count_per_thread), 0);
+            g_assert(thread != 0);
+            threads.push_back(thread);
+        }
+
+        for (sc_int32 i = 0; i < thread_count; ++i)
+            g_assert(GPOINTER_TO_INT(g_thread_join(threads[i])) == count_per_thread);
+
+        double const time = g_test_timer_elapsed();
+        printf("Threads: %d, Time: %lf, Elements/s: %lf\n", thread_count, time, (thread_count * count_per_thread) / time);
+
+        sc_memory_shutdown(SC_FALSE);
+    }
+}
+
+// ---------------------------
+namespace
+{
+    struct SaveBenchWriter
+    {
+        sc_addr node;
+        gint stop;
+        gint64 latencyMax;
+    };
+}
+
+// changes one sc-element, while segments are saved, and measures the longest change time
+gpointer save_bench_writer_thread(gpointer data)
+{
+    SaveBenchWriter *writer = (SaveBenchWriter*)data;
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+    sc_uint32 i = 0;
+
+    while (g_atomic_int_get(&writer->stop) == 0)
+    {
+        gint64 const start = g_get_monotonic_time();
+        g_assert(sc_memory_change_element_subtype(ctx, writer->node, (++i % 2) ? sc_type_const : sc_type_var) == SC_RESULT_OK);
+        writer->latencyMax = std::max(writer->latencyMax, g_get_monotonic_time() - start);
+        g_usleep(100);
+    }
+
+    sc_memory_context_free(ctx);
+    return 0;
+}
+
+// save latency for different number of changed segments
+void test_save_dirty()
+{
+    sc_uint32 const segments_count = 16;
+
+    s_default_ctx = sc_memory_initialize(&params);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+
+    // first sc-element of each segment, to change it
+    std::vector<sc_addr> nodes(segments_count);
+    std::vector<bool> found(segments_count, false);
+    while (true)
+    {
+        sc_addr const addr = sc_memory_node_new(ctx, 0);
+        g_assert(SC_ADDR_IS_NOT_EMPTY(addr));
+        if (addr.seg >= segments_count)
+            break;
+
+        if (!found[addr.seg])
+        {
+            nodes[addr.seg] = addr;
+            found[addr.seg] = true;
+        }
+    }
+
+    g_test_timer_start();
+    sc_memory_save(ctx);
+    printf("Segments: %u, Full save time: %lf\n", segments_count, g_test_timer_elapsed());
+
+    // writer changes the first segment, so it's always changed
+    for (sc_uint32 dirty = 1; dirty <= segments_count; dirty *= 2)
+    {
+        SaveBenchWriter writer;
+        writer.node = nodes[0];
+        writer.stop = 0;
+        writer.latencyMax = 0;
+
+        for (sc_uint32 i = 1; i < dirty; ++i)
+            g_assert(sc_memory_change_element_subtype(ctx, nodes[i], sc_type_var) == SC_RESULT_OK);
+
+        GThread * thread = g_thread_try_new(0, save_bench_writer_thread, &writer, 0);
+        g_assert(thread != 0);
+
+        g_test_timer_start();
+        g_assert(sc_memory_save(ctx) == SC_RESULT_OK);
+        double const time = g_test_timer_elapsed();
+
+        g_atomic_int_set(&writer.stop, 1);
+        g_thread_join(thread);
+
+        printf("Changed segments: %u/%u, Save time: %lf, Writer max latency (us): %lld\n",
+               dirty, segments_count, time, (long long)writer.latencyMax);
+    }
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
+// ---------------------------
+// changes throughput for each write-ahead log sync policy and replay time of written log
+void test_wal()
+{
+    char const * policies[] = { "none", "interval", "commit" };
+    sc_int32 const count = 1 << 14;
+
+    sc_memory_params p = params;
+    p.config_file = "sc-memory-wal.ini";
+
+    for (sc_uint32 i = 0; i < sizeof(policies) / sizeof(policies[0]); ++i)
+    {
+        FILE *config = fopen(p.config_file, "w");
+        g_assert(config != 0);
+        fprintf(config, "[memory]\nwal = true\nwal_sync = %s\n", policies[i]);
+        fclose(config);
+
+        p.clear = SC_TRUE;
+        s_default_ctx = sc_memory_initialize(&p);
+        g_assert(sc_memory_save(s_default_ctx) == SC_RESULT_OK);
+
+        tGThreadVector threads;
+        threads.reserve(g_thread_count);
+
+        g_test_timer_start();
+        for (sc_int32 j = 0; j < g_thread_count; ++j)
+        {
+            GThread * thread = g_thread_try_new(0, create_arc_thread, GINT_TO_POINTER(count / g_thread_count), 0);
+            g_assert(thread != 0);
+            threads.push_back(thread);
+        }
+
+        for (sc_int32 j = 0; j < g_thread_count; ++j)
+            g_assert(GPOINTER_TO_INT(g_thread_join(threads[j])) == count / g_thread_count);
+
+        // each iteration creates two nodes and one arc
+        double const time = g_test_timer_elapsed();
+        sc_memory_shutdown(SC_FALSE);
+
+        p.clear = SC_FALSE;
+        g_test_timer_start();
+        s_default_ctx = sc_memory_initialize(&p);
+        double const replay_time = g_test_timer_elapsed();
+
+        sc_stat stat;
+        g_assert(sc_memory_stat(s_default_ctx, &stat) == SC_RESULT_OK);
+        g_assert(stat.arc_count >= (sc_uint32)count);
+
+        printf("Sync: %s, Changes/s: %lf, Replay time: %lf, Replayed changes/s: %lf\n",
+               policies[i], 3 * count / time, replay_time, 3 * count / replay_time);
+
+        sc_memory_shutdown(SC_FALSE);
+    }
+
+    remove(p.config_file);
+}
+
+// ---------------------------
+//! Returns resident memory of process in bytes. If it can't be measured, then returns 0
+sc_uint64 get_resident_memory()
+{
+    sc_uint64 result = 0;
+#ifdef __linux__
+    gchar *data = 0;
+    unsigned long long pages_total = 0, pages_resident = 0;
+
+    // return freed memory to system, so measurements don't depend on previous tests
+    malloc_trim(0);
+    if (g_file_get_contents("/proc/self/statm", &data, 0, 0) == TRUE)
+    {
+        if (sscanf(data, "%llu %llu", &pages_total, &pages_resident) == 2)
+            result = (sc_uint64)pages_resident * sysconf(_SC_PAGESIZE);
+        g_free(data);
+    }
+#endif
+    return result;
+}
+
+// memory, that is used for different number of sc-elements
+void test_segments_memory()
+{
+    sc_uint32 const counts[] = { 1000, 10000, 100000, 1000000 };
+
+    for (sc_uint32 i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+        s_default_ctx = sc_memory_initialize(&params);
+        sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+        sc_uint64 const memory_start = get_resident_memory();
+
+        for (sc_uint32 j = 0; j < counts[i]; ++j)
+        {
+            sc_addr const addr = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+            g_assert(SC_ADDR_IS_NOT_EMPTY(addr));
+        }
+
+        sc_stat stat;
+        g_assert(sc_memory_stat(ctx, &stat) == SC_RESULT_OK);
+        sc_uint64 const memory = get_resident_memory() - memory_start;
+
+        // fixed-size segments take memory for all their elements
+        printf("Elements: %u, Segments: %u, Memory (KB): %llu, Bytes per element: %lf, Fixed segments memory (KB): %llu\n",
+               counts[i], stat.segments_count, (unsigned long long)memory / 1024, (double)memory / counts[i],
+               (unsigned long long)stat.segments_count * SC_SEGMENT_ELEMENTS_COUNT * (sizeof(sc_element) + sizeof(sc_element_meta)) / 1024);
+
+        sc_memory_context_free(ctx);
+        sc_memory_shutdown(SC_FALSE);
+    }
+}
+
+// ---------------------------
+//! Opens counter of cache misses for current thread. Returns -1, if perf counters aren't available
+int cache_misses_counter_open()
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+void cache_misses_counter_start(int fd)
+{
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+//! Stops counter and returns number of cache misses. If counter isn't available, then returns -1
+long long cache_misses_counter_stop(int fd)
+{
+    long long result = -1;
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &result, sizeof(result)) != sizeof(result))
+            result = -1;
+    }
+#endif
+    return result;
+}
+
+void cache_misses_counter_close(int fd)
+{
+#ifdef __linux__
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+// walks output arcs of nodes with and without type filters
+void test_iterate_walk()
+{
+    sc_uint32 const NODES_COUNT = 1000;
+    sc_uint32 const DEGREE = 100;
+    sc_uint32 const REPEATS = 10;
+
+    s_default_ctx = sc_memory_initialize(&params);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+
+    std::vector<sc_addr> nodes, targets;
+    for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+    {
+        nodes.push_back(sc_memory_node_new(ctx, sc_type_node | sc_type_const));
+        targets.push_back(sc_memory_node_new(ctx, sc_type_node | ((i % 2) ? sc_type_var : sc_type_const)));
+    }
+
+    // arcs of one node are created interleaved with arcs of other nodes, so they aren't stored sequentially
+    for (sc_uint32 d = 0; d < DEGREE; ++d)
+    {
+        for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+        {
+            sc_type const type = (d % 2) ? sc_type_arc_pos_var_perm : sc_type_arc_pos_const_perm;
+            sc_addr const arc = sc_memory_arc_new(ctx, type, nodes[i], targets[g_random_int_range(0, NODES_COUNT)]);
+            g_assert(SC_ADDR_IS_NOT_EMPTY(arc));
+        }
+    }
+
+    printf("Element size: %zd bytes, sc-link content size: %zd bytes (stored apart from elements)\n", sizeof(sc_element), sizeof(sc_content));
+
+    struct
+    {
+        char const *name;
+        sc_type arc_type;
+        sc_type end_type;
+    } const walks[] = {
+        { "out-degree walk", 0, 0 },
+        { "arc type filter", sc_type_arc_pos_const_perm, 0 },
+        { "arc and end type filter", sc_type_arc_pos_const_perm, sc_type_node | sc_type_var },
+    };
+
+    int const counter = cache_misses_counter_open();
+    for (sc_uint32 w = 0; w < sizeof(walks) / sizeof(walks[0]); ++w)
+    {
+        sc_uint64 found = 0;
+        GTimer *timer = g_timer_new();
+
+        cache_misses_counter_start(counter);
+        for (sc_uint32 r = 0; r < REPEATS; ++r)
+        {
+            for (sc_uint32 i = 0; i < NODES_COUNT; ++i)
+            {
+                sc_iterator3 *it = sc_iterator3_f_a_a_new(ctx, nodes[i], walks[w].arc_type, walks[w].end_type);
+                while (sc_iterator3_next(it) == SC_TRUE)
+                    ++found;
+                sc_iterator3_free(it);
+            }
+        }
+        long long const misses = cache_misses_counter_stop(counter);
+        g_timer_stop(timer);
+
+        sc_uint64 const walked = (sc_uint64)NODES_COUNT * DEGREE * REPEATS;
+        printf("%s: found %llu, time: %lf s, ns per arc: %lf, cache misses per arc: ",
+               walks[w].name, (unsigned long long)found, g_timer_elapsed(timer, 0), g_timer_elapsed(timer, 0) * 1e9 / walked);
+        if (misses >= 0)
+            printf("%lf\n", (double)misses / walked);
+        else
+            printf("n/a\n");
+
+        g_assert(walks[w].arc_type != 0 || found == walked);
+        g_timer_destroy(timer);
+    }
+    cache_misses_counter_close(counter);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
+// ---------------------------
+namespace
+{
+    const sc_uint32 g_iterate_shared_count = 16;
+    const sc_uint32 g_iterate_stable_degree = 256;
+    std::vector<sc_addr> g_iterate_shared_nodes;
+    gint g_iterate_readers_active = 0;
+}
+
+// iterates shared nodes with filters and checks, that just stable sc-arcs are found
+gpointer iterate_concurrent_reader(gpointer data)
+{
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+    int count = GPOINTER_TO_INT(data);
+    int result = count;
+    for (int i = 0; i < count; ++i)
+    {
+        sc_addr const shared = g_iterate_shared_nodes[g_random_int_range(0, g_iterate_shared_count)];
+        sc_uint32 found = 0, stable = 0;
+
+        sc_iterator3 *it = sc_iterator3_f_a_a_new(ctx, shared, sc_type_arc_pos_const_perm, sc_type_node | sc_type_const);
+        while (sc_iterator3_next(it) == SC_TRUE)
+        {
+            sc_type type = 0;
+            ++found;
+            // stable targets are created as structure nodes
+            if (SC_ADDR_IS_EQUAL(sc_iterator3_value(it, 0), shared) &&
+                sc_memory_get_element_type(ctx, sc_iterator3_value(it, 2), &type) == SC_RESULT_OK &&
+                (type & sc_type_node_struct))
+            {
+                ++stable;
+            }
+        }
+        sc_iterator3_free(it);
+
+        if (found != g_iterate_stable_degree || stable != g_iterate_stable_degree)
+        {
+            result = i + 1;
+            break;
+        }
+    }
+
+    g_atomic_int_dec_and_test(&g_iterate_readers_active);
+    sc_memory_context_free(ctx);
+
+    return GINT_TO_POINTER(result);
+}
+
+/* creates, retypes and deletes sc-arcs of shared nodes, while readers iterate them. Sc-arcs don't match
+ * filter of readers, so they are skipped by readers and aren't held by them
+ */
+gpointer iterate_concurrent_writer(gpointer data)
+{
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+    int result = GPOINTER_TO_INT(data);
+    while (g_atomic_int_get(&g_iterate_readers_active) > 0)
+    {
+        sc_addr const shared = g_iterate_shared_nodes[g_random_int_range(0, g_iterate_shared_count)];
+        sc_addr const node = sc_memory_node_new(ctx, sc_type_node | sc_type_var);
+        sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_pos_var_perm, shared, node);
+        sc_addr const arc_shared = sc_memory_arc_new(ctx, sc_type_arc_pos_var_perm, shared, g_iterate_shared_nodes[0]);
+        if (SC_ADDR_IS_EMPTY(arc) || SC_ADDR_IS_EMPTY(arc_shared) ||
+            sc_memory_change_element_subtype(ctx, arc, sc_type_const | sc_type_arc_pos | sc_type_arc_perm) != SC_RESULT_OK ||
+            sc_memory_element_free(ctx, node) != SC_RESULT_OK ||
+            sc_memory_element_free(ctx, arc_shared) != SC_RESULT_OK)
+        {
+            result = 0;
+            break;
+        }
+    }
+
+    sc_memory_context_free(ctx);
+
+    return GINT_TO_POINTER(result);
+}
+
+void test_iterate_concurrent()
+{
+    sc_int32 const reads_count = 1 << 8;
+    s_default_ctx = sc_memory_initialize(&params);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+
+    g_iterate_shared_nodes.resize(g_iterate_shared_count);
+    for (sc_uint32 i = 0; i < g_iterate_shared_count; ++i)
+    {
+        g_iterate_shared_nodes[i] = sc_memory_node_new(ctx, sc_type_node | sc_type_const);
+        for (sc_uint32 j = 0; j < g_iterate_stable_degree; ++j)
+        {
+            sc_addr const target = sc_memory_node_new(ctx, sc_type_node | sc_type_const | sc_type_node_struct);
+            sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, g_iterate_shared_nodes[i], target);
+            g_assert(SC_ADDR_IS_NOT_EMPTY(arc));
+            // arcs, that don't match filter, are skipped by readers
+            g_assert(SC_ADDR_IS_NOT_EMPTY(sc_memory_arc_new(ctx, sc_type_arc_pos_var_perm, g_iterate_shared_nodes[i], target)));
+        }
+    }
+
+    sc_int32 const readers_count = std::max<sc_int32>(1, g_thread_count / 4);
+    sc_int32 const writers_count = readers_count;
+    g_atomic_int_set(&g_iterate_readers_active, readers_count);
+
+    tGThreadVector readers, writers;
+    GTimer *timer = g_timer_new();
+    for (sc_int32 i = 0; i < writers_count; ++i)
+        writers.push_back(g_thread_new(0, iterate_concurrent_writer, GINT_TO_POINTER(1)));
+    for (sc_int32 i = 0; i < readers_count; ++i)
+        readers.push_back(g_thread_new(0, iterate_concurrent_reader, GINT_TO_POINTER(reads_count)));
+
+    for (size_t i = 0; i < readers.size(); ++i)
+        g_assert(GPOINTER_TO_INT(g_thread_join(readers[i])) == reads_count);
+    g_timer_stop(timer);
+    for (size_t i = 0; i < writers.size(); ++i)
+        g_assert(GPOINTER_TO_INT(g_thread_join(writers[i])) == 1);
+
+    printf("Readers: %d, writers: %d, iterations per second: %lf\n", readers_count, writers_count,
+           readers_count * reads_count / g_timer_elapsed(timer, 0));
+    g_timer_destroy(timer);
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
+// ---------------------------
+namespace
+{
+    const sc_int32 g_delete_shared_count = 64;
+    std::vector<sc_addr> g_delete_shared_nodes;
+}
+
+// creates sc-elements connected with shared nodes and deletes them, while other threads do the same
+gpointer delete_create_thread(gpointer data)
+{
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+    int count = GPOINTER_TO_INT(data);
+    int result = count;
+    for (int i = 0; i < count; ++i)
+    {
+        sc_addr node = sc_memory_node_new(ctx, 0);
+        sc_addr const shared_out = g_delete_shared_nodes[g_random_int_range(0, g_delete_shared_count)];
+        sc_addr const shared_in = g_delete_shared_nodes[g_random_int_range(0, g_delete_shared_count)];
+
+        sc_addr const arc_out = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, node, shared_out);
+        sc_addr const arc_in = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, shared_in, node);
+        if (SC_ADDR_IS_EMPTY(arc_out) || SC_ADDR_IS_EMPTY(arc_in))
+        {
+            result = i + 1;
+            break;
+        }
+
+        // arc to arc, so deletion need to collect more than one level of connectors
+        sc_addr const arc_arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, shared_in, arc_out);
+        if (SC_ADDR_IS_EMPTY(arc_arc) || sc_memory_element_free(ctx, node) != SC_RESULT_OK)
+        {
+            result = i + 1;
+            break;
+        }
+    }
+
+    sc_memory_context_free(ctx);
+
+    return GINT_TO_POINTER(result);
+}
+
+void test_delete_create()
+{
+    s_default_ctx = sc_memory_initialize(&params);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+
+    g_delete_shared_nodes.resize(g_delete_shared_count);
+    for (sc_int32 i = 0; i < g_delete_shared_count; ++i)
+        g_delete_shared_nodes[i] = sc_memory_node_new(ctx, 0);
+
+    test_creation(delete_create_thread, 1 << 18, g_thread_count);
+
+    // all connectors of shared nodes should be deleted
+    for (sc_int32 i = 0; i < g_delete_shared_count; ++i)
+    {
+        sc_iterator3 *it = sc_iterator3_f_a_a_new(ctx, g_delete_shared_nodes[i], 0, 0);
+        g_assert(sc_iterator3_next(it) == SC_FALSE);
+        sc_iterator3_free(it);
+
+        it = sc_iterator3_a_a_f_new(ctx, 0, 0, g_delete_shared_nodes[i]);
+        g_assert(sc_iterator3_next(it) == SC_FALSE);
+        sc_iterator3_free(it);
+    }
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
+// ---------------------------
+sc_result events_subscribe_callback(const sc_event *event, sc_addr arg)
+{
+    g_atomic_int_inc((gint*)sc_event_get_data(event));
+    return SC_RESULT_OK;
+}
+
+sc_result events_subscribe_delete_callback(const sc_event *event)
+{
+    // destroys event from delete callback, like wrapper does
+    return sc_event_destroy((sc_event*)event);
+}
+
+// subscribe, emit and unsubscribe events on own elements, while emitting events without subscribers
+gpointer events_subscribe_thread(gpointer data)
+{
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+    int count = GPOINTER_TO_INT(data);
+    int result = count;
+    gint processed = 0;
+
+    sc_addr target = sc_memory_node_new(ctx, 0);
+    for (int i = 0; i < count; ++i)
+    {
+        sc_addr node = sc_memory_node_new(ctx, 0);
+        sc_event *evt_out = sc_event_new(ctx, node, SC_EVENT_ADD_OUTPUT_ARC, &processed, events_subscribe_callback, 0);
+        sc_event *evt_del = sc_event_new(ctx, node, SC_EVENT_REMOVE_ELEMENT, &processed, events_subscribe_callback, events_subscribe_delete_callback);
+        if (evt_out == 0 || evt_del == 0)
+        {
+            result = i + 1;
+            break;
+        }
+
+        // there are no subscriptions on target
+        sc_addr const arc = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, node, target);
+        sc_addr const arc2 = sc_memory_arc_new(ctx, sc_type_arc_pos_const_perm, target, target);
+        if (SC_ADDR_IS_EMPTY(arc) || SC_ADDR_IS_EMPTY(arc2))
+        {
+            result = i + 1;
+            break;
+        }
+
+        sc_event_destroy(evt_out);
+        // evt_del is destroyed by delete callback
+        sc_memory_element_free(ctx, node);
+    }
+
+    sc_memory_context_free(ctx);
+
+    return GINT_TO_POINTER(result);
+}
+
+void test_events_subscribe()
+{
+    s_default_ctx = sc_memory_initialize(&params);
+
+    test_creation(events_subscribe_thread, 1 << 16, g_thread_count);
+
+    sc_memory_shutdown(SC_FALSE);
+}
+
+// ---------------------------
+gint g_events_destroy_state = 0;
+
+sc_result events_destroy_delete_callback(const sc_event *event)
+{
+    // let another thread destroy event, while callback still uses it
+    g_atomic_int_set(&g_events_destroy_state, 1);
+    g_usleep(50000);
+    g_atomic_int_inc((gint*)sc_event_get_data(event));
+    g_atomic_int_set(&g_events_destroy_state, 2);
+    return SC_RESULT_OK;
+}
+
+gpointer events_destroy_thread(gpointer data)
+{
+    while (g_atomic_int_get(&g_events_destroy_state) == 0)
+        g_thread_yield();
+
+    sc_result const result = sc_event_destroy((sc_event*)data);
+    // destroy should return after delete callback
+    g_assert(g_atomic_int_get(&g_events_destroy_state) == 2);
+
+    return GINT_TO_POINTER(result);
+}
+
+void test_events_destroy_deleted()
+{
+    s_default_ctx = sc_memory_initialize(&params);
+    sc_memory_context *ctx = sc_memory_context_new(sc_access_lvl_make(8, 8));
+
+    for (int i = 0; i < 8; ++i)
+    {
+        gint calls = 0;
+        g_atomic_int_set(&g_events_destroy_state, 0);
+
+        sc_addr node = sc_memory_node_new(ctx, 0);
+        sc_event *evt = sc_event_new(ctx, node, SC_EVENT_ADD_OUTPUT_ARC, &calls, events_subscribe_callback, events_destroy_delete_callback);
+        g_assert(evt != 0);
+
+        GThread *thread = g_thread_new(0, events_destroy_thread, evt);
+        g_assert(sc_memory_element_free(ctx, node) == SC_RESULT_OK);
+        g_assert(GPOINTER_TO_INT(g_thread_join(thread)) == SC_RESULT_OK);
+        g_assert(calls == 1);
+    }
+
+    sc_memory_context_free(ctx);
+    sc_memory_shutdown(SC_FALSE);
+}
+
 // ---------------------------
 int main(int argc, char *argv[])
 {
@@ -254,6 +1012,16 @@ int main(int argc, char *argv[])
     g_test_add_func("/threading/create_arcs", test_arc_creation);
     g_test_add_func("/threading/create_links", test_link_creation);
     g_test_add_func("/threading/create_combined", test_combined_creation);
+    g_test_add_func("/threading/create_scaling", test_creation_scaling);
+    g_test_add_func("/threading/save_dirty", test_save_dirty);
+    g_test_add_func("/threading/wal", test_wal);
+    g_test_add_func("/threading/segments_memory", test_segments_memory);
+    g_test_add_func("/threading/iterate_walk", test_iterate_walk);
+    g_test_add_func("/threading/iterate_concurrent", test_iterate_concurrent);
+    g_test_add_func("/threading/delete_create", test_delete_create);
+    g_test_add_func("/threading/events_dispatch", test_events_dispatch);
+    g_test_add_func("/threading/events_subscribe", test_events_subscribe);
+    g_test_add_func("/threading/events_destroy_deleted", test_events_destroy_deleted);
     g_test_run();
 
 
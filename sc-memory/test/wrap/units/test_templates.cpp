@@ -605,6 +605,382 @@ UNIT_TEST(template_search_in_struct)
 	}
 }
 
+UNIT_TEST(template_search_plan)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_min);
+
+	/* Class with many members, a few of them have relation with values:
+	 * concept _-> _x;; _x => nrel: _y;;
+	 */
+	static size_t const membersCount = 1000;
+	static size_t const relationsCount = 10;
+
+	uint64_t const norolesCount = ctx.getTypeCardinality(sc_type_node_norole | sc_type_const);
+	ScAddr const conceptAddr = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const nrelAddr = ctx.createNode(sc_type_node_norole | sc_type_const);
+	tAddrVector members;
+	for (size_t i = 0; i < membersCount; ++i)
+	{
+		members.push_back(ctx.createNode(sc_type_node | sc_type_const));
+		SC_CHECK(ctx.createEdge(sc_type_arc_pos_const_perm, conceptAddr, members.back()).isValid(), ());
+	}
+	for (size_t i = 0; i < relationsCount; ++i)
+	{
+		ScAddr const valueAddr = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const edgeAddr = ctx.createEdge(sc_type_arc_common | sc_type_const, members[i * 7], valueAddr);
+		SC_CHECK(ctx.createEdge(sc_type_arc_pos_const_perm, nrelAddr, edgeAddr).isValid(), ());
+	}
+
+	SUBTEST_START(statistics)
+	{
+		uint32_t outDegree = 0, inDegree = 0;
+		SC_CHECK(ctx.getElementDegree(conceptAddr, outDegree, inDegree), ());
+		SC_CHECK_EQUAL(outDegree, membersCount, ());
+		SC_CHECK_EQUAL(inDegree, 0, ());
+		SC_CHECK(ctx.getElementDegree(members[7], outDegree, inDegree), ());
+		SC_CHECK_EQUAL(outDegree, 1, ());
+		SC_CHECK_EQUAL(inDegree, 1, ());
+
+		SC_CHECK_EQUAL(ctx.getTypeCardinality(sc_type_node_norole | sc_type_const), norolesCount + 1, ());
+		SC_CHECK(ctx.getTypeCardinality(sc_type_arc_pos_const_perm) >= membersCount + relationsCount, ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(plans_empty)
+	{
+		ScTemplate templ;
+		templ
+			(conceptAddr,
+			ScType::EDGE_ACCESS_VAR_POS_PERM,
+			ScType::NODE_VAR >> "_x")
+			(ScType::NODE_VAR >> "_y",
+			ScType::EDGE_DCOMMON_VAR >> "_edge",
+			"_x")
+			(nrelAddr,
+			ScType::EDGE_ACCESS_VAR_POS_PERM,
+			"_edge");
+
+		// values of relation are targets of edges, so there are no results with any plan
+		templ.setSearchPlan(ScTemplateSearchPlan::Static);
+		SC_CHECK(templ.getSearchPlan() == ScTemplateSearchPlan::Static, ());
+		ScTemplateSearchResult staticResult;
+		SC_CHECK_NOT(ctx.helperSearchTemplate(templ, staticResult), ());
+
+		templ.setSearchPlan(ScTemplateSearchPlan::CostBased);
+		ScTemplateSearchResult costResult;
+		SC_CHECK_NOT(ctx.helperSearchTemplate(templ, costResult), ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(plans_results)
+	{
+		ScTemplate templ;
+		templ
+			(conceptAddr,
+			ScType::EDGE_ACCESS_VAR_POS_PERM,
+			ScType::NODE_VAR >> "_x")
+			("_x",
+			ScType::EDGE_DCOMMON_VAR >> "_edge",
+			ScType::NODE_VAR >> "_y")
+			(nrelAddr,
+			ScType::EDGE_ACCESS_VAR_POS_PERM,
+			"_edge");
+
+		ScTemplateSearchResult results[2];
+		templ.setSearchPlan(ScTemplateSearchPlan::Static);
+		SC_CHECK(ctx.helperSearchTemplate(templ, results[0]), ());
+		templ.setSearchPlan(ScTemplateSearchPlan::CostBased);
+		SC_CHECK(ctx.helperSearchTemplate(templ, results[1]), ());
+
+		for (ScTemplateSearchResult const & result : results)
+		{
+			SC_CHECK_EQUAL(result.getSize(), relationsCount, ());
+
+			std::set<ScAddr, ScAddLessFunc> found;
+			for (size_t i = 0; i < result.getSize(); ++i)
+			{
+				ScTemplateSearchResultItem const item = result[i];
+				SC_CHECK_EQUAL(ctx.getEdgeSource(item["_edge"]), item["_x"], ());
+				SC_CHECK_EQUAL(ctx.getEdgeTarget(item["_edge"]), item["_y"], ());
+				found.insert(item["_x"]);
+			}
+
+			SC_CHECK_EQUAL(found.size(), relationsCount, ());
+			for (size_t i = 0; i < relationsCount; ++i)
+				SC_CHECK(found.find(members[i * 7]) != found.end(), ());
+		}
+	}
+	SUBTEST_END
+}
+
+UNIT_TEST(template_search_stream)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_min);
+
+	// concept _-> _x;; a half of members are in struct
+	static size_t const membersCount = 50;
+
+	ScAddr const conceptAddr = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const structAddr = ctx.createNode(sc_type_node_struct | sc_type_const);
+	ScStruct testStruct(&ctx, structAddr);
+	testStruct << conceptAddr;
+
+	std::set<ScAddr, ScAddLessFunc> members;
+	for (size_t i = 0; i < membersCount; ++i)
+	{
+		ScAddr const memberAddr = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const edgeAddr = ctx.createEdge(sc_type_arc_pos_const_perm, conceptAddr, memberAddr);
+		SC_CHECK(edgeAddr.isValid(), ());
+		members.insert(memberAddr);
+		if (i % 2 == 0)
+			testStruct << memberAddr << edgeAddr;
+	}
+
+	ScTemplate templ;
+	templ
+		(conceptAddr,
+		ScType::EDGE_ACCESS_VAR_POS_PERM,
+		ScType::NODE_VAR >> "_x");
+
+	// concept has no common edges
+	ScTemplate emptyTempl;
+	emptyTempl
+		(conceptAddr,
+		ScType::EDGE_DCOMMON_VAR,
+		ScType::NODE_VAR >> "_x");
+
+	SUBTEST_START(for_each)
+	{
+		std::set<ScAddr, ScAddLessFunc> found;
+		size_t const count = ctx.helperSearchTemplateForEach(templ, [&found](ScTemplateSearchResultItem const & item) {
+			found.insert(item["_x"]);
+			return ScTemplateSearchRequest::Continue;
+		});
+
+		SC_CHECK_EQUAL(count, membersCount, ());
+		SC_CHECK(found == members, ());
+
+		size_t const structCount = ctx.helperSearchTemplateInStructForEach(templ, structAddr, [](ScTemplateSearchResultItem const &) {
+			return ScTemplateSearchRequest::Continue;
+		});
+		SC_CHECK_EQUAL(structCount, membersCount / 2, ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(stop_and_limit)
+	{
+		size_t called = 0;
+		size_t const count = ctx.helperSearchTemplateForEach(templ, [&called](ScTemplateSearchResultItem const &) {
+			return (++called == 3) ? ScTemplateSearchRequest::Stop : ScTemplateSearchRequest::Continue;
+		});
+		SC_CHECK_EQUAL(count, 3, ());
+		SC_CHECK_EQUAL(called, 3, ());
+
+		called = 0;
+		SC_CHECK_EQUAL(ctx.helperSearchTemplateForEach(templ, [&called](ScTemplateSearchResultItem const &) {
+			++called;
+			return ScTemplateSearchRequest::Continue;
+		}, 5), 5, ());
+		SC_CHECK_EQUAL(called, 5, ());
+
+		ScTemplateSearchResult result;
+		SC_CHECK(ctx.helperSearchTemplate(templ, result, 4), ());
+		SC_CHECK_EQUAL(result.getSize(), 4, ());
+		for (size_t i = 0; i < result.getSize(); ++i)
+			SC_CHECK(members.find(result[i]["_x"]) != members.end(), ());
+
+		SC_CHECK(ctx.helperSearchTemplateInStruct(templ, structAddr, result, 2), ());
+		SC_CHECK_EQUAL(result.getSize(), 2, ());
+
+		SC_CHECK(ctx.helperSearchTemplate(templ, result, membersCount * 2), ());
+		SC_CHECK_EQUAL(result.getSize(), membersCount, ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(exists)
+	{
+		SC_CHECK(ctx.helperSearchTemplateExists(templ), ());
+		SC_CHECK_NOT(ctx.helperSearchTemplateExists(emptyTempl), ());
+		SC_CHECK_EQUAL(ctx.helperSearchTemplateForEach(emptyTempl, [](ScTemplateSearchResultItem const &) {
+			return ScTemplateSearchRequest::Continue;
+		}), 0, ());
+	}
+	SUBTEST_END
+}
+
+UNIT_TEST(template_search_parallel)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_min);
+
+	/* Instances of class, each of them is checked by relation and class of value:
+	 * concept _-> _x;; _x => nrel: _v;; concept_value _-> _v;;
+	 * Just each third instance has value in class
+	 */
+	static size_t const instancesCount = 300;
+
+	ScAddr const conceptAddr = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const valueConceptAddr = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const nrelAddr = ctx.createNode(sc_type_node_norole | sc_type_const);
+	for (size_t i = 0; i < instancesCount; ++i)
+	{
+		ScAddr const instanceAddr = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const valueAddr = ctx.createNode(sc_type_node | sc_type_const);
+		ScAddr const edgeAddr = ctx.createEdge(sc_type_arc_common | sc_type_const, instanceAddr, valueAddr);
+		SC_CHECK(ctx.createEdge(sc_type_arc_pos_const_perm, conceptAddr, instanceAddr).isValid(), ());
+		SC_CHECK(ctx.createEdge(sc_type_arc_pos_const_perm, nrelAddr, edgeAddr).isValid(), ());
+		if (i % 3 == 0)
+			SC_CHECK(ctx.createEdge(sc_type_arc_pos_const_perm, valueConceptAddr, valueAddr).isValid(), ());
+	}
+
+	ScTemplate templ;
+	templ
+		(conceptAddr,
+		ScType::EDGE_ACCESS_VAR_POS_PERM,
+		ScType::NODE_VAR >> "_x")
+		("_x",
+		ScType::EDGE_DCOMMON_VAR >> "_edge",
+		ScType::NODE_VAR >> "_v")
+		(nrelAddr,
+		ScType::EDGE_ACCESS_VAR_POS_PERM,
+		"_edge")
+		(valueConceptAddr,
+		ScType::EDGE_ACCESS_VAR_POS_PERM,
+		"_v");
+
+	ScTemplateSearchResult expected;
+	SC_CHECK(ctx.helperSearchTemplate(templ, expected), ());
+	SC_CHECK_EQUAL(expected.getSize(), instancesCount / 3, ());
+
+	SUBTEST_START(workers)
+	{
+		size_t const workersCounts[] = { 0, 1, 2, 4, 16 };
+		for (size_t const workersCount : workersCounts)
+		{
+			ScTemplateSearchResult result;
+			SC_CHECK(ctx.helperSearchTemplateParallel(templ, result, ScTemplateParallelParams(workersCount)), ());
+
+			// results are merged in order of sequential search
+			SC_CHECK_EQUAL(result.getSize(), expected.getSize(), ());
+			for (size_t i = 0; i < result.getSize(); ++i)
+			{
+				SC_CHECK_EQUAL(result[i]["_x"], expected[i]["_x"], ());
+				SC_CHECK_EQUAL(result[i]["_edge"], expected[i]["_edge"], ());
+				SC_CHECK_EQUAL(result[i]["_v"], expected[i]["_v"], ());
+			}
+		}
+	}
+	SUBTEST_END
+
+	SUBTEST_START(limit)
+	{
+		std::set<ScAddr, ScAddLessFunc> expectedInstances;
+		for (size_t i = 0; i < expected.getSize(); ++i)
+			expectedInstances.insert(expected[i]["_x"]);
+
+		ScTemplateSearchResult result;
+		SC_CHECK(ctx.helperSearchTemplateParallel(templ, result, ScTemplateParallelParams(4).setResultsLimit(7)), ());
+		SC_CHECK_EQUAL(result.getSize(), 7, ());
+		for (size_t i = 0; i < result.getSize(); ++i)
+			SC_CHECK(expectedInstances.find(result[i]["_x"]) != expectedInstances.end(), ());
+
+		SC_CHECK(ctx.helperSearchTemplateParallel(templ, result, ScTemplateParallelParams(4).setResultsLimit(instancesCount)), ());
+		SC_CHECK_EQUAL(result.getSize(), expected.getSize(), ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(cancel)
+	{
+		ScTemplateSearchCancellation cancellation;
+		cancellation.cancel();
+		SC_CHECK(cancellation.isCancelled(), ());
+
+		ScTemplateSearchResult result;
+		SC_CHECK_NOT(ctx.helperSearchTemplateParallel(templ, result, ScTemplateParallelParams(4).setCancellation(&cancellation)), ());
+		SC_CHECK_EQUAL(result.getSize(), 0, ());
+
+		cancellation.reset();
+		SC_CHECK(ctx.helperSearchTemplateParallel(templ, result, ScTemplateParallelParams(4).setCancellation(&cancellation)), ());
+		SC_CHECK_EQUAL(result.getSize(), expected.getSize(), ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(empty)
+	{
+		ScTemplate emptyTempl;
+		emptyTempl
+			(valueConceptAddr,
+			ScType::EDGE_ACCESS_VAR_POS_PERM,
+			ScType::NODE_VAR >> "_v")
+			("_v",
+			ScType::EDGE_DCOMMON_VAR,
+			ScType::NODE_VAR);
+
+		// values have no output edges
+		ScTemplateSearchResult result;
+		SC_CHECK_NOT(ctx.helperSearchTemplateParallel(emptyTempl, result, ScTemplateParallelParams(4)), ());
+		SC_CHECK_EQUAL(result.getSize(), 0, ());
+	}
+	SUBTEST_END
+}
+
+UNIT_TEST(template_gen_batch)
+{
+	ScMemoryContext ctx(sc_access_lvl_make_min);
+
+	ScAddr const conceptAddr = ctx.createNode(sc_type_node_class | sc_type_const);
+	ScAddr const nrelAddr = ctx.createNode(sc_type_node_norole | sc_type_const);
+
+	// concept _-> _x;; _x => nrel: _y;;
+	ScTemplate templ;
+	templ
+		(conceptAddr, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+		("_x", ScType::EDGE_DCOMMON_VAR >> "_edge", ScType::NODE_VAR >> "_y")
+		(nrelAddr, ScType::EDGE_ACCESS_VAR_POS_PERM, "_edge");
+
+	SUBTEST_START(generate)
+	{
+		ScTemplateGenResult genResult;
+		SC_CHECK(ctx.helperGenTemplate(templ, genResult), ());
+
+		ScAddr begin, end;
+		SC_CHECK(ctx.getEdgeInfo(genResult["_edge"], begin, end), ());
+		SC_CHECK_EQUAL(begin, genResult["_x"], ());
+		SC_CHECK_EQUAL(end, genResult["_y"], ());
+
+		ScTemplateSearchResult searchResult;
+		SC_CHECK(ctx.helperSearchTemplate(templ, searchResult), ());
+		SC_CHECK_EQUAL(searchResult.getSize(), 1, ());
+		SC_CHECK_EQUAL(searchResult[0]["_x"], genResult["_x"], ());
+		SC_CHECK_EQUAL(searchResult[0]["_edge"], genResult["_edge"], ());
+	}
+	SUBTEST_END
+
+	SUBTEST_START(atomic)
+	{
+		uint32_t outDegree = 0, inDegree = 0;
+		SC_CHECK(ctx.getElementDegree(conceptAddr, outDegree, inDegree), ());
+
+		// the last triple refers to removed element, so none of elements is created
+		ScAddr const removedAddr = ctx.createNode(sc_type_node | sc_type_const);
+		SC_CHECK(ctx.eraseElement(removedAddr), ());
+
+		ScTemplate invalidTempl;
+		invalidTempl
+			(conceptAddr, ScType::EDGE_ACCESS_VAR_POS_PERM, ScType::NODE_VAR >> "_x")
+			(removedAddr, ScType::EDGE_ACCESS_VAR_POS_PERM, "_x");
+
+		ScTemplateGenResult genResult;
+		ScTemplateResultCode resultCode = ScTemplateResultCode::Success;
+		SC_CHECK(!ctx.helperGenTemplate(invalidTempl, genResult, ScTemplateGenParams::Empty, &resultCode), ());
+		SC_CHECK(resultCode == ScTemplateResultCode::InternalError, ());
+
+		uint32_t newOutDegree = 0;
+		SC_CHECK(ctx.getElementDegree(conceptAddr, newOutDegree, inDegree), ());
+		SC_CHECK_EQUAL(newOutDegree, outDegree, ());
+	}
+	SUBTEST_END
+}
+
 UNIT_TEST(template_performance)
 {
 	ScAddr node1, node2, node3, node4, edge1, edge2, edge3;
@@ -9,6 +9,7 @@
 #include "sc_stream.hpp"
 #include <assert.h>
 
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -146,8 +147,43 @@ bool ScMemory::hasMemoryContext(ScMemoryContext const * ctx)
 
 // ---------------
 
+size_t ScElementsBatch::appendNode(sc_type type)
+{
+	sc_element_spec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.type = type;
+	spec.begin_index = spec.end_index = SC_ELEMENT_SPEC_NO_INDEX;
+	mSpecs.push_back(spec);
+	return mSpecs.size() - 1;
+}
+
+size_t ScElementsBatch::appendLink()
+{
+	return appendNode(sc_type_link);
+}
+
+size_t ScElementsBatch::appendEdge(sc_type type, Item const & begin, Item const & end)
+{
+	check_expr(type & sc_type_arc_mask);
+	check_expr(begin.mIndex == SC_ELEMENT_SPEC_NO_INDEX || begin.mIndex < mSpecs.size());
+	check_expr(end.mIndex == SC_ELEMENT_SPEC_NO_INDEX || end.mIndex < mSpecs.size());
+
+	sc_element_spec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.type = type;
+	spec.begin = *begin.mAddr;
+	spec.end = *end.mAddr;
+	spec.begin_index = begin.mIndex;
+	spec.end_index = end.mIndex;
+	mSpecs.push_back(spec);
+	return mSpecs.size() - 1;
+}
+
+// ---------------
+
 ScMemoryContext::ScMemoryContext(sc_uint8 accessLevels /* = 0 */, std::string const & name /* = "" */)
     : mContext(0)
+    , mAccessLevels(accessLevels)
 {
     mContext = sc_memory_context_new(accessLevels);
     if (name.empty())
@@ -218,6 +254,26 @@ ScAddr ScMemoryContext::createEdge(sc_type type, ScAddr const & addrBeg, ScAddr
 	return ScAddr(sc_memory_arc_new(mContext, type, addrBeg.mRealAddr, addrEnd.mRealAddr));
 }
 
+bool ScMemoryContext::createElements(ScElementsBatch const & batch, tAddrVector & result)
+{
+	check_expr(isValid());
+	result.resize(batch.size());
+	if (batch.empty())
+		return true;
+
+	std::vector<sc_addr> addrs(batch.size());
+	if (sc_memory_elements_new(mContext, &batch.mSpecs[0], (sc_uint32)batch.size(), &addrs[0]) != SC_RESULT_OK)
+	{
+		result.clear();
+		return false;
+	}
+
+	for (size_t i = 0; i < addrs.size(); ++i)
+		result[i].mRealAddr = addrs[i];
+
+	return true;
+}
+
 ScType ScMemoryContext::getElementType(ScAddr const & addr) const
 {
     check_expr(isValid());
@@ -231,6 +287,24 @@ bool ScMemoryContext::setElementSubtype(ScAddr const & addr, sc_type subtype)
     return sc_memory_change_element_subtype(mContext, addr.mRealAddr, subtype) == SC_RESULT_OK;
 }
 
+bool ScMemoryContext::getElementDegree(ScAddr const & addr, uint32_t & outDegree, uint32_t & inDegree) const
+{
+    check_expr(isValid());
+    sc_uint32 out = 0, in = 0;
+    if (sc_memory_get_element_degree(mContext, addr.mRealAddr, &out, &in) != SC_RESULT_OK)
+        return false;
+
+    outDegree = out;
+    inDegree = in;
+    return true;
+}
+
+uint64_t ScMemoryContext::getTypeCardinality(sc_type type) const
+{
+    check_expr(isValid());
+    return sc_memory_get_type_cardinality(mContext, type);
+}
+
 ScAddr ScMemoryContext::getEdgeSource(ScAddr const & edgeAddr) const
 {
 	check_expr(isValid());
@@ -383,14 +457,36 @@ bool ScMemoryContext::helperGenTemplate(ScTemplate const & templ, ScTemplateGenR
 	return templ.generate(*this, result, params, resultCode);
 }
 
-bool ScMemoryContext::helperSearchTemplate(ScTemplate const & templ, ScTemplateSearchResult & result)
+bool ScMemoryContext::helperSearchTemplate(ScTemplate const & templ, ScTemplateSearchResult & result, size_t limit)
+{
+    return templ.search(*this, result, limit);
+}
+
+bool ScMemoryContext::helperSearchTemplateInStruct(ScTemplate const & templ, ScAddr const & scStruct, ScTemplateSearchResult & result, size_t limit)
+{
+	return templ.searchInStruct(*this, scStruct, result, limit);
+}
+
+size_t ScMemoryContext::helperSearchTemplateForEach(ScTemplate const & templ, ScTemplateSearchCallback const & callback, size_t limit)
+{
+	return templ.searchForEach(*this, ScAddr(), callback, limit);
+}
+
+size_t ScMemoryContext::helperSearchTemplateInStructForEach(ScTemplate const & templ, ScAddr const & scStruct, ScTemplateSearchCallback const & callback, size_t limit)
+{
+	return templ.searchForEach(*this, scStruct, callback, limit);
+}
+
+bool ScMemoryContext::helperSearchTemplateExists(ScTemplate const & templ)
 {
-    return templ.search(*this, result);
+	return (templ.searchForEach(*this, ScAddr(), [](ScTemplateSearchResultItem const &) {
+		return ScTemplateSearchRequest::Stop;
+	}, 1) > 0);
 }
 
-bool ScMemoryContext::helperSearchTemplateInStruct(ScTemplate const & templ, ScAddr const & scStruct, ScTemplateSearchResult & result)
+bool ScMemoryContext::helperSearchTemplateParallel(ScTemplate const & templ, ScTemplateSearchResult & result, ScTemplateParallelParams const & params)
 {
-	return templ.searchInStruct(*this, scStruct, result);
+	return templ.searchParallel(*this, params, result);
 }
 
 bool ScMemoryContext::helperBuildTemplate(ScTemplate & templ, ScAddr const & templAddr)
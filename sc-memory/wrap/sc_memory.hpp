@@ -20,6 +20,7 @@ extern "C"
 
 #include <list>
 #include <string>
+#include <vector>
 
 class ScMemoryContext;
 class ScStream;
@@ -52,6 +53,46 @@ private:
     static tMemoryContextList msContexts;
 };
 
+/* Batch of new sc-elements, that are created by ScMemoryContext::createElements at once (see sc_memory_elements_new).
+ * Elements are referenced by their indices in batch, so edge can connect elements of the same batch.
+ */
+class ScElementsBatch
+{
+	friend class ScMemoryContext;
+
+public:
+	//! Begin or end of edge: existing sc-element or previous element of the same batch
+	class Item
+	{
+		friend class ScElementsBatch;
+
+	public:
+		Item(ScAddr const & addr) : mAddr(addr), mIndex(SC_ELEMENT_SPEC_NO_INDEX) {}
+		Item(size_t index) : mIndex((sc_uint32)index) {}
+
+		bool isIndex() const { return mIndex != SC_ELEMENT_SPEC_NO_INDEX; }
+		size_t getIndex() const { return mIndex; }
+		ScAddr const & getAddr() const { return mAddr; }
+
+	private:
+		ScAddr mAddr;
+		sc_uint32 mIndex;
+	};
+
+	//! Appends element to batch and returns its index
+	_SC_EXTERN size_t appendNode(sc_type type);
+	_SC_EXTERN size_t appendLink();
+	_SC_EXTERN size_t appendEdge(sc_type type, Item const & begin, Item const & end);
+
+	size_t size() const { return mSpecs.size(); }
+	bool empty() const { return mSpecs.empty(); }
+	void clear() { mSpecs.clear(); }
+	void reserve(size_t count) { mSpecs.reserve(count); }
+
+private:
+	std::vector<sc_element_spec> mSpecs;
+};
+
 //! Class used to work with memory. It provides functions to create/erase elements
 class ScMemoryContext
 {
@@ -66,6 +107,7 @@ public:
     _SC_EXTERN void destroy();
 
     std::string const & getName() const { return mName; }
+    sc_uint8 getAccessLevels() const { return mAccessLevels; }
 
     _SC_EXTERN bool isValid() const;
 
@@ -82,6 +124,11 @@ public:
 
 	_SC_EXTERN ScAddr createEdge(sc_type type, ScAddr const & addrBeg, ScAddr const & addrEnd);
 
+	/*! Creates all elements of \p batch at once. Addrs of created elements are stored into \p result in order of batch.
+	 * Returns true, if elements created; otherwise nothing is created and returns false
+	 */
+	_SC_EXTERN bool createElements(ScElementsBatch const & batch, tAddrVector & result);
+
     //! Returns type of sc-element. If there are any error, then returns 0
 	_SC_EXTERN ScType getElementType(ScAddr const & addr) const;
 
@@ -90,6 +137,13 @@ public:
      */
 	_SC_EXTERN bool setElementSubtype(ScAddr const & addr, sc_type subtype);
 
+    /*! Returns number of output and input edges of sc-element in \p outDegree and \p inDegree.
+     * Degrees are estimates, because they can be changed concurrently. Return false, if element doesn't exist
+     */
+	_SC_EXTERN bool getElementDegree(ScAddr const & addr, uint32_t & outDegree, uint32_t & inDegree) const;
+    //! Returns estimated number of sc-elements, which type contains all bits of \p type
+	_SC_EXTERN uint64_t getTypeCardinality(sc_type type) const;
+
 	_SC_EXTERN ScAddr getEdgeSource(ScAddr const & edgeAddr) const;
 	_SC_EXTERN ScAddr getEdgeTarget(ScAddr const & edgeAddr) const;
 	_SC_EXTERN bool getEdgeInfo(ScAddr const & edgeAddr, ScAddr & outSourceAddr, ScAddr & outTargetAddr) const;
@@ -133,8 +187,21 @@ public:
 	_SC_EXTERN bool helperCheckArc(ScAddr const & begin, ScAddr end, sc_type arcType);
 	_SC_EXTERN bool helperFindBySystemIdtf(std::string const & sysIdtf, ScAddr & outAddr);
 	_SC_EXTERN bool helperGenTemplate(ScTemplate const & templ, ScTemplateGenResult & result, ScTemplateGenParams const & params = ScTemplateGenParams::Empty, ScTemplateResultCode * resultCode = nullptr);
-    _SC_EXTERN bool helperSearchTemplate(ScTemplate const & templ, ScTemplateSearchResult & result);
-	_SC_EXTERN bool helperSearchTemplateInStruct(ScTemplate const & templ, ScAddr const & scStruct, ScTemplateSearchResult & result);
+    //! Search stops, when \p limit results found. 0 means no limit
+    _SC_EXTERN bool helperSearchTemplate(ScTemplate const & templ, ScTemplateSearchResult & result, size_t limit = 0);
+	_SC_EXTERN bool helperSearchTemplateInStruct(ScTemplate const & templ, ScAddr const & scStruct, ScTemplateSearchResult & result, size_t limit = 0);
+	/*! Passes each found result into \p callback without storing of results. Search stops, when callback returns
+	 * ScTemplateSearchRequest::Stop or \p limit results found (0 means no limit). Returns number of results passed into callback
+	 */
+	_SC_EXTERN size_t helperSearchTemplateForEach(ScTemplate const & templ, ScTemplateSearchCallback const & callback, size_t limit = 0);
+	_SC_EXTERN size_t helperSearchTemplateInStructForEach(ScTemplate const & templ, ScAddr const & scStruct, ScTemplateSearchCallback const & callback, size_t limit = 0);
+	//! Returns true, if template has any result. Search stops on the first result
+	_SC_EXTERN bool helperSearchTemplateExists(ScTemplate const & templ);
+	/*! Searches template by workers, that process results of the first triple in parallel. Workers use own memory contexts
+	 * with access levels of this context. Results are in the same order as in helperSearchTemplate, if search wasn't
+	 * stopped by limit or cancellation
+	 */
+	_SC_EXTERN bool helperSearchTemplateParallel(ScTemplate const & templ, ScTemplateSearchResult & result, ScTemplateParallelParams const & params = ScTemplateParallelParams());
 	_SC_EXTERN bool helperBuildTemplate(ScTemplate & templ, ScAddr const & templAddr);
 
 private:
@@ -145,6 +212,7 @@ private:
 private:
     sc_memory_context * mContext;
     std::string mName;
+    sc_uint8 mAccessLevels;
 };
 
 
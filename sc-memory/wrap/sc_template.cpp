@@ -10,7 +10,8 @@
 #include <algorithm>
 
 ScTemplate::ScTemplate(size_t BufferedNum)
-	: mIsCacheValid(false)
+	: mSearchPlan(ScTemplateSearchPlan::CostBased)
+	, mIsCacheValid(false)
 {
 	mConstructions.reserve(BufferedNum);
 	mCurrentReplPos = 0;
@@ -36,6 +37,16 @@ void ScTemplate::clear()
 	mIsCacheValid = false;
 }
 
+void ScTemplate::setSearchPlan(ScTemplateSearchPlan plan)
+{
+	mSearchPlan = plan;
+}
+
+ScTemplateSearchPlan ScTemplate::getSearchPlan() const
+{
+	return mSearchPlan;
+}
+
 bool ScTemplate::isSearchCacheValid() const
 {
 	return (mIsCacheValid && (mSearchCachedOrder.size() == mConstructions.size()));
@@ -46,6 +57,74 @@ bool ScTemplate::isGenerateCacheValid() const
 	return (mIsCacheValid && (mGenerateCachedOrder.size() == mConstructions.size()));
 }
 
+void ScTemplate::compile() const
+{
+	if (isSearchCacheValid() && (mCompiledConstructions.size() == mConstructions.size()))
+		return;
+
+	mCompiledConstructions.resize(mConstructions.size());
+	for (size_t i = 0; i < mConstructions.size(); ++i)
+	{
+		ScTemplateItemValue const * values = mConstructions[i].getValues();
+		for (size_t j = 0; j < 3; ++j)
+		{
+			ScTemplateItemValue const & value = values[j];
+			ScTemplateCompiledValue & compiled = mCompiledConstructions[i].mValues[j];
+
+			compiled.mItemType = value.mItemType;
+			compiled.mConstType = value.mTypeValue.upConstType();
+			compiled.mAddr = value.mAddrValue;
+			compiled.mSlot = ScTemplateCompiledValue::NoSlot;
+			if (!value.mReplacementName.empty())
+			{
+				tReplacementsMap::const_iterator const it = mReplacements.find(value.mReplacementName);
+				if (it != mReplacements.end())
+					compiled.mSlot = it->second;
+			}
+		}
+	}
+
+	tProcessOrder & order = mSearchCachedOrder;
+	order.resize(mConstructions.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	/* Main idea of this stage, to build an order where iterators with maximum number of 
+	 * fixed elements will runs first. This allow to minimize number of iterations. Also we can't 
+	 * start search from template a_a_a, or any template where all fixed elements are remplacements
+	 */
+	tTemplateConstr3Vector const & triples = mConstructions;
+	std::sort(order.begin(), order.end(), [&triples](size_t a, size_t b) {
+		ScTemplateConstr3 const & aTriple = triples[a];
+		ScTemplateConstr3 const & bTriple = triples[b];
+
+		// compare by addrs arguments count
+		size_t const aAddrCount = aTriple.countAddrs();
+		size_t const bAddrCount = bTriple.countAddrs();
+
+		if (aAddrCount != bAddrCount)
+			return (aAddrCount > bAddrCount);
+
+		// compare by fixed arguments count
+		size_t const aFCount = aTriple.countFixed();
+		size_t const bFCount = bTriple.countFixed();
+
+		if (aFCount != bFCount)
+			return (aFCount > bFCount);
+
+		// compare by replacements count
+		size_t const aRCount = aTriple.countReplacements();
+		size_t const bRCount = bTriple.countReplacements();
+
+		if (aRCount != bRCount)
+			return (aRCount > bRCount);
+
+		return false;
+	});
+
+	mIsCacheValid = true;
+}
+
 bool ScTemplate::hasReplacement(std::string const & repl) const
 {
 	return (mReplacements.find(repl) != mReplacements.end());
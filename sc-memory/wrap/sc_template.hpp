@@ -10,6 +10,7 @@
 #include "sc_addr.hpp"
 #include "sc_utils.hpp"
 
+#include <functional>
 
 #define SC_REPL(x) (char const *)(x)
 
@@ -178,6 +179,31 @@ protected:
 	size_t mIndex;
 };
 
+/* Compiled value of triple. Names of replacements are resolved to slots (indices in result vector)
+ * once, when template compiles, so search and generation don't lookup them by name
+ */
+struct ScTemplateCompiledValue
+{
+	static size_t const NoSlot = size_t(-1);
+
+	ScTemplateItemValue::eType mItemType;
+	// constant type, that is used for iteration or generation
+	ScType mConstType;
+	ScAddr mAddr;
+	// slot of value in result vector, or NoSlot if value has no replacement name
+	size_t mSlot;
+
+	inline bool hasSlot() const
+	{
+		return (mSlot != NoSlot);
+	}
+};
+
+struct ScTemplateCompiledConstr3
+{
+	ScTemplateCompiledValue mValues[3];
+};
+
 template <typename Type>
 ScTemplateItemValue operator >> (Type const & value, char const * replName)
 {
@@ -192,6 +218,7 @@ ScTemplateItemValue operator >> (Type const & value, std::string const & replNam
 
 class ScTemplateGenResult;
 class ScTemplateSearchResult;
+class ScTemplateSearchResultItem;
 
 enum class ScTemplateResultCode : uint8_t
 {
@@ -200,6 +227,92 @@ enum class ScTemplateResultCode : uint8_t
 	InternalError = 2
 };
 
+/* Order of triples processing in template search:
+ * - Static - triples are sorted once by number of fixed elements in them;
+ * - CostBased - on each step of search next triple is selected by estimated number of its results.
+ *   Estimate is calculated from degrees of already found elements and cardinalities of types (see ScTemplateSearch)
+ */
+enum class ScTemplateSearchPlan : uint8_t
+{
+	Static = 0,
+	CostBased = 1
+};
+
+//! Returned by callback of template search to continue or stop it
+enum class ScTemplateSearchRequest : uint8_t
+{
+	Continue = 0,
+	Stop = 1
+};
+
+/* Callback of template search, that is called for each found result. Item refers to values of search,
+ * so it is valid just while callback runs
+ */
+typedef std::function<ScTemplateSearchRequest(ScTemplateSearchResultItem const & item)> ScTemplateSearchCallback;
+
+/* Cooperative cancellation of template search. Search checks it before each iteration step,
+ * so it can be cancelled from another thread. Found results are kept in search result
+ */
+class ScTemplateSearchCancellation
+{
+public:
+	_SC_EXTERN ScTemplateSearchCancellation();
+
+	_SC_EXTERN void cancel();
+	_SC_EXTERN void reset();
+	_SC_EXTERN bool isCancelled() const;
+
+private:
+	volatile int mIsCancelled;
+};
+
+/* Parameters of parallel template search. Results of the first triple of search are split into chunks,
+ * that are processed by workers with own memory contexts. When worker processed its chunks,
+ * it steals chunks of other workers
+ */
+class ScTemplateParallelParams
+{
+	friend class ScTemplateParallelSearch;
+
+public:
+	//! Number of workers 0 means number of processors
+	explicit ScTemplateParallelParams(size_t workersCount = 0)
+		: mWorkersCount(workersCount)
+		, mResultsLimit(0)
+		, mCancellation(nullptr)
+	{
+	}
+
+	//! Search stops, when \p limit results found. 0 means no limit
+	ScTemplateParallelParams & setResultsLimit(size_t limit)
+	{
+		mResultsLimit = limit;
+		return *this;
+	}
+
+	//! Sets cancellation, that is checked by workers. It should be alive until search finished
+	ScTemplateParallelParams & setCancellation(ScTemplateSearchCancellation const * cancellation)
+	{
+		mCancellation = cancellation;
+		return *this;
+	}
+
+	size_t getWorkersCount() const
+	{
+		return mWorkersCount;
+	}
+
+	size_t getResultsLimit() const
+	{
+		return mResultsLimit;
+	}
+
+protected:
+	size_t mWorkersCount;
+	size_t mResultsLimit;
+	ScTemplateSearchCancellation const * mCancellation;
+};
+
 /* Parameters for template generator.
  * Can be used to replace variables by values
  */
@@ -247,6 +360,7 @@ class ScTemplate final
 {
 	friend class ScMemoryContext;
 	friend class ScTemplateSearch;
+	friend class ScTemplateParallelSearch;
 	friend class ScTemplateGenerator;
 	friend class ScTemplateBuilder;
 
@@ -254,6 +368,7 @@ public:
 	typedef std::map<std::string, size_t> tReplacementsMap;
 	typedef std::vector<ScTemplateConstr3> tTemplateConstr3Vector;
 	typedef std::vector<size_t> tProcessOrder;
+	typedef std::vector<ScTemplateCompiledConstr3> tCompiledConstr3Vector;
 
 	_SC_EXTERN explicit ScTemplate(size_t BufferedNum = 16);
 
@@ -269,6 +384,10 @@ public:
 
 	_SC_EXTERN bool hasReplacement(std::string const & repl) const;
 
+	//! Sets order of triples processing in search. CostBased plan is used by default
+	_SC_EXTERN void setSearchPlan(ScTemplateSearchPlan plan);
+	_SC_EXTERN ScTemplateSearchPlan getSearchPlan() const;
+
 	/** Add construction:
 	 *          param2
 	 * param1 ----------> param3
@@ -292,13 +411,21 @@ public:
 protected:
 	// Begin: calls by memory context
 	bool generate(ScMemoryContext & ctx, ScTemplateGenResult & result, ScTemplateGenParams const & params, ScTemplateResultCode * errorCode = nullptr) const;
-    bool search(ScMemoryContext & ctx, ScTemplateSearchResult & result) const;
-	bool searchInStruct(ScMemoryContext & ctx, ScAddr const & scStruct, ScTemplateSearchResult & result) const;
+    bool search(ScMemoryContext & ctx, ScTemplateSearchResult & result, size_t limit = 0) const;
+	bool searchInStruct(ScMemoryContext & ctx, ScAddr const & scStruct, ScTemplateSearchResult & result, size_t limit = 0) const;
+	// Passes results into callback without storing them. Struct isn't checked, if it's empty
+	size_t searchForEach(ScMemoryContext & ctx, ScAddr const & scStruct, ScTemplateSearchCallback const & callback, size_t limit) const;
+	bool searchParallel(ScMemoryContext & ctx, ScTemplateParallelParams const & params, ScTemplateSearchResult & result) const;
 	
 	// Builds template based on template in sc-memory
 	bool fromScTemplate(ScMemoryContext & ctx, ScAddr const & scTemplateAddr);
 	// End: calls by memory context
 	
+	/** Resolves names of replacements to slots and builds static order of search. Called by search and
+	 * generation, when template changed after last compilation
+	 */
+	void compile() const;
+
 private:
 	/** Generates node or link element in memory, depending on type. 
 	 * If type isn't a node or link, then return empty addr
@@ -316,6 +443,7 @@ protected:
 	// Store construction (triples)
 	tTemplateConstr3Vector mConstructions;
 	size_t mCurrentReplPos;
+	ScTemplateSearchPlan mSearchPlan;
 
 	/* Caches (used to prevent processing order update on each search/gen)
 	 * Flag mIsCacheValid == false - request to update cache. We doesn't use two flags,
@@ -324,9 +452,10 @@ protected:
 	 * Caches are mutable, to prevent changes of template in search and generation, they can asses just a cache.
 	 * That because template passed into them by const reference.
 	 */
-	bool mIsCacheValid : 1;
+	mutable bool mIsCacheValid : 1;
 	mutable tProcessOrder mSearchCachedOrder;
 	mutable tProcessOrder mGenerateCachedOrder;
+	mutable tCompiledConstr3Vector mCompiledConstructions;
 };
 
 
@@ -398,6 +527,7 @@ protected:
 class ScTemplateSearchResult
 {
     friend class ScTemplateSearch;
+    friend class ScTemplateParallelSearch;
 
 public:
     inline size_t getSize() const
@@ -13,18 +13,22 @@ const ScTemplateGenParams ScTemplateGenParams::Empty = ScTemplateGenParams();
 
 class ScTemplateGenerator
 {
+	typedef std::vector<ScElementsBatch::Item> tBatchItems;
+
 public:
-	ScTemplateGenerator(ScTemplate::tReplacementsMap const & replacements,
-						ScTemplate::tTemplateConstr3Vector const & constructions,
+	ScTemplateGenerator(ScTemplate const & templ,
 						ScTemplateGenParams const & params,
 						ScMemoryContext & context)
-		: mReplacements(replacements)
-		, mConstructions(constructions)
+		: mReplacements(templ.mReplacements)
+		, mConstructions(templ.mConstructions)
+		, mCompiledConstructions(templ.mCompiledConstructions)
 		, mParams(params)
 		, mContext(context)
 	{
+		templ.compile();
+
 		// check if it valid
-		for (auto constr : mConstructions)
+		for (auto const & constr : mConstructions)
 		{
 			auto values = constr.getValues();
 			if (values[1].isFixed())
@@ -49,14 +53,16 @@ public:
 		result.mResult.resize(mConstructions.size() * 3);
 		result.mReplacements = mReplacements;
 
-		tAddrList createdElements;
-		size_t resultIdx = 0;
-		bool isError = false;
+		// all elements are created by one batch, so triple items are existing elements or indices of batch elements
+		ScElementsBatch batch;
+		batch.reserve(mConstructions.size() * 3);
+		tBatchItems items;
+		items.reserve(mConstructions.size() * 3);
 
-		for (auto it = mConstructions.begin(); it != mConstructions.end(); ++it)
+		for (size_t i = 0; i < mConstructions.size(); ++i)
 		{
-			ScTemplateConstr3 const & item = *it;
-			ScTemplateItemValue const * values = item.getValues();
+			ScTemplateItemValue const * values = mConstructions[i].getValues();
+			ScTemplateCompiledValue const * compiled = mCompiledConstructions[i].mValues;
 
 			// check that the third argument isn't a command to generate edge
 			check_expr(!(values[2].mItemType == ScTemplateItemValue::VT_Type && values[2].mTypeValue.isEdge()));
@@ -65,98 +71,67 @@ public:
 			// the second item couldn't be a replacement
 			check_expr(values[1].mItemType != ScTemplateItemValue::VT_Replace);
 
-			ScAddr const addr1 = resolveAddr(values[0], result.mResult);
-			check_expr(addr1.isValid());
-			ScAddr const addr2 = resolveAddr(values[2], result.mResult);
-			check_expr(addr2.isValid());
-
-			if (!addr1.isValid() || !addr2.isValid())
-			{
-				isError = true;
-				break;
-			}
+			ScElementsBatch::Item const item1 = resolveItem(compiled[0], items, batch);
+			ScElementsBatch::Item const item2 = resolveItem(compiled[2], items, batch);
+			if (!isItemValid(item1) || !isItemValid(item2))
+				return ScTemplateResultCode::InternalError;
 
-			ScAddr const edge = mContext.createEdge(*values[1].mTypeValue.upConstType(), addr1, addr2);
-			if (!edge.isValid())
-			{
-				isError = true;
-				break;
-			}
-
-			result.mResult[resultIdx++] = addr1;
-			result.mResult[resultIdx++] = edge;
-			result.mResult[resultIdx++] = addr2;
+			items.push_back(item1);
+			items.push_back(ScElementsBatch::Item(batch.appendEdge(*compiled[1].mConstType, item1, item2)));
+			items.push_back(item2);
 		}
 
-		if (isError)
-		{
-			cleanupCreated();
+		tAddrVector created;
+		if (!mContext.createElements(batch, created))
 			return ScTemplateResultCode::InternalError;
-		}
-
-		return ScTemplateResultCode::Success;
-	}
-
-	ScAddr createNodeLink(ScType const & type)
-	{
-		ScAddr addr;
-		if (type.isNode())
-		{
-			addr = mContext.createNode(*type);
-		}
-		else if (type.isLink())
-		{
-			addr = mContext.createLink();
-		}
 
-		if (addr.isValid())
-			mCreatedElements.push_back(addr);
+		for (size_t i = 0; i < items.size(); ++i)
+			result.mResult[i] = items[i].isIndex() ? created[items[i].getIndex()] : items[i].getAddr();
 
-		return addr;
+		return ScTemplateResultCode::Success;
 	}
 
-	ScAddr resolveAddr(ScTemplateItemValue const & itemValue, tAddrVector const & resultAddrs)
+	ScElementsBatch::Item resolveItem(ScTemplateCompiledValue const & itemValue, tBatchItems const & items, ScElementsBatch & batch)
 	{
-		/// TODO: improve speed, because not all time we need to replace by params
-		// replace by value from params
-		if (!mParams.empty() && !itemValue.mReplacementName.empty())
-		{
-			ScAddr result;
-			if (mParams.get(itemValue.mReplacementName, result))
-				return result;
-		}
+		// replace by value from params (they are resolved to slots in checkParams)
+		if (itemValue.hasSlot() && !mParamAddrs.empty() && mParamAddrs[itemValue.mSlot].isValid())
+			return ScElementsBatch::Item(mParamAddrs[itemValue.mSlot]);
 
 		switch (itemValue.mItemType)
 		{
 		case ScTemplateItemValue::VT_Addr:
-			return itemValue.mAddrValue;
+			return ScElementsBatch::Item(itemValue.mAddr);
 		case ScTemplateItemValue::VT_Type:
-			return createNodeLink(itemValue.mTypeValue.upConstType());
+		{
+			if (itemValue.mConstType.isNode())
+				return ScElementsBatch::Item(batch.appendNode(*itemValue.mConstType));
+			if (itemValue.mConstType.isLink())
+				return ScElementsBatch::Item(batch.appendLink());
+			break;
+		}
 		case ScTemplateItemValue::VT_Replace:
 		{
-			ScTemplate::tReplacementsMap::const_iterator it = mReplacements.find(itemValue.mReplacementName);
-			if (it != mReplacements.end())
-			{
-				check_expr(it->second < resultAddrs.size());
-				return resultAddrs[it->second];
-			}
+			// replacement refers to item of previous triple
+			if (itemValue.hasSlot() && itemValue.mSlot < items.size())
+				return items[itemValue.mSlot];
 		}
 		default:
 			break;
 		}
 
-		return ScAddr();
+		return ScElementsBatch::Item(ScAddr());
 	}
 
-	void cleanupCreated()
+	static bool isItemValid(ScElementsBatch::Item const & item)
 	{
-		for (tAddrList::iterator it = mCreatedElements.begin(); it != mCreatedElements.end(); ++it)
-			mContext.eraseElement(*it);
-		mCreatedElements.clear();
+		return item.isIndex() || item.getAddr().isValid();
 	}
 
-	bool checkParams() const
+	bool checkParams()
 	{
+		if (!mParams.empty())
+			mParamAddrs.resize(mConstructions.size() * 3);
+
 		ScTemplateGenParams::tParamsMap::const_iterator it;
 		for (it = mParams.mValues.begin(); it != mParams.mValues.end(); ++it)
 		{
@@ -170,6 +145,8 @@ public:
 			/// TODO: check subtype of objects. Can't replace tuple with no tuple object
 			if (!itemType.isVar() || itemType.isEdge())
 				return false;
+
+			mParamAddrs[itRepl->second] = it->second;
 		}
 
 		return true;
@@ -178,15 +155,17 @@ public:
 private:
 	ScTemplate::tReplacementsMap const & mReplacements;
 	ScTemplate::tTemplateConstr3Vector const & mConstructions;
+	ScTemplate::tCompiledConstr3Vector const & mCompiledConstructions;
 	ScTemplateGenParams const & mParams;
 	ScMemoryContext & mContext;
-	tAddrList mCreatedElements;
+	// values of params by slots of replacements
+	tAddrVector mParamAddrs;
 };
 
 
 bool ScTemplate::generate(ScMemoryContext & ctx, ScTemplateGenResult & result, ScTemplateGenParams const & params, ScTemplateResultCode * errorCode) const
 {
-	ScTemplateGenerator gen(mReplacements, mConstructions, params, ctx);
+	ScTemplateGenerator gen(*this, params, ctx);
 	ScTemplateResultCode resultCode = gen(result);
 
 	if (errorCode)
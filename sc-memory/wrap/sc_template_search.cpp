@@ -7,7 +7,14 @@
 #include "sc_template.hpp"
 #include "sc_memory.hpp"
 
+extern "C"
+{
+#include <glib.h>
+}
+
 #include <algorithm>
+#include <deque>
+#include <limits>
 
 
 class ScTemplateSearch
@@ -19,79 +26,95 @@ public:
 		: mTemplate(templ)
         , mContext(context)
 		, mScStruct(scStruct)
+		, mElementsCount(-1.0)
+		, mEdgesCount(-1.0)
+		, mStopFlag(nullptr)
+		, mCancellation(nullptr)
+		, mResultsCount(nullptr)
+		, mResultsLimit(0)
+		, mFoundCount(0)
     {
-		updateSearchCache();
+		mTemplate.compile();
+
+		mOwnStopFlag = 0;
+		mOwnResultsCount = 0;
+		mStopFlag = &mOwnStopFlag;
+		mResultsCount = &mOwnResultsCount;
     }
 
-	void updateSearchCache()
+	//! Search stops, when \p limit results found. 0 means no limit
+	void setLimit(size_t limit)
+	{
+		mResultsLimit = limit;
+	}
+
+	//! Found results are passed into \p callback instead of search result
+	void setCallback(ScTemplateSearchCallback const & callback)
 	{
-		if (!mTemplate.isSearchCacheValid())
+		mCallback = callback;
+	}
+
+	//! Returns number of results, that were appended into search result or passed into callback
+	size_t getFoundCount() const
+	{
+		return mFoundCount;
+	}
+
+	/* Sets shared state of search, that is used to stop workers of parallel search. When \p resultsLimit
+	 * results are counted in \p resultsCount, then \p stopFlag is set
+	 */
+	void setStopControl(volatile gint * stopFlag, ScTemplateSearchCancellation const * cancellation,
+						volatile gint * resultsCount, size_t resultsLimit)
+	{
+		mStopFlag = stopFlag;
+		mCancellation = cancellation;
+		mResultsCount = resultsCount;
+		mResultsLimit = resultsLimit;
+	}
+
+	bool isStopped() const
+	{
+		return ((g_atomic_int_get(mStopFlag) != 0) ||
+				(mCancellation && mCancellation->isCancelled()));
+	}
+
+	// Destroys iterator from pool, when step of search finishes
+	class IteratorGuard
+	{
+	public:
+		explicit IteratorGuard(sc_iterator3 * it)
+			: mIterator(it)
 		{
-			// update it
-			auto const & triples = mTemplate.mConstructions;
-			ScTemplate::tProcessOrder & cache = mTemplate.mSearchCachedOrder;
-			cache.resize(mTemplate.mConstructions.size());
-			size_t i = 0;
-			for (size_t & v : cache)
-				v = i++;
-
-			/* Main idea of this stage, to build an order where iterators with maximum number of 
-			 * fixed elements will runs first. This allow to minimize number of iterations. Also we can't 
-			 * start search from template a_a_a, or any template where all fixed elements are remplacements
-			 */
-			std::sort(cache.begin(), cache.end(), [&triples](size_t a, size_t b) {
-				ScTemplateConstr3 const & aTriple = triples[a];
-				ScTemplateConstr3 const & bTriple = triples[b];
-
-				// compare by addrs arguments count
-				size_t const aAddrCount = aTriple.countAddrs();
-				size_t const bAddrCount = bTriple.countAddrs();
-
-				if (aAddrCount != bAddrCount)
-					return (aAddrCount > bAddrCount);
-
-				// compare by fixed arguments count
-				size_t const aFCount = aTriple.countFixed();
-				size_t const bFCount = bTriple.countFixed();
-
-				if (aFCount != bFCount)
-					return (aFCount > bFCount);
-
-				// compare by replacements count
-				size_t const aRCount = aTriple.countReplacements();
-				size_t const bRCount = bTriple.countReplacements();
-
-				if (aRCount != bRCount)
-					return (aRCount > bRCount);
-
-				return false;
-			});
 		}
-	}
 
-    ScAddr const & resolveAddr(ScTemplateItemValue const & value) const
+		~IteratorGuard()
+		{
+			sc_iterator3_destroy(mIterator);
+		}
+
+	private:
+		sc_iterator3 * mIterator;
+	};
+
+    ScAddr const & resolveAddr(ScTemplateCompiledValue const & value) const
     {
         switch (value.mItemType)
         {
         case ScTemplateItemValue::VT_Addr:
-            return value.mAddrValue;
+            return value.mAddr;
 
         case ScTemplateItemValue::VT_Replace:
         {
-            auto it = mTemplate.mReplacements.find(value.mReplacementName);
-            check_expr(it != mTemplate.mReplacements.end());
-            check_expr(it->second < mResultAddrs.size());
-            return mResultAddrs[it->second];
+            check_expr(value.mSlot < mResultAddrs.size());
+            return mResultAddrs[value.mSlot];
         }
 
 		case ScTemplateItemValue::VT_Type:
 		{
-			if (!value.mReplacementName.empty())
+			if (value.hasSlot())
 			{
-				auto it = mTemplate.mReplacements.find(value.mReplacementName);
-				check_expr(it != mTemplate.mReplacements.end());
-				check_expr(it->second < mResultAddrs.size());
-				return mResultAddrs[it->second];
+				check_expr(value.mSlot < mResultAddrs.size());
+				return mResultAddrs[value.mSlot];
 			}
 			break;
 		}
@@ -104,44 +127,152 @@ public:
         return empty;
     }
 
-    ScIterator3Ptr createIterator(ScTemplateConstr3 const & constr)
-    {
-        ScTemplateItemValue const * values = constr.getValues();
+	static sc_iterator_param makeParam(ScAddr const & addr, sc_type type)
+	{
+		sc_iterator_param param;
+		param.is_type = addr.isValid() ? SC_FALSE : SC_TRUE;
+		if (param.is_type)
+			param.type = type;
+		else
+			param.addr = *addr;
+
+		return param;
+	}
 
-        ScTemplateItemValue const & value0 = values[0];
-        ScTemplateItemValue const & value1 = values[1];
-        ScTemplateItemValue const & value2 = values[2];
+	/* Initializes iterator from pool for triple. Returns false, if iterator can't be initialized
+	 * (fixed elements can't be read in context)
+	 */
+	bool initIterator(ScTemplateCompiledConstr3 const & constr, sc_iterator3 * it)
+	{
+		ScTemplateCompiledValue const * values = constr.mValues;
 
-		ScAddr const addr0 = resolveAddr(value0);
-		ScAddr const addr1 = resolveAddr(value1);
-		ScAddr const addr2 = resolveAddr(value2);
+		ScAddr const & addr0 = resolveAddr(values[0]);
+		ScAddr const & addr1 = resolveAddr(values[1]);
+		ScAddr const & addr2 = resolveAddr(values[2]);
 
-		if (addr0.isValid())
+		sc_iterator3_type type = sc_iterator3_count;
+		if (addr1.isValid()) // A_F_A - edge is already found, so its source and target are checked by caller
 		{
-			if (addr2.isValid()) // F_A_F
-			{
-				return mContext.iterator3(addr0, *value1.mTypeValue.upConstType(), addr2);
-			}
-			else // F_A_A
-			{
-				return mContext.iterator3(addr0, *value1.mTypeValue.upConstType(), *value2.mTypeValue.upConstType());
-			}
+			return (sc_iterator3_init(it, mContext.getRealContext(), sc_iterator3_a_f_a,
+									  makeParam(ScAddr(), addr0.isValid() ? sc_type(0) : *values[0].mConstType),
+									  makeParam(addr1, 0),
+									  makeParam(ScAddr(), addr2.isValid() ? sc_type(0) : *values[2].mConstType)) == SC_TRUE);
 		}
-		else if (addr2.isValid()) // A_A_F
+		else if (addr0.isValid())
 		{
-			return mContext.iterator3(*value0.mTypeValue.upConstType(), *value1.mTypeValue.upConstType(), addr2);
+			type = addr2.isValid() ? sc_iterator3_f_a_f : sc_iterator3_f_a_a;
 		}
-		else if (addr1.isValid()) // A_F_A
+		else if (addr2.isValid()) // A_A_F
 		{
-			return mContext.iterator3(*value0.mTypeValue.upConstType(), addr1, *value2.mTypeValue.upConstType());
+			type = sc_iterator3_a_a_f;
 		}
 		else // unknown iterator type
 		{
 			error("Unknown iterator type");
 		}
 
-        return ScIterator3Ptr();
-    }
+		return (sc_iterator3_init(it, mContext.getRealContext(), type,
+								  makeParam(addr0, *values[0].mConstType),
+								  makeParam(ScAddr(), *values[1].mConstType),
+								  makeParam(addr2, *values[2].mConstType)) == SC_TRUE);
+	}
+
+	/* Returns part of elements (edges, if \p isEdge is true), that match type of value. Cardinalities are
+	 * changed while search works, so selectivities are calculated once per search
+	 */
+	double selectivity(ScTemplateCompiledValue const & value, bool isEdge)
+	{
+		if (value.mItemType != ScTemplateItemValue::VT_Type)
+			return 1.0;
+
+		sc_type const type = *value.mConstType;
+		tSelectivityCache::const_iterator it = mSelectivityCache.find(type);
+		if (it != mSelectivityCache.end())
+			return it->second;
+
+		if (mElementsCount < 0.0)
+		{
+			mElementsCount = double(mContext.getTypeCardinality(0));
+			mEdgesCount = double(mContext.getTypeCardinality(sc_type_arc_common) +
+								 mContext.getTypeCardinality(sc_type_arc_access) +
+								 mContext.getTypeCardinality(sc_type_edge_common));
+		}
+
+		double const total = isEdge ? mEdgesCount : mElementsCount;
+		double const result = (total > 0.0) ? std::min(1.0, double(mContext.getTypeCardinality(type)) / total) : 1.0;
+		mSelectivityCache[type] = result;
+		return result;
+	}
+
+	/* Estimates number of results of triple iterator with already found elements. Iterator from fixed element
+	 * walks its output (input) edges, so number of results is a degree of element, multiplied by selectivities
+	 * of other values. Triple without fixed values can't be iterated, so it has infinite cost
+	 */
+	double estimateCost(ScTemplateCompiledConstr3 const & constr)
+	{
+		ScTemplateCompiledValue const * values = constr.mValues;
+
+		ScAddr const & addr0 = resolveAddr(values[0]);
+		ScAddr const & addr1 = resolveAddr(values[1]);
+		ScAddr const & addr2 = resolveAddr(values[2]);
+
+		if (addr1.isValid()) // A_F_A - edge has just one source and target
+			return 1.0;
+
+		uint32_t outDegree = 0, inDegree = 0;
+		if (addr0.isValid())
+		{
+			mContext.getElementDegree(addr0, outDegree, inDegree);
+			double const cost = double(outDegree) * selectivity(values[1], true);
+			if (addr2.isValid()) // F_A_F - just checks, that elements are connected
+			{
+				mContext.getElementDegree(addr2, outDegree, inDegree);
+				return std::min(1.0, std::min(cost, double(inDegree) * selectivity(values[1], true)));
+			}
+
+			return cost * selectivity(values[2], false); // F_A_A
+		}
+		else if (addr2.isValid()) // A_A_F
+		{
+			mContext.getElementDegree(addr2, outDegree, inDegree);
+			return double(inDegree) * selectivity(values[1], true) * selectivity(values[0], false);
+		}
+
+		return std::numeric_limits<double>::infinity();
+	}
+
+	/* Returns index of triple, that should be processed on \p orderIndex step of search. Cost based plan
+	 * selects unprocessed triple with minimal cost, so elements found on previous steps are used to
+	 * choose the next one. Triples with equal costs are selected in static order
+	 */
+	size_t selectConstruction(size_t orderIndex)
+	{
+		ScTemplate::tProcessOrder const & order = mTemplate.mSearchCachedOrder;
+		if (mTemplate.mSearchPlan == ScTemplateSearchPlan::Static)
+			return order[orderIndex];
+
+		bool const isLast = (orderIndex + 1 == order.size());
+		size_t result = order.size();
+		double resultCost = 0.0;
+		for (size_t const idx : order)
+		{
+			if (mProcessed[idx])
+				continue;
+
+			if (isLast)
+				return idx;
+
+			double const cost = estimateCost(mTemplate.mCompiledConstructions[idx]);
+			if (result == order.size() || cost < resultCost)
+			{
+				result = idx;
+				resultCost = cost;
+			}
+		}
+
+		check_expr(result < order.size());
+		return result;
+	}
 
 	bool checkInStruct(ScAddr const & addr)
 	{
@@ -158,88 +289,181 @@ public:
 		return false;
 	}
 
-	void refReplacement(ScTemplateItemValue const & v, ScAddr const & addr)
+	void refReplacement(ScTemplateCompiledValue const & v, ScAddr const & addr)
 	{
-		if (!v.mReplacementName.empty())
+		if (v.hasSlot())
 		{
-			auto it = mTemplate.mReplacements.find(v.mReplacementName);
-			check_expr(it != mTemplate.mReplacements.end());		
+			mResultAddrs[v.mSlot] = addr;
+			mReplRefs[v.mSlot]++;
+		}
+	}
 
-			mResultAddrs[it->second] = addr;
-			mReplRefs[it->second]++;
+	void unrefReplacement(ScTemplateCompiledValue const & v)
+	{
+		if (v.hasSlot())
+		{
+			mReplRefs[v.mSlot]--;
+			if (mReplRefs[v.mSlot] == 0)
+				mResultAddrs[v.mSlot].reset();
 		}
 	}
 
-	void unrefReplacement(ScTemplateItemValue const & v)
+	void appendResult(ScTemplateSearchResult & result)
 	{
-		if (!v.mReplacementName.empty())
+		if (mResultsLimit > 0)
 		{
-			auto it = mTemplate.mReplacements.find(v.mReplacementName);
-			check_expr(it != mTemplate.mReplacements.end());
-			
-			mReplRefs[it->second]--;
-			if (mReplRefs[it->second] == 0)
-				mResultAddrs[it->second].reset();
+			size_t const count = size_t(g_atomic_int_add(mResultsCount, 1));
+			if (count + 1 >= mResultsLimit)
+				g_atomic_int_set(mStopFlag, 1);
+			if (count >= mResultsLimit)
+				return;
+		}
+
+		++mFoundCount;
+		if (mCallback)
+		{
+			// item refers to values of current step, so it's valid just in callback
+			ScTemplateSearchResultItem const item(&mResultAddrs, &mTemplate.mReplacements);
+			if (mCallback(item) == ScTemplateSearchRequest::Stop)
+				g_atomic_int_set(mStopFlag, 1);
+		}
+		else
+		{
+			result.mResults.push_back(mResultAddrs);
 		}
 	}
 
+	// Stores values found for triple on \p orderIndex step and continues search from the next step
+	void processTriple(size_t orderIndex, size_t constrIndex, ScAddr const & value0, ScAddr const & value1, ScAddr const & value2,
+					   ScTemplateSearchResult & result)
+	{
+		/// check if search in structure
+		if (mScStruct.isValid())
+		{
+			if (!checkInStruct(value0) ||
+				!checkInStruct(value1) ||
+				!checkInStruct(value2))
+			{
+				return;
+			}
+		}
+
+		ScTemplateCompiledValue const * values = mTemplate.mCompiledConstructions[constrIndex].mValues;
+		size_t const resultIdx = constrIndex * 3;
+
+		// do not make cycle for optimization issues (remove comparsion expresion)
+		mResultAddrs[resultIdx] = value0;
+		mResultAddrs[resultIdx + 1] = value1;
+		mResultAddrs[resultIdx + 2] = value2;
+
+		refReplacement(values[0], value0);
+		refReplacement(values[1], value1);
+		refReplacement(values[2], value2);
+
+		if (orderIndex + 1 == mTemplate.mCompiledConstructions.size())
+		{
+			appendResult(result);
+		}
+		else
+		{
+			iteration(orderIndex + 1, result);
+		}
+
+		unrefReplacement(values[0]);
+		unrefReplacement(values[1]);
+		unrefReplacement(values[2]);
+	}
+
 	void iteration(size_t orderIndex, ScTemplateSearchResult & result)
     {
-		size_t const constrIndex = mTemplate.mSearchCachedOrder[orderIndex];
+		size_t const constrIndex = selectConstruction(orderIndex);
 
-        check_expr(constrIndex < mTemplate.mConstructions.size());
-		size_t const finishIdx = mTemplate.mConstructions.size() - 1;
-        size_t resultIdx = constrIndex * 3;
+        check_expr(constrIndex < mTemplate.mCompiledConstructions.size());
+		mProcessed[constrIndex] = true;
 		
 		/// TODO: prevent recursive search and make test for that case
 
-		ScTemplateConstr3 const & constr = mTemplate.mConstructions[constrIndex];
-		ScTemplateItemValue const * values = constr.getValues();
-        ScIterator3Ptr const it3 = createIterator(constr);
-        while (it3->next())
+		ScTemplateCompiledConstr3 const & constr = mTemplate.mCompiledConstructions[constrIndex];
+		ScTemplateCompiledValue const * values = constr.mValues;
+		bool const isEdgeFound = resolveAddr(values[1]).isValid();
+		ScAddr const source = resolveAddr(values[0]);
+		ScAddr const target = resolveAddr(values[2]);
+
+		// each step of search uses own iterator from pool, so iterators aren't allocated per step
+		sc_iterator3 * it3 = &(mIterators[orderIndex]);
+		if (!initIterator(constr, it3))
+		{
+			mProcessed[constrIndex] = false;
+			return;
+		}
+
+		IteratorGuard const guard(it3);
+        while (!isStopped() && sc_iterator3_next(it3) == SC_TRUE)
         {
-			/// check if search in structure
-			if (mScStruct.isValid())
+			ScAddr const value0(sc_iterator3_value(it3, 0));
+			ScAddr const value1(sc_iterator3_value(it3, 1));
+			ScAddr const value2(sc_iterator3_value(it3, 2));
+
+			// iterator from found edge returns its source and target, that can differ from found ones
+			if (isEdgeFound &&
+				((source.isValid() && source != value0) || (target.isValid() && target != value2)))
 			{
-				if (!checkInStruct(it3->value(0)) ||
-					!checkInStruct(it3->value(1)) ||
-					!checkInStruct(it3->value(2)))
-				{
-					continue;
-				}
+				continue;
 			}
 
-            // do not make cycle for optimization issues (remove comparsion expresion)
-            mResultAddrs[resultIdx] = it3->value(0);
-            mResultAddrs[resultIdx + 1] = it3->value(1);
-            mResultAddrs[resultIdx + 2] = it3->value(2);
-
-			refReplacement(values[0], it3->value(0));
-			refReplacement(values[1], it3->value(1));
-			refReplacement(values[2], it3->value(2));			
-
-			if (orderIndex == finishIdx)
-            {
-                result.mResults.push_back(mResultAddrs);
-            }
-            else
-            {
-				iteration(orderIndex + 1, result);
-            }
-
-			unrefReplacement(values[0]);
-			unrefReplacement(values[1]);
-			unrefReplacement(values[2]);
+			processTriple(orderIndex, constrIndex, value0, value1, value2, result);
         }
+
+		mProcessed[constrIndex] = false;
     }
 
+	void prepare()
+	{
+		mResultAddrs.assign(calculateOneResultSize(), ScAddr());
+		mReplRefs.assign(mResultAddrs.size(), 0);
+		mProcessed.assign(mTemplate.mCompiledConstructions.size(), false);
+		mIterators.resize(mTemplate.mCompiledConstructions.size());
+	}
+
+	/* Collects results of the first triple of search into \p candidates (three values per result),
+	 * returns index of this triple. Used by parallel search to split work between workers
+	 */
+	size_t collectCandidates(tAddrVector & candidates)
+	{
+		prepare();
+
+		size_t const constrIndex = selectConstruction(0);
+		check_expr(constrIndex < mTemplate.mCompiledConstructions.size());
+
+		sc_iterator3 * it3 = &(mIterators[0]);
+		if (initIterator(mTemplate.mCompiledConstructions[constrIndex], it3))
+		{
+			IteratorGuard const guard(it3);
+			while (!isStopped() && sc_iterator3_next(it3) == SC_TRUE)
+			{
+				candidates.push_back(ScAddr(sc_iterator3_value(it3, 0)));
+				candidates.push_back(ScAddr(sc_iterator3_value(it3, 1)));
+				candidates.push_back(ScAddr(sc_iterator3_value(it3, 2)));
+			}
+		}
+
+		return constrIndex;
+	}
+
+	//! Continues search from one of candidates, that were collected by collectCandidates. Should be called after prepare
+	void processCandidate(size_t constrIndex, ScAddr const * values, ScTemplateSearchResult & result)
+	{
+		mProcessed[constrIndex] = true;
+		processTriple(0, constrIndex, values[0], values[1], values[2], result);
+		mProcessed[constrIndex] = false;
+	}
+
     bool operator () (ScTemplateSearchResult & result)
     {
 		result.clear();
 
 		result.mReplacements = mTemplate.mReplacements;
-        mResultAddrs.resize(calculateOneResultSize());
-		mReplRefs.resize(mResultAddrs.size(), 0);
+		prepare();
 
         iteration(0, result);
 
@@ -254,7 +478,7 @@ public:
 private:
 	ScTemplate const & mTemplate;
     ScMemoryContext & mContext;
-	ScAddr const & mScStruct;
+	ScAddr const mScStruct;
 
 	typedef std::unordered_set<ScAddr, ScAddrHashFunc<uint32_t>> tStructCache;
 	tStructCache mStructCache;
@@ -262,16 +486,263 @@ private:
     tAddrVector mResultAddrs;
 	typedef std::vector<uint32_t> tReplRefs;
 	tReplRefs mReplRefs;
+
+	// flag per triple, that is processed on one of the previous steps of search
+	std::vector<bool> mProcessed;
+	// iterator per step of search
+	std::vector<sc_iterator3> mIterators;
+
+	// number of all elements and edges, they are requested once, when selectivity is calculated at first
+	double mElementsCount;
+	double mEdgesCount;
+	typedef std::unordered_map<sc_type, double> tSelectivityCache;
+	tSelectivityCache mSelectivityCache;
+
+	// state to stop search, it's shared between workers of parallel search
+	volatile gint * mStopFlag;
+	ScTemplateSearchCancellation const * mCancellation;
+	volatile gint * mResultsCount;
+	size_t mResultsLimit;
+	// state of search, that isn't shared
+	volatile gint mOwnStopFlag;
+	volatile gint mOwnResultsCount;
+
+	ScTemplateSearchCallback mCallback;
+	size_t mFoundCount;
+};
+
+ScTemplateSearchCancellation::ScTemplateSearchCancellation()
+	: mIsCancelled(0)
+{
+}
+
+void ScTemplateSearchCancellation::cancel()
+{
+	g_atomic_int_set(&mIsCancelled, 1);
+}
+
+void ScTemplateSearchCancellation::reset()
+{
+	g_atomic_int_set(&mIsCancelled, 0);
+}
+
+bool ScTemplateSearchCancellation::isCancelled() const
+{
+	return (g_atomic_int_get(&mIsCancelled) != 0);
+}
+
+/* Parallel search splits results of the first triple (candidates) into chunks. Chunks are distributed
+ * between queues of workers, worker takes chunks from the front of own queue and steals them from the back
+ * of other queues. The first worker runs in calling thread with its context, other workers run in own threads
+ * with own memory contexts. Results are collected per chunk and merged in chunks order
+ */
+class ScTemplateParallelSearch
+{
+	struct Chunk
+	{
+		size_t mBegin;
+		size_t mEnd;
+		ScTemplateSearchResult mResult;
+	};
+
+	struct WorkerQueue
+	{
+		GMutex mMutex;
+		std::deque<size_t> mChunks;
+	};
+
+	struct Worker
+	{
+		ScTemplateParallelSearch * mSearch;
+		size_t mIndex;
+		GThread * mThread;
+	};
+
+public:
+	// Number of chunks per worker. More chunks give better balance, but each of them has own result
+	static size_t const ChunksPerWorker = 8;
+
+	ScTemplateParallelSearch(ScTemplate const & templ, ScMemoryContext & context, ScTemplateParallelParams const & params)
+		: mTemplate(templ)
+		, mContext(context)
+		, mParams(params)
+		, mConstrIndex(0)
+		, mStopFlag(0)
+		, mResultsCount(0)
+	{
+		mTemplate.compile();
+	}
+
+	bool operator () (ScTemplateSearchResult & result)
+	{
+		result.clear();
+		result.mReplacements = mTemplate.mReplacements;
+
+		{
+			ScTemplateSearch search(mTemplate, mContext, ScAddr());
+			search.setStopControl(&mStopFlag, mParams.mCancellation, &mResultsCount, mParams.mResultsLimit);
+			mConstrIndex = search.collectCandidates(mCandidates);
+		}
+
+		size_t const candidatesCount = mCandidates.size() / 3;
+		if (candidatesCount == 0)
+			return false;
+
+		size_t workersCount = mParams.mWorkersCount;
+		if (workersCount == 0)
+			workersCount = g_get_num_processors();
+		workersCount = std::max<size_t>(1, std::min(workersCount, candidatesCount));
+
+		// split candidates into chunks and distribute them between workers
+		size_t const chunksCount = std::min(candidatesCount, workersCount * ChunksPerWorker);
+		mChunks.resize(chunksCount);
+		mQueues.resize(workersCount);
+		for (size_t i = 0; i < workersCount; ++i)
+			g_mutex_init(&(mQueues[i].mMutex));
+
+		for (size_t i = 0; i < chunksCount; ++i)
+		{
+			mChunks[i].mBegin = (i * candidatesCount) / chunksCount;
+			mChunks[i].mEnd = ((i + 1) * candidatesCount) / chunksCount;
+			mQueues[i % workersCount].mChunks.push_back(i);
+		}
+
+		std::vector<Worker> workers(workersCount);
+		for (size_t i = 0; i < workersCount; ++i)
+		{
+			workers[i].mSearch = this;
+			workers[i].mIndex = i;
+			workers[i].mThread = nullptr;
+		}
+
+		for (size_t i = 1; i < workersCount; ++i)
+		{
+			// chunks of worker, that can't be started, are stolen by other workers
+			workers[i].mThread = g_thread_try_new("template_search", &ScTemplateParallelSearch::workerThread, &(workers[i]), nullptr);
+		}
+
+		processChunks(0, mContext);
+
+		for (size_t i = 1; i < workersCount; ++i)
+		{
+			if (workers[i].mThread)
+				g_thread_join(workers[i].mThread);
+		}
+
+		for (size_t i = 0; i < workersCount; ++i)
+			g_mutex_clear(&(mQueues[i].mMutex));
+
+		for (Chunk & chunk : mChunks)
+		{
+			ScTemplateSearchResult::tSearchResults & chunkResults = chunk.mResult.mResults;
+			for (tAddrVector & item : chunkResults)
+				result.mResults.push_back(std::move(item));
+			chunkResults.clear();
+		}
+
+		return result.getSize() > 0;
+	}
+
+private:
+	static gpointer workerThread(gpointer data)
+	{
+		Worker * worker = static_cast<Worker*>(data);
+		ScTemplateParallelSearch * search = worker->mSearch;
+
+		ScMemoryContext context(search->mContext.getAccessLevels(), "template_search_worker");
+		search->processChunks(worker->mIndex, context);
+
+		return nullptr;
+	}
+
+	/* Returns index of the next chunk for worker. At first it takes chunks from own queue,
+	 * then steals them from other workers. If there are no more chunks, then returns false
+	 */
+	bool popChunk(size_t workerIndex, size_t & outChunk)
+	{
+		WorkerQueue & own = mQueues[workerIndex];
+		g_mutex_lock(&own.mMutex);
+		bool found = !own.mChunks.empty();
+		if (found)
+		{
+			outChunk = own.mChunks.front();
+			own.mChunks.pop_front();
+		}
+		g_mutex_unlock(&own.mMutex);
+
+		for (size_t i = 1; !found && i < mQueues.size(); ++i)
+		{
+			WorkerQueue & victim = mQueues[(workerIndex + i) % mQueues.size()];
+			g_mutex_lock(&victim.mMutex);
+			found = !victim.mChunks.empty();
+			if (found)
+			{
+				outChunk = victim.mChunks.back();
+				victim.mChunks.pop_back();
+			}
+			g_mutex_unlock(&victim.mMutex);
+		}
+
+		return found;
+	}
+
+	void processChunks(size_t workerIndex, ScMemoryContext & context)
+	{
+		ScTemplateSearch search(mTemplate, context, ScAddr());
+		search.setStopControl(&mStopFlag, mParams.mCancellation, &mResultsCount, mParams.mResultsLimit);
+		search.prepare();
+
+		size_t chunkIndex = 0;
+		while (!search.isStopped() && popChunk(workerIndex, chunkIndex))
+		{
+			Chunk & chunk = mChunks[chunkIndex];
+			for (size_t i = chunk.mBegin; i < chunk.mEnd && !search.isStopped(); ++i)
+				search.processCandidate(mConstrIndex, &(mCandidates[i * 3]), chunk.mResult);
+		}
+	}
+
+private:
+	ScTemplate const & mTemplate;
+	ScMemoryContext & mContext;
+	ScTemplateParallelParams const & mParams;
+
+	size_t mConstrIndex;
+	tAddrVector mCandidates;
+	std::vector<Chunk> mChunks;
+	std::vector<WorkerQueue> mQueues;
+
+	volatile gint mStopFlag;
+	volatile gint mResultsCount;
 };
 
-bool ScTemplate::search(ScMemoryContext & ctx, ScTemplateSearchResult & result) const
+bool ScTemplate::search(ScMemoryContext & ctx, ScTemplateSearchResult & result, size_t limit) const
 {
     ScTemplateSearch search(*this, ctx, ScAddr());
+    search.setLimit(limit);
     return search(result);
 }
 
-bool ScTemplate::searchInStruct(ScMemoryContext & ctx, ScAddr const & scStruct, ScTemplateSearchResult & result) const
+bool ScTemplate::searchInStruct(ScMemoryContext & ctx, ScAddr const & scStruct, ScTemplateSearchResult & result, size_t limit) const
 {
 	ScTemplateSearch search(*this, ctx, scStruct);
+	search.setLimit(limit);
+	return search(result);
+}
+
+size_t ScTemplate::searchForEach(ScMemoryContext & ctx, ScAddr const & scStruct, ScTemplateSearchCallback const & callback, size_t limit) const
+{
+	ScTemplateSearch search(*this, ctx, scStruct);
+	search.setLimit(limit);
+	search.setCallback(callback);
+
+	ScTemplateSearchResult result;
+	search(result);
+
+	return search.getFoundCount();
+}
+
+bool ScTemplate::searchParallel(ScMemoryContext & ctx, ScTemplateParallelParams const & params, ScTemplateSearchResult & result) const
+{
+	ScTemplateParallelSearch search(*this, ctx, params);
 	return search(result);
 }
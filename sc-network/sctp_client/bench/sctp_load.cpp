@@ -0,0 +1,174 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Load generator for sctp-server. For each number of connections it opens connections,
+ * sends requests from each one in a loop during specified time and reports requests/s and
+ * p50/p99 latency of requests.
+ *
+ * Usage: sctp-load <host> <port> [duration in seconds] [connections count ...]
+ */
+
+#include "../sctpClient.hpp"
+
+#if defined (SC_PLATFORM_WIN)
+    #include "../sockets/winSocket.hpp"
+#else
+    #include "../sockets/glibSocket.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+struct LoadResult
+{
+    std::vector<uint32_t> latencies;    // latency of each request in microseconds
+    bool failed;
+
+    LoadResult() : failed(false) {}
+};
+
+sctp::Client * createClient()
+{
+#if defined (SC_PLATFORM_WIN)
+    return new sctp::Client(new sctp::winSocket());
+#else
+    return new sctp::Client(new sctp::glibSocket());
+#endif
+}
+
+/* Each connection creates one sc-node and then requests its type. Request is a round trip
+ * without changes of sc-memory, so results of different runs can be compared
+ */
+void runConnection(std::string const & host, std::string const & port, std::atomic<bool> const & started,
+                   tClock::time_point const & deadline, LoadResult & result)
+{
+    sctp::Client * client = createClient();
+    if (!client->connect(host, port))
+    {
+        result.failed = true;
+        delete client;
+        return;
+    }
+
+    ScAddr const node = client->createNode(sc_type_node | sc_type_const);
+    if (!node.isValid())
+        result.failed = true;
+
+    while (!started.load())
+        std::this_thread::yield();
+
+    result.latencies.reserve(1 << 16);
+    while (!result.failed && tClock::now() < deadline)
+    {
+        tClock::time_point const begin = tClock::now();
+        if (client->getElementType(node) != (sc_type_node | sc_type_const))
+        {
+            result.failed = true;
+            break;
+        }
+        tClock::time_point const end = tClock::now();
+        result.latencies.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+    }
+
+    client->disconnect();
+    delete client;
+}
+
+bool runLoad(std::string const & host, std::string const & port, uint32_t connections, uint32_t duration)
+{
+    std::vector<LoadResult> results(connections);
+    std::vector<std::thread> threads;
+    std::atomic<bool> started(false);
+
+    // connections are opened before measurement
+    tClock::time_point const deadline = tClock::now() + std::chrono::seconds(duration + connections / 100 + 1);
+    for (uint32_t i = 0; i < connections; ++i)
+        threads.push_back(std::thread(runConnection, host, port, std::cref(started), std::cref(deadline), std::ref(results[i])));
+
+    std::this_thread::sleep_for(std::chrono::seconds(connections / 100 + 1));
+    tClock::time_point const begin = tClock::now();
+    started = true;
+
+    for (uint32_t i = 0; i < connections; ++i)
+        threads[i].join();
+
+    double const seconds = std::chrono::duration<double>(tClock::now() - begin).count();
+
+    std::vector<uint32_t> latencies;
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < connections; ++i)
+    {
+        latencies.insert(latencies.end(), results[i].latencies.begin(), results[i].latencies.end());
+        if (results[i].failed)
+            ++failed;
+    }
+
+    if (latencies.empty())
+    {
+        printf("%11u  all connections failed\n", connections);
+        return false;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    uint32_t const p50 = latencies[latencies.size() / 2];
+    uint32_t const p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+
+    printf("%11u  %12.0f  %9u  %9u", connections, latencies.size() / seconds, p50, p99);
+    if (failed > 0)
+        printf("  (%u connections failed)", failed);
+    printf("\n");
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <host> <port> [duration in seconds] [connections count ...]\n", argv[0]);
+        return 1;
+    }
+
+#if defined (SC_PLATFORM_WIN)
+    sctp::winSocket::initialize();
+#endif
+
+    std::string const host = argv[1];
+    std::string const port = argv[2];
+    uint32_t const duration = (argc > 3) ? (uint32_t)atoi(argv[3]) : 5;
+
+    std::vector<uint32_t> connections;
+    for (int i = 4; i < argc; ++i)
+        connections.push_back((uint32_t)atoi(argv[i]));
+    if (connections.empty())
+    {
+        uint32_t const defaults[] = { 1, 8, 64, 256 };
+        connections.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+    }
+
+    printf("connections  requests/s  p50 (us)  p99 (us)\n");
+    bool result = true;
+    for (size_t i = 0; i < connections.size(); ++i)
+        result = runLoad(host, port, connections[i], duration) && result;
+
+#if defined (SC_PLATFORM_WIN)
+    sctp::winSocket::shutdown();
+#endif
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,422 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Compares throughput of synchronous and pipelined asynchronous sctp clients. Connections go
+ * through loopback proxy, that delays data in each direction by half of specified round trip
+ * latency. For each latency it reports:
+ * - sync: requests/s of sctp::Client, that waits for result of each request;
+ * - async: requests/s of sctp::AsyncClient, that keeps all requests in flight;
+ * - batch: sc-arcs/s created by AsyncClient::createArcs.
+ *
+ * Usage: sctp-pipeline <host> <port> [requests count] [latency in ms ...]
+ */
+
+#include "../sctpClient.hpp"
+#include "../sctpAsyncClient.hpp"
+#include "../sockets/glibSocket.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock tClock;
+
+//! Sync client is stopped after this time, because it's too slow on big latencies
+std::chrono::seconds const kSyncTimeLimit(3);
+//! Number of sc-arcs in one createArcs call
+uint32_t const kArcsBatchSize = 1000;
+
+/* One direction of proxied connection. Reader receives data and puts it into queue with time,
+ * when it should be sent. Writer sends data, when this time comes
+ */
+class DelayPipe
+{
+public:
+    DelayPipe(int from, int to, tClock::duration const & delay)
+        : mFrom(from)
+        , mTo(to)
+        , mDelay(delay)
+        , mIsFinished(false)
+    {
+        mReader = std::thread(&DelayPipe::readLoop, this);
+        mWriter = std::thread(&DelayPipe::writeLoop, this);
+    }
+
+    ~DelayPipe()
+    {
+        mReader.join();
+        mWriter.join();
+    }
+
+private:
+    struct Chunk
+    {
+        tClock::time_point due;
+        std::vector<char> data;
+    };
+
+    void readLoop()
+    {
+        char buffer[64 * 1024];
+        while (true)
+        {
+            ssize_t const n = ::recv(mFrom, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                break;
+
+            Chunk chunk;
+            chunk.due = tClock::now() + mDelay;
+            chunk.data.assign(buffer, buffer + n);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push_back(std::move(chunk));
+            mCondition.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsFinished = true;
+        mCondition.notify_one();
+    }
+
+    void writeLoop()
+    {
+        while (true)
+        {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mIsFinished || !mQueue.empty(); });
+                if (mQueue.empty())
+                    break;
+
+                chunk = std::move(mQueue.front());
+                mQueue.pop_front();
+            }
+
+            std::this_thread::sleep_until(chunk.due);
+
+            size_t sent = 0;
+            while (sent < chunk.data.size())
+            {
+                ssize_t const n = ::send(mTo, chunk.data.data() + sent, chunk.data.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                    break;
+                sent += n;
+            }
+            if (sent < chunk.data.size())
+                break;
+        }
+
+        ::shutdown(mTo, SHUT_WR);
+    }
+
+private:
+    int mFrom;
+    int mTo;
+    tClock::duration mDelay;
+
+    std::deque<Chunk> mQueue;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mIsFinished;
+
+    std::thread mReader;
+    std::thread mWriter;
+};
+
+//! Loopback proxy, that accepts one connection and delays its data
+class DelayProxy
+{
+public:
+    DelayProxy(std::string const & host, std::string const & port, uint32_t latencyMs)
+        : mHost(host)
+        , mPort(port)
+        , mDelay(std::chrono::microseconds(latencyMs * 500))
+        , mListenSocket(-1)
+        , mClientSocket(-1)
+        , mServerSocket(-1)
+        , mListenPort(0)
+    {
+    }
+
+    ~DelayProxy()
+    {
+        // unblocks accept, if there was no connection
+        if (mListenSocket >= 0)
+            ::shutdown(mListenSocket, SHUT_RDWR);
+        if (mAcceptThread.joinable())
+            mAcceptThread.join();
+
+        // pipes are joined after both sides of connection are closed
+        mToServer.reset();
+        mToClient.reset();
+
+        if (mClientSocket >= 0)
+            ::close(mClientSocket);
+        if (mServerSocket >= 0)
+            ::close(mServerSocket);
+        if (mListenSocket >= 0)
+            ::close(mListenSocket);
+    }
+
+    //! Starts to listen for connection. Returns port of proxy or empty string on error
+    std::string start()
+    {
+        mListenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (mListenSocket < 0)
+            return std::string();
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+
+        socklen_t len = sizeof(addr);
+        if (::bind(mListenSocket, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            ::listen(mListenSocket, 1) != 0 ||
+            ::getsockname(mListenSocket, (sockaddr*)&addr, &len) != 0)
+        {
+            return std::string();
+        }
+
+        mListenPort = ntohs(addr.sin_port);
+        mAcceptThread = std::thread(&DelayProxy::acceptConnection, this);
+
+        return std::to_string(mListenPort);
+    }
+
+private:
+    void acceptConnection()
+    {
+        mClientSocket = ::accept(mListenSocket, 0, 0);
+        if (mClientSocket < 0)
+            return;
+
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo * info = 0;
+        if (::getaddrinfo(mHost.c_str(), mPort.c_str(), &hints, &info) != 0)
+        {
+            ::shutdown(mClientSocket, SHUT_RDWR);
+            return;
+        }
+
+        mServerSocket = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        bool const connected = mServerSocket >= 0 && ::connect(mServerSocket, info->ai_addr, info->ai_addrlen) == 0;
+        ::freeaddrinfo(info);
+
+        if (!connected)
+        {
+            ::shutdown(mClientSocket, SHUT_RDWR);
+            return;
+        }
+
+        int const flag = 1;
+        ::setsockopt(mClientSocket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        ::setsockopt(mServerSocket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+        mToServer.reset(new DelayPipe(mClientSocket, mServerSocket, mDelay));
+        mToClient.reset(new DelayPipe(mServerSocket, mClientSocket, mDelay));
+    }
+
+private:
+    std::string mHost;
+    std::string mPort;
+    tClock::duration mDelay;
+
+    int mListenSocket;
+    int mClientSocket;
+    int mServerSocket;
+    uint16_t mListenPort;
+
+    std::thread mAcceptThread;
+    std::unique_ptr<DelayPipe> mToServer;
+    std::unique_ptr<DelayPipe> mToClient;
+};
+
+double secondsFrom(tClock::time_point const & begin)
+{
+    return std::chrono::duration<double>(tClock::now() - begin).count();
+}
+
+//! Returns requests/s of synchronous client or negative value on error
+double runSync(std::string const & host, std::string const & port, uint32_t requests, uint32_t latencyMs)
+{
+    DelayProxy proxy(host, port, latencyMs);
+    std::string const proxyPort = proxy.start();
+
+    sctp::Client client(new sctp::glibSocket());
+    if (proxyPort.empty() || !client.connect("127.0.0.1", proxyPort))
+        return -1.0;
+
+    ScAddr const node = client.createNode(sc_type_node | sc_type_const);
+    if (!node.isValid())
+        return -1.0;
+
+    uint32_t done = 0;
+    tClock::time_point const begin = tClock::now();
+    while (done < requests && tClock::now() - begin < kSyncTimeLimit)
+    {
+        if (client.getElementType(node) != (sc_type_node | sc_type_const))
+            return -1.0;
+        ++done;
+    }
+
+    double const result = done / secondsFrom(begin);
+    client.disconnect();
+
+    return result;
+}
+
+//! Returns requests/s of asynchronous client or negative value on error
+double runAsync(std::string const & host, std::string const & port, uint32_t requests, uint32_t latencyMs)
+{
+    DelayProxy proxy(host, port, latencyMs);
+    std::string const proxyPort = proxy.start();
+
+    sctp::AsyncClient client(new sctp::glibSocket());
+    if (proxyPort.empty() || !client.connect("127.0.0.1", proxyPort))
+        return -1.0;
+
+    ScAddr const node = client.createNode(sc_type_node | sc_type_const).get();
+    if (!node.isValid())
+        return -1.0;
+
+    std::vector< std::future<sc_type> > results;
+    results.reserve(requests);
+
+    tClock::time_point const begin = tClock::now();
+    for (uint32_t i = 0; i < requests; ++i)
+        results.push_back(client.getElementType(node));
+
+    for (uint32_t i = 0; i < requests; ++i)
+    {
+        if (results[i].get() != (sc_type_node | sc_type_const))
+            return -1.0;
+    }
+
+    double const result = requests / secondsFrom(begin);
+    client.disconnect();
+
+    return result;
+}
+
+//! Returns sc-arcs/s created by batches or negative value on error
+double runBatch(std::string const & host, std::string const & port, uint32_t requests, uint32_t latencyMs)
+{
+    DelayProxy proxy(host, port, latencyMs);
+    std::string const proxyPort = proxy.start();
+
+    sctp::AsyncClient client(new sctp::glibSocket());
+    if (proxyPort.empty() || !client.connect("127.0.0.1", proxyPort))
+        return -1.0;
+
+    std::future<ScAddr> source = client.createNode(sc_type_node | sc_type_const);
+    std::future<ScAddr> target = client.createNode(sc_type_node | sc_type_const);
+    ScAddr const begAddr = source.get();
+    ScAddr const endAddr = target.get();
+    if (!begAddr.isValid() || !endAddr.isValid())
+        return -1.0;
+
+    std::vector< std::future<tAddrVector> > results;
+
+    tClock::time_point const begin = tClock::now();
+    for (uint32_t created = 0; created < requests; created += kArcsBatchSize)
+    {
+        uint32_t const count = std::min(kArcsBatchSize, requests - created);
+        sctp::AsyncClient::tArcInfoVector arcs(count, sctp::AsyncClient::ArcInfo(sc_type_arc_pos_const_perm, begAddr, endAddr));
+        results.push_back(client.createArcs(arcs));
+    }
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        tAddrVector const arcs = results[i].get();
+        for (size_t j = 0; j < arcs.size(); ++j)
+        {
+            if (!arcs[j].isValid())
+                return -1.0;
+        }
+    }
+
+    double const result = requests / secondsFrom(begin);
+    client.disconnect();
+
+    return result;
+}
+
+void printValue(double value)
+{
+    if (value < 0.0)
+        printf("  %12s", "failed");
+    else
+        printf("  %12.0f", value);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <host> <port> [requests count] [latency in ms ...]\n", argv[0]);
+        return 1;
+    }
+
+    std::string const host = argv[1];
+    std::string const port = argv[2];
+    uint32_t const requests = (argc > 3) ? (uint32_t)atoi(argv[3]) : 10000;
+
+    std::vector<uint32_t> latencies;
+    for (int i = 4; i < argc; ++i)
+        latencies.push_back((uint32_t)atoi(argv[i]));
+    if (latencies.empty())
+    {
+        uint32_t const defaults[] = { 0, 1, 5, 20 };
+        latencies.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+    }
+
+    printf("latency (ms)  sync (req/s)  async (req/s)  batch (arcs/s)\n");
+    bool result = true;
+    for (size_t i = 0; i < latencies.size(); ++i)
+    {
+        double const sync = runSync(host, port, requests, latencies[i]);
+        double const async = runAsync(host, port, requests, latencies[i]);
+        double const batch = runBatch(host, port, requests, latencies[i]);
+
+        printf("%12u", latencies[i]);
+        printValue(sync);
+        printValue(async);
+        printValue(batch);
+        printf("\n");
+
+        result = result && sync >= 0.0 && async >= 0.0 && batch >= 0.0;
+    }
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,399 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sctpAsyncClient.hpp"
+
+#include <cstring>
+#include <memory>
+
+namespace sctp
+{
+
+namespace
+{
+
+template <typename ValueType>
+std::shared_ptr< std::promise<ValueType> > makePromise()
+{
+    return std::make_shared< std::promise<ValueType> >();
+}
+
+//! Reads sc-addr from result of command, that creates sc-element
+ScAddr resultAddr(ResultHeader const & header, char const * data)
+{
+    if (header.resultCode != SCTP_RESULT_OK || header.resultSize != sizeof(tRealAddr))
+        return ScAddr();
+
+    tRealAddr addr;
+    memcpy(&addr, data, sizeof(addr));
+    return ScAddr(addr);
+}
+
+//! State of batched request, that is shared by callbacks of all its commands
+struct BatchState
+{
+    std::promise<tAddrVector> promise;
+    tAddrVector result;
+    std::atomic<sc_uint32> remain;
+
+    explicit BatchState(sc_uint32 count)
+        : result(count)
+        , remain(count)
+    {
+    }
+};
+
+} // namespace
+
+_SC_EXTERN AsyncClient::AsyncClient(ISocket * socket)
+    : mSocketImpl(socket)
+    , mCmdIdCounter(0)
+    , mIsRunning(false)
+{
+}
+
+_SC_EXTERN AsyncClient::~AsyncClient()
+{
+    disconnect();
+    delete mSocketImpl;
+}
+
+_SC_EXTERN bool AsyncClient::connect(std::string const & address, std::string const & port)
+{
+    if (mIsRunning || !mSocketImpl->connect(address, port))
+        return false;
+
+    mIsRunning = true;
+    mReceiveThread = std::thread(&AsyncClient::receiveResults, this);
+
+    return true;
+}
+
+_SC_EXTERN void AsyncClient::disconnect()
+{
+    if (mReceiveThread.joinable())
+    {
+        mIsRunning = false;
+        mSocketImpl->interrupt();
+        mReceiveThread.join();
+    }
+
+    if (mSocketImpl->isConnected())
+        mSocketImpl->disconnect();
+
+    failPending();
+}
+
+_SC_EXTERN std::future<bool> AsyncClient::isElement(ScAddr const & addr)
+{
+    auto promise = makePromise<bool>();
+    tRealAddr const param = addr.getRealAddr();
+
+    if (!request(SCTP_CMD_CHECK_ELEMENT, &param, sizeof(param), [promise](ResultHeader const & header, char const *)
+        {
+            promise->set_value(header.resultCode == SCTP_RESULT_OK);
+        }))
+    {
+        promise->set_value(false);
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<bool> AsyncClient::eraseElement(ScAddr const & addr)
+{
+    auto promise = makePromise<bool>();
+    tRealAddr const param = addr.getRealAddr();
+
+    if (!request(SCTP_CMD_ERASE_ELEMENT, &param, sizeof(param), [promise](ResultHeader const & header, char const *)
+        {
+            promise->set_value(header.resultCode == SCTP_RESULT_OK);
+        }))
+    {
+        promise->set_value(false);
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<sc_type> AsyncClient::getElementType(ScAddr const & addr)
+{
+    auto promise = makePromise<sc_type>();
+    tRealAddr const param = addr.getRealAddr();
+
+    if (!request(SCTP_CMD_GET_ELEMENT_TYPE, &param, sizeof(param), [promise](ResultHeader const & header, char const * data)
+        {
+            sc_type type = 0;
+            if (header.resultCode == SCTP_RESULT_OK && header.resultSize == sizeof(type))
+                memcpy(&type, data, sizeof(type));
+            promise->set_value(type);
+        }))
+    {
+        promise->set_value((sc_type)0);
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<ScAddr> AsyncClient::createNode(sc_type type)
+{
+    auto promise = makePromise<ScAddr>();
+
+    if (!request(SCTP_CMD_CREATE_NODE, &type, sizeof(type), [promise](ResultHeader const & header, char const * data)
+        {
+            promise->set_value(resultAddr(header, data));
+        }))
+    {
+        promise->set_value(ScAddr());
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<ScAddr> AsyncClient::createLink()
+{
+    auto promise = makePromise<ScAddr>();
+
+    if (!request(SCTP_CMD_CREATE_LINK, 0, 0, [promise](ResultHeader const & header, char const * data)
+        {
+            promise->set_value(resultAddr(header, data));
+        }))
+    {
+        promise->set_value(ScAddr());
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<ScAddr> AsyncClient::createArc(sc_type type, ScAddr const & addrBeg, ScAddr const & addrEnd)
+{
+    auto promise = makePromise<ScAddr>();
+
+    // params: type, begin, end
+    char params[sizeof(sc_type) + 2 * sizeof(tRealAddr)];
+    tRealAddr const begin = addrBeg.getRealAddr();
+    tRealAddr const end = addrEnd.getRealAddr();
+    memcpy(params, &type, sizeof(type));
+    memcpy(params + sizeof(type), &begin, sizeof(begin));
+    memcpy(params + sizeof(type) + sizeof(begin), &end, sizeof(end));
+
+    if (!request(SCTP_CMD_CREATE_ARC, params, sizeof(params), [promise](ResultHeader const & header, char const * data)
+        {
+            promise->set_value(resultAddr(header, data));
+        }))
+    {
+        promise->set_value(ScAddr());
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<tAddrVector> AsyncClient::createArcs(tArcInfoVector const & arcs)
+{
+    auto state = std::make_shared<BatchState>((sc_uint32)arcs.size());
+    std::future<tAddrVector> future = state->promise.get_future();
+
+    if (arcs.empty())
+    {
+        state->promise.set_value(tAddrVector());
+        return future;
+    }
+
+    sc_uint32 const paramsSize = sizeof(sc_type) + 2 * sizeof(tRealAddr);
+    std::vector<char> params(paramsSize * arcs.size());
+    std::vector<tResultCallback> callbacks;
+    callbacks.reserve(arcs.size());
+
+    for (size_t i = 0; i < arcs.size(); ++i)
+    {
+        char * p = params.data() + i * paramsSize;
+        tRealAddr const begin = arcs[i].begin.getRealAddr();
+        tRealAddr const end = arcs[i].end.getRealAddr();
+
+        memcpy(p, &arcs[i].type, sizeof(sc_type));
+        memcpy(p + sizeof(sc_type), &begin, sizeof(begin));
+        memcpy(p + sizeof(sc_type) + sizeof(begin), &end, sizeof(end));
+
+        callbacks.push_back([state, i](ResultHeader const & header, char const * data)
+            {
+                state->result[i] = resultAddr(header, data);
+                if (--state->remain == 0)
+                    state->promise.set_value(state->result);
+            });
+    }
+
+    if (!requestBatch(SCTP_CMD_CREATE_ARC, params, paramsSize, callbacks))
+        state->promise.set_value(tAddrVector(arcs.size()));
+
+    return future;
+}
+
+_SC_EXTERN std::future<bool> AsyncClient::setLinkContent(ScAddr const & addr, IScStreamPtr const & stream)
+{
+    auto promise = makePromise<bool>();
+
+    // params: sc-addr, content size, content
+    std::vector<char> params(sizeof(tRealAddr) + sizeof(sc_uint32) + stream->size());
+    tRealAddr const realAddr = addr.getRealAddr();
+    sc_uint32 const size = stream->size();
+    memcpy(params.data(), &realAddr, sizeof(realAddr));
+    memcpy(params.data() + sizeof(realAddr), &size, sizeof(size));
+
+    sc_uint32 readBytes = 0;
+    if ((size > 0 && !stream->read(params.data() + sizeof(realAddr) + sizeof(size), size, readBytes)) || readBytes != size)
+    {
+        promise->set_value(false);
+        return promise->get_future();
+    }
+
+    if (!request(SCTP_CMD_SET_LINK_CONTENT, params.data(), (sc_uint32)params.size(), [promise](ResultHeader const & header, char const *)
+        {
+            promise->set_value(header.resultCode == SCTP_RESULT_OK);
+        }))
+    {
+        promise->set_value(false);
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN std::future<IScStreamPtr> AsyncClient::getLinkContent(ScAddr const & addr)
+{
+    auto promise = makePromise<IScStreamPtr>();
+    tRealAddr const param = addr.getRealAddr();
+
+    if (!request(SCTP_CMD_GET_LINK_CONTENT, &param, sizeof(param), [promise](ResultHeader const & header, char const * data)
+        {
+            if (header.resultCode != SCTP_RESULT_OK)
+            {
+                promise->set_value(IScStreamPtr());
+                return;
+            }
+
+            char * buff = new char[header.resultSize];
+            memcpy(buff, data, header.resultSize);
+            MemoryBufferPtr buffer(new MemoryBuffer(buff, header.resultSize));
+            promise->set_value(IScStreamPtr(new ScStreamMemory(buffer)));
+        }))
+    {
+        promise->set_value(IScStreamPtr());
+    }
+
+    return promise->get_future();
+}
+
+_SC_EXTERN bool AsyncClient::request(sc_uint8 cmdCode, void const * params, sc_uint32 paramsSize, tResultCallback const & callback)
+{
+    std::vector<char> data(paramsSize);
+    if (paramsSize > 0)
+        memcpy(data.data(), params, paramsSize);
+
+    return requestBatch(cmdCode, data, paramsSize, std::vector<tResultCallback>(1, callback));
+}
+
+_SC_EXTERN size_t AsyncClient::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    return mPending.size();
+}
+
+bool AsyncClient::requestBatch(sc_uint8 cmdCode, std::vector<char> const & params, sc_uint32 paramsSize, std::vector<tResultCallback> const & callbacks)
+{
+    if (!mIsRunning)
+        return false;
+
+    // all requests are packed into one buffer, so they are written by one call
+    sc_uint32 const frameSize = sizeof(RequestHeader) + paramsSize;
+    std::vector<char> frames(frameSize * callbacks.size());
+    std::vector<sc_uint32> ids(callbacks.size());
+
+    for (size_t i = 0; i < callbacks.size(); ++i)
+    {
+        RequestHeader header;
+        header.commandType = cmdCode;
+        header.flags = 0;
+        header.id = ids[i] = ++mCmdIdCounter;
+        header.argsSize = paramsSize;
+
+        char * frame = frames.data() + i * frameSize;
+        memcpy(frame, &header, sizeof(header));
+        if (paramsSize > 0)
+            memcpy(frame + sizeof(header), params.data() + i * paramsSize, paramsSize);
+    }
+
+    std::lock_guard<std::mutex> writeLock(mWriteMutex);
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        for (size_t i = 0; i < callbacks.size(); ++i)
+            mPending[ids[i]] = callbacks[i];
+    }
+
+    if (mSocketImpl->write(frames.data(), (sc_uint32)frames.size()) == static_cast<int>(frames.size()))
+        return true;
+
+    // requests weren't sent, so they don't wait for results
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    for (size_t i = 0; i < ids.size(); ++i)
+        mPending.erase(ids[i]);
+
+    return false;
+}
+
+void AsyncClient::receiveResults()
+{
+    std::vector<char> data;
+
+    while (mIsRunning)
+    {
+        ResultHeader header;
+        if (mSocketImpl->readType(header) != sizeof(header))
+            break;
+
+        data.resize(header.resultSize);
+        if (header.resultSize > 0 && mSocketImpl->read(data.data(), header.resultSize) != static_cast<int>(header.resultSize))
+            break;
+
+        // header is packed, so id is copied before lookup
+        sc_uint32 const id = header.id;
+        tResultCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            tPendingMap::iterator it = mPending.find(id);
+            if (it == mPending.end())
+                continue;
+
+            callback.swap(it->second);
+            mPending.erase(it);
+        }
+
+        callback(header, data.data());
+    }
+
+    mIsRunning = false;
+    failPending();
+}
+
+void AsyncClient::failPending()
+{
+    tPendingMap pending;
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        pending.swap(mPending);
+    }
+
+    for (tPendingMap::iterator it = pending.begin(); it != pending.end(); ++it)
+    {
+        ResultHeader header;
+        header.code = 0;
+        header.id = it->first;
+        header.resultCode = SCTP_RESULT_FAIL;
+        header.resultSize = 0;
+
+        it->second(header, 0);
+    }
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include "sctpClient.hpp"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sctp
+{
+
+/*! Asynchronous sctp client. Requests are written into socket without waiting for results
+ * of previous ones, so many requests are processed by server at the same time. Results are
+ * received by separate thread and matched with requests by command id.
+ *
+ * Each request method returns future. Also any command can be sent by request() with callback,
+ * that is called from receiving thread. All methods can be called from any thread.
+ */
+class AsyncClient
+{
+public:
+    /*! Callback, that is called when result of command is received
+     * @param header Header of result
+     * @param data Pointer to result data (header.resultSize bytes). It's valid during call only
+     */
+    typedef std::function<void(ResultHeader const & header, char const * data)> tResultCallback;
+
+    //! Description of sc-arc for batched creation
+    struct ArcInfo
+    {
+        sc_type type;
+        ScAddr begin;
+        ScAddr end;
+
+        ArcInfo(sc_type _type, ScAddr const & _begin, ScAddr const & _end)
+            : type(_type), begin(_begin), end(_end) {}
+    };
+    typedef std::vector<ArcInfo> tArcInfoVector;
+
+    _SC_EXTERN explicit AsyncClient(ISocket * socket);
+    _SC_EXTERN virtual ~AsyncClient();
+
+    //! Connects to server and starts receiving thread
+    _SC_EXTERN bool connect(std::string const & address, std::string const & port);
+    //! Closes connection. Requests, that wait for results, are finished with fail
+    _SC_EXTERN void disconnect();
+
+    _SC_EXTERN std::future<bool> isElement(ScAddr const & addr);
+    _SC_EXTERN std::future<bool> eraseElement(ScAddr const & addr);
+    _SC_EXTERN std::future<sc_type> getElementType(ScAddr const & addr);
+
+    _SC_EXTERN std::future<ScAddr> createNode(sc_type type);
+    _SC_EXTERN std::future<ScAddr> createLink();
+    _SC_EXTERN std::future<ScAddr> createArc(sc_type type, ScAddr const & addrBeg, ScAddr const & addrEnd);
+
+    /*! Creates sc-arcs. All requests are written by one call, so they are received by server as
+     * one batch. Result contains created sc-arcs in order of \p arcs. If any sc-arc wasn't created,
+     * then its value is invalid
+     */
+    _SC_EXTERN std::future<tAddrVector> createArcs(tArcInfoVector const & arcs);
+
+    _SC_EXTERN std::future<bool> setLinkContent(ScAddr const & addr, IScStreamPtr const & stream);
+    //! Result is invalid stream, if there are any errors
+    _SC_EXTERN std::future<IScStreamPtr> getLinkContent(ScAddr const & addr);
+
+    /*! Sends command with specified params
+     * @param cmdCode Command code
+     * @param params Pointer to command params
+     * @param paramsSize Size of params in bytes
+     * @param callback Callback, that is called when result is received. If connection is closed
+     * before result, then it's called with SCTP_RESULT_FAIL code and empty data
+     * @returns Returns false, if request wasn't written. Callback isn't called in this case
+     */
+    _SC_EXTERN bool request(sc_uint8 cmdCode, void const * params, sc_uint32 paramsSize, tResultCallback const & callback);
+
+    //! Returns number of requests, that wait for results
+    _SC_EXTERN size_t pendingCount() const;
+
+private:
+    //! Writes several requests by one call. Each request is a pair of params and callback
+    bool requestBatch(sc_uint8 cmdCode, std::vector<char> const & params, sc_uint32 paramsSize, std::vector<tResultCallback> const & callbacks);
+
+    //! Loop of receiving thread
+    void receiveResults();
+    //! Calls callbacks of all pending requests with fail result
+    void failPending();
+
+private:
+    ISocket * mSocketImpl;
+
+    std::atomic<sc_uint32> mCmdIdCounter;
+
+    //! Mutex to write requests. Request is registered before writing, so its result can't be missed
+    std::mutex mWriteMutex;
+
+    //! Requests, that wait for results
+    typedef std::map<sc_uint32, tResultCallback> tPendingMap;
+    tPendingMap mPending;
+    mutable std::mutex mPendingMutex;
+
+    std::thread mReceiveThread;
+    std::atomic<bool> mIsRunning;
+};
+
+}
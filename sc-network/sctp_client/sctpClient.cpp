@@ -7,45 +7,130 @@
 #include "sctpClient.hpp"
 #include "sctpTypes.hpp"
 
+#include <algorithm>
+
 namespace sctp
 {
 
-sc_uint8 mIterRange;
-sc_uint32 mResultCount;
-sc_uint32 mCurrentResult;
-TSharedPointer<char> mBuffer;
-
-Iterator::Iterator(TSharedPointer<char> buffer, sc_uint32 resultCount, sc_uint8 iterRange)
-    : mIterRange(iterRange)
-    , mResultCount(resultCount)
-    , mCurrentResult(0)
-    , mBuffer(buffer)
-
-
-
+Iterator::Iterator(Client * client, sc_uint8 iterRange, sc_uint32 pageSize)
+	: mClient(client)
+	, mCursorId(0)
+	, mPageSize(pageSize)
+	, mIterRange(iterRange)
+	, mResultCount(0)
+	, mCurrentResult(0)
 {
 }
 
 Iterator::~Iterator()
 {
+	if (mCursorId != 0)
+		mClient->closeCursor(mCursorId);
 }
 
 bool Iterator::next()
 {
 	++mCurrentResult;
-	return (mCurrentResult <= mResultCount);
+	if (mCurrentResult <= mResultCount)
+		return true;
+
+	// request next page
+	if (mCursorId == 0 || !mClient->nextCursorPage(*this))
+		return false;
+
+	mCurrentResult = 1;
+	return (mResultCount > 0);
 }
 
 ScAddr Iterator::getValue(sc_uint8 idx) const
 {
-	check_expr(mCurrentResult > 0);
-	sc_uint32 const offset = (mCurrentResult - 1) * sizeof(tRealAddr) * mIterRange + sizeof(tRealAddr) * idx;
-	return ScAddr(*((tRealAddr*)(mBuffer._GetPtr() + offset)));
+	check_expr(mCurrentResult > 0 && mCurrentResult <= mResultCount);
+	check_expr(idx < mIterRange);
+	return ScAddr(mBuffer[(mCurrentResult - 1) * mIterRange + idx]);
+}
+
+// -----------------------------------------
+_SC_EXTERN Batch::Batch()
+	: mCount(0)
+{
+	// the first value is a number of operations
+	writeValue(mCount);
+}
+
+_SC_EXTERN Batch::Ref Batch::createNode(sc_type type)
+{
+	Ref const ref = addOperation(SCTP_BATCH_CREATE_NODE);
+	writeValue(type);
+	return ref;
+}
+
+_SC_EXTERN Batch::Ref Batch::createLink()
+{
+	return addOperation(SCTP_BATCH_CREATE_LINK);
+}
+
+_SC_EXTERN Batch::Ref Batch::createArc(sc_type type, Ref const & begin, Ref const & end)
+{
+	Ref const ref = addOperation(SCTP_BATCH_CREATE_ARC);
+	writeValue(type);
+	writeRef(begin);
+	writeRef(end);
+	return ref;
+}
+
+_SC_EXTERN Batch::Ref Batch::setLinkContent(Ref const & link, IScStreamPtr const & stream)
+{
+	std::vector<char> data(stream->size());
+	sc_uint32 readBytes = 0;
+	if (!data.empty() && !stream->read(data.data(), (sc_uint32)data.size(), readBytes))
+		readBytes = 0;
+	data.resize(readBytes);
+
+	return setLinkContent(link, data.data(), (sc_uint32)data.size());
+}
+
+_SC_EXTERN Batch::Ref Batch::setLinkContent(Ref const & link, char const * data, sc_uint32 size)
+{
+	Ref const ref = addOperation(SCTP_BATCH_SET_LINK_CONTENT);
+	writeRef(link);
+	writeValue(size);
+	mData.insert(mData.end(), data, data + size);
+	return ref;
+}
+
+_SC_EXTERN void Batch::clear()
+{
+	mData.clear();
+	mCount = 0;
+	writeValue(mCount);
+}
+
+Batch::Ref Batch::addOperation(sc_uint8 op)
+{
+	writeValue(op);
+	Ref const ref(mCount++);
+	memcpy(mData.data(), &mCount, sizeof(mCount));
+	return ref;
+}
+
+void Batch::writeRef(Ref const & ref)
+{
+	if (ref.mIsLocal)
+	{
+		writeValue((sc_uint8)SCTP_BATCH_REF_INDEX);
+		writeValue(ref.mIndex);
+	}
+	else
+	{
+		writeValue((sc_uint8)SCTP_BATCH_REF_ADDR);
+		writeValue(ref.mAddr.getRealAddr());
+	}
 }
 
 // -----------------------------------------
 _SC_EXTERN Client::Client(ISocket * socket)
     : mCmdIdCounter(0)
+    , mIteratorPageSize(SCTP_ITERATOR_PAGE_SIZE)
     , mSocketImpl(socket)
 {
 }
@@ -307,6 +392,153 @@ _SC_EXTERN bool Client::findLinksByContent(IScStreamPtr const & stream, tAddrLis
     return false;
 }
 
+_SC_EXTERN void Client::setIteratorPageSize(sc_uint32 pageSize)
+{
+    check_expr(pageSize > 0);
+    mIteratorPageSize = pageSize;
+}
+
+_SC_EXTERN bool Client::applyBatch(Batch const & batch, tAddrVector & result, sc_uint32 * failedOp)
+{
+    RequestHeader req;
+    std::vector<char> const & data = batch.data();
+
+    req.id = ++mCmdIdCounter;
+    req.flags = 0;
+    req.commandType = SCTP_CMD_BATCH;
+    req.argsSize = (sc_uint32)data.size();
+
+    result.clear();
+    if (!writeSctpHeader(req) || mSocketImpl->write((void*)data.data(), req.argsSize) != static_cast<int>(req.argsSize))
+        return false;
+
+    ResultHeader res;
+    if (!readResultHeader(res))
+        return false;
+
+    if (res.resultCode != SCTP_RESULT_OK)
+    {
+        // result contains index of failed operation
+        sc_uint32 index = 0;
+        if (res.resultSize != sizeof(index))
+        {
+            skipResult(res.resultSize);
+            return false;
+        }
+
+        if (mSocketImpl->readType(index) == sizeof(index) && failedOp)
+            *failedOp = index;
+        return false;
+    }
+
+    if (res.resultSize != batch.size() * sizeof(tRealAddr))
+    {
+        skipResult(res.resultSize);
+        return false;
+    }
+
+    std::vector<tRealAddr> addrs(res.resultSize / sizeof(tRealAddr));
+    if (res.resultSize > 0 && mSocketImpl->read(addrs.data(), res.resultSize) != static_cast<int>(res.resultSize))
+        return false;
+
+    result.reserve(addrs.size());
+    for (size_t i = 0; i < addrs.size(); ++i)
+        result.push_back(ScAddr(addrs[i]));
+
+    return true;
+}
+
+bool Client::openCursor(Iterator & iter, char const * params, sc_uint32 paramsSize)
+{
+    RequestHeader req;
+    sc_uint8 const iterateCmd = SCTP_CMD_ITERATE_ELEMENTS;
+
+    req.id = ++mCmdIdCounter;
+    req.flags = 0;
+    req.commandType = SCTP_CMD_CURSOR_OPEN;
+    req.argsSize = sizeof(iterateCmd) + sizeof(iter.mPageSize) + paramsSize;
+
+    if (writeSctpHeader(req) &&
+        mSocketImpl->writeType(iterateCmd) == sizeof(iterateCmd) &&
+        mSocketImpl->writeType(iter.mPageSize) == sizeof(iter.mPageSize) &&
+        mSocketImpl->write((void*)params, paramsSize) == static_cast<int>(paramsSize))
+    {
+        return readCursorPage(iter);
+    }
+
+    return false;
+}
+
+bool Client::nextCursorPage(Iterator & iter)
+{
+    RequestHeader req;
+
+    req.id = ++mCmdIdCounter;
+    req.flags = 0;
+    req.commandType = SCTP_CMD_CURSOR_NEXT;
+    req.argsSize = sizeof(iter.mCursorId) + sizeof(iter.mPageSize);
+
+    if (writeSctpHeader(req) &&
+        mSocketImpl->writeType(iter.mCursorId) == sizeof(iter.mCursorId) &&
+        mSocketImpl->writeType(iter.mPageSize) == sizeof(iter.mPageSize))
+    {
+        return readCursorPage(iter);
+    }
+
+    iter.mCursorId = 0;
+    return false;
+}
+
+void Client::closeCursor(sc_uint32 cursorId)
+{
+    RequestHeader req;
+
+    req.id = ++mCmdIdCounter;
+    req.flags = 0;
+    req.commandType = SCTP_CMD_CURSOR_CLOSE;
+    req.argsSize = sizeof(cursorId);
+
+    if (writeSctpHeader(req) && mSocketImpl->writeType(cursorId) == sizeof(cursorId))
+    {
+        ResultHeader res;
+        readResultHeader(res);
+    }
+}
+
+bool Client::readCursorPage(Iterator & iter)
+{
+    ResultHeader res;
+    iter.mResultCount = 0;
+
+    if (!readResultHeader(res) || res.resultCode != SCTP_RESULT_OK)
+    {
+        iter.mCursorId = 0;
+        return false;
+    }
+
+    sc_uint32 header[2]; // cursor id, results count
+    if (mSocketImpl->readType(header) != sizeof(header))
+    {
+        iter.mCursorId = 0;
+        return false;
+    }
+
+    iter.mCursorId = header[0];
+
+    sc_uint32 const valuesCount = header[1] * iter.mIterRange;
+    // buffer is reused by all pages
+    iter.mBuffer.resize(valuesCount);
+    sc_uint32 const bufferSize = valuesCount * sizeof(tRealAddr);
+    if (bufferSize > 0 && mSocketImpl->read(iter.mBuffer.data(), bufferSize) != static_cast<int>(bufferSize))
+    {
+        iter.mCursorId = 0;
+        return false;
+    }
+
+    iter.mResultCount = header[1];
+    return true;
+}
+
 bool Client::writeSctpHeader(RequestHeader const & header)
 {
     assert(mSocketImpl);
@@ -322,5 +554,19 @@ bool Client::readResultHeader(ResultHeader & outHeader)
     return false;
 }
 
+bool Client::skipResult(sc_uint32 bytesCount)
+{
+    char buffer[1024];
+    while (bytesCount > 0)
+    {
+        sc_uint32 const size = std::min(bytesCount, (sc_uint32)sizeof(buffer));
+        if (mSocketImpl->read(buffer, size) != static_cast<int>(size))
+            return false;
+        bytesCount -= size;
+    }
+
+    return true;
+}
+
 
 }
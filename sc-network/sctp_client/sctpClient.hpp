@@ -13,12 +13,15 @@
 #include "sctpTypes.hpp"
 #include "sctpISocket.hpp"
 
+#include <vector>
 
 
 namespace sctp
 {
 
 #define SCTP_ADDR_SIZE      (sizeof(tRealAddr))
+//! Default number of iterator results, that are requested from server by one command
+#define SCTP_ITERATOR_PAGE_SIZE     1024
 
 #pragma pack(push,1)
 struct RequestHeader
@@ -78,23 +81,35 @@ struct ResultHeader
 
 #pragma pack(pop)
 
+class Client;
+
+/*! Iterator over results of server-side cursor. Results are received by pages, so iteration
+ * starts as soon as the first page is received. Next page is requested, when current one ends.
+ * Iterator uses client connection, so it must be destroyed before client.
+ */
 class Iterator
 {
 	friend class Client;
 
 protected:
-	_SC_EXTERN Iterator(TSharedPointer<char> buffer, sc_uint32 resultCount, sc_uint8 iterRange);
+	_SC_EXTERN Iterator(Client * client, sc_uint8 iterRange, sc_uint32 pageSize);
 
 public:
+	//! Closes cursor on server, if not all results were received
 	_SC_EXTERN virtual ~Iterator();
 	_SC_EXTERN bool next();
 	_SC_EXTERN ScAddr getValue(sc_uint8 idx) const;
 
 private:
+	Client * mClient;
+	//! Id of server-side cursor. It's zero, when all results were received
+	sc_uint32 mCursorId;
+	sc_uint32 mPageSize;
 	sc_uint8 mIterRange;
+	//! Number of results in current page
 	sc_uint32 mResultCount;
 	sc_uint32 mCurrentResult;
-	TSharedPointer<char> mBuffer;
+	std::vector<tRealAddr> mBuffer;
 };
 
 SHARED_PTR_TYPE(Iterator)
@@ -104,7 +119,7 @@ SHARED_PTR_TYPE(Iterator)
 template <typename ParamType1, typename ParamType2, typename ParamType3>
 sc_uint32 Iterator3ParamsT(char * buffer, ParamType1 const & param1, ParamType2 const & param2, ParamType3 const & param3);
 
-template<> sc_uint32 Iterator3ParamsT<ScAddr, sc_type, sc_type>(char * buffer, ScAddr const & param1, sc_type const & param2, sc_type const & param3)
+template<> inline sc_uint32 Iterator3ParamsT<ScAddr, sc_type, sc_type>(char * buffer, ScAddr const & param1, sc_type const & param2, sc_type const & param3)
 {
 	buffer[0] = SCTP_ITERATOR_3F_A_A;
 	tRealAddr * addrBuff = (tRealAddr*)(buffer + 1);
@@ -118,7 +133,7 @@ template<> sc_uint32 Iterator3ParamsT<ScAddr, sc_type, sc_type>(char * buffer, S
 	return 1 + sizeof(tRealAddr) + sizeof(sc_type)* 2;
 }
 
-template<> sc_uint32 Iterator3ParamsT<ScAddr, sc_type, ScAddr>(char * buffer, ScAddr const & param1, sc_type const & param2, ScAddr const & param3)
+template<> inline sc_uint32 Iterator3ParamsT<ScAddr, sc_type, ScAddr>(char * buffer, ScAddr const & param1, sc_type const & param2, ScAddr const & param3)
 {
 	buffer[0] = SCTP_ITERATOR_3F_A_F;
 	tRealAddr * addrBuff = (tRealAddr*)(buffer + 1);
@@ -133,7 +148,7 @@ template<> sc_uint32 Iterator3ParamsT<ScAddr, sc_type, ScAddr>(char * buffer, Sc
 	return 1 + sizeof(tRealAddr) * 2 + sizeof(sc_type);
 }
 
-template<> sc_uint32 Iterator3ParamsT<sc_type, sc_type, ScAddr>(char * buffer, sc_type const & param1, sc_type const & param2, ScAddr const & param3)
+template<> inline sc_uint32 Iterator3ParamsT<sc_type, sc_type, ScAddr>(char * buffer, sc_type const & param1, sc_type const & param2, ScAddr const & param3)
 {
 	buffer[0] = SCTP_ITERATOR_3A_A_F;
 	sc_type * typeBuff = (sc_type*)(buffer + 1);
@@ -152,7 +167,7 @@ template <typename ParamType1, typename ParamType2, typename ParamType3, typenam
 sc_uint32 Iterator5ParamsT(char * buffer, ParamType1 const & param1, ParamType2 const & param2, ParamType3 const & param3, ParamType4 const & param4, ParamType5 const & param5);
 
 
-template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, sc_type, sc_type, ScAddr>
+template <> inline sc_uint32 Iterator5ParamsT<ScAddr, sc_type, sc_type, sc_type, ScAddr>
 	(char * buffer, ScAddr const & param1, sc_type const & param2, sc_type const & param3, sc_type const & param4, ScAddr const & param5)
 {
 	buffer[0] = SCTP_ITERATOR_5F_A_A_A_F;
@@ -172,7 +187,7 @@ template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, sc_type, sc_type, ScAddr
 	return 1 + sizeof(tRealAddr) * 2 + sizeof(sc_type) * 3;
 }
 
-template <> sc_uint32 Iterator5ParamsT<sc_type, sc_type, ScAddr, sc_type, ScAddr>
+template <> inline sc_uint32 Iterator5ParamsT<sc_type, sc_type, ScAddr, sc_type, ScAddr>
 	(char * buffer, sc_type const & param1, sc_type const & param2, ScAddr const & param3, sc_type const & param4, ScAddr const & param5)
 {
 	buffer[0] = SCTP_ITERATOR_5A_A_F_A_F;
@@ -193,7 +208,7 @@ template <> sc_uint32 Iterator5ParamsT<sc_type, sc_type, ScAddr, sc_type, ScAddr
 	return 1 + sizeof(tRealAddr) * 2 + sizeof(sc_type) * 3;
 }
 
-template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, ScAddr, sc_type, ScAddr>
+template <> inline sc_uint32 Iterator5ParamsT<ScAddr, sc_type, ScAddr, sc_type, ScAddr>
 	(char * buffer, ScAddr const & param1, sc_type const & param2, ScAddr const & param3, sc_type const & param4, ScAddr const & param5)
 {
 	buffer[0] = SCTP_ITERATOR_5F_A_F_A_F;
@@ -214,7 +229,7 @@ template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, ScAddr, sc_type, ScAddr>
 	return 1 + sizeof(tRealAddr) * 3 + sizeof(sc_type) * 2;
 }
 
-template <> sc_uint32 Iterator5ParamsT<sc_type, sc_type, ScAddr, sc_type, sc_type>
+template <> inline sc_uint32 Iterator5ParamsT<sc_type, sc_type, ScAddr, sc_type, sc_type>
 	(char * buffer, sc_type const & param1, sc_type const & param2, ScAddr const & param3, sc_type const & param4, sc_type const & param5)
 {
 	buffer[0] = SCTP_ITERATOR_5A_A_F_A_A;
@@ -234,7 +249,7 @@ template <> sc_uint32 Iterator5ParamsT<sc_type, sc_type, ScAddr, sc_type, sc_typ
 	return 1 + sizeof(tRealAddr) + sizeof(sc_type) * 4;
 }
 
-template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, sc_type, sc_type, sc_type>
+template <> inline sc_uint32 Iterator5ParamsT<ScAddr, sc_type, sc_type, sc_type, sc_type>
 	(char * buffer, ScAddr const & param1, sc_type const & param2, sc_type const & param3, sc_type const & param4, sc_type const & param5)
 {
 	buffer[0] = SCTP_ITERATOR_5F_A_A_A_A;
@@ -253,7 +268,7 @@ template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, sc_type, sc_type, sc_typ
 	return 1 + sizeof(tRealAddr) + sizeof(sc_type) * 4;
 }
 
-template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, ScAddr, sc_type, sc_type>
+template <> inline sc_uint32 Iterator5ParamsT<ScAddr, sc_type, ScAddr, sc_type, sc_type>
 	(char * buffer, ScAddr const & param1, sc_type const & param2, ScAddr const & param3, sc_type const & param4, sc_type const & param5)
 {
 	buffer[0] = SCTP_ITERATOR_5F_A_F_A_A;
@@ -274,6 +289,68 @@ template <> sc_uint32 Iterator5ParamsT<ScAddr, sc_type, ScAddr, sc_type, sc_type
 	return 1 + sizeof(tRealAddr) * 2 + sizeof(sc_type) * 3;
 }
 
+// ------------------------------------------------------
+/*! Program of sc-element creation operations, that is applied by server as one command
+ * (see Client::applyBatch). Each operation returns reference to its result, so next operations
+ * can use sc-elements, that aren't created yet.
+ */
+class Batch
+{
+public:
+	//! Reference to existing sc-element or to result of previous batch operation
+	class Ref
+	{
+		friend class Batch;
+
+	public:
+		//! Makes reference to existing sc-element
+		Ref(ScAddr const & addr) : mAddr(addr), mIndex(0), mIsLocal(false) {}
+
+		//! Returns index of operation in batch, that creates referenced sc-element
+		sc_uint32 index() const { return mIndex; }
+		bool isLocal() const { return mIsLocal; }
+
+	private:
+		explicit Ref(sc_uint32 index) : mIndex(index), mIsLocal(true) {}
+
+		ScAddr mAddr;
+		sc_uint32 mIndex;
+		bool mIsLocal;
+	};
+
+	_SC_EXTERN Batch();
+
+	_SC_EXTERN Ref createNode(sc_type type);
+	_SC_EXTERN Ref createLink();
+	_SC_EXTERN Ref createArc(sc_type type, Ref const & begin, Ref const & end);
+	//! Result of this operation is sc-link itself
+	_SC_EXTERN Ref setLinkContent(Ref const & link, IScStreamPtr const & stream);
+	_SC_EXTERN Ref setLinkContent(Ref const & link, char const * data, sc_uint32 size);
+
+	//! Returns number of operations
+	sc_uint32 size() const { return mCount; }
+	bool isEmpty() const { return mCount == 0; }
+	_SC_EXTERN void clear();
+
+	//! Returns encoded params of SCTP_CMD_BATCH command
+	std::vector<char> const & data() const { return mData; }
+
+private:
+	Ref addOperation(sc_uint8 op);
+	void writeRef(Ref const & ref);
+
+	template <typename Type>
+	void writeValue(Type const & value)
+	{
+		char const * p = (char const *)&value;
+		mData.insert(mData.end(), p, p + sizeof(Type));
+	}
+
+private:
+	std::vector<char> mData;
+	sc_uint32 mCount;
+};
+
 // ------------------------------------------------------
 class Client
 {
@@ -314,34 +391,10 @@ public:
 	{
 		char buffer[128];
 		sc_uint32 paramsSize = Iterator3ParamsT(buffer, param1, param2, param3);
-		RequestHeader req;
-
-		req.id = ++mCmdIdCounter;
-		req.flags = 0;
-		req.commandType = SCTP_CMD_ITERATE_ELEMENTS;
-		req.argsSize = paramsSize;
-
-		if (mSocketImpl->writeType(req) == sizeof(RequestHeader) && mSocketImpl->write(buffer, paramsSize) == paramsSize)
-		{
-			ResultHeader resultHeader;
-			if (mSocketImpl->readType(resultHeader) == sizeof(ResultHeader))
-			{
-				sc_uint32 resultCount = 0;
-				if (mSocketImpl->readType(resultCount) == sizeof(sc_uint32))
-				{
-					sc_uint32 const bufferSize = sizeof(tRealAddr) * 3 * resultCount;
-					if (bufferSize > 0)
-					{
-						TSharedPointer<char> buffer = TSharedPointer<char>(new char[bufferSize]);
-						if (bufferSize > 0)
-						{
-							if (mSocketImpl->read(buffer._GetPtr(), bufferSize) == bufferSize)
-								return IteratorPtr(new Iterator(buffer, resultCount, 3));
-						}
-					}
-				}
-			}
-		}
+
+		IteratorPtr iter(new Iterator(this, 3, mIteratorPageSize));
+		if (openCursor(*iter, buffer, paramsSize))
+			return iter;
 
         return IteratorPtr();
 	}
@@ -352,48 +405,48 @@ public:
 	{
 		char buffer[128];
 		sc_uint32 paramsSize = Iterator5ParamsT(buffer, param1, param2, param3, param4, param5);
-		RequestHeader req;
-
-		req.id = ++mCmdIdCounter;
-		req.flags = 0;
-		req.commandType = SCTP_CMD_ITERATE_ELEMENTS;
-		req.argsSize = paramsSize;
-
-		if (mSocketImpl->writeType(req) == sizeof(RequestHeader) && mSocketImpl->write(buffer, paramsSize) == paramsSize)
-		{
-			ResultHeader resultHeader;
-			if (mSocketImpl->readType(resultHeader) == sizeof(ResultHeader))
-			{
-				sc_uint32 resultCount = 0;
-				if (mSocketImpl->readType(resultCount) == sizeof(sc_uint32))
-				{
-					sc_uint32 const bufferSize = sizeof(tRealAddr) * 5 * resultCount;
-					if (bufferSize > 0)
-					{
-						TSharedPointer<char> buffer = TSharedPointer<char>(new char[bufferSize]);
-						if (bufferSize > 0)
-						{
-							if (mSocketImpl->read(buffer._GetPtr(), bufferSize) == bufferSize)
-								return IteratorPtr(new Iterator(buffer, resultCount, 5));
-						}
-					}
-				}
-			}
-		}
+
+		IteratorPtr iter(new Iterator(this, 5, mIteratorPageSize));
+		if (openCursor(*iter, buffer, paramsSize))
+			return iter;
 
         return IteratorPtr();
 	}
 
+	//! Sets number of results, that iterators request from server by one command
+	_SC_EXTERN void setIteratorPageSize(sc_uint32 pageSize);
+
+	/*! Applies all operations of batch by one command.
+	 * @param batch Batch of operations
+	 * @param result Contains result of each operation in order of operations
+	 * @param failedOp If it isn't null, then it contains index of failed operation, when server
+	 * declined batch
+	 * @returns Returns true, if all operations were applied. Otherwise sc-elements, that were created
+	 * by batch, are erased by server
+	 */
+	_SC_EXTERN bool applyBatch(Batch const & batch, tAddrVector & result, sc_uint32 * failedOp = 0);
 
 private:
     bool writeSctpHeader(RequestHeader const & header);
     /// Buffer must have a correct size
     bool readResultHeader(ResultHeader & outHeader);
+    //! Reads and drops unread bytes of result, so next command starts from its header
+    bool skipResult(sc_uint32 bytesCount);
+
+    friend class Iterator;
+
+    //! Opens server-side cursor over results of SCTP_CMD_ITERATE_ELEMENTS with specified params
+    bool openCursor(Iterator & iter, char const * params, sc_uint32 paramsSize);
+    //! Requests next page of cursor results
+    bool nextCursorPage(Iterator & iter);
+    void closeCursor(sc_uint32 cursorId);
+    //! Reads page of cursor results into iterator buffer
+    bool readCursorPage(Iterator & iter);
 
-    ///! TODO : Iterators
 private:
 
     mutable sc_uint32 mCmdIdCounter;
+    sc_uint32 mIteratorPageSize;
     ISocket * mSocketImpl;
 };
 
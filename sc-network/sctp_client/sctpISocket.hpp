@@ -22,6 +22,11 @@ public:
 
     virtual bool isConnected() const = 0;
 
+    /** Shuts down connection without closing socket, so read, that is blocked in another
+     * thread, returns error. Socket must be disconnected after that.
+     */
+    virtual void interrupt() = 0;
+
     /** Reads data from socket into buffer (buffer size must be equal to bytesCount).
      * Returns number of bytes that was read. If returned value is -1,
      * then there was error while read data.
@@ -37,6 +37,10 @@ typedef enum
     SCTP_CMD_EVENT_DESTROY      = 0x0f, // destroys specified event subscription
     SCTP_CMD_EVENT_EMIT         = 0x10, // emits events to client
 	SCTP_CMD_GENERATE_CONSTRUCTION = 0x11, // generate cunstrution by template
+    SCTP_CMD_CURSOR_OPEN        = 0x12, // open iteration cursor and return the first page of results
+    SCTP_CMD_CURSOR_NEXT        = 0x13, // return next page of cursor results
+    SCTP_CMD_CURSOR_CLOSE       = 0x14, // close iteration cursor
+    SCTP_CMD_BATCH              = 0x15, // apply batch of element creation operations
 
     SCTP_CMD_FIND_ELEMENT_BY_SYSITDF = 0xa0, // return sc-element by it system identifier
     SCTP_CMD_SET_SYSIDTF        = 0xa1,   // setup new system identifier for sc-element
@@ -62,6 +66,31 @@ typedef enum
 
 } eSctpIteratorType;
 
+//! Flags of SCTP_CMD_ITERATE_CONSTRUCTION command
+typedef enum
+{
+    SCTP_ITERATE_FLAG_LIMIT     = 0x01  // parameters of iterators are followed by maximum number of results (quint32)
+
+} eSctpIterateFlag;
+
+//! Operations of SCTP_CMD_BATCH command
+typedef enum
+{
+    SCTP_BATCH_CREATE_NODE      = 0x00, // params: type
+    SCTP_BATCH_CREATE_LINK      = 0x01, // no params
+    SCTP_BATCH_CREATE_ARC       = 0x02, // params: type, begin reference, end reference
+    SCTP_BATCH_SET_LINK_CONTENT = 0x03  // params: link reference, content size, content
+
+} eSctpBatchOperation;
+
+//! Kinds of references to sc-elements in SCTP_CMD_BATCH operations
+typedef enum
+{
+    SCTP_BATCH_REF_ADDR         = 0x00, // followed by sc-addr of existing sc-element
+    SCTP_BATCH_REF_INDEX        = 0x01  // followed by index of previous operation in batch
+
+} eSctpBatchReference;
+
 typedef enum
 {
     SCTP_RESULT_OK              = 0x00, //
@@ -67,6 +67,12 @@ bool glibSocket::isConnected() const
     return mConnection;
 }
 
+void glibSocket::interrupt()
+{
+    if (mConnection)
+        g_socket_shutdown(g_socket_connection_get_socket(mConnection), TRUE, TRUE, NULL);
+}
+
 int glibSocket::read(void * buffer, unsigned int bytesCount)
 {
     g_assert(mInputStream);
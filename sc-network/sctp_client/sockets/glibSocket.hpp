@@ -28,6 +28,7 @@ public:
     void disconnect();
 
     bool isConnected() const;
+    void interrupt();
 
     /** Reads data from socket into buffer (buffer size must be equal to bytesCount).
      * Returns number of bytes that was read. If returned value is -1,
@@ -56,6 +56,12 @@ bool winSocket::isConnected() const
     return (mSocket != INVALID_SOCKET);
 }
 
+void winSocket::interrupt()
+{
+    if (mSocket != INVALID_SOCKET)
+        ::shutdown(mSocket, SD_BOTH);
+}
+
 int winSocket::read(void * buffer, unsigned int bytesCount)
 {
     unsigned int bytesRead = 0;
@@ -33,6 +33,7 @@ public:
 	_SC_EXTERN void disconnect();
 
 	_SC_EXTERN bool isConnected() const;
+	_SC_EXTERN void interrupt();
 
     /** Reads data from socket into buffer (buffer size must be equal to bytesCount).
      * Returns number of bytes that was read. If returned value is -1,
@@ -10,13 +10,16 @@ extern "C"
 }
 
 #include "../sctpClient.hpp"
+#include "../sctpAsyncClient.hpp"
 
 #if defined (SC_PLATFORM_WIN)
     #include "../sockets/winSocket.hpp"
     sctp::Client sctpClient(new sctp::winSocket());
+    #define SCTP_TEST_SOCKET sctp::winSocket
 #else
     #include "../sockets/glibSocket.hpp"
     sctp::Client sctpClient(new sctp::glibSocket());
+    #define SCTP_TEST_SOCKET sctp::glibSocket
 #endif
 
 void test_connection()
@@ -156,6 +159,154 @@ void test_iterators()
 	}
 }
 
+void test_iterator_pages()
+{
+	sc_uint32 const count = 11;
+
+	ScAddr addr = sctpClient.createNode(0);
+	g_assert(addr.isValid());
+
+	for (sc_uint32 i = 0; i < count; ++i)
+	{
+		ScAddr target = sctpClient.createNode(0);
+		g_assert(target.isValid());
+		g_assert(sctpClient.createArc(sc_type_arc_pos_const_perm, addr, target).isValid());
+	}
+
+	// results are received by several pages
+	sctpClient.setIteratorPageSize(3);
+
+	{
+		sctp::IteratorPtr iter = sctpClient.iterator3(addr, sc_type_arc_pos_const_perm, sc_type_node);
+		sc_uint32 found = 0;
+		while (iter->next())
+		{
+			g_assert(iter->getValue(0) == addr);
+			++found;
+		}
+		g_assert(found == count);
+	}
+
+	// cursor is closed, when iterator is destroyed before the end
+	{
+		sctp::IteratorPtr iter = sctpClient.iterator3(addr, sc_type_arc_pos_const_perm, sc_type_node);
+		g_assert(iter->next());
+		g_assert(iter->next());
+	}
+
+	// empty result
+	{
+		ScAddr empty = sctpClient.createNode(0);
+		sctp::IteratorPtr iter = sctpClient.iterator3(empty, sc_type_arc_pos_const_perm, sc_type_node);
+		g_assert(!iter->next());
+	}
+
+	sctpClient.setIteratorPageSize(SCTP_ITERATOR_PAGE_SIZE);
+	g_assert(sctpClient.isElement(addr));
+}
+
+void test_batch()
+{
+	ScAddr const existing = sctpClient.createNode(sc_type_node | sc_type_const);
+	g_assert(existing.isValid());
+
+	{
+		char const * data = "Batch content";
+		sctp::Batch batch;
+		sctp::Batch::Ref const node = batch.createNode(sc_type_node | sc_type_node_class);
+		sctp::Batch::Ref const link = batch.createLink();
+		sctp::Batch::Ref const arc = batch.createArc(sc_type_arc_pos_const_perm, node, link);
+		batch.createArc(sc_type_arc_common, existing, arc);
+		batch.setLinkContent(link, data, (sc_uint32)strlen(data));
+		g_assert(batch.size() == 5);
+
+		tAddrVector result;
+		g_assert(sctpClient.applyBatch(batch, result));
+		g_assert(result.size() == batch.size());
+
+		g_assert(sctpClient.getElementType(result[node.index()]) == (sc_type_node | sc_type_node_class));
+		g_assert(sctpClient.getElementType(result[link.index()]) == sc_type_link);
+		g_assert(result[4] == result[link.index()]);
+
+		ScAddr a1, a2;
+		g_assert(sctpClient.getArcInfo(result[arc.index()], a1, a2));
+		g_assert(a1 == result[node.index()]);
+		g_assert(a2 == result[link.index()]);
+		g_assert(sctpClient.getArcInfo(result[3], a1, a2));
+		g_assert(a1 == existing);
+		g_assert(a2 == result[arc.index()]);
+
+		IScStreamPtr stream;
+		g_assert(sctpClient.getLinkContent(result[link.index()], stream));
+		g_assert(stream->size() == strlen(data));
+	}
+
+	// batch is declined, if any operation fails
+	{
+		sctp::Batch batch;
+		sctp::Batch::Ref const node = batch.createNode(sc_type_node);
+		batch.createArc(sc_type_arc_pos_const_perm, node, existing);
+		batch.createArc(sc_type_arc_pos_const_perm, node, ScAddr());
+
+		tAddrVector result;
+		sc_uint32 failed = 0;
+		g_assert(!sctpClient.applyBatch(batch, result, &failed));
+		g_assert(failed == 2);
+		g_assert(result.empty());
+
+		sctp::IteratorPtr iter = sctpClient.iterator3(sc_type_node, sc_type_arc_pos_const_perm, existing);
+		g_assert(!iter->next());
+	}
+
+	sctp::Batch empty;
+	tAddrVector result;
+	g_assert(sctpClient.applyBatch(empty, result));
+	g_assert(result.empty());
+}
+
+void test_async_client()
+{
+	sctp::AsyncClient client(new SCTP_TEST_SOCKET());
+	g_assert(client.connect("127.0.0.1", "55770"));
+
+	// requests are sent without waiting for results
+	sc_uint32 const count = 50;
+	std::vector< std::future<ScAddr> > nodes;
+	for (sc_uint32 i = 0; i < count; ++i)
+		nodes.push_back(client.createNode(sc_type_node | sc_type_const));
+
+	sctp::AsyncClient::tArcInfoVector arcs;
+	ScAddr const source = nodes.front().get();
+	for (sc_uint32 i = 1; i < count; ++i)
+	{
+		ScAddr const target = nodes[i].get();
+		g_assert(target.isValid());
+		arcs.push_back(sctp::AsyncClient::ArcInfo(sc_type_arc_pos_const_perm, source, target));
+	}
+
+	tAddrVector const created = client.createArcs(arcs).get();
+	g_assert(created.size() == arcs.size());
+	for (size_t i = 0; i < created.size(); ++i)
+	{
+		g_assert(created[i].isValid());
+		g_assert(client.getElementType(created[i]).get() == sc_type_arc_pos_const_perm);
+	}
+
+	// results are available for synchronous client too
+	ScAddr a1, a2;
+	g_assert(sctpClient.getArcInfo(created.back(), a1, a2));
+	g_assert(a1 == source);
+	g_assert(a2 == arcs.back().end);
+
+	std::future<bool> erased = client.eraseElement(source);
+	std::future<bool> exists = client.isElement(source);
+	g_assert(erased.get());
+	g_assert(!exists.get());
+
+	client.disconnect();
+	g_assert(client.pendingCount() == 0);
+}
+
 int main(int argc, char *argv[])
 {
 #if defined (SC_PLATFORM_WIN)
@@ -167,6 +318,9 @@ int main(int argc, char *argv[])
     g_test_add_func("/sctp/connection", test_connection);
     g_test_add_func("/sctp/base_commands", test_base_commands);
 	g_test_add_func("/sctp/iterators", test_iterators);
+	g_test_add_func("/sctp/iterator_pages", test_iterator_pages);
+	g_test_add_func("/sctp/batch", test_batch);
+	g_test_add_func("/sctp/async_client", test_async_client);
 
     g_test_run();
 
@@ -0,0 +1,206 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/* Microbenchmark of sctp command framing. The same pipelined small commands (check element
+ * and get element type) are processed by two ways:
+ *  - stream: each command is read from socket device by processCommand(QIODevice*, QIODevice*)
+ *    and socket is flushed after each command (as it was done before batching);
+ *  - batch: received data is read into sctpBuffer by one call, commands are parsed in place by
+ *    processCommands and all results are written into socket by one call.
+ * Socket is emulated by device, that counts calls and copied bytes. Flush of the socket and read
+ * of available data are counted as system calls.
+ *
+ * Usage: sctp-framing-bench [commands count] [repo path]
+ */
+
+#include "../sctpCommand.h"
+#include "../sctpStatistic.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+//! Device, that emulates socket. It counts read and write calls, and bytes, that were copied by them
+class CountingSocket : public QIODevice
+{
+public:
+    CountingSocket(QByteArray const & received)
+        : mReceived(received)
+        , mReadPos(0)
+        , mCalls(0)
+        , mBytes(0)
+        , mSysCalls(0)
+    {
+        open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const { return mReceived.size() - mReadPos + QIODevice::bytesAvailable(); }
+
+    //! Emulates sending of written data
+    void flush()
+    {
+        ++mSysCalls;
+    }
+
+    quint64 calls() const { return mCalls; }
+    quint64 bytes() const { return mBytes; }
+    quint64 sysCalls() const { return mSysCalls; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        qint64 const bytes = qMin(maxSize, (qint64)(mReceived.size() - mReadPos));
+        memcpy(data, mReceived.constData() + mReadPos, bytes);
+        mReadPos += bytes;
+
+        ++mCalls;
+        mBytes += bytes;
+        return bytes;
+    }
+
+    qint64 writeData(const char *data, qint64 maxSize)
+    {
+        Q_UNUSED(data);
+        ++mCalls;
+        mBytes += maxSize;
+        return maxSize;
+    }
+
+private:
+    QByteArray mReceived;
+    qint64 mReadPos;
+
+    quint64 mCalls;
+    quint64 mBytes;
+    quint64 mSysCalls;
+};
+
+void appendCommand(QByteArray & data, quint8 code, quint32 id, sc_addr const & addr)
+{
+    quint8 const flags = 0;
+    quint32 const paramSize = sizeof(addr);
+
+    data.append((const char*)&code, sizeof(code));
+    data.append((const char*)&flags, sizeof(flags));
+    data.append((const char*)&id, sizeof(id));
+    data.append((const char*)&paramSize, sizeof(paramSize));
+    data.append((const char*)&addr, sizeof(addr));
+}
+
+void printResult(const char * mode, quint32 count, CountingSocket const & socket, quint64 extraBytes, qint64 nsecs)
+{
+    printf("%-8s %14.2f %14.2f %14.2f %12.1f\n", mode,
+           (double)socket.calls() / count,
+           (double)socket.sysCalls() / count,
+           (double)(socket.bytes() + extraBytes) / count,
+           (double)nsecs / count);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    quint32 const count = (argc > 1) ? (quint32)atoi(argv[1]) : 100000;
+    QString const repoPath = (argc > 2) ? QString(argv[2]) : QDir::temp().filePath("sctp-framing-bench");
+
+    QByteArray const repo = repoPath.toLocal8Bit();
+    sc_memory_params params;
+    sc_memory_params_clear(&params);
+    params.clear = SC_TRUE;
+    params.repo_path = repo.constData();
+
+    sc_memory_context *context = sc_memory_initialize(&params);
+    if (context == 0)
+    {
+        printf("Can't initialize sc-memory in %s\n", repo.constData());
+        return EXIT_FAILURE;
+    }
+
+    sctpStatistic statistic;
+    statistic.initialize(QDir(repoPath).filePath("stat"), 0, context);
+
+    sc_addr const node = sc_memory_node_new(context, sc_type_node | sc_type_const);
+
+    QByteArray requests;
+    for (quint32 i = 0; i < count; ++i)
+        appendCommand(requests, (i % 2) ? SCTP_CMD_GET_ELEMENT_TYPE : SCTP_CMD_CHECK_ELEMENT, i, node);
+
+    printf("Commands: %u, request size: %u bytes\n\n", count, (quint32)(requests.size() / count));
+    printf("%-8s %14s %14s %14s %12s\n", "mode", "dev calls/cmd", "syscalls/cmd", "bytes/cmd", "ns/cmd");
+
+    // stream
+    {
+        sctpCommand command;
+        command.init();
+
+        CountingSocket socket(requests);
+        QElapsedTimer timer;
+
+        // received data is read by one system call
+        socket.flush();
+        timer.start();
+        quint32 processed = 0;
+        while (socket.bytesAvailable() >= sctpCommand::cmdHeaderSize())
+        {
+            command.processCommand(&socket, &socket);
+            socket.flush();
+            ++processed;
+        }
+        qint64 const nsecs = timer.nsecsElapsed();
+
+        Q_ASSERT(processed == count);
+        printResult("stream", processed, socket, 0, nsecs);
+
+        command.shutdown();
+    }
+
+    // batch
+    {
+        sctpCommand command;
+        command.init();
+
+        CountingSocket socket(requests);
+        sctpBuffer input;
+        QByteArray output;
+        QElapsedTimer timer;
+
+        timer.start();
+
+        qint64 const available = socket.bytesAvailable();
+        input.commit((quint32)socket.read(input.reserve((quint32)available), available));
+        socket.flush();
+
+        QBuffer outDevice(&output);
+        outDevice.open(QIODevice::WriteOnly);
+        quint32 const processed = command.processCommands(input, &outDevice);
+
+        socket.write(output);
+        socket.flush();
+
+        qint64 const nsecs = timer.nsecsElapsed();
+
+        Q_ASSERT(processed == count);
+        // results are copied into output buffer before writing into socket
+        printResult("batch", processed, socket, output.size(), nsecs);
+
+        command.shutdown();
+    }
+
+    statistic.shutdown();
+    sc_memory_shutdown(SC_FALSE);
+
+    return EXIT_SUCCESS;
+}
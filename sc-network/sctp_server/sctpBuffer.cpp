@@ -0,0 +1,129 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sctpBuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SCTP_BUFFER_MIN_CAPACITY    4096
+
+sctpBuffer::sctpBuffer(quint32 capacity)
+    : mData(0)
+    , mCapacity(0)
+    , mBegin(0)
+    , mEnd(0)
+{
+    if (capacity > 0)
+        reserve(capacity);
+}
+
+sctpBuffer::~sctpBuffer()
+{
+    free(mData);
+}
+
+char* sctpBuffer::reserve(quint32 size)
+{
+    if (mCapacity - mEnd >= size)
+        return mData + mEnd;
+
+    quint32 const used = mEnd - mBegin;
+
+    // move not consumed data to the beginning, if it frees enough space
+    if (mCapacity - used >= size && used <= mBegin)
+    {
+        memcpy(mData, mData + mBegin, used);
+        mBegin = 0;
+        mEnd = used;
+        return mData + mEnd;
+    }
+
+    quint32 capacity = qMax(mCapacity, (quint32)SCTP_BUFFER_MIN_CAPACITY);
+    while (capacity - used < size)
+        capacity *= 2;
+
+    char *data = (char*)malloc(capacity);
+    Q_CHECK_PTR(data);
+    if (used > 0)
+        memcpy(data, mData + mBegin, used);
+    free(mData);
+
+    mData = data;
+    mCapacity = capacity;
+    mBegin = 0;
+    mEnd = used;
+
+    return mData + mEnd;
+}
+
+void sctpBuffer::commit(quint32 size)
+{
+    Q_ASSERT(mEnd + size <= mCapacity);
+    mEnd += size;
+}
+
+void sctpBuffer::append(const char *data, quint32 size)
+{
+    memcpy(reserve(size), data, size);
+    commit(size);
+}
+
+void sctpBuffer::consume(quint32 size)
+{
+    Q_ASSERT(size <= mEnd - mBegin);
+    mBegin += size;
+
+    if (mBegin == mEnd)
+        mBegin = mEnd = 0;
+}
+
+void sctpBuffer::clear()
+{
+    mBegin = mEnd = 0;
+}
+
+void sctpBuffer::swap(sctpBuffer &other)
+{
+    qSwap(mData, other.mData);
+    qSwap(mCapacity, other.mCapacity);
+    qSwap(mBegin, other.mBegin);
+    qSwap(mEnd, other.mEnd);
+}
+
+// ---------------------------------------------
+sctpParamsDevice::sctpParamsDevice()
+    : mData(0)
+    , mSize(0)
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void sctpParamsDevice::setData(const char *data, quint32 size)
+{
+    mData = data;
+    mSize = size;
+    seek(0);
+}
+
+qint64 sctpParamsDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 const available = (qint64)mSize - pos();
+    if (available <= 0)
+        return 0;
+
+    qint64 const bytes = qMin(available, maxSize);
+    memcpy(data, mData + pos(), bytes);
+
+    return bytes;
+}
+
+qint64 sctpParamsDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
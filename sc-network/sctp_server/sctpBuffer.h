@@ -0,0 +1,82 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sctpBuffer_h_
+#define _sctpBuffer_h_
+
+#include <QIODevice>
+
+/*! Reusable buffer of received data. Data is received directly into free space at the end
+ * and commands are parsed in place from the beginning. Memory isn't freed between batches:
+ * when all data is consumed offsets are reset, and incomplete command is moved to the
+ * beginning only if there is no enough free space. So received command is always
+ * contiguous and can be processed without copying.
+ */
+class sctpBuffer
+{
+public:
+    explicit sctpBuffer(quint32 capacity = 0);
+    ~sctpBuffer();
+
+    //! Returns pointer to the first not consumed byte
+    const char* data() const { return mData + mBegin; }
+    //! Returns number of not consumed bytes
+    quint32 size() const { return mEnd - mBegin; }
+    bool isEmpty() const { return mBegin == mEnd; }
+    quint32 capacity() const { return mCapacity; }
+
+    /*! Returns pointer to free space, that can store at least \p size bytes.
+     * Received data must be committed by commit call
+     */
+    char* reserve(quint32 size);
+    //! Appends \p size bytes, that were written into reserved space
+    void commit(quint32 size);
+    //! Copies data to the end of buffer
+    void append(const char *data, quint32 size);
+
+    //! Marks \p size bytes from the beginning as processed
+    void consume(quint32 size);
+    //! Removes all data. Allocated memory stays for reuse
+    void clear();
+
+    //! Exchanges contents with \p other buffer without copying
+    void swap(sctpBuffer &other);
+
+private:
+    Q_DISABLE_COPY(sctpBuffer)
+
+    char *mData;
+    quint32 mCapacity;
+    //! Offset of the first not consumed byte
+    quint32 mBegin;
+    //! Offset of the first free byte
+    quint32 mEnd;
+};
+
+/*! Read-only device over memory, that isn't owned. It's used to read command params directly
+ * from received data. Device is unbuffered, so data isn't copied into internal buffer of QIODevice.
+ */
+class sctpParamsDevice : public QIODevice
+{
+public:
+    sctpParamsDevice();
+
+    //! Setup data to read. Position is reset to the beginning
+    void setData(const char *data, quint32 size);
+
+    bool isSequential() const { return false; }
+    qint64 size() const { return mSize; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+    const char *mData;
+    quint32 mSize;
+};
+
+#endif
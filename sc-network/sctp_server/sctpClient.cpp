@@ -11,6 +11,7 @@
 #include <QTcpSocket>
 #include <QHostAddress>
 #include <QDebug>
+#include <QBuffer>
 
 sctpClient::sctpClient(QObject *parent, int socketDescriptor)
     : QThread(parent)
@@ -66,18 +67,23 @@ void sctpClient::run()
 
 void sctpClient::processCommands()
 {
-    while (mSocket->bytesAvailable() >= mCommand->cmdHeaderSize())
-    {
-        eSctpErrorCode errCode = mCommand->processCommand(mSocket, mSocket);
-        if (errCode != SCTP_NO_ERROR)
-        {
-            qDebug() << "Error: " << errCode << "; while process request from client " << mSocket->peerAddress().toString();
-            sctpStatistic::getInstance()->commandProcessed(true);
-        }else
-        {
-            sctpStatistic::getInstance()->commandProcessed(false);
-        }
+    // read all available data, so pipelined commands are processed as one batch
+    qint64 const available = mSocket->bytesAvailable();
+    if (available <= 0)
+        return;
+
+    qint64 const bytes = mSocket->read(mInput.reserve((quint32)available), available);
+    if (bytes <= 0)
+        return;
+    mInput.commit((quint32)bytes);
+
+    mOutput.resize(0);
+    QBuffer outDevice(&mOutput);
+    outDevice.open(QIODevice::WriteOnly);
 
+    if (mCommand->processCommands(mInput, &outDevice) > 0)
+    {
+        mSocket->write(mOutput);
         mSocket->flush();
     }
 }
@@ -9,6 +9,9 @@
 
 #include <QObject>
 #include <QThread>
+#include <QByteArray>
+
+#include "sctpBuffer.h"
 
 
 class QTcpSocket;
@@ -33,6 +36,11 @@ private:
     sctpCommand *mCommand;
 
     int mSocketDescriptor;
+
+    //! Received data. It's reused between reads, commands are parsed in place
+    sctpBuffer mInput;
+    //! Results of commands, that are received by one read. They are written into socket at once
+    QByteArray mOutput;
     
 signals:
     void done(sctpClient *client);
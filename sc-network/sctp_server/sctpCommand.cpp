@@ -13,6 +13,7 @@
 #include <QDebug>
 #include <QBuffer>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 #include <limits>
 #include <assert.h>
@@ -20,6 +21,15 @@
 
 #define SCTP_READ_TIMEOUT   3000
 
+//! Time in milliseconds, while unused cursor is held by server
+#define SCTP_CURSOR_TTL         60000
+//! Maximum number of opened cursors per connection
+#define SCTP_CURSORS_MAX        64
+//! Maximum number of results in one cursor page
+#define SCTP_CURSOR_PAGE_MAX    65536
+//! Maximum number of operations in one SCTP_CMD_BATCH command
+#define SCTP_BATCH_OPS_MAX      65536
+
 #define READ_PARAM(__val)   if (params->readRawData((char*)&__val, sizeof(__val)) != sizeof(__val)) \
                                   return SCTP_ERROR_CMD_READ_PARAMS;
 
@@ -56,6 +66,8 @@ namespace
 			quint8 m_repl[5];
 			quint8 m_replCount;
 			IterParam m_args[5];
+			//! Position of iterator values in result
+			quint8 m_pos;
 
 			sc_iterator3 *m_it3;
 			sc_iterator5 *m_it5;
@@ -63,6 +75,7 @@ namespace
 			IteratorData()
 				: m_type(SCTP_ITERATOR_COUNT)
 				, m_replCount(0)
+				, m_pos(0)
 				, m_it3(0)
 				, m_it5(0)
 			{
@@ -403,6 +416,14 @@ namespace
 				return false;
 			}
 
+			void setContext(sc_memory_context const * ctx)
+			{
+				if (m_it3)
+					sc_iterator3_set_context(m_it3, ctx);
+				if (m_it5)
+					sc_iterator5_set_context(m_it5, ctx);
+			}
+
 			void copyResults(ScAddrVec & result, quint8 pos) const
 			{
 				quint8 const count = argsCount();
@@ -424,8 +445,55 @@ namespace
 		typedef std::vector<IteratorData> IteratorDataVec;
 		IteratorDataVec m_iterators;
 
+		//! Values of the current result
+		ScAddrVec m_row;
+		//! Index of the deepest started iterator. It's -1 before iteration and after its end
+		qint32 m_level;
+		bool m_started;
+
+		void updatePositions()
+		{
+			quint8 pos = 0;
+			for (size_t i = 0; i < m_iterators.size(); ++i)
+			{
+				m_iterators[i].m_pos = pos;
+				pos += m_iterators[i].argsCount();
+			}
+		}
+
+		void applyReplaces(quint8 itIdx, ScAddrVec const & result)
+		{
+			IteratorData & it = m_iterators[itIdx];
+			if (itIdx == 0)
+				return;
+
+			quint8 count = it.fixedCount();
+			for (quint8 i = 0; i < count; ++i)
+			{
+				quint8 const repl = it.m_repl[i];
+				if (repl == 255)
+					continue;
+
+				Q_ASSERT(repl < it.m_pos);
+				qint8 pos = it.fixedPos(i);
+
+				Q_ASSERT(pos != -1 && pos < it.argsCount());
+				Q_ASSERT(SC_ADDR_IS_NOT_EMPTY(result[repl]));
+				Q_ASSERT(it.m_args[pos].isRepl());
+				Q_ASSERT(!it.m_args[pos].m_param.is_type);
+
+				it.m_args[pos].m_param.addr = result[repl];
+			}
+		}
+
 	public:
 
+		IterConstsr()
+			: m_level(-1)
+			, m_started(false)
+		{
+		}
+
 		bool build(QDataStream *params)
 		{
 			quint8 iterCount;
@@ -448,6 +516,23 @@ namespace
 				it.buildParams(params);
 			}
 
+			updatePositions();
+			return true;
+		}
+
+		//! Build one iterator from params of SCTP_CMD_ITERATE_ELEMENTS command
+		bool buildElements(QDataStream *params)
+		{
+			m_iterators.resize(1);
+			IteratorData & it = m_iterators[0];
+
+			if (params->readRawData((char*)&it.m_type, sizeof(it.m_type)) != sizeof(it.m_type))
+				return false;
+			if (!it.isValidType())
+				return false;
+			it.buildParams(params);
+
+			updatePositions();
 			return true;
 		}
 
@@ -462,53 +547,69 @@ namespace
 			return r;
 		}
 
-		void iterateStep(sc_memory_context const * ctx, ScAddrVec & result, quint8 resultPos, quint8 itIdx)
+		/*! Go to the next result. Iteration can be continued by next call, so it can be
+		 * splitted into several commands
+		 * @returns If there is next result, then returns true and it can be got by row();
+		 * otherwise returns false
+		 */
+		bool next(sc_memory_context const * ctx)
 		{
-			Q_ASSERT(itIdx < m_iterators.size());
-			Q_ASSERT(resultPos < result.size());
+			if (m_iterators.empty())
+				return false;
 
-			IteratorData & it = m_iterators[itIdx];
-			// apply replaces
-			if (itIdx > 0)
+			qint32 const last = (qint32)m_iterators.size() - 1;
+			if (!m_started)
 			{
-				quint8 count = it.fixedCount();
-				for (quint8 i = 0; i < count; ++i)
-				{
-					quint8 const repl = it.m_repl[i];
-					if (repl == 255)
-						continue;
-
-					Q_ASSERT(repl < resultPos);
-					qint8 pos = it.fixedPos(i);
-
-					Q_ASSERT(pos != -1 && pos < it.argsCount());
-					Q_ASSERT(SC_ADDR_IS_NOT_EMPTY(result[repl]));
-					Q_ASSERT(it.m_args[pos].isRepl());
-					Q_ASSERT(!it.m_args[pos].m_param.is_type);
-
-					it.m_args[pos].m_param.addr = result[repl];
-				}
+				m_started = true;
+				m_row.resize(oneResultSize());
+				m_level = 0;
+				m_iterators[0].startIterate(ctx);
 			}
-			it.startIterate(ctx);
 
-			while (it.nextIterate())
+			while (m_level >= 0)
 			{
-				it.copyResults(result, resultPos);
-				if (itIdx == m_iterators.size() - 1)
-					m_results.insert(m_results.end(), result.begin(), result.end());
+				IteratorData & it = m_iterators[m_level];
+				if (it.nextIterate())
+				{
+					it.copyResults(m_row, it.m_pos);
+					if (m_level == last)
+						return true;
+
+					++m_level;
+					applyReplaces(m_level, m_row);
+					m_iterators[m_level].startIterate(ctx);
+				}
 				else
-					iterateStep(ctx, result, resultPos + it.argsCount(), itIdx + 1);
+				{
+					it.stopIterate();
+					--m_level;
+				}
 			}
 
-			it.stopIterate();
+			return false;
 		}
 
-		void iterate(sc_memory_context const * ctx)
+		ScAddrVec const & row() const
 		{
-			ScAddrVec result;
-			result.resize(oneResultSize());
+			return m_row;
+		}
 
-			iterateStep(ctx, result, 0, 0);
+		//! Change memory context of started iterators
+		void setContext(sc_memory_context const * ctx)
+		{
+			for (size_t i = 0; i < m_iterators.size(); ++i)
+				m_iterators[i].setContext(ctx);
+		}
+
+		//! Collects results of iteration. If \p limit isn't 0, then iteration stops, when \p limit results collected
+		void iterate(sc_memory_context const * ctx, quint32 limit = 0)
+		{
+			quint32 count = 0;
+			while ((limit == 0 || count < limit) && next(ctx))
+			{
+				m_results.insert(m_results.end(), m_row.begin(), m_row.end());
+				++count;
+			}
 		}
 
 		bool generateStep(sc_memory_context const * ctx, ScAddrVec & result, quint8 resultPos, quint8 itIdx)
@@ -562,15 +663,51 @@ namespace
 		}
 
 	};
+
+	/*! Reads reference to sc-element of SCTP_CMD_BATCH operation. If reference points to the result
+	 * of operation, that isn't processed yet, then \p addr is empty.
+	 * @returns Returns false, if reference can't be read
+	 */
+	bool readBatchReference(QDataStream *params, std::vector<sc_addr> const & results, sc_addr & addr)
+	{
+		quint8 kind = 0;
+		if (params->readRawData((char*)&kind, sizeof(kind)) != sizeof(kind))
+			return false;
+
+		SC_ADDR_MAKE_EMPTY(addr);
+		if (kind == SCTP_BATCH_REF_ADDR)
+			return params->readRawData((char*)&addr, sizeof(addr)) == sizeof(addr);
+
+		quint32 index = 0;
+		if (kind != SCTP_BATCH_REF_INDEX || params->readRawData((char*)&index, sizeof(index)) != sizeof(index))
+			return false;
+
+		if (index < results.size())
+			addr = results[index];
+
+		return true;
+	}
 }
 
 
+//! Iteration, that is continued by SCTP_CMD_CURSOR_NEXT commands of the same connection
+class sctpCursor
+{
+public:
+    IterConstsr iterator;
+    //! Measures time since the last access. Cursor is destroyed, when it isn't used during SCTP_CURSOR_TTL
+    QElapsedTimer accessTimer;
+};
+
 // -----------------------------
 
 sctpCommand::sctpCommand(QObject *parent)
     : QObject(parent)
     , mSendEventsCount(0)
+    , mLastCursorId(0)
     , mContext(0)
+    , mOwnContext(false)
+    , mParamsStream(&mParamsDevice)
 {
 }
 
@@ -581,6 +718,13 @@ sctpCommand::~sctpCommand()
 void sctpCommand::init()
 {
     mContext = sc_memory_context_new(sc_access_lvl_make_min);
+    mOwnContext = true;
+}
+
+void sctpCommand::setContext(sc_memory_context *ctx)
+{
+    Q_ASSERT(!mOwnContext);
+    mContext = ctx;
 }
 
 void sctpCommand::shutdown()
@@ -590,8 +734,27 @@ void sctpCommand::shutdown()
         sctpEventManager::getSingleton()->destroyEvent(*it);
     mEventsSet.clear();
 
-    sc_memory_context_free(mContext);
+    // iterators of cursors use context to unlock elements, so in asynchronous mode
+    // temporary context is created
+    if (!mCursors.empty())
+    {
+        sc_memory_context *ctx = mContext ? mContext : sc_memory_context_new(sc_access_lvl_make_min);
+        tCursorsMap::iterator itCursor, itCursorEnd = mCursors.end();
+        for (itCursor = mCursors.begin(); itCursor != itCursorEnd; ++itCursor)
+        {
+            itCursor->second->iterator.setContext(ctx);
+            delete itCursor->second;
+        }
+        mCursors.clear();
+
+        if (ctx != mContext)
+            sc_memory_context_free(ctx);
+    }
+
+    if (mOwnContext)
+        sc_memory_context_free(mContext);
     mContext = 0;
+    mOwnContext = false;
 }
 
 eSctpErrorCode sctpCommand::processCommand(QIODevice *inDevice, QIODevice *outDevice)
@@ -618,64 +781,138 @@ eSctpErrorCode sctpCommand::processCommand(QIODevice *inDevice, QIODevice *outDe
     inDevice->read((char*)paramsData.data(), paramsData.size());
     QDataStream paramsStream(paramsData);
 
+    return dispatchCommand(cmdCode, cmdFlags, cmdId, &paramsStream, outDevice);
+}
+
+eSctpErrorCode sctpCommand::processCommand(const char *data, quint32 size, QIODevice *outDevice)
+{
+    Q_ASSERT(cmdFrameSize(data, size) == size);
+
+    quint8 cmdCode = (quint8)data[0];
+    quint8 cmdFlags = (quint8)data[1];
+    quint32 cmdId = 0;
+    memcpy(&cmdId, data + 2 * sizeof(quint8), sizeof(cmdId));
+
+    // params are read directly from received data
+    mParamsDevice.setData(data + cmdHeaderSize(), size - cmdHeaderSize());
+    mParamsStream.resetStatus();
+
+    return dispatchCommand(cmdCode, cmdFlags, cmdId, &mParamsStream, outDevice);
+}
+
+quint32 sctpCommand::processCommands(sctpBuffer &input, QIODevice *outDevice)
+{
+    quint32 count = 0;
+    quint32 frameSize = 0;
+
+    expireCursors();
+
+    while ((frameSize = cmdFrameSize(input.data(), input.size())) > 0)
+    {
+        eSctpErrorCode errCode = processCommand(input.data(), frameSize, outDevice);
+        if (errCode != SCTP_NO_ERROR)
+        {
+            qDebug() << "Error: " << errCode << "; while process command";
+            sctpStatistic::getInstance()->commandProcessed(true);
+        }else
+        {
+            sctpStatistic::getInstance()->commandProcessed(false);
+        }
+
+        input.consume(frameSize);
+        ++count;
+    }
+
+    return count;
+}
+
+quint32 sctpCommand::cmdFrameSize(const char *data, quint32 size)
+{
+    if (size < cmdHeaderSize())
+        return 0;
+
+    quint32 cmdParamSize = 0;
+    memcpy(&cmdParamSize, data + 2 * sizeof(quint8) + sizeof(quint32), sizeof(cmdParamSize));
+
+    // don't overflow on broken size
+    if (cmdParamSize > size - cmdHeaderSize())
+        return 0;
+
+    return cmdHeaderSize() + cmdParamSize;
+}
+
+eSctpErrorCode sctpCommand::dispatchCommand(quint8 cmdCode, quint8 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
     switch (cmdCode)
     {
     case SCTP_CMD_CHECK_ELEMENT:
-        return processCheckElement(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processCheckElement(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_GET_ELEMENT_TYPE:
-        return processGetElementType(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processGetElementType(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_ERASE_ELEMENT:
-        return processElementErase(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processElementErase(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_CREATE_NODE:
-        return processCreateNode(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processCreateNode(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_CREATE_LINK:
-        return processCreateLink(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processCreateLink(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_CREATE_ARC:
-        return processCreateArc(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processCreateArc(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_GET_ARC:
-        return processGetArc(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processGetArc(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_GET_LINK_CONTENT:
-        return processGetLinkContent(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processGetLinkContent(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_FIND_LINKS:
-        return processFindLinks(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processFindLinks(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_SET_LINK_CONTENT:
-        return processSetLinkContent(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processSetLinkContent(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_ITERATE_ELEMENTS:
-        return processIterateElements(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processIterateElements(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_ITERATE_CONSTRUCTION:
-        return processIterateConstruction(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processIterateConstruction(cmdFlags, cmdId, params, outDevice);
 
 	case SCTP_CMD_GENERATE_CONSTRUCTION:
-		return processGenerateConstruction(cmdFlags, cmdId, &paramsStream, outDevice);
+		return processGenerateConstruction(cmdFlags, cmdId, params, outDevice);
+
+    case SCTP_CMD_BATCH:
+        return processBatch(cmdFlags, cmdId, params, outDevice);
+
+    case SCTP_CMD_CURSOR_OPEN:
+        return processCursorOpen(cmdFlags, cmdId, params, outDevice);
+
+    case SCTP_CMD_CURSOR_NEXT:
+        return processCursorNext(cmdFlags, cmdId, params, outDevice);
+
+    case SCTP_CMD_CURSOR_CLOSE:
+        return processCursorClose(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_EVENT_CREATE:
-        return processCreateEvent(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processCreateEvent(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_EVENT_DESTROY:
-        return processDestroyEvent(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processDestroyEvent(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_EVENT_EMIT:
-        return processEmitEvent(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processEmitEvent(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_FIND_ELEMENT_BY_SYSITDF:
-        return processFindElementBySysIdtf(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processFindElementBySysIdtf(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_SET_SYSIDTF:
-        return processSetSysIdtf(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processSetSysIdtf(cmdFlags, cmdId, params, outDevice);
 
     case SCTP_CMD_STATISTICS:
-        return processStatistics(cmdFlags, cmdId, &paramsStream, outDevice);
+        return processStatistics(cmdFlags, cmdId, params, outDevice);
 
     default:
         return SCTP_ERROR_UNKNOWN_CMD;
@@ -700,14 +937,15 @@ bool sctpCommand::waitAvailableBytes(QIODevice *stream, quint32 bytesNum)
 void sctpCommand::writeResultHeader(eSctpCommandCode cmdCode, quint32 cmdId, eSctpResultCode resCode, quint32 resSize, QIODevice *outDevice)
 {
     Q_ASSERT(outDevice != 0);
-    quint8 code = cmdCode;
 
-    outDevice->write((const char*)&code, sizeof(code));
-    outDevice->write((const char*)&cmdId, sizeof(cmdId));
+    // header is written by one call, because each write into socket is a system call
+    char header[2 * sizeof(quint8) + 2 * sizeof(quint32)];
+    header[0] = (char)cmdCode;
+    memcpy(header + sizeof(quint8), &cmdId, sizeof(cmdId));
+    header[sizeof(quint8) + sizeof(quint32)] = (char)resCode;
+    memcpy(header + 2 * sizeof(quint8) + sizeof(quint32), &resSize, sizeof(resSize));
 
-    code = resCode;
-    outDevice->write((const char*)&code, sizeof(code));
-    outDevice->write((const char*)&resSize, sizeof(resSize));
+    outDevice->write(header, sizeof(header));
 }
 
 quint32 sctpCommand::cmdHeaderSize()
@@ -1201,9 +1439,15 @@ eSctpErrorCode sctpCommand::processIterateElements(quint32 cmdFlags, quint32 cmd
 eSctpErrorCode sctpCommand::processIterateConstruction(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
 {
     IterConstsr constr;
-    if (constr.build(params))
+    quint32 limit = 0;
+    bool built = constr.build(params);
+    if (built && (cmdFlags & SCTP_ITERATE_FLAG_LIMIT))
+        built = params->readRawData((char*)&limit, sizeof(limit)) == sizeof(limit);
+
+    if (built)
     {
-        constr.iterate(mContext);
+        // iteration stops on limit, so client, that needs just existence or the first results, doesn't wait for all of them
+        constr.iterate(mContext, limit);
         quint8 stride = constr.oneResultSize();
         IterConstsr::ScAddrVec const & result = constr.result();
         Q_ASSERT(result.size() % stride == 0);
@@ -1246,6 +1490,249 @@ eSctpErrorCode sctpCommand::processGenerateConstruction(quint32 cmdFlags, quint3
 	return SCTP_NO_ERROR;
 }
 
+eSctpErrorCode sctpCommand::processBatch(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    quint32 count = 0;
+
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
+
+    READ_PARAM(count);
+    if (count > SCTP_BATCH_OPS_MAX)
+        return SCTP_ERROR_CMD_READ_PARAMS;
+
+    // result of each operation is stored by its index, so next operations can refer to it
+    std::vector<sc_addr> results;
+    results.reserve(count);
+    std::vector<sc_addr> created;
+    std::vector<sc_char> content;
+
+    bool paramsRead = true;
+    for (quint32 i = 0; i < count && paramsRead; ++i)
+    {
+        quint8 op = 0;
+        sc_type type = 0;
+        sc_addr addr, begin_addr, end_addr;
+        quint32 data_len = 0;
+
+        SC_ADDR_MAKE_EMPTY(addr);
+        paramsRead = params->readRawData((char*)&op, sizeof(op)) == sizeof(op);
+
+        switch (paramsRead ? op : 0xff)
+        {
+        case SCTP_BATCH_CREATE_NODE:
+            paramsRead = params->readRawData((char*)&type, sizeof(type)) == sizeof(type);
+            if (paramsRead)
+                addr = sc_memory_node_new(mContext, type);
+            break;
+
+        case SCTP_BATCH_CREATE_LINK:
+            addr = sc_memory_link_new(mContext);
+            break;
+
+        case SCTP_BATCH_CREATE_ARC:
+            paramsRead = params->readRawData((char*)&type, sizeof(type)) == sizeof(type)
+                    && readBatchReference(params, results, begin_addr)
+                    && readBatchReference(params, results, end_addr);
+            if (paramsRead && SC_ADDR_IS_NOT_EMPTY(begin_addr) && SC_ADDR_IS_NOT_EMPTY(end_addr))
+                addr = sc_memory_arc_new(mContext, type, begin_addr, end_addr);
+            break;
+
+        case SCTP_BATCH_SET_LINK_CONTENT:
+            paramsRead = readBatchReference(params, results, begin_addr)
+                    && params->readRawData((char*)&data_len, sizeof(data_len)) == sizeof(data_len)
+                    && data_len <= params->device()->bytesAvailable(); // content can't be longer than rest of params
+            if (paramsRead)
+            {
+                content.resize(data_len);
+                paramsRead = data_len == 0 || params->readRawData(content.data(), data_len) == (int)data_len;
+            }
+            if (paramsRead && SC_ADDR_IS_NOT_EMPTY(begin_addr))
+            {
+                sc_stream *stream = sc_stream_memory_new(content.data(), data_len, SC_STREAM_FLAG_READ, SC_FALSE);
+                if (sc_memory_set_link_content(mContext, begin_addr, stream) == SC_RESULT_OK)
+                    addr = begin_addr;
+                sc_stream_free(stream);
+            }
+            break;
+
+        default:
+            paramsRead = false;
+            break;
+        }
+
+        if (!paramsRead || SC_ADDR_IS_EMPTY(addr))
+            break;
+
+        if (op != SCTP_BATCH_SET_LINK_CONTENT)
+            created.push_back(addr);
+        results.push_back(addr);
+    }
+
+    if (results.size() == count)
+    {
+        quint32 const byteSize = sizeof(sc_addr) * count;
+        writeResultHeader(SCTP_CMD_BATCH, cmdId, SCTP_RESULT_OK, byteSize, outDevice);
+        outDevice->write((const char *)results.data(), byteSize);
+        return SCTP_NO_ERROR;
+    }
+
+    /* batch is applied completely or not at all, so created sc-elements are erased in reverse order
+     * (sc-arcs are erased with their begin or end elements). Changed content of existing sc-links
+     * isn't restored
+     */
+    for (std::vector<sc_addr>::reverse_iterator it = created.rbegin(); it != created.rend(); ++it)
+    {
+        if (sc_memory_is_element(mContext, *it))
+            sc_memory_element_free(mContext, *it);
+    }
+
+    if (!paramsRead)
+        return SCTP_ERROR_CMD_READ_PARAMS;
+
+    // result contains index of failed operation
+    quint32 const failed = (quint32)results.size();
+    writeResultHeader(SCTP_CMD_BATCH, cmdId, SCTP_RESULT_FAIL, sizeof(failed), outDevice);
+    outDevice->write((const char *)&failed, sizeof(failed));
+
+    return SCTP_NO_ERROR;
+}
+
+eSctpErrorCode sctpCommand::processCursorOpen(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    quint8 iterateCmd = 0;
+    quint32 pageSize = 0;
+
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
+
+    READ_PARAM(iterateCmd);
+    READ_PARAM(pageSize);
+
+    sctpCursor *cursor = new sctpCursor();
+    bool built = false;
+    if (iterateCmd == SCTP_CMD_ITERATE_ELEMENTS)
+        built = cursor->iterator.buildElements(params);
+    else if (iterateCmd == SCTP_CMD_ITERATE_CONSTRUCTION)
+        built = cursor->iterator.build(params);
+
+    if (!built || pageSize == 0 || pageSize > SCTP_CURSOR_PAGE_MAX || mCursors.size() >= SCTP_CURSORS_MAX)
+    {
+        delete cursor;
+        writeResultHeader(SCTP_CMD_CURSOR_OPEN, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return built ? SCTP_NO_ERROR : SCTP_ERROR_CMD_READ_PARAMS;
+    }
+
+    // zero id is returned, when there are no more results
+    do
+    {
+        ++mLastCursorId;
+    } while (mLastCursorId == 0 || mCursors.find(mLastCursorId) != mCursors.end());
+
+    mCursors[mLastCursorId] = cursor;
+    writeCursorPage(SCTP_CMD_CURSOR_OPEN, cmdId, mLastCursorId, pageSize, outDevice);
+
+    return SCTP_NO_ERROR;
+}
+
+eSctpErrorCode sctpCommand::processCursorNext(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    quint32 cursorId = 0;
+    quint32 pageSize = 0;
+
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
+
+    READ_PARAM(cursorId);
+    READ_PARAM(pageSize);
+
+    if (mCursors.find(cursorId) == mCursors.end() || pageSize == 0 || pageSize > SCTP_CURSOR_PAGE_MAX)
+    {
+        writeResultHeader(SCTP_CMD_CURSOR_NEXT, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_NO_ERROR;
+    }
+
+    writeCursorPage(SCTP_CMD_CURSOR_NEXT, cmdId, cursorId, pageSize, outDevice);
+
+    return SCTP_NO_ERROR;
+}
+
+eSctpErrorCode sctpCommand::processCursorClose(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    quint32 cursorId = 0;
+
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
+
+    READ_PARAM(cursorId);
+
+    tCursorsMap::iterator it = mCursors.find(cursorId);
+    if (it == mCursors.end())
+    {
+        writeResultHeader(SCTP_CMD_CURSOR_CLOSE, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_NO_ERROR;
+    }
+
+    destroyCursor(it);
+    writeResultHeader(SCTP_CMD_CURSOR_CLOSE, cmdId, SCTP_RESULT_OK, 0, outDevice);
+
+    return SCTP_NO_ERROR;
+}
+
+void sctpCommand::writeCursorPage(eSctpCommandCode cmdCode, quint32 cmdId, quint32 cursorId, quint32 pageSize, QIODevice *outDevice)
+{
+    tCursorsMap::iterator it = mCursors.find(cursorId);
+    Q_ASSERT(it != mCursors.end());
+
+    sctpCursor *cursor = it->second;
+    // cursor could be opened by another worker
+    cursor->iterator.setContext(mContext);
+
+    // only one page is stored, so memory doesn't depend on number of results
+    IterConstsr::ScAddrVec page;
+    quint32 count = 0;
+    while (count < pageSize && cursor->iterator.next(mContext))
+    {
+        IterConstsr::ScAddrVec const & row = cursor->iterator.row();
+        page.insert(page.end(), row.begin(), row.end());
+        ++count;
+    }
+
+    // cursor is closed, when all results are returned
+    if (count < pageSize)
+    {
+        destroyCursor(it);
+        cursorId = 0;
+    }
+    else
+        cursor->accessTimer.start();
+
+    quint32 const dataSize = sizeof(sc_addr) * (quint32)page.size();
+    writeResultHeader(cmdCode, cmdId, SCTP_RESULT_OK, 2 * sizeof(quint32) + dataSize, outDevice);
+    outDevice->write((const char*)&cursorId, sizeof(cursorId));
+    outDevice->write((const char*)&count, sizeof(count));
+    if (dataSize > 0)
+        outDevice->write((const char*)page.data(), dataSize);
+}
+
+void sctpCommand::destroyCursor(tCursorsMap::iterator it)
+{
+    it->second->iterator.setContext(mContext);
+    delete it->second;
+    mCursors.erase(it);
+}
+
+void sctpCommand::expireCursors()
+{
+    tCursorsMap::iterator it = mCursors.begin();
+    while (it != mCursors.end())
+    {
+        tCursorsMap::iterator current = it++;
+        if (current->second->accessTimer.hasExpired(SCTP_CURSOR_TTL))
+            destroyCursor(current);
+    }
+}
+
 eSctpErrorCode sctpCommand::processCreateEvent(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
 {
     sc_uint8 event_type;
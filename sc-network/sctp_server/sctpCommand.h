@@ -10,13 +10,17 @@
 #include <QObject>
 #include <QMutex>
 #include <QByteArray>
+#include <QDataStream>
 
 #include <set>
+#include <map>
 
 #include "../sctp_client/sctpTypes.hpp"
+#include "sctpBuffer.h"
 
 
 class QIODevice;
+class sctpCursor;
 
 /*! Base class for sctp commands.
  * It provide command packing/unpacking to binary data.
@@ -34,15 +38,51 @@ public:
     virtual ~sctpCommand();
 
 
+    //! Creates own memory context, that is used to process commands
     void init();
     void shutdown();
 
+    /*! Setup memory context, that is used to process next commands. It isn't freed on shutdown.
+     * Worker pool of asynchronous server uses it, because each worker has its own context
+     */
+    void setContext(sc_memory_context *ctx);
+
     /*! Read and process command from buffer
      * @param inDevice Pointer to device for input data reading
      * @param outDevice Pointer to device for output data writing
      */
     eSctpErrorCode processCommand(QIODevice *inDevice, QIODevice *outDevice);
 
+    /*! Process command, that is stored in memory. It doesn't wait for any data
+     * @param data Pointer to command data (header and params)
+     * @param size Size of command data. It must be equal to value returned by cmdFrameSize
+     * @param outDevice Pointer to device for output data writing
+     */
+    eSctpErrorCode processCommand(const char *data, quint32 size, QIODevice *outDevice);
+
+    /*! Process all complete commands from received data. Params are read in place, and
+     * processed commands are consumed from \p input. Incomplete command stays in \p input
+     * until the rest of it would be received.
+     * @param input Buffer of received data
+     * @param outDevice Pointer to device for output data writing. Results of all commands
+     * are written there, so they can be sent by one call
+     * @returns Number of processed commands
+     */
+    quint32 processCommands(sctpBuffer &input, QIODevice *outDevice);
+
+    /*! Non-blocking parser of received data
+     * @param data Pointer to received data, that starts with command header
+     * @param size Size of received data
+     * @returns If \p data contains complete command, then returns its size (header and params);
+     * otherwise returns 0
+     */
+    static quint32 cmdFrameSize(const char *data, quint32 size);
+
+    /*! Destroys cursors, that weren't used during SCTP_CURSOR_TTL. It's called before processing of received
+     * commands, and asynchronous server calls it for idle connections too. Memory context must be set
+     */
+    void expireCursors();
+
     /*! Wait while specified number of bytes will be available in specified data stream
      * @param stream Pointer to data stream to wait available bytes
      * @param bytesNum Number of waiting bytes
@@ -63,6 +103,9 @@ public:
     static quint32 cmdHeaderSize();
     
 protected:
+    //! Calls processing function of specified command
+    eSctpErrorCode dispatchCommand(quint8 cmdCode, quint8 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+
     //! Type of command processing function
     typedef eSctpErrorCode (*fProcessCommand)(quint8 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
 
@@ -83,6 +126,15 @@ private:
     eSctpErrorCode processIterateElements(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
     eSctpErrorCode processIterateConstruction(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
 	eSctpErrorCode processGenerateConstruction(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    /*! Applies operations of batch in one pass. If any operation fails, then sc-elements created by
+     * the batch are erased and result contains index of failed operation
+     */
+    eSctpErrorCode processBatch(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+
+    // cursors
+    eSctpErrorCode processCursorOpen(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    eSctpErrorCode processCursorNext(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    eSctpErrorCode processCursorClose(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
 
     // events
     eSctpErrorCode processCreateEvent(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
@@ -108,8 +160,26 @@ private:
     typedef std::set<tEventId> tEventsSet;
     tEventsSet mEventsSet;
 
+    //! Map of opened cursors by their id
+    typedef std::map<quint32, sctpCursor*> tCursorsMap;
+    tCursorsMap mCursors;
+    //! Id of the last opened cursor
+    quint32 mLastCursorId;
+
+    /*! Writes next page of cursor results. If there are no more results, then cursor is destroyed
+     * and zero cursor id is written
+     */
+    void writeCursorPage(eSctpCommandCode cmdCode, quint32 cmdId, quint32 cursorId, quint32 pageSize, QIODevice *outDevice);
+    void destroyCursor(tCursorsMap::iterator it);
+
     //! Memory context
     sc_memory_context *mContext;
+    //! Flag, that is true, when memory context was created by init
+    bool mOwnContext;
+
+    //! Device and stream, that are reused to read params of received commands without copying
+    sctpParamsDevice mParamsDevice;
+    QDataStream mParamsStream;
 
 signals:
     
@@ -0,0 +1,430 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sctpReactor.h"
+#include "sctpWorkerPool.h"
+#include "sctpCommand.h"
+#include "sctpStatistic.h"
+#include "sc_memory.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define SCTP_REACTOR_MAX_EVENTS     256
+#define SCTP_REACTOR_READ_SIZE      65536
+#define SCTP_REACTOR_INPUT_MAX      (4 * 1024 * 1024)   // received data, after that socket isn't read until commands are processed
+#define SCTP_REACTOR_EXPIRE_PERIOD  10000               // period (ms) of cursors expiration for idle connections
+
+sctpReactor::sctpReactor(sctpWorkerPool *workerPool, QObject *parent)
+    : QThread(parent)
+    , mWorkerPool(workerPool)
+    , mEpoll(-1)
+    , mWakeUp(-1)
+    , mIsRunning(0)
+    , mContext(0)
+{
+}
+
+sctpReactor::~sctpReactor()
+{
+    Q_ASSERT(mConnections.isEmpty());
+}
+
+bool sctpReactor::initialize()
+{
+    mEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (mEpoll < 0)
+    {
+        qCritical() << "Can't create epoll instance: " << strerror(errno);
+        return false;
+    }
+
+    mWakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mWakeUp < 0)
+    {
+        qCritical() << "Can't create event descriptor: " << strerror(errno);
+        return false;
+    }
+
+    // null pointer in event data designates wake up
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = 0;
+    if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeUp, &event) != 0)
+    {
+        qCritical() << "Can't listen event descriptor: " << strerror(errno);
+        return false;
+    }
+
+    mIsRunning = 1;
+    start();
+
+    return true;
+}
+
+void sctpReactor::stop()
+{
+    mIsRunning = 0;
+    wakeUp();
+    wait();
+}
+
+void sctpReactor::shutdown()
+{
+    Q_ASSERT(!isRunning());
+
+    // sockets, that weren't served
+    mPendingMutex.lock();
+    for (QList<int>::iterator it = mPendingSockets.begin(); it != mPendingSockets.end(); ++it)
+        ::close(*it);
+    mPendingSockets.clear();
+    mProcessed.clear();
+    mPendingMutex.unlock();
+
+    // workers are stopped, so connections aren't processed anymore
+    QList<sctpConnection*> connections = mConnections.toList();
+    for (QList<sctpConnection*>::iterator it = connections.begin(); it != connections.end(); ++it)
+    {
+        (*it)->busy = false;
+        closeConnection(*it);
+    }
+    destroyClosed();
+
+    if (mWakeUp >= 0)
+        ::close(mWakeUp);
+    if (mEpoll >= 0)
+        ::close(mEpoll);
+    mWakeUp = mEpoll = -1;
+}
+
+void sctpReactor::addConnection(int socketDescriptor)
+{
+    mPendingMutex.lock();
+    mPendingSockets.append(socketDescriptor);
+    mPendingMutex.unlock();
+
+    wakeUp();
+}
+
+void sctpReactor::processed(sctpConnection *connection)
+{
+    mPendingMutex.lock();
+    mProcessed.append(connection);
+    mPendingMutex.unlock();
+
+    wakeUp();
+}
+
+void sctpReactor::run()
+{
+    epoll_event events[SCTP_REACTOR_MAX_EVENTS];
+    QElapsedTimer expireTimer;
+
+    mContext = sc_memory_context_new(sc_access_lvl_make_min);
+    expireTimer.start();
+
+    while (mIsRunning.load() != 0)
+    {
+        // wait is interrupted to expire cursors of idle connections
+        qint64 const timeout = qMax<qint64>(0, SCTP_REACTOR_EXPIRE_PERIOD - expireTimer.elapsed());
+        int count = epoll_wait(mEpoll, events, SCTP_REACTOR_MAX_EVENTS, (int)timeout);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            qCritical() << "Error while waiting for socket events: " << strerror(errno);
+            break;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.ptr == 0)
+            {
+                quint64 value = 0;
+                if (::read(mWakeUp, &value, sizeof(value)) < 0 && errno != EAGAIN)
+                    qWarning() << "Can't read event descriptor: " << strerror(errno);
+
+                acceptPending();
+                handleProcessed();
+                continue;
+            }
+
+            sctpConnection *connection = (sctpConnection*)events[i].data.ptr;
+            // connection was closed by previous event in this iteration
+            if (connection->socket < 0)
+                continue;
+
+            // socket, that was closed for reading, is just flushed, and its errors are reported by send
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !connection->readClosed)
+                handleRead(connection);
+            if (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+                handleWrite(connection);
+
+            if (isFinished(connection))
+                closeConnection(connection);
+        }
+
+        destroyClosed();
+
+        if (expireTimer.hasExpired(SCTP_REACTOR_EXPIRE_PERIOD))
+        {
+            expireCursors();
+            expireTimer.restart();
+        }
+    }
+
+    sc_memory_context_free(mContext);
+    mContext = 0;
+}
+
+void sctpReactor::wakeUp()
+{
+    quint64 value = 1;
+    if (::write(mWakeUp, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        qWarning() << "Can't write event descriptor: " << strerror(errno);
+}
+
+void sctpReactor::acceptPending()
+{
+    QList<int> sockets;
+    mPendingMutex.lock();
+    sockets.swap(mPendingSockets);
+    mPendingMutex.unlock();
+
+    for (QList<int>::iterator it = sockets.begin(); it != sockets.end(); ++it)
+    {
+        int const socket = *it;
+        int flag = 1;
+
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+        sctpConnection *connection = new sctpConnection();
+        connection->socket = socket;
+        connection->command = new sctpCommand();
+        connection->reactor = this;
+        connection->busy = false;
+        connection->closed = false;
+        connection->readClosed = false;
+        connection->writing = false;
+        connection->events = EPOLLIN | EPOLLRDHUP;
+
+        epoll_event event;
+        event.events = connection->events;
+        event.data.ptr = connection;
+        if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, socket, &event) != 0)
+        {
+            qWarning() << "Can't listen socket " << socket << ": " << strerror(errno);
+            ::close(socket);
+            delete connection->command;
+            delete connection;
+            continue;
+        }
+
+        mConnections.insert(connection);
+        sctpStatistic::getInstance()->clientConnected();
+    }
+}
+
+void sctpReactor::handleProcessed()
+{
+    QList<sctpConnection*> connections;
+    mPendingMutex.lock();
+    connections.swap(mProcessed);
+    mPendingMutex.unlock();
+
+    for (QList<sctpConnection*>::iterator it = connections.begin(); it != connections.end(); ++it)
+    {
+        sctpConnection *connection = *it;
+        Q_ASSERT(connection->busy);
+        connection->busy = false;
+
+        handleWrite(connection);
+        schedule(connection);
+        updateEvents(connection);
+
+        if (isFinished(connection))
+            closeConnection(connection);
+    }
+}
+
+void sctpReactor::handleRead(sctpConnection *connection)
+{
+    while (true)
+    {
+        // data is received directly into connection buffer, that is parsed in place by worker
+        QMutexLocker locker(&connection->mutex);
+
+        /* buffer isn't grown after complete command, so client, that sends commands faster than they are processed,
+         * is limited by socket buffers. Incomplete command is received whole, like in thread per connection mode
+         */
+        if (connection->input.size() >= SCTP_REACTOR_INPUT_MAX &&
+            sctpCommand::cmdFrameSize(connection->input.data(), connection->input.size()) > 0)
+            break;
+
+        ssize_t bytes = ::recv(connection->socket, connection->input.reserve(SCTP_REACTOR_READ_SIZE), SCTP_REACTOR_READ_SIZE, 0);
+        if (bytes > 0)
+        {
+            connection->input.commit((quint32)bytes);
+            continue;
+        }
+        int const error = errno;
+        locker.unlock();
+
+        if (bytes < 0 && error == EINTR)
+            continue;
+
+        /* client finished sending, but it can still wait for results, so socket isn't read anymore and
+         * connection is closed, when results of received commands are sent
+         */
+        if (bytes == 0)
+            connection->readClosed = true;
+        else if (error != EAGAIN && error != EWOULDBLOCK)
+            connection->closed = true;
+
+        break;
+    }
+
+    // level-triggered events are reported until socket is closed, so it isn't listened anymore.
+    // Commands, that were received before, are processed
+    if (connection->closed)
+        epoll_ctl(mEpoll, EPOLL_CTL_DEL, connection->socket, 0);
+
+    schedule(connection);
+    updateEvents(connection);
+}
+
+void sctpReactor::handleWrite(sctpConnection *connection)
+{
+    QMutexLocker locker(&connection->mutex);
+
+    int sent = 0;
+    while (sent < connection->output.size())
+    {
+        ssize_t bytes = ::send(connection->socket, connection->output.constData() + sent, connection->output.size() - sent, MSG_NOSIGNAL);
+        if (bytes > 0)
+        {
+            sent += (int)bytes;
+            continue;
+        }
+
+        if (bytes < 0 && errno == EINTR)
+            continue;
+
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        connection->closed = true;
+        break;
+    }
+
+    if (connection->closed)
+        connection->output.clear();
+    else if (sent > 0)
+        connection->output.remove(0, sent);
+
+    // listen for socket writing, while there are results to send
+    connection->writing = !connection->output.isEmpty();
+    locker.unlock();
+
+    updateEvents(connection);
+}
+
+void sctpReactor::schedule(sctpConnection *connection)
+{
+    if (connection->busy)
+        return;
+
+    connection->mutex.lock();
+    bool const hasCommand = sctpCommand::cmdFrameSize(connection->input.data(), connection->input.size()) > 0;
+    connection->mutex.unlock();
+
+    if (hasCommand)
+    {
+        connection->busy = true;
+        mWorkerPool->push(connection);
+    }
+}
+
+void sctpReactor::updateEvents(sctpConnection *connection)
+{
+    if (connection->closed)
+        return;
+
+    /* socket isn't read while connection is processed by worker, so received data doesn't grow without limit.
+     * Closed socket is still reported by EPOLLHUP, and EPOLLRDHUP isn't listened, because it's level-triggered too
+     */
+    quint32 const events = ((connection->busy || connection->readClosed) ? 0 : (EPOLLIN | EPOLLRDHUP)) | (connection->writing ? EPOLLOUT : 0);
+    if (events == connection->events)
+        return;
+
+    connection->events = events;
+
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+    epoll_ctl(mEpoll, EPOLL_CTL_MOD, connection->socket, &event);
+}
+
+bool sctpReactor::isFinished(sctpConnection *connection) const
+{
+    if (connection->busy)
+        return false;
+
+    // not busy connection has no complete commands, so half-closed one waits just for sending
+    return connection->closed || (connection->readClosed && !connection->writing);
+}
+
+void sctpReactor::closeConnection(sctpConnection *connection)
+{
+    Q_ASSERT(!connection->busy);
+    if (connection->socket < 0)
+        return;
+
+    epoll_ctl(mEpoll, EPOLL_CTL_DEL, connection->socket, 0);
+    ::close(connection->socket);
+    connection->socket = -1;
+
+    mConnections.remove(connection);
+    mClosed.append(connection);
+}
+
+void sctpReactor::expireCursors()
+{
+    for (QSet<sctpConnection*>::iterator it = mConnections.begin(); it != mConnections.end(); ++it)
+    {
+        sctpConnection *connection = *it;
+        // command is used by worker, that expires cursors by itself
+        if (connection->busy)
+            continue;
+
+        connection->command->setContext(mContext);
+        connection->command->expireCursors();
+        connection->command->setContext(0);
+    }
+}
+
+void sctpReactor::destroyClosed()
+{
+    for (QList<sctpConnection*>::iterator it = mClosed.begin(); it != mClosed.end(); ++it)
+    {
+        sctpConnection *connection = *it;
+        connection->command->shutdown();
+        delete connection->command;
+        delete connection;
+    }
+    mClosed.clear();
+}
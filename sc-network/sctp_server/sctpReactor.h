@@ -0,0 +1,136 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sctpReactor_h_
+#define _sctpReactor_h_
+
+#include <QThread>
+#include <QMutex>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QList>
+#include <QSet>
+
+#include "sctpBuffer.h"
+#include "../sctp_client/sctpTypes.hpp"
+
+class sctpCommand;
+class sctpReactor;
+class sctpWorkerPool;
+
+/*! Client connection of asynchronous server. Data is received and sent by reactor thread,
+ * and commands are processed by worker pool.
+ */
+struct sctpConnection
+{
+    //! Client socket descriptor
+    int socket;
+    //! Command processor, that stores client state (events)
+    sctpCommand *command;
+    //! Reactor, that serves connection
+    sctpReactor *reactor;
+
+    //! Mutex to synchronize buffers between reactor and worker
+    QMutex mutex;
+    //! Received data, that isn't processed yet. Reactor receives data directly there
+    sctpBuffer input;
+    //! Results of processed commands, that aren't sent yet
+    QByteArray output;
+
+    //! Commands, that are processed by worker. Buffer is exchanged with input, so both are reused. Used by worker only
+    sctpBuffer processing;
+    //! Results, that are written by worker. Used by worker only
+    QByteArray replies;
+
+    //! Flag, that is true while connection is queued or processed by worker. Used by reactor thread only
+    bool busy;
+    //! Flag, that is true when socket error occurred or connection is finished. Used by reactor thread only
+    bool closed;
+    //! Flag, that is true when client finished sending (half-closed connection). Results are still sent. Used by reactor thread only
+    bool readClosed;
+    //! Flag, that is true while reactor waits until socket is ready for writing. Used by reactor thread only
+    bool writing;
+    //! Events, that are listened by epoll for socket. Used by reactor thread only
+    quint32 events;
+};
+
+/*! Event loop, that multiplexes client sockets with epoll. Reactor reads received data without blocking
+ * and pushes connections with complete commands into worker pool. Results are sent, when worker finished.
+ * Asynchronous server starts one reactor per processor core.
+ */
+class sctpReactor : public QThread
+{
+    Q_OBJECT
+public:
+    explicit sctpReactor(sctpWorkerPool *workerPool, QObject *parent = 0);
+    virtual ~sctpReactor();
+
+    //! Creates epoll instance. Returns false, if it's not supported
+    bool initialize();
+    //! Stops reactor thread. Connections stay opened, until shutdown call
+    void stop();
+    //! Closes all connections. It must be called, when worker pool is stopped
+    void shutdown();
+
+    //! Appends accepted client socket. It can be called from any thread
+    void addConnection(int socketDescriptor);
+    //! Notify reactor, that worker finished processing of connection commands. It can be called from any thread
+    void processed(sctpConnection *connection);
+
+    void run();
+
+protected:
+    //! Wakes up reactor thread to handle new and processed connections
+    void wakeUp();
+    //! Appends connections, that were added by addConnection
+    void acceptPending();
+    //! Sends results and schedules connections, that were processed by workers
+    void handleProcessed();
+
+    //! Reads all available data from connection socket
+    void handleRead(sctpConnection *connection);
+    //! Sends processed results, while socket is ready for writing
+    void handleWrite(sctpConnection *connection);
+    //! Pushes connection into worker pool, if it has complete command and it isn't processed already
+    void schedule(sctpConnection *connection);
+    //! Updates events of connection socket, that are listened by epoll, by connection state
+    void updateEvents(sctpConnection *connection);
+    /*! Returns true, if connection should be closed: socket error occurred, or client finished sending
+     * and all results of its commands are sent
+     */
+    bool isFinished(sctpConnection *connection) const;
+    //! Closes connection. It would be destroyed at the end of events loop iteration
+    void closeConnection(sctpConnection *connection);
+    //! Destroys closed connections
+    void destroyClosed();
+    //! Destroys expired cursors of connections, that aren't processed by workers, so idle clients release them too
+    void expireCursors();
+
+private:
+    sctpWorkerPool *mWorkerPool;
+
+    //! Epoll instance descriptor
+    int mEpoll;
+    //! Event descriptor, that is used to wake up reactor thread
+    int mWakeUp;
+    QAtomicInt mIsRunning;
+    //! Memory context of reactor thread, that is used to destroy expired cursors
+    sc_memory_context *mContext;
+
+    //! Mutex to synchronize pending lists
+    QMutex mPendingMutex;
+    //! Accepted sockets, that aren't added into epoll yet
+    QList<int> mPendingSockets;
+    //! Connections, that were processed by workers
+    QList<sctpConnection*> mProcessed;
+
+    //! Connections, that are served by reactor
+    QSet<sctpConnection*> mConnections;
+    //! Closed connections, that would be destroyed
+    QList<sctpConnection*> mClosed;
+};
+
+#endif
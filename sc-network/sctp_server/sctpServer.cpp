@@ -9,6 +9,11 @@
 #include "sctpStatistic.h"
 #include "sctpEventManager.h"
 
+#ifdef Q_OS_LINUX
+# include "sctpReactor.h"
+# include "sctpWorkerPool.h"
+#endif
+
 #include <QSettings>
 #include <QDebug>
 #include <QThreadPool>
@@ -27,6 +32,11 @@ sctpServer::sctpServer(QObject *parent)
   , mPort(0)
   , mStatistic(0)
   , mSavePeriod(0)
+  , mAsyncMode(false)
+  , mReactorsCount(0)
+  , mWorkersCount(0)
+  , mNextReactor(0)
+  , mWorkerPool(0)
   , mEventManager(0)
   , mContext(0)
 {
@@ -94,11 +104,65 @@ bool sctpServer::start(const QString &config)
         mStatistic->initialize(mStatPath, mStatUpdatePeriod, mContext);
     }
 
+    if (mAsyncMode && !startAsync())
+        return false;
+
     QTimer::singleShot(mSavePeriod * 1000, this, SLOT(onSave()));
 
     return true;
 }
 
+bool sctpServer::startAsync()
+{
+#ifdef Q_OS_LINUX
+    mWorkerPool = new sctpWorkerPool(mWorkersCount);
+    mWorkerPool->start();
+
+    if (mReactorsCount == 0)
+        mReactorsCount = QThread::idealThreadCount();
+
+    for (quint32 i = 0; i < mReactorsCount; ++i)
+    {
+        sctpReactor *reactor = new sctpReactor(mWorkerPool);
+        mReactors.append(reactor);
+        if (!reactor->initialize())
+        {
+            stopAsync();
+            return false;
+        }
+    }
+
+    qDebug() << "Asynchronous mode: " << mReactorsCount << " reactors";
+    return true;
+#else
+    qWarning() << "Asynchronous mode isn't supported on this platform. Thread per connection is used";
+    mAsyncMode = false;
+    return true;
+#endif
+}
+
+void sctpServer::stopAsync()
+{
+#ifdef Q_OS_LINUX
+    // workers can notify reactors, so reactors are destroyed after workers stop
+    for (QList<sctpReactor*>::iterator it = mReactors.begin(); it != mReactors.end(); ++it)
+        (*it)->stop();
+
+    if (mWorkerPool)
+        mWorkerPool->stop();
+
+    for (QList<sctpReactor*>::iterator it = mReactors.begin(); it != mReactors.end(); ++it)
+    {
+        (*it)->shutdown();
+        delete *it;
+    }
+    mReactors.clear();
+
+    delete mWorkerPool;
+    mWorkerPool = 0;
+#endif
+}
+
 void sctpServer::parseConfig(const QString &config_path)
 {
     QSettings settings(config_path, QSettings::IniFormat);
@@ -127,6 +191,10 @@ void sctpServer::parseConfig(const QString &config_path)
         mSavePeriod = 3600;
     }
 
+    mAsyncMode = (settings.value("Network/Mode").toString() == "async");
+    mReactorsCount = settings.value("Network/Reactors").toUInt();
+    mWorkersCount = settings.value("Network/Workers").toUInt();
+
     mExtPath = settings.value("Extensions/Directory").toString();
 
     mStatUpdatePeriod = settings.value("Stat/UpdatePeriod").toUInt(&result);
@@ -145,6 +213,14 @@ void sctpServer::parseConfig(const QString &config_path)
 
 void sctpServer::incomingConnection(qintptr socketDescriptor)
 {
+#ifdef Q_OS_LINUX
+    if (mAsyncMode)
+    {
+        mReactors[mNextReactor++ % mReactors.size()]->addConnection((int)socketDescriptor);
+        return;
+    }
+#endif
+
     sctpClient *client = new sctpClient(this, socketDescriptor);
     connect(client, SIGNAL(finished()), client, SLOT(deleteLater()));
     connect(client, SIGNAL(destroyed(QObject*)), this, SLOT(clientDestroyed(QObject*)));
@@ -154,6 +230,10 @@ void sctpServer::incomingConnection(qintptr socketDescriptor)
 
 void sctpServer::stop()
 {
+    // contexts of workers have to be freed before sc-memory shutdown
+    if (mAsyncMode)
+        stopAsync();
+
     sc_memory_shutdown(SC_TRUE);
     mContext = 0;
 
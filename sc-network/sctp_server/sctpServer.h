@@ -15,6 +15,8 @@
 class sctpClient;
 class sctpStatistic;
 class sctpEventManager;
+class sctpReactor;
+class sctpWorkerPool;
 
 class sctpServer : public QTcpServer
 {
@@ -29,6 +31,10 @@ public:
 protected:
     //! Parse configuration file
     void parseConfig(const QString &config_path);
+    //! Starts reactors and worker pool of asynchronous mode
+    bool startAsync();
+    //! Stops reactors and worker pool of asynchronous mode
+    void stopAsync();
 
 
 protected:
@@ -50,6 +56,17 @@ private:
 
     QSet<sctpClient*> mClients;
 
+    //! Flag, that is true, when connections are served by reactors instead of thread per connection
+    bool mAsyncMode;
+    //! Number of reactors in asynchronous mode (0 - number of processor cores)
+    quint32 mReactorsCount;
+    //! Number of workers in asynchronous mode (0 - number of processor cores)
+    quint32 mWorkersCount;
+    QList<sctpReactor*> mReactors;
+    //! Index of reactor, that will serve next connection
+    quint32 mNextReactor;
+    sctpWorkerPool *mWorkerPool;
+
     //! Event manager instance
     sctpEventManager *mEventManager;
     //! Pointer to default memory context
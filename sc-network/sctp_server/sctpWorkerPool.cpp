@@ -0,0 +1,139 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "sctpWorkerPool.h"
+#include "sctpReactor.h"
+#include "sctpCommand.h"
+
+#include <QBuffer>
+#include <QDebug>
+
+extern "C"
+{
+#include "sc_memory.h"
+}
+
+sctpWorker::sctpWorker(sctpWorkerPool *pool)
+    : QThread(0)
+    , mPool(pool)
+    , mContext(0)
+{
+}
+
+sctpWorker::~sctpWorker()
+{
+}
+
+void sctpWorker::run()
+{
+    mContext = sc_memory_context_new(sc_access_lvl_make_min);
+
+    sctpConnection *connection = 0;
+    while ((connection = mPool->pop()) != 0)
+        processConnection(connection);
+
+    sc_memory_context_free(mContext);
+    mContext = 0;
+}
+
+void sctpWorker::processConnection(sctpConnection *connection)
+{
+    // data, that is received while commands are processed, is appended into connection input buffer
+    connection->mutex.lock();
+    Q_ASSERT(connection->processing.isEmpty());
+    connection->processing.swap(connection->input);
+    connection->mutex.unlock();
+
+    // results of all commands are collected and sent by reactor at once
+    connection->replies.resize(0);
+    QBuffer outDevice(&connection->replies);
+    outDevice.open(QIODevice::WriteOnly);
+
+    connection->command->setContext(mContext);
+    connection->command->processCommands(connection->processing, &outDevice);
+    connection->command->setContext(0);
+
+    outDevice.close();
+
+    connection->mutex.lock();
+    // incomplete command stays before newly received data
+    if (!connection->processing.isEmpty())
+    {
+        connection->processing.append(connection->input.data(), connection->input.size());
+        connection->input.clear();
+        connection->input.swap(connection->processing);
+    }
+
+    if (connection->output.isEmpty())
+        connection->output.swap(connection->replies);
+    else
+        connection->output.append(connection->replies);
+    connection->mutex.unlock();
+
+    connection->reactor->processed(connection);
+}
+
+// ---------------------------------------------
+sctpWorkerPool::sctpWorkerPool(quint32 workersCount)
+    : mWorkersCount(workersCount)
+    , mIsRunning(false)
+{
+    if (mWorkersCount == 0)
+        mWorkersCount = QThread::idealThreadCount();
+}
+
+sctpWorkerPool::~sctpWorkerPool()
+{
+    Q_ASSERT(mWorkers.isEmpty());
+}
+
+void sctpWorkerPool::start()
+{
+    mIsRunning = true;
+    for (quint32 i = 0; i < mWorkersCount; ++i)
+    {
+        sctpWorker *worker = new sctpWorker(this);
+        mWorkers.append(worker);
+        worker->start();
+    }
+
+    qDebug() << "Started" << mWorkersCount << "workers";
+}
+
+void sctpWorkerPool::stop()
+{
+    mMutex.lock();
+    mIsRunning = false;
+    mCondition.wakeAll();
+    mMutex.unlock();
+
+    for (QList<sctpWorker*>::iterator it = mWorkers.begin(); it != mWorkers.end(); ++it)
+    {
+        (*it)->wait();
+        delete *it;
+    }
+    mWorkers.clear();
+    mQueue.clear();
+}
+
+void sctpWorkerPool::push(sctpConnection *connection)
+{
+    QMutexLocker locker(&mMutex);
+    mQueue.enqueue(connection);
+    mCondition.wakeOne();
+}
+
+sctpConnection* sctpWorkerPool::pop()
+{
+    QMutexLocker locker(&mMutex);
+    while (mIsRunning && mQueue.isEmpty())
+        mCondition.wait(&mMutex);
+
+    if (!mIsRunning)
+        return 0;
+
+    return mQueue.dequeue();
+}
@@ -0,0 +1,77 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#ifndef _sctpWorkerPool_h_
+#define _sctpWorkerPool_h_
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+
+#include "../sctp_client/sctpTypes.hpp"
+
+struct sctpConnection;
+class sctpWorkerPool;
+
+/*! Thread, that processes commands of connections from pool queue.
+ * Each worker has its own memory context, so number of contexts doesn't depend on number of clients
+ */
+class sctpWorker : public QThread
+{
+    Q_OBJECT
+public:
+    explicit sctpWorker(sctpWorkerPool *pool);
+    virtual ~sctpWorker();
+
+    void run();
+
+protected:
+    //! Process all complete commands, that were received from connection
+    void processConnection(sctpConnection *connection);
+
+private:
+    sctpWorkerPool *mPool;
+    //! Memory context of worker
+    sc_memory_context *mContext;
+};
+
+/*! Fixed pool of workers, that process commands of asynchronous server connections.
+ * Connection is pushed into pool, when it has complete commands. It isn't pushed again,
+ * until worker finished processing, so commands of one client are processed in order.
+ */
+class sctpWorkerPool
+{
+    friend class sctpWorker;
+
+public:
+    explicit sctpWorkerPool(quint32 workersCount);
+    ~sctpWorkerPool();
+
+    //! Starts worker threads. It must be called after sc-memory initialization
+    void start();
+    //! Stops worker threads and waits until they finish processing
+    void stop();
+
+    //! Appends connection into queue. Its commands would be processed by the first free worker
+    void push(sctpConnection *connection);
+
+protected:
+    //! Returns next connection to process. If pool is stopped, then returns 0
+    sctpConnection* pop();
+
+private:
+    quint32 mWorkersCount;
+    QList<sctpWorker*> mWorkers;
+
+    QMutex mMutex;
+    QWaitCondition mCondition;
+    QQueue<sctpConnection*> mQueue;
+    bool mIsRunning;
+};
+
+#endif
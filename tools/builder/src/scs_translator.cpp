@@ -31,6 +31,27 @@ String trimContentData(String const & path)
 	return path.substr(2, path.size() - 3);
 }
 
+typedef std::map<sElement*, sc_uint32> tElementIndexMap;
+
+//! Resolves begin or end of sc-arc in batch: created element or previous sc-arc of batch (index from \p indices)
+bool resolveArcEnd(sElement *el, tElementIndexMap const & indices, sc_addr & addr, sc_uint32 & index)
+{
+    SC_ADDR_MAKE_EMPTY(addr);
+    index = SC_ELEMENT_SPEC_NO_INDEX;
+    if (SC_ADDR_IS_NOT_EMPTY(el->addr))
+    {
+        addr = el->addr;
+        return true;
+    }
+
+    tElementIndexMap::const_iterator it = indices.find(el);
+    if (it == indices.end())
+        return false;
+
+    index = it->second;
+    return true;
+}
+
 SCsTranslator::SCsTranslator(sc_memory_context *ctx)
     : iTranslator(ctx)
 {
@@ -175,6 +196,7 @@ bool SCsTranslator::buildScText(pANTLR3_BASE_TREE tree)
             determineElementType(el);
     }
 
+    // nodes and links are created one by one, because links need content
     tElementSet arcs;
     for (it = mElementSet.begin(); it != itEnd; ++it)
     {
@@ -184,50 +206,82 @@ bool SCsTranslator::buildScText(pANTLR3_BASE_TREE tree)
         // skip processed triples
         if (el->ignore) continue;
 
-        sc_addr addr = resolveScAddr(el);
-
-        if (SC_ADDR_IS_EMPTY(addr))
+        if (el->type & sc_type_arc_mask)
         {
-            assert(el->type & sc_type_arc_mask);
-            arcs.insert(el);
+            if (!findScAddr(el))
+                arcs.insert(el);
         }
+        else
+            resolveScAddr(el);
     }
 
-    bool created = true;
-    while (!arcs.empty() && created)
+    createArcs(arcs);
+
+    if (!arcs.empty())
+    {
+        StringStream ss;
+        ss << "Arcs not created: " << arcs.size();
+        THROW_EXCEPT(Exception::ERR_INVALID_STATE,
+                     ss.str(),
+                     mParams.fileName,
+                     -1);
+    }
+
+    return true;
+}
+
+void SCsTranslator::createArcs(tElementSet & arcs)
+{
+    std::vector<sc_element_spec> specs;
+    std::vector<sElement*> elements;
+    tElementIndexMap indices;
+
+    // order sc-arcs, so each one follows its begin and end
+    bool appended = true;
+    while (!arcs.empty() && appended)
     {
-        created = false;
+        appended = false;
 
-        tElementSet createdSet;
-        itEnd = arcs.end();
-        for (it = arcs.begin(); it != itEnd; ++it)
+        tElementSet::iterator it = arcs.begin();
+        while (it != arcs.end())
         {
-            sElement *arc_el = *it;
-            assert(arc_el->type & sc_type_arc_mask);
-            sc_addr addr = resolveScAddr(arc_el);
+            sElement *el = *it;
+            assert(el->type & sc_type_arc_mask);
 
-            if (SC_ADDR_IS_EMPTY(addr)) continue;
+            sc_element_spec spec;
+            spec.type = el->type;
+            if (!resolveArcEnd(el->arc_src, indices, spec.begin, spec.begin_index) ||
+                !resolveArcEnd(el->arc_trg, indices, spec.end, spec.end_index))
+            {
+                ++it;
+                continue;
+            }
 
-            createdSet.insert(arc_el);
+            indices[el] = (sc_uint32)specs.size();
+            specs.push_back(spec);
+            elements.push_back(el);
+            arcs.erase(it++);
+            appended = true;
         }
-
-        created = !createdSet.empty();
-        itEnd = createdSet.end();
-        for (it = createdSet.begin(); it != itEnd; ++it)
-            arcs.erase(*it);
     }
 
-    if (!arcs.empty())
+    if (specs.empty())
+        return;
+
+    std::vector<sc_addr> addrs(specs.size());
+    if (sc_memory_elements_new(mContext, &specs[0], (sc_uint32)specs.size(), &addrs[0]) != SC_RESULT_OK)
     {
-        StringStream ss;
-        ss << "Arcs not created: " << arcs.size();
         THROW_EXCEPT(Exception::ERR_INVALID_STATE,
-                     ss.str(),
+                     "Can't create arcs",
                      mParams.fileName,
                      -1);
     }
 
-    return true;
+    for (size_t i = 0; i < elements.size(); ++i)
+    {
+        elements[i]->addr = addrs[i];
+        registerScAddr(elements[i]);
+    }
 }
 
 SCsTranslator::eSentenceType SCsTranslator::determineSentenceType(pANTLR3_BASE_TREE node)
@@ -393,6 +447,18 @@ sc_addr SCsTranslator::resolveScAddr(sElement *el)
 {
     assert(SC_ADDR_IS_EMPTY(el->addr));
 
+    if (findScAddr(el))
+        return el->addr;
+
+    // generate addr
+    sc_addr addr = createScAddr(el);
+    registerScAddr(el);
+
+    return addr;
+}
+
+bool SCsTranslator::findScAddr(sElement *el)
+{
     sc_addr addr;
     SC_ADDR_MAKE_EMPTY(addr);
     if (!el->idtf.empty())
@@ -425,40 +491,37 @@ sc_addr SCsTranslator::resolveScAddr(sElement *el)
         }
     }
 
-    if (SC_ADDR_IS_NOT_EMPTY(addr))
-    {
-        sc_type t = 0;
-        if (sc_memory_get_element_type(mContext, addr, &t) == SC_RESULT_OK)
-            sc_memory_change_element_subtype(mContext, addr, ~sc_type_element_mask & (el->type | t));
-
-        el->addr = addr;
-        return addr;
-    }
+    if (SC_ADDR_IS_EMPTY(addr))
+        return false;
 
-    // generate addr
-    addr = createScAddr(el);
+    sc_type t = 0;
+    if (sc_memory_get_element_type(mContext, addr, &t) == SC_RESULT_OK)
+        sc_memory_change_element_subtype(mContext, addr, ~sc_type_element_mask & (el->type | t));
 
+    el->addr = addr;
+    return true;
+}
 
+void SCsTranslator::registerScAddr(sElement *el)
+{
     // store in addrs map
-    if (!el->idtf.empty())
+    if (!el->idtf.empty() && SC_ADDR_IS_NOT_EMPTY(el->addr))
     {
         switch (_getIdentifierVisibility(el->idtf))
         {
         case IdtfSystem:
-            sc_helper_set_system_identifier(mContext, addr, el->idtf.c_str(), (sc_uint32)el->idtf.size());
-            mSysIdtfAddrs[el->idtf] = addr;
+            sc_helper_set_system_identifier(mContext, el->addr, el->idtf.c_str(), (sc_uint32)el->idtf.size());
+            mSysIdtfAddrs[el->idtf] = el->addr;
             break;
         case IdtfLocal:
-            mLocalIdtfAddrs[el->idtf] = addr;
+            mLocalIdtfAddrs[el->idtf] = el->addr;
             break;
         case IdtfGlobal:
-            msGlobalIdtfAddrs[el->idtf] = addr;
+            msGlobalIdtfAddrs[el->idtf] = el->addr;
             break;
         }
 
     }
-
-    return addr;
 }
 
 sc_addr SCsTranslator::createScAddr(sElement *el)
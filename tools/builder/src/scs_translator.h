@@ -136,8 +136,16 @@ private:
     // --------- helper functions -----------
     //! Function that resolve sc-addr for element with specified identifier
     sc_addr resolveScAddr(sElement *el);
+    //! Finds existing sc-element by identifier of element. Returns true, if it found
+    bool findScAddr(sElement *el);
+    //! Stores sc-addr of created element by its identifier
+    void registerScAddr(sElement *el);
     //! Create new sc-addr of element
     sc_addr createScAddr(sElement *el);
+    /*! Creates all sc-arcs from \p arcs, which begin and end can be resolved, by one batch (see sc_memory_elements_new).
+     * Created sc-arcs are removed from \p arcs
+     */
+    void createArcs(std::set<sElement*> & arcs);
     //! Determines sc-type of element
     void determineElementType(sElement *el);
 